@@ -0,0 +1,284 @@
+/**
+ * @file acq_stats.c
+ * @brief Rolling latency histograms of the sensor acquisition cycle
+ */
+
+#include "acq_stats.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "ACQ_STATS";
+
+#define ACQ_STATS_WINDOW_US     ((int64_t)ACQ_STATS_WINDOW_SEC * 1000000)
+
+static const uint32_t s_bounds_us[ACQ_STATS_BUCKETS] = ACQ_STATS_BUCKET_BOUNDS_US;
+
+typedef struct {
+    int64_t start_us;
+    uint16_t cycles;
+    acq_hist_t cycle;
+    acq_hist_t bus;
+    acq_sensor_stats_t sensors[ACQ_STATS_MAX_SENSORS];
+} acq_window_t;
+
+static acq_window_t s_windows[2];       // [s_current] and the previous one, guarded by s_mutex
+static uint8_t s_current = 0;
+static SemaphoreHandle_t s_mutex = NULL;
+
+static void acq_hist_add(acq_hist_t *hist, uint32_t us) {
+    uint8_t bucket = 0;
+    while (bucket < ACQ_STATS_BUCKETS - 1 && us > s_bounds_us[bucket]) {
+        bucket++;
+    }
+    if (hist->count == UINT16_MAX) {
+        return;
+    }
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->sum_us += us;
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+}
+
+static void acq_hist_merge(acq_hist_t *into, const acq_hist_t *from) {
+    for (int i = 0; i < ACQ_STATS_BUCKETS; i++) {
+        into->buckets[i] += from->buckets[i];
+    }
+    into->count += from->count;
+    into->sum_us += from->sum_us;
+    if (from->max_us > into->max_us) {
+        into->max_us = from->max_us;
+    }
+}
+
+uint32_t acq_hist_percentile_us(const acq_hist_t *hist, uint8_t pct) {
+    if (hist->count == 0) {
+        return 0;
+    }
+    uint32_t rank = ((uint32_t)hist->count * pct + 99) / 100;
+    uint32_t seen = 0;
+    for (int i = 0; i < ACQ_STATS_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            return (s_bounds_us[i] < hist->max_us) ? s_bounds_us[i] : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+/**
+ * @brief Current window, opening a new one when it has run its length (caller holds s_mutex)
+ */
+static acq_window_t *acq_stats_window_locked(int64_t now_us) {
+    acq_window_t *cur = &s_windows[s_current];
+    if (cur->start_us == 0) {
+        cur->start_us = now_us;
+    } else if (now_us - cur->start_us >= ACQ_STATS_WINDOW_US) {
+        s_current ^= 1;
+        acq_window_t *next = &s_windows[s_current];
+        memset(next, 0, sizeof(*next));
+        // After a long pause the old window is not recent either
+        if (now_us - cur->start_us >= 2 * ACQ_STATS_WINDOW_US) {
+            memset(cur, 0, sizeof(*cur));
+        }
+        next->start_us = now_us;
+        cur = next;
+    }
+    return cur;
+}
+
+esp_err_t acq_stats_init(void) {
+    if (s_mutex != NULL) {
+        return ESP_OK;
+    }
+    s_mutex = xSemaphoreCreateMutex();
+    return (s_mutex != NULL) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void acq_stats_record_sensor(uint8_t index, uint8_t address, const acq_sensor_sample_t *sample) {
+    if (s_mutex == NULL || index >= ACQ_STATS_MAX_SENSORS || sample == NULL) {
+        return;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    acq_window_t *win = acq_stats_window_locked(esp_timer_get_time());
+    for (int w = 0; w < 2; w++) {
+        acq_sensor_stats_t *slot = &s_windows[w].sensors[index];
+        if (slot->address != address) {
+            memset(slot, 0, sizeof(*slot));
+            slot->address = address;
+        }
+    }
+
+    acq_sensor_stats_t *s = &win->sensors[index];
+    if (s->reads < UINT16_MAX) {
+        s->reads++;
+        s->failures += sample->ok ? 0 : 1;
+        s->retries += sample->retries;
+        s->errors += sample->errors;
+    }
+    s->bus_us += sample->bus_us;
+    acq_hist_add(&s->trigger, sample->trigger_us);
+    if (sample->ok) {
+        acq_hist_add(&s->wait, sample->wait_us);
+        acq_hist_add(&s->fetch, sample->fetch_us);
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+void acq_stats_record_cycle(uint32_t cycle_us, uint32_t bus_us) {
+    if (s_mutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    acq_window_t *win = acq_stats_window_locked(esp_timer_get_time());
+    if (win->cycles < UINT16_MAX) {
+        win->cycles++;
+    }
+    acq_hist_add(&win->cycle, cycle_us);
+    acq_hist_add(&win->bus, bus_us);
+    xSemaphoreGive(s_mutex);
+}
+
+esp_err_t acq_stats_get(acq_stats_snapshot_t *snapshot) {
+    if (s_mutex == NULL || snapshot == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    memset(snapshot, 0, sizeof(*snapshot));
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    int64_t now_us = esp_timer_get_time();
+    acq_stats_window_locked(now_us);
+
+    int64_t oldest_us = now_us;
+    for (int w = 0; w < 2; w++) {
+        const acq_window_t *win = &s_windows[w];
+        if (win->start_us == 0) {
+            continue;
+        }
+        if (win->start_us < oldest_us) {
+            oldest_us = win->start_us;
+        }
+        snapshot->cycles += win->cycles;
+        acq_hist_merge(&snapshot->cycle, &win->cycle);
+        acq_hist_merge(&snapshot->bus, &win->bus);
+        for (int i = 0; i < ACQ_STATS_MAX_SENSORS; i++) {
+            const acq_sensor_stats_t *from = &win->sensors[i];
+            acq_sensor_stats_t *into = &snapshot->sensors[i];
+            if (from->address == 0) {
+                continue;
+            }
+            into->address = from->address;
+            into->reads += from->reads;
+            into->failures += from->failures;
+            into->retries += from->retries;
+            into->errors += from->errors;
+            into->bus_us += from->bus_us;
+            acq_hist_merge(&into->trigger, &from->trigger);
+            acq_hist_merge(&into->wait, &from->wait);
+            acq_hist_merge(&into->fetch, &from->fetch);
+        }
+    }
+    xSemaphoreGive(s_mutex);
+    snapshot->span_sec = (uint32_t)((now_us - oldest_us) / 1000000);
+    return ESP_OK;
+}
+
+void acq_stats_reset(void) {
+    if (s_mutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    memset(s_windows, 0, sizeof(s_windows));
+    xSemaphoreGive(s_mutex);
+    ESP_LOGI(TAG, "Acquisition statistics reset");
+}
+
+static void acq_write_hist_json(json_writer_t *w, const char *key, const acq_hist_t *hist) {
+    json_writer_key(w, key);
+    json_writer_object_begin(w);
+    json_writer_kv_int(w, "count", hist->count);
+    json_writer_kv_int(w, "max_us", hist->max_us);
+    json_writer_kv_int(w, "mean_us", hist->count > 0 ? (int64_t)(hist->sum_us / hist->count) : 0);
+    json_writer_kv_int(w, "p50_us", acq_hist_percentile_us(hist, 50));
+    json_writer_kv_int(w, "p95_us", acq_hist_percentile_us(hist, 95));
+    json_writer_key(w, "buckets");
+    json_writer_array_begin(w);
+    for (int i = 0; i < ACQ_STATS_BUCKETS; i++) {
+        json_writer_int(w, hist->buckets[i]);
+    }
+    json_writer_array_end(w);
+    json_writer_object_end(w);
+}
+
+void acq_stats_write_json(json_writer_t *w, bool detailed) {
+    acq_stats_snapshot_t *snap = malloc(sizeof(acq_stats_snapshot_t));
+    if (snap == NULL || acq_stats_get(snap) != ESP_OK) {
+        free(snap);
+        json_writer_null(w);
+        return;
+    }
+
+    uint32_t retries = 0;
+    uint32_t errors = 0;
+    uint32_t failures = 0;
+    for (int i = 0; i < ACQ_STATS_MAX_SENSORS; i++) {
+        retries += snap->sensors[i].retries;
+        errors += snap->sensors[i].errors;
+        failures += snap->sensors[i].failures;
+    }
+
+    json_writer_object_begin(w);
+    json_writer_kv_int(w, "span_sec", snap->span_sec);
+    json_writer_kv_int(w, "cycles", snap->cycles);
+    json_writer_kv_int(w, "retries", retries);
+    json_writer_kv_int(w, "i2c_errors", errors);
+    json_writer_kv_int(w, "failures", failures);
+    if (!detailed) {
+        json_writer_kv_int(w, "cycle_p50_ms", acq_hist_percentile_us(&snap->cycle, 50) / 1000);
+        json_writer_kv_int(w, "cycle_p95_ms", acq_hist_percentile_us(&snap->cycle, 95) / 1000);
+        json_writer_kv_int(w, "cycle_max_ms", snap->cycle.max_us / 1000);
+        json_writer_kv_int(w, "bus_p95_ms", acq_hist_percentile_us(&snap->bus, 95) / 1000);
+        json_writer_object_end(w);
+        free(snap);
+        return;
+    }
+
+    // Upper bucket bounds; the last bucket is open-ended
+    json_writer_key(w, "bounds_us");
+    json_writer_array_begin(w);
+    for (int i = 0; i < ACQ_STATS_BUCKETS - 1; i++) {
+        json_writer_int(w, s_bounds_us[i]);
+    }
+    json_writer_array_end(w);
+    acq_write_hist_json(w, "cycle", &snap->cycle);
+    acq_write_hist_json(w, "bus", &snap->bus);
+
+    json_writer_key(w, "sensors");
+    json_writer_array_begin(w);
+    for (int i = 0; i < ACQ_STATS_MAX_SENSORS; i++) {
+        const acq_sensor_stats_t *s = &snap->sensors[i];
+        if (s->address == 0 || s->reads == 0) {
+            continue;
+        }
+        json_writer_object_begin(w);
+        json_writer_kv_int(w, "index", i);
+        json_writer_kv_int(w, "address", s->address);
+        json_writer_kv_int(w, "reads", s->reads);
+        json_writer_kv_int(w, "failures", s->failures);
+        json_writer_kv_int(w, "retries", s->retries);
+        json_writer_kv_int(w, "i2c_errors", s->errors);
+        json_writer_kv_int(w, "bus_ms", (int64_t)(s->bus_us / 1000));
+        json_writer_kv_int(w, "bus_per_read_us", (int64_t)(s->bus_us / s->reads));
+        acq_write_hist_json(w, "trigger", &s->trigger);
+        acq_write_hist_json(w, "wait", &s->wait);
+        acq_write_hist_json(w, "fetch", &s->fetch);
+        json_writer_object_end(w);
+    }
+    json_writer_array_end(w);
+    json_writer_object_end(w);
+    free(snap);
+}
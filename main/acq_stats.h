@@ -0,0 +1,122 @@
+/**
+ * @file acq_stats.h
+ * @brief Rolling latency histograms of the sensor acquisition cycle
+ *
+ * The reading task records, for every board it reads in a cycle, the time
+ * its trigger and its fetches held the bus, how long the conversion was
+ * waited for, how many fetches came back not ready and how many transfers
+ * failed; and for every completed cycle its duration and total bus time.
+ *
+ * Samples land in the current window; after ACQ_STATS_WINDOW_SEC it becomes
+ * the previous one and a new window starts. Reports merge both, so they
+ * cover between one and two windows of recent history.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ACQ_STATS_MAX_SENSORS   16      // SENSOR_MANAGER_MAX_SENSORS
+#define ACQ_STATS_WINDOW_SEC    900
+
+/**
+ * @brief Histogram with fixed bucket bounds
+ *
+ * Bucket i counts samples up to ACQ_STATS_BUCKET_BOUNDS_US[i]; the last
+ * bucket catches everything above. Counts fit 16 bits because a window
+ * holds at most one sample per cycle.
+ */
+#define ACQ_STATS_BUCKETS           14
+#define ACQ_STATS_BUCKET_BOUNDS_US  {250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, \
+                                     250000, 500000, 1000000, 2500000, UINT32_MAX}
+typedef struct {
+    uint16_t buckets[ACQ_STATS_BUCKETS];
+    uint16_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+} acq_hist_t;
+
+/**
+ * @brief One board's part of one cycle, as measured by the reading task
+ */
+typedef struct {
+    bool ok;                    // A reading was stored
+    uint32_t trigger_us;        // Bus held by the trigger command
+    uint32_t wait_us;           // Trigger done -> start of the fetch that returned the reading
+    uint32_t fetch_us;          // Bus held by that fetch
+    uint32_t bus_us;            // Bus held by the trigger and every fetch
+    uint8_t retries;            // Fetches answered with ESP_ERR_NOT_FINISHED
+    uint8_t errors;             // Trigger or fetch transfers that failed
+} acq_sensor_sample_t;
+
+typedef struct {
+    uint8_t address;            // 0 for an unused slot
+    uint16_t reads;
+    uint16_t failures;          // Reads that stored no reading
+    uint16_t retries;
+    uint16_t errors;
+    uint64_t bus_us;
+    acq_hist_t trigger;
+    acq_hist_t wait;
+    acq_hist_t fetch;
+} acq_sensor_stats_t;
+
+typedef struct {
+    uint32_t span_sec;          // Time covered by the merged windows
+    uint16_t cycles;
+    acq_hist_t cycle;           // Cycle start -> cache published
+    acq_hist_t bus;             // Bus time of all boards in the cycle
+    acq_sensor_stats_t sensors[ACQ_STATS_MAX_SENSORS];  // By registry index
+} acq_stats_snapshot_t;
+
+/**
+ * @brief Create the lock (idempotent); called from sensor_manager_init()
+ */
+esp_err_t acq_stats_init(void);
+
+/**
+ * @brief Add one board's part of a cycle
+ *
+ * A slot whose address changed (hot-plug) starts over.
+ */
+void acq_stats_record_sensor(uint8_t index, uint8_t address, const acq_sensor_sample_t *sample);
+
+/**
+ * @brief Add one completed cycle
+ */
+void acq_stats_record_cycle(uint32_t cycle_us, uint32_t bus_us);
+
+/**
+ * @brief Both windows merged
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE before acq_stats_init()
+ */
+esp_err_t acq_stats_get(acq_stats_snapshot_t *snapshot);
+
+/**
+ * @brief Drop both windows
+ */
+void acq_stats_reset(void);
+
+/**
+ * @brief Approximate percentile: upper bound of the bucket holding it, capped at the maximum
+ */
+uint32_t acq_hist_percentile_us(const acq_hist_t *hist, uint8_t pct);
+
+/**
+ * @brief Write the merged windows as a JSON object
+ *
+ * @param detailed true for per-board histograms, false for cycle percentiles and totals
+ */
+void acq_stats_write_json(json_writer_t *w, bool detailed);
+
+#ifdef __cplusplus
+}
+#endif
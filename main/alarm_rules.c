@@ -0,0 +1,386 @@
+/**
+ * @file alarm_rules.c
+ * @brief Local threshold and rate-of-change alarms evaluated on every cache update
+ */
+
+#include "alarm_rules.h"
+#include "sensor_manager.h"
+#include "derived_metrics.h"
+#include "ezo_sensor.h"
+#include "mqtt_telemetry.h"
+#include "settings_store.h"
+#include "telemetry_codec.h"
+#include "json_writer.h"
+#include "time_sync.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <math.h>
+#include <string.h>
+
+static const char *TAG = "ALARM_RULES";
+
+#define ALARM_SLOTS             SENSOR_MANAGER_MAX_SENSORS  // Boards per rule, as in sensor_cache_t.sensors
+#define ALARM_ALERT_JSON_SIZE   320
+
+_Static_assert(ALARM_RULES_MAX * sizeof(alarm_rule_t) <= SETTINGS_STORE_BLOB_MAX, "alarm rules exceed a settings blob");
+
+typedef enum {
+    ALARM_SOURCE_SENSOR = 0,
+    ALARM_SOURCE_BATTERY,
+    ALARM_SOURCE_DERIVED,
+} alarm_source_t;
+
+/**
+ * @brief A rule reduced to one comparison: value * sign past trip, then back inside clear
+ */
+typedef struct {
+    float sign;                 // -1 for "below" rules, so every rule trips upwards
+    float trip;
+    float clear;
+    bool rate;
+    uint8_t source;             // alarm_source_t
+    uint8_t sensor_kind;        // ezo_sensor_kind_t; UNKNOWN falls back to the type string
+} alarm_compiled_t;
+
+typedef struct {
+    uint8_t address;            // Board the state belongs to; a different board resets it
+    bool active;
+    uint8_t count;              // Consecutive samples toward the opposite state
+    bool has_prev;
+    float prev;                 // Previous value, for rate rules
+    uint64_t prev_us;
+    uint64_t last_us;           // Sample already evaluated
+} alarm_state_t;
+
+static SemaphoreHandle_t s_rules_mutex = NULL;
+static alarm_rule_t s_rules[ALARM_RULES_MAX];
+static alarm_compiled_t s_compiled[ALARM_RULES_MAX];
+static alarm_state_t s_states[ALARM_RULES_MAX][ALARM_SLOTS];
+static uint8_t s_rule_count = 0;
+static alarm_listener_t s_listener = NULL;
+static char s_alert_json[ALARM_ALERT_JSON_SIZE];   // Sensor task only, under s_rules_mutex
+
+static const char *const k_kind_names[ALARM_RULE_KIND_COUNT] = {
+    [ALARM_RULE_ABOVE] = "above",
+    [ALARM_RULE_BELOW] = "below",
+    [ALARM_RULE_RATE]  = "rate",
+};
+
+static bool alarm_rule_valid(const alarm_rule_t *rule)
+{
+    return rule->kind < ALARM_RULE_KIND_COUNT &&
+           rule->debounce >= 1 && rule->debounce <= ALARM_RULES_MAX_DEBOUNCE &&
+           isfinite(rule->threshold) && isfinite(rule->hysteresis) && rule->hysteresis >= 0.0f &&
+           (rule->kind != ALARM_RULE_RATE || rule->threshold >= 0.0f) &&
+           (rule->value_index < MAX_SENSOR_VALUES ||
+            (strcmp(rule->sensor_type, ALARM_SENSOR_DERIVED) == 0 && rule->value_index < DERIVED_METRIC_COUNT));
+}
+
+static void alarm_compile(const alarm_rule_t *rule, alarm_compiled_t *out)
+{
+    out->rate = (rule->kind == ALARM_RULE_RATE);
+    out->sign = (rule->kind == ALARM_RULE_BELOW) ? -1.0f : 1.0f;
+    out->trip = out->sign * rule->threshold;
+    out->clear = out->trip - rule->hysteresis;
+    if (strcmp(rule->sensor_type, ALARM_SENSOR_BATTERY) == 0) {
+        out->source = ALARM_SOURCE_BATTERY;
+    } else if (strcmp(rule->sensor_type, ALARM_SENSOR_DERIVED) == 0) {
+        out->source = ALARM_SOURCE_DERIVED;
+    } else {
+        out->source = ALARM_SOURCE_SENSOR;
+    }
+    out->sensor_kind = ezo_sensor_kind_from_type(rule->sensor_type);
+}
+
+/**
+ * @brief Install a validated table; caller holds s_rules_mutex
+ */
+static void alarm_install_locked(const alarm_rule_t *rules, uint8_t count)
+{
+    if (count > 0) {
+        memcpy(s_rules, rules, count * sizeof(alarm_rule_t));
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        s_rules[i].sensor_type[sizeof(s_rules[i].sensor_type) - 1] = '\0';
+        s_rules[i].reserved = 0;
+        alarm_compile(&s_rules[i], &s_compiled[i]);
+    }
+    memset(s_states, 0, sizeof(s_states));
+    s_rule_count = count;
+}
+
+static void alarm_emit_locked(uint8_t r, uint8_t address, bool active, float value, uint64_t t_us)
+{
+    alarm_event_t event = {
+        .rule = r,
+        .def = &s_rules[r],
+        .address = address,
+        .active = active,
+        .value = value,
+        .timestamp_us = t_us,
+    };
+
+    ESP_LOGW(TAG, "Rule %u %s: %s[%u] (0x%02X) %s %.3f, value %.3f", r, active ? "tripped" : "cleared",
+             s_rules[r].sensor_type, s_rules[r].value_index, address,
+             k_kind_names[s_rules[r].kind], s_rules[r].threshold, value);
+
+    // Queued in the client outbox, so the alert also survives a short disconnect
+    size_t len = alarm_rules_event_json(&event, s_alert_json, sizeof(s_alert_json));
+    if (len > 0) {
+        esp_err_t err = mqtt_publish_alert(s_alert_json, len);
+        if (err != ESP_OK) {
+            ESP_LOGD(TAG, "Alert not queued for MQTT: %s", esp_err_to_name(err));
+        }
+    }
+    if (s_listener != NULL) {
+        s_listener(&event);
+    }
+}
+
+/**
+ * @brief Feed one fresh sample of a channel to a rule; caller holds s_rules_mutex
+ */
+static void alarm_evaluate_locked(uint8_t r, uint8_t slot, uint8_t address, float value, uint64_t t_us)
+{
+    alarm_state_t *state = &s_states[r][slot];
+    if (state->address != address) {
+        memset(state, 0, sizeof(*state));
+        state->address = address;
+    }
+    // Held readings repeat an earlier sample and must not count twice
+    if (!isfinite(value) || (t_us != 0 && t_us == state->last_us)) {
+        return;
+    }
+    state->last_us = t_us;
+
+    const alarm_compiled_t *rule = &s_compiled[r];
+    float x = value;
+    if (rule->rate) {
+        bool first = !state->has_prev || t_us <= state->prev_us;
+        float previous = state->prev;
+        uint64_t dt_us = t_us - state->prev_us;
+        state->prev = value;
+        state->prev_us = t_us;
+        state->has_prev = true;
+        if (first) {
+            return;
+        }
+        x = fabsf((value - previous) * 60e6f / (float)dt_us);
+    }
+
+    float level = rule->sign * x;
+    bool toward_change = state->active ? (level < rule->clear) : (level > rule->trip);
+    if (!toward_change) {
+        state->count = 0;
+        return;
+    }
+    if (++state->count < s_rules[r].debounce) {
+        return;
+    }
+    state->count = 0;
+    state->active = !state->active;
+    alarm_emit_locked(r, address, state->active, x, t_us);
+}
+
+static void alarm_cache_listener(const sensor_cache_t *cache, void *ctx)
+{
+    (void)ctx;
+    if (s_rule_count == 0 || cache == NULL) {
+        return;
+    }
+    // Focus mode: values of the board under test are not readings from the process
+    if (sensor_manager_is_reading_paused()) {
+        return;
+    }
+    // Skip a cycle rather than stall the reading task behind a table update
+    if (xSemaphoreTake(s_rules_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+        return;
+    }
+
+    for (uint8_t r = 0; r < s_rule_count; r++) {
+        const alarm_rule_t *rule = &s_rules[r];
+        const alarm_compiled_t *compiled = &s_compiled[r];
+        if (compiled->source == ALARM_SOURCE_BATTERY) {
+            if (cache->battery_valid) {
+                alarm_evaluate_locked(r, 0, 0, cache->battery_percentage, cache->timestamp_us);
+            }
+            continue;
+        }
+        if (compiled->source == ALARM_SOURCE_DERIVED) {
+            if (cache->derived_valid & (1u << rule->value_index)) {
+                alarm_evaluate_locked(r, 0, 0, cache->derived[rule->value_index], cache->timestamp_us);
+            }
+            continue;
+        }
+
+        for (uint8_t i = 0; i < cache->sensor_count && i < ALARM_SLOTS; i++) {
+            const cached_sensor_t *sensor = &cache->sensors[i];
+            // Only fresh samples: spikes and held values repeat an earlier estimate
+            if (!sensor->valid || rule->value_index >= sensor->value_count ||
+                (sensor->quality != SENSOR_QUALITY_GOOD && sensor->quality != SENSOR_QUALITY_SETTLING)) {
+                continue;
+            }
+            bool match = (compiled->sensor_kind != EZO_KIND_UNKNOWN) ? (sensor->kind == compiled->sensor_kind)
+                                                                      : (strcmp(sensor->sensor_type, rule->sensor_type) == 0);
+            if (!match) {
+                continue;
+            }
+            uint8_t address = (sensor->address != 0) ? sensor->address : (uint8_t)(i + 1);
+            alarm_evaluate_locked(r, i, address, sensor->values[rule->value_index], sensor->timestamp_us);
+        }
+    }
+
+    xSemaphoreGive(s_rules_mutex);
+}
+
+esp_err_t alarm_rules_init(void)
+{
+    if (s_rules_mutex != NULL) {
+        return ESP_OK;
+    }
+    s_rules_mutex = xSemaphoreCreateMutex();
+    if (s_rules_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    alarm_rule_t saved[ALARM_RULES_MAX];
+    size_t size = sizeof(saved);
+    if (settings_store_get_blob(SETTING_ALARM_RULES, saved, &size) == ESP_OK &&
+        size % sizeof(alarm_rule_t) == 0) {
+        uint8_t count = (uint8_t)(size / sizeof(alarm_rule_t));
+        bool valid = true;
+        for (uint8_t i = 0; i < count && valid; i++) {
+            valid = alarm_rule_valid(&saved[i]);
+        }
+        if (valid) {
+            alarm_install_locked(saved, count);
+        } else {
+            ESP_LOGW(TAG, "Ignoring invalid saved alarm rules");
+        }
+    }
+
+    esp_err_t ret = sensor_manager_register_cache_listener(alarm_cache_listener, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register cache listener: %s", esp_err_to_name(ret));
+        vSemaphoreDelete(s_rules_mutex);
+        s_rules_mutex = NULL;
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Alarm rules ready (%u rules)", s_rule_count);
+    return ESP_OK;
+}
+
+void alarm_rules_set_listener(alarm_listener_t listener)
+{
+    if (s_rules_mutex == NULL) {
+        s_listener = listener;
+        return;
+    }
+    xSemaphoreTake(s_rules_mutex, portMAX_DELAY);
+    s_listener = listener;
+    xSemaphoreGive(s_rules_mutex);
+}
+
+esp_err_t alarm_rules_set(const alarm_rule_t *rules, uint8_t count)
+{
+    if (count > ALARM_RULES_MAX || (count > 0 && rules == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (!alarm_rule_valid(&rules[i])) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if (s_rules_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_rules_mutex, portMAX_DELAY);
+    alarm_install_locked(rules, count);
+    // An empty table erases the saved one
+    settings_store_set_blob(SETTING_ALARM_RULES, s_rules, count * sizeof(alarm_rule_t));
+    xSemaphoreGive(s_rules_mutex);
+
+    ESP_LOGI(TAG, "Alarm rules updated (%u rules)", count);
+    return ESP_OK;
+}
+
+uint8_t alarm_rules_get(alarm_rule_t *rules, uint8_t max_rules)
+{
+    if (rules == NULL || s_rules_mutex == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(s_rules_mutex, portMAX_DELAY);
+    uint8_t count = s_rule_count < max_rules ? s_rule_count : max_rules;
+    memcpy(rules, s_rules, count * sizeof(alarm_rule_t));
+    xSemaphoreGive(s_rules_mutex);
+    return count;
+}
+
+bool alarm_rules_is_active(uint8_t rule)
+{
+    if (s_rules_mutex == NULL || rule >= ALARM_RULES_MAX) {
+        return false;
+    }
+    bool active = false;
+    xSemaphoreTake(s_rules_mutex, portMAX_DELAY);
+    for (uint8_t i = 0; rule < s_rule_count && i < ALARM_SLOTS && !active; i++) {
+        active = s_states[rule][i].active;
+    }
+    xSemaphoreGive(s_rules_mutex);
+    return active;
+}
+
+const char *alarm_rules_kind_name(uint8_t kind)
+{
+    return kind < ALARM_RULE_KIND_COUNT ? k_kind_names[kind] : NULL;
+}
+
+int alarm_rules_kind_from_name(const char *name)
+{
+    for (int i = 0; name != NULL && i < ALARM_RULE_KIND_COUNT; i++) {
+        if (strcmp(k_kind_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+size_t alarm_rules_event_json(const alarm_event_t *event, char *buf, size_t size)
+{
+    if (event == NULL || event->def == NULL || buf == NULL) {
+        return 0;
+    }
+    const alarm_rule_t *rule = event->def;
+    const char *field = (strcmp(rule->sensor_type, ALARM_SENSOR_DERIVED) == 0) ?
+                        derived_metrics_name(rule->value_index) :
+                        telemetry_value_name(rule->sensor_type, rule->value_index);
+
+    json_writer_t w;
+    json_writer_init(&w, buf, size, NULL, NULL);
+    json_writer_object_begin(&w);
+    json_writer_kv_string(&w, "type", "alarm");
+    json_writer_kv_string(&w, "state", event->active ? "tripped" : "cleared");
+    json_writer_kv_int(&w, "rule", event->rule);
+    json_writer_kv_string(&w, "sensor", rule->sensor_type);
+    json_writer_kv_int(&w, "index", rule->value_index);
+    if (field != NULL) {
+        json_writer_kv_string(&w, "field", field);
+    }
+    if (event->address != 0) {
+        json_writer_kv_int(&w, "address", event->address);
+    }
+    json_writer_kv_string(&w, "kind", k_kind_names[rule->kind]);
+    json_writer_kv_float(&w, "threshold", rule->threshold);
+    json_writer_kv_float(&w, "hysteresis", rule->hysteresis);
+    json_writer_kv_float(&w, "value", event->value);
+    json_writer_kv_int(&w, "uptime_ms", (int64_t)(event->timestamp_us / 1000ULL));
+    time_t now;
+    if (time_sync_is_synced() && time_sync_get_timestamp(&now) == ESP_OK) {
+        json_writer_kv_int(&w, "timestamp", (int64_t)now);
+    }
+    json_writer_object_end(&w);
+    return json_writer_finish(&w) == ESP_OK ? json_writer_length(&w) : 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file alarm_rules.h
+ * @brief Local threshold and rate-of-change alarms evaluated on every cache update
+ *
+ * Each rule watches one channel (a value of a sensor type, the battery or a
+ * derived metric) and trips when it goes above or below a level, or when it
+ * changes faster than a rate. Rules are compiled once when they are set, into
+ * trip and clear levels that include the hysteresis, so evaluation in the
+ * sensor task is a compare per fresh sample. A rule trips after debounce
+ * consecutive samples past its trip level and clears after as many back
+ * inside its clear level.
+ *
+ * State changes go out at once, independent of the telemetry interval: a
+ * QoS 1 alert on the device's MQTT alert topic and an event to the listener
+ * (the dashboard WebSocket). Boards of the same type are tracked separately.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ALARM_RULES_MAX             12      // Rules kept (fits one settings blob)
+#define ALARM_RULES_MAX_DEBOUNCE    10      // Upper bound of consecutive samples to trip or clear
+#define ALARM_SENSOR_BATTERY        "battery"   // sensor_type of the fuel gauge (value_index 0)
+#define ALARM_SENSOR_DERIVED        "derived"   // sensor_type of derived metrics (value_index: derived_metric_t)
+
+typedef enum {
+    ALARM_RULE_ABOVE = 0,       // Value above threshold
+    ALARM_RULE_BELOW,           // Value below threshold
+    ALARM_RULE_RATE,            // Absolute change faster than threshold per minute
+    ALARM_RULE_KIND_COUNT
+} alarm_rule_kind_t;
+
+/**
+ * @brief One rule, as configured and saved to NVS
+ */
+typedef struct {
+    char sensor_type[16];       // EZO type string, ALARM_SENSOR_BATTERY or ALARM_SENSOR_DERIVED
+    uint8_t value_index;        // Index into the sensor's values (derived: the metric)
+    uint8_t kind;               // alarm_rule_kind_t
+    uint8_t debounce;           // Consecutive samples needed to trip and to clear (1 = immediate)
+    uint8_t reserved;
+    float threshold;
+    float hysteresis;           // Distance back inside the threshold before the rule clears
+} alarm_rule_t;
+
+/**
+ * @brief A rule tripped or cleared
+ */
+typedef struct {
+    uint8_t rule;               // Index of the rule
+    const alarm_rule_t *def;
+    uint8_t address;            // I2C address of the board, 0 for battery and derived channels
+    bool active;                // true: tripped, false: cleared
+    float value;                // Channel value, or its rate per minute for rate rules
+    uint64_t timestamp_us;      // Acquisition time of the sample (esp_timer)
+} alarm_event_t;
+
+/**
+ * @brief Called on every state change, in the sensor reading task; must not block
+ */
+typedef void (*alarm_listener_t)(const alarm_event_t *event);
+
+/**
+ * @brief Load the saved rules and start evaluating them on cache updates (idempotent)
+ */
+esp_err_t alarm_rules_init(void);
+
+/**
+ * @brief Set the listener notified of state changes (NULL to remove it)
+ */
+void alarm_rules_set_listener(alarm_listener_t listener);
+
+/**
+ * @brief Replace the rule table and save it to NVS
+ *
+ * Every rule starts out clear. An empty table disables alarms.
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for more than
+ *         ALARM_RULES_MAX rules, an unknown kind, a negative hysteresis or
+ *         rate, or a debounce outside 1..ALARM_RULES_MAX_DEBOUNCE
+ */
+esp_err_t alarm_rules_set(const alarm_rule_t *rules, uint8_t count);
+
+/**
+ * @brief Get the rule table
+ *
+ * @return Number of rules written
+ */
+uint8_t alarm_rules_get(alarm_rule_t *rules, uint8_t max_rules);
+
+/**
+ * @brief Whether a rule is tripped on any board
+ */
+bool alarm_rules_is_active(uint8_t rule);
+
+/**
+ * @brief Name of a rule kind ("above", "below", "rate"), NULL if out of range
+ */
+const char *alarm_rules_kind_name(uint8_t kind);
+
+/**
+ * @brief Rule kind from its name, -1 if unknown
+ */
+int alarm_rules_kind_from_name(const char *name);
+
+/**
+ * @brief Render an event as the JSON alert document
+ *
+ * @return Length written (without the terminator), 0 if buf is too small
+ */
+size_t alarm_rules_event_json(const alarm_event_t *event, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,6 +8,12 @@
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "esp_random.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/md.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include <string.h>
 #include <time.h>
 
@@ -18,11 +24,51 @@ static const char *TAG = "API_KEY_MGR";
 #define NVS_KEY_COUNT "key_count"
 #define NVS_KEY_PREFIX "key_"
 
+// Usage stats are written back at most this often instead of on every request
+#define API_KEY_STATS_FLUSH_MS 60000
+#define API_KEY_DIGEST_LEN 32
+
 // In-memory cache of API keys
 static api_key_t s_api_keys[API_KEY_MAX_COUNT];
 static size_t s_key_count = 0;
 static bool s_initialized = false;
 
+// Salted SHA-256 of each key, parallel to s_api_keys; the salt is random per boot
+static uint8_t s_key_digests[API_KEY_MAX_COUNT][API_KEY_DIGEST_LEN];
+static uint8_t s_digest_salt[16];
+
+static SemaphoreHandle_t s_mutex = NULL;
+static esp_timer_handle_t s_flush_timer = NULL;
+static uint32_t s_stats_dirty = 0;     // Bit per slot whose use_count/last_used is not in NVS yet
+
+static void compute_key_digest(const char *key, uint8_t out[API_KEY_DIGEST_LEN])
+{
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    mbedtls_sha256_update(&ctx, s_digest_salt, sizeof(s_digest_salt));
+    mbedtls_sha256_update(&ctx, (const unsigned char *)key, strnlen(key, API_KEY_MAX_LENGTH));
+    mbedtls_sha256_finish(&ctx, out);
+    mbedtls_sha256_free(&ctx);
+}
+
+static bool digest_equal(const uint8_t *a, const uint8_t *b)
+{
+    // Constant time: every byte is compared whatever the first mismatch
+    uint8_t diff = 0;
+    for (size_t i = 0; i < API_KEY_DIGEST_LEN; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+static void rebuild_digests(void)
+{
+    for (size_t i = 0; i < s_key_count; i++) {
+        compute_key_digest(s_api_keys[i].key, s_key_digests[i]);
+    }
+}
+
 // Helper function to save keys to NVS
 static esp_err_t save_keys_to_nvs(void)
 {
@@ -59,12 +105,85 @@ static esp_err_t save_keys_to_nvs(void)
     nvs_close(nvs_handle);
     
     if (err == ESP_OK) {
+        s_stats_dirty = 0;
         ESP_LOGI(TAG, "Saved %zu API keys to NVS", s_key_count);
     }
     
     return err;
 }
 
+// Write back only the keys whose usage stats changed since the last save
+static esp_err_t save_key_stats_to_nvs(void)
+{
+    if (s_stats_dirty == 0) {
+        return ESP_OK;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    for (size_t i = 0; i < s_key_count && err == ESP_OK; i++) {
+        if (!(s_stats_dirty & (1UL << i))) {
+            continue;
+        }
+        char key_name[16];
+        snprintf(key_name, sizeof(key_name), "%s%d", NVS_KEY_PREFIX, (int)i);
+        err = nvs_set_blob(nvs_handle, key_name, &s_api_keys[i], sizeof(api_key_t));
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (err == ESP_OK) {
+        s_stats_dirty = 0;
+    } else {
+        ESP_LOGW(TAG, "Failed to save API key usage stats: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+// Caller holds s_mutex. Start the flush unless one is already pending
+static void arm_stats_flush(void)
+{
+    if (s_stats_dirty != 0 && s_flush_timer != NULL && !esp_timer_is_active(s_flush_timer)) {
+        esp_timer_start_once(s_flush_timer, API_KEY_STATS_FLUSH_MS * 1000ULL);
+    }
+}
+
+static void stats_flush_timer_cb(void *arg)
+{
+    (void)arg;
+    if (xSemaphoreTake(s_mutex, portMAX_DELAY) == pdTRUE) {
+        // A failed save keeps its dirty bits; try again a period later
+        if (save_key_stats_to_nvs() != ESP_OK) {
+            arm_stats_flush();
+        }
+        xSemaphoreGive(s_mutex);
+    }
+}
+
+static void stats_flush_on_shutdown(void)
+{
+    // Restart path: don't wait long on a request that holds the lock
+    if (s_mutex != NULL && xSemaphoreTake(s_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        save_key_stats_to_nvs();
+        xSemaphoreGive(s_mutex);
+    }
+}
+
+// Caller holds s_mutex
+static void mark_stats_dirty(size_t index)
+{
+    s_stats_dirty |= 1UL << index;
+    // Not restarted while pending, so steady traffic still flushes once per period
+    arm_stats_flush();
+}
+
 // Helper function to load keys from NVS
 static esp_err_t load_keys_from_nvs(void)
 {
@@ -113,6 +232,24 @@ static esp_err_t load_keys_from_nvs(void)
     return ESP_OK;
 }
 
+// Undo a partial init, so a later init starts from scratch
+static void api_key_manager_teardown(void)
+{
+    esp_unregister_shutdown_handler(stats_flush_on_shutdown);
+    if (s_flush_timer != NULL) {
+        esp_timer_stop(s_flush_timer);
+        esp_timer_delete(s_flush_timer);
+        s_flush_timer = NULL;
+    }
+    if (s_mutex != NULL) {
+        vSemaphoreDelete(s_mutex);
+        s_mutex = NULL;
+    }
+    memset(s_api_keys, 0, sizeof(s_api_keys));
+    s_key_count = 0;
+    s_stats_dirty = 0;
+}
+
 esp_err_t api_key_manager_init(void)
 {
     if (s_initialized) {
@@ -122,17 +259,41 @@ esp_err_t api_key_manager_init(void)
     
     ESP_LOGI(TAG, "Initializing API key manager");
     
+    s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    esp_timer_create_args_t timer_args = {
+        .callback = stats_flush_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "api_key_flush"
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &s_flush_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create stats flush timer: %s", esp_err_to_name(err));
+        s_flush_timer = NULL;
+        api_key_manager_teardown();
+        return err;
+    }
+    esp_register_shutdown_handler(stats_flush_on_shutdown);
+    
     // Clear in-memory keys
     memset(s_api_keys, 0, sizeof(s_api_keys));
     s_key_count = 0;
     
     // Load keys from NVS
-    esp_err_t err = load_keys_from_nvs();
+    err = load_keys_from_nvs();
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to load keys from NVS");
+        api_key_manager_teardown();
         return err;
     }
     
+    esp_fill_random(s_digest_salt, sizeof(s_digest_salt));
+    rebuild_digests();
+    
     s_initialized = true;
     ESP_LOGI(TAG, "API key manager initialized with %zu keys", s_key_count);
     
@@ -150,7 +311,10 @@ esp_err_t api_key_manager_add(const char *name, const char *key, api_key_type_t
         return ESP_ERR_INVALID_ARG;
     }
     
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    
     if (s_key_count >= API_KEY_MAX_COUNT) {
+        xSemaphoreGive(s_mutex);
         ESP_LOGE(TAG, "Maximum API key count reached");
         return ESP_ERR_NO_MEM;
     }
@@ -158,6 +322,7 @@ esp_err_t api_key_manager_add(const char *name, const char *key, api_key_type_t
     // Check if key name already exists
     for (size_t i = 0; i < s_key_count; i++) {
         if (strcmp(s_api_keys[i].name, name) == 0) {
+            xSemaphoreGive(s_mutex);
             ESP_LOGW(TAG, "API key with name '%s' already exists", name);
             return ESP_ERR_INVALID_ARG;
         }
@@ -175,10 +340,12 @@ esp_err_t api_key_manager_add(const char *name, const char *key, api_key_type_t
     
     // Add to array
     s_api_keys[s_key_count] = new_key;
+    compute_key_digest(new_key.key, s_key_digests[s_key_count]);
     s_key_count++;
     
     // Save to NVS
     esp_err_t err = save_keys_to_nvs();
+    xSemaphoreGive(s_mutex);
     if (err == ESP_OK) {
         ESP_LOGI(TAG, "Added API key '%s' (type: %d)", name, type);
     }
@@ -196,6 +363,8 @@ esp_err_t api_key_manager_delete(const char *name)
         return ESP_ERR_INVALID_ARG;
     }
     
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    
     // Find key by name
     int found_index = -1;
     for (size_t i = 0; i < s_key_count; i++) {
@@ -206,6 +375,7 @@ esp_err_t api_key_manager_delete(const char *name)
     }
     
     if (found_index == -1) {
+        xSemaphoreGive(s_mutex);
         ESP_LOGW(TAG, "API key '%s' not found", name);
         return ESP_ERR_NOT_FOUND;
     }
@@ -213,15 +383,18 @@ esp_err_t api_key_manager_delete(const char *name)
     // Shift remaining keys
     for (size_t i = found_index; i < s_key_count - 1; i++) {
         s_api_keys[i] = s_api_keys[i + 1];
+        memcpy(s_key_digests[i], s_key_digests[i + 1], API_KEY_DIGEST_LEN);
     }
     
     s_key_count--;
     
     // Clear last slot
     memset(&s_api_keys[s_key_count], 0, sizeof(api_key_t));
+    memset(s_key_digests[s_key_count], 0, API_KEY_DIGEST_LEN);
     
-    // Save to NVS
+    // Save to NVS (rewrites every slot, so pending stats go out with it)
     esp_err_t err = save_keys_to_nvs();
+    xSemaphoreGive(s_mutex);
     if (err == ESP_OK) {
         ESP_LOGI(TAG, "Deleted API key '%s'", name);
     }
@@ -239,11 +412,14 @@ esp_err_t api_key_manager_set_enabled(const char *name, bool enabled)
         return ESP_ERR_INVALID_ARG;
     }
     
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    
     // Find key by name
     for (size_t i = 0; i < s_key_count; i++) {
         if (strcmp(s_api_keys[i].name, name) == 0) {
             s_api_keys[i].enabled = enabled;
             esp_err_t err = save_keys_to_nvs();
+            xSemaphoreGive(s_mutex);
             if (err == ESP_OK) {
                 ESP_LOGI(TAG, "API key '%s' %s", name, enabled ? "enabled" : "disabled");
             }
@@ -251,6 +427,7 @@ esp_err_t api_key_manager_set_enabled(const char *name, bool enabled)
         }
     }
     
+    xSemaphoreGive(s_mutex);
     ESP_LOGW(TAG, "API key '%s' not found", name);
     return ESP_ERR_NOT_FOUND;
 }
@@ -261,34 +438,71 @@ bool api_key_manager_validate(const char *key, api_key_type_t type)
         return false;
     }
     
-    // Check against all keys
+    uint8_t digest[API_KEY_DIGEST_LEN];
+    compute_key_digest(key, digest);
+    
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    
+    // Every slot is compared so the time taken doesn't depend on which key matched
+    int match = -1;
     for (size_t i = 0; i < s_key_count; i++) {
-        // Skip disabled keys
-        if (!s_api_keys[i].enabled) {
-            continue;
+        bool eligible = s_api_keys[i].enabled && (type == -1 || s_api_keys[i].type == type);
+        if (digest_equal(s_key_digests[i], digest) && eligible && match < 0) {
+            match = (int)i;
         }
-        
-        // Check type if specified (type == -1 means check all types)
-        if (type != -1 && s_api_keys[i].type != type) {
+    }
+    
+    if (match < 0) {
+        xSemaphoreGive(s_mutex);
+        ESP_LOGW(TAG, "Invalid API key provided");
+        return false;
+    }
+    
+    // Usage stats stay in RAM and are written back by the flush timer
+    s_api_keys[match].last_used_timestamp = (uint32_t)time(NULL);
+    s_api_keys[match].use_count++;
+    mark_stats_dirty(match);
+    xSemaphoreGive(s_mutex);
+    
+    ESP_LOGD(TAG, "API key validated successfully");
+    return true;
+}
+
+esp_err_t api_key_manager_hmac(const char *name, api_key_type_t type, const uint8_t *data, size_t len,
+                               uint8_t mac[API_KEY_HMAC_LEN])
+{
+    if (!s_initialized || name == NULL || (data == NULL && len > 0) || mac == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < s_key_count; i++) {
+        const api_key_t *k = &s_api_keys[i];
+        if (strcmp(k->name, name) != 0 || !k->enabled || (type != -1 && k->type != type)) {
             continue;
         }
-        
-        // Compare keys
-        if (strcmp(s_api_keys[i].key, key) == 0) {
-            // Update usage stats
-            s_api_keys[i].last_used_timestamp = (uint32_t)time(NULL);
-            s_api_keys[i].use_count++;
-            
-            // Save updated stats (non-blocking, don't check error)
-            save_keys_to_nvs();
-            
-            ESP_LOGI(TAG, "API key '%s' validated successfully", s_api_keys[i].name);
-            return true;
-        }
+        int ret = mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                                  (const unsigned char *)k->key, strnlen(k->key, API_KEY_MAX_LENGTH),
+                                  data, len, mac);
+        xSemaphoreGive(s_mutex);
+        return (ret == 0) ? ESP_OK : ESP_FAIL;
     }
+    xSemaphoreGive(s_mutex);
     
-    ESP_LOGW(TAG, "Invalid API key provided");
-    return false;
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t api_key_manager_flush(void)
+{
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    esp_timer_stop(s_flush_timer);
+    esp_err_t err = save_key_stats_to_nvs();
+    xSemaphoreGive(s_mutex);
+    return err;
 }
 
 esp_err_t api_key_manager_get(const char *name, api_key_t *key_out)
@@ -297,12 +511,15 @@ esp_err_t api_key_manager_get(const char *name, api_key_t *key_out)
         return ESP_ERR_INVALID_ARG;
     }
     
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
     for (size_t i = 0; i < s_key_count; i++) {
         if (strcmp(s_api_keys[i].name, name) == 0) {
             *key_out = s_api_keys[i];
+            xSemaphoreGive(s_mutex);
             return ESP_OK;
         }
     }
+    xSemaphoreGive(s_mutex);
     
     return ESP_ERR_NOT_FOUND;
 }
@@ -313,8 +530,10 @@ esp_err_t api_key_manager_get_all(api_key_t *keys, size_t *count)
         return ESP_ERR_INVALID_ARG;
     }
     
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
     memcpy(keys, s_api_keys, sizeof(api_key_t) * s_key_count);
     *count = s_key_count;
+    xSemaphoreGive(s_mutex);
     
     return ESP_OK;
 }
@@ -325,12 +544,15 @@ esp_err_t api_key_manager_get_by_type(api_key_type_t type, api_key_t *key_out)
         return ESP_ERR_INVALID_ARG;
     }
     
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
     for (size_t i = 0; i < s_key_count; i++) {
         if (s_api_keys[i].type == type && s_api_keys[i].enabled) {
             *key_out = s_api_keys[i];
+            xSemaphoreGive(s_mutex);
             return ESP_OK;
         }
     }
+    xSemaphoreGive(s_mutex);
     
     return ESP_ERR_NOT_FOUND;
 }
@@ -364,14 +586,20 @@ esp_err_t api_key_manager_clear_all(void)
     
     ESP_LOGW(TAG, "Clearing all API keys");
     
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    esp_timer_stop(s_flush_timer);
+    
     // Clear in-memory keys
     memset(s_api_keys, 0, sizeof(s_api_keys));
+    memset(s_key_digests, 0, sizeof(s_key_digests));
     s_key_count = 0;
+    s_stats_dirty = 0;
     
     // Clear NVS
     nvs_handle_t nvs_handle;
     esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
     if (err != ESP_OK) {
+        xSemaphoreGive(s_mutex);
         return err;
     }
     
@@ -381,6 +609,7 @@ esp_err_t api_key_manager_clear_all(void)
     }
     
     nvs_close(nvs_handle);
+    xSemaphoreGive(s_mutex);
     
     if (err == ESP_OK) {
         ESP_LOGI(TAG, "All API keys cleared");
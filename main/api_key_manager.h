@@ -14,6 +14,7 @@
 #include "esp_err.h"
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -86,7 +87,10 @@ esp_err_t api_key_manager_set_enabled(const char *name, bool enabled);
  * @brief Validate an API key
  * 
  * Checks if the provided key exists, is enabled, and matches a stored key.
- * Updates last_used_timestamp and use_count on successful validation.
+ * Keys are matched by salted digest with a constant-time comparison across
+ * every slot. Updates last_used_timestamp and use_count on successful
+ * validation; those are kept in RAM and written to NVS at most once per
+ * flush period, by api_key_manager_flush(), or at restart.
  * 
  * @param key The API key to validate
  * @param type Optional: validate against specific key type (use -1 to check all types)
@@ -94,6 +98,30 @@ esp_err_t api_key_manager_set_enabled(const char *name, bool enabled);
  */
 bool api_key_manager_validate(const char *key, api_key_type_t type);
 
+/**
+ * @brief HMAC-SHA256 of a message under a named key
+ * 
+ * Lets a protocol prove knowledge of a key without the key leaving this
+ * module. Usage stats are not updated.
+ * 
+ * @param name Name of the key
+ * @param type Required key type (use -1 to accept all types)
+ * @param data Message
+ * @param len Message length
+ * @param mac Output, API_KEY_HMAC_LEN bytes
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no enabled key of that name and type exists
+ */
+#define API_KEY_HMAC_LEN 32
+esp_err_t api_key_manager_hmac(const char *name, api_key_type_t type, const uint8_t *data, size_t len,
+                               uint8_t mac[API_KEY_HMAC_LEN]);
+
+/**
+ * @brief Write pending usage stats to NVS now
+ * 
+ * @return ESP_OK on success (or if nothing was pending)
+ */
+esp_err_t api_key_manager_flush(void);
+
 /**
  * @brief Get an API key by name
  * 
@@ -0,0 +1,215 @@
+/**
+ * @file asset_pack.c
+ * @brief Read-only dashboard asset pack served straight from memory-mapped flash
+ */
+
+#include "asset_pack.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "ASSET_PACK";
+
+#define ASSET_PACK_MAGIC        0x4B504141  // "AAPK"
+#define ASSET_PACK_VERSION      1
+#define ASSET_PACK_SECTOR_SIZE  4096
+#define ASSET_PACK_ALIGN(x)     (((x) + 3u) & ~3u)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t total_size;        // Header, index and bodies
+    uint32_t index_crc;         // CRC32 of the index entries
+} asset_pack_header_t;
+
+typedef struct {
+    char name[ASSET_PACK_NAME_MAX];
+    uint32_t offset;            // From the start of the partition
+    uint32_t size;
+    uint32_t crc32;
+    uint8_t encoding;
+    uint8_t reserved[3];
+} asset_pack_entry_t;
+
+static const esp_partition_t *s_partition = NULL;
+static esp_partition_mmap_handle_t s_mmap_handle;
+static const uint8_t *s_base = NULL;        // NULL while no valid pack is mapped
+
+static void asset_pack_unmap(void)
+{
+    if (s_base != NULL) {
+        esp_partition_munmap(s_mmap_handle);
+        s_base = NULL;
+    }
+}
+
+static const asset_pack_entry_t *asset_pack_entries(void)
+{
+    return (const asset_pack_entry_t *)(s_base + sizeof(asset_pack_header_t));
+}
+
+/**
+ * @brief Map the pack and check it end to end
+ */
+static esp_err_t asset_pack_map(void)
+{
+    asset_pack_header_t hdr;
+    esp_err_t ret = esp_partition_read(s_partition, 0, &hdr, sizeof(hdr));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    size_t index_end = sizeof(hdr) + (size_t)hdr.count * sizeof(asset_pack_entry_t);
+    if (hdr.magic != ASSET_PACK_MAGIC || hdr.version != ASSET_PACK_VERSION ||
+        hdr.count > ASSET_PACK_MAX_FILES || hdr.total_size < index_end ||
+        hdr.total_size > s_partition->size) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const void *ptr = NULL;
+    ret = esp_partition_mmap(s_partition, 0, hdr.total_size, ESP_PARTITION_MMAP_DATA, &ptr, &s_mmap_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "mmap failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    s_base = ptr;
+
+    const asset_pack_entry_t *entries = asset_pack_entries();
+    if (esp_rom_crc32_le(0, (const uint8_t *)entries, hdr.count * sizeof(asset_pack_entry_t)) != hdr.index_crc) {
+        ESP_LOGW(TAG, "Index CRC mismatch");
+        asset_pack_unmap();
+        return ESP_ERR_INVALID_CRC;
+    }
+    for (uint16_t i = 0; i < hdr.count; i++) {
+        const asset_pack_entry_t *e = &entries[i];
+        if (e->name[ASSET_PACK_NAME_MAX - 1] != '\0' || e->offset < index_end ||
+            e->offset > hdr.total_size || e->size > hdr.total_size - e->offset ||
+            esp_rom_crc32_le(0, s_base + e->offset, e->size) != e->crc32) {
+            ESP_LOGW(TAG, "Entry %u (%.*s) is corrupt", i, ASSET_PACK_NAME_MAX, e->name);
+            asset_pack_unmap();
+            return ESP_ERR_INVALID_CRC;
+        }
+    }
+
+    ESP_LOGI(TAG, "Mapped %u assets (%" PRIu32 " bytes)", hdr.count, hdr.total_size);
+    return ESP_OK;
+}
+
+esp_err_t asset_pack_init(void)
+{
+    if (s_partition == NULL) {
+        s_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                               ASSET_PACK_PARTITION_LABEL);
+        if (s_partition == NULL) {
+            ESP_LOGI(TAG, "No '%s' partition, assets are served from FATFS", ASSET_PACK_PARTITION_LABEL);
+            return ESP_ERR_NOT_FOUND;
+        }
+    }
+    if (s_base != NULL) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = asset_pack_map();
+    return (ret == ESP_OK) ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+bool asset_pack_is_valid(void)
+{
+    return s_base != NULL;
+}
+
+esp_err_t asset_pack_find(const char *name, asset_pack_file_t *file)
+{
+    if (name == NULL || file == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_base == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const asset_pack_header_t *hdr = (const asset_pack_header_t *)s_base;
+    const asset_pack_entry_t *entries = asset_pack_entries();
+    for (uint16_t i = 0; i < hdr->count; i++) {
+        if (strcmp(entries[i].name, name) == 0) {
+            file->data = (const char *)(s_base + entries[i].offset);
+            file->size = entries[i].size;
+            file->crc32 = entries[i].crc32;
+            file->encoding = (asset_pack_encoding_t)entries[i].encoding;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t asset_pack_write(const asset_pack_source_t *files, size_t count)
+{
+    if (files == NULL || count > ASSET_PACK_MAX_FILES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    asset_pack_unmap();
+
+    asset_pack_entry_t entries[ASSET_PACK_MAX_FILES];
+    memset(entries, 0, sizeof(entries));
+    size_t offset = sizeof(asset_pack_header_t) + count * sizeof(asset_pack_entry_t);
+    for (size_t i = 0; i < count; i++) {
+        if (files[i].name == NULL || strlen(files[i].name) >= ASSET_PACK_NAME_MAX ||
+            (files[i].data == NULL && files[i].size > 0)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        strncpy(entries[i].name, files[i].name, ASSET_PACK_NAME_MAX - 1);
+        entries[i].offset = offset;
+        entries[i].size = files[i].size;
+        entries[i].crc32 = esp_rom_crc32_le(0, files[i].data, files[i].size);
+        entries[i].encoding = (uint8_t)files[i].encoding;
+        offset = ASSET_PACK_ALIGN(offset + files[i].size);
+    }
+
+    // Erasing the first sector drops the old pack even when the new one does not fit,
+    // so a stale copy is never served in place of the files on FATFS
+    size_t erase_size = (offset + ASSET_PACK_SECTOR_SIZE - 1) & ~(size_t)(ASSET_PACK_SECTOR_SIZE - 1);
+    if (offset > s_partition->size) {
+        esp_partition_erase_range(s_partition, 0, ASSET_PACK_SECTOR_SIZE);
+        ESP_LOGW(TAG, "Assets need %zu bytes, partition has %" PRIu32 "; serving from FATFS",
+                 offset, s_partition->size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t ret = esp_partition_erase_range(s_partition, 0, erase_size);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Erase failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = esp_partition_write(s_partition, sizeof(asset_pack_header_t), entries,
+                              count * sizeof(asset_pack_entry_t));
+    for (size_t i = 0; i < count && ret == ESP_OK; i++) {
+        if (files[i].size > 0) {
+            ret = esp_partition_write(s_partition, entries[i].offset, files[i].data, files[i].size);
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Write failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // Header last: until it lands the partition reads as erased
+    asset_pack_header_t hdr = {
+        .magic = ASSET_PACK_MAGIC,
+        .version = ASSET_PACK_VERSION,
+        .count = (uint16_t)count,
+        .total_size = offset,
+        .index_crc = esp_rom_crc32_le(0, (const uint8_t *)entries, count * sizeof(asset_pack_entry_t)),
+    };
+    ret = esp_partition_write(s_partition, 0, &hdr, sizeof(hdr));
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Header write failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    return asset_pack_map();
+}
@@ -0,0 +1,96 @@
+/**
+ * @file asset_pack.h
+ * @brief Read-only dashboard asset pack served straight from memory-mapped flash
+ *
+ * The pack lives in the raw "assets" data partition: a header, an index of
+ * (name, offset, length, CRC32, encoding) entries, then the file bodies, each
+ * 4-byte aligned. Once validated, the partition is mapped into the data address
+ * space and asset_pack_find() returns pointers into that mapping, so serving a
+ * file needs no FATFS, wear-levelling, heap buffer or copy.
+ *
+ * The pack is a derived copy of the FATFS "www" volume: the web editor rewrites
+ * it after every change. The header goes to flash last, so a rebuild cut short
+ * by a reset leaves no valid pack and callers fall back to FATFS.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ASSET_PACK_PARTITION_LABEL  "assets"
+#define ASSET_PACK_NAME_MAX         32      // Including the terminating NUL
+#define ASSET_PACK_MAX_FILES        8
+
+typedef enum {
+    ASSET_PACK_ENCODING_IDENTITY = 0,
+    ASSET_PACK_ENCODING_GZIP = 1,
+} asset_pack_encoding_t;
+
+/**
+ * @brief One file to store in the pack
+ */
+typedef struct {
+    const char *name;
+    const void *data;
+    size_t size;
+    asset_pack_encoding_t encoding;
+} asset_pack_source_t;
+
+/**
+ * @brief A file in the mapped pack
+ *
+ * data points into flash and stays valid until the next asset_pack_write().
+ */
+typedef struct {
+    const char *data;
+    size_t size;
+    uint32_t crc32;             // CRC32 of the stored bytes
+    asset_pack_encoding_t encoding;
+} asset_pack_file_t;
+
+/**
+ * @brief Find the partition and map the pack if it is valid
+ *
+ * Checks the header, the index CRC and every file CRC once, so lookups can
+ * trust the mapping afterwards.
+ *
+ * @return esp_err_t ESP_OK with a valid pack, ESP_ERR_NOT_FOUND without an
+ *         "assets" partition, ESP_ERR_INVALID_STATE if the partition holds no
+ *         valid pack (erased, or a rebuild was interrupted)
+ */
+esp_err_t asset_pack_init(void);
+
+/**
+ * @brief Check if a valid pack is mapped
+ */
+bool asset_pack_is_valid(void);
+
+/**
+ * @brief Look up a file by name
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if the file is not in
+ *         the pack, ESP_ERR_INVALID_STATE without a valid pack
+ */
+esp_err_t asset_pack_find(const char *name, asset_pack_file_t *file);
+
+/**
+ * @brief Replace the pack with the given files
+ *
+ * Unmaps the current pack first: the caller must make sure no pointer from
+ * asset_pack_find() is still in use.
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_SIZE if the files do
+ *         not fit the partition (no valid pack remains in that case)
+ */
+esp_err_t asset_pack_write(const asset_pack_source_t *files, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
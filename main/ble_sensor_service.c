@@ -0,0 +1,409 @@
+/**
+ * @file ble_sensor_service.c
+ * @brief NimBLE GATT service serving the sensor cache after provisioning
+ */
+
+#include "ble_sensor_service.h"
+#include "idf_provisioning.h"
+#include "sensor_manager.h"
+#include "telemetry_codec.h"
+#include "time_sync.h"
+#include "esp_log.h"
+#include "nimble/nimble_port.h"
+#include "nimble/nimble_port_freertos.h"
+#include "host/ble_hs.h"
+#include "host/util/util.h"
+#include "services/gap/ble_svc_gap.h"
+#include "services/gatt/ble_svc_gatt.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "BLE_SENSORS";
+
+#ifndef CONFIG_KC_BLE_SENSOR_PAIRING_SEC
+#define CONFIG_KC_BLE_SENSOR_PAIRING_SEC 300
+#endif
+#ifndef CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+#define CONFIG_BT_NIMBLE_MAX_CONNECTIONS 1
+#endif
+
+#define BLE_SENSOR_FRAME_HEADER     2
+#define BLE_SENSOR_PROV_WAIT_MS     10000
+// Advertising 1 s apart; connections at 200-400 ms with 4 skippable events
+#define BLE_SENSOR_ADV_ITVL         BLE_GAP_ADV_ITVL_MS(1000)
+#define BLE_SENSOR_CONN_ITVL_MIN    160     // 1.25 ms units
+#define BLE_SENSOR_CONN_ITVL_MAX    320
+#define BLE_SENSOR_CONN_LATENCY     4
+#define BLE_SENSOR_SUPERVISION_TO   600     // 10 ms units
+
+void ble_store_config_init(void);
+
+// 3a1f0000-6b5c-4d3e-9a2b-4b4321c0ffee and its characteristics, least significant byte first
+static const ble_uuid128_t k_service_uuid =
+    BLE_UUID128_INIT(0xee, 0xff, 0xc0, 0x21, 0x43, 0x4b, 0x2b, 0x9a, 0x3e, 0x4d, 0x5c, 0x6b, 0x00, 0x00, 0x1f, 0x3a);
+static const ble_uuid128_t k_snapshot_uuid =
+    BLE_UUID128_INIT(0xee, 0xff, 0xc0, 0x21, 0x43, 0x4b, 0x2b, 0x9a, 0x3e, 0x4d, 0x5c, 0x6b, 0x01, 0x00, 0x1f, 0x3a);
+
+typedef struct {
+    uint16_t conn_handle;
+    bool subscribed;
+} ble_sensor_peer_t;
+
+// Host task state; the cache listener only posts s_cache_event
+static bool s_started = false;
+static bool s_pairing_open = true;
+static uint8_t s_own_addr_type;
+static uint16_t s_snapshot_handle;
+static ble_sensor_peer_t s_peers[CONFIG_BT_NIMBLE_MAX_CONNECTIONS];
+static sensor_cache_t s_cache;
+static uint8_t s_packed[TELEMETRY_PACKED_MAX_SIZE];
+static size_t s_packed_len = 0;
+static uint8_t s_counter = 0;
+static struct ble_npl_event s_cache_event;
+static struct ble_npl_callout s_pairing_callout;
+
+static void ble_sensor_advertise(void);
+
+/**
+ * @brief Repack the cache into s_packed (host task)
+ *
+ * Done once per new cache, so every blob of a long read comes from the same snapshot.
+ */
+static bool ble_sensor_refresh_packed(void) {
+    if (sensor_manager_get_cached_data(&s_cache) != ESP_OK) {
+        s_packed_len = 0;
+        return false;
+    }
+    uint32_t unix_time = time_sync_is_synced() ? (uint32_t)time(NULL) : 0;
+    if (telemetry_pack_snapshot(&s_cache, unix_time, s_packed, sizeof(s_packed), &s_packed_len) != ESP_OK) {
+        s_packed_len = 0;
+        return false;
+    }
+    s_counter++;
+    return true;
+}
+
+static int ble_sensor_snapshot_access(uint16_t conn_handle, uint16_t attr_handle,
+                                      struct ble_gatt_access_ctxt *ctxt, void *arg) {
+    (void)conn_handle;
+    (void)attr_handle;
+    (void)arg;
+    if (ctxt->op != BLE_GATT_ACCESS_OP_READ_CHR) {
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+    // Long reads come back here per blob, so serve the copy packed on the last cache event
+    if (s_packed_len == 0) {
+        ble_sensor_refresh_packed();
+    }
+    if (s_packed_len == 0) {
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+    return os_mbuf_append(ctxt->om, s_packed, s_packed_len) == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+static const struct ble_gatt_svc_def k_services[] = {
+    {
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = &k_service_uuid.u,
+        .characteristics = (struct ble_gatt_chr_def[]) {
+            {
+                .uuid = &k_snapshot_uuid.u,
+                .access_cb = ble_sensor_snapshot_access,
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_READ_ENC | BLE_GATT_CHR_F_NOTIFY,
+                .val_handle = &s_snapshot_handle,
+            },
+            { 0 }
+        },
+    },
+    { 0 }
+};
+
+static ble_sensor_peer_t *ble_sensor_peer(uint16_t conn_handle) {
+    for (int i = 0; i < CONFIG_BT_NIMBLE_MAX_CONNECTIONS; i++) {
+        if (s_peers[i].conn_handle == conn_handle) {
+            return &s_peers[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Send the packed cache to one subscriber in MTU-sized frames
+ */
+static void ble_sensor_notify_peer(uint16_t conn_handle) {
+    uint16_t mtu = ble_att_mtu(conn_handle);
+    size_t chunk = (mtu > 3 + BLE_SENSOR_FRAME_HEADER) ? mtu - 3 - BLE_SENSOR_FRAME_HEADER : 0;
+    size_t frames = (chunk > 0) ? (s_packed_len + chunk - 1) / chunk : 0;
+    uint8_t frame[BLE_SENSOR_FRAME_HEADER + TELEMETRY_PACKED_MAX_SIZE];
+
+    if (frames == 0 || frames > BLE_SENSOR_MAX_FRAMES) {
+        // Too large for this MTU: the header alone tells the client to read instead
+        frame[0] = s_counter;
+        frame[1] = 0;
+        struct os_mbuf *om = ble_hs_mbuf_from_flat(frame, BLE_SENSOR_FRAME_HEADER);
+        if (om != NULL) {
+            ble_gatts_notify_custom(conn_handle, s_snapshot_handle, om);
+        }
+        return;
+    }
+
+    for (size_t f = 0; f < frames; f++) {
+        size_t offset = f * chunk;
+        size_t len = (s_packed_len - offset < chunk) ? s_packed_len - offset : chunk;
+        frame[0] = s_counter;
+        frame[1] = (uint8_t)((f << 4) | frames);
+        memcpy(frame + BLE_SENSOR_FRAME_HEADER, s_packed + offset, len);
+        struct os_mbuf *om = ble_hs_mbuf_from_flat(frame, BLE_SENSOR_FRAME_HEADER + len);
+        if (om == NULL || ble_gatts_notify_custom(conn_handle, s_snapshot_handle, om) != 0) {
+            // Out of buffers; the next cache brings the client up to date
+            ESP_LOGD(TAG, "Notification to %u stopped at frame %u/%u", conn_handle, (unsigned)f, (unsigned)frames);
+            return;
+        }
+    }
+}
+
+static void ble_sensor_cache_event(struct ble_npl_event *ev) {
+    (void)ev;
+    if (!ble_sensor_refresh_packed()) {
+        return;
+    }
+    for (int i = 0; i < CONFIG_BT_NIMBLE_MAX_CONNECTIONS; i++) {
+        if (s_peers[i].subscribed) {
+            ble_sensor_notify_peer(s_peers[i].conn_handle);
+        }
+    }
+}
+
+static void ble_sensor_cache_listener(const sensor_cache_t *cache, void *user_ctx) {
+    (void)cache;
+    (void)user_ctx;
+    // Packing and notifying run in the NimBLE host task, not in acquisition
+    ble_npl_eventq_put(nimble_port_get_dflt_eventq(), &s_cache_event);
+}
+
+static void ble_sensor_close_pairing(struct ble_npl_event *ev) {
+    (void)ev;
+    s_pairing_open = false;
+    ble_hs_cfg.sm_bonding = 0;
+    ESP_LOGI(TAG, "Pairing window closed; only bonded phones can connect");
+}
+
+static int ble_sensor_gap_event(struct ble_gap_event *event, void *arg) {
+    (void)arg;
+    struct ble_gap_conn_desc desc;
+
+    switch (event->type) {
+        case BLE_GAP_EVENT_CONNECT:
+            if (event->connect.status != 0) {
+                ble_sensor_advertise();
+                return 0;
+            }
+            for (int i = 0; i < CONFIG_BT_NIMBLE_MAX_CONNECTIONS; i++) {
+                if (s_peers[i].conn_handle == BLE_HS_CONN_HANDLE_NONE) {
+                    s_peers[i].conn_handle = event->connect.conn_handle;
+                    s_peers[i].subscribed = false;
+                    break;
+                }
+            }
+            {
+                struct ble_gap_upd_params params = {
+                    .itvl_min = BLE_SENSOR_CONN_ITVL_MIN,
+                    .itvl_max = BLE_SENSOR_CONN_ITVL_MAX,
+                    .latency = BLE_SENSOR_CONN_LATENCY,
+                    .supervision_timeout = BLE_SENSOR_SUPERVISION_TO,
+                };
+                ble_gap_update_params(event->connect.conn_handle, &params);
+            }
+            // Encrypt straight away: a bonded phone resumes, a new one pairs or is dropped
+            ble_gap_security_initiate(event->connect.conn_handle);
+            // Another phone may connect while this one is served
+            ble_sensor_advertise();
+            return 0;
+
+        case BLE_GAP_EVENT_DISCONNECT: {
+            ble_sensor_peer_t *peer = ble_sensor_peer(event->disconnect.conn.conn_handle);
+            if (peer != NULL) {
+                peer->conn_handle = BLE_HS_CONN_HANDLE_NONE;
+                peer->subscribed = false;
+            }
+            ble_sensor_advertise();
+            return 0;
+        }
+
+        case BLE_GAP_EVENT_ENC_CHANGE:
+            if (event->enc_change.status != 0 ||
+                ble_gap_conn_find(event->enc_change.conn_handle, &desc) != 0 || !desc.sec_state.bonded) {
+                ESP_LOGW(TAG, "Dropping unbonded connection %u", event->enc_change.conn_handle);
+                ble_gap_terminate(event->enc_change.conn_handle, BLE_ERR_REM_USER_CONN_TERM);
+            }
+            return 0;
+
+        case BLE_GAP_EVENT_REPEAT_PAIRING:
+            // The phone lost its bond; replace ours only while new bonds are accepted
+            if (!s_pairing_open) {
+                return BLE_GAP_REPEAT_PAIRING_IGNORE;
+            }
+            if (ble_gap_conn_find(event->repeat_pairing.conn_handle, &desc) == 0) {
+                ble_store_util_delete_peer(&desc.peer_id_addr);
+            }
+            return BLE_GAP_REPEAT_PAIRING_RETRY;
+
+        case BLE_GAP_EVENT_SUBSCRIBE:
+            if (event->subscribe.attr_handle == s_snapshot_handle) {
+                ble_sensor_peer_t *peer = ble_sensor_peer(event->subscribe.conn_handle);
+                if (peer != NULL) {
+                    peer->subscribed = event->subscribe.cur_notify;
+                }
+                if (event->subscribe.cur_notify && (s_packed_len > 0 || ble_sensor_refresh_packed())) {
+                    ble_sensor_notify_peer(event->subscribe.conn_handle);
+                }
+            }
+            return 0;
+
+        case BLE_GAP_EVENT_ADV_COMPLETE:
+            ble_sensor_advertise();
+            return 0;
+
+        default:
+            return 0;
+    }
+}
+
+static void ble_sensor_advertise(void) {
+    if (ble_gap_adv_active()) {
+        return;
+    }
+    bool free_slot = false;
+    for (int i = 0; i < CONFIG_BT_NIMBLE_MAX_CONNECTIONS; i++) {
+        free_slot |= (s_peers[i].conn_handle == BLE_HS_CONN_HANDLE_NONE);
+    }
+    if (!free_slot) {
+        return;
+    }
+
+    // Service UUID in the advertisement, name in the scan response: both do not fit in 31 bytes
+    struct ble_hs_adv_fields fields = { 0 };
+    fields.flags = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP;
+    fields.uuids128 = &k_service_uuid;
+    fields.num_uuids128 = 1;
+    fields.uuids128_is_complete = 1;
+    int rc = ble_gap_adv_set_fields(&fields);
+    if (rc == 0) {
+        struct ble_hs_adv_fields rsp = { 0 };
+        const char *name = ble_svc_gap_device_name();
+        rsp.name = (const uint8_t *)name;
+        rsp.name_len = strlen(name);
+        rsp.name_is_complete = 1;
+        rc = ble_gap_adv_rsp_set_fields(&rsp);
+    }
+    if (rc != 0) {
+        ESP_LOGE(TAG, "Advertising data rejected: %d", rc);
+        return;
+    }
+
+    struct ble_gap_adv_params params = {
+        .conn_mode = BLE_GAP_CONN_MODE_UND,
+        .disc_mode = BLE_GAP_DISC_MODE_GEN,
+        .itvl_min = BLE_SENSOR_ADV_ITVL,
+        .itvl_max = BLE_SENSOR_ADV_ITVL,
+    };
+    rc = ble_gap_adv_start(s_own_addr_type, NULL, BLE_HS_FOREVER, &params, ble_sensor_gap_event, NULL);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "Advertising failed to start: %d", rc);
+    }
+}
+
+static void ble_sensor_on_sync(void) {
+    ble_hs_util_ensure_addr(0);
+    if (ble_hs_id_infer_auto(0, &s_own_addr_type) != 0) {
+        ESP_LOGE(TAG, "No usable BLE address");
+        return;
+    }
+    ble_sensor_advertise();
+}
+
+static void ble_sensor_on_reset(int reason) {
+    ESP_LOGW(TAG, "NimBLE host reset: %d", reason);
+}
+
+static void ble_sensor_host_task(void *param) {
+    (void)param;
+    nimble_port_run();
+    nimble_port_freertos_deinit();
+}
+
+esp_err_t ble_sensor_service_start(void) {
+    if (s_started) {
+        return ESP_OK;
+    }
+
+    // Provisioning owns the stack until it has sent its last response and deinit
+    for (int waited = 0; idf_provisioning_is_running(); waited += 100) {
+        if (waited >= BLE_SENSOR_PROV_WAIT_MS) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+
+    esp_err_t err = nimble_port_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NimBLE init failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    for (int i = 0; i < CONFIG_BT_NIMBLE_MAX_CONNECTIONS; i++) {
+        s_peers[i].conn_handle = BLE_HS_CONN_HANDLE_NONE;
+    }
+
+    ble_hs_cfg.sync_cb = ble_sensor_on_sync;
+    ble_hs_cfg.reset_cb = ble_sensor_on_reset;
+    ble_hs_cfg.store_status_cb = ble_store_util_status_rr;
+    ble_hs_cfg.sm_io_cap = BLE_HS_IO_NO_INPUT_OUTPUT;
+    ble_hs_cfg.sm_bonding = 1;
+    ble_hs_cfg.sm_sc = 1;
+    ble_hs_cfg.sm_our_key_dist = BLE_SM_PAIR_KEY_DIST_ENC | BLE_SM_PAIR_KEY_DIST_ID;
+    ble_hs_cfg.sm_their_key_dist = BLE_SM_PAIR_KEY_DIST_ENC | BLE_SM_PAIR_KEY_DIST_ID;
+
+    ble_svc_gap_init();
+    ble_svc_gatt_init();
+    int rc = ble_gatts_count_cfg(k_services);
+    if (rc == 0) {
+        rc = ble_gatts_add_svcs(k_services);
+    }
+    if (rc != 0) {
+        ESP_LOGE(TAG, "GATT table rejected: %d", rc);
+        nimble_port_deinit();
+        return ESP_FAIL;
+    }
+    ble_svc_gap_device_name_set(idf_provisioning_get_service_name());
+    ble_store_config_init();
+
+    ble_npl_event_init(&s_cache_event, ble_sensor_cache_event, NULL);
+    ble_npl_callout_init(&s_pairing_callout, nimble_port_get_dflt_eventq(), ble_sensor_close_pairing, NULL);
+    ble_npl_callout_reset(&s_pairing_callout, ble_npl_time_ms_to_ticks32(CONFIG_KC_BLE_SENSOR_PAIRING_SEC * 1000));
+
+    err = sensor_manager_register_cache_listener(ble_sensor_cache_listener, NULL);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "No cache listener slot; notifications disabled: %s", esp_err_to_name(err));
+    }
+
+    nimble_port_freertos_init(ble_sensor_host_task);
+    s_started = true;
+    ESP_LOGI(TAG, "Sensor service advertising as %s (pairing open for %d s)",
+             idf_provisioning_get_service_name(), CONFIG_KC_BLE_SENSOR_PAIRING_SEC);
+    return ESP_OK;
+}
+
+bool ble_sensor_service_is_connected(void) {
+    if (!s_started) {
+        return false;
+    }
+    for (int i = 0; i < CONFIG_BT_NIMBLE_MAX_CONNECTIONS; i++) {
+        if (s_peers[i].conn_handle != BLE_HS_CONN_HANDLE_NONE) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file ble_sensor_service.h
+ * @brief NimBLE GATT service serving the sensor cache after provisioning
+ *
+ * With CONFIG_KC_BLE_SENSOR_SERVICE the device keeps advertising under its
+ * provisioning name once Wi-Fi is set up, so a phone on site can read the
+ * sensors without the cloud. One characteristic holds the cache in the
+ * packed snapshot encoding (telemetry_pack_snapshot()); subscribers get it
+ * as notifications on every new cache.
+ *
+ * Each notification is the snapshot split into frames of at most MTU - 3
+ * bytes, every frame starting with a two-byte header: a counter that
+ * changes with each cache, then frame index (high nibble) and frame count
+ * (low nibble). A snapshot needing more than BLE_SENSOR_MAX_FRAMES frames is
+ * announced by one header-only frame with count 0; the client reads the
+ * characteristic instead.
+ *
+ * Access needs an encrypted link to a bonded peer. New bonds are accepted
+ * only for CONFIG_KC_BLE_SENSOR_PAIRING_SEC after the service starts (power
+ * the device up to pair a phone); afterwards unbonded links are dropped as
+ * soon as they are encrypted. Advertising and the requested connection
+ * interval are slow, to keep the radio's share of the power budget small.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLE_SENSOR_MAX_FRAMES   15
+
+/**
+ * @brief Bring up NimBLE and start advertising (idempotent)
+ *
+ * Waits for BLE provisioning to release the stack first.
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_TIMEOUT if provisioning does not end,
+ *         or the NimBLE init error
+ */
+esp_err_t ble_sensor_service_start(void);
+
+/**
+ * @brief Whether a bonded peer is connected
+ */
+bool ble_sensor_service_is_connected(void);
+
+#ifdef __cplusplus
+}
+#endif
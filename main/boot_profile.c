@@ -0,0 +1,177 @@
+/**
+ * @file boot_profile.c
+ * @brief Boot timing marks, kept for the last few boots
+ */
+
+#include "boot_profile.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "nvs.h"
+#include <string.h>
+
+static const char *TAG = "BOOT_PROF";
+
+#define NVS_NAMESPACE "boot_prof"
+#define NVS_KEY_HISTORY "history"
+
+static const char *const k_mark_names[BOOT_MARK_COUNT] = {
+    [BOOT_MARK_APP_MAIN]        = "app_main",
+    [BOOT_MARK_SECURITY]        = "security",
+    [BOOT_MARK_WIFI_ASSOCIATED] = "wifi_associated",
+    [BOOT_MARK_GOT_IP]          = "got_ip",
+    [BOOT_MARK_TIME_SYNCED]     = "time_synced",
+    [BOOT_MARK_PROVISIONED]     = "provisioned",
+    [BOOT_MARK_HTTPS_UP]        = "https_up",
+    [BOOT_MARK_I2C_SCANNED]     = "i2c_scanned",
+    [BOOT_MARK_SENSORS_READY]   = "sensors_ready",
+    [BOOT_MARK_MQTT_CONNECTED]  = "mqtt_connected",
+    [BOOT_MARK_FIRST_PUBLISH]   = "first_publish",
+};
+
+// Newest first; slot 0 is this boot once init has run
+static boot_profile_t s_history[BOOT_PROFILE_HISTORY];
+static uint8_t s_history_count = 0;
+static boot_profile_t s_current;
+static esp_timer_handle_t s_save_timer = NULL;
+static bool s_saved = false;
+
+static void boot_profile_save(void)
+{
+    if (s_saved) {
+        return;
+    }
+    s_saved = true;
+
+    // Older boots shift down one slot; the oldest falls off the end
+    memmove(&s_history[1], &s_history[0], sizeof(s_history[0]) * (BOOT_PROFILE_HISTORY - 1));
+    s_history[0] = s_current;
+    if (s_history_count < BOOT_PROFILE_HISTORY) {
+        s_history_count++;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(nvs_handle, NVS_KEY_HISTORY, s_history, sizeof(s_history[0]) * s_history_count);
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs_handle);
+        }
+        nvs_close(nvs_handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save boot profile: %s", esp_err_to_name(err));
+        return;
+    }
+    ESP_LOGI(TAG, "Boot #%lu: first publish at %lu ms", (unsigned long)s_current.boot_count,
+             (unsigned long)s_current.mark_ms[BOOT_MARK_FIRST_PUBLISH]);
+}
+
+static void save_timer_cb(void *arg)
+{
+    (void)arg;
+    boot_profile_save();
+}
+
+esp_err_t boot_profile_init(void)
+{
+    if (s_save_timer != NULL) {
+        return ESP_OK;
+    }
+
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
+        size_t size = sizeof(s_history);
+        if (nvs_get_blob(nvs_handle, NVS_KEY_HISTORY, s_history, &size) == ESP_OK) {
+            // A shorter blob is a history that has not filled up yet
+            s_history_count = (uint8_t)(size / sizeof(s_history[0]));
+        }
+        nvs_close(nvs_handle);
+    }
+
+    s_current.boot_count = (s_history_count > 0) ? s_history[0].boot_count + 1 : 1;
+    s_current.reset_reason = (uint8_t)esp_reset_reason();
+
+    esp_timer_create_args_t args = {
+        .callback = save_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "boot_profile"
+    };
+    esp_err_t err = esp_timer_create(&args, &s_save_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return esp_timer_start_once(s_save_timer, BOOT_PROFILE_SAVE_DEADLINE_MS * 1000ULL);
+}
+
+void boot_profile_mark(boot_mark_t mark)
+{
+    if (mark >= BOOT_MARK_COUNT || s_current.mark_ms[mark] != 0) {
+        return;
+    }
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    s_current.mark_ms[mark] = now_ms ? now_ms : 1;
+
+    if (mark == BOOT_MARK_FIRST_PUBLISH && s_save_timer != NULL && !s_saved) {
+        // Save off the caller's task (the MQTT event loop)
+        esp_timer_stop(s_save_timer);
+        esp_timer_start_once(s_save_timer, 1000);
+    }
+}
+
+void boot_profile_ezo_init(uint8_t address, uint32_t duration_ms, bool ok)
+{
+    if (s_current.ezo_count >= BOOT_PROFILE_MAX_EZO) {
+        return;
+    }
+    boot_ezo_timing_t *ezo = &s_current.ezo[s_current.ezo_count++];
+    ezo->address = address;
+    ezo->ok = ok;
+    ezo->duration_ms = duration_ms > UINT16_MAX ? UINT16_MAX : (uint16_t)duration_ms;
+}
+
+static void write_profile_json(json_writer_t *w, const boot_profile_t *profile)
+{
+    json_writer_object_begin(w);
+    json_writer_kv_int(w, "boot", profile->boot_count);
+    json_writer_kv_int(w, "reset_reason", profile->reset_reason);
+    json_writer_key(w, "marks_ms");
+    json_writer_object_begin(w);
+    for (int i = 0; i < BOOT_MARK_COUNT; i++) {
+        if (profile->mark_ms[i] != 0) {
+            json_writer_kv_int(w, k_mark_names[i], profile->mark_ms[i]);
+        }
+    }
+    json_writer_object_end(w);
+    if (profile->ezo_count > 0) {
+        json_writer_key(w, "ezo_init");
+        json_writer_array_begin(w);
+        for (uint8_t i = 0; i < profile->ezo_count && i < BOOT_PROFILE_MAX_EZO; i++) {
+            json_writer_object_begin(w);
+            json_writer_kv_int(w, "address", profile->ezo[i].address);
+            json_writer_kv_int(w, "ms", profile->ezo[i].duration_ms);
+            json_writer_kv_bool(w, "ok", profile->ezo[i].ok);
+            json_writer_object_end(w);
+        }
+        json_writer_array_end(w);
+    }
+    json_writer_object_end(w);
+}
+
+void boot_profile_write_json(json_writer_t *w, bool history)
+{
+    json_writer_object_begin(w);
+    json_writer_key(w, "current");
+    write_profile_json(w, &s_current);
+    if (history) {
+        // Once saved, slot 0 is this boot again
+        json_writer_key(w, "previous");
+        json_writer_array_begin(w);
+        for (uint8_t i = s_saved ? 1 : 0; i < s_history_count; i++) {
+            write_profile_json(w, &s_history[i]);
+        }
+        json_writer_array_end(w);
+    }
+    json_writer_object_end(w);
+}
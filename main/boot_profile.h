@@ -0,0 +1,84 @@
+/**
+ * @file boot_profile.h
+ * @brief Boot timing marks, kept for the last few boots
+ *
+ * Subsystems record the first time they reach a milestone (Wi-Fi associated,
+ * time synced, first MQTT publish acknowledged, ...) as milliseconds since the
+ * application started. Marks are plain stores into RAM, so they can be taken
+ * from any task at any point in startup, even before boot_profile_init(). The
+ * profile is written to NVS once the first publish is acknowledged (or after
+ * BOOT_PROFILE_SAVE_DEADLINE_MS), alongside the profiles of the previous
+ * BOOT_PROFILE_HISTORY - 1 boots.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BOOT_PROFILE_HISTORY            4       // Boots kept in NVS, current one included
+#define BOOT_PROFILE_MAX_EZO            8
+#define BOOT_PROFILE_SAVE_DEADLINE_MS   180000  // Save even if nothing is ever published
+
+typedef enum {
+    BOOT_MARK_APP_MAIN,
+    BOOT_MARK_SECURITY,
+    BOOT_MARK_WIFI_ASSOCIATED,
+    BOOT_MARK_GOT_IP,
+    BOOT_MARK_TIME_SYNCED,
+    BOOT_MARK_PROVISIONED,
+    BOOT_MARK_HTTPS_UP,
+    BOOT_MARK_I2C_SCANNED,
+    BOOT_MARK_SENSORS_READY,
+    BOOT_MARK_MQTT_CONNECTED,
+    BOOT_MARK_FIRST_PUBLISH,
+    BOOT_MARK_COUNT
+} boot_mark_t;
+
+typedef struct {
+    uint8_t address;
+    bool ok;
+    uint16_t duration_ms;
+} boot_ezo_timing_t;
+
+typedef struct {
+    uint32_t boot_count;
+    uint8_t reset_reason;                       // esp_reset_reason_t
+    uint8_t ezo_count;
+    uint32_t mark_ms[BOOT_MARK_COUNT];          // 0 = milestone not reached
+    boot_ezo_timing_t ezo[BOOT_PROFILE_MAX_EZO];
+} boot_profile_t;
+
+/**
+ * @brief Load previous boots and arm the deadline save
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t boot_profile_init(void);
+
+/**
+ * @brief Record the first time a milestone is reached; later calls are ignored
+ */
+void boot_profile_mark(boot_mark_t mark);
+
+/**
+ * @brief Record how long one EZO board took to initialize
+ */
+void boot_profile_ezo_init(uint8_t address, uint32_t duration_ms, bool ok);
+
+/**
+ * @brief Write boot profiles as a JSON object
+ *
+ * @param history true to add the previous boots stored in NVS
+ */
+void boot_profile_write_json(json_writer_t *w, bool history);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,113 @@
+/**
+ * @file calib_stability.c
+ * @brief Rolling stability metric for probes settling in a calibration solution
+ */
+
+#include "calib_stability.h"
+#include "ezo_sensor.h"
+#include <math.h>
+#include <string.h>
+
+typedef struct {
+    const char *sensor_type;
+    float tolerance_abs;
+    float tolerance_rel;
+} calib_tolerance_t;
+
+// Roughly the repeatability EZO boards quote for each probe
+static const calib_tolerance_t k_tolerances[] = {
+    { EZO_TYPE_PH,  0.02f,  0.0f   },
+    { EZO_TYPE_ORP, 2.0f,   0.0f   },
+    { EZO_TYPE_EC,  2.0f,   0.01f  },
+    { EZO_TYPE_DO,  0.05f,  0.01f  },
+    { EZO_TYPE_RTD, 0.05f,  0.0f   },
+    { EZO_TYPE_HUM, 0.5f,   0.01f  },
+};
+
+void calib_stability_init(calib_stability_t *tracker, const char *sensor_type)
+{
+    if (tracker == NULL) {
+        return;
+    }
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->tolerance_abs = 0.01f;
+    tracker->tolerance_rel = 0.01f;
+    for (size_t i = 0; sensor_type != NULL && i < sizeof(k_tolerances) / sizeof(k_tolerances[0]); i++) {
+        if (strcmp(k_tolerances[i].sensor_type, sensor_type) == 0) {
+            tracker->tolerance_abs = k_tolerances[i].tolerance_abs;
+            tracker->tolerance_rel = k_tolerances[i].tolerance_rel;
+            break;
+        }
+    }
+}
+
+void calib_stability_add(calib_stability_t *tracker, uint64_t t_ms, float value,
+                         calib_stability_result_t *result)
+{
+    if (tracker == NULL || result == NULL) {
+        return;
+    }
+    memset(result, 0, sizeof(*result));
+
+    if (isfinite(value)) {
+        tracker->t_ms[tracker->head] = t_ms;
+        tracker->value[tracker->head] = value;
+        tracker->head = (tracker->head + 1) % CALIB_STABILITY_SAMPLES;
+        if (tracker->count < CALIB_STABILITY_SAMPLES) {
+            tracker->count++;
+        }
+    }
+
+    // Walk back from the newest sample until the window is covered; times are
+    // taken relative to the newest one so the sums stay small in float
+    uint8_t n = 0;
+    uint64_t newest = 0;
+    uint64_t oldest = 0;
+    double sum_t = 0.0, sum_v = 0.0, sum_tt = 0.0, sum_tv = 0.0;
+    for (uint8_t i = 0; i < tracker->count; i++) {
+        uint8_t idx = (tracker->head + CALIB_STABILITY_SAMPLES - 1 - i) % CALIB_STABILITY_SAMPLES;
+        if (i == 0) {
+            newest = tracker->t_ms[idx];
+        } else if (newest - tracker->t_ms[idx] > CALIB_STABILITY_WINDOW_MS) {
+            break;
+        }
+        oldest = tracker->t_ms[idx];
+        double t = -(double)(newest - tracker->t_ms[idx]) / 60000.0;  // Minutes before the newest
+        double v = tracker->value[idx];
+        sum_t += t;
+        sum_v += v;
+        sum_tt += t * t;
+        sum_tv += t * v;
+        n++;
+    }
+    if (n == 0) {
+        return;
+    }
+
+    double mean_t = sum_t / n;
+    double mean_v = sum_v / n;
+    double var_t = sum_tt / n - mean_t * mean_t;
+    double slope = (var_t > 0.0) ? (sum_tv / n - mean_t * mean_v) / var_t : 0.0;
+
+    double sq = 0.0;
+    for (uint8_t i = 0; i < n; i++) {
+        uint8_t idx = (tracker->head + CALIB_STABILITY_SAMPLES - 1 - i) % CALIB_STABILITY_SAMPLES;
+        double t = -(double)(newest - tracker->t_ms[idx]) / 60000.0;
+        double fit = mean_v + slope * (t - mean_t);
+        double r = tracker->value[idx] - fit;
+        sq += r * r;
+    }
+
+    result->samples = n;
+    result->span_ms = (uint32_t)(newest - oldest);
+    result->mean = (float)mean_v;
+    result->stddev = (float)sqrt(sq / n);
+    result->slope_per_min = (float)slope;
+    result->tolerance = fmaxf(tracker->tolerance_abs, tracker->tolerance_rel * fabsf(result->mean));
+
+    float drift = fabsf(result->slope_per_min) * (CALIB_STABILITY_WINDOW_MS / 60000.0f);
+    result->stable = n >= CALIB_STABILITY_MIN_SAMPLES &&
+                     result->span_ms >= CALIB_STABILITY_MIN_SPAN_MS &&
+                     result->stddev <= result->tolerance &&
+                     drift <= result->tolerance;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file calib_stability.h
+ * @brief Rolling stability metric for probes settling in a calibration solution
+ *
+ * Calibration sessions feed the focused board's primary reading into a
+ * tracker. It keeps the last CALIB_STABILITY_WINDOW_MS of samples and fits a
+ * least-squares line to them. The reading counts as stable once both tests
+ * pass over at least CALIB_STABILITY_MIN_SPAN_MS:
+ * - the residual standard deviation is within the tolerance;
+ * - the drift the slope implies across the window is within the tolerance.
+ * The tolerance is set per probe type: max(absolute, relative * |mean|).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CALIB_STABILITY_SAMPLES         32
+#define CALIB_STABILITY_WINDOW_MS       15000
+#define CALIB_STABILITY_MIN_SPAN_MS     10000
+#define CALIB_STABILITY_MIN_SAMPLES     5
+
+typedef struct {
+    uint64_t t_ms[CALIB_STABILITY_SAMPLES];
+    float value[CALIB_STABILITY_SAMPLES];
+    uint8_t head;
+    uint8_t count;
+    float tolerance_abs;
+    float tolerance_rel;
+} calib_stability_t;
+
+typedef struct {
+    bool stable;
+    uint8_t samples;            // Samples inside the window
+    uint32_t span_ms;           // Time between the oldest and newest of them
+    float mean;
+    float stddev;               // Residual around the fitted line
+    float slope_per_min;
+    float tolerance;
+} calib_stability_result_t;
+
+/**
+ * @brief Reset a tracker with the tolerance for an EZO type
+ */
+void calib_stability_init(calib_stability_t *tracker, const char *sensor_type);
+
+/**
+ * @brief Add a sample and evaluate the window
+ *
+ * @param t_ms Sample time in milliseconds (monotonic)
+ */
+void calib_stability_add(calib_stability_t *tracker, uint64_t t_ms, float value,
+                         calib_stability_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
@@ -11,6 +11,9 @@
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "esp_mac.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "CLOUD_PROV";
@@ -26,24 +29,58 @@ static const char *TAG = "CLOUD_PROV";
 #define NVS_KEY_PRIVATE "device_key"
 #define NVS_KEY_CERT_ID "cert_id"
 #define NVS_KEY_MQTT_CA "mqtt_ca_cert"
+#define NVS_KEY_CA_CERT "ca_cert"
 
 // Callback
 static cloud_prov_callback_t s_callback = NULL;
 
-// Buffers for HTTP responses
-static char s_response_buffer[4096];
-static size_t s_response_len = 0;
+// Size of the buffer for the certificate-generation JSON reply
+#define CLOUD_PROV_JSON_RESPONSE_SIZE 1024
+
+/**
+ * @brief Destination of one HTTP response body, written as chunks arrive
+ */
+typedef struct {
+    char *buf;
+    size_t size;        // Capacity, including the terminator
+    size_t len;
+    bool overflow;      // Body was longer than size - 1; what fit is kept, the rest dropped
+} response_sink_t;
+
+// One keep-alive connection to the SSL manager serves a whole provisioning run
+static esp_http_client_handle_t s_ssl_client = NULL;
+
+// Credential cache: every stored PEM in one allocation, loaded on first use
+static const char *const k_cred_nvs_keys[CLOUD_PROV_CRED_COUNT] = {
+    [CLOUD_PROV_CRED_DEVICE_CERT] = NVS_KEY_CERT,
+    [CLOUD_PROV_CRED_PRIVATE_KEY] = NVS_KEY_PRIVATE,
+    [CLOUD_PROV_CRED_CA_CERT]     = NVS_KEY_CA_CERT,
+    [CLOUD_PROV_CRED_MQTT_CA]     = NVS_KEY_MQTT_CA,
+};
+static SemaphoreHandle_t s_cred_mutex = NULL;
+static char *s_cred_buf = NULL;
+static size_t s_cred_buf_size = 0;
+static const char *s_cred_pem[CLOUD_PROV_CRED_COUNT];
+static size_t s_cred_len[CLOUD_PROV_CRED_COUNT];
+static bool s_cred_loaded = false;
 
 /**
  * @brief HTTP event handler
  */
 static esp_err_t http_event_handler(esp_http_client_event_t *evt)
 {
+    response_sink_t *sink = (response_sink_t *)evt->user_data;
     switch (evt->event_id) {
         case HTTP_EVENT_ON_DATA:
-            if (s_response_len + evt->data_len < sizeof(s_response_buffer)) {
-                memcpy(s_response_buffer + s_response_len, evt->data, evt->data_len);
-                s_response_len += evt->data_len;
+            if (sink == NULL || sink->buf == NULL) {
+                break;
+            }
+            if (sink->len + evt->data_len < sink->size) {
+                memcpy(sink->buf + sink->len, evt->data, evt->data_len);
+                sink->len += evt->data_len;
+                sink->buf[sink->len] = '\0';
+            } else {
+                sink->overflow = true;
             }
             break;
         default:
@@ -52,6 +89,84 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt)
     return ESP_OK;
 }
 
+/**
+ * @brief Point the next response body at buf (size bytes, terminator included)
+ */
+static void response_sink_reset(response_sink_t *sink, char *buf, size_t size)
+{
+    sink->buf = buf;
+    sink->size = size;
+    sink->len = 0;
+    sink->overflow = false;
+    if (buf != NULL && size > 0) {
+        buf[0] = '\0';
+    }
+}
+
+/**
+ * @brief Run a request whose body is written straight into the sink
+ *
+ * @return esp_err_t Transport error, ESP_ERR_INVALID_SIZE if the body did not
+ *         fit, or ESP_OK; the HTTP status is returned separately
+ */
+static esp_err_t perform_into_sink(esp_http_client_handle_t client, response_sink_t *sink, int *status_code)
+{
+    esp_http_client_set_user_data(client, sink);
+    esp_err_t err = esp_http_client_perform(client);
+    *status_code = esp_http_client_get_status_code(client);
+    esp_http_client_set_user_data(client, NULL);
+    
+    if (err == ESP_OK && sink->overflow) {
+        ESP_LOGE(TAG, "Response larger than %zu bytes, rejected", sink->size - 1);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return err;
+}
+
+/**
+ * @brief Get the SSL manager client, reusing the open connection when there is one
+ *
+ * The TLS session is kept by the client, so when the server drops the
+ * keep-alive connection the next request resumes it instead of a full handshake.
+ */
+static esp_http_client_handle_t ssl_manager_client(const char *url, esp_http_client_method_t method)
+{
+    if (s_ssl_client != NULL) {
+        esp_http_client_set_url(s_ssl_client, url);
+        esp_http_client_set_method(s_ssl_client, method);
+        return s_ssl_client;
+    }
+    
+    esp_http_client_config_t config = {
+        .url = url,
+        .method = method,
+        .event_handler = http_event_handler,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .timeout_ms = 10000,
+        .keep_alive_enable = true,
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        .save_client_session = true,
+#endif
+    };
+    
+    s_ssl_client = esp_http_client_init(&config);
+    if (s_ssl_client != NULL) {
+        esp_http_client_set_header(s_ssl_client, "X-API-Key", CLOUD_PROV_API_KEY);
+    }
+    return s_ssl_client;
+}
+
+/**
+ * @brief Close the SSL manager connection (end of a run, or after an error)
+ */
+static void ssl_manager_client_close(void)
+{
+    if (s_ssl_client != NULL) {
+        esp_http_client_cleanup(s_ssl_client);
+        s_ssl_client = NULL;
+    }
+}
+
 /**
  * @brief Get MAC address as device ID
  */
@@ -67,6 +182,138 @@ esp_err_t cloud_prov_init(cloud_prov_callback_t callback)
 {
     ESP_LOGI(TAG, "Initializing cloud provisioning");
     s_callback = callback;
+    if (s_cred_mutex == NULL) {
+        s_cred_mutex = xSemaphoreCreateMutex();
+        if (s_cred_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Read every stored credential into a single buffer (caller holds s_cred_mutex)
+ */
+static esp_err_t cred_cache_load_locked(void)
+{
+    if (s_cred_loaded) {
+        return ESP_OK;
+    }
+    
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open_from_partition(NVS_PARTITION, NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    
+    // Size everything first so the credentials share one right-sized allocation
+    size_t sizes[CLOUD_PROV_CRED_COUNT] = {0};
+    size_t total = 0;
+    for (int i = 0; i < CLOUD_PROV_CRED_COUNT; i++) {
+        size_t required_size = 0;
+        if (nvs_get_str(nvs_handle, k_cred_nvs_keys[i], NULL, &required_size) == ESP_OK && required_size > 1) {
+            sizes[i] = required_size;
+            total += required_size;
+        }
+    }
+    if (total == 0) {
+        nvs_close(nvs_handle);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    char *buf = malloc(total);
+    if (buf == NULL) {
+        nvs_close(nvs_handle);
+        ESP_LOGE(TAG, "Failed to allocate %zu bytes for credential cache", total);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    size_t offset = 0;
+    for (int i = 0; i < CLOUD_PROV_CRED_COUNT; i++) {
+        s_cred_pem[i] = NULL;
+        s_cred_len[i] = 0;
+        if (sizes[i] == 0) {
+            continue;
+        }
+        size_t required_size = sizes[i];
+        if (nvs_get_str(nvs_handle, k_cred_nvs_keys[i], buf + offset, &required_size) == ESP_OK) {
+            s_cred_pem[i] = buf + offset;
+            s_cred_len[i] = strlen(buf + offset);
+        }
+        offset += sizes[i];
+    }
+    nvs_close(nvs_handle);
+    
+    s_cred_buf = buf;
+    s_cred_buf_size = total;
+    s_cred_loaded = true;
+    ESP_LOGI(TAG, "Credential cache loaded (%zu bytes)", total);
+    return ESP_OK;
+}
+
+esp_err_t cloud_prov_credential_get(cloud_prov_cred_t which, const char **pem_out, size_t *len_out)
+{
+    if (which >= CLOUD_PROV_CRED_COUNT || pem_out == NULL || len_out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_cred_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_cred_mutex, portMAX_DELAY);
+    esp_err_t err = cred_cache_load_locked();
+    if (err == ESP_OK && s_cred_pem[which] == NULL) {
+        err = ESP_ERR_NOT_FOUND;
+    }
+    if (err == ESP_OK) {
+        *pem_out = s_cred_pem[which];
+        *len_out = s_cred_len[which];
+    }
+    xSemaphoreGive(s_cred_mutex);
+    return err;
+}
+
+void cloud_prov_credentials_invalidate(void)
+{
+    if (s_cred_mutex == NULL) {
+        return;
+    }
+    
+    xSemaphoreTake(s_cred_mutex, portMAX_DELAY);
+    if (s_cred_buf != NULL) {
+        // Don't leave the private key behind in freed heap
+        memset(s_cred_buf, 0, s_cred_buf_size);
+        free(s_cred_buf);
+    }
+    s_cred_buf = NULL;
+    s_cred_buf_size = 0;
+    memset(s_cred_pem, 0, sizeof(s_cred_pem));
+    memset(s_cred_len, 0, sizeof(s_cred_len));
+    s_cred_loaded = false;
+    xSemaphoreGive(s_cred_mutex);
+}
+
+/**
+ * @brief Copy a cached credential into a caller buffer
+ */
+static esp_err_t copy_credential(cloud_prov_cred_t which, char *out, size_t out_size, size_t *len_out)
+{
+    if (out == NULL || len_out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    const char *pem = NULL;
+    size_t len = 0;
+    esp_err_t err = cloud_prov_credential_get(which, &pem, &len);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (len >= out_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    memcpy(out, pem, len + 1);
+    *len_out = len;
     return ESP_OK;
 }
 
@@ -108,52 +355,12 @@ bool cloud_prov_has_certificates(void)
 
 esp_err_t cloud_prov_get_certificate(char *cert_out, size_t *cert_len)
 {
-    if (cert_out == NULL || cert_len == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open_from_partition(NVS_PARTITION, NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
-    if (err != ESP_OK) {
-        return err;
-    }
-    
-    size_t required_size = CLOUD_PROV_MAX_CERT_SIZE;
-    err = nvs_get_str(nvs_handle, NVS_KEY_CERT, cert_out, &required_size);
-    nvs_close(nvs_handle);
-    
-    if (err == ESP_OK) {
-        // nvs_get_str returns size including null terminator
-        // Return the actual string length for PEM data
-        *cert_len = strlen(cert_out);
-    }
-    
-    return err;
+    return copy_credential(CLOUD_PROV_CRED_DEVICE_CERT, cert_out, CLOUD_PROV_MAX_CERT_SIZE, cert_len);
 }
 
 esp_err_t cloud_prov_get_private_key(char *key_out, size_t *key_len)
 {
-    if (key_out == NULL || key_len == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open_from_partition(NVS_PARTITION, NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
-    if (err != ESP_OK) {
-        return err;
-    }
-    
-    size_t required_size = CLOUD_PROV_MAX_KEY_SIZE;
-    err = nvs_get_str(nvs_handle, NVS_KEY_PRIVATE, key_out, &required_size);
-    nvs_close(nvs_handle);
-    
-    if (err == ESP_OK) {
-        // nvs_get_str returns size including null terminator
-        // Return the actual string length for PEM data
-        *key_len = strlen(key_out);
-    }
-    
-    return err;
+    return copy_credential(CLOUD_PROV_CRED_PRIVATE_KEY, key_out, CLOUD_PROV_MAX_KEY_SIZE, key_len);
 }
 
 esp_err_t cloud_prov_clear_certificates(void)
@@ -169,11 +376,13 @@ esp_err_t cloud_prov_clear_certificates(void)
     nvs_erase_key(nvs_handle, NVS_KEY_CERT);
     nvs_erase_key(nvs_handle, NVS_KEY_PRIVATE);
     nvs_erase_key(nvs_handle, NVS_KEY_CERT_ID);
+    nvs_erase_key(nvs_handle, NVS_KEY_CA_CERT);
     nvs_erase_key(nvs_handle, NVS_KEY_MQTT_CA);
     
     err = nvs_commit(nvs_handle);
     nvs_close(nvs_handle);
     
+    cloud_prov_credentials_invalidate();
     return err;
 }
 
@@ -209,50 +418,58 @@ esp_err_t cloud_prov_download_mqtt_ca_cert(void)
         return ESP_FAIL;
     }
     
-    // Reset response buffer
-    s_response_len = 0;
-    memset(s_response_buffer, 0, sizeof(s_response_buffer));
+    // The body is received straight into the buffer that goes to NVS
+    char *ca_cert = malloc(CLOUD_PROV_MAX_CERT_SIZE);
+    if (ca_cert == NULL) {
+        esp_http_client_cleanup(client);
+        return ESP_ERR_NO_MEM;
+    }
+    response_sink_t sink;
+    response_sink_reset(&sink, ca_cert, CLOUD_PROV_MAX_CERT_SIZE);
     
-    err = esp_http_client_perform(client);
-    int status_code = esp_http_client_get_status_code(client);
+    int status_code = 0;
+    err = perform_into_sink(client, &sink, &status_code);
     
     esp_http_client_cleanup(client);
     
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(err));
+        free(ca_cert);
         return err;
     }
     
     if (status_code != 200) {
         ESP_LOGE(TAG, "Server returned status: %d", status_code);
+        free(ca_cert);
         return ESP_FAIL;
     }
     
-    if (s_response_len == 0 || s_response_len >= CLOUD_PROV_MAX_CERT_SIZE) {
-        ESP_LOGE(TAG, "Invalid certificate size: %zu bytes", s_response_len);
+    if (sink.len == 0) {
+        ESP_LOGE(TAG, "Empty CA certificate response");
+        free(ca_cert);
         return ESP_FAIL;
     }
     
-    // Null-terminate the certificate
-    s_response_buffer[s_response_len] = '\0';
-    
-    ESP_LOGI(TAG, "Downloaded MQTT CA certificate (%zu bytes)", s_response_len);
+    ESP_LOGI(TAG, "Downloaded MQTT CA certificate (%zu bytes)", sink.len);
     
     // Store in NVS
     err = nvs_open_from_partition(NVS_PARTITION, NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to open NVS partition: %s", esp_err_to_name(err));
+        free(ca_cert);
         return err;
     }
     
-    err = nvs_set_str(nvs_handle, NVS_KEY_MQTT_CA, s_response_buffer);
+    err = nvs_set_str(nvs_handle, NVS_KEY_MQTT_CA, ca_cert);
     if (err == ESP_OK) {
         err = nvs_commit(nvs_handle);
     }
     
     nvs_close(nvs_handle);
+    free(ca_cert);
     
     if (err == ESP_OK) {
+        cloud_prov_credentials_invalidate();
         ESP_LOGI(TAG, "MQTT CA certificate stored successfully");
     } else {
         ESP_LOGE(TAG, "Failed to store MQTT CA certificate: %s", esp_err_to_name(err));
@@ -263,25 +480,7 @@ esp_err_t cloud_prov_download_mqtt_ca_cert(void)
 
 esp_err_t cloud_prov_get_mqtt_ca_cert(char *cert_out, size_t *cert_len)
 {
-    if (cert_out == NULL || cert_len == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open_from_partition(NVS_PARTITION, NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
-    if (err != ESP_OK) {
-        return err;
-    }
-    
-    size_t required_size = CLOUD_PROV_MAX_CERT_SIZE;
-    err = nvs_get_str(nvs_handle, NVS_KEY_MQTT_CA, cert_out, &required_size);
-    nvs_close(nvs_handle);
-    
-    if (err == ESP_OK) {
-        *cert_len = strlen(cert_out);
-    }
-    
-    return err;
+    return copy_credential(CLOUD_PROV_CRED_MQTT_CA, cert_out, CLOUD_PROV_MAX_CERT_SIZE, cert_len);
 }
 
 /**
@@ -302,50 +501,49 @@ static esp_err_t request_certificate_generation(char *cert_id_out, size_t cert_i
              "email=devices@kannacloud.com&san=kc.local,DNS:*.local,IP:192.168.1.0/24");
     
     // Configure HTTP client
-    esp_http_client_config_t config = {
-        .url = CLOUD_PROV_SSL_MANAGER_URL "/create",
-        .method = HTTP_METHOD_POST,
-        .event_handler = http_event_handler,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .timeout_ms = 10000,
-    };
-    
-    esp_http_client_handle_t client = esp_http_client_init(&config);
+    esp_http_client_handle_t client = ssl_manager_client(CLOUD_PROV_SSL_MANAGER_URL "/create", HTTP_METHOD_POST);
     if (client == NULL) {
         ESP_LOGE(TAG, "Failed to initialize HTTP client");
         return ESP_FAIL;
     }
     
     // Set headers
-    esp_http_client_set_header(client, "X-API-Key", CLOUD_PROV_API_KEY);
     esp_http_client_set_header(client, "Accept", "application/json");
     esp_http_client_set_header(client, "Content-Type", "application/x-www-form-urlencoded");
     esp_http_client_set_post_field(client, post_data, strlen(post_data));
     
-    // Reset response buffer
-    s_response_len = 0;
-    memset(s_response_buffer, 0, sizeof(s_response_buffer));
+    char *response = malloc(CLOUD_PROV_JSON_RESPONSE_SIZE);
+    if (response == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    response_sink_t sink;
+    response_sink_reset(&sink, response, CLOUD_PROV_JSON_RESPONSE_SIZE);
     
     // Perform request
-    esp_err_t err = esp_http_client_perform(client);
-    int status_code = esp_http_client_get_status_code(client);
+    int status_code = 0;
+    esp_err_t err = perform_into_sink(client, &sink, &status_code);
     
-    esp_http_client_cleanup(client);
+    // Downloads that follow are plain GETs on the same connection
+    esp_http_client_set_post_field(client, NULL, 0);
+    esp_http_client_delete_header(client, "Content-Type");
     
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(err));
+        ssl_manager_client_close();
+        free(response);
         return err;
     }
     
     if (status_code != 200) {
         ESP_LOGE(TAG, "Server returned status: %d", status_code);
-        ESP_LOGE(TAG, "Response: %.*s", (int)s_response_len, s_response_buffer);
+        ESP_LOGE(TAG, "Response: %.*s", (int)sink.len, response);
+        free(response);
         return ESP_FAIL;
     }
     
     // Parse JSON response
-    s_response_buffer[s_response_len] = '\0';
-    cJSON *json = cJSON_Parse(s_response_buffer);
+    cJSON *json = cJSON_ParseWithLength(response, sink.len);
+    free(response);
     if (json == NULL) {
         ESP_LOGE(TAG, "Failed to parse JSON response");
         return ESP_FAIL;
@@ -378,56 +576,41 @@ static esp_err_t download_file(const char *cert_id, const char *file_type, char
     
     ESP_LOGI(TAG, "Downloading %s from: %s", file_type, url);
     
-    esp_http_client_config_t config = {
-        .url = url,
-        .method = HTTP_METHOD_GET,
-        .event_handler = http_event_handler,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .timeout_ms = 10000,
-    };
-    
-    esp_http_client_handle_t client = esp_http_client_init(&config);
+    esp_http_client_handle_t client = ssl_manager_client(url, HTTP_METHOD_GET);
     if (client == NULL) {
         return ESP_FAIL;
     }
     
-    esp_http_client_set_header(client, "X-API-Key", CLOUD_PROV_API_KEY);
-    
-    // Reset response buffer
-    s_response_len = 0;
-    memset(s_response_buffer, 0, sizeof(s_response_buffer));
+    // Chunks land directly in the caller's buffer, which is what gets stored
+    response_sink_t sink;
+    response_sink_reset(&sink, output, output_size);
     
-    esp_err_t err = esp_http_client_perform(client);
-    int status_code = esp_http_client_get_status_code(client);
+    int status_code = 0;
+    esp_err_t err = perform_into_sink(client, &sink, &status_code);
     
-    ESP_LOGI(TAG, "Download response - Status: %d, Length: %zu bytes", status_code, s_response_len);
+    ESP_LOGI(TAG, "Download response - Status: %d, Length: %zu bytes", status_code, sink.len);
     
-    // Log first 200 chars of response for debugging
-    if (s_response_len > 0) {
-        char preview[201];
-        size_t preview_len = s_response_len < 200 ? s_response_len : 200;
-        memcpy(preview, s_response_buffer, preview_len);
-        preview[preview_len] = '\0';
-        ESP_LOGI(TAG, "Response preview: %.200s", preview);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_SIZE) {
+        // Start the next request on a fresh connection
+        ssl_manager_client_close();
     }
     
-    esp_http_client_cleanup(client);
+    if (err == ESP_ERR_INVALID_SIZE) {
+        ESP_LOGE(TAG, "Downloaded %s too large (limit %zu bytes)", file_type, output_size - 1);
+        return ESP_ERR_NO_MEM;
+    }
     
     if (err != ESP_OK || status_code != 200) {
+        // Only error bodies are previewed: a successful one may be the private key
+        if (sink.len > 0) {
+            ESP_LOGI(TAG, "Response preview: %.200s", output);
+        }
         ESP_LOGE(TAG, "Failed to download %s: %s (status: %d)",
                  file_type, esp_err_to_name(err), status_code);
         return ESP_FAIL;
     }
     
-    if (s_response_len >= output_size) {
-        ESP_LOGE(TAG, "Downloaded %s too large (%zu bytes)", file_type, s_response_len);
-        return ESP_ERR_NO_MEM;
-    }
-    
-    memcpy(output, s_response_buffer, s_response_len);
-    output[s_response_len] = '\0';
-    
-    ESP_LOGI(TAG, "Downloaded %s (%zu bytes)", file_type, s_response_len);
+    ESP_LOGI(TAG, "Downloaded %s (%zu bytes)", file_type, sink.len);
     
     return ESP_OK;
 }
@@ -452,6 +635,7 @@ esp_err_t cloud_prov_provision_device(void)
     esp_err_t err = request_certificate_generation(cert_id, sizeof(cert_id));
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to generate certificate");
+        ssl_manager_client_close();
         if (s_callback) {
             s_callback(false, "Certificate generation failed");
         }
@@ -462,12 +646,14 @@ esp_err_t cloud_prov_provision_device(void)
     char *private_key = malloc(CLOUD_PROV_MAX_KEY_SIZE);
     if (private_key == NULL) {
         ESP_LOGE(TAG, "Failed to allocate memory for private key");
+        ssl_manager_client_close();
         return ESP_ERR_NO_MEM;
     }
     
     err = download_file(cert_id, "key", private_key, CLOUD_PROV_MAX_KEY_SIZE);
     if (err != ESP_OK) {
         free(private_key);
+        ssl_manager_client_close();
         if (s_callback) {
             s_callback(false, "Private key download failed");
         }
@@ -479,6 +665,7 @@ esp_err_t cloud_prov_provision_device(void)
     if (certificate == NULL) {
         free(private_key);
         ESP_LOGE(TAG, "Failed to allocate memory for certificate");
+        ssl_manager_client_close();
         return ESP_ERR_NO_MEM;
     }
     
@@ -486,6 +673,7 @@ esp_err_t cloud_prov_provision_device(void)
     if (err != ESP_OK) {
         free(private_key);
         free(certificate);
+        ssl_manager_client_close();
         if (s_callback) {
             s_callback(false, "Certificate download failed");
         }
@@ -498,10 +686,12 @@ esp_err_t cloud_prov_provision_device(void)
         free(private_key);
         free(certificate);
         ESP_LOGE(TAG, "Failed to allocate memory for CA certificate");
+        ssl_manager_client_close();
         return ESP_ERR_NO_MEM;
     }
     
     err = download_file(cert_id, "ca", ca_certificate, CLOUD_PROV_MAX_CERT_SIZE);
+    ssl_manager_client_close();
     if (err != ESP_OK) {
         ESP_LOGW(TAG, "CA certificate download failed (optional): %s", esp_err_to_name(err));
         // CA cert is optional, don't fail provisioning
@@ -562,7 +752,7 @@ esp_err_t cloud_prov_provision_device(void)
     
     // Store CA certificate if available
     if (ca_certificate != NULL) {
-        err = nvs_set_str(nvs_handle, "ca_cert", ca_certificate);
+        err = nvs_set_str(nvs_handle, NVS_KEY_CA_CERT, ca_certificate);
         if (err != ESP_OK) {
             ESP_LOGW(TAG, "Failed to store CA certificate: %s", esp_err_to_name(err));
             // Don't fail provisioning if CA cert storage fails
@@ -580,6 +770,7 @@ esp_err_t cloud_prov_provision_device(void)
     if (ca_certificate) free(ca_certificate);
     
     if (err == ESP_OK) {
+        cloud_prov_credentials_invalidate();
         ESP_LOGI(TAG, "===========================================");
         ESP_LOGI(TAG, "✓ Device provisioning completed successfully!");
         ESP_LOGI(TAG, "===========================================");
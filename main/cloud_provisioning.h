@@ -13,6 +13,7 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,6 +27,17 @@ extern "C" {
 #define CLOUD_PROV_MAX_CERT_SIZE (4096)
 #define CLOUD_PROV_MAX_KEY_SIZE (4096)
 
+/**
+ * @brief Credentials held in the RAM credential cache
+ */
+typedef enum {
+    CLOUD_PROV_CRED_DEVICE_CERT,    // HTTPS server certificate
+    CLOUD_PROV_CRED_PRIVATE_KEY,    // HTTPS server private key
+    CLOUD_PROV_CRED_CA_CERT,        // CA that issued the device certificate (served at /ca.crt)
+    CLOUD_PROV_CRED_MQTT_CA,        // CA the MQTT broker certificate is verified against
+    CLOUD_PROV_CRED_COUNT
+} cloud_prov_cred_t;
+
 /**
  * @brief Provisioning status callback
  * 
@@ -99,6 +111,27 @@ esp_err_t cloud_prov_get_device_id(char *id_out, size_t id_len);
  */
 esp_err_t cloud_prov_clear_certificates(void);
 
+/**
+ * @brief Get a read-only view of a cached credential
+ * 
+ * The first call reads every stored credential from NVS into one allocation;
+ * later calls return pointers into it without touching flash. The PEM is
+ * null-terminated. A view stays valid until the cache is invalidated by
+ * cloud_prov_clear_certificates() or by newly stored credentials, so a
+ * holder that keeps it (the MQTT client) must be torn down before that.
+ * 
+ * @param which Credential to look up
+ * @param pem_out Receives a pointer to the PEM text
+ * @param len_out Receives the PEM length, excluding the terminator
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if that credential is not stored
+ */
+esp_err_t cloud_prov_credential_get(cloud_prov_cred_t which, const char **pem_out, size_t *len_out);
+
+/**
+ * @brief Drop the credential cache so the next lookup reloads it from NVS
+ */
+void cloud_prov_credentials_invalidate(void);
+
 /**
  * @brief Download MQTT CA certificate from server
  * 
@@ -0,0 +1,421 @@
+/**
+ * @file data_bench.c
+ * @brief On-device micro-benchmark of the sensor data path
+ */
+
+#include "data_bench.h"
+#include "ezo_sensor.h"
+#include "signal_filter.h"
+#include "mqtt_telemetry.h"
+#include "telemetry_codec.h"
+#include "sensor_manager.h"
+#include "mem_monitor.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdatomic.h>
+#include <string.h>
+
+static const char *TAG = "DATA_BENCH";
+
+#define NVS_NAMESPACE       "data_bench"
+#define NVS_KEY_BASELINE    "baseline"
+#define DATA_BENCH_ROUNDS   3       // Best of, to shed preemption by other tasks
+#define DATA_BENCH_SCRATCH_SLOT (SIGNAL_FILTER_MAX_SENSORS - 1)
+#define DATA_BENCH_DEADBAND 0.5f    // Larger than any fixture step, so every channel is compared
+
+#ifndef CONFIG_KC_DATA_BENCH_THRESHOLD_PCT
+#define CONFIG_KC_DATA_BENCH_THRESHOLD_PCT 20
+#endif
+
+static const char *const k_stage_names[DATA_BENCH_STAGE_COUNT] = {
+    "ezo_parse", "filter", "deadband", "sensors_json", "cbor", "pack", "unpack",
+};
+
+// One response per board type, as the boards send them
+typedef struct {
+    const char *type;
+    const char *response;
+} data_bench_fixture_t;
+
+static const data_bench_fixture_t k_fixtures[] = {
+    { EZO_TYPE_PH,  "7.012" },
+    { EZO_TYPE_EC,  "1413,707,0.00,1.000" },
+    { EZO_TYPE_DO,  "8.32,91.2" },
+    { EZO_TYPE_RTD, "25.104" },
+    { EZO_TYPE_ORP, "412.3" },
+    { EZO_TYPE_HUM, "45.21,23.10,Dew,11.42" },
+};
+
+#define DATA_BENCH_FIXTURES (sizeof(k_fixtures) / sizeof(k_fixtures[0]))
+
+typedef struct {
+    uint8_t version;
+    uint8_t stage_count;
+    uint8_t reserved[2];
+    uint32_t ns_per_op[DATA_BENCH_STAGE_COUNT];
+} data_bench_baseline_t;
+
+#define DATA_BENCH_BASELINE_VERSION 1
+
+static SemaphoreHandle_t s_mutex = NULL;
+static atomic_bool s_running = false;
+static data_bench_baseline_t s_baseline;        // Guarded by s_mutex
+static bool s_baseline_valid = false;
+static data_bench_report_t s_last;
+
+// Working set of a run, only touched by the running task
+static sensor_cache_t s_cache;
+static sensor_cache_t s_previous;
+static sensor_cache_t s_unpacked;
+static mqtt_deadband_t s_deadbands[DATA_BENCH_FIXTURES + 1];
+static char s_json[2048];
+static uint8_t s_cbor[TELEMETRY_CBOR_MAX_SIZE];
+static uint8_t s_packed[TELEMETRY_PACKED_MAX_SIZE];
+static size_t s_packed_len = 0;
+static volatile uint32_t s_sink;                // Keeps results observable to the optimizer
+
+
+static void data_bench_build_fixtures(void) {
+    memset(&s_cache, 0, sizeof(s_cache));
+    for (uint8_t i = 0; i < DATA_BENCH_FIXTURES; i++) {
+        cached_sensor_t *sensor = &s_cache.sensors[i];
+        strncpy(sensor->sensor_type, k_fixtures[i].type, sizeof(sensor->sensor_type) - 1);
+        ezo_parse_reading(k_fixtures[i].response, strlen(k_fixtures[i].response),
+                          sensor->raw_values, &sensor->value_count, NULL);
+        memcpy(sensor->values, sensor->raw_values, sizeof(sensor->values));
+        sensor->valid = true;
+        sensor->quality = SENSOR_QUALITY_GOOD;
+        sensor->timestamp_us = 1000000ULL * (i + 1);
+        sensor->address = 0x60 + i;
+        telemetry_sensor_set_kind(sensor);
+
+        strncpy(s_deadbands[i].sensor_type, k_fixtures[i].type, sizeof(s_deadbands[i].sensor_type) - 1);
+        s_deadbands[i].value_index = MQTT_DEADBAND_ALL_VALUES;
+        s_deadbands[i].threshold = DATA_BENCH_DEADBAND;
+    }
+    s_cache.sensor_count = DATA_BENCH_FIXTURES;
+    s_cache.battery_percentage = 87.5f;
+    s_cache.battery_valid = true;
+    s_cache.rssi = -61;
+    s_cache.timestamp_us = 1000000ULL * DATA_BENCH_FIXTURES;
+
+    strcpy(s_deadbands[DATA_BENCH_FIXTURES].sensor_type, "battery");
+    s_deadbands[DATA_BENCH_FIXTURES].value_index = 0;
+    s_deadbands[DATA_BENCH_FIXTURES].threshold = 1.0f;
+
+    // The previous snapshot differs by less than every deadband: the worst case, a full scan
+    s_previous = s_cache;
+    for (uint8_t i = 0; i < DATA_BENCH_FIXTURES; i++) {
+        for (uint8_t v = 0; v < s_previous.sensors[i].value_count; v++) {
+            s_previous.sensors[i].values[v] += DATA_BENCH_DEADBAND / 4.0f;
+        }
+    }
+}
+
+static void data_bench_ezo_parse(uint32_t n) {
+    float values[4];
+    uint8_t count = 0;
+    for (uint32_t k = 0; k < n; k++) {
+        const data_bench_fixture_t *f = &k_fixtures[k % DATA_BENCH_FIXTURES];
+        ezo_parse_reading(f->response, strlen(f->response), values, &count, NULL);
+        s_sink += count;
+    }
+}
+
+static void data_bench_filter(uint32_t n) {
+    float filtered[MAX_SENSOR_VALUES];
+    uint32_t per_type = n / DATA_BENCH_FIXTURES;
+    for (uint8_t i = 0; i < DATA_BENCH_FIXTURES; i++) {
+        const cached_sensor_t *sensor = &s_cache.sensors[i];
+        float raw[MAX_SENSOR_VALUES];
+        signal_filter_reset_slot(DATA_BENCH_SCRATCH_SLOT);
+        for (uint32_t k = 0; k < per_type + (i < n % DATA_BENCH_FIXTURES ? 1 : 0); k++) {
+            // Small deterministic noise keeps the window and spike test doing real work
+            for (uint8_t v = 0; v < sensor->value_count; v++) {
+                raw[v] = sensor->raw_values[v] + (float)(k & 7) * 0.001f;
+            }
+            s_sink += signal_filter_apply(DATA_BENCH_SCRATCH_SLOT, sensor->sensor_type, raw, filtered,
+                                          sensor->value_count);
+        }
+    }
+    signal_filter_reset_slot(DATA_BENCH_SCRATCH_SLOT);
+}
+
+static void data_bench_deadband(uint32_t n) {
+    for (uint32_t k = 0; k < n; k++) {
+        s_sink += mqtt_deadband_changed(s_deadbands, DATA_BENCH_FIXTURES + 1, &s_previous, &s_cache);
+    }
+}
+
+static void data_bench_sensors_json(uint32_t n) {
+    json_writer_t w;
+    for (uint32_t k = 0; k < n; k++) {
+        json_writer_init(&w, s_json, sizeof(s_json), NULL, NULL);
+        json_writer_object_begin(&w);
+        json_writer_key(&w, "sensors");
+        telemetry_write_sensors_json(&w, &s_cache);
+        json_writer_kv_float(&w, "battery", s_cache.battery_percentage);
+        json_writer_kv_int(&w, "rssi", s_cache.rssi);
+        json_writer_object_end(&w);
+        s_sink += (json_writer_finish(&w) == ESP_OK) ? (uint32_t)w.len : 0;
+    }
+}
+
+static void data_bench_cbor(uint32_t n) {
+    size_t len = 0;
+    for (uint32_t k = 0; k < n; k++) {
+        telemetry_encode_cbor("bench", &s_cache, 1700000000u + k, s_cbor, sizeof(s_cbor), &len);
+        s_sink += len;
+    }
+}
+
+static void data_bench_pack(uint32_t n) {
+    for (uint32_t k = 0; k < n; k++) {
+        telemetry_pack_snapshot(&s_cache, 1700000000u + k, s_packed, sizeof(s_packed), &s_packed_len);
+        s_sink += s_packed_len;
+    }
+}
+
+static void data_bench_unpack(uint32_t n) {
+    uint32_t unix_time = 0;
+    for (uint32_t k = 0; k < n; k++) {
+        telemetry_unpack_snapshot(s_packed, s_packed_len, &s_unpacked, &unix_time);
+        s_sink += s_unpacked.sensor_count;
+    }
+}
+
+typedef void (*data_bench_fn_t)(uint32_t n);
+
+static const data_bench_fn_t k_stage_fns[DATA_BENCH_STAGE_COUNT] = {
+    data_bench_ezo_parse, data_bench_filter, data_bench_deadband, data_bench_sensors_json,
+    data_bench_cbor, data_bench_pack, data_bench_unpack,
+};
+
+/**
+ * @brief The filter stage owns a scratch slot, so only run it while the reading task is parked
+ */
+static bool data_bench_filter_available(void) {
+    return sensor_manager_is_reading_paused() && !sensor_manager_is_reading_in_progress() &&
+           sensor_manager_get_ezo_count() <= DATA_BENCH_SCRATCH_SLOT;
+}
+
+static void data_bench_run_stage(data_bench_stage_t stage, uint32_t n, data_bench_result_t *result) {
+    int64_t best_us = INT64_MAX;
+    int64_t allocs = 0;
+    for (int round = 0; round < DATA_BENCH_ROUNDS; round++) {
+        int64_t allocs_before = mem_monitor_task_alloc_count();
+        int64_t start = esp_timer_get_time();
+        k_stage_fns[stage](n);
+        int64_t elapsed = esp_timer_get_time() - start;
+        if (elapsed < best_us) {
+            best_us = elapsed;
+        }
+        allocs = (allocs_before < 0) ? -1 : mem_monitor_task_alloc_count() - allocs_before;
+    }
+
+    result->ran = true;
+    result->ns_per_op = (uint32_t)((best_us * 1000) / n);
+    result->allocs_per_op = (allocs < 0) ? -1.0f : (float)allocs / (float)n;
+}
+
+esp_err_t data_bench_init(void) {
+    if (s_mutex == NULL) {
+        s_mutex = xSemaphoreCreateMutex();
+        if (s_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
+        size_t size = sizeof(s_baseline);
+        if (nvs_get_blob(nvs_handle, NVS_KEY_BASELINE, &s_baseline, &size) == ESP_OK &&
+            size == sizeof(s_baseline) && s_baseline.version == DATA_BENCH_BASELINE_VERSION &&
+            s_baseline.stage_count == DATA_BENCH_STAGE_COUNT) {
+            s_baseline_valid = true;
+        }
+        nvs_close(nvs_handle);
+    }
+    ESP_LOGI(TAG, "Baseline %s", s_baseline_valid ? "loaded" : "not set");
+    return ESP_OK;
+}
+
+esp_err_t data_bench_run(uint32_t iterations, data_bench_report_t *report) {
+    if (s_mutex == NULL || report == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    bool idle = false;
+    if (!atomic_compare_exchange_strong(&s_running, &idle, true)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (iterations == 0) {
+        iterations = DATA_BENCH_DEFAULT_ITERATIONS;
+    } else if (iterations > DATA_BENCH_MAX_ITERATIONS) {
+        iterations = DATA_BENCH_MAX_ITERATIONS;
+    }
+
+    memset(report, 0, sizeof(*report));
+    report->iterations = iterations;
+    report->threshold_pct = CONFIG_KC_DATA_BENCH_THRESHOLD_PCT;
+
+    int64_t start = esp_timer_get_time();
+    data_bench_build_fixtures();
+    // Unpack reads the record written by pack, so stages run in enum order
+    bool filter_ok = data_bench_filter_available();
+    for (int stage = 0; stage < DATA_BENCH_STAGE_COUNT; stage++) {
+        if (stage == DATA_BENCH_FILTER && !filter_ok) {
+            continue;
+        }
+        data_bench_run_stage((data_bench_stage_t)stage, iterations, &report->stages[stage]);
+    }
+    report->duration_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    report->baseline_valid = s_baseline_valid;
+    report->passed = true;
+    for (int stage = 0; stage < DATA_BENCH_STAGE_COUNT; stage++) {
+        data_bench_result_t *result = &report->stages[stage];
+        if (!s_baseline_valid || !result->ran) {
+            continue;
+        }
+        result->baseline_ns = s_baseline.ns_per_op[stage];
+        uint64_t limit = (uint64_t)result->baseline_ns * (100 + report->threshold_pct) / 100;
+        result->regressed = result->baseline_ns > 0 && result->ns_per_op > limit;
+        if (result->regressed) {
+            report->passed = false;
+        }
+    }
+    report->valid = true;
+    s_last = *report;
+    xSemaphoreGive(s_mutex);
+    atomic_store(&s_running, false);
+
+    for (int stage = 0; stage < DATA_BENCH_STAGE_COUNT; stage++) {
+        const data_bench_result_t *result = &report->stages[stage];
+        if (!result->ran) {
+            ESP_LOGI(TAG, "%-13s skipped", k_stage_names[stage]);
+            continue;
+        }
+        ESP_LOGI(TAG, "%-13s %8lu ns/op %6.2f allocs/op%s", k_stage_names[stage],
+                 (unsigned long)result->ns_per_op, result->allocs_per_op,
+                 result->regressed ? "  REGRESSED" : "");
+    }
+    if (!report->passed) {
+        ESP_LOGW(TAG, "Regression beyond %u%% of the baseline", report->threshold_pct);
+    }
+    return ESP_OK;
+}
+
+esp_err_t data_bench_get_last(data_bench_report_t *report) {
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool valid = s_last.valid;
+    if (valid) {
+        *report = s_last;
+    }
+    xSemaphoreGive(s_mutex);
+    return valid ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t data_bench_save_baseline(const data_bench_report_t *report) {
+    if (s_mutex == NULL || report == NULL || !report->valid) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    data_bench_baseline_t baseline = {
+        .version = DATA_BENCH_BASELINE_VERSION,
+        .stage_count = DATA_BENCH_STAGE_COUNT,
+    };
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    for (int stage = 0; stage < DATA_BENCH_STAGE_COUNT; stage++) {
+        // A skipped stage keeps its previous baseline
+        baseline.ns_per_op[stage] = report->stages[stage].ran ? report->stages[stage].ns_per_op :
+                                    (s_baseline_valid ? s_baseline.ns_per_op[stage] : 0);
+    }
+    xSemaphoreGive(s_mutex);
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(nvs_handle, NVS_KEY_BASELINE, &baseline, sizeof(baseline));
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs_handle);
+        }
+        nvs_close(nvs_handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save baseline: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_baseline = baseline;
+    s_baseline_valid = true;
+    xSemaphoreGive(s_mutex);
+    ESP_LOGI(TAG, "Baseline saved");
+    return ESP_OK;
+}
+
+esp_err_t data_bench_clear_baseline(void) {
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err == ESP_OK) {
+        err = nvs_erase_key(nvs_handle, NVS_KEY_BASELINE);
+        if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND) {
+            err = nvs_commit(nvs_handle);
+        }
+        nvs_close(nvs_handle);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_baseline_valid = false;
+    xSemaphoreGive(s_mutex);
+    return ESP_OK;
+}
+
+const char *data_bench_stage_name(data_bench_stage_t stage) {
+    return (stage < DATA_BENCH_STAGE_COUNT) ? k_stage_names[stage] : "unknown";
+}
+
+void data_bench_write_json(json_writer_t *w, const data_bench_report_t *report) {
+    json_writer_object_begin(w);
+    json_writer_kv_int(w, "iterations", report->iterations);
+    json_writer_kv_int(w, "duration_ms", report->duration_ms);
+    json_writer_kv_int(w, "threshold_pct", report->threshold_pct);
+    json_writer_kv_bool(w, "baseline", report->baseline_valid);
+    json_writer_kv_bool(w, "passed", report->passed);
+    json_writer_key(w, "stages");
+    json_writer_object_begin(w);
+    for (int stage = 0; stage < DATA_BENCH_STAGE_COUNT; stage++) {
+        const data_bench_result_t *result = &report->stages[stage];
+        json_writer_key(w, k_stage_names[stage]);
+        if (!result->ran) {
+            json_writer_null(w);
+            continue;
+        }
+        json_writer_object_begin(w);
+        json_writer_kv_int(w, "ns_per_op", result->ns_per_op);
+        if (result->allocs_per_op >= 0.0f) {
+            json_writer_kv_float(w, "allocs_per_op", result->allocs_per_op);
+        }
+        if (result->baseline_ns > 0) {
+            json_writer_kv_int(w, "baseline_ns", result->baseline_ns);
+            json_writer_kv_bool(w, "regressed", result->regressed);
+        }
+        json_writer_object_end(w);
+    }
+    json_writer_object_end(w);
+    json_writer_object_end(w);
+}
@@ -0,0 +1,106 @@
+/**
+ * @file data_bench.h
+ * @brief On-device micro-benchmark of the sensor data path
+ *
+ * Runs the allocation-sensitive stages between an EZO response and a
+ * published payload on fixed fixtures: reading parse, signal conditioning,
+ * deadband comparison, JSON and CBOR serialization and the packed record
+ * used by the log and batches. Each stage is timed over many iterations and
+ * reported in ns/op and heap allocations/op. The fixtures never touch the
+ * bus, so results only move when the code (or its build flags) does.
+ *
+ * A run can be saved as baseline in NVS; later runs are compared against it
+ * and fail when any stage is slower by more than CONFIG_KC_DATA_BENCH_THRESHOLD_PCT.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DATA_BENCH_DEFAULT_ITERATIONS   500
+#define DATA_BENCH_MAX_ITERATIONS       20000
+
+typedef enum {
+    DATA_BENCH_EZO_PARSE = 0,   // ezo_parse_reading over one response of each board type
+    DATA_BENCH_FILTER,          // signal_filter_apply on a scratch slot, one sample of each type
+    DATA_BENCH_DEADBAND,        // mqtt_deadband_changed against a fixed table
+    DATA_BENCH_SENSORS_JSON,    // telemetry_write_sensors_json, MQTT data and HTTP sensor payload
+    DATA_BENCH_CBOR,            // telemetry_encode_cbor
+    DATA_BENCH_PACK,            // telemetry_pack_snapshot
+    DATA_BENCH_UNPACK,          // telemetry_unpack_snapshot
+    DATA_BENCH_STAGE_COUNT
+} data_bench_stage_t;
+
+typedef struct {
+    bool ran;                   // false when the stage was skipped (see data_bench_run)
+    uint32_t ns_per_op;
+    float allocs_per_op;        // Negative when allocations are not counted in this build
+    uint32_t baseline_ns;       // 0 without a baseline for the stage
+    bool regressed;             // Slower than the baseline beyond the threshold
+} data_bench_result_t;
+
+typedef struct {
+    bool valid;                 // A run has completed
+    uint32_t iterations;
+    uint32_t duration_ms;
+    uint8_t threshold_pct;
+    bool baseline_valid;
+    bool passed;                // No stage regressed
+    data_bench_result_t stages[DATA_BENCH_STAGE_COUNT];
+} data_bench_report_t;
+
+/**
+ * @brief Load the saved baseline from NVS
+ */
+esp_err_t data_bench_init(void);
+
+/**
+ * @brief Run every stage and compare it to the baseline
+ *
+ * Blocks for the duration of the run. The filter stage needs the reading task
+ * out of the way: it is skipped unless sensor reading is paused and idle, and
+ * when no sensor slot is free.
+ *
+ * @param iterations Operations per stage, 0 for DATA_BENCH_DEFAULT_ITERATIONS
+ * @param report Output report, also kept as the last report
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE while another run is in progress
+ */
+esp_err_t data_bench_run(uint32_t iterations, data_bench_report_t *report);
+
+/**
+ * @brief Copy the last report
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND before the first run
+ */
+esp_err_t data_bench_get_last(data_bench_report_t *report);
+
+/**
+ * @brief Save the timings of a report as the new baseline
+ */
+esp_err_t data_bench_save_baseline(const data_bench_report_t *report);
+
+/**
+ * @brief Forget the saved baseline
+ */
+esp_err_t data_bench_clear_baseline(void);
+
+/**
+ * @brief Stage name used in JSON and logs
+ */
+const char *data_bench_stage_name(data_bench_stage_t stage);
+
+/**
+ * @brief Write a report as a JSON object
+ */
+void data_bench_write_json(json_writer_t *w, const data_bench_report_t *report);
+
+#ifdef __cplusplus
+}
+#endif
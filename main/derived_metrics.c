@@ -0,0 +1,183 @@
+/**
+ * @file derived_metrics.c
+ * @brief Metrics computed on the device from the conditioned sensor values
+ */
+
+#include "derived_metrics.h"
+#include "ezo_sensor.h"
+#include <math.h>
+#include <string.h>
+
+#define DERIVED_MAX_INPUTS 2
+
+_Static_assert(DERIVED_METRIC_COUNT <= MAX_DERIVED_VALUES, "derived metrics exceed sensor_cache_t.derived");
+
+typedef struct {
+    uint8_t kind;               // ezo_sensor_kind_t of the board
+    uint8_t channel;            // Channel in the kind's descriptor
+} derived_input_t;
+
+// Channels in the descriptor order of ezo_sensor.c
+#define DERIVED_CH_HUMIDITY     0
+#define DERIVED_CH_AIR_TEMP     1
+#define DERIVED_CH_DEW_POINT    2
+#define DERIVED_CH_CONDUCTIVITY 0
+#define DERIVED_CH_DO           0
+#define DERIVED_CH_DO_SAT       1
+#define DERIVED_CH_TEMPERATURE  0
+
+typedef struct {
+    const char *name;
+    const char *unit;
+    derived_input_t inputs[DERIVED_MAX_INPUTS];
+    uint8_t input_count;
+    derived_input_t replaces;   // Skipped while a board reports this output (kind UNKNOWN: never)
+    bool board_normalized;      // First input is already at 25 °C when the board applied RTD compensation
+    float (*formula)(const float *in);
+} derived_metric_def_t;
+
+// Saturation vapour pressure over water, kPa (Tetens)
+static float derived_svp_kpa(float temp_c) {
+    return 0.61078f * expf(17.27f * temp_c / (temp_c + 237.3f));
+}
+
+static float derived_vpd(const float *in) {
+    float rh = fminf(fmaxf(in[0], 0.0f), 100.0f);
+    return derived_svp_kpa(in[1]) * (1.0f - rh / 100.0f);
+}
+
+// Magnus formula with the Sonntag constants
+static float derived_dew_point(const float *in) {
+    if (in[0] <= 0.0f) {
+        return NAN;
+    }
+    float gamma = logf(fminf(in[0], 100.0f) / 100.0f) + 17.62f * in[1] / (243.12f + in[1]);
+    return 243.12f * gamma / (17.62f - gamma);
+}
+
+// Linear compensation with the usual 2 %/°C coefficient for nutrient solutions
+static float derived_ec_25c(const float *in) {
+    float factor = 1.0f + 0.02f * (in[1] - 25.0f);
+    return factor > 0.0f ? in[0] / factor : NAN;
+}
+
+// Fresh water at sea level (Benson & Krause, as tabulated in Standard Methods 4500-O)
+static float derived_do_saturation(const float *in) {
+    float tk = in[1] + 273.15f;
+    float ln_c = -139.34411f + 1.575701e5f / tk - 6.642308e7f / (tk * tk) +
+                 1.243800e10f / (tk * tk * tk) - 8.621949e11f / (tk * tk * tk * tk);
+    float saturated_mg_l = expf(ln_c);
+    return saturated_mg_l > 0.0f ? 100.0f * in[0] / saturated_mg_l : NAN;
+}
+
+static const derived_metric_def_t s_metrics[DERIVED_METRIC_COUNT] = {
+    [DERIVED_VPD] = {
+        .name = "vpd_kpa", .unit = "kPa",
+        .inputs = { { EZO_KIND_HUM, DERIVED_CH_HUMIDITY }, { EZO_KIND_HUM, DERIVED_CH_AIR_TEMP } }, .input_count = 2,
+        .formula = derived_vpd,
+    },
+    [DERIVED_DEW_POINT] = {
+        .name = "dew_point", .unit = "°C",
+        .inputs = { { EZO_KIND_HUM, DERIVED_CH_HUMIDITY }, { EZO_KIND_HUM, DERIVED_CH_AIR_TEMP } }, .input_count = 2,
+        .replaces = { EZO_KIND_HUM, DERIVED_CH_DEW_POINT },
+        .formula = derived_dew_point,
+    },
+    [DERIVED_EC_25C] = {
+        .name = "ec_25c", .unit = "µS/cm",
+        .inputs = { { EZO_KIND_EC, DERIVED_CH_CONDUCTIVITY }, { EZO_KIND_RTD, DERIVED_CH_TEMPERATURE } }, .input_count = 2,
+        .board_normalized = true,
+        .formula = derived_ec_25c,
+    },
+    [DERIVED_DO_SATURATION] = {
+        .name = "do_saturation", .unit = "%",
+        .inputs = { { EZO_KIND_DO, DERIVED_CH_DO }, { EZO_KIND_RTD, DERIVED_CH_TEMPERATURE } }, .input_count = 2,
+        .replaces = { EZO_KIND_DO, DERIVED_CH_DO_SAT },
+        .formula = derived_do_saturation,
+    },
+};
+
+/**
+ * @brief Index of a channel among a sensor's values, -1 if the board does not report it
+ */
+static int derived_channel_index(const cached_sensor_t *sensor, uint8_t channel) {
+    for (uint8_t j = 0; j < sensor->value_count && j < MAX_SENSOR_VALUES; j++) {
+        if (sensor->channels[j] == channel) {
+            return j;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Find an input in the cache; temperatures from an RTD are returned in °C
+ */
+static bool derived_find_input(const sensor_cache_t *cache, const derived_input_t *input,
+                               float *value, const cached_sensor_t **source) {
+    for (uint8_t i = 0; i < cache->sensor_count && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
+        const cached_sensor_t *sensor = &cache->sensors[i];
+        if (!sensor->valid || sensor->kind != input->kind) {
+            continue;
+        }
+        int index = derived_channel_index(sensor, input->channel);
+        if (index < 0 || index >= sensor->value_count || !isfinite(sensor->values[index])) {
+            return false;
+        }
+
+        float v = sensor->values[index];
+        if (input->kind == EZO_KIND_RTD) {
+            const ezo_sensor_t *ezo = (const ezo_sensor_t *)sensor_manager_get_ezo_sensor(i);
+            char scale = (ezo != NULL) ? ezo->config.rtd.temperature_scale : 'C';
+            if (scale == 'F') {
+                v = (v - 32.0f) * 5.0f / 9.0f;
+            } else if (scale == 'K') {
+                v -= 273.15f;
+            }
+        }
+        *value = v;
+        if (source != NULL) {
+            *source = sensor;
+        }
+        return true;
+    }
+    return false;
+}
+
+void derived_metrics_compute(sensor_cache_t *cache) {
+    if (cache == NULL) {
+        return;
+    }
+    cache->derived_valid = 0;
+    memset(cache->derived, 0, sizeof(cache->derived));
+
+    for (uint8_t m = 0; m < DERIVED_METRIC_COUNT; m++) {
+        const derived_metric_def_t *def = &s_metrics[m];
+        float unused;
+        if (def->replaces.kind != EZO_KIND_UNKNOWN && derived_find_input(cache, &def->replaces, &unused, NULL)) {
+            continue;
+        }
+
+        float in[DERIVED_MAX_INPUTS];
+        const cached_sensor_t *first = NULL;
+        bool ready = true;
+        for (uint8_t k = 0; k < def->input_count && ready; k++) {
+            ready = derived_find_input(cache, &def->inputs[k], &in[k], k == 0 ? &first : NULL);
+        }
+        if (!ready) {
+            continue;
+        }
+
+        float value = (def->board_normalized && first->temp_compensated) ? in[0] : def->formula(in);
+        if (isfinite(value)) {
+            cache->derived[m] = value;
+            cache->derived_valid |= (uint8_t)(1u << m);
+        }
+    }
+}
+
+const char *derived_metrics_name(uint8_t metric) {
+    return metric < DERIVED_METRIC_COUNT ? s_metrics[metric].name : NULL;
+}
+
+const char *derived_metrics_unit(uint8_t metric) {
+    return metric < DERIVED_METRIC_COUNT ? s_metrics[metric].unit : NULL;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file derived_metrics.h
+ * @brief Metrics computed on the device from the conditioned sensor values
+ *
+ * Each metric is a row of a table: the input channels it needs (a sensor
+ * type plus a value field) and a formula. Once per cycle, before the cache
+ * is published, every metric whose inputs are valid is evaluated into
+ * sensor_cache_t.derived. A metric can name a board output it replaces; it
+ * is then skipped while that board still reports the output itself.
+ * Consumers publish the results next to the sensors, under "derived".
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DERIVED_VPD = 0,            // Vapour pressure deficit of the air, kPa (HUM)
+    DERIVED_DEW_POINT,          // Dew point, °C (HUM, while its Dew output is off)
+    DERIVED_EC_25C,             // Conductivity normalized to 25 °C, µS/cm (EC + RTD)
+    DERIVED_DO_SATURATION,      // Oxygen saturation, % (DO + RTD, while its % output is off)
+    DERIVED_METRIC_COUNT
+} derived_metric_t;
+
+/**
+ * @brief Evaluate every metric into cache->derived and cache->derived_valid
+ *
+ * Runs in the sensor reading task, on the cache about to be published.
+ */
+void derived_metrics_compute(sensor_cache_t *cache);
+
+/**
+ * @brief JSON key of a metric ("vpd_kpa", "dew_point", "ec_25c", "do_saturation")
+ */
+const char *derived_metrics_name(uint8_t metric);
+
+/**
+ * @brief Unit of a metric, for display
+ */
+const char *derived_metrics_unit(uint8_t metric);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,440 @@
+/**
+ * @file ezo_emulator.c
+ * @brief Emulated EZO boards behind the EZO driver's I2C transfers (test builds)
+ */
+
+#include "ezo_emulator.h"
+#include "ezo_sensor.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "EZO_EMU";
+
+#ifndef CONFIG_KC_EZO_EMULATOR_COUNT
+#define CONFIG_KC_EZO_EMULATOR_COUNT 0
+#endif
+#ifndef CONFIG_KC_EZO_EMULATOR_BASE_ADDR
+#define CONFIG_KC_EZO_EMULATOR_BASE_ADDR 0x20
+#endif
+#ifndef CONFIG_KC_EZO_EMULATOR_JITTER_MS
+#define CONFIG_KC_EZO_EMULATOR_JITTER_MS 0
+#endif
+#ifndef CONFIG_KC_EZO_EMULATOR_FAIL_PERMILLE
+#define CONFIG_KC_EZO_EMULATOR_FAIL_PERMILLE 0
+#endif
+
+#define EZO_EMULATOR_BYTE_US    90      // 9 clocks per byte at 100 kHz
+#define EZO_EMULATOR_FIRMWARE   "2.16"
+
+typedef enum {
+    EMU_PENDING_NONE = 0,       // Nothing to read: EZO_RESP_NO_DATA
+    EMU_PENDING_REPLY,          // Command answered, reply ready
+    EMU_PENDING_READING,        // Conversion running until ready_us
+} emu_pending_t;
+
+typedef struct {
+    bool used;
+    ezo_emulator_config_t config;
+    ezo_emulator_counters_t counters;
+    emu_pending_t pending;
+    int64_t ready_us;
+    char reply[EZO_LARGEST_STRING];
+    char name[EZO_MAX_SENSOR_NAME];
+    bool led;
+    bool continuous;
+    bool sleeping;
+} emu_device_t;
+
+// Order of the default fleet: the RTD first, so the others get its temperature
+static const uint8_t k_fleet_kinds[] = {
+    EZO_KIND_RTD, EZO_KIND_PH, EZO_KIND_EC, EZO_KIND_DO, EZO_KIND_ORP, EZO_KIND_HUM,
+};
+
+static emu_device_t s_devices[EZO_EMULATOR_MAX_DEVICES];
+static SemaphoreHandle_t s_mutex = NULL;
+static uint64_t s_bus_busy_us = 0;          // Emulated wire time of every transfer
+static int64_t s_started_us = 0;
+
+static emu_device_t *emu_find_locked(uint8_t address) {
+    for (int i = 0; i < EZO_EMULATOR_MAX_DEVICES; i++) {
+        if (s_devices[i].used && s_devices[i].config.address == address) {
+            return &s_devices[i];
+        }
+    }
+    return NULL;
+}
+
+static bool emu_roll(uint16_t permille) {
+    return permille > 0 && (esp_random() % 1000) < permille;
+}
+
+/**
+ * @brief Hold the caller for the wire time of a transfer
+ */
+static void emu_bus_time(size_t bytes) {
+    uint32_t us = (uint32_t)(bytes + 1) * EZO_EMULATOR_BYTE_US;    // Plus the address byte
+    esp_rom_delay_us(us);
+    s_bus_busy_us += us;
+}
+
+static void emu_format_reading(const emu_device_t *dev, char *out, size_t size) {
+    const ezo_emulator_config_t *c = &dev->config;
+    if (c->response[0] != '\0') {
+        snprintf(out, size, "%s", c->response);
+        return;
+    }
+
+    float v[4];
+    for (int i = 0; i < 4; i++) {
+        float r = ((float)(esp_random() % 2001) - 1000.0f) / 1000.0f;
+        v[i] = c->values[i] + r * c->noise;
+    }
+    switch (c->kind) {
+    case EZO_KIND_EC:
+        snprintf(out, size, "%.2f,%.0f,%.2f,%.3f", v[0], v[1], v[2], v[3]);
+        break;
+    case EZO_KIND_DO:
+        snprintf(out, size, "%.2f,%.1f", v[0], v[1]);
+        break;
+    case EZO_KIND_HUM:
+        snprintf(out, size, "%.2f,%.2f,Dew,%.2f", v[0], v[1], v[2]);
+        break;
+    default:
+        snprintf(out, size, "%.3f", v[0]);
+        break;
+    }
+}
+
+static void emu_reply(emu_device_t *dev, const char *text) {
+    snprintf(dev->reply, sizeof(dev->reply), "%s", text);
+    dev->pending = EMU_PENDING_REPLY;
+}
+
+/**
+ * @brief Answer one command the way the board would (caller holds s_mutex)
+ */
+static void emu_command_locked(emu_device_t *dev, const char *cmd) {
+    const ezo_sensor_desc_t *desc = ezo_sensor_desc(dev->config.kind);
+    char text[EZO_LARGEST_STRING];
+
+    // Any byte wakes a sleeping board
+    dev->sleeping = false;
+
+    if (strcmp(cmd, "R") == 0 || strncmp(cmd, "RT,", 3) == 0) {
+        uint32_t latency = dev->config.latency_ms > 0 ? dev->config.latency_ms : desc->conversion_ms;
+        if (dev->config.jitter_ms > 0) {
+            latency += esp_random() % (dev->config.jitter_ms + 1u);
+        }
+        dev->pending = EMU_PENDING_READING;
+        dev->ready_us = esp_timer_get_time() + (int64_t)latency * 1000;
+        dev->counters.readings++;
+    } else if (strcmp(cmd, "i") == 0) {
+        snprintf(text, sizeof(text), "?I,%s," EZO_EMULATOR_FIRMWARE, desc->type);
+        emu_reply(dev, text);
+    } else if (strcmp(cmd, "Status") == 0) {
+        emu_reply(dev, "?Status,P,5.038");
+    } else if (strcmp(cmd, "Name,?") == 0) {
+        snprintf(text, sizeof(text), "?Name,%s", dev->name);
+        emu_reply(dev, text);
+    } else if (strncmp(cmd, "Name,", 5) == 0) {
+        snprintf(dev->name, sizeof(dev->name), "%s", cmd + 5);
+        emu_reply(dev, "");
+    } else if (strcmp(cmd, "L,?") == 0) {
+        emu_reply(dev, dev->led ? "?L,1" : "?L,0");
+    } else if (strncmp(cmd, "L,", 2) == 0) {
+        dev->led = (cmd[2] == '1');
+        emu_reply(dev, "");
+    } else if (strcmp(cmd, "C,?") == 0) {
+        emu_reply(dev, dev->continuous ? "?C,1" : "?C,0");
+    } else if (strncmp(cmd, "C,", 2) == 0) {
+        dev->continuous = (atoi(cmd + 2) > 0);
+        emu_reply(dev, "");
+    } else if (strcmp(cmd, "Plock,?") == 0) {
+        emu_reply(dev, "?Plock,0");
+    } else if (strcmp(cmd, "Cal,?") == 0) {
+        emu_reply(dev, "?Cal,0");
+    } else if (strcmp(cmd, "O,?") == 0) {
+        switch (dev->config.kind) {
+        case EZO_KIND_EC:  emu_reply(dev, "?O,EC,TDS,S,SG"); break;
+        case EZO_KIND_DO:  emu_reply(dev, "?O,mg,%"); break;
+        case EZO_KIND_HUM: emu_reply(dev, "?O,HUM,T,Dew"); break;
+        default:           emu_reply(dev, "?O,"); break;
+        }
+    } else if (strcmp(cmd, "K,?") == 0) {
+        emu_reply(dev, "?K,1.0");
+    } else if (strcmp(cmd, "TDS,?") == 0) {
+        emu_reply(dev, "?TDS,0.50");
+    } else if (strcmp(cmd, "S,?") == 0) {
+        emu_reply(dev, "?S,c");
+    } else if (strcmp(cmd, "pHext,?") == 0) {
+        emu_reply(dev, "?pHext,0");
+    } else if (strcmp(cmd, "T,?") == 0) {
+        emu_reply(dev, "?T,25.0");
+    } else if (strcmp(cmd, "Sleep") == 0) {
+        dev->sleeping = true;
+        dev->pending = EMU_PENDING_NONE;
+    } else if (strncmp(cmd, "I2C,", 4) == 0) {
+        // The board reboots at its new address without answering
+        long address = strtol(cmd + 4, NULL, 10);
+        if (address > 0 && address < 0x78 && emu_find_locked((uint8_t)address) == NULL) {
+            dev->config.address = (uint8_t)address;
+        }
+        dev->pending = EMU_PENDING_NONE;
+    } else {
+        // Settings and calibration commands only acknowledge
+        emu_reply(dev, "");
+    }
+}
+
+void ezo_emulator_default_config(uint8_t kind, uint8_t address, ezo_emulator_config_t *config) {
+    memset(config, 0, sizeof(*config));
+    config->address = address;
+    config->kind = kind;
+    config->jitter_ms = CONFIG_KC_EZO_EMULATOR_JITTER_MS;
+    config->fail_permille = CONFIG_KC_EZO_EMULATOR_FAIL_PERMILLE;
+    switch (kind) {
+    case EZO_KIND_RTD:
+        config->values[0] = 25.1f;
+        config->noise = 0.05f;
+        break;
+    case EZO_KIND_PH:
+        config->values[0] = 7.01f;
+        config->noise = 0.01f;
+        break;
+    case EZO_KIND_EC:
+        config->values[0] = 1413.0f;
+        config->values[1] = 707.0f;
+        config->values[2] = 0.70f;
+        config->values[3] = 1.0f;
+        config->noise = 0.5f;
+        break;
+    case EZO_KIND_DO:
+        config->values[0] = 8.32f;
+        config->values[1] = 91.2f;
+        config->noise = 0.05f;
+        break;
+    case EZO_KIND_ORP:
+        config->values[0] = 412.3f;
+        config->noise = 0.5f;
+        break;
+    case EZO_KIND_HUM:
+        config->values[0] = 45.2f;
+        config->values[1] = 23.1f;
+        config->values[2] = 10.8f;
+        config->noise = 0.2f;
+        break;
+    default:
+        break;
+    }
+}
+
+esp_err_t ezo_emulator_init(void) {
+    if (s_mutex != NULL) {
+        return ESP_OK;
+    }
+    s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_started_us = esp_timer_get_time();
+
+    for (int i = 0; i < CONFIG_KC_EZO_EMULATOR_COUNT && i < EZO_EMULATOR_MAX_DEVICES; i++) {
+        ezo_emulator_config_t config;
+        uint8_t kind = k_fleet_kinds[i % (sizeof(k_fleet_kinds) / sizeof(k_fleet_kinds[0]))];
+        ezo_emulator_default_config(kind, (uint8_t)(CONFIG_KC_EZO_EMULATOR_BASE_ADDR + i), &config);
+        ezo_emulator_set(&config);
+    }
+    ESP_LOGW(TAG, "EZO emulator active: %d board(s) from 0x%02X", CONFIG_KC_EZO_EMULATOR_COUNT,
+             CONFIG_KC_EZO_EMULATOR_BASE_ADDR);
+    return ESP_OK;
+}
+
+esp_err_t ezo_emulator_set(const ezo_emulator_config_t *config) {
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (config == NULL || config->address < 0x08 || config->address > 0x77 ||
+        config->kind == EZO_KIND_UNKNOWN || config->kind >= EZO_KIND_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    emu_device_t *dev = emu_find_locked(config->address);
+    if (dev == NULL) {
+        for (int i = 0; i < EZO_EMULATOR_MAX_DEVICES && dev == NULL; i++) {
+            if (!s_devices[i].used) {
+                dev = &s_devices[i];
+                memset(dev, 0, sizeof(*dev));
+                dev->used = true;
+                dev->led = true;
+            }
+        }
+    }
+    if (dev != NULL) {
+        dev->config = *config;
+        dev->config.response[sizeof(dev->config.response) - 1] = '\0';
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+    xSemaphoreGive(s_mutex);
+    return ret;
+}
+
+esp_err_t ezo_emulator_get(uint8_t address, ezo_emulator_config_t *config) {
+    if (s_mutex == NULL || config == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    emu_device_t *dev = emu_find_locked(address);
+    if (dev != NULL) {
+        *config = dev->config;
+    }
+    xSemaphoreGive(s_mutex);
+    return dev != NULL ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t ezo_emulator_remove(uint8_t address) {
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    emu_device_t *dev = emu_find_locked(address);
+    if (dev != NULL) {
+        dev->used = false;
+    }
+    xSemaphoreGive(s_mutex);
+    return dev != NULL ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+bool ezo_emulator_present(uint8_t address) {
+    if (s_mutex == NULL) {
+        return false;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool present = emu_find_locked(address) != NULL;
+    xSemaphoreGive(s_mutex);
+    return present;
+}
+
+esp_err_t ezo_emulator_transmit(uint8_t address, const uint8_t *data, size_t len) {
+    if (s_mutex == NULL || data == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    char cmd[32];
+    size_t n = len < sizeof(cmd) - 1 ? len : sizeof(cmd) - 1;
+    memcpy(cmd, data, n);
+    cmd[n] = '\0';
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    emu_device_t *dev = emu_find_locked(address);
+    esp_err_t ret = ESP_OK;
+    if (dev == NULL) {
+        ret = ESP_ERR_NOT_FOUND;
+    } else {
+        dev->counters.transfers++;
+        emu_bus_time(len);
+        if (emu_roll(dev->config.fail_permille)) {
+            dev->counters.failures++;
+            ret = ESP_ERR_TIMEOUT;
+        } else {
+            emu_command_locked(dev, cmd);
+        }
+    }
+    xSemaphoreGive(s_mutex);
+    return ret;
+}
+
+esp_err_t ezo_emulator_receive(uint8_t address, uint8_t *buf, size_t len) {
+    if (s_mutex == NULL || buf == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(buf, 0, len);
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    emu_device_t *dev = emu_find_locked(address);
+    esp_err_t ret = ESP_OK;
+    if (dev != NULL) {
+        dev->counters.transfers++;
+        emu_bus_time(len);
+    }
+    if (dev == NULL) {
+        ret = ESP_ERR_NOT_FOUND;
+    } else if (emu_roll(dev->config.fail_permille)) {
+        dev->counters.failures++;
+        ret = ESP_ERR_TIMEOUT;
+    } else if (dev->pending == EMU_PENDING_READING &&
+               (esp_timer_get_time() < dev->ready_us || emu_roll(dev->config.busy_permille))) {
+        buf[0] = EZO_RESP_NOT_READY;
+        dev->counters.not_ready++;
+    } else if (dev->pending == EMU_PENDING_NONE) {
+        buf[0] = EZO_RESP_NO_DATA;
+    } else {
+        if (dev->pending == EMU_PENDING_READING) {
+            emu_format_reading(dev, dev->reply, sizeof(dev->reply));
+        }
+        buf[0] = EZO_RESP_SUCCESS;
+        snprintf((char *)buf + 1, len - 1, "%s", dev->reply);
+        dev->pending = EMU_PENDING_NONE;
+    }
+    xSemaphoreGive(s_mutex);
+    return ret;
+}
+
+void ezo_emulator_write_json(json_writer_t *w) {
+    json_writer_object_begin(w);
+    if (s_mutex == NULL) {
+        json_writer_kv_int(w, "count", 0);
+        json_writer_object_end(w);
+        return;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    int64_t elapsed_us = esp_timer_get_time() - s_started_us;
+    json_writer_kv_int(w, "bus_busy_ms", (int64_t)(s_bus_busy_us / 1000));
+    json_writer_kv_float(w, "bus_utilization", elapsed_us > 0 ? (float)s_bus_busy_us * 100.0f / (float)elapsed_us : 0.0f);
+    json_writer_key(w, "devices");
+    json_writer_array_begin(w);
+    int count = 0;
+    for (int i = 0; i < EZO_EMULATOR_MAX_DEVICES; i++) {
+        const emu_device_t *dev = &s_devices[i];
+        if (!dev->used) {
+            continue;
+        }
+        const ezo_emulator_config_t *c = &dev->config;
+        json_writer_object_begin(w);
+        json_writer_kv_int(w, "address", c->address);
+        json_writer_kv_string(w, "type", ezo_sensor_desc(c->kind)->type);
+        json_writer_kv_int(w, "latency_ms", c->latency_ms > 0 ? c->latency_ms : ezo_sensor_desc(c->kind)->conversion_ms);
+        json_writer_kv_int(w, "jitter_ms", c->jitter_ms);
+        json_writer_kv_int(w, "fail_permille", c->fail_permille);
+        json_writer_kv_int(w, "busy_permille", c->busy_permille);
+        json_writer_kv_float(w, "noise", c->noise);
+        json_writer_key(w, "values");
+        json_writer_array_begin(w);
+        for (int v = 0; v < 4; v++) {
+            json_writer_float(w, c->values[v]);
+        }
+        json_writer_array_end(w);
+        if (c->response[0] != '\0') {
+            json_writer_kv_string(w, "response", c->response);
+        }
+        json_writer_kv_int(w, "transfers", dev->counters.transfers);
+        json_writer_kv_int(w, "readings", dev->counters.readings);
+        json_writer_kv_int(w, "not_ready", dev->counters.not_ready);
+        json_writer_kv_int(w, "failures", dev->counters.failures);
+        json_writer_object_end(w);
+        count++;
+    }
+    json_writer_array_end(w);
+    xSemaphoreGive(s_mutex);
+    json_writer_kv_int(w, "count", count);
+    json_writer_object_end(w);
+}
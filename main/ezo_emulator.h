@@ -0,0 +1,113 @@
+/**
+ * @file ezo_emulator.h
+ * @brief Emulated EZO boards behind the EZO driver's I2C transfers (test builds)
+ *
+ * With CONFIG_KC_EZO_EMULATOR the driver's transmit and receive calls for an
+ * emulated address are answered here instead of on the wire, and the scanner
+ * sees the address as present. Each board speaks enough of the EZO I2C
+ * protocol for identification, settings queries and readings: a reading
+ * reports EZO_RESP_NOT_READY until its programmed conversion latency (plus
+ * jitter) has passed. Transfers can be made to fail, to stay busy past the
+ * latency, or to return fixed response text.
+ *
+ * Transfers take the time a 100 kHz bus would need for their bytes, so cycle
+ * time and bus utilization of the acquisition engine can be measured with
+ * more boards than a bench holds. Boards are added and removed at run time,
+ * which also exercises hot-plug detection.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EZO_EMULATOR_MAX_DEVICES    16
+
+/**
+ * @brief Programmable behaviour of one emulated board
+ */
+typedef struct {
+    uint8_t address;
+    uint8_t kind;                   // ezo_sensor_kind_t
+    uint16_t latency_ms;            // Conversion time of a reading, 0 for the kind's worst case
+    uint16_t jitter_ms;             // Uniform extra conversion time, 0..jitter_ms
+    uint16_t fail_permille;         // Transfers failing with ESP_ERR_TIMEOUT
+    uint16_t busy_permille;         // Finished readings still answered with NOT_READY
+    float values[4];                // Centre of the generated readings
+    float noise;                    // Uniform noise amplitude added to each value
+    char response[24];              // Fixed reading text (e.g. "*ER"), empty to generate one
+} ezo_emulator_config_t;
+
+typedef struct {
+    uint32_t transfers;
+    uint32_t readings;
+    uint32_t not_ready;             // Polls answered with EZO_RESP_NOT_READY
+    uint32_t failures;              // Injected transfer errors
+} ezo_emulator_counters_t;
+
+/**
+ * @brief Create the Kconfig default fleet (idempotent)
+ *
+ * Called from i2c_scanner_init(), before the first scan.
+ */
+esp_err_t ezo_emulator_init(void);
+
+/**
+ * @brief Defaults for a board of a kind: descriptor latency and typical values
+ */
+void ezo_emulator_default_config(uint8_t kind, uint8_t address, ezo_emulator_config_t *config);
+
+/**
+ * @brief Add a board, or reprogram the one at config->address
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad address or kind,
+ *         ESP_ERR_NO_MEM when EZO_EMULATOR_MAX_DEVICES boards exist
+ */
+esp_err_t ezo_emulator_set(const ezo_emulator_config_t *config);
+
+/**
+ * @brief Current programming of a board
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if no board has the address
+ */
+esp_err_t ezo_emulator_get(uint8_t address, ezo_emulator_config_t *config);
+
+/**
+ * @brief Remove a board; it stops answering, as if unplugged
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if no board has the address
+ */
+esp_err_t ezo_emulator_remove(uint8_t address);
+
+/**
+ * @brief Whether an address belongs to an emulated board
+ */
+bool ezo_emulator_present(uint8_t address);
+
+/**
+ * @brief Write to an emulated board (stands in for i2c_master_transmit)
+ */
+esp_err_t ezo_emulator_transmit(uint8_t address, const uint8_t *data, size_t len);
+
+/**
+ * @brief Read from an emulated board (stands in for i2c_master_receive)
+ *
+ * buf[0] is the EZO status byte, followed by the NUL-terminated response.
+ */
+esp_err_t ezo_emulator_receive(uint8_t address, uint8_t *buf, size_t len);
+
+/**
+ * @brief Write every board with its programming and counters, plus bus time, as a JSON object
+ */
+void ezo_emulator_write_json(json_writer_t *w);
+
+#ifdef __cplusplus
+}
+#endif
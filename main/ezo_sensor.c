@@ -4,17 +4,159 @@
  */
 
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "ezo_sensor.h"
+#include "trace_log.h"
+#include "i2c_arbiter.h"
+#include "i2c_scanner.h"
+#ifdef CONFIG_KC_EZO_EMULATOR
+#include "ezo_emulator.h"
+#endif
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "nvs.h"
 
 static const char *TAG = "EZO_SENSOR";
 
+// Identity/settings cache so warm boots only verify the board instead of re-querying it
+#define EZO_ID_CACHE_NAMESPACE  "ezo_cache"
+#define EZO_ID_CACHE_VERSION    1
+
+typedef struct {
+    uint32_t version;
+    uint32_t size;
+    ezo_sensor_config_t config;
+} ezo_identity_blob_t;
+
+static const ezo_sensor_desc_t s_descs[EZO_KIND_COUNT] = {
+    [EZO_KIND_UNKNOWN] = {
+        .type = "", .conversion_ms = 1000,
+    },
+    [EZO_KIND_RTD] = {
+        .type = EZO_TYPE_RTD, .channel_count = 1,
+        .channels = { "temperature" }, .units = { "°C" },
+        .conversion_ms = 600, .capabilities = EZO_CAP_CALIBRATION,
+    },
+    [EZO_KIND_PH] = {
+        .type = EZO_TYPE_PH, .channel_count = 1,
+        .channels = { "ph" }, .units = { "pH" },
+        .conversion_ms = 900, .temp_comp = true,
+        .capabilities = EZO_CAP_CALIBRATION | EZO_CAP_TEMP_COMP | EZO_CAP_MODE | EZO_CAP_SLEEP,
+    },
+    [EZO_KIND_EC] = {
+        .type = EZO_TYPE_EC, .channel_count = 4,
+        .channels = { "conductivity", "tds", "salinity", "specific_gravity" },
+        .units = { "µS/cm", "ppm", "PSU", "" },
+        .conversion_ms = 1000, .temp_comp = true,
+        .capabilities = EZO_CAP_CALIBRATION | EZO_CAP_MODE,
+    },
+    [EZO_KIND_DO] = {
+        .type = EZO_TYPE_DO, .channel_count = 2,
+        .channels = { "dissolved_oxygen", "saturation" }, .units = { "mg/L", "%" },
+        .conversion_ms = 1300, .capabilities = EZO_CAP_CALIBRATION | EZO_CAP_MODE,
+    },
+    [EZO_KIND_ORP] = {
+        .type = EZO_TYPE_ORP, .channel_count = 1,
+        .channels = { "orp" }, .units = { "mV" },
+        .conversion_ms = 900, .temp_comp = true,
+        .capabilities = EZO_CAP_CALIBRATION | EZO_CAP_MODE | EZO_CAP_SLEEP,
+    },
+    [EZO_KIND_HUM] = {
+        .type = EZO_TYPE_HUM, .channel_count = 3,
+        .channels = { "humidity", "air_temp", "dew_point" }, .units = { "%", "°C", "°C" },
+        .conversion_ms = 600,
+    },
+};
+
+// Output names of the HUM "O,?" reply, in descriptor channel order
+static const char *const s_hum_outputs[] = { "HUM", "T", "Dew" };
+
 static esp_err_t ezo_sensor_receive_response(ezo_sensor_t *sensor, char *response, size_t response_size);
-static esp_err_t ezo_sensor_parse_values(char *response, float values[4], uint8_t *count);
+static esp_err_t ezo_sensor_parse_values(const char *response, float values[4], uint8_t *count);
+static esp_err_t ezo_sensor_identify(ezo_sensor_t *sensor);
+static void ezo_sensor_query_details(ezo_sensor_t *sensor);
+static bool ezo_identity_cache_load(ezo_sensor_t *sensor);
+static void ezo_identity_cache_store(const ezo_sensor_t *sensor);
+static void ezo_identity_cache_invalidate(const ezo_sensor_t *sensor);
+
+ezo_sensor_kind_t ezo_sensor_kind_from_type(const char *type) {
+    if (type == NULL || type[0] == '\0') {
+        return EZO_KIND_UNKNOWN;
+    }
+    for (int k = EZO_KIND_UNKNOWN + 1; k < EZO_KIND_COUNT; k++) {
+        if (strcmp(s_descs[k].type, type) == 0) {
+            return (ezo_sensor_kind_t)k;
+        }
+    }
+    return EZO_KIND_UNKNOWN;
+}
+
+const ezo_sensor_desc_t *ezo_sensor_desc(uint8_t kind) {
+    return &s_descs[kind < EZO_KIND_COUNT ? kind : EZO_KIND_UNKNOWN];
+}
+
+const char *ezo_sensor_channel_name(uint8_t kind, uint8_t channel) {
+    if (kind >= EZO_KIND_COUNT || channel >= EZO_MAX_CHANNELS) {
+        return NULL;
+    }
+    return s_descs[kind].channels[channel];
+}
+
+/**
+ * @brief Map each value of a reading to its descriptor channel
+ *
+ * HUM boards report only their enabled outputs, in the order "O,?" lists
+ * them; every other kind reports its channels in descriptor order.
+ */
+static void ezo_sensor_resolve_channels(ezo_sensor_t *sensor) {
+    ezo_sensor_config_t *config = &sensor->config;
+    const ezo_sensor_desc_t *desc = ezo_sensor_desc(config->kind);
+    memset(config->channels, EZO_CHANNEL_NONE, sizeof(config->channels));
+
+    if (config->kind == EZO_KIND_HUM && config->hum.param_count > 0) {
+        for (uint8_t j = 0; j < config->hum.param_count && j < EZO_MAX_CHANNELS; j++) {
+            for (uint8_t c = 0; c < sizeof(s_hum_outputs) / sizeof(s_hum_outputs[0]); c++) {
+                if (strcasecmp(config->hum.param_order[j], s_hum_outputs[c]) == 0) {
+                    config->channels[j] = c;
+                    break;
+                }
+            }
+        }
+        return;
+    }
+
+    for (uint8_t c = 0; c < desc->channel_count; c++) {
+        config->channels[c] = c;
+    }
+}
+
+/**
+ * @brief Write to the board; emulated addresses never reach the wire
+ */
+static esp_err_t ezo_sensor_bus_write(ezo_sensor_t *sensor, const uint8_t *data, size_t len) {
+#ifdef CONFIG_KC_EZO_EMULATOR
+    if (ezo_emulator_present(sensor->config.i2c_address)) {
+        return ezo_emulator_transmit(sensor->config.i2c_address, data, len);
+    }
+#endif
+    esp_err_t ret = i2c_master_transmit(sensor->dev_handle, data, len, EZO_RESPONSE_TIMEOUT_MS);
+    i2c_scanner_note_result(sensor->config.i2c_address, ret);
+    return ret;
+}
+
+static esp_err_t ezo_sensor_bus_read(ezo_sensor_t *sensor, uint8_t *buf, size_t len) {
+#ifdef CONFIG_KC_EZO_EMULATOR
+    if (ezo_emulator_present(sensor->config.i2c_address)) {
+        return ezo_emulator_receive(sensor->config.i2c_address, buf, len);
+    }
+#endif
+    esp_err_t ret = i2c_master_receive(sensor->dev_handle, buf, len, EZO_RESPONSE_TIMEOUT_MS);
+    i2c_scanner_note_result(sensor->config.i2c_address, ret);
+    return ret;
+}
 
 /**
  * @brief Send command and read response from EZO sensor
@@ -25,11 +167,11 @@ esp_err_t ezo_sensor_send_command(ezo_sensor_t *sensor, const char *command,
         return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGI(TAG, "Sending command to 0x%02X: %s", sensor->config.i2c_address, command);
+    trace_log_emit(TRACE_EV_EZO_CMD, sensor->config.i2c_address,
+                   trace_arg_str4(command, 0), trace_arg_str4(command, 4));
 
     // Send command
-    esp_err_t ret = i2c_master_transmit(sensor->dev_handle, (const uint8_t *)command, 
-                                        strlen(command), EZO_RESPONSE_TIMEOUT_MS);
+    esp_err_t ret = ezo_sensor_bus_write(sensor, (const uint8_t *)command, strlen(command));
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to send command: %s", esp_err_to_name(ret));
         return ret;
@@ -58,7 +200,7 @@ static esp_err_t ezo_sensor_receive_response(ezo_sensor_t *sensor, char *respons
     }
 
     uint8_t buffer[EZO_LARGEST_STRING] = {0};
-    esp_err_t ret = i2c_master_receive(sensor->dev_handle, buffer, EZO_LARGEST_STRING, EZO_RESPONSE_TIMEOUT_MS);
+    esp_err_t ret = ezo_sensor_bus_read(sensor, buffer, EZO_LARGEST_STRING);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to read response: %s", esp_err_to_name(ret));
         return ret;
@@ -93,24 +235,139 @@ static esp_err_t ezo_sensor_receive_response(ezo_sensor_t *sensor, char *respons
     return ESP_FAIL;
 }
 
-static esp_err_t ezo_sensor_parse_values(char *response, float values[4], uint8_t *count) {
+static const float k_ezo_pow10[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f
+};
+#define EZO_PARSE_MAX_FRAC_DIGITS 9
+#define EZO_PARSE_MAX_MANTISSA    100000000000000000ULL  // Stop accumulating before uint64 overflow
+
+static bool ezo_is_space(char c) {
+    return c == ' ' || c == '\r' || c == '\n' || c == '\t';
+}
+
+/**
+ * @brief Parse one decimal field in [begin, end) without libc float parsing
+ *
+ * Returns false if the field does not start like a number. Sets *complete to
+ * false if trailing characters follow the number.
+ */
+static bool ezo_parse_number(const char *begin, const char *end, float *out, bool *complete) {
+    const char *p = begin;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    uint32_t int_scale = 0;     // Integer digits dropped after the mantissa filled up
+    uint32_t frac_digits = 0;
+    bool any_digit = false;
+
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (mantissa < EZO_PARSE_MAX_MANTISSA) {
+            mantissa = mantissa * 10 + (uint32_t)(*p - '0');
+        } else {
+            int_scale++;
+        }
+        any_digit = true;
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (frac_digits < EZO_PARSE_MAX_FRAC_DIGITS && mantissa < EZO_PARSE_MAX_MANTISSA) {
+                mantissa = mantissa * 10 + (uint32_t)(*p - '0');
+                frac_digits++;
+            }
+            any_digit = true;
+            p++;
+        }
+    }
+
+    if (!any_digit) {
+        return false;
+    }
+
+    float value = (float)mantissa / k_ezo_pow10[frac_digits];
+    while (int_scale-- > 0) {
+        value *= 10.0f;
+    }
+    *out = negative ? -value : value;
+    *complete = (p == end);
+    return true;
+}
+
+esp_err_t ezo_parse_reading(const char *response, size_t len, float values[4], uint8_t *count,
+                            uint8_t *valid_mask) {
     if (response == NULL || values == NULL || count == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
     *count = 0;
-    char *token = strtok(response, ",");
-    while (token != NULL && *count < 4) {
-        if (token[0] == '-' || token[0] == '.' || (token[0] >= '0' && token[0] <= '9')) {
-            values[*count] = atof(token);
-            (*count)++;
+    uint8_t mask = 0;
+    if (valid_mask != NULL) {
+        *valid_mask = 0;
+    }
+    const char *end = response + strnlen(response, len);
+    const char *field = response;
+
+    while (field < end && *count < 4) {
+        const char *field_end = memchr(field, ',', (size_t)(end - field));
+        if (field_end == NULL) {
+            field_end = end;
         }
-        token = strtok(NULL, ",");
+
+        // Trim surrounding whitespace and line endings
+        const char *b = field;
+        const char *e = field_end;
+        while (b < e && ezo_is_space(*b)) b++;
+        while (e > b && ezo_is_space(e[-1])) e--;
+
+        if (b < e && *b == '*') {
+            // Status markers: *OK and friends are informational, errors abort the parse
+            size_t n = (size_t)(e - b);
+            if ((n == 3 && (memcmp(b, "*ER", 3) == 0 || memcmp(b, "*OV", 3) == 0 ||
+                            memcmp(b, "*UV", 3) == 0))) {
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+        } else if (b < e) {
+            float v;
+            bool complete;
+            if (ezo_parse_number(b, e, &v, &complete)) {
+                values[*count] = v;
+                if (complete) {
+                    mask |= (uint8_t)(1U << *count);
+                }
+                (*count)++;
+            }
+        }
+
+        field = field_end + 1;
     }
 
+    if (valid_mask != NULL) {
+        *valid_mask = mask;
+    }
     return ESP_OK;
 }
 
+// Drop-in for atof() on single response fields
+static float ezo_parse_float(const char *text) {
+    float value = 0.0f;
+    bool complete;
+    const char *end = text + strlen(text);
+    while (text < end && ezo_is_space(*text)) text++;
+    if (!ezo_parse_number(text, end, &value, &complete)) {
+        value = 0.0f;
+    }
+    return value;
+}
+
+static esp_err_t ezo_sensor_parse_values(const char *response, float values[4], uint8_t *count) {
+    return ezo_parse_reading(response, EZO_LARGEST_STRING, values, count, NULL);
+}
+
 /**
  * @brief Initialize EZO sensor
  */
@@ -163,10 +420,10 @@ esp_err_t ezo_sensor_init(ezo_sensor_t *sensor, i2c_master_bus_handle_t bus_hand
         ESP_LOGI(TAG, "Successfully cleared %d stale response(s) from 0x%02X", cleared_count, i2c_address);
     }
 
-    // Get device information with retries for slow sensors
+    // Identify the board with retries for slow sensors
     const int max_retries = 3;
     for (int i = 0; i < max_retries; i++) {
-        ret = ezo_sensor_get_device_info(sensor);
+        ret = ezo_sensor_identify(sensor);
         if (ret == ESP_OK) {
             break;
         }
@@ -178,6 +435,15 @@ esp_err_t ezo_sensor_init(ezo_sensor_t *sensor, i2c_master_bus_handle_t bus_hand
         }
     }
 
+    if (ret == ESP_OK) {
+        if (ezo_identity_cache_load(sensor)) {
+            ESP_LOGI(TAG, "Address 0x%02X: identity verified, using cached settings", i2c_address);
+        } else {
+            ezo_sensor_query_details(sensor);
+            ezo_identity_cache_store(sensor);
+        }
+    }
+
     // Validate type field after all initialization
     size_t type_len = strnlen(sensor->config.type, sizeof(sensor->config.type));
     if (type_len == 0 || type_len >= sizeof(sensor->config.type)) {
@@ -185,7 +451,9 @@ esp_err_t ezo_sensor_init(ezo_sensor_t *sensor, i2c_master_bus_handle_t bus_hand
                  sensor->config.i2c_address, type_len, sizeof(sensor->config.type), sensor->config.type);
         // Force to empty string to trigger UNKNOWN fallback later
         sensor->config.type[0] = '\0';
+        sensor->config.kind = EZO_KIND_UNKNOWN;
     }
+    ezo_sensor_resolve_channels(sensor);
 
     ESP_LOGI(TAG, "EZO sensor initialized: Type=%s, FW=%s", 
              sensor->config.type, sensor->config.firmware_version);
@@ -216,7 +484,7 @@ esp_err_t ezo_sensor_refresh_settings(ezo_sensor_t *sensor) {
         }
     }
 
-    if ((sensor->config.capability_flags & EZO_CAP_TEMP_COMP) && strcmp(sensor->config.type, EZO_TYPE_PH) == 0) {
+    if ((sensor->config.capability_flags & EZO_CAP_TEMP_COMP) && sensor->config.kind == EZO_KIND_PH) {
         float temp_c = 0.0f;
         esp_err_t ret = ezo_ph_get_temperature_comp(sensor, &temp_c);
         if (ret == ESP_OK) {
@@ -245,6 +513,33 @@ esp_err_t ezo_sensor_refresh_settings(ezo_sensor_t *sensor) {
     return overall;
 }
 
+/**
+ * @brief Add the device handle again on a recreated bus
+ */
+esp_err_t ezo_sensor_attach(ezo_sensor_t *sensor, i2c_master_bus_handle_t bus_handle) {
+    if (sensor == NULL || bus_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (sensor->dev_handle != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    i2c_device_config_t dev_cfg = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = sensor->config.i2c_address,
+        .scl_speed_hz = 100000,
+    };
+
+    esp_err_t ret = i2c_master_bus_add_device(bus_handle, &dev_cfg, &sensor->dev_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to re-add I2C device 0x%02X: %s", sensor->config.i2c_address, esp_err_to_name(ret));
+        sensor->dev_handle = NULL;
+        return ret;
+    }
+    sensor->bus_handle = bus_handle;
+    return ESP_OK;
+}
+
 /**
  * @brief Deinitialize EZO sensor
  */
@@ -273,6 +568,19 @@ esp_err_t ezo_sensor_get_device_info(ezo_sensor_t *sensor) {
         return ESP_ERR_INVALID_ARG;
     }
 
+    esp_err_t ret = ezo_sensor_identify(sensor);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ezo_sensor_query_details(sensor);
+    return ESP_OK;
+}
+
+/**
+ * @brief Query type and firmware ("i") and derive capability flags
+ */
+static esp_err_t ezo_sensor_identify(ezo_sensor_t *sensor) {
     char response[EZO_LARGEST_STRING] = {0};
     
     // Send info command
@@ -286,7 +594,8 @@ esp_err_t ezo_sensor_get_device_info(ezo_sensor_t *sensor) {
     ESP_LOGI(TAG, "Address 0x%02X: Device info response: '%s'", sensor->config.i2c_address, response);
 
     // Parse response: ?I,<type>,<version>
-    char *token = strtok(response, ",");
+    char *token_save = NULL;
+    char *token = strtok_r(response, ",", &token_save);
     int field = 0;
     
     while (token != NULL) {
@@ -302,28 +611,23 @@ esp_err_t ezo_sensor_get_device_info(ezo_sensor_t *sensor) {
             strncpy(sensor->config.firmware_version, token, EZO_MAX_FW_VERSION - 1);
             sensor->config.firmware_version[EZO_MAX_FW_VERSION - 1] = '\0';  // Ensure null termination
         }
-        token = strtok(NULL, ",");
+        token = strtok_r(NULL, ",", &token_save);
         field++;
     }
 
-    // Set capability defaults based on type
-    sensor->config.capability_flags = 0;
-    if (strcmp(sensor->config.type, EZO_TYPE_PH) == 0) {
-        sensor->config.capability_flags = EZO_CAP_CALIBRATION | EZO_CAP_TEMP_COMP |
-                                          EZO_CAP_MODE | EZO_CAP_SLEEP;
-    } else if (strcmp(sensor->config.type, EZO_TYPE_ORP) == 0) {
-        sensor->config.capability_flags = EZO_CAP_CALIBRATION | EZO_CAP_MODE |
-                                          EZO_CAP_SLEEP;
-    } else if (strcmp(sensor->config.type, EZO_TYPE_EC) == 0) {
-        sensor->config.capability_flags = EZO_CAP_CALIBRATION | EZO_CAP_MODE;
-    } else if (strcmp(sensor->config.type, EZO_TYPE_RTD) == 0) {
-        sensor->config.capability_flags = EZO_CAP_CALIBRATION;
-    } else if (strcmp(sensor->config.type, EZO_TYPE_DO) == 0) {
-        sensor->config.capability_flags = EZO_CAP_CALIBRATION | EZO_CAP_MODE;
-    }
+    // Resolve the kind once; everything type-specific is looked up by it from here on
+    sensor->config.kind = ezo_sensor_kind_from_type(sensor->config.type);
+    sensor->config.capability_flags = ezo_sensor_desc(sensor->config.kind)->capabilities;
+
+    return ESP_OK;
+}
 
+/**
+ * @brief Query name, LED, protocol lock and type-specific parameters
+ */
+static void ezo_sensor_query_details(ezo_sensor_t *sensor) {
     // Get sensor name
-    ret = ezo_sensor_get_name(sensor, sensor->config.name, sizeof(sensor->config.name));
+    esp_err_t ret = ezo_sensor_get_name(sensor, sensor->config.name, sizeof(sensor->config.name));
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Failed to get sensor name");
     } else if (sensor->config.name[0] != '\0') {
@@ -343,14 +647,14 @@ esp_err_t ezo_sensor_get_device_info(ezo_sensor_t *sensor) {
     }
 
     // Get sensor-specific parameters
-    if (strcmp(sensor->config.type, EZO_TYPE_RTD) == 0) {
+    if (sensor->config.kind == EZO_KIND_RTD) {
         ezo_rtd_get_scale(sensor, &sensor->config.rtd.temperature_scale);
-    } else if (strcmp(sensor->config.type, EZO_TYPE_PH) == 0) {
+    } else if (sensor->config.kind == EZO_KIND_PH) {
         ezo_ph_get_extended_scale(sensor, &sensor->config.ph.extended_scale);
-    } else if (strcmp(sensor->config.type, EZO_TYPE_EC) == 0) {
+    } else if (sensor->config.kind == EZO_KIND_EC) {
         ezo_ec_get_probe_type(sensor, &sensor->config.ec.probe_type);
         ezo_ec_get_tds_factor(sensor, &sensor->config.ec.tds_conversion_factor);
-    } else if (strcmp(sensor->config.type, EZO_TYPE_HUM) == 0) {
+    } else if (sensor->config.kind == EZO_KIND_HUM) {
         ESP_LOGI(TAG, "Address 0x%02X: Configuring HUM sensor (type verified: '%s')", 
                  sensor->config.i2c_address, sensor->config.type);
         
@@ -367,7 +671,9 @@ esp_err_t ezo_sensor_get_device_info(ezo_sensor_t *sensor) {
             sensor->config.hum.param_t = false;
             sensor->config.hum.param_dew = false;
             
-            char *param_token = strtok(param_response, ",");
+            char *param_token_save = NULL;
+            
+            char *param_token = strtok_r(param_response, ",", &param_token_save);
             int param_field = 0;
             
             while (param_token != NULL && sensor->config.hum.param_count < 4) {
@@ -388,7 +694,7 @@ esp_err_t ezo_sensor_get_device_info(ezo_sensor_t *sensor) {
                     
                     sensor->config.hum.param_count++;
                 }
-                param_token = strtok(NULL, ",");
+                param_token = strtok_r(NULL, ",", &param_token_save);
                 param_field++;
             }
             
@@ -400,8 +706,95 @@ esp_err_t ezo_sensor_get_device_info(ezo_sensor_t *sensor) {
                      sensor->config.i2c_address, esp_err_to_name(ret));
         }
     }
+}
 
-    return ESP_OK;
+static void ezo_identity_cache_key(uint8_t address, char *key, size_t key_size) {
+    snprintf(key, key_size, "id_%02x", address);
+}
+
+/**
+ * @brief Restore cached settings if they belong to the board just identified
+ */
+static bool ezo_identity_cache_load(ezo_sensor_t *sensor) {
+    nvs_handle_t nvs_handle;
+    if (nvs_open(EZO_ID_CACHE_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return false;
+    }
+
+    char key[8];
+    ezo_identity_cache_key(sensor->config.i2c_address, key, sizeof(key));
+
+    ezo_identity_blob_t *blob = malloc(sizeof(ezo_identity_blob_t));
+    if (blob == NULL) {
+        nvs_close(nvs_handle);
+        return false;
+    }
+
+    size_t len = sizeof(ezo_identity_blob_t);
+    esp_err_t ret = nvs_get_blob(nvs_handle, key, blob, &len);
+    nvs_close(nvs_handle);
+
+    bool match = (ret == ESP_OK && len == sizeof(ezo_identity_blob_t) &&
+                  blob->version == EZO_ID_CACHE_VERSION &&
+                  blob->size == sizeof(ezo_sensor_config_t) &&
+                  blob->config.i2c_address == sensor->config.i2c_address &&
+                  strcmp(blob->config.type, sensor->config.type) == 0 &&
+                  strcmp(blob->config.firmware_version, sensor->config.firmware_version) == 0);
+
+    if (match) {
+        const ezo_sensor_config_t *cached = &blob->config;
+        memcpy(sensor->config.name, cached->name, sizeof(sensor->config.name));
+        sensor->config.name[sizeof(sensor->config.name) - 1] = '\0';
+        sensor->config.led_control = cached->led_control;
+        sensor->config.protocol_lock = cached->protocol_lock;
+        sensor->config.ec = cached->ec;
+        sensor->config.rtd = cached->rtd;
+        sensor->config.ph = cached->ph;
+        sensor->config.hum = cached->hum;
+    }
+
+    free(blob);
+    return match;
+}
+
+static void ezo_identity_cache_store(const ezo_sensor_t *sensor) {
+    if (sensor->config.type[0] == '\0') {
+        return;
+    }
+
+    ezo_identity_blob_t *blob = calloc(1, sizeof(ezo_identity_blob_t));
+    if (blob == NULL) {
+        return;
+    }
+    blob->version = EZO_ID_CACHE_VERSION;
+    blob->size = sizeof(ezo_sensor_config_t);
+    blob->config = sensor->config;
+
+    nvs_handle_t nvs_handle;
+    if (nvs_open(EZO_ID_CACHE_NAMESPACE, NVS_READWRITE, &nvs_handle) == ESP_OK) {
+        char key[8];
+        ezo_identity_cache_key(sensor->config.i2c_address, key, sizeof(key));
+        if (nvs_set_blob(nvs_handle, key, blob, sizeof(ezo_identity_blob_t)) == ESP_OK) {
+            nvs_commit(nvs_handle);
+        } else {
+            ESP_LOGW(TAG, "Failed to cache identity for 0x%02X", sensor->config.i2c_address);
+        }
+        nvs_close(nvs_handle);
+    }
+    free(blob);
+}
+
+// Settings the cache cannot mirror (output parameters) force a full query next boot
+static void ezo_identity_cache_invalidate(const ezo_sensor_t *sensor) {
+    nvs_handle_t nvs_handle;
+    if (nvs_open(EZO_ID_CACHE_NAMESPACE, NVS_READWRITE, &nvs_handle) == ESP_OK) {
+        char key[8];
+        ezo_identity_cache_key(sensor->config.i2c_address, key, sizeof(key));
+        if (nvs_erase_key(nvs_handle, key) == ESP_OK) {
+            nvs_commit(nvs_handle);
+        }
+        nvs_close(nvs_handle);
+    }
 }
 
 /**
@@ -420,9 +813,9 @@ esp_err_t ezo_sensor_read(ezo_sensor_t *sensor, float *value) {
     }
 
     // Parse the numeric response
-    *value = atof(response);
+    *value = ezo_parse_float(response);
     
-    ESP_LOGI(TAG, "Sensor 0x%02X read: %.2f", sensor->config.i2c_address, *value);
+    trace_log_emit(TRACE_EV_EZO_READ, sensor->config.i2c_address, 1, trace_arg_float(*value));
     
     return ESP_OK;
 }
@@ -444,11 +837,8 @@ esp_err_t ezo_sensor_read_all(ezo_sensor_t *sensor, float values[4], uint8_t *co
 
     ret = ezo_sensor_parse_values(response, values, count);
     if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "Sensor 0x%02X read %d values: %.2f%s",
-                 sensor->config.i2c_address,
-                 *count,
-                 *count > 0 ? values[0] : 0.0f,
-                 *count > 1 ? ",..." : "");
+        trace_log_emit(TRACE_EV_EZO_READ, sensor->config.i2c_address, *count,
+                       trace_arg_float(*count > 0 ? values[0] : 0.0f));
     }
     return ret;
 }
@@ -492,11 +882,8 @@ esp_err_t ezo_sensor_fetch_all(ezo_sensor_t *sensor, float values[4], uint8_t *c
 
     esp_err_t parse_ret = ezo_sensor_parse_values(response, values, count);
     if (parse_ret == ESP_OK) {
-        ESP_LOGI(TAG, "Sensor 0x%02X fetch %d values: %.2f%s",
-                 sensor->config.i2c_address,
-                 *count,
-                 *count > 0 ? values[0] : 0.0f,
-                 *count > 1 ? ",..." : "");
+        trace_log_emit(TRACE_EV_EZO_READ, sensor->config.i2c_address, *count,
+                       trace_arg_float(*count > 0 ? values[0] : 0.0f));
     }
     return parse_ret;
 }
@@ -574,23 +961,8 @@ esp_err_t ezo_sensor_set_name(ezo_sensor_t *sensor, const char *name) {
         }
     }
 
-    // Pause sensor reading to avoid I2C conflicts
-    extern esp_err_t sensor_manager_pause_reading(void);
-    extern bool sensor_manager_is_reading_in_progress(void);
-    extern esp_err_t sensor_manager_resume_reading(void);
-    
-    sensor_manager_pause_reading();
-    
-    // Wait for any in-progress reading to complete (max 3 seconds)
-    int wait_count = 0;
-    while (sensor_manager_is_reading_in_progress() && wait_count < 30) {
-        vTaskDelay(pdMS_TO_TICKS(100));
-        wait_count++;
-    }
-    
-    if (sensor_manager_is_reading_in_progress()) {
-        ESP_LOGW(TAG, "Timed out waiting for sensor reading to complete");
-    }
+    // Hold the bus for the whole set/verify sequence (nests inside a caller's session)
+    i2c_arbiter_begin(I2C_ARBITER_PRIO_INTERACTIVE, sensor->config.i2c_address);
     
     // Clear any stale data in sensor buffer before setting name
     char dummy[EZO_LARGEST_STRING];
@@ -644,12 +1016,12 @@ esp_err_t ezo_sensor_set_name(ezo_sensor_t *sensor, const char *name) {
             strncpy(sensor->config.name, name, EZO_MAX_SENSOR_NAME - 1);
             sensor->config.name[EZO_MAX_SENSOR_NAME - 1] = '\0';
         }
+        ezo_identity_cache_store(sensor);
     } else {
         ESP_LOGE(TAG, "Failed to set sensor name: %s", esp_err_to_name(ret));
     }
     
-    // Resume sensor reading
-    sensor_manager_resume_reading();
+    i2c_arbiter_end();
     
     return ret;
 }
@@ -670,9 +1042,10 @@ esp_err_t ezo_sensor_get_led(ezo_sensor_t *sensor, bool *enabled) {
     }
 
     // Parse response: ?L,<0|1>
-    char *token = strtok(response, ",");
+    char *token_save = NULL;
+    char *token = strtok_r(response, ",", &token_save);
     if (token != NULL && strcmp(token, "?L") == 0) {
-        token = strtok(NULL, ",");
+        token = strtok_r(NULL, ",", &token_save);
         if (token != NULL) {
             *enabled = (atoi(token) == 1);
         }
@@ -694,6 +1067,7 @@ esp_err_t ezo_sensor_set_led(ezo_sensor_t *sensor, bool enabled) {
     esp_err_t ret = ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
     if (ret == ESP_OK) {
         sensor->config.led_control = enabled;
+        ezo_identity_cache_store(sensor);
     }
     
     return ret;
@@ -715,9 +1089,10 @@ esp_err_t ezo_sensor_get_plock(ezo_sensor_t *sensor, bool *locked) {
     }
 
     // Parse response: ?Plock,<0|1>
-    char *token = strtok(response, ",");
+    char *token_save = NULL;
+    char *token = strtok_r(response, ",", &token_save);
     if (token != NULL && strcmp(token, "?Plock") == 0) {
-        token = strtok(NULL, ",");
+        token = strtok_r(NULL, ",", &token_save);
         if (token != NULL) {
             *locked = (atoi(token) == 1);
         }
@@ -739,6 +1114,7 @@ esp_err_t ezo_sensor_set_plock(ezo_sensor_t *sensor, bool locked) {
     esp_err_t ret = ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
     if (ret == ESP_OK) {
         sensor->config.protocol_lock = locked;
+        ezo_identity_cache_store(sensor);
     }
     
     return ret;
@@ -754,6 +1130,7 @@ esp_err_t ezo_sensor_factory_reset(ezo_sensor_t *sensor) {
 
     ESP_LOGW(TAG, "Factory resetting sensor at 0x%02X", sensor->config.i2c_address);
     
+    ezo_identity_cache_invalidate(sensor);
     return ezo_sensor_send_command(sensor, "Factory", NULL, 0, EZO_SHORT_WAIT_MS);
 }
 
@@ -771,6 +1148,7 @@ esp_err_t ezo_sensor_change_i2c_address(ezo_sensor_t *sensor, uint8_t new_addres
     ESP_LOGW(TAG, "Changing I2C address from 0x%02X to 0x%02X (device will reboot)", 
              sensor->config.i2c_address, new_address);
     
+    ezo_identity_cache_invalidate(sensor);
     return ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
 }
 
@@ -788,11 +1166,12 @@ esp_err_t ezo_ec_get_probe_type(ezo_sensor_t *sensor, float *probe_type) {
     }
 
     // Parse response: ?K,<value>
-    char *token = strtok(response, ",");
+    char *token_save = NULL;
+    char *token = strtok_r(response, ",", &token_save);
     if (token != NULL && strcmp(token, "?K") == 0) {
-        token = strtok(NULL, ",");
+        token = strtok_r(NULL, ",", &token_save);
         if (token != NULL) {
-            *probe_type = atof(token);
+            *probe_type = ezo_parse_float(token);
         }
     }
 
@@ -810,6 +1189,7 @@ esp_err_t ezo_ec_set_probe_type(ezo_sensor_t *sensor, float probe_type) {
     esp_err_t ret = ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
     if (ret == ESP_OK) {
         sensor->config.ec.probe_type = probe_type;
+        ezo_identity_cache_store(sensor);
     }
     
     return ret;
@@ -828,11 +1208,12 @@ esp_err_t ezo_ec_get_tds_factor(ezo_sensor_t *sensor, float *factor) {
     }
 
     // Parse response: ?TDS,<value>
-    char *token = strtok(response, ",");
+    char *token_save = NULL;
+    char *token = strtok_r(response, ",", &token_save);
     if (token != NULL && strcmp(token, "?TDS") == 0) {
-        token = strtok(NULL, ",");
+        token = strtok_r(NULL, ",", &token_save);
         if (token != NULL) {
-            *factor = atof(token);
+            *factor = ezo_parse_float(token);
         }
     }
 
@@ -850,6 +1231,7 @@ esp_err_t ezo_ec_set_tds_factor(ezo_sensor_t *sensor, float factor) {
     esp_err_t ret = ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
     if (ret == ESP_OK) {
         sensor->config.ec.tds_conversion_factor = factor;
+        ezo_identity_cache_store(sensor);
     }
     
     return ret;
@@ -863,7 +1245,11 @@ esp_err_t ezo_ec_set_output_parameter(ezo_sensor_t *sensor, const char *param, b
     char command[16];
     snprintf(command, sizeof(command), "O,%s,%d", param, enabled ? 1 : 0);
     
-    return ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
+    esp_err_t ret = ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
+    if (ret == ESP_OK) {
+        ezo_identity_cache_invalidate(sensor);
+    }
+    return ret;
 }
 
 // RTD-specific functions
@@ -880,9 +1266,10 @@ esp_err_t ezo_rtd_get_scale(ezo_sensor_t *sensor, char *scale) {
     }
 
     // Parse response: ?S,<scale>
-    char *token = strtok(response, ",");
+    char *token_save = NULL;
+    char *token = strtok_r(response, ",", &token_save);
     if (token != NULL && strcmp(token, "?S") == 0) {
-        token = strtok(NULL, ",");
+        token = strtok_r(NULL, ",", &token_save);
         if (token != NULL && strlen(token) > 0) {
             *scale = token[0];
         }
@@ -902,6 +1289,7 @@ esp_err_t ezo_rtd_set_scale(ezo_sensor_t *sensor, char scale) {
     esp_err_t ret = ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
     if (ret == ESP_OK) {
         sensor->config.rtd.temperature_scale = scale;
+        ezo_identity_cache_store(sensor);
     }
     
     return ret;
@@ -921,9 +1309,10 @@ esp_err_t ezo_ph_get_extended_scale(ezo_sensor_t *sensor, bool *enabled) {
     }
 
     // Parse response: ?pHext,<0|1>
-    char *token = strtok(response, ",");
+    char *token_save = NULL;
+    char *token = strtok_r(response, ",", &token_save);
     if (token != NULL && strcmp(token, "?pHext") == 0) {
-        token = strtok(NULL, ",");
+        token = strtok_r(NULL, ",", &token_save);
         if (token != NULL) {
             *enabled = (atoi(token) == 1);
         }
@@ -943,6 +1332,7 @@ esp_err_t ezo_ph_set_extended_scale(ezo_sensor_t *sensor, bool enabled) {
     esp_err_t ret = ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
     if (ret == ESP_OK) {
         sensor->config.ph.extended_scale = enabled;
+        ezo_identity_cache_store(sensor);
     }
     
     return ret;
@@ -1067,11 +1457,13 @@ esp_err_t ezo_ph_get_temperature_comp(ezo_sensor_t *sensor, float *temperature_c
         return ret;
     }
 
-    char *token = strtok(response, ",");
+    char *token_save = NULL;
+
+    char *token = strtok_r(response, ",", &token_save);
     if (token != NULL && strcmp(token, "?T") == 0) {
-        token = strtok(NULL, ",");
+        token = strtok_r(NULL, ",", &token_save);
         if (token != NULL) {
-            *temperature_c = atof(token);
+            *temperature_c = ezo_parse_float(token);
             sensor->config.temp_compensation = *temperature_c;
             sensor->config.temp_comp_valid = true;
             return ESP_OK;
@@ -1128,9 +1520,11 @@ esp_err_t ezo_sensor_get_continuous_mode(ezo_sensor_t *sensor, bool *enabled) {
         return ret;
     }
 
-    char *token = strtok(response, ",");
+    char *token_save = NULL;
+
+    char *token = strtok_r(response, ",", &token_save);
     if (token != NULL && strcmp(token, "?C") == 0) {
-        token = strtok(NULL, ",");
+        token = strtok_r(NULL, ",", &token_save);
         if (token != NULL) {
             *enabled = (atoi(token) == 1);
             sensor->config.continuous_mode = *enabled;
@@ -1179,7 +1573,11 @@ esp_err_t ezo_rtd_set_output_parameter(ezo_sensor_t *sensor, const char *param,
     char command[32];
     snprintf(command, sizeof(command), "O,%s,%d", param, enabled ? 1 : 0);
     
-    return ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
+    esp_err_t ret = ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
+    if (ret == ESP_OK) {
+        ezo_identity_cache_invalidate(sensor);
+    }
+    return ret;
 }
 
 esp_err_t ezo_hum_set_output_parameter(ezo_sensor_t *sensor, const char *param, bool enabled) {
@@ -1190,7 +1588,11 @@ esp_err_t ezo_hum_set_output_parameter(ezo_sensor_t *sensor, const char *param,
     char command[32];
     snprintf(command, sizeof(command), "O,%s,%d", param, enabled ? 1 : 0);
     
-    return ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
+    esp_err_t ret = ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
+    if (ret == ESP_OK) {
+        ezo_identity_cache_invalidate(sensor);
+    }
+    return ret;
 }
 
 esp_err_t ezo_ph_set_output_parameter(ezo_sensor_t *sensor, const char *param, bool enabled) {
@@ -1201,7 +1603,11 @@ esp_err_t ezo_ph_set_output_parameter(ezo_sensor_t *sensor, const char *param, b
     char command[32];
     snprintf(command, sizeof(command), "O,%s,%d", param, enabled ? 1 : 0);
     
-    return ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
+    esp_err_t ret = ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
+    if (ret == ESP_OK) {
+        ezo_identity_cache_invalidate(sensor);
+    }
+    return ret;
 }
 
 esp_err_t ezo_do_set_output_parameter(ezo_sensor_t *sensor, const char *param, bool enabled) {
@@ -1212,7 +1618,11 @@ esp_err_t ezo_do_set_output_parameter(ezo_sensor_t *sensor, const char *param, b
     char command[32];
     snprintf(command, sizeof(command), "O,%s,%d", param, enabled ? 1 : 0);
     
-    return ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
+    esp_err_t ret = ezo_sensor_send_command(sensor, command, NULL, 0, EZO_SHORT_WAIT_MS);
+    if (ret == ESP_OK) {
+        ezo_identity_cache_invalidate(sensor);
+    }
+    return ret;
 }
 
 esp_err_t ezo_sensor_get_output_config(ezo_sensor_t *sensor, char *config, size_t config_size) {
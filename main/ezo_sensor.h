@@ -35,6 +35,39 @@ extern "C" {
 #define EZO_CAP_MODE            (1U << 3)
 #define EZO_CAP_OFFSET          (1U << 4)
 
+/**
+ * @brief Sensor kind, resolved from the type string once when a board is identified
+ */
+typedef enum {
+    EZO_KIND_UNKNOWN = 0,
+    EZO_KIND_RTD,
+    EZO_KIND_PH,
+    EZO_KIND_EC,
+    EZO_KIND_DO,
+    EZO_KIND_ORP,
+    EZO_KIND_HUM,
+    EZO_KIND_COUNT
+} ezo_sensor_kind_t;
+
+#define EZO_MAX_CHANNELS        4       // Values one reading can carry
+#define EZO_CHANNEL_NONE        0xFF    // Value without a known channel
+
+/**
+ * @brief Constant description of a sensor kind
+ *
+ * Channels are listed in the board's default output order; a board with
+ * outputs disabled maps its values onto them (ezo_sensor_config_t.channels).
+ */
+typedef struct {
+    const char *type;                           // Type string reported by "i"
+    const char *channels[EZO_MAX_CHANNELS];     // Telemetry field of each channel (NULL: none)
+    const char *units[EZO_MAX_CHANNELS];
+    uint8_t channel_count;
+    uint16_t conversion_ms;                     // Worst-case time of one reading
+    bool temp_comp;                             // Readings are taken with the RTD temperature
+    uint32_t capabilities;                      // Default EZO_CAP_* flags
+} ezo_sensor_desc_t;
+
 // Timing constants (in milliseconds)
 #define EZO_SHORT_WAIT_MS       300     // Short delay for simple commands
 #define EZO_LONG_WAIT_MS        5000    // Long delay for readings
@@ -64,6 +97,8 @@ typedef struct {
     bool temp_comp_valid;                       // Whether temp_compensation is valid
     char calibration_status[32];               // Cached calibration status string
     bool calibration_status_valid;             // Calibration status cache state
+    uint8_t kind;                               // ezo_sensor_kind_t of type
+    uint8_t channels[EZO_MAX_CHANNELS];         // Descriptor channel of each value (EZO_CHANNEL_NONE past the last)
     
     // EC-specific parameters
     struct {
@@ -104,9 +139,29 @@ typedef struct {
     ezo_sensor_config_t config;                 // Sensor configuration
 } ezo_sensor_t;
 
+/**
+ * @brief Kind of a type string (EZO_KIND_UNKNOWN if not recognized)
+ */
+ezo_sensor_kind_t ezo_sensor_kind_from_type(const char *type);
+
+/**
+ * @brief Descriptor of a kind; the EZO_KIND_UNKNOWN entry for out-of-range kinds
+ */
+const ezo_sensor_desc_t *ezo_sensor_desc(uint8_t kind);
+
+/**
+ * @brief Telemetry field name of a descriptor channel, NULL if it has none
+ */
+const char *ezo_sensor_channel_name(uint8_t kind, uint8_t channel);
+
 /**
  * @brief Initialize an EZO sensor
  * 
+ * Identifies the board with "i". If type and firmware match the settings
+ * cached in NVS from a previous boot, those are reused; otherwise the full
+ * settings query runs and the cache is refreshed. Safe to call concurrently
+ * for different boards on the same bus.
+ * 
  * @param sensor Pointer to EZO sensor handle
  * @param bus_handle I2C bus handle
  * @param i2c_address I2C address of the sensor
@@ -114,6 +169,19 @@ typedef struct {
  */
 esp_err_t ezo_sensor_init(ezo_sensor_t *sensor, i2c_master_bus_handle_t bus_handle, uint8_t i2c_address);
 
+/**
+ * @brief Attach an initialized sensor to a recreated bus
+ * 
+ * Used after i2c_scanner_recover_bus(): the device handle removed with
+ * ezo_sensor_deinit() is added to the new bus. Identity and settings are
+ * kept, the board is not queried.
+ * 
+ * @param sensor Pointer to EZO sensor handle (deinitialized)
+ * @param bus_handle New I2C bus handle
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if still attached
+ */
+esp_err_t ezo_sensor_attach(ezo_sensor_t *sensor, i2c_master_bus_handle_t bus_handle);
+
 /**
  * @brief Deinitialize an EZO sensor
  * 
@@ -181,9 +249,30 @@ esp_err_t ezo_sensor_start_read_with_temp(ezo_sensor_t *sensor, float temp_celsi
 
 /**
  * @brief Fetch readings after a prior ezo_sensor_start_read().
+ *
+ * Returns ESP_ERR_NOT_FINISHED while the board is still converting (status 0xFE),
+ * so it can be called repeatedly to poll for completion.
  */
 esp_err_t ezo_sensor_fetch_all(ezo_sensor_t *sensor, float values[4], uint8_t *count);
 
+/**
+ * @brief Parse a comma-separated EZO reading
+ *
+ * Reentrant and allocation-free; the response is not modified. Numeric fields
+ * are packed into values[] in order and other fields (labels such as "Dew")
+ * are skipped. Decimal fields are parsed in fixed point, so no libc float
+ * parsing is needed.
+ *
+ * @param response Response text (NUL-terminated or len bytes)
+ * @param len Maximum number of bytes to examine
+ * @param values Array to store up to 4 values
+ * @param count Pointer to store number of values parsed
+ * @param valid_mask Optional; bit n is set when values[n] parsed without trailing garbage
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_RESPONSE for *ER, *OV or *UV markers
+ */
+esp_err_t ezo_parse_reading(const char *response, size_t len, float values[4], uint8_t *count,
+                            uint8_t *valid_mask);
+
 /**
  * @brief Get sensor name
  * 
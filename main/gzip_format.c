@@ -0,0 +1,66 @@
+/**
+ * @file gzip_format.c
+ * @brief RFC 1952 gzip header and trailer parsing
+ */
+
+#include "gzip_format.h"
+
+#define GZIP_ID1        0x1f
+#define GZIP_ID2        0x8b
+#define GZIP_CM_DEFLATE 8
+#define GZIP_FHCRC      0x02
+#define GZIP_FEXTRA     0x04
+#define GZIP_FNAME      0x08
+#define GZIP_FCOMMENT   0x10
+
+static uint32_t gzip_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+size_t gzip_header_len(const uint8_t *data, size_t len)
+{
+    if (data == NULL || len < GZIP_HEADER_MIN ||
+        data[0] != GZIP_ID1 || data[1] != GZIP_ID2 || data[2] != GZIP_CM_DEFLATE) {
+        return 0;
+    }
+    uint8_t flags = data[3];
+    size_t pos = GZIP_HEADER_MIN;
+    if (flags & GZIP_FEXTRA) {
+        if (pos + 2 > len) {
+            return 0;
+        }
+        pos += 2 + (data[pos] | (data[pos + 1] << 8));
+    }
+    for (int field = 0; field < 2; field++) {
+        uint8_t bit = field == 0 ? GZIP_FNAME : GZIP_FCOMMENT;
+        if (flags & bit) {
+            while (pos < len && data[pos] != 0) {
+                pos++;
+            }
+            pos++;
+        }
+    }
+    if (flags & GZIP_FHCRC) {
+        pos += 2;
+    }
+    return pos < len ? pos : 0;
+}
+
+void gzip_read_trailer(const uint8_t *trailer, uint32_t *crc, uint32_t *isize)
+{
+    if (crc != NULL) {
+        *crc = gzip_le32(trailer);
+    }
+    if (isize != NULL) {
+        *isize = gzip_le32(trailer + 4);
+    }
+}
+
+bool gzip_trailer_matches(const uint8_t *trailer, uint32_t crc, size_t size)
+{
+    uint32_t expect_crc;
+    uint32_t expect_isize;
+    gzip_read_trailer(trailer, &expect_crc, &expect_isize);
+    return crc == expect_crc && (uint32_t)size == expect_isize;
+}
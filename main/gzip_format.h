@@ -0,0 +1,48 @@
+/**
+ * @file gzip_format.h
+ * @brief RFC 1952 gzip member framing shared by the OTA and web asset paths
+ *
+ * Only the framing lives here: the deflate body is inflated by the caller
+ * with the ROM miniz, which works in chunks for OTA and in one call for
+ * the web editor.
+ */
+
+#ifndef GZIP_FORMAT_H
+#define GZIP_FORMAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define GZIP_HEADER_MIN     10
+#define GZIP_TRAILER_SIZE   8       // CRC32 and ISIZE, little-endian
+
+/**
+ * @brief Length of the gzip header at the start of a buffer
+ *
+ * Checks the magic and the deflate method, then skips the optional extra,
+ * name, comment and header CRC fields.
+ *
+ * @return Header length, or 0 if it is malformed or does not end inside the buffer
+ */
+size_t gzip_header_len(const uint8_t *data, size_t len);
+
+/**
+ * @brief Decode the 8-byte trailer
+ *
+ * @param trailer GZIP_TRAILER_SIZE bytes following the deflate stream
+ * @param[out] crc  CRC32 of the uncompressed data (may be NULL)
+ * @param[out] isize Uncompressed length modulo 2^32 (may be NULL)
+ */
+void gzip_read_trailer(const uint8_t *trailer, uint32_t *crc, uint32_t *isize);
+
+/**
+ * @brief Check inflated output against the trailer
+ *
+ * @param crc  CRC32 (esp_rom_crc32_le, seed 0) of the inflated data
+ * @param size Number of bytes inflated
+ * @return true if both the CRC and the length match
+ */
+bool gzip_trailer_matches(const uint8_t *trailer, uint32_t crc, size_t size);
+
+#endif // GZIP_FORMAT_H
@@ -16,6 +16,8 @@ static const char *TAG = "HTTP_SERVER";
 #include "time_sync.h"
 #include "api_key_manager.h"
 #include "web_file_editor.h"
+#include "json_writer.h"
+#include "telemetry_codec.h"
 #include "esp_https_server.h"
 #include "esp_heap_caps.h"
 #include "esp_timer.h"
@@ -29,13 +31,15 @@ static const char *TAG = "HTTP_SERVER";
 #include "nvs.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <math.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <unistd.h>
 
 static httpd_handle_t s_server = NULL;
 
-#define OTA_UPLOAD_BUFFER_SIZE 4096
-
 // External sensor reading functions from mqtt_telemetry.c
 extern float read_temperature(void);
 extern float read_humidity(void);
@@ -45,14 +49,35 @@ extern float read_battery_level(void);
 
 // Sensor manager functions
 #include "sensor_manager.h"
+#include "signal_filter.h"
+#include "calib_stability.h"
+#include "sensor_jobs.h"
+#include "alarm_rules.h"
 #include "ezo_sensor.h"
 #include "ezo_sensor.h"
 #include "max17048.h"
+#include "i2c_arbiter.h"
+#include "i2c_scanner.h"
+#include "sensor_history.h"
 #include "mqtt_telemetry.h"  // For MAX_SENSOR_VALUES
+#include "telemetry_log.h"
+#include "power_manager.h"
+#include "ota_pipeline.h"
+#include "perf_monitor.h"
+#include "mem_monitor.h"
+#include "lan_poll.h"
+#include "task_profile.h"
+#include "json_arena.h"
+#include "data_bench.h"
+#ifdef CONFIG_KC_EZO_EMULATOR
+#include "ezo_emulator.h"
+#endif
+#include "boot_profile.h"
+#include "trace_log.h"
 
 // Declare embedded web files (generated by CMake)
-extern const uint8_t index_html_start[] asm("_binary_index_html_start");
-extern const uint8_t index_html_end[]   asm("_binary_index_html_end");
+extern const uint8_t index_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t index_html_gz_end[]   asm("_binary_index_html_gz_end");
 
 #define SENSOR_CALIBRATE_URI   "/api/sensors/calibrate/"
 #define SENSOR_COMP_URI        "/api/sensors/compensate/"
@@ -61,145 +86,366 @@ extern const uint8_t index_html_end[]   asm("_binary_index_html_end");
 #define SENSOR_STATUS_URI      "/api/sensors/status/"
 #define SENSOR_SAMPLE_URI      "/api/sensors/sample/"
 #define SENSOR_WS_URI          "/ws/sensors"
+#define SENSOR_JOB_URI         "/api/jobs/"
 
 #define SENSOR_WS_MAX_CLIENTS  4
-#define FOCUS_SAMPLE_INTERVAL_MS 2500
+#define SENSOR_WS_FRAME_POOL   6          // Shared outgoing frames across all clients
+#define SENSOR_WS_CLIENT_QUEUE 3          // Frames a slow client may have pending
+
+// Binary live-data protocol, selected per client with {"action":"set_protocol","protocol":"binary"}.
+// Frame: kind (u8), flags (u8), sequence (u16, status frames), timestamp_ms (u64), then:
+//   status keyframe: rssi (i8), battery (f32, NaN if unknown), sensor count (u8),
+//                    per sensor: slot (u8) + key (u8 length + bytes, as in the JSON "sensors" object)
+//                    + sensor record
+//   status delta:    rssi (i8), battery (f32), change count (u8), per change: channel (u8) + value (f32)
+//   focus sample:    address (u8) + sensor record
+// Sensor record: type (u8 length + bytes), value count (u8), per value: name (u8 length + bytes) + f32.
+// Channel = slot << 2 | value index. Multi-byte fields are little-endian.
+#define SENSOR_WS_BIN_VERSION       2       // 2: keyframe sensors carry their key
+#define SENSOR_WS_BIN_STATUS        0x01
+#define SENSOR_WS_BIN_FOCUS_SAMPLE  0x02
+#define SENSOR_WS_BIN_FLAG_KEY      0x01    // Full state; deltas follow from its sequence number
+#define SENSOR_WS_BIN_KEY_INTERVAL  30      // Deltas between unsolicited keyframes
+
+// Device status pushed to WebSocket clients, replacing dashboard polling of /api/status
+#define SENSOR_WS_STATUS_CHECK_MS      2000    // Compare pushed fields this often
+#define SENSOR_WS_STATUS_HEARTBEAT_MS  30000   // Full message even when nothing changed
+#define SENSOR_WS_STATUS_RSSI_STEP     3       // dB
+#define SENSOR_WS_STATUS_HEAP_STEP     4096    // Bytes of free heap
+#define SENSOR_WS_STATUS_CPU_STEP      5       // Percentage points of CPU load
+
+#define FOCUS_SAMPLE_INTERVAL_MS 2500     // Triggered mode: one R conversion per period
+#define FOCUS_STREAM_INTERVAL_MS 1000     // Continuous mode: board's native output rate
+#define FOCUS_QUEUE_DEPTH        8        // Power of two
+
+#define SENSOR_INTERACTIVE_POLL_MS 100
+#define SENSOR_WS_FRAME_SIZE       1536
+#define HTTP_JSON_CHUNK_SIZE       512
+#define HTTP_JSON_BODY_MAX         2048     // Largest JSON request body accepted
+#define SENSOR_JOB_RESULT_SIZE     1024     // Sensor JSON kept with a finished job
+#define PERF_BENCH_IDLE_WAIT_MS    5000     // Longest wait for a reading cycle to end before a benchmark
+#define HTTP_UPLOAD_CHUNK_SIZE     2048     // Web file PUT bodies are streamed through this
+
+#define HTTP_MAX_OPEN_SOCKETS      3        // TLS sessions use internal RAM (~20 KB each)
+#define HTTP_API_KEEPALIVE_MS      30000    // Longest an API session may hold its slot
+#define HTTP_BUDGET_SWEEP_MS       5000
 
 typedef struct {
-    bool should_resume;
-    bool mutex_acquired;
+    bool begun;                     // i2c_arbiter_end() still owed
 } sensor_read_guard_t;
 
-static SemaphoreHandle_t s_sensor_guard_mutex = NULL;
+// Outgoing WebSocket frame, serialized once and shared by every client it is queued for
+typedef struct {
+    atomic_uint refs;       // Producer while filling, plus one per client queue holding it
+    bool status;            // Status snapshot: superseded by a newer one if still unsent
+    bool binary;            // Sent as a binary frame (binary protocol clients only)
+    size_t len;
+    char *data;             // SENSOR_WS_FRAME_SIZE bytes
+} ws_frame_t;
 
 typedef struct {
     int fd;
     bool active;
+    bool send_scheduled;                        // ws_send_work_cb queued for this slot
+    bool binary;                                // Negotiated the binary live-data protocol
+    uint8_t queued;
+    ws_frame_t *queue[SENSOR_WS_CLIENT_QUEUE];  // Pending frames, oldest first
 } sensor_ws_client_t;
 
-static sensor_ws_client_t s_ws_clients[SENSOR_WS_MAX_CLIENTS];
+static sensor_ws_client_t s_ws_clients[SENSOR_WS_MAX_CLIENTS];   // Guarded by s_ws_clients_mutex
 static SemaphoreHandle_t s_ws_clients_mutex = NULL;
+static ws_frame_t s_ws_frames[SENSOR_WS_FRAME_POOL];
+
+typedef enum {
+    WS_AUDIENCE_ALL,        // Control messages, understood by every client
+    WS_AUDIENCE_JSON,
+    WS_AUDIENCE_BINARY,
+} ws_audience_t;
+
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t cap;
+    bool overflow;
+} ws_bin_writer_t;
+
+// Binary delta state shared by all binary clients (s_ws_bin_mutex)
+static SemaphoreHandle_t s_ws_bin_mutex = NULL;
+static sensor_cache_t s_ws_bin_prev;                // State the next delta is relative to
+static bool s_ws_bin_prev_valid = false;
+static uint16_t s_ws_bin_seq = 0;
+static uint8_t s_ws_bin_since_key = 0;
+
+typedef struct {
+    bool valid;
+    bool wifi_connected;
+    bool mqtt_connected;
+    bool time_synced;
+    bool rssi_valid;
+    int rssi;
+    int cpu_usage;          // -1 until the profiler has a window
+    uint32_t free_heap;
+    int64_t last_full_us;
+} ws_status_push_t;
+
+static ws_status_push_t s_status_push;             // Last broadcast values (httpd task)
+static esp_timer_handle_t s_status_timer = NULL;
+static atomic_bool s_status_work_queued = false;
+
+typedef struct {
+    int fd;                 // -1 when the slot is free
+    int64_t opened_us;
+} http_session_t;
+
+typedef struct {
+    uint32_t handshakes;            // Completed, full or resumed
+    uint32_t handshakes_started;    // ClientHello seen (certificate select hook)
+    uint32_t handshakes_timed;
+    uint32_t handshake_last_ms;
+    uint32_t handshake_max_ms;
+    uint64_t handshake_total_ms;
+    uint32_t budget_closes;         // API sessions closed to keep a slot free
+    uint32_t keepalive_closes;      // API sessions retired by HTTP_API_KEEPALIVE_MS
+} http_conn_stats_t;
+
+// Connection budget state, only touched from the httpd task
+static http_session_t s_http_sessions[HTTP_MAX_OPEN_SOCKETS];
+static http_conn_stats_t s_http_stats;
+static int64_t s_http_handshake_start_us = 0;
+static esp_timer_handle_t s_http_budget_timer = NULL;
+static atomic_bool s_http_sweep_queued = false;
 static esp_timer_handle_t s_focus_timer = NULL;
 static bool s_focus_stream_active = false;
 static uint8_t s_focus_sensor_address = 0;
-static bool s_focus_paused_readings = false;
+static bool s_focus_continuous = false;          // Board streams on its own, only read output
+static bool s_focus_restore_continuous = false;  // Continuous mode was enabled by the focus stream
+static bool s_focus_triggered = false;           // Triggered mode: a conversion is pending
+
+typedef struct {
+    uint64_t timestamp_ms;
+    float values[4];
+    uint8_t address;
+    uint8_t count;
+} focus_sample_t;
+
+// Single-producer (arbiter task) / single-consumer (httpd task) sample ring
+static focus_sample_t s_focus_queue[FOCUS_QUEUE_DEPTH];
+static atomic_uint s_focus_queue_head = 0;
+static atomic_uint s_focus_queue_tail = 0;
+static atomic_bool s_focus_fetch_pending = false;
+static atomic_bool s_focus_drain_queued = false;
 
-static void sensor_read_guard_acquire(sensor_read_guard_t *guard);
+static void sensor_read_guard_acquire(sensor_read_guard_t *guard, uint8_t address);
 static void sensor_read_guard_release(sensor_read_guard_t *guard);
 static void handle_sensor_cache_update(const sensor_cache_t *cache, void *ctx);
-static cJSON *create_sensors_object_from_cache(const sensor_cache_t *cache);
-static void sensor_ws_broadcast_json(const char *json, size_t len);
+static void sensor_ws_broadcast_cjson(cJSON *root);
 static void sensor_ws_send_status_event(const sensor_cache_t *cache);
-static void sensor_ws_send_focus_sample(ezo_sensor_t *sensor, const float *values, uint8_t count);
+static void sensor_ws_send_focus_sample(ezo_sensor_t *sensor, const float *values, uint8_t count,
+                                        uint64_t timestamp_ms);
 static void sensor_ws_send_focus_status(const char *status, uint8_t address);
 static esp_err_t sensor_ws_handler(httpd_req_t *req);
 static void handle_ws_command(int client_fd, const char *payload, size_t len);
 static void focus_timer_cb(void *arg);
-static void focus_stream_sample_now(void);
 static esp_err_t focus_stream_start(uint8_t address);
 static void focus_stream_stop(void);
+static void calib_session_start(cJSON *root);
+static void calib_session_commit(cJSON *root);
+static void calib_session_end(const char *state, const char *error);
+static void calib_session_on_sample(const focus_sample_t *sample);
 static void sensor_ws_remove_client(int fd);
-static cJSON *build_sensor_json(ezo_sensor_t *sensor, int index, bool include_runtime);
-static void add_sample_readings_to_json(cJSON *json, const char *type, const float values[], uint8_t count);
+static void sensor_ws_status_push_enable(bool enable);
+static void http_write_connection_stats(json_writer_t *w);
+static void write_sensor_json(json_writer_t *w, const ezo_sensor_t *sensor, int index, bool include_runtime,
+                              const float *values, uint8_t count, uint64_t timestamp_ms);
 static ezo_sensor_t *find_sensor_by_address(uint8_t address);
+static esp_err_t sensor_interactive_read(ezo_sensor_t *sensor, float values[4], uint8_t *count);
 
-static void sensor_read_guard_acquire(sensor_read_guard_t *guard)
+static void sensor_read_guard_acquire(sensor_read_guard_t *guard, uint8_t address)
 {
     if (guard == NULL) {
         return;
     }
 
-    guard->mutex_acquired = false;
-    // Ensure we serialize all manual sensor read operations
-    if (s_sensor_guard_mutex == NULL) {
-        s_sensor_guard_mutex = xSemaphoreCreateMutex();
-        if (s_sensor_guard_mutex == NULL) {
-            ESP_LOGE(TAG, "Failed to create sensor guard mutex");
-        }
+    // Interactive sessions are granted ahead of queued background work; a
+    // reading the background task had pending on this board is discarded
+    esp_err_t ret = i2c_arbiter_begin(I2C_ARBITER_PRIO_INTERACTIVE, address);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to acquire I2C bus for 0x%02X: %s", address, esp_err_to_name(ret));
     }
+    // Ended even when refused, so an enclosing session keeps its depth
+    guard->begun = true;
+}
 
-    if (s_sensor_guard_mutex != NULL) {
-        if (xSemaphoreTake(s_sensor_guard_mutex, portMAX_DELAY) == pdTRUE) {
-            guard->mutex_acquired = true;
-        } else {
-            ESP_LOGW(TAG, "Failed to acquire sensor guard mutex");
-            guard->mutex_acquired = false;
-        }
+static void sensor_read_guard_release(sensor_read_guard_t *guard)
+{
+    if (guard == NULL) {
+        return;
     }
 
-    guard->should_resume = false;
+    if (guard->begun) {
+        i2c_arbiter_end();
+        guard->begun = false;
+    }
+}
 
-    bool already_paused = sensor_manager_is_reading_paused();
-    if (!already_paused) {
-        if (sensor_manager_pause_reading() == ESP_OK) {
-            guard->should_resume = true;
-        } else {
-            ESP_LOGW(TAG, "Failed to pause sensor reading task before action");
-        }
+/**
+ * @brief Take a fresh reading without holding the bus during the conversion
+ *
+ * The trigger and each status poll run in short interactive sessions, so
+ * background acquisition of other boards continues while this one converts.
+ */
+static esp_err_t sensor_interactive_read(ezo_sensor_t *sensor, float values[4], uint8_t *count)
+{
+    sensor_read_guard_t guard;
+    sensor_read_guard_acquire(&guard, sensor->config.i2c_address);
+    esp_err_t ret = ezo_sensor_start_read(sensor);
+    sensor_read_guard_release(&guard);
+    if (ret != ESP_OK) {
+        return ret;
     }
 
-    const TickType_t timeout_ticks = pdMS_TO_TICKS(EZO_LONG_WAIT_MS + 2000);
-    TickType_t start = xTaskGetTickCount();
-    while (sensor_manager_is_reading_in_progress()) {
-        if ((xTaskGetTickCount() - start) > timeout_ticks) {
-            ESP_LOGW(TAG, "Timeout waiting for sensor reading task to idle");
-            break;
+    uint32_t waited_ms = 0;
+    do {
+        vTaskDelay(pdMS_TO_TICKS(SENSOR_INTERACTIVE_POLL_MS));
+        waited_ms += SENSOR_INTERACTIVE_POLL_MS;
+
+        sensor_read_guard_acquire(&guard, sensor->config.i2c_address);
+        ret = ezo_sensor_fetch_all(sensor, values, count);
+        sensor_read_guard_release(&guard);
+    } while (ret == ESP_ERR_NOT_FINISHED && waited_ms < EZO_LONG_WAIT_MS);
+
+    return ret;
+}
+
+/**
+ * @brief Take a free frame from the pool, holding the producer reference
+ *
+ * @return Frame to fill, or NULL if every frame is still queued somewhere
+ */
+static ws_frame_t *ws_frame_acquire(bool status)
+{
+    for (int i = 0; i < SENSOR_WS_FRAME_POOL; i++) {
+        ws_frame_t *frame = &s_ws_frames[i];
+        unsigned expected = 0;
+        if (frame->data != NULL &&
+            atomic_compare_exchange_strong(&frame->refs, &expected, 1)) {
+            frame->status = status;
+            frame->binary = false;
+            frame->len = 0;
+            return frame;
         }
-        vTaskDelay(pdMS_TO_TICKS(50));
     }
+    ESP_LOGD(TAG, "WS frame pool exhausted, dropping frame");
+    return NULL;
 }
 
-static void sensor_read_guard_release(sensor_read_guard_t *guard)
+static bool ws_audience_matches(const sensor_ws_client_t *client, ws_audience_t audience)
 {
-    if (guard == NULL) {
-        return;
+    return audience == WS_AUDIENCE_ALL || client->binary == (audience == WS_AUDIENCE_BINARY);
+}
+
+static void ws_frame_release(ws_frame_t *frame)
+{
+    if (frame != NULL) {
+        atomic_fetch_sub(&frame->refs, 1);
     }
+}
 
-    if (guard->should_resume) {
-        sensor_manager_resume_reading();
+/**
+ * @brief Drop every frame queued for a client (caller holds s_ws_clients_mutex)
+ */
+static void sensor_ws_client_clear_locked(sensor_ws_client_t *client)
+{
+    for (uint8_t i = 0; i < client->queued; i++) {
+        ws_frame_release(client->queue[i]);
+        client->queue[i] = NULL;
     }
-    guard->should_resume = false;
+    client->queued = 0;
+}
 
-    if (guard->mutex_acquired && s_sensor_guard_mutex != NULL) {
-        xSemaphoreGive(s_sensor_guard_mutex);
-        guard->mutex_acquired = false;
+/**
+ * @brief Take the queue entry at index out of the queue (caller holds s_ws_clients_mutex)
+ *
+ * @return The frame; its queue reference now belongs to the caller
+ */
+static ws_frame_t *sensor_ws_client_take_locked(sensor_ws_client_t *client, uint8_t index)
+{
+    ws_frame_t *frame = client->queue[index];
+    for (uint8_t i = index + 1; i < client->queued; i++) {
+        client->queue[i - 1] = client->queue[i];
     }
+    client->queued--;
+    client->queue[client->queued] = NULL;
+    return frame;
 }
 
-typedef struct {
-    httpd_handle_t server;
-    int fd;
-    char *payload;
-    size_t len;
-} ws_async_send_arg_t;
+/**
+ * @brief Queue a frame for a client (caller holds s_ws_clients_mutex)
+ *
+ * An unsent status snapshot is replaced by the newer one. When a slow client
+ * has a full queue, its oldest snapshot is dropped to make room; other frames
+ * are only dropped if the queue holds nothing else to shed.
+ *
+ * @return true if the frame was queued
+ */
+static bool sensor_ws_client_enqueue_locked(sensor_ws_client_t *client, ws_frame_t *frame)
+{
+    bool shed = frame->status;
+    for (uint8_t i = 0; i < client->queued; i++) {
+        if (client->queue[i]->status && (shed || client->queued == SENSOR_WS_CLIENT_QUEUE)) {
+            ws_frame_release(sensor_ws_client_take_locked(client, i));
+            break;
+        }
+    }
+    if (client->queued == SENSOR_WS_CLIENT_QUEUE) {
+        ESP_LOGD(TAG, "WS client fd %d backlogged, dropping frame", client->fd);
+        return false;
+    }
+
+    atomic_fetch_add(&frame->refs, 1);
+    client->queue[client->queued++] = frame;
+    return true;
+}
 
+/**
+ * @brief Drain one client's queue from the httpd task
+ *
+ * @param arg Client slot index
+ */
 static void ws_send_work_cb(void *arg)
 {
-    ws_async_send_arg_t *resp = (ws_async_send_arg_t *)arg;
-    if (resp == NULL) {
-        return;
-    }
+    int slot = (int)(intptr_t)arg;
+
+    while (s_server != NULL) {
+        if (xSemaphoreTake(s_ws_clients_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+            return;
+        }
+        sensor_ws_client_t *client = &s_ws_clients[slot];
+        if (!client->active || client->queued == 0) {
+            client->send_scheduled = false;
+            xSemaphoreGive(s_ws_clients_mutex);
+            return;
+        }
+        ws_frame_t *frame = sensor_ws_client_take_locked(client, 0);
+        int fd = client->fd;
+        xSemaphoreGive(s_ws_clients_mutex);
 
-    if (resp->server != NULL) {
-        httpd_ws_frame_t frame = {
+        httpd_ws_frame_t ws_frame = {
             .final = true,
             .fragmented = false,
-            .type = HTTPD_WS_TYPE_TEXT,
-            .payload = (uint8_t *)resp->payload,
-            .len = resp->len
+            .type = frame->binary ? HTTPD_WS_TYPE_BINARY : HTTPD_WS_TYPE_TEXT,
+            .payload = (uint8_t *)frame->data,
+            .len = frame->len
         };
 
-        esp_err_t ret = httpd_ws_send_frame_async(resp->server, resp->fd, &frame);
+        esp_err_t ret = httpd_ws_send_frame_async(s_server, fd, &ws_frame);
+        ws_frame_release(frame);
         if (ret != ESP_OK) {
-            ESP_LOGW(TAG, "Failed to send WS frame to fd %d: %s", resp->fd, esp_err_to_name(ret));
-            sensor_ws_remove_client(resp->fd);
+            ESP_LOGW(TAG, "Failed to send WS frame to fd %d: %s", fd, esp_err_to_name(ret));
+            sensor_ws_remove_client(fd);
+            return;
         }
     }
-
-    if (resp->payload != NULL) {
-        free(resp->payload);
-    }
-    free(resp);
 }
 
 static void sensor_ws_ensure_mutex(void)
@@ -210,6 +456,28 @@ static void sensor_ws_ensure_mutex(void)
             ESP_LOGE(TAG, "Failed to create WS client mutex");
         }
     }
+    if (s_ws_bin_mutex == NULL) {
+        s_ws_bin_mutex = xSemaphoreCreateMutex();
+        if (s_ws_bin_mutex == NULL) {
+            ESP_LOGE(TAG, "Failed to create WS delta state mutex");
+        }
+    }
+    if (s_ws_frames[0].data == NULL) {
+        // One block for the whole pool, PSRAM when available
+        size_t pool_size = SENSOR_WS_FRAME_POOL * SENSOR_WS_FRAME_SIZE;
+        char *pool = heap_caps_malloc(pool_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (pool == NULL) {
+            pool = malloc(pool_size);
+        }
+        if (pool == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate WS frame pool");
+            return;
+        }
+        for (int i = 0; i < SENSOR_WS_FRAME_POOL; i++) {
+            atomic_init(&s_ws_frames[i].refs, 0);
+            s_ws_frames[i].data = pool + i * SENSOR_WS_FRAME_SIZE;
+        }
+    }
 }
 
 static void sensor_ws_add_client(int fd)
@@ -224,6 +492,8 @@ static void sensor_ws_add_client(int fd)
             if (!s_ws_clients[i].active) {
                 s_ws_clients[i].active = true;
                 s_ws_clients[i].fd = fd;
+                s_ws_clients[i].binary = false;
+                sensor_ws_client_clear_locked(&s_ws_clients[i]);
                 ESP_LOGI(TAG, "WS client added (fd=%d, slot=%d)", fd, i);
                 added = true;
                 break;
@@ -234,6 +504,8 @@ static void sensor_ws_add_client(int fd)
         if (!added) {
             ESP_LOGW(TAG, "WS client limit reached, closing fd %d", fd);
             httpd_sess_trigger_close(s_server, fd);
+        } else {
+            sensor_ws_status_push_enable(true);
         }
     }
 }
@@ -249,6 +521,7 @@ static void sensor_ws_remove_client(int fd)
                 ESP_LOGI(TAG, "WS client removed (fd=%d)", fd);
                 s_ws_clients[i].active = false;
                 s_ws_clients[i].fd = -1;
+                sensor_ws_client_clear_locked(&s_ws_clients[i]);
                 break;
             }
         }
@@ -261,6 +534,9 @@ static void sensor_ws_remove_client(int fd)
         }
         xSemaphoreGive(s_ws_clients_mutex);
 
+        if (!any_active) {
+            sensor_ws_status_push_enable(false);
+        }
         if (!any_active && s_focus_stream_active) {
             ESP_LOGI(TAG, "No WS clients connected, stopping focus stream");
             focus_stream_stop();
@@ -268,7 +544,12 @@ static void sensor_ws_remove_client(int fd)
     }
 }
 
-static bool sensor_ws_has_clients(void)
+/**
+ * @brief Check for connected clients speaking a protocol
+ *
+ * @param audience WS_AUDIENCE_ALL for any client
+ */
+static bool sensor_ws_has_clients(ws_audience_t audience)
 {
     if (s_ws_clients_mutex == NULL) {
         return false;
@@ -276,7 +557,7 @@ static bool sensor_ws_has_clients(void)
     bool result = false;
     if (xSemaphoreTake(s_ws_clients_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
         for (int i = 0; i < SENSOR_WS_MAX_CLIENTS; i++) {
-            if (s_ws_clients[i].active) {
+            if (s_ws_clients[i].active && ws_audience_matches(&s_ws_clients[i], audience)) {
                 result = true;
                 break;
             }
@@ -286,143 +567,378 @@ static bool sensor_ws_has_clients(void)
     return result;
 }
 
-static void sensor_ws_send_json_to_client(int fd, const char *json, size_t len)
+/**
+ * @brief Check if a client negotiated the binary protocol
+ */
+static bool sensor_ws_client_is_binary(int fd)
 {
-    if (s_server == NULL || json == NULL || len == 0) {
-        return;
+    bool result = false;
+    if (s_ws_clients_mutex != NULL && xSemaphoreTake(s_ws_clients_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+        for (int i = 0; i < SENSOR_WS_MAX_CLIENTS; i++) {
+            if (s_ws_clients[i].active && s_ws_clients[i].fd == fd) {
+                result = s_ws_clients[i].binary;
+                break;
+            }
+        }
+        xSemaphoreGive(s_ws_clients_mutex);
     }
+    return result;
+}
 
-    ws_async_send_arg_t *arg = calloc(1, sizeof(ws_async_send_arg_t));
-    if (arg == NULL) {
+/**
+ * @brief Queue a filled frame for every client of an audience, or only target_fd if >= 0
+ *
+ * Each client queue takes its own reference; the caller keeps and releases
+ * the producer reference.
+ */
+static void sensor_ws_publish(ws_frame_t *frame, int target_fd, ws_audience_t audience)
+{
+    if (s_server == NULL || s_ws_clients_mutex == NULL || frame->len == 0) {
         return;
     }
-    arg->payload = malloc(len);
-    if (arg->payload == NULL) {
-        free(arg);
+
+    int schedule[SENSOR_WS_MAX_CLIENTS];
+    size_t schedule_count = 0;
+    if (xSemaphoreTake(s_ws_clients_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
         return;
     }
-    memcpy(arg->payload, json, len);
-    arg->len = len;
-    arg->fd = fd;
-    arg->server = s_server;
+    for (int i = 0; i < SENSOR_WS_MAX_CLIENTS; i++) {
+        sensor_ws_client_t *client = &s_ws_clients[i];
+        if (!client->active || (target_fd >= 0 && client->fd != target_fd) ||
+            !ws_audience_matches(client, audience)) {
+            continue;
+        }
+        if (sensor_ws_client_enqueue_locked(client, frame) && !client->send_scheduled) {
+            client->send_scheduled = true;
+            schedule[schedule_count++] = i;
+        }
+    }
+    xSemaphoreGive(s_ws_clients_mutex);
 
-    if (httpd_queue_work(s_server, ws_send_work_cb, arg) != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to queue WS send work");
-        free(arg->payload);
-        free(arg);
+    // One pending work item per client; it drains whatever is queued when it runs
+    for (size_t i = 0; i < schedule_count; i++) {
+        if (httpd_queue_work(s_server, ws_send_work_cb, (void *)(intptr_t)schedule[i]) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to queue WS send work");
+            if (xSemaphoreTake(s_ws_clients_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+                s_ws_clients[schedule[i]].send_scheduled = false;
+                xSemaphoreGive(s_ws_clients_mutex);
+            }
+        }
     }
 }
 
-static void sensor_ws_broadcast_json(const char *json, size_t len)
+/**
+ * @brief Serialize a cJSON message once and queue it as a text frame
+ *
+ * @param root Message to send
+ * @param target_fd Single client, or -1 for all clients of the audience
+ * @param audience Clients that understand the message
+ */
+static void sensor_ws_send_cjson(cJSON *root, int target_fd, ws_audience_t audience)
 {
-    if (json == NULL || len == 0 || s_server == NULL) {
+    if (root == NULL || (target_fd < 0 && !sensor_ws_has_clients(audience))) {
         return;
     }
-    if (!sensor_ws_has_clients()) {
+
+    ws_frame_t *frame = ws_frame_acquire(false);
+    if (frame == NULL) {
         return;
     }
+    if (cJSON_PrintPreallocated(root, frame->data, SENSOR_WS_FRAME_SIZE, false)) {
+        frame->len = strlen(frame->data);
+        sensor_ws_publish(frame, target_fd, audience);
+    } else {
+        ESP_LOGW(TAG, "WS message does not fit %d bytes", SENSOR_WS_FRAME_SIZE);
+    }
+    ws_frame_release(frame);
+}
 
-    if (s_ws_clients_mutex == NULL) {
+static void sensor_ws_broadcast_cjson(cJSON *root)
+{
+    sensor_ws_send_cjson(root, -1, WS_AUDIENCE_ALL);
+}
+
+static void sensor_ws_emit_status_json(const sensor_cache_t *cache, int target_fd)
+{
+    // Serialized once per cache update, however many clients are connected
+    ws_frame_t *frame = ws_frame_acquire(true);
+    if (frame == NULL) {
         return;
     }
 
-    int targets[SENSOR_WS_MAX_CLIENTS];
-    size_t target_count = 0;
-    if (xSemaphoreTake(s_ws_clients_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        for (int i = 0; i < SENSOR_WS_MAX_CLIENTS; i++) {
-            if (s_ws_clients[i].active && target_count < SENSOR_WS_MAX_CLIENTS) {
-                targets[target_count++] = s_ws_clients[i].fd;
-            }
+    json_writer_t w;
+    json_writer_init(&w, frame->data, SENSOR_WS_FRAME_SIZE, NULL, NULL);
+
+    json_writer_object_begin(&w);
+    json_writer_kv_string(&w, "type", "status_snapshot");
+    json_writer_kv_int(&w, "timestamp_ms", (int64_t)(cache->timestamp_us / 1000ULL));
+    if (cache->battery_valid) {
+        json_writer_kv_float(&w, "battery", cache->battery_percentage);
+    }
+    json_writer_kv_int(&w, "rssi", cache->rssi);
+
+    json_writer_key(&w, "sensors");
+    telemetry_write_sensors_json(&w, cache);
+    telemetry_write_derived_json(&w, cache);
+
+    // Sensors run on independent schedules, so report when each one was last sampled
+    json_writer_key(&w, "sensor_updated_ms");
+    json_writer_object_begin(&w);
+    for (uint8_t i = 0; i < cache->sensor_count && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
+        const cached_sensor_t *sensor = &cache->sensors[i];
+        if (sensor->valid && sensor->timestamp_us > 0) {
+            // Same key as the reading in "sensors", so a second board of a type gets its own entry
+            char key[24];
+            json_writer_kv_int(&w, telemetry_sensor_key(cache, i, key, sizeof(key)),
+                               (int64_t)(sensor->timestamp_us / 1000ULL));
         }
-        xSemaphoreGive(s_ws_clients_mutex);
     }
+    json_writer_object_end(&w);
+    json_writer_object_end(&w);
+
+    if (json_writer_finish(&w) == ESP_OK) {
+        frame->len = json_writer_length(&w);
+        sensor_ws_publish(frame, target_fd, WS_AUDIENCE_JSON);
+    } else {
+        ESP_LOGW(TAG, "Status snapshot does not fit %d bytes", SENSOR_WS_FRAME_SIZE);
+    }
+
+    ws_frame_release(frame);
+}
+
+static void ws_bin_put(ws_bin_writer_t *w, const void *data, size_t len)
+{
+    if (len == 0) {
+        return;
+    }
+    if (w->overflow || w->len + len > w->cap) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+}
+
+// Multi-byte fields are little-endian, the native order of every supported target
+static void ws_bin_put_u8(ws_bin_writer_t *w, uint8_t value)
+{
+    ws_bin_put(w, &value, sizeof(value));
+}
+
+static void ws_bin_put_f32(ws_bin_writer_t *w, float value)
+{
+    ws_bin_put(w, &value, sizeof(value));
+}
+
+static void ws_bin_put_str8(ws_bin_writer_t *w, const char *str)
+{
+    size_t len = (str != NULL) ? strnlen(str, UINT8_MAX) : 0;
+    ws_bin_put_u8(w, (uint8_t)len);
+    ws_bin_put(w, str, len);
+}
+
+static void ws_bin_put_header(ws_bin_writer_t *w, uint8_t kind, uint8_t flags, uint16_t seq, uint64_t timestamp_ms)
+{
+    ws_bin_put_u8(w, kind);
+    ws_bin_put_u8(w, flags);
+    ws_bin_put(w, &seq, sizeof(seq));
+    ws_bin_put(w, &timestamp_ms, sizeof(timestamp_ms));
+}
+
+/**
+ * @brief Resolve the channel name of each value a board reports
+ *
+ * @return false for boards of an unknown kind, whose values stay unnamed
+ */
+static bool sample_value_names(const ezo_sensor_t *sensor, const char *names[EZO_MAX_CHANNELS])
+{
+    bool named = (sensor->config.kind != EZO_KIND_UNKNOWN);
+    for (uint8_t j = 0; j < EZO_MAX_CHANNELS; j++) {
+        names[j] = named ? ezo_sensor_channel_name(sensor->config.kind, sensor->config.channels[j]) : NULL;
+    }
+    return named;
+}
 
-    for (size_t i = 0; i < target_count; i++) {
-        sensor_ws_send_json_to_client(targets[i], json, len);
+/**
+ * @brief Write one sensor: type, value count, then a name and a value per entry
+ *
+ * Names follow the JSON "sensors" object: none for single-value sensors, unnamed
+ * entries of a named type are skipped by the decoder.
+ */
+static void ws_bin_put_sensor(ws_bin_writer_t *w, const char *type, const char *const names[],
+                              const float *values, uint8_t count)
+{
+    if (count > MAX_SENSOR_VALUES) {
+        count = MAX_SENSOR_VALUES;
+    }
+    ws_bin_put_str8(w, type);
+    ws_bin_put_u8(w, count);
+    for (uint8_t j = 0; j < count; j++) {
+        if (count == 1) {
+            ws_bin_put_str8(w, NULL);
+        } else if (names != NULL) {
+            ws_bin_put_str8(w, names[j]);
+        } else {
+            char field[16];
+            snprintf(field, sizeof(field), "value_%d", j);
+            ws_bin_put_str8(w, field);
+        }
+        ws_bin_put_f32(w, values[j]);
     }
 }
 
-static cJSON *create_sensors_object_from_cache(const sensor_cache_t *cache)
+/**
+ * @brief Check if two snapshots have the same channels (valid sensors, types and value counts)
+ */
+static bool ws_bin_same_layout(const sensor_cache_t *a, const sensor_cache_t *b)
 {
-    cJSON *sensors = cJSON_CreateObject();
-    if (sensors == NULL || cache == NULL) {
-        return sensors;
+    if (a->sensor_count != b->sensor_count) {
+        return false;
+    }
+    for (uint8_t i = 0; i < a->sensor_count && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
+        const cached_sensor_t *sa = &a->sensors[i];
+        const cached_sensor_t *sb = &b->sensors[i];
+        if (sa->valid != sb->valid) {
+            return false;
+        }
+        if (sa->valid && (sa->value_count != sb->value_count || strcmp(sa->sensor_type, sb->sensor_type) != 0)) {
+            return false;
+        }
     }
+    return true;
+}
 
-    for (uint8_t i = 0; i < cache->sensor_count && i < 8; i++) {
+/**
+ * @brief Encode a binary status frame
+ *
+ * @param w Output writer
+ * @param cache Snapshot to encode
+ * @param prev Snapshot the delta is relative to, or NULL for a keyframe
+ * @param seq Sequence number
+ * @return Number of changed channels (delta) or sensors (keyframe)
+ */
+static uint8_t ws_bin_encode_status(ws_bin_writer_t *w, const sensor_cache_t *cache,
+                                    const sensor_cache_t *prev, uint16_t seq)
+{
+    ws_bin_put_header(w, SENSOR_WS_BIN_STATUS, (prev == NULL) ? SENSOR_WS_BIN_FLAG_KEY : 0,
+                      seq, cache->timestamp_us / 1000ULL);
+    ws_bin_put_u8(w, (uint8_t)cache->rssi);
+    ws_bin_put_f32(w, cache->battery_valid ? cache->battery_percentage : NAN);
+
+    size_t count_pos = w->len;
+    uint8_t entries = 0;
+    ws_bin_put_u8(w, 0);
+    for (uint8_t i = 0; i < cache->sensor_count && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
         const cached_sensor_t *sensor = &cache->sensors[i];
         if (!sensor->valid) {
             continue;
         }
-
-        if (sensor->value_count == 1) {
-            cJSON_AddNumberToObject(sensors, sensor->sensor_type, sensor->values[0]);
-        } else if (sensor->value_count > 1) {
-            cJSON *sensor_obj = cJSON_CreateObject();
-            if (sensor_obj == NULL) {
-                continue;
-            }
-
-            if (strcmp(sensor->sensor_type, "HUM") == 0) {
-                if (sensor->value_count >= 1) cJSON_AddNumberToObject(sensor_obj, "humidity", sensor->values[0]);
-                if (sensor->value_count >= 2) cJSON_AddNumberToObject(sensor_obj, "air_temp", sensor->values[1]);
-                if (sensor->value_count >= 3) cJSON_AddNumberToObject(sensor_obj, "dew_point", sensor->values[2]);
-            } else if (strcmp(sensor->sensor_type, "EC") == 0) {
-                if (sensor->value_count >= 1) cJSON_AddNumberToObject(sensor_obj, "conductivity", sensor->values[0]);
-                if (sensor->value_count >= 2) cJSON_AddNumberToObject(sensor_obj, "tds", sensor->values[1]);
-                if (sensor->value_count >= 3) cJSON_AddNumberToObject(sensor_obj, "salinity", sensor->values[2]);
-                if (sensor->value_count >= 4) cJSON_AddNumberToObject(sensor_obj, "specific_gravity", sensor->values[3]);
-            } else if (strcmp(sensor->sensor_type, "DO") == 0) {
-                if (sensor->value_count >= 1) cJSON_AddNumberToObject(sensor_obj, "dissolved_oxygen", sensor->values[0]);
-                if (sensor->value_count >= 2) cJSON_AddNumberToObject(sensor_obj, "saturation", sensor->values[1]);
-            } else {
-                for (uint8_t j = 0; j < sensor->value_count; j++) {
-                    char field_name[16];
-                    snprintf(field_name, sizeof(field_name), "value_%d", j);
-                    cJSON_AddNumberToObject(sensor_obj, field_name, sensor->values[j]);
-                }
+        if (prev == NULL) {
+            // Keyed like the JSON snapshot, so a second board of a type ("pH_2") keeps its own entry
+            char key[24];
+            ws_bin_put_u8(w, i);
+            ws_bin_put_str8(w, telemetry_sensor_key(cache, i, key, sizeof(key)));
+            const char *names[MAX_SENSOR_VALUES];
+            bool named = telemetry_sensor_names(sensor, names);
+            ws_bin_put_sensor(w, sensor->sensor_type, named ? names : NULL, sensor->values, sensor->value_count);
+            entries++;
+            continue;
+        }
+        // Channel id: sensor slot in the high bits, value index in the low two
+        for (uint8_t j = 0; j < sensor->value_count && j < MAX_SENSOR_VALUES; j++) {
+            if (memcmp(&sensor->values[j], &prev->sensors[i].values[j], sizeof(float)) != 0) {
+                ws_bin_put_u8(w, (uint8_t)((i << 2) | j));
+                ws_bin_put_f32(w, sensor->values[j]);
+                entries++;
             }
-
-            cJSON_AddItemToObject(sensors, sensor->sensor_type, sensor_obj);
         }
     }
-
-    return sensors;
+    if (!w->overflow) {
+        w->buf[count_pos] = entries;
+    }
+    return entries;
 }
 
-static void sensor_ws_emit_status_payload(const sensor_cache_t *cache, int target_fd)
+/**
+ * @brief Send a binary status frame
+ *
+ * Broadcasts carry only the channels that changed since the previous broadcast,
+ * with a keyframe whenever the channel layout changes and every
+ * SENSOR_WS_BIN_KEY_INTERVAL frames. A targeted send (new client or resync
+ * request after a sequence gap) gets a keyframe of the state the next delta
+ * will be relative to.
+ */
+static void sensor_ws_emit_status_binary(const sensor_cache_t *cache, int target_fd)
 {
-    if (cache == NULL) {
+    if (s_ws_bin_mutex == NULL || xSemaphoreTake(s_ws_bin_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
         return;
     }
 
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
+    bool keyframe = (target_fd >= 0) || !s_ws_bin_prev_valid ||
+                    !ws_bin_same_layout(&s_ws_bin_prev, cache) ||
+                    s_ws_bin_since_key >= SENSOR_WS_BIN_KEY_INTERVAL;
+    if (target_fd >= 0 && !s_ws_bin_prev_valid) {
+        s_ws_bin_prev = *cache;
+        s_ws_bin_prev_valid = true;
+    }
+    bool unchanged = !keyframe && cache->rssi == s_ws_bin_prev.rssi &&
+                     cache->battery_valid == s_ws_bin_prev.battery_valid &&
+                     cache->battery_percentage == s_ws_bin_prev.battery_percentage;
+
+    // Delta frames are never superseded in a client queue; a dropped one shows up as a gap
+    ws_frame_t *frame = ws_frame_acquire(false);
+    if (frame == NULL) {
+        xSemaphoreGive(s_ws_bin_mutex);
         return;
     }
 
-    cJSON_AddStringToObject(root, "type", "status_snapshot");
-    cJSON_AddNumberToObject(root, "timestamp_ms", (double)(cache->timestamp_us / 1000ULL));
-    if (cache->battery_valid) {
-        cJSON_AddNumberToObject(root, "battery", cache->battery_percentage);
+    ws_bin_writer_t w = { .buf = (uint8_t *)frame->data, .cap = SENSOR_WS_FRAME_SIZE };
+    if (target_fd >= 0) {
+        ws_bin_encode_status(&w, &s_ws_bin_prev, NULL, s_ws_bin_seq);
+    } else {
+        uint16_t seq = s_ws_bin_seq + 1;
+        uint8_t changes = ws_bin_encode_status(&w, cache, keyframe ? NULL : &s_ws_bin_prev, seq);
+        if (!keyframe && unchanged && changes == 0) {
+            w.len = 0;      // Nothing new: keep the sequence contiguous by not sending
+        } else {
+            s_ws_bin_seq = seq;
+            s_ws_bin_prev = *cache;
+            s_ws_bin_prev_valid = true;
+            s_ws_bin_since_key = keyframe ? 0 : s_ws_bin_since_key + 1;
+        }
     }
-    cJSON_AddNumberToObject(root, "rssi", cache->rssi);
 
-    cJSON *sensors = create_sensors_object_from_cache(cache);
-    if (sensors != NULL) {
-        cJSON_AddItemToObject(root, "sensors", sensors);
+    if (w.overflow) {
+        ESP_LOGW(TAG, "Binary status frame does not fit %d bytes", SENSOR_WS_FRAME_SIZE);
+    } else if (w.len > 0) {
+        frame->binary = true;
+        frame->len = w.len;
+        sensor_ws_publish(frame, target_fd, WS_AUDIENCE_BINARY);
     }
+    ws_frame_release(frame);
+    xSemaphoreGive(s_ws_bin_mutex);
+}
 
-    char *json = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
+static void sensor_ws_emit_status_payload(const sensor_cache_t *cache, int target_fd)
+{
+    if (cache == NULL) {
+        return;
+    }
 
-    if (json != NULL) {
-        if (target_fd >= 0) {
-            sensor_ws_send_json_to_client(target_fd, json, strlen(json));
+    if (target_fd >= 0) {
+        if (sensor_ws_client_is_binary(target_fd)) {
+            sensor_ws_emit_status_binary(cache, target_fd);
         } else {
-            sensor_ws_broadcast_json(json, strlen(json));
+            sensor_ws_emit_status_json(cache, target_fd);
         }
-        free(json);
+        return;
+    }
+
+    if (sensor_ws_has_clients(WS_AUDIENCE_JSON)) {
+        sensor_ws_emit_status_json(cache, -1);
+    }
+    if (sensor_ws_has_clients(WS_AUDIENCE_BINARY)) {
+        sensor_ws_emit_status_binary(cache, -1);
     }
 }
 
@@ -445,90 +961,397 @@ static void handle_sensor_cache_update(const sensor_cache_t *cache, void *ctx)
     sensor_ws_send_status_event(cache);
 }
 
-static void sensor_ws_send_focus_status(const char *status, uint8_t address)
+/**
+ * @brief Switch a client between the JSON and binary protocols
+ *
+ * Acknowledged with a text {"type":"protocol"} message, followed by a fresh
+ * snapshot in the new format.
+ */
+static void sensor_ws_set_client_protocol(int fd, bool binary)
 {
-    if (status == NULL) {
+    bool found = false;
+    if (s_ws_clients_mutex != NULL && xSemaphoreTake(s_ws_clients_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+        for (int i = 0; i < SENSOR_WS_MAX_CLIENTS; i++) {
+            if (s_ws_clients[i].active && s_ws_clients[i].fd == fd) {
+                s_ws_clients[i].binary = binary;
+                found = true;
+                break;
+            }
+        }
+        xSemaphoreGive(s_ws_clients_mutex);
+    }
+    if (!found) {
         return;
     }
 
     cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        return;
+    if (root != NULL) {
+        cJSON_AddStringToObject(root, "type", "protocol");
+        cJSON_AddStringToObject(root, "protocol", binary ? "binary" : "json");
+        cJSON_AddNumberToObject(root, "version", SENSOR_WS_BIN_VERSION);
+        sensor_ws_send_cjson(root, fd, WS_AUDIENCE_ALL);
+        cJSON_Delete(root);
     }
+    sensor_ws_send_snapshot_to_client(fd);
+}
 
-    cJSON_AddStringToObject(root, "type", "focus_status");
-    cJSON_AddStringToObject(root, "status", status);
-    cJSON_AddNumberToObject(root, "address", address);
-
-    char *json = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-
-    if (json != NULL) {
-        sensor_ws_broadcast_json(json, strlen(json));
-        free(json);
+/**
+ * @brief Read the device status fields pushed to WebSocket clients
+ */
+static void sensor_ws_collect_status(ws_status_push_t *status)
+{
+    status->wifi_connected = wifi_manager_is_connected();
+    status->mqtt_connected = mqtt_client_is_connected();
+    status->time_synced = time_sync_is_synced();
+    status->free_heap = esp_get_free_heap_size();
+    status->cpu_usage = perf_monitor_cpu_usage();
+    status->rssi_valid = false;
+    if (status->wifi_connected) {
+        wifi_ap_record_t ap_info;
+        if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+            status->rssi = ap_info.rssi;
+            status->rssi_valid = true;
+        }
     }
 }
 
-static void sensor_ws_send_focus_sample(ezo_sensor_t *sensor, const float *values, uint8_t count)
+/**
+ * @brief Push device status as a {"type":"device_status"} text message
+ *
+ * A full message carries every field plus uptime and the formatted clock; a
+ * delta carries only what moved by a meaningful step since the last broadcast.
+ * Broadcasts fall back to a full message every SENSOR_WS_STATUS_HEARTBEAT_MS.
+ *
+ * @param target_fd Single client (always a full message), or -1 to broadcast
+ */
+static void sensor_ws_send_device_status(int target_fd)
 {
-    if (sensor == NULL || values == NULL || count == 0) {
+    ws_status_push_t now = {0};
+    sensor_ws_collect_status(&now);
+    int64_t now_us = esp_timer_get_time();
+
+    ws_status_push_t *last = &s_status_push;
+    bool full = (target_fd >= 0) || !last->valid ||
+                (now_us - last->last_full_us) >= (int64_t)SENSOR_WS_STATUS_HEARTBEAT_MS * 1000;
+    bool rssi_changed = now.rssi_valid != last->rssi_valid ||
+                        (now.rssi_valid && abs(now.rssi - last->rssi) >= SENSOR_WS_STATUS_RSSI_STEP);
+    bool heap_changed = (now.free_heap > last->free_heap ? now.free_heap - last->free_heap
+                                                         : last->free_heap - now.free_heap) >= SENSOR_WS_STATUS_HEAP_STEP;
+    bool cpu_changed = abs(now.cpu_usage - last->cpu_usage) >= SENSOR_WS_STATUS_CPU_STEP;
+    bool wifi_changed = now.wifi_connected != last->wifi_connected;
+    bool mqtt_changed = now.mqtt_connected != last->mqtt_connected;
+    bool time_changed = now.time_synced != last->time_synced;
+    if (!full && !rssi_changed && !heap_changed && !cpu_changed && !wifi_changed && !mqtt_changed && !time_changed) {
         return;
     }
 
-    cJSON *sensor_json = build_sensor_json(sensor, -1, true);
-    if (sensor_json == NULL) {
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
         return;
     }
+    cJSON_AddStringToObject(root, "type", "device_status");
+    cJSON_AddBoolToObject(root, "full", full);
+    if (full) {
+        cJSON_AddNumberToObject(root, "uptime", (double)(now_us / 1000000));
+        char time_str[64];
+        if (time_sync_get_time_string(time_str, sizeof(time_str), NULL) == ESP_OK) {
+            cJSON_AddStringToObject(root, "current_time", time_str);
+        } else {
+            cJSON_AddStringToObject(root, "current_time", "Not synced");
+        }
+    }
+    if ((full || rssi_changed) && now.rssi_valid) {
+        cJSON_AddNumberToObject(root, "rssi", now.rssi);
+    }
+    if (full || heap_changed) {
+        cJSON_AddNumberToObject(root, "free_heap", now.free_heap);
+    }
+    if ((full || cpu_changed) && now.cpu_usage >= 0) {
+        cJSON_AddNumberToObject(root, "cpu_usage", now.cpu_usage);
+    }
+    if (full || wifi_changed) {
+        cJSON_AddBoolToObject(root, "wifi_connected", now.wifi_connected);
+    }
+    if (full || mqtt_changed) {
+        cJSON_AddBoolToObject(root, "mqtt_connected", now.mqtt_connected);
+    }
+    if (full || time_changed) {
+        cJSON_AddBoolToObject(root, "time_synced", now.time_synced);
+    }
 
-    uint64_t timestamp_ms = esp_timer_get_time() / 1000ULL;
-    cJSON_AddNumberToObject(sensor_json, "timestamp_ms", (double)timestamp_ms);
-    cJSON_AddNumberToObject(sensor_json, "value_count", count);
-
-    cJSON *raw = cJSON_CreateArray();
-    if (raw != NULL) {
-        for (uint8_t i = 0; i < count; i++) {
-            cJSON_AddItemToArray(raw, cJSON_CreateNumber(values[i]));
+    sensor_ws_send_cjson(root, target_fd, WS_AUDIENCE_ALL);
+    cJSON_Delete(root);
+
+    if (target_fd < 0) {
+        now.valid = true;
+        now.last_full_us = full ? now_us : last->last_full_us;
+        *last = now;
+    }
+}
+
+// Runs in the httpd task, like every other WebSocket producer that is not a sensor listener
+static void status_push_work_cb(void *arg)
+{
+    (void)arg;
+    atomic_store(&s_status_work_queued, false);
+    if (sensor_ws_has_clients(WS_AUDIENCE_ALL)) {
+        sensor_ws_send_device_status(-1);
+    }
+}
+
+static void status_push_timer_cb(void *arg)
+{
+    (void)arg;
+    if (s_server == NULL || atomic_exchange(&s_status_work_queued, true)) {
+        return;
+    }
+    if (httpd_queue_work(s_server, status_push_work_cb, NULL) != ESP_OK) {
+        atomic_store(&s_status_work_queued, false);
+    }
+}
+
+/**
+ * @brief Start or stop the status push timer with the first and last client
+ */
+static void sensor_ws_status_push_enable(bool enable)
+{
+    if (!enable) {
+        if (s_status_timer != NULL) {
+            esp_timer_stop(s_status_timer);
+        }
+        s_status_push.valid = false;
+        return;
+    }
+
+    if (s_status_timer == NULL) {
+        esp_timer_create_args_t args = {
+            .callback = status_push_timer_cb,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "ws_status"
+        };
+        if (esp_timer_create(&args, &s_status_timer) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create status push timer");
+            return;
         }
-        cJSON_AddItemToObject(sensor_json, "raw", raw);
     }
+    if (!esp_timer_is_active(s_status_timer)) {
+        esp_timer_start_periodic(s_status_timer, SENSOR_WS_STATUS_CHECK_MS * 1000ULL);
+    }
+}
 
-    add_sample_readings_to_json(sensor_json, sensor->config.type, values, count);
+static void sensor_ws_send_focus_status(const char *status, uint8_t address)
+{
+    if (status == NULL) {
+        return;
+    }
 
     cJSON *root = cJSON_CreateObject();
     if (root == NULL) {
-        cJSON_Delete(sensor_json);
         return;
     }
 
-    cJSON_AddStringToObject(root, "type", "focus_sample");
-    cJSON_AddItemToObject(root, "sensor", sensor_json);
+    cJSON_AddStringToObject(root, "type", "focus_status");
+    cJSON_AddStringToObject(root, "status", status);
+    cJSON_AddNumberToObject(root, "address", address);
 
-    char *json = cJSON_PrintUnformatted(root);
+    sensor_ws_broadcast_cjson(root);
     cJSON_Delete(root);
+}
+
+static void sensor_ws_send_focus_sample_binary(ezo_sensor_t *sensor, const float *values, uint8_t count,
+                                               uint64_t timestamp_ms)
+{
+    ws_frame_t *frame = ws_frame_acquire(false);
+    if (frame == NULL) {
+        return;
+    }
+
+    // Only the reading; the dashboard already holds the board details from /api/sensors
+    ws_bin_writer_t w = { .buf = (uint8_t *)frame->data, .cap = SENSOR_WS_FRAME_SIZE };
+    ws_bin_put_header(&w, SENSOR_WS_BIN_FOCUS_SAMPLE, 0, 0, timestamp_ms);
+    ws_bin_put_u8(&w, sensor->config.i2c_address);
+    const char *names[EZO_MAX_CHANNELS];
+    bool named = sample_value_names(sensor, names);
+    ws_bin_put_sensor(&w, sensor->config.type, named ? names : NULL, values, count);
+    if (!w.overflow) {
+        frame->binary = true;
+        frame->len = w.len;
+        sensor_ws_publish(frame, -1, WS_AUDIENCE_BINARY);
+    }
+    ws_frame_release(frame);
+}
+
+static void sensor_ws_send_focus_sample(ezo_sensor_t *sensor, const float *values, uint8_t count,
+                                        uint64_t timestamp_ms)
+{
+    if (sensor == NULL || values == NULL || count == 0) {
+        return;
+    }
+
+    if (sensor_ws_has_clients(WS_AUDIENCE_BINARY)) {
+        sensor_ws_send_focus_sample_binary(sensor, values, count, timestamp_ms);
+    }
+    if (!sensor_ws_has_clients(WS_AUDIENCE_JSON)) {
+        return;
+    }
+
+    ws_frame_t *frame = ws_frame_acquire(false);
+    if (frame == NULL) {
+        return;
+    }
+
+    json_writer_t w;
+    json_writer_init(&w, frame->data, SENSOR_WS_FRAME_SIZE, NULL, NULL);
+    json_writer_object_begin(&w);
+    json_writer_kv_string(&w, "type", "focus_sample");
+    json_writer_key(&w, "sensor");
+    write_sensor_json(&w, sensor, -1, true, values, count, timestamp_ms);
+    json_writer_object_end(&w);
+
+    if (json_writer_finish(&w) == ESP_OK) {
+        frame->len = w.len;
+        sensor_ws_publish(frame, -1, WS_AUDIENCE_JSON);
+    } else {
+        ESP_LOGW(TAG, "WS message does not fit %d bytes", SENSOR_WS_FRAME_SIZE);
+    }
+    ws_frame_release(frame);
+}
+
+static bool focus_queue_push(const focus_sample_t *sample)
+{
+    unsigned head = atomic_load_explicit(&s_focus_queue_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&s_focus_queue_tail, memory_order_acquire);
+    if (head - tail >= FOCUS_QUEUE_DEPTH) {
+        return false;
+    }
+
+    s_focus_queue[head & (FOCUS_QUEUE_DEPTH - 1)] = *sample;
+    atomic_store_explicit(&s_focus_queue_head, head + 1, memory_order_release);
+    return true;
+}
+
+static bool focus_queue_pop(focus_sample_t *sample)
+{
+    unsigned tail = atomic_load_explicit(&s_focus_queue_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&s_focus_queue_head, memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+
+    *sample = s_focus_queue[tail & (FOCUS_QUEUE_DEPTH - 1)];
+    atomic_store_explicit(&s_focus_queue_tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// Runs in the httpd task: turns queued samples into WebSocket frames
+static void focus_drain_work_cb(void *arg)
+{
+    (void)arg;
+    atomic_store(&s_focus_drain_queued, false);
+
+    focus_sample_t sample;
+    while (focus_queue_pop(&sample)) {
+        ezo_sensor_t *sensor = find_sensor_by_address(sample.address);
+        if (sensor != NULL) {
+            sensor_ws_send_focus_sample(sensor, sample.values, sample.count, sample.timestamp_ms);
+            calib_session_on_sample(&sample);
+        }
+    }
+}
 
-    if (json != NULL) {
-        sensor_ws_broadcast_json(json, strlen(json));
-        free(json);
+// Runs in the arbiter task with the bus held: one short register read per period
+static esp_err_t focus_fetch_txn(void *ctx)
+{
+    uint8_t address = (uint8_t)(uintptr_t)ctx;
+    if (!s_focus_stream_active || address != s_focus_sensor_address) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ezo_sensor_t *sensor = find_sensor_by_address(address);
+    if (sensor == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    focus_sample_t sample = {
+        .address = address,
+    };
+    esp_err_t ret = ESP_ERR_NOT_FINISHED;
+    if (s_focus_continuous || s_focus_triggered) {
+        ret = ezo_sensor_fetch_all(sensor, sample.values, &sample.count);
+    }
+    if (!s_focus_continuous) {
+        // Re-arm now so the conversion runs while the arbiter serves others
+        s_focus_triggered = (ezo_sensor_start_read(sensor) == ESP_OK);
+    }
+
+    if (ret == ESP_OK && sample.count > 0) {
+        sample.timestamp_ms = esp_timer_get_time() / 1000ULL;
+        if (!focus_queue_push(&sample)) {
+            ESP_LOGW(TAG, "Focus sample queue full, dropping sample");
+        }
+        // The reading task skips the focused board and reports this sample instead
+        sensor_manager_submit_external_reading(address, sample.values, sample.count);
+    }
+    return ret;
+}
+
+static void focus_fetch_done(esp_err_t result, void *ctx)
+{
+    uint8_t address = (uint8_t)(uintptr_t)ctx;
+    atomic_store(&s_focus_fetch_pending, false);
+
+    if (result != ESP_OK && result != ESP_ERR_NOT_FINISHED && result != ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "Focus read failed for 0x%02X: %s", address, esp_err_to_name(result));
+    }
+
+    unsigned head = atomic_load(&s_focus_queue_head);
+    if (head != atomic_load(&s_focus_queue_tail) && s_server != NULL &&
+        !atomic_exchange(&s_focus_drain_queued, true)) {
+        if (httpd_queue_work(s_server, focus_drain_work_cb, NULL) != ESP_OK) {
+            atomic_store(&s_focus_drain_queued, false);
+        }
     }
 }
 
 static void focus_timer_cb(void *arg)
 {
     (void)arg;
-    focus_stream_sample_now();
+    if (!s_focus_stream_active) {
+        return;
+    }
+
+    // Skip a period rather than queue up behind a slow bus
+    if (atomic_exchange(&s_focus_fetch_pending, true)) {
+        return;
+    }
+
+    void *ctx = (void *)(uintptr_t)s_focus_sensor_address;
+    if (i2c_arbiter_submit(I2C_ARBITER_PRIO_INTERACTIVE, s_focus_sensor_address,
+                           focus_fetch_txn, ctx, focus_fetch_done) != ESP_OK) {
+        atomic_store(&s_focus_fetch_pending, false);
+    }
 }
 
-static void wait_for_sensor_reading_idle(void)
+// Put the board back into the mode it was in before focusing
+static void focus_stream_release_board(void)
 {
-    const TickType_t timeout_ticks = pdMS_TO_TICKS(EZO_LONG_WAIT_MS + 2000);
-    TickType_t start = xTaskGetTickCount();
-    while (sensor_manager_is_reading_in_progress()) {
-        if ((xTaskGetTickCount() - start) > timeout_ticks) {
-            ESP_LOGW(TAG, "Timeout waiting for sensor reading task to idle");
-            break;
+    if (s_focus_restore_continuous) {
+        ezo_sensor_t *sensor = find_sensor_by_address(s_focus_sensor_address);
+        if (sensor != NULL) {
+            sensor_read_guard_t guard;
+            sensor_read_guard_acquire(&guard, sensor->config.i2c_address);
+            esp_err_t ret = ezo_sensor_set_continuous_mode(sensor, false);
+            sensor_read_guard_release(&guard);
+            if (ret != ESP_OK) {
+                ESP_LOGW(TAG, "Failed to leave continuous mode on 0x%02X: %s",
+                         s_focus_sensor_address, esp_err_to_name(ret));
+            }
         }
-        vTaskDelay(pdMS_TO_TICKS(50));
     }
+    s_focus_continuous = false;
+    s_focus_restore_continuous = false;
+    s_focus_triggered = false;
 }
 
 static esp_err_t focus_stream_start(uint8_t address)
@@ -538,24 +1361,13 @@ static esp_err_t focus_stream_start(uint8_t address)
         return ESP_ERR_NOT_FOUND;
     }
 
-    if (s_focus_stream_active) {
-        s_focus_sensor_address = address;
-        focus_stream_sample_now();
+    if (s_focus_stream_active && s_focus_sensor_address == address) {
         sensor_ws_send_focus_status("started", address);
         return ESP_OK;
     }
 
-    if (!sensor_manager_is_reading_paused()) {
-        sensor_manager_pause_reading();
-        s_focus_paused_readings = true;
-    } else {
-        s_focus_paused_readings = false;
-    }
-
-    wait_for_sensor_reading_idle();
-
-    s_focus_sensor_address = address;
-    s_focus_stream_active = true;
+    // A calibration session is tied to the board being focused
+    calib_session_end("cancelled", NULL);
 
     if (s_focus_timer == NULL) {
         esp_timer_create_args_t args = {
@@ -566,16 +1378,43 @@ static esp_err_t focus_stream_start(uint8_t address)
         };
         if (esp_timer_create(&args, &s_focus_timer) != ESP_OK) {
             ESP_LOGE(TAG, "Failed to create focus stream timer");
-            s_focus_stream_active = false;
             return ESP_FAIL;
         }
     } else {
         esp_timer_stop(s_focus_timer);
     }
 
-    focus_stream_sample_now();
+    if (s_focus_stream_active) {
+        focus_stream_release_board();
+    }
+
+    // From here on the focus stream is the only reader of the board
+    sensor_manager_set_external_reader(address);
+
+    // Let the board convert on its own and only read its output register;
+    // fall back to triggered reads on boards without continuous mode
+    if (sensor->config.capability_flags & EZO_CAP_MODE) {
+        if (sensor->config.continuous_mode) {
+            s_focus_continuous = true;
+        } else {
+            sensor_read_guard_t guard;
+            sensor_read_guard_acquire(&guard, address);
+            esp_err_t ret = ezo_sensor_set_continuous_mode(sensor, true);
+            sensor_read_guard_release(&guard);
+            s_focus_continuous = (ret == ESP_OK);
+            s_focus_restore_continuous = (ret == ESP_OK);
+        }
+    }
+
+    s_focus_sensor_address = address;
+    s_focus_stream_active = true;
+
+    uint32_t interval_ms = s_focus_continuous ? FOCUS_STREAM_INTERVAL_MS : FOCUS_SAMPLE_INTERVAL_MS;
+    ESP_LOGI(TAG, "Focus stream on 0x%02X (%s, %lu ms)", address,
+             s_focus_continuous ? "continuous" : "triggered", (unsigned long)interval_ms);
 
-    esp_timer_start_periodic(s_focus_timer, FOCUS_SAMPLE_INTERVAL_MS * 1000ULL);
+    focus_timer_cb(NULL);
+    esp_timer_start_periodic(s_focus_timer, interval_ms * 1000ULL);
     sensor_ws_send_focus_status("started", address);
     return ESP_OK;
 }
@@ -586,50 +1425,20 @@ static void focus_stream_stop(void)
         esp_timer_stop(s_focus_timer);
     }
 
-    if (!s_focus_stream_active && !s_focus_paused_readings) {
+    if (!s_focus_stream_active) {
         return;
     }
 
+    calib_session_end("cancelled", NULL);
     uint8_t last_address = s_focus_sensor_address;
+    focus_stream_release_board();
+    sensor_manager_set_external_reader(0);
     s_focus_stream_active = false;
     s_focus_sensor_address = 0;
 
-    if (s_focus_paused_readings) {
-        sensor_manager_resume_reading();
-        s_focus_paused_readings = false;
-    }
-
     sensor_ws_send_focus_status("stopped", last_address);
 }
 
-static void focus_stream_sample_now(void)
-{
-    if (!s_focus_stream_active) {
-        return;
-    }
-
-    ezo_sensor_t *sensor = find_sensor_by_address(s_focus_sensor_address);
-    if (sensor == NULL) {
-        ESP_LOGW(TAG, "Focus sensor 0x%02X not found", s_focus_sensor_address);
-        focus_stream_stop();
-        return;
-    }
-
-    float values[4] = {0};
-    uint8_t count = 0;
-
-    sensor_read_guard_t guard;
-    sensor_read_guard_acquire(&guard);
-    esp_err_t ret = ezo_sensor_read_all(sensor, values, &count);
-    sensor_read_guard_release(&guard);
-
-    if (ret == ESP_OK && count > 0) {
-        sensor_ws_send_focus_sample(sensor, values, count);
-    } else {
-        ESP_LOGW(TAG, "Focus read failed for 0x%02X: %s", sensor->config.i2c_address, esp_err_to_name(ret));
-    }
-}
-
 static void handle_ws_command(int client_fd, const char *payload, size_t len)
 {
     if (payload == NULL || len == 0) {
@@ -646,6 +1455,8 @@ static void handle_ws_command(int client_fd, const char *payload, size_t len)
     if (cJSON_IsString(action) && action->valuestring != NULL) {
         if (strcmp(action->valuestring, "request_snapshot") == 0) {
             sensor_ws_send_snapshot_to_client(client_fd);
+        } else if (strcmp(action->valuestring, "request_status") == 0) {
+            sensor_ws_send_device_status(client_fd);
         } else if (strcmp(action->valuestring, "focus_start") == 0) {
             cJSON *addr = cJSON_GetObjectItem(root, "address");
             if (cJSON_IsNumber(addr)) {
@@ -657,6 +1468,17 @@ static void handle_ws_command(int client_fd, const char *payload, size_t len)
             }
         } else if (strcmp(action->valuestring, "focus_stop") == 0) {
             focus_stream_stop();
+        } else if (strcmp(action->valuestring, "calibration_start") == 0) {
+            calib_session_start(root);
+        } else if (strcmp(action->valuestring, "calibration_commit") == 0) {
+            calib_session_commit(root);
+        } else if (strcmp(action->valuestring, "calibration_cancel") == 0) {
+            calib_session_end("cancelled", NULL);
+        } else if (strcmp(action->valuestring, "set_protocol") == 0) {
+            cJSON *protocol = cJSON_GetObjectItem(root, "protocol");
+            if (cJSON_IsString(protocol) && protocol->valuestring != NULL) {
+                sensor_ws_set_client_protocol(client_fd, strcmp(protocol->valuestring, "binary") == 0);
+            }
         }
     }
 
@@ -697,170 +1519,225 @@ static ezo_sensor_t *find_sensor_by_address(uint8_t address)
     return NULL;
 }
 
-static void add_capabilities_array(cJSON *parent, uint32_t flags)
+static void write_capabilities_json(json_writer_t *w, uint32_t flags)
 {
-    cJSON *caps = cJSON_CreateArray();
-    if (caps == NULL) {
-        return;
-    }
-    if (flags & EZO_CAP_CALIBRATION) cJSON_AddItemToArray(caps, cJSON_CreateString("calibration"));
-    if (flags & EZO_CAP_TEMP_COMP)   cJSON_AddItemToArray(caps, cJSON_CreateString("temp_comp"));
-    if (flags & EZO_CAP_MODE)        cJSON_AddItemToArray(caps, cJSON_CreateString("mode"));
-    if (flags & EZO_CAP_SLEEP)       cJSON_AddItemToArray(caps, cJSON_CreateString("sleep"));
-    if (flags & EZO_CAP_OFFSET)      cJSON_AddItemToArray(caps, cJSON_CreateString("offset"));
-    cJSON_AddItemToObject(parent, "capabilities", caps);
+    json_writer_key(w, "capabilities");
+    json_writer_array_begin(w);
+    if (flags & EZO_CAP_CALIBRATION) json_writer_string(w, "calibration");
+    if (flags & EZO_CAP_TEMP_COMP)   json_writer_string(w, "temp_comp");
+    if (flags & EZO_CAP_MODE)        json_writer_string(w, "mode");
+    if (flags & EZO_CAP_SLEEP)       json_writer_string(w, "sleep");
+    if (flags & EZO_CAP_OFFSET)      json_writer_string(w, "offset");
+    json_writer_array_end(w);
 }
 
-static void append_sensor_runtime_info(cJSON *json, ezo_sensor_t *sensor)
+static void write_sensor_runtime_json(json_writer_t *w, const ezo_sensor_t *sensor)
 {
-    if (json == NULL || sensor == NULL) {
-        return;
-    }
-
     if (sensor->config.capability_flags & EZO_CAP_CALIBRATION) {
         if (sensor->config.calibration_status_valid && sensor->config.calibration_status[0] != '\0') {
-            cJSON_AddStringToObject(json, "calibration_status", sensor->config.calibration_status);
+            json_writer_kv_string(w, "calibration_status", sensor->config.calibration_status);
         } else {
-            cJSON_AddStringToObject(json, "calibration_status", "unknown");
+            json_writer_kv_string(w, "calibration_status", "unknown");
         }
     }
 
-    if ((sensor->config.capability_flags & EZO_CAP_TEMP_COMP) && strcmp(sensor->config.type, EZO_TYPE_PH) == 0) {
+    if ((sensor->config.capability_flags & EZO_CAP_TEMP_COMP) && sensor->config.kind == EZO_KIND_PH) {
         if (sensor->config.temp_comp_valid) {
-            cJSON_AddNumberToObject(json, "temperature_comp", sensor->config.temp_compensation);
+            json_writer_kv_float(w, "temperature_comp", sensor->config.temp_compensation);
         }
     }
 
     if (sensor->config.capability_flags & EZO_CAP_MODE) {
-        cJSON_AddBoolToObject(json, "continuous_mode", sensor->config.continuous_mode);
+        json_writer_kv_bool(w, "continuous_mode", sensor->config.continuous_mode);
     }
 
     if (sensor->config.capability_flags & EZO_CAP_SLEEP) {
-        cJSON_AddBoolToObject(json, "sleeping", sensor->config.sleeping);
+        json_writer_kv_bool(w, "sleeping", sensor->config.sleeping);
     }
 }
 
-static void add_sample_readings_to_json(cJSON *json, const char *type, const float values[], uint8_t count)
+static void write_sample_readings_json(json_writer_t *w, const ezo_sensor_t *sensor, const float values[], uint8_t count)
 {
-    if (json == NULL || type == NULL || values == NULL || count == 0) {
-        return;
-    }
-
-    bool is_multi_value = false;
-    if (strcmp(type, EZO_TYPE_EC) == 0 || strcmp(type, EZO_TYPE_HUM) == 0 || strcmp(type, EZO_TYPE_DO) == 0) {
-        is_multi_value = true;
-    }
-
-    if (!is_multi_value && count == 1) {
-        cJSON_AddNumberToObject(json, "reading", values[0]);
+    if (values == NULL || count == 0) {
         return;
     }
 
-    cJSON *reading = cJSON_CreateObject();
-    if (reading == NULL) {
+    const ezo_sensor_desc_t *desc = ezo_sensor_desc(sensor->config.kind);
+    if (desc->channel_count <= 1 && count == 1) {
+        json_writer_kv_float(w, "reading", values[0]);
         return;
     }
 
-    if (strcmp(type, EZO_TYPE_EC) == 0) {
-        if (count >= 1) cJSON_AddNumberToObject(reading, "conductivity", values[0]);
-        if (count >= 2) cJSON_AddNumberToObject(reading, "tds", values[1]);
-        if (count >= 3) cJSON_AddNumberToObject(reading, "salinity", values[2]);
-        if (count >= 4) cJSON_AddNumberToObject(reading, "specific_gravity", values[3]);
-    } else if (strcmp(type, EZO_TYPE_HUM) == 0) {
-        if (count >= 1) cJSON_AddNumberToObject(reading, "humidity", values[0]);
-        if (count >= 2) cJSON_AddNumberToObject(reading, "air_temp", values[1]);
-        if (count >= 3) cJSON_AddNumberToObject(reading, "dew_point", values[2]);
-    } else if (strcmp(type, EZO_TYPE_DO) == 0) {
-        if (count >= 1) cJSON_AddNumberToObject(reading, "dissolved_oxygen", values[0]);
-        if (count >= 2) cJSON_AddNumberToObject(reading, "saturation", values[1]);
-    } else {
-        for (uint8_t i = 0; i < count; i++) {
+    const char *names[EZO_MAX_CHANNELS];
+    bool named = sample_value_names(sensor, names);
+    json_writer_key(w, "reading");
+    json_writer_object_begin(w);
+    for (uint8_t i = 0; i < count && i < EZO_MAX_CHANNELS; i++) {
+        if (named && names[i] != NULL) {
+            json_writer_kv_float(w, names[i], values[i]);
+        } else if (!named) {
             char key[12];
             snprintf(key, sizeof(key), "value%d", i + 1);
-            cJSON_AddNumberToObject(reading, key, values[i]);
+            json_writer_kv_float(w, key, values[i]);
         }
     }
-
-    cJSON_AddItemToObject(json, "reading", reading);
+    json_writer_object_end(w);
 }
 
-static cJSON *build_sensor_json(ezo_sensor_t *sensor, int index, bool include_runtime)
+/**
+ * @brief Write one sensor as a JSON object straight from its ezo_sensor_config_t
+ *
+ * @param index Position in the sensor list, or -1 to omit
+ * @param values Latest reading to include as "raw"/"reading", or NULL
+ */
+static void write_sensor_json(json_writer_t *w, const ezo_sensor_t *sensor, int index, bool include_runtime,
+                              const float *values, uint8_t count, uint64_t timestamp_ms)
 {
-    if (sensor == NULL) {
-        return NULL;
+    json_writer_object_begin(w);
+    if (index >= 0) {
+        json_writer_kv_int(w, "index", index);
+    }
+    json_writer_kv_int(w, "address", sensor->config.i2c_address);
+    json_writer_kv_int(w, "bus", i2c_arbiter_get_device_bus(sensor->config.i2c_address));
+    json_writer_kv_bool(w, "offline", sensor_manager_is_ezo_offline(sensor->config.i2c_address));
+    json_writer_kv_string(w, "type", sensor->config.type);
+    json_writer_kv_string(w, "name", sensor->config.name);
+    json_writer_kv_string(w, "firmware", sensor->config.firmware_version);
+    json_writer_kv_bool(w, "led", sensor->config.led_control);
+    json_writer_kv_bool(w, "plock", sensor->config.protocol_lock);
+    write_capabilities_json(w, sensor->config.capability_flags);
+
+    if (sensor->config.kind == EZO_KIND_RTD) {
+        json_writer_kv_string(w, "scale", (const char[]){sensor->config.rtd.temperature_scale, '\0'});
+    } else if (sensor->config.kind == EZO_KIND_PH) {
+        json_writer_kv_bool(w, "extended_scale", sensor->config.ph.extended_scale);
+    } else if (sensor->config.kind == EZO_KIND_EC) {
+        json_writer_kv_int(w, "probe_type", sensor->config.ec.probe_type);
+        json_writer_kv_float(w, "tds_factor", sensor->config.ec.tds_conversion_factor);
     }
 
-    cJSON *obj = cJSON_CreateObject();
-    if (obj == NULL) {
-        return NULL;
+    if (include_runtime) {
+        write_sensor_runtime_json(w, sensor);
     }
 
-    if (index >= 0) {
-        cJSON_AddNumberToObject(obj, "index", index);
+    if (values != NULL && count > 0) {
+        json_writer_kv_int(w, "timestamp_ms", (int64_t)timestamp_ms);
+        json_writer_kv_int(w, "value_count", count);
+        json_writer_key(w, "raw");
+        json_writer_array_begin(w);
+        for (uint8_t i = 0; i < count; i++) {
+            json_writer_float(w, values[i]);
+        }
+        json_writer_array_end(w);
+        write_sample_readings_json(w, sensor, values, count);
     }
-    cJSON_AddNumberToObject(obj, "address", sensor->config.i2c_address);
-    cJSON_AddStringToObject(obj, "type", sensor->config.type);
-    cJSON_AddStringToObject(obj, "name", sensor->config.name);
-    cJSON_AddStringToObject(obj, "firmware", sensor->config.firmware_version);
-    cJSON_AddBoolToObject(obj, "led", sensor->config.led_control);
-    cJSON_AddBoolToObject(obj, "plock", sensor->config.protocol_lock);
-    add_capabilities_array(obj, sensor->config.capability_flags);
+    json_writer_object_end(w);
+}
 
-    if (strcmp(sensor->config.type, EZO_TYPE_RTD) == 0) {
-        cJSON_AddStringToObject(obj, "scale", (const char[]){sensor->config.rtd.temperature_scale, '\0'});
-    } else if (strcmp(sensor->config.type, EZO_TYPE_PH) == 0) {
-        cJSON_AddBoolToObject(obj, "extended_scale", sensor->config.ph.extended_scale);
-    } else if (strcmp(sensor->config.type, EZO_TYPE_EC) == 0) {
-        cJSON_AddNumberToObject(obj, "probe_type", sensor->config.ec.probe_type);
-        cJSON_AddNumberToObject(obj, "tds_factor", sensor->config.ec.tds_conversion_factor);
-    }
+/**
+ * @brief json_writer sink that streams into a chunked HTTP response
+ */
+static esp_err_t json_writer_httpd_sink(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len);
+}
 
-    if (include_runtime) {
-        append_sensor_runtime_info(obj, sensor);
-    }
+/**
+ * @brief Send {"status":"success","sensor":{...}} as a chunked response
+ */
+static esp_err_t send_sensor_json_response(httpd_req_t *req, const ezo_sensor_t *sensor,
+                                           const float *values, uint8_t count, uint64_t timestamp_ms)
+{
+    char chunk[HTTP_JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), json_writer_httpd_sink, req);
 
-    return obj;
+    httpd_resp_set_type(req, "application/json");
+    json_writer_object_begin(&w);
+    json_writer_kv_string(&w, "status", "success");
+    json_writer_key(&w, "sensor");
+    write_sensor_json(&w, sensor, -1, true, values, count, timestamp_ms);
+    json_writer_object_end(&w);
+
+    esp_err_t err = json_writer_finish(&w);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Sensor response aborted: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
 }
 
-static cJSON *parse_request_json_body(httpd_req_t *req, char **raw_buffer)
+/**
+ * @brief Read and parse a JSON request body of at most HTTP_JSON_BODY_MAX bytes
+ *
+ * Oversized bodies are refused from Content-Length before anything is read,
+ * so no request can make the server allocate more than the limit. httpd hands
+ * the body over in socket-sized pieces, which are collected into one bounded
+ * buffer that is freed as soon as cJSON has parsed it.
+ *
+ * @return Parsed JSON, or NULL after an error response has been sent
+ */
+static cJSON *parse_request_json_body(httpd_req_t *req)
 {
     if (req->content_len <= 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Empty request");
+        return NULL;
+    }
+    if (req->content_len > HTTP_JSON_BODY_MAX) {
+        httpd_resp_send_err(req, HTTPD_413_CONTENT_TOO_LARGE, "Request body too large");
         return NULL;
     }
 
     char *buffer = malloc(req->content_len + 1);
     if (buffer == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
         return NULL;
     }
 
-    int total = 0;
+    size_t total = 0;
     while (total < req->content_len) {
         int received = httpd_req_recv(req, buffer + total, req->content_len - total);
         if (received <= 0) {
             free(buffer);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Failed to read request");
             return NULL;
         }
         total += received;
     }
-    buffer[total] = '\0';
 
-    cJSON *json = cJSON_Parse(buffer);
+    cJSON *json = cJSON_ParseWithLength(buffer, total);
+    free(buffer);
     if (json == NULL) {
-        free(buffer);
-        if (raw_buffer != NULL) {
-            *raw_buffer = NULL;
-        }
-        return NULL;
-    }
-
-    if (raw_buffer != NULL) {
-        *raw_buffer = buffer;
-    } else {
-        free(buffer);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
     }
     return json;
 }
 
+/**
+ * @brief Run a handler with its cJSON allocations in a request arena
+ *
+ * user_ctx carries the handler's own httpd_uri_t (see http_register_arena_handler).
+ */
+static esp_err_t http_arena_handler(httpd_req_t *req)
+{
+    const httpd_uri_t *uri = (const httpd_uri_t *)req->user_ctx;
+    json_arena_t *arena = json_arena_begin();
+    esp_err_t ret = uri->handler(req);
+    json_arena_end(arena);
+    return ret;
+}
+
+/**
+ * @brief Register a handler whose cJSON documents do not outlive the request
+ */
+static esp_err_t http_register_arena_handler(httpd_handle_t server, const httpd_uri_t *uri)
+{
+    httpd_uri_t wrapped = *uri;
+    wrapped.handler = http_arena_handler;
+    wrapped.user_ctx = (void *)uri;
+    return httpd_register_uri_handler(server, &wrapped);
+}
+
 /**
  * @brief Favicon handler - return 204 No Content to avoid 404 errors
  */
@@ -872,110 +1749,220 @@ static esp_err_t favicon_handler(httpd_req_t *req)
 }
 
 /**
- * @brief Root handler - serve dashboard from on-device filesystem or embedded fallback
+ * @brief Check if the client accepts gzip-encoded responses
  */
-static esp_err_t root_handler(httpd_req_t *req)
+static bool client_accepts_gzip(httpd_req_t *req)
 {
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_set_hdr(req, "Connection", "keep-alive");
-    httpd_resp_set_hdr(req, "Cache-Control", "no-cache, no-store, must-revalidate");
-    httpd_resp_set_hdr(req, "Pragma", "no-cache");
-    httpd_resp_set_hdr(req, "Expires", "0");
-    
-    // Try to load from the writable filesystem first
-    char *content = NULL;
-    size_t size = 0;
-    if (web_editor_load_file("index.html", &content, &size) == ESP_OK) {
-        ESP_LOGI(TAG, "Serving index.html from FATFS (%d bytes)", size);
-        httpd_resp_send(req, content, size);
-        free(content);
-        return ESP_OK;
-    }
-    
-    // Fallback to embedded HTML
-    ESP_LOGI(TAG, "Serving index.html from embedded image (filesystem read failed)");
-    const size_t html_size = index_html_end - index_html_start;
-    httpd_resp_send(req, (const char *)index_html_start, html_size);
-    return ESP_OK;
+    char accept_encoding[64];
+    esp_err_t ret = httpd_req_get_hdr_value_str(req, "Accept-Encoding", accept_encoding, sizeof(accept_encoding));
+    return (ret == ESP_OK || ret == ESP_ERR_HTTPD_RESULT_TRUNC) && strstr(accept_encoding, "gzip") != NULL;
 }
 
 /**
- * @brief API status endpoint - return device status as JSON
+ * @brief Send an asset body, passing gzip data through when the client accepts it
  */
-static esp_err_t api_status_handler(httpd_req_t *req)
+static esp_err_t send_asset_body(httpd_req_t *req, const char *data, size_t size, bool gzip, bool accepts_gzip)
 {
-    cJSON *root = cJSON_CreateObject();
+    if (!gzip) {
+        return httpd_resp_send(req, data, size);
+    }
+    if (accepts_gzip) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+        return httpd_resp_send(req, data, size);
+    }
+    
+    // Rare client without gzip support: inflate on the device
+    char *text = NULL;
+    size_t text_size = 0;
+    esp_err_t ret = web_editor_gunzip(data, size, &text, &text_size);
+    if (ret != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Asset decode failed");
+        return ret;
+    }
+    ret = httpd_resp_send(req, text, text_size);
+    free(text);
+    return ret;
+}
+
+/**
+ * @brief Serve a dashboard asset from the in-memory cache with ETag revalidation
+ *
+ * Browsers keep the asset and revalidate on every load ("no-cache"), so edits
+ * show up immediately while unchanged files cost a 304 instead of a TLS transfer.
+ * Compressed assets go out as-is with Content-Encoding: gzip.
+ *
+ * @return ESP_OK once a response was sent, otherwise the cache error (nothing sent)
+ */
+static esp_err_t send_cached_asset(httpd_req_t *req, const char *filename)
+{
+    const char *content = NULL;
+    size_t size = 0;
+    bool gzip = false;
+    const char *etag = NULL;
+    esp_err_t ret = web_editor_get_cached_file(filename, &content, &size, &gzip, &etag);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    httpd_resp_set_type(req, web_editor_get_content_type(filename));
+    httpd_resp_set_hdr(req, "Connection", "keep-alive");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    
+    // The ETag names the stored (possibly gzip) bytes, so an inflated copy goes out without one
+    bool accepts_gzip = client_accepts_gzip(req);
+    if (gzip) {
+        httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    }
+    if (!gzip || accepts_gzip) {
+        httpd_resp_set_hdr(req, "ETag", etag);
+        
+        char if_none_match[64];
+        if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) == ESP_OK &&
+            (strstr(if_none_match, etag) != NULL || strcmp(if_none_match, "*") == 0)) {
+            httpd_resp_set_status(req, "304 Not Modified");
+            httpd_resp_send(req, NULL, 0);
+            return ESP_OK;
+        }
+    }
+    
+    send_asset_body(req, content, size, gzip, accepts_gzip);
+    return ESP_OK;
+}
+
+/**
+ * @brief Root handler - serve dashboard from on-device filesystem or embedded fallback
+ */
+static esp_err_t root_handler(httpd_req_t *req)
+{
+    // Cached copy of the writable filesystem version first
+    if (send_cached_asset(req, "index.html") == ESP_OK) {
+        return ESP_OK;
+    }
+    
+    // Fallback to embedded HTML
+    ESP_LOGI(TAG, "Serving index.html from embedded image (filesystem read failed)");
+    httpd_resp_set_type(req, "text/html");
+    httpd_resp_set_hdr(req, "Connection", "keep-alive");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache, no-store, must-revalidate");
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    const size_t html_size = index_html_gz_end - index_html_gz_start;
+    send_asset_body(req, (const char *)index_html_gz_start, html_size, true, client_accepts_gzip(req));
+    return ESP_OK;
+}
+
+/**
+ * @brief API status endpoint - return device status as JSON
+ */
+static esp_err_t api_status_handler(httpd_req_t *req)
+{
+    char chunk[HTTP_JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), json_writer_httpd_sink, req);
+    
+    httpd_resp_set_type(req, "application/json");
+    json_writer_object_begin(&w);
     
     // Device ID
     char device_id[32];
     cloud_prov_get_device_id(device_id, sizeof(device_id));
-    cJSON_AddStringToObject(root, "device_id", device_id);
+    json_writer_kv_string(&w, "device_id", device_id);
     
     // WiFi SSID
     char ssid[33];
     char password[64];
     if (wifi_manager_get_stored_credentials(ssid, password) == ESP_OK) {
-        cJSON_AddStringToObject(root, "wifi_ssid", ssid);
+        json_writer_kv_string(&w, "wifi_ssid", ssid);
         memset(password, 0, sizeof(password)); // Clear password
     } else {
-        cJSON_AddStringToObject(root, "wifi_ssid", "Not configured");
+        json_writer_kv_string(&w, "wifi_ssid", "Not configured");
     }
     
     // IP Address
     if (wifi_manager_is_connected()) {
         // TODO: Get actual IP address from WiFi manager
-        cJSON_AddStringToObject(root, "ip_address", "Connected");
+        json_writer_kv_string(&w, "ip_address", "Connected");
     } else {
-        cJSON_AddStringToObject(root, "ip_address", "Disconnected");
+        json_writer_kv_string(&w, "ip_address", "Disconnected");
     }
     
     // WiFi RSSI
     if (wifi_manager_is_connected()) {
         wifi_ap_record_t ap_info;
         if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
-            cJSON_AddNumberToObject(root, "rssi", ap_info.rssi);
+            json_writer_kv_int(&w, "rssi", ap_info.rssi);
         }
     }
     
     // Uptime
-    cJSON_AddNumberToObject(root, "uptime", esp_timer_get_time() / 1000000);
+    json_writer_kv_int(&w, "uptime", esp_timer_get_time() / 1000000);
     
     // Current time
     char time_str[64];
     if (time_sync_get_time_string(time_str, sizeof(time_str), NULL) == ESP_OK) {
-        cJSON_AddStringToObject(root, "current_time", time_str);
+        json_writer_kv_string(&w, "current_time", time_str);
     } else {
-        cJSON_AddStringToObject(root, "current_time", "Not synced");
+        json_writer_kv_string(&w, "current_time", "Not synced");
     }
     
-    // Free heap
-    cJSON_AddNumberToObject(root, "free_heap", esp_get_free_heap_size());
+    // Free heap, plus fragmentation per region
+    json_writer_kv_int(&w, "free_heap", esp_get_free_heap_size());
+    json_writer_key(&w, "memory");
+    mem_monitor_write_json(&w, false);
+    
+    // CPU usage over the profiler's last window (idle-task run time)
+    int cpu_usage = perf_monitor_cpu_usage();
+    if (cpu_usage >= 0) {
+        json_writer_kv_int(&w, "cpu_usage", cpu_usage);
+    }
     
-    // CPU usage (simplified estimate based on idle task)
-    // TODO: Implement more accurate CPU monitoring
-    cJSON_AddNumberToObject(root, "cpu_usage", 25);
+    // TLS sessions and handshake cost
+    json_writer_key(&w, "http");
+    http_write_connection_stats(&w);
     
     // Get cached sensor data from sensor_manager (non-blocking, no I2C operations)
     sensor_cache_t cache;
     if (sensor_manager_get_cached_data(&cache) == ESP_OK) {
         if (cache.battery_valid) {
-            cJSON_AddNumberToObject(root, "battery", cache.battery_percentage);
+            json_writer_kv_float(&w, "battery", cache.battery_percentage);
         }
 
-        cJSON *sensors = create_sensors_object_from_cache(&cache);
-        if (sensors != NULL) {
-            cJSON_AddItemToObject(root, "sensors", sensors);
+        json_writer_key(&w, "sensors");
+        telemetry_write_sensors_json(&w, &cache);
+        telemetry_write_derived_json(&w, &cache);
+
+        // Values as read from the boards, and what signal conditioning made of them
+        json_writer_key(&w, "sensors_raw");
+        json_writer_object_begin(&w);
+        for (uint8_t i = 0; i < cache.sensor_count && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
+            const cached_sensor_t *sensor = &cache.sensors[i];
+            if (sensor->valid) {
+                char key[24];
+                telemetry_write_keyed_sensor_json(&w, telemetry_sensor_key(&cache, i, key, sizeof(key)),
+                                                  sensor->sensor_type, sensor->raw_values, sensor->value_count, NULL);
+            }
+        }
+        json_writer_object_end(&w);
+
+        json_writer_key(&w, "sensor_quality");
+        json_writer_object_begin(&w);
+        for (uint8_t i = 0; i < cache.sensor_count && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
+            const cached_sensor_t *sensor = &cache.sensors[i];
+            if (sensor->valid) {
+                char key[24];
+                json_writer_kv_string(&w, telemetry_sensor_key(&cache, i, key, sizeof(key)),
+                                      signal_filter_quality_name((sensor_quality_t)sensor->quality));
+            }
         }
+        json_writer_object_end(&w);
     }
     
-    // Send JSON response
-    const char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, HTTPD_RESP_USE_STRLEN);
-    
-    free((void *)json_str);
-    cJSON_Delete(root);
-    return ESP_OK;
+    json_writer_object_end(&w);
+    esp_err_t err = json_writer_finish(&w);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Status response aborted: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
 }
 
 static esp_err_t sensor_ws_handler(httpd_req_t *req)
@@ -984,6 +1971,7 @@ static esp_err_t sensor_ws_handler(httpd_req_t *req)
     if (req->method == HTTP_GET) {
         sensor_ws_add_client(client_fd);
         sensor_ws_send_snapshot_to_client(client_fd);
+        sensor_ws_send_device_status(client_fd);
         return ESP_OK;
     }
 
@@ -1097,34 +2085,110 @@ static esp_err_t api_settings_handler(httpd_req_t *req)
         // Get current MQTT telemetry interval
         uint32_t mqtt_interval = mqtt_get_telemetry_interval();
         cJSON_AddNumberToObject(root, "mqtt_interval", mqtt_interval);
+
+        cJSON_AddStringToObject(root, "mqtt_format",
+                                mqtt_get_payload_format() == MQTT_PAYLOAD_CBOR ? "cbor" : "json");
+
+        // Batched publishing: N samples or T seconds per message
+        cJSON_AddNumberToObject(root, "mqtt_batch_size", mqtt_get_batch_size());
+        cJSON_AddNumberToObject(root, "mqtt_batch_window", mqtt_get_batch_window());
+
+        // MQTT 5 (topic aliases, user properties, expiry); applies after reboot
+        cJSON_AddBoolToObject(root, "mqtt_v5", mqtt_get_protocol_v5());
+
+        // Duty-cycled deep sleep on battery nodes
+        cJSON_AddBoolToObject(root, "low_power", power_manager_get_low_power());
+        cJSON_AddNumberToObject(root, "low_power_interval", power_manager_get_interval());
+
+        // Change-driven publishing: [{"sensor":"pH","index":0,"threshold":0.05}, ...]
+        cJSON_AddNumberToObject(root, "mqtt_heartbeat", mqtt_get_heartbeat_interval());
+        cJSON *deadbands = cJSON_AddArrayToObject(root, "mqtt_deadband");
+        mqtt_deadband_t entries[MQTT_DEADBAND_MAX_CHANNELS];
+        uint8_t deadband_count = mqtt_get_deadbands(entries, MQTT_DEADBAND_MAX_CHANNELS);
+        for (uint8_t i = 0; deadbands != NULL && i < deadband_count; i++) {
+            cJSON *entry = cJSON_CreateObject();
+            cJSON_AddStringToObject(entry, "sensor", entries[i].sensor_type);
+            if (entries[i].value_index != MQTT_DEADBAND_ALL_VALUES) {
+                cJSON_AddNumberToObject(entry, "index", entries[i].value_index);
+            }
+            cJSON_AddNumberToObject(entry, "threshold", entries[i].threshold);
+            cJSON_AddItemToArray(deadbands, entry);
+        }
+
+        // Local alarms: [{"sensor":"pH","index":0,"kind":"above","threshold":6.5,"hysteresis":0.1,"debounce":3}, ...]
+        cJSON *alarms = cJSON_AddArrayToObject(root, "alarm_rules");
+        alarm_rule_t rules[ALARM_RULES_MAX];
+        uint8_t rule_count = alarm_rules_get(rules, ALARM_RULES_MAX);
+        for (uint8_t i = 0; alarms != NULL && i < rule_count; i++) {
+            cJSON *entry = cJSON_CreateObject();
+            cJSON_AddStringToObject(entry, "sensor", rules[i].sensor_type);
+            cJSON_AddNumberToObject(entry, "index", rules[i].value_index);
+            cJSON_AddStringToObject(entry, "kind", alarm_rules_kind_name(rules[i].kind));
+            cJSON_AddNumberToObject(entry, "threshold", rules[i].threshold);
+            cJSON_AddNumberToObject(entry, "hysteresis", rules[i].hysteresis);
+            cJSON_AddNumberToObject(entry, "debounce", rules[i].debounce);
+            cJSON_AddBoolToObject(entry, "active", alarm_rules_is_active(i));
+            cJSON_AddItemToArray(alarms, entry);
+        }
         
         // Get sensor reading interval
         uint32_t sensor_interval = sensor_manager_get_reading_interval();
         cJSON_AddNumberToObject(root, "sensor_interval", sensor_interval);
+
+        // Get EZO acquisition mode
+        cJSON_AddStringToObject(root, "sensor_acq_mode",
+                                sensor_manager_get_acquisition_mode() == SENSOR_ACQ_MODE_POLLED ? "polled" : "fixed");
+
+        // Per-sensor schedules (interval 0 = follow sensor_interval)
+        cJSON *schedules = cJSON_AddArrayToObject(root, "sensor_schedules");
+        uint8_t ezo_count = sensor_manager_get_ezo_count();
+        for (uint8_t i = 0; schedules != NULL && i < ezo_count; i++) {
+            ezo_sensor_t *sensor = (ezo_sensor_t*)sensor_manager_get_ezo_sensor(i);
+            if (sensor == NULL) {
+                continue;
+            }
+            cJSON *entry = cJSON_CreateObject();
+            cJSON_AddNumberToObject(entry, "address", sensor->config.i2c_address);
+            cJSON_AddStringToObject(entry, "type", sensor->config.type);
+            cJSON_AddNumberToObject(entry, "interval", sensor_manager_get_sensor_interval(sensor->config.i2c_address));
+            cJSON_AddItemToArray(schedules, entry);
+        }
+
+        // Signal conditioning per detected sensor type
+        cJSON *filters = cJSON_AddArrayToObject(root, "signal_filters");
+        for (uint8_t i = 0; filters != NULL && i < ezo_count; i++) {
+            ezo_sensor_t *sensor = (ezo_sensor_t*)sensor_manager_get_ezo_sensor(i);
+            if (sensor == NULL) {
+                continue;
+            }
+            signal_filter_config_t config;
+            signal_filter_get_config(sensor->config.type, &config);
+            cJSON *entry = cJSON_CreateObject();
+            cJSON_AddStringToObject(entry, "type", sensor->config.type);
+            cJSON_AddStringToObject(entry, "mode", signal_filter_mode_name(config.mode));
+            cJSON_AddNumberToObject(entry, "window", config.window);
+            cJSON_AddNumberToObject(entry, "alpha", config.alpha);
+            cJSON_AddNumberToObject(entry, "process_noise", config.process_noise);
+            cJSON_AddNumberToObject(entry, "measurement_noise", config.measurement_noise);
+            cJSON_AddNumberToObject(entry, "spike_k", config.spike_k);
+            cJSON_AddNumberToObject(entry, "spike_floor", config.spike_floor);
+            cJSON_AddNumberToObject(entry, "spike_rel", config.spike_rel);
+            cJSON_AddItemToArray(filters, entry);
+        }
         
         char *json_str = cJSON_PrintUnformatted(root);
         cJSON_Delete(root);
         
         httpd_resp_set_type(req, "application/json");
         httpd_resp_sendstr(req, json_str);
-        free(json_str);
+        cJSON_free(json_str);
         
         return ESP_OK;
     }
     
     // Handle POST request - update settings
-    char content[200];
-    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
-    if (ret <= 0) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid request");
-        return ESP_FAIL;
-    }
-    content[ret] = '\0';
-    
-    // Parse JSON
-    cJSON *root = cJSON_Parse(content);
+    cJSON *root = parse_request_json_body(req);
     if (root == NULL) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
         return ESP_FAIL;
     }
     
@@ -1145,6 +2209,151 @@ static esp_err_t api_settings_handler(httpd_req_t *req)
         }
     }
     
+    // Update data topic payload format if present ("json" or "cbor")
+    cJSON *mqtt_format = cJSON_GetObjectItem(root, "mqtt_format");
+    if (mqtt_format != NULL && cJSON_IsString(mqtt_format)) {
+        if (strcmp(mqtt_format->valuestring, "json") == 0) {
+            mqtt_set_payload_format(MQTT_PAYLOAD_JSON);
+        } else if (strcmp(mqtt_format->valuestring, "cbor") == 0) {
+            mqtt_set_payload_format(MQTT_PAYLOAD_CBOR);
+        } else {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "mqtt_format must be 'json' or 'cbor'");
+            return ESP_FAIL;
+        }
+    }
+
+    // Update batching if present
+    cJSON *batch_size = cJSON_GetObjectItem(root, "mqtt_batch_size");
+    if (batch_size != NULL && cJSON_IsNumber(batch_size)) {
+        if (batch_size->valueint < 0 || batch_size->valueint > MQTT_BATCH_MAX_SAMPLES) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Batch size must be 0-16");
+            return ESP_FAIL;
+        }
+        mqtt_set_batch_size((uint8_t)batch_size->valueint);
+    }
+    cJSON *batch_window = cJSON_GetObjectItem(root, "mqtt_batch_window");
+    if (batch_window != NULL && cJSON_IsNumber(batch_window)) {
+        if (batch_window->valueint < 0) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Batch window must be >= 0");
+            return ESP_FAIL;
+        }
+        mqtt_set_batch_window((uint32_t)batch_window->valueint);
+    }
+
+    // Update MQTT protocol version if present (takes effect on the next connection init)
+    cJSON *mqtt_v5 = cJSON_GetObjectItem(root, "mqtt_v5");
+    if (mqtt_v5 != NULL && cJSON_IsBool(mqtt_v5)) {
+        if (mqtt_set_protocol_v5(cJSON_IsTrue(mqtt_v5)) != ESP_OK) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "MQTT 5 not supported by this build");
+            return ESP_FAIL;
+        }
+    }
+
+    // Update low-power sleep period if present
+    cJSON *low_power_interval = cJSON_GetObjectItem(root, "low_power_interval");
+    if (low_power_interval != NULL && cJSON_IsNumber(low_power_interval)) {
+        if (low_power_interval->valueint < POWER_MIN_INTERVAL_SEC) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Low-power interval must be >= 30 seconds");
+            return ESP_FAIL;
+        }
+        power_manager_set_interval((uint32_t)low_power_interval->valueint);
+    }
+
+    // Update low-power mode if present (the node sleeps once the power-on window ends)
+    cJSON *low_power = cJSON_GetObjectItem(root, "low_power");
+    if (low_power != NULL && cJSON_IsBool(low_power)) {
+        power_manager_set_low_power(cJSON_IsTrue(low_power));
+    }
+
+    // Update deadband heartbeat if present
+    cJSON *mqtt_heartbeat = cJSON_GetObjectItem(root, "mqtt_heartbeat");
+    if (mqtt_heartbeat != NULL && cJSON_IsNumber(mqtt_heartbeat)) {
+        if (mqtt_heartbeat->valueint < 0) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Heartbeat must be >= 0");
+            return ESP_FAIL;
+        }
+        mqtt_set_heartbeat_interval((uint32_t)mqtt_heartbeat->valueint);
+    }
+
+    // Replace deadband table if present (omit "index" to cover every value of the sensor)
+    cJSON *deadbands = cJSON_GetObjectItem(root, "mqtt_deadband");
+    if (deadbands != NULL && cJSON_IsArray(deadbands)) {
+        mqtt_deadband_t entries[MQTT_DEADBAND_MAX_CHANNELS];
+        uint8_t deadband_count = 0;
+        cJSON *entry = NULL;
+        cJSON_ArrayForEach(entry, deadbands) {
+            cJSON *sensor = cJSON_GetObjectItem(entry, "sensor");
+            cJSON *index = cJSON_GetObjectItem(entry, "index");
+            cJSON *threshold = cJSON_GetObjectItem(entry, "threshold");
+            if (deadband_count >= MQTT_DEADBAND_MAX_CHANNELS || !cJSON_IsString(sensor) ||
+                !cJSON_IsNumber(threshold) || threshold->valuedouble < 0 ||
+                (index != NULL && (!cJSON_IsNumber(index) || index->valueint < 0 ||
+                                   index->valueint >= MAX_SENSOR_VALUES))) {
+                cJSON_Delete(root);
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                                    "Deadband entries need sensor, threshold >= 0 and optional index 0-3");
+                return ESP_FAIL;
+            }
+            mqtt_deadband_t *dst = &entries[deadband_count++];
+            memset(dst, 0, sizeof(*dst));
+            strncpy(dst->sensor_type, sensor->valuestring, sizeof(dst->sensor_type) - 1);
+            dst->value_index = (index != NULL) ? (uint8_t)index->valueint : MQTT_DEADBAND_ALL_VALUES;
+            dst->threshold = (float)threshold->valuedouble;
+        }
+        mqtt_set_deadbands(entries, deadband_count);
+    }
+
+    // Replace the alarm rules if present ("index" defaults to 0, "hysteresis" to 0, "debounce" to 1)
+    cJSON *alarms = cJSON_GetObjectItem(root, "alarm_rules");
+    if (alarms != NULL && cJSON_IsArray(alarms)) {
+        alarm_rule_t rules[ALARM_RULES_MAX];
+        uint8_t rule_count = 0;
+        cJSON *entry = NULL;
+        cJSON_ArrayForEach(entry, alarms) {
+            cJSON *sensor = cJSON_GetObjectItem(entry, "sensor");
+            cJSON *index = cJSON_GetObjectItem(entry, "index");
+            cJSON *kind = cJSON_GetObjectItem(entry, "kind");
+            cJSON *threshold = cJSON_GetObjectItem(entry, "threshold");
+            cJSON *hysteresis = cJSON_GetObjectItem(entry, "hysteresis");
+            cJSON *debounce = cJSON_GetObjectItem(entry, "debounce");
+            int kind_val = cJSON_IsString(kind) ? alarm_rules_kind_from_name(kind->valuestring) : -1;
+            if (rule_count >= ALARM_RULES_MAX || !cJSON_IsString(sensor) || kind_val < 0 ||
+                !cJSON_IsNumber(threshold) ||
+                (index != NULL && (!cJSON_IsNumber(index) || index->valueint < 0 || index->valueint > UINT8_MAX)) ||
+                (hysteresis != NULL && !cJSON_IsNumber(hysteresis)) ||
+                (debounce != NULL && !cJSON_IsNumber(debounce))) {
+                cJSON_Delete(root);
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                                    "Alarm rules need sensor, kind (above/below/rate) and threshold");
+                return ESP_FAIL;
+            }
+            alarm_rule_t *dst = &rules[rule_count++];
+            memset(dst, 0, sizeof(*dst));
+            strncpy(dst->sensor_type, sensor->valuestring, sizeof(dst->sensor_type) - 1);
+            dst->value_index = (index != NULL) ? (uint8_t)index->valueint : 0;
+            dst->kind = (uint8_t)kind_val;
+            dst->threshold = (float)threshold->valuedouble;
+            dst->hysteresis = (hysteresis != NULL) ? (float)hysteresis->valuedouble : 0.0f;
+            if (debounce == NULL) {
+                dst->debounce = 1;
+            } else if (debounce->valueint >= 1 && debounce->valueint <= UINT8_MAX) {
+                dst->debounce = (uint8_t)debounce->valueint;
+            }
+        }
+        if (alarm_rules_set(rules, rule_count) == ESP_ERR_INVALID_ARG) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                                "Alarm rules need an index in range, hysteresis >= 0, a rate >= 0 and debounce 1-10");
+            return ESP_FAIL;
+        }
+    }
+    
     // Update sensor reading interval if present
     cJSON *sensor_interval = cJSON_GetObjectItem(root, "sensor_interval");
     if (sensor_interval != NULL && cJSON_IsNumber(sensor_interval)) {
@@ -1158,6 +2367,94 @@ static esp_err_t api_settings_handler(httpd_req_t *req)
         ESP_LOGI(TAG, "Setting sensor reading interval to %d seconds", interval_val);
         sensor_manager_set_reading_interval(interval_val);
     }
+
+    // Update EZO acquisition mode if present ("polled" or "fixed")
+    cJSON *acq_mode = cJSON_GetObjectItem(root, "sensor_acq_mode");
+    if (acq_mode != NULL && cJSON_IsString(acq_mode)) {
+        sensor_acq_mode_t mode;
+        if (strcmp(acq_mode->valuestring, "polled") == 0) {
+            mode = SENSOR_ACQ_MODE_POLLED;
+        } else if (strcmp(acq_mode->valuestring, "fixed") == 0) {
+            mode = SENSOR_ACQ_MODE_FIXED_WAIT;
+        } else {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "sensor_acq_mode must be 'polled' or 'fixed'");
+            return ESP_FAIL;
+        }
+
+        ESP_LOGI(TAG, "Setting EZO acquisition mode to %s", acq_mode->valuestring);
+        sensor_manager_set_acquisition_mode(mode);
+    }
+
+    // Update per-sensor schedules if present: [{"address":99,"interval":2}, ...]
+    cJSON *schedules = cJSON_GetObjectItem(root, "sensor_schedules");
+    if (schedules != NULL && cJSON_IsArray(schedules)) {
+        cJSON *entry = NULL;
+        cJSON_ArrayForEach(entry, schedules) {
+            cJSON *address = cJSON_GetObjectItem(entry, "address");
+            cJSON *interval = cJSON_GetObjectItem(entry, "interval");
+            if (!cJSON_IsNumber(address) || !cJSON_IsNumber(interval) || interval->valueint < 0) {
+                cJSON_Delete(root);
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Schedule entries need address and interval >= 0");
+                return ESP_FAIL;
+            }
+            if (sensor_manager_set_sensor_interval((uint8_t)address->valueint, (uint32_t)interval->valueint) != ESP_OK) {
+                ESP_LOGW(TAG, "No sensor at 0x%02X for schedule update", address->valueint);
+            }
+        }
+    }
+
+    // Signal conditioning: [{"type":"DO","mode":"median","window":5,"spike_k":4}, {"type":"pH","default":true}, ...]
+    // Fields left out keep their current value
+    cJSON *filters = cJSON_GetObjectItem(root, "signal_filters");
+    if (filters != NULL && cJSON_IsArray(filters)) {
+        cJSON *entry = NULL;
+        cJSON_ArrayForEach(entry, filters) {
+            cJSON *type = cJSON_GetObjectItem(entry, "type");
+            if (!cJSON_IsString(type)) {
+                cJSON_Delete(root);
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Filter entries need a sensor type");
+                return ESP_FAIL;
+            }
+            if (cJSON_IsTrue(cJSON_GetObjectItem(entry, "default"))) {
+                signal_filter_set_config(type->valuestring, NULL);
+                continue;
+            }
+
+            signal_filter_config_t config;
+            signal_filter_get_config(type->valuestring, &config);
+            cJSON *mode = cJSON_GetObjectItem(entry, "mode");
+            bool valid = true;
+            if (mode != NULL) {
+                valid = cJSON_IsString(mode) &&
+                        signal_filter_mode_from_name(mode->valuestring, &config.mode) == ESP_OK;
+            }
+            cJSON *item = cJSON_GetObjectItem(entry, "window");
+            if (cJSON_IsNumber(item)) {
+                valid = valid && item->valueint >= SIGNAL_FILTER_WINDOW_MIN && item->valueint <= SIGNAL_FILTER_WINDOW_MAX;
+                config.window = (uint8_t)item->valueint;
+            }
+            struct { const char *key; float *field; } floats[] = {
+                { "alpha", &config.alpha },
+                { "process_noise", &config.process_noise },
+                { "measurement_noise", &config.measurement_noise },
+                { "spike_k", &config.spike_k },
+                { "spike_floor", &config.spike_floor },
+                { "spike_rel", &config.spike_rel },
+            };
+            for (size_t f = 0; f < sizeof(floats) / sizeof(floats[0]); f++) {
+                item = cJSON_GetObjectItem(entry, floats[f].key);
+                if (cJSON_IsNumber(item)) {
+                    *floats[f].field = (float)item->valuedouble;
+                }
+            }
+            if (!valid || signal_filter_set_config(type->valuestring, &config) != ESP_OK) {
+                cJSON_Delete(root);
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid signal filter settings");
+                return ESP_FAIL;
+            }
+        }
+    }
     
     cJSON_Delete(root);
     
@@ -1174,6 +2471,7 @@ static esp_err_t api_settings_reset_handler(httpd_req_t *req)
 {
     const uint32_t DEFAULT_MQTT_INTERVAL = 10;
     const uint32_t DEFAULT_SENSOR_INTERVAL = 10;
+    const uint32_t DEFAULT_MQTT_HEARTBEAT = 300;
     
     ESP_LOGI(TAG, "Resetting settings to defaults");
     
@@ -1183,6 +2481,25 @@ static esp_err_t api_settings_reset_handler(httpd_req_t *req)
     // Reset sensor interval
     sensor_manager_set_reading_interval(DEFAULT_SENSOR_INTERVAL);
     
+    // Back to plain interval publishing
+    mqtt_set_deadbands(NULL, 0);
+    alarm_rules_set(NULL, 0);
+    mqtt_set_payload_format(MQTT_PAYLOAD_JSON);
+    mqtt_set_heartbeat_interval(DEFAULT_MQTT_HEARTBEAT);
+    mqtt_set_batch_size(0);
+    mqtt_set_batch_window(0);
+    mqtt_set_protocol_v5(false);
+    power_manager_set_low_power(false);
+    power_manager_set_interval(POWER_DEFAULT_INTERVAL_SEC);
+
+    // Built-in signal conditioning for every detected board
+    for (uint8_t i = 0; i < sensor_manager_get_ezo_count(); i++) {
+        ezo_sensor_t *sensor = (ezo_sensor_t*)sensor_manager_get_ezo_sensor(i);
+        if (sensor != NULL) {
+            signal_filter_set_config(sensor->config.type, NULL);
+        }
+    }
+    
     httpd_resp_set_type(req, "application/json");
     httpd_resp_sendstr(req, "{\"status\":\"reset\",\"mqtt_interval\":10,\"sensor_interval\":10}");
     
@@ -1221,185 +2538,330 @@ static esp_err_t api_sensors_list_handler(httpd_req_t *req)
         ESP_LOGW(TAG, "Sensor settings refresh failed: %s", esp_err_to_name(refresh_ret));
     }
 
-    cJSON *root = cJSON_CreateObject();
-    cJSON *sensors = cJSON_CreateArray();
-    
+    char chunk[HTTP_JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), json_writer_httpd_sink, req);
+
+    // Streamed a chunk at a time, so the response size no longer grows with the sensor count
+    httpd_resp_set_type(req, "application/json");
+    json_writer_object_begin(&w);
+    json_writer_key(&w, "sensors");
+    json_writer_array_begin(&w);
+    int count = 0;
+
     // Add battery monitor if available
     if (sensor_manager_has_battery_monitor()) {
-        cJSON *battery = cJSON_CreateObject();
-        cJSON_AddStringToObject(battery, "type", "MAX17048");
-        cJSON_AddNumberToObject(battery, "address", 0x36);
-        cJSON_AddStringToObject(battery, "name", "Battery Monitor");
-        cJSON_AddStringToObject(battery, "description", "Li+ Battery Fuel Gauge");
-        cJSON_AddItemToArray(sensors, battery);
+        json_writer_object_begin(&w);
+        json_writer_kv_string(&w, "type", "MAX17048");
+        json_writer_kv_int(&w, "address", 0x36);
+        json_writer_kv_string(&w, "name", "Battery Monitor");
+        json_writer_kv_string(&w, "description", "Li+ Battery Fuel Gauge");
+        json_writer_object_end(&w);
+        count++;
     }
-    
+
     // Add EZO sensors
     uint8_t ezo_count = sensor_manager_get_ezo_count();
     for (uint8_t i = 0; i < ezo_count; i++) {
         ezo_sensor_t *sensor = (ezo_sensor_t*)sensor_manager_get_ezo_sensor(i);
         if (sensor != NULL) {
-            cJSON *ezo = build_sensor_json(sensor, i, true);
-            if (ezo != NULL) {
-                cJSON_AddItemToArray(sensors, ezo);
-            }
+            write_sensor_json(&w, sensor, i, true, NULL, 0, 0);
+            count++;
         }
     }
-    
-    cJSON_AddItemToObject(root, "sensors", sensors);
-    cJSON_AddNumberToObject(root, "count", cJSON_GetArraySize(sensors));
-    
-    const char *response = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, response);
-    
-    free((void*)response);
-    cJSON_Delete(root);
-    
-    return ESP_OK;
+
+    json_writer_array_end(&w);
+    json_writer_kv_int(&w, "count", count);
+    json_writer_object_end(&w);
+
+    esp_err_t err = json_writer_finish(&w);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Sensor list response aborted: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// Arguments of a queued sensor action; the job function frees them
+typedef struct {
+    uint8_t address;
+    bool flag;                  // continuous (mode) or sleep (power)
+    float value;                // temp_c (compensation)
+    cJSON *body;                // Request body (config)
+} sensor_action_job_t;
+
+static void sensor_action_job_free(sensor_action_job_t *job)
+{
+    if (job != NULL) {
+        cJSON_Delete(job->body);
+        free(job);
+    }
+}
+
+static void write_job_json(json_writer_t *w, const sensor_job_info_t *info, const char *result)
+{
+    json_writer_object_begin(w);
+    json_writer_kv_int(w, "id", info->id);
+    json_writer_kv_string(w, "kind", info->kind);
+    if (info->address != 0) {
+        json_writer_kv_int(w, "address", info->address);
+    }
+    json_writer_kv_string(w, "state", sensor_jobs_state_name(info->state));
+    if (info->finished_us != 0) {
+        json_writer_kv_int(w, "status", info->status);
+        json_writer_kv_int(w, "duration_ms", (info->finished_us - info->queued_us) / 1000);
+    }
+    if (info->error != NULL) {
+        json_writer_kv_string(w, "error", info->error);
+    }
+    if (result != NULL) {
+        json_writer_key(w, "result");
+        json_writer_fragment(w, result);
+    }
+    json_writer_object_end(w);
 }
 
 /**
- * @brief POST /api/sensors/rescan - Rescan I2C bus for sensors
+ * @brief Job listener: report every state change as a "job" WebSocket message
  */
-static esp_err_t api_sensors_rescan_handler(httpd_req_t *req)
+static void sensor_job_ws_listener(const sensor_job_info_t *info, const char *result)
 {
-    ESP_LOGI(TAG, "Rescanning I2C bus for sensors");
-    
-    esp_err_t ret = sensor_manager_rescan();
-    
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "status", ret == ESP_OK ? "success" : "error");
-    cJSON_AddNumberToObject(root, "battery", sensor_manager_has_battery_monitor() ? 1 : 0);
-    cJSON_AddNumberToObject(root, "ezo_count", sensor_manager_get_ezo_count());
-    
-    const char *response = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, response);
-    
-    free((void*)response);
-    cJSON_Delete(root);
-    
-    return ESP_OK;
+    if (!sensor_ws_has_clients(WS_AUDIENCE_ALL)) {
+        return;
+    }
+    ws_frame_t *frame = ws_frame_acquire(false);
+    if (frame == NULL) {
+        return;
+    }
+
+    json_writer_t w;
+    json_writer_init(&w, frame->data, SENSOR_WS_FRAME_SIZE, NULL, NULL);
+    json_writer_object_begin(&w);
+    json_writer_kv_string(&w, "type", "job");
+    json_writer_key(&w, "job");
+    write_job_json(&w, info, result);
+    json_writer_object_end(&w);
+    if (json_writer_finish(&w) == ESP_OK) {
+        frame->len = json_writer_length(&w);
+        sensor_ws_publish(frame, -1, WS_AUDIENCE_ALL);
+    } else {
+        // Clients still get the result from GET /api/jobs/<id>
+        ESP_LOGW(TAG, "Job %lu message does not fit %d bytes", (unsigned long)info->id, SENSOR_WS_FRAME_SIZE);
+    }
+    ws_frame_release(frame);
 }
 
-static esp_err_t send_sensor_success_response(httpd_req_t *req, ezo_sensor_t *sensor)
+/**
+ * @brief Push alarm state changes to every dashboard, same document as the MQTT alert
+ */
+static void alarm_ws_listener(const alarm_event_t *event)
 {
-    if (sensor != NULL) {
-        esp_err_t refresh = ezo_sensor_refresh_settings(sensor);
-        if (refresh != ESP_OK) {
-            ESP_LOGW(TAG, "Failed to refresh sensor settings before response: %s", esp_err_to_name(refresh));
-        }
+    if (!sensor_ws_has_clients(WS_AUDIENCE_ALL)) {
+        return;
     }
-
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
-        return ESP_FAIL;
+    ws_frame_t *frame = ws_frame_acquire(false);
+    if (frame == NULL) {
+        return;
     }
-    cJSON_AddStringToObject(root, "status", "success");
-    cJSON *sensor_json = build_sensor_json(sensor, -1, true);
-    if (sensor_json != NULL) {
-        cJSON_AddItemToObject(root, "sensor", sensor_json);
+    frame->len = alarm_rules_event_json(event, frame->data, SENSOR_WS_FRAME_SIZE);
+    if (frame->len > 0) {
+        sensor_ws_publish(frame, -1, WS_AUDIENCE_ALL);
     }
+    ws_frame_release(frame);
+}
 
-    const char *response = cJSON_PrintUnformatted(root);
-    if (response == NULL) {
-        cJSON_Delete(root);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to serialize JSON");
-        return ESP_FAIL;
+/**
+ * @brief Queue a sensor action and answer 202 with the job's id and location
+ *
+ * @param job Arguments, owned by the job from here on (may be NULL)
+ */
+static esp_err_t submit_sensor_job(httpd_req_t *req, const char *kind, uint8_t address,
+                                   sensor_job_fn_t fn, sensor_action_job_t *job)
+{
+    uint32_t id = 0;
+    esp_err_t ret = sensor_jobs_submit(kind, address, fn, job, &id);
+    if (ret != ESP_OK) {
+        sensor_action_job_free(job);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "2");
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"error\":\"Sensor job queue is full\"}");
+        return ESP_OK;
     }
 
+    char location[32];
+    snprintf(location, sizeof(location), SENSOR_JOB_URI "%lu", (unsigned long)id);
+    char body[128];
+    snprintf(body, sizeof(body), "{\"status\":\"accepted\",\"job_id\":%lu,\"kind\":\"%s\",\"location\":\"%s\"}",
+             (unsigned long)id, kind, location);
+
+    httpd_resp_set_status(req, "202 Accepted");
+    httpd_resp_set_hdr(req, "Location", location);
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, response);
-    free((void*)response);
-    cJSON_Delete(root);
-    return ESP_OK;
+    return httpd_resp_sendstr(req, body);
 }
 
 /**
- * @brief POST /api/sensors/config - Update sensor configuration
- * Body: {"address": 99, "led": 1, "name": "MySensor", "scale": "F", etc}
+ * @brief Refresh a board's settings and keep its JSON as the job result; caller holds the bus
  */
-static esp_err_t api_sensors_config_handler(httpd_req_t *req)
+static void sensor_job_set_sensor_result(sensor_job_output_t *out, ezo_sensor_t *sensor)
 {
-    char content[512];
-    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
-    if (ret <= 0) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Empty request");
-        return ESP_FAIL;
+    esp_err_t refresh = ezo_sensor_refresh_settings(sensor);
+    if (refresh != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to refresh sensor settings: %s", esp_err_to_name(refresh));
     }
-    content[ret] = '\0';
-    
-    cJSON *root = cJSON_Parse(content);
-    if (root == NULL) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
-        return ESP_FAIL;
+
+    char *buf = malloc(SENSOR_JOB_RESULT_SIZE);
+    if (buf == NULL) {
+        return;
     }
-    
-    cJSON *address_json = cJSON_GetObjectItem(root, "address");
-    if (address_json == NULL || !cJSON_IsNumber(address_json)) {
-        cJSON_Delete(root);
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing address");
-        return ESP_FAIL;
+    json_writer_t w;
+    json_writer_init(&w, buf, SENSOR_JOB_RESULT_SIZE, NULL, NULL);
+    json_writer_object_begin(&w);
+    json_writer_kv_string(&w, "status", "success");
+    json_writer_key(&w, "sensor");
+    write_sensor_json(&w, sensor, -1, true, NULL, 0, 0);
+    json_writer_object_end(&w);
+    if (json_writer_finish(&w) != ESP_OK) {
+        ESP_LOGW(TAG, "Sensor 0x%02X result does not fit %d bytes", sensor->config.i2c_address,
+                 SENSOR_JOB_RESULT_SIZE);
+        free(buf);
+        return;
     }
-    
-    uint8_t address = (uint8_t)address_json->valueint;
-    
-    // Find sensor by address
-    ezo_sensor_t *sensor = NULL;
-    uint8_t ezo_count = sensor_manager_get_ezo_count();
-    for (uint8_t i = 0; i < ezo_count; i++) {
-        ezo_sensor_t *s = (ezo_sensor_t*)sensor_manager_get_ezo_sensor(i);
-        if (s != NULL && s->config.i2c_address == address) {
-            sensor = s;
-            break;
-        }
+    out->result = buf;
+}
+
+/**
+ * @brief Look the board up again at run time; a rescan may have dropped it since submission
+ */
+static ezo_sensor_t *sensor_job_begin(uint8_t address, sensor_read_guard_t *guard, sensor_job_output_t *out)
+{
+    ezo_sensor_t *sensor = find_sensor_by_address(address);
+    if (sensor == NULL) {
+        out->status = 404;
+        out->error = "Sensor not found";
+        return NULL;
     }
+    sensor_read_guard_acquire(guard, address);
+    return sensor;
+}
+
+static void sensor_rescan_job(void *arg, sensor_job_output_t *out)
+{
+    (void)arg;
+    ESP_LOGI(TAG, "Rescanning I2C bus for sensors");
     
-    if (sensor == NULL) {
-        cJSON_Delete(root);
-        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Sensor not found");
-        return ESP_FAIL;
+    esp_err_t ret = sensor_manager_rescan();
+    if (ret != ESP_OK) {
+        out->error = "Rescan failed";
     }
     
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", ret == ESP_OK ? "success" : "error");
+    cJSON_AddNumberToObject(root, "battery", sensor_manager_has_battery_monitor() ? 1 : 0);
+    cJSON_AddNumberToObject(root, "ezo_count", sensor_manager_get_ezo_count());
+    out->result = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+}
+
+/**
+ * @brief POST /api/sensors/rescan - Rescan I2C bus for sensors (202, runs as a job)
+ *
+ * With ?mode=incremental only a hot-plug pass is requested: unclaimed
+ * addresses are probed while the registered boards keep reporting.
+ */
+static esp_err_t api_sensors_rescan_handler(httpd_req_t *req)
+{
+    char query[32];
+    char mode[16];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "mode", mode, sizeof(mode)) == ESP_OK &&
+        strcmp(mode, "incremental") == 0) {
+        if (sensor_manager_request_discovery() != ESP_OK) {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Hot-plug detection not running");
+            return ESP_FAIL;
+        }
+        httpd_resp_set_status(req, "202 Accepted");
+        httpd_resp_set_type(req, "application/json");
+        return httpd_resp_sendstr(req, "{\"status\":\"accepted\",\"mode\":\"incremental\"}");
+    }
+    return submit_sensor_job(req, "rescan", 0, sensor_rescan_job, NULL);
+}
+
+/**
+ * @brief GET /api/jobs/<id> - State and result of a queued sensor action
+ */
+static esp_err_t api_job_get_handler(httpd_req_t *req)
+{
+    const char *id_str = req->uri + strlen(SENSOR_JOB_URI);
+    char *end = NULL;
+    unsigned long id = strtoul(id_str, &end, 10);
+    if (end == id_str || (*end != '\0' && *end != '?')) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid job id");
+        return ESP_FAIL;
+    }
+
+    sensor_job_info_t info;
+    char *result = NULL;
+    if (sensor_jobs_get((uint32_t)id, &info, &result) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Job not found");
+        return ESP_FAIL;
+    }
+
+    char chunk[HTTP_JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), json_writer_httpd_sink, req);
+    httpd_resp_set_type(req, "application/json");
+    write_job_json(&w, &info, result);
+    free(result);
+
+    esp_err_t err = json_writer_finish(&w);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Job response aborted: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static esp_err_t send_sensor_success_response(httpd_req_t *req, ezo_sensor_t *sensor)
+{
+    if (sensor != NULL) {
+        esp_err_t refresh = ezo_sensor_refresh_settings(sensor);
+        if (refresh != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to refresh sensor settings before response: %s", esp_err_to_name(refresh));
+        }
+    }
+
+    if (sensor == NULL) {
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_sendstr(req, "{\"status\":\"success\"}");
+        return ESP_OK;
+    }
+    return send_sensor_json_response(req, sensor, NULL, 0, 0);
+}
+
+static void sensor_config_job(void *arg, sensor_job_output_t *out)
+{
+    sensor_action_job_t *job = arg;
+    cJSON *root = job->body;
+
+    sensor_read_guard_t guard;
+    ezo_sensor_t *sensor = sensor_job_begin(job->address, &guard, out);
+    if (sensor == NULL) {
+        sensor_action_job_free(job);
+        return;
+    }
+
     // Update LED
     cJSON *led = cJSON_GetObjectItem(root, "led");
     if (led != NULL && cJSON_IsBool(led)) {
         ezo_sensor_set_led(sensor, cJSON_IsTrue(led));
     }
     
-    // Update name with validation
+    // Name was validated when the job was submitted
     cJSON *name = cJSON_GetObjectItem(root, "name");
     if (name != NULL && cJSON_IsString(name)) {
-        const char *name_str = name->valuestring;
-        size_t name_len = strlen(name_str);
-        
-        // Validate name: 1-16 characters, alphanumeric and underscore only
-        if (name_len == 0 || name_len > 16) {
-            cJSON_Delete(root);
-            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Name must be 1-16 characters");
-            return ESP_FAIL;
-        }
-        
-        // Check for valid characters (alphanumeric and underscore only)
-        bool valid = true;
-        for (size_t i = 0; i < name_len; i++) {
-            char c = name_str[i];
-            if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || 
-                  (c >= '0' && c <= '9') || c == '_')) {
-                valid = false;
-                break;
-            }
-        }
-        
-        if (!valid) {
-            cJSON_Delete(root);
-            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Name must contain only letters, numbers, and underscores");
-            return ESP_FAIL;
-        }
-        
-        esp_err_t name_ret = ezo_sensor_set_name(sensor, name_str);
+        esp_err_t name_ret = ezo_sensor_set_name(sensor, name->valuestring);
         if (name_ret != ESP_OK) {
             ESP_LOGW(TAG, "Failed to set sensor name: %s", esp_err_to_name(name_ret));
         }
@@ -1412,17 +2874,17 @@ static esp_err_t api_sensors_config_handler(httpd_req_t *req)
     }
     
     // Type-specific updates
-    if (strcmp(sensor->config.type, "RTD") == 0) {
+    if (sensor->config.kind == EZO_KIND_RTD) {
         cJSON *scale = cJSON_GetObjectItem(root, "scale");
         if (scale != NULL && cJSON_IsString(scale) && strlen(scale->valuestring) > 0) {
             ezo_rtd_set_scale(sensor, scale->valuestring[0]);
         }
-    } else if (strcmp(sensor->config.type, "pH") == 0) {
+    } else if (sensor->config.kind == EZO_KIND_PH) {
         cJSON *ext_scale = cJSON_GetObjectItem(root, "extended_scale");
         if (ext_scale != NULL && cJSON_IsBool(ext_scale)) {
             ezo_ph_set_extended_scale(sensor, cJSON_IsTrue(ext_scale));
         }
-    } else if (strcmp(sensor->config.type, "EC") == 0) {
+    } else if (sensor->config.kind == EZO_KIND_EC) {
         cJSON *probe = cJSON_GetObjectItem(root, "probe_type");
         if (probe != NULL && cJSON_IsNumber(probe)) {
             ezo_ec_set_probe_type(sensor, (float)probe->valuedouble);
@@ -1433,174 +2895,401 @@ static esp_err_t api_sensors_config_handler(httpd_req_t *req)
             ezo_ec_set_tds_factor(sensor, (float)tds->valuedouble);
         }
     }
-    
-    cJSON_Delete(root);
+    sensor_action_job_free(job);
     
     // Refresh sensor settings after update
-    esp_err_t refresh_ret = ezo_sensor_refresh_settings(sensor);
-    if (refresh_ret != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to refresh sensor settings: %s", esp_err_to_name(refresh_ret));
-    }
-    
-    return send_sensor_success_response(req, sensor);
+    sensor_job_set_sensor_result(out, sensor);
+    sensor_read_guard_release(&guard);
 }
 
-static esp_err_t api_sensor_calibrate_handler(httpd_req_t *req)
+/**
+ * @brief POST /api/sensors/config - Update sensor configuration (202, runs as a job)
+ * Body: {"address": 99, "led": 1, "name": "MySensor", "scale": "F", etc}
+ */
+static esp_err_t api_sensors_config_handler(httpd_req_t *req)
 {
-    uint8_t address;
-    if (!parse_sensor_address_from_uri(req->uri, SENSOR_CALIBRATE_URI, &address)) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid sensor address");
+    cJSON *root = parse_request_json_body(req);
+    if (root == NULL) {
         return ESP_FAIL;
     }
-
-    ezo_sensor_t *sensor = find_sensor_by_address(address);
-    if (sensor == NULL) {
+    
+    cJSON *address_json = cJSON_GetObjectItem(root, "address");
+    if (address_json == NULL || !cJSON_IsNumber(address_json)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing address");
+        return ESP_FAIL;
+    }
+    
+    uint8_t address = (uint8_t)address_json->valueint;
+    if (find_sensor_by_address(address) == NULL) {
+        cJSON_Delete(root);
         httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Sensor not found");
         return ESP_FAIL;
     }
-
-    char *raw = NULL;
-    cJSON *payload = parse_request_json_body(req, &raw);
-    if (payload == NULL) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+    
+    // Validate name: 1-16 characters, alphanumeric and underscore only
+    cJSON *name = cJSON_GetObjectItem(root, "name");
+    if (name != NULL && cJSON_IsString(name)) {
+        const char *name_str = name->valuestring;
+        size_t name_len = strlen(name_str);
+        
+        if (name_len == 0 || name_len > 16) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Name must be 1-16 characters");
+            return ESP_FAIL;
+        }
+        
+        // Check for valid characters (alphanumeric and underscore only)
+        for (size_t i = 0; i < name_len; i++) {
+            char c = name_str[i];
+            if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || 
+                  (c >= '0' && c <= '9') || c == '_')) {
+                cJSON_Delete(root);
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Name must contain only letters, numbers, and underscores");
+                return ESP_FAIL;
+            }
+        }
+    }
+    
+    sensor_action_job_t *job = calloc(1, sizeof(*job));
+    if (job == NULL) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
         return ESP_FAIL;
     }
+    job->address = address;
+    job->body = root;
+    return submit_sensor_job(req, "config", address, sensor_config_job, job);
+}
 
-    esp_err_t ret = ESP_ERR_NOT_SUPPORTED;
-    sensor_read_guard_t guard;
-    bool guard_active = false;
+/**
+ * @brief One calibration point, parsed from a request before the bus is taken
+ */
+typedef struct {
+    char point[12];
+    float value;
+    bool clear;
+} calibration_request_t;
 
-    if (strcmp(sensor->config.type, EZO_TYPE_PH) == 0) {
-        cJSON *point = cJSON_GetObjectItem(payload, "point");
+/**
+ * @brief Parse a calibrate body for the board's type
+ *
+ * @return NULL on success, otherwise the message for a 400 response
+ */
+static const char *parse_calibration_request(const ezo_sensor_t *sensor, cJSON *payload,
+                                             calibration_request_t *cal)
+{
+    memset(cal, 0, sizeof(*cal));
+    cJSON *point = cJSON_GetObjectItem(payload, "point");
+    if (point != NULL && cJSON_IsString(point)) {
+        strncpy(cal->point, point->valuestring, sizeof(cal->point) - 1);
+    }
+    uint8_t kind = sensor->config.kind;
+
+    if (kind == EZO_KIND_PH) {
         if (point == NULL || !cJSON_IsString(point)) {
-            cJSON_Delete(payload);
-            free(raw);
-            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing calibration point");
-            return ESP_FAIL;
+            return "Missing calibration point";
         }
-        const char *point_str = point->valuestring;
-        float default_value = 0.0f;
-        if (strcmp(point_str, "mid") == 0) default_value = 7.00f;
-        else if (strcmp(point_str, "low") == 0) default_value = 4.00f;
-        else if (strcmp(point_str, "high") == 0) default_value = 10.00f;
+        if (strcmp(cal->point, "mid") == 0) cal->value = 7.00f;
+        else if (strcmp(cal->point, "low") == 0) cal->value = 4.00f;
+        else if (strcmp(cal->point, "high") == 0) cal->value = 10.00f;
 
         cJSON *value = cJSON_GetObjectItem(payload, "value");
-        float cal_value = default_value;
         if (value != NULL && cJSON_IsNumber(value)) {
-            cal_value = (float)value->valuedouble;
-        }
-        sensor_read_guard_acquire(&guard);
-        guard_active = true;
-        ret = ezo_ph_calibrate(sensor, point_str, cal_value);
-    } else if (strcmp(sensor->config.type, EZO_TYPE_ORP) == 0) {
-        bool clear = false;
-        cJSON *point = cJSON_GetObjectItem(payload, "point");
-        if (point != NULL && cJSON_IsString(point) && strcmp(point->valuestring, "clear") == 0) {
-            clear = true;
+            cal->value = (float)value->valuedouble;
         }
+    } else if (kind == EZO_KIND_ORP) {
+        cal->clear = strcmp(cal->point, "clear") == 0;
         cJSON *clear_flag = cJSON_GetObjectItem(payload, "clear");
         if (clear_flag != NULL && cJSON_IsBool(clear_flag)) {
-            clear = cJSON_IsTrue(clear_flag);
+            cal->clear = cJSON_IsTrue(clear_flag);
         }
-
-        sensor_read_guard_acquire(&guard);
-        guard_active = true;
-
-        if (clear) {
-            ret = ezo_orp_calibrate(sensor, -1000.0f);
-        } else {
+        if (!cal->clear) {
             cJSON *value = cJSON_GetObjectItem(payload, "value");
             if (value == NULL || !cJSON_IsNumber(value)) {
-                cJSON_Delete(payload);
-                free(raw);
-                sensor_read_guard_release(&guard);
-                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing calibration value");
-                return ESP_FAIL;
+                return "Missing calibration value";
             }
-            ret = ezo_orp_calibrate(sensor, (float)value->valuedouble);
+            cal->value = (float)value->valuedouble;
         }
-    } else if (strcmp(sensor->config.type, EZO_TYPE_RTD) == 0) {
-        bool clear = false;
-        cJSON *point = cJSON_GetObjectItem(payload, "point");
-        if (point != NULL && cJSON_IsString(point) && strcmp(point->valuestring, "clear") == 0) {
-            clear = true;
-        }
-
-        float reference_temp = 0.0f;
-        if (!clear) {
+    } else if (kind == EZO_KIND_RTD) {
+        cal->clear = strcmp(cal->point, "clear") == 0;
+        if (!cal->clear) {
             cJSON *temperature = cJSON_GetObjectItem(payload, "temperature");
             if (temperature == NULL || !cJSON_IsNumber(temperature)) {
-                cJSON_Delete(payload);
-                free(raw);
-                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing temperature value");
-                return ESP_FAIL;
+                return "Missing temperature value";
             }
-            reference_temp = (float)temperature->valuedouble;
+            cal->value = (float)temperature->valuedouble;
         }
-
-        sensor_read_guard_acquire(&guard);
-        guard_active = true;
-        ret = ezo_rtd_calibrate(sensor, clear ? -1000.0f : reference_temp);
-    } else if (strcmp(sensor->config.type, EZO_TYPE_EC) == 0) {
-        cJSON *point = cJSON_GetObjectItem(payload, "point");
+    } else if (kind == EZO_KIND_EC) {
         if (point == NULL || !cJSON_IsString(point)) {
-            cJSON_Delete(payload);
-            free(raw);
-            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing calibration point");
-            return ESP_FAIL;
+            return "Missing calibration point";
         }
-
-        const char *point_str = point->valuestring;
-        bool point_needs_value = (strcmp(point_str, "low") == 0) || (strcmp(point_str, "high") == 0);
-        uint32_t cal_value = 0;
+        bool point_needs_value = (strcmp(cal->point, "low") == 0) || (strcmp(cal->point, "high") == 0);
         if (point_needs_value) {
             cJSON *value = cJSON_GetObjectItem(payload, "value");
             if (value == NULL || !cJSON_IsNumber(value) || value->valuedouble <= 0) {
-                cJSON_Delete(payload);
-                free(raw);
-                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid calibration value");
-                return ESP_FAIL;
+                return "Invalid calibration value";
             }
-            cal_value = (uint32_t)(value->valuedouble + 0.5);
+            cal->value = (float)value->valuedouble;
         }
-
-        sensor_read_guard_acquire(&guard);
-        guard_active = true;
-        ret = ezo_ec_calibrate(sensor, point_str, cal_value);
-    } else if (strcmp(sensor->config.type, EZO_TYPE_DO) == 0) {
-        cJSON *point = cJSON_GetObjectItem(payload, "point");
+    } else if (kind == EZO_KIND_DO) {
         if (point == NULL || !cJSON_IsString(point)) {
-            cJSON_Delete(payload);
-            free(raw);
-            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing calibration point");
-            return ESP_FAIL;
+            return "Missing calibration point";
         }
+    } else {
+        return "Calibration not supported for this sensor";
+    }
+    return NULL;
+}
 
-        sensor_read_guard_acquire(&guard);
-        guard_active = true;
-        ret = ezo_do_calibrate(sensor, point->valuestring);
+/**
+ * @brief Send a parsed calibration point to the board; caller holds the bus
+ */
+static esp_err_t run_calibration(ezo_sensor_t *sensor, const calibration_request_t *cal)
+{
+    uint8_t kind = sensor->config.kind;
+    if (kind == EZO_KIND_PH) {
+        return ezo_ph_calibrate(sensor, cal->point, cal->value);
+    } else if (kind == EZO_KIND_ORP) {
+        return ezo_orp_calibrate(sensor, cal->clear ? -1000.0f : cal->value);
+    } else if (kind == EZO_KIND_RTD) {
+        return ezo_rtd_calibrate(sensor, cal->clear ? -1000.0f : cal->value);
+    } else if (kind == EZO_KIND_EC) {
+        return ezo_ec_calibrate(sensor, cal->point, (uint32_t)(cal->value + 0.5f));
+    } else if (kind == EZO_KIND_DO) {
+        return ezo_do_calibrate(sensor, cal->point);
     }
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#define CALIB_SESSION_TIMEOUT_MS (10 * 60 * 1000)
+
+// Calibration assistant: the focus stream feeds the stability tracker, only touched from the httpd task
+typedef struct {
+    bool active;
+    bool auto_commit;
+    bool stable;
+    bool request_valid;         // False while a track-only session waits for the point at commit
+    uint8_t address;
+    int64_t started_us;
+    calibration_request_t request;
+    calib_stability_t stability;
+    calib_stability_result_t last;
+} calib_session_t;
 
+static calib_session_t s_calib_session;
+
+static void calib_session_send(const char *state, const char *error)
+{
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        return;
+    }
+
+    const calib_stability_result_t *r = &s_calib_session.last;
+    cJSON_AddStringToObject(root, "type", "calibration_status");
+    cJSON_AddNumberToObject(root, "address", s_calib_session.address);
+    cJSON_AddStringToObject(root, "point", s_calib_session.request.point);
+    cJSON_AddStringToObject(root, "state", state);
+    cJSON_AddBoolToObject(root, "auto_commit", s_calib_session.auto_commit);
+    if (r->samples > 0) {
+        cJSON_AddNumberToObject(root, "samples", r->samples);
+        cJSON_AddNumberToObject(root, "span_ms", r->span_ms);
+        cJSON_AddNumberToObject(root, "mean", r->mean);
+        cJSON_AddNumberToObject(root, "stddev", r->stddev);
+        cJSON_AddNumberToObject(root, "slope_per_min", r->slope_per_min);
+        cJSON_AddNumberToObject(root, "tolerance", r->tolerance);
+    }
+    if (error != NULL) {
+        cJSON_AddStringToObject(root, "error", error);
+    }
+
+    sensor_ws_broadcast_cjson(root);
+    cJSON_Delete(root);
+}
+
+static void calib_session_end(const char *state, const char *error)
+{
+    if (!s_calib_session.active) {
+        return;
+    }
+    ESP_LOGI(TAG, "Calibration session on 0x%02X %s%s%s", s_calib_session.address, state,
+             error != NULL ? ": " : "", error != NULL ? error : "");
+    calib_session_send(state, error);
+    s_calib_session.active = false;
+}
+
+/**
+ * @brief Start a session: {"action":"calibration_start","address":99,"point":"mid","auto_commit":true}
+ *
+ * Takes the same point fields as POST /api/sensors/calibrate/<addr>. Without
+ * auto_commit the fields may be left out and sent with calibration_commit
+ * instead, so the solution value can be entered while the probe settles.
+ */
+static void calib_session_start(cJSON *root)
+{
+    cJSON *addr = cJSON_GetObjectItem(root, "address");
+    ezo_sensor_t *sensor = cJSON_IsNumber(addr) ? find_sensor_by_address((uint8_t)addr->valueint) : NULL;
+    if (sensor == NULL) {
+        sensor_ws_send_focus_status("error", cJSON_IsNumber(addr) ? (uint8_t)addr->valueint : 0);
+        return;
+    }
+
+    calib_session_end("cancelled", NULL);
+    memset(&s_calib_session, 0, sizeof(s_calib_session));
+    s_calib_session.address = sensor->config.i2c_address;
+
+    s_calib_session.auto_commit = cJSON_IsTrue(cJSON_GetObjectItem(root, "auto_commit"));
+    const char *error = parse_calibration_request(sensor, root, &s_calib_session.request);
+    s_calib_session.request_valid = (error == NULL);
+    if (!s_calib_session.auto_commit) {
+        error = NULL;
+    }
+    if (error == NULL && focus_stream_start(sensor->config.i2c_address) != ESP_OK) {
+        error = "Focus stream unavailable";
+    }
+    if (error != NULL) {
+        calib_session_send("failed", error);
+        return;
+    }
+
+    s_calib_session.started_us = esp_timer_get_time();
+    calib_stability_init(&s_calib_session.stability, sensor->config.type);
+    s_calib_session.active = true;
+    ESP_LOGI(TAG, "Calibration session on 0x%02X (%s point '%s'%s)", s_calib_session.address,
+             sensor->config.type, s_calib_session.request.point,
+             s_calib_session.auto_commit ? ", auto-commit" : "");
+    calib_session_send("settling", NULL);
+}
+
+/**
+ * @brief Send the session's point to the board, stable or not, and end the session
+ *
+ * @param root Commit message; point fields in it replace the ones given at start (may be NULL)
+ */
+static void calib_session_commit(cJSON *root)
+{
+    if (!s_calib_session.active) {
+        return;
+    }
+    ezo_sensor_t *sensor = find_sensor_by_address(s_calib_session.address);
+    if (sensor == NULL) {
+        calib_session_end("failed", "Sensor not found");
+        return;
+    }
+
+    if (root != NULL && (cJSON_GetObjectItem(root, "point") != NULL || cJSON_GetObjectItem(root, "value") != NULL ||
+                         cJSON_GetObjectItem(root, "temperature") != NULL)) {
+        calibration_request_t cal;
+        const char *error = parse_calibration_request(sensor, root, &cal);
+        if (error != NULL) {
+            // Keep the session so the client can correct the value and retry
+            calib_session_send(s_calib_session.stable ? "stable" : "settling", error);
+            return;
+        }
+        s_calib_session.request = cal;
+        s_calib_session.request_valid = true;
+    }
+    if (!s_calib_session.request_valid) {
+        calib_session_send(s_calib_session.stable ? "stable" : "settling", "Missing calibration point");
+        return;
+    }
+
+    sensor_read_guard_t guard;
+    sensor_read_guard_acquire(&guard, s_calib_session.address);
+    esp_err_t ret = run_calibration(sensor, &s_calib_session.request);
+    if (ret == ESP_OK) {
+        ezo_sensor_refresh_settings(sensor);
+    }
+    sensor_read_guard_release(&guard);
+
+    calib_session_end(ret == ESP_OK ? "committed" : "failed", ret == ESP_OK ? NULL : esp_err_to_name(ret));
+}
+
+static void calib_session_on_sample(const focus_sample_t *sample)
+{
+    if (!s_calib_session.active || sample->address != s_calib_session.address || sample->count == 0) {
+        return;
+    }
+    if (esp_timer_get_time() - s_calib_session.started_us > CALIB_SESSION_TIMEOUT_MS * 1000LL) {
+        calib_session_end("failed", "Probe did not settle");
+        return;
+    }
+
+    calib_stability_add(&s_calib_session.stability, sample->timestamp_ms, sample->values[0],
+                        &s_calib_session.last);
+    bool stable = s_calib_session.last.stable;
+    if (stable != s_calib_session.stable) {
+        ESP_LOGI(TAG, "Calibration probe 0x%02X %s (mean %.3f, sd %.4f, slope %.4f/min)",
+                 s_calib_session.address, stable ? "stable" : "settling again",
+                 s_calib_session.last.mean, s_calib_session.last.stddev, s_calib_session.last.slope_per_min);
+        s_calib_session.stable = stable;
+    }
+
+    if (stable && s_calib_session.auto_commit) {
+        calib_session_send("stable", NULL);
+        calib_session_commit(NULL);
+        return;
+    }
+    calib_session_send(stable ? "stable" : "settling", NULL);
+}
+
+static esp_err_t api_sensor_calibrate_handler(httpd_req_t *req)
+{
+    uint8_t address;
+    if (!parse_sensor_address_from_uri(req->uri, SENSOR_CALIBRATE_URI, &address)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid sensor address");
+        return ESP_FAIL;
+    }
+
+    ezo_sensor_t *sensor = find_sensor_by_address(address);
+    if (sensor == NULL) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Sensor not found");
+        return ESP_FAIL;
+    }
+
+    cJSON *payload = parse_request_json_body(req);
+    if (payload == NULL) {
+        return ESP_FAIL;
+    }
+
+    calibration_request_t cal;
+    const char *error = parse_calibration_request(sensor, payload, &cal);
     cJSON_Delete(payload);
-    free(raw);
+    if (error != NULL) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, error);
+        return ESP_FAIL;
+    }
+
+    sensor_read_guard_t guard;
+    sensor_read_guard_acquire(&guard, sensor->config.i2c_address);
+    esp_err_t ret = run_calibration(sensor, &cal);
 
     if (ret != ESP_OK) {
-        if (guard_active) {
-            sensor_read_guard_release(&guard);
-        }
-        if (ret == ESP_ERR_NOT_SUPPORTED) {
-            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Calibration not supported for this sensor");
-        } else {
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Calibration failed");
-        }
+        sensor_read_guard_release(&guard);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Calibration failed");
         return ESP_FAIL;
     }
 
     esp_err_t resp = send_sensor_success_response(req, sensor);
-    if (guard_active) {
+    sensor_read_guard_release(&guard);
+    return resp;
+}
+
+static void sensor_compensation_job(void *arg, sensor_job_output_t *out)
+{
+    sensor_action_job_t *job = arg;
+    sensor_read_guard_t guard;
+    ezo_sensor_t *sensor = sensor_job_begin(job->address, &guard, out);
+    if (sensor != NULL) {
+        if (ezo_ph_set_temperature_comp(sensor, job->value) != ESP_OK) {
+            out->error = "Failed to set temperature compensation";
+        } else {
+            sensor_job_set_sensor_result(out, sensor);
+        }
         sensor_read_guard_release(&guard);
     }
-    return resp;
+    sensor_action_job_free(job);
 }
 
 static esp_err_t api_sensor_compensation_handler(httpd_req_t *req)
@@ -1617,16 +3306,13 @@ static esp_err_t api_sensor_compensation_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    char *raw = NULL;
-    cJSON *payload = parse_request_json_body(req, &raw);
+    cJSON *payload = parse_request_json_body(req);
     if (payload == NULL) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
         return ESP_FAIL;
     }
 
-    if (strcmp(sensor->config.type, EZO_TYPE_PH) != 0) {
+    if (sensor->config.kind != EZO_KIND_PH) {
         cJSON_Delete(payload);
-        free(raw);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Temperature compensation not supported");
         return ESP_FAIL;
     }
@@ -1634,27 +3320,36 @@ static esp_err_t api_sensor_compensation_handler(httpd_req_t *req)
     cJSON *temp = cJSON_GetObjectItem(payload, "temp_c");
     if (temp == NULL || !cJSON_IsNumber(temp)) {
         cJSON_Delete(payload);
-        free(raw);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing temp_c value");
         return ESP_FAIL;
     }
     float target = (float)temp->valuedouble;
     cJSON_Delete(payload);
-    free(raw);
 
-    sensor_read_guard_t guard;
-    sensor_read_guard_acquire(&guard);
-
-    esp_err_t ret = ezo_ph_set_temperature_comp(sensor, target);
-    if (ret != ESP_OK) {
-        sensor_read_guard_release(&guard);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to set temperature compensation");
+    sensor_action_job_t *job = calloc(1, sizeof(*job));
+    if (job == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
         return ESP_FAIL;
     }
+    job->address = address;
+    job->value = target;
+    return submit_sensor_job(req, "compensate", address, sensor_compensation_job, job);
+}
 
-    esp_err_t resp = send_sensor_success_response(req, sensor);
-    sensor_read_guard_release(&guard);
-    return resp;
+static void sensor_mode_job(void *arg, sensor_job_output_t *out)
+{
+    sensor_action_job_t *job = arg;
+    sensor_read_guard_t guard;
+    ezo_sensor_t *sensor = sensor_job_begin(job->address, &guard, out);
+    if (sensor != NULL) {
+        if (ezo_sensor_set_continuous_mode(sensor, job->flag) != ESP_OK) {
+            out->error = "Failed to update mode";
+        } else {
+            sensor_job_set_sensor_result(out, sensor);
+        }
+        sensor_read_guard_release(&guard);
+    }
+    sensor_action_job_free(job);
 }
 
 static esp_err_t api_sensor_mode_handler(httpd_req_t *req)
@@ -1676,38 +3371,46 @@ static esp_err_t api_sensor_mode_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    char *raw = NULL;
-    cJSON *payload = parse_request_json_body(req, &raw);
+    cJSON *payload = parse_request_json_body(req);
     if (payload == NULL) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
         return ESP_FAIL;
     }
 
     cJSON *continuous = cJSON_GetObjectItem(payload, "continuous");
     if (continuous == NULL || !cJSON_IsBool(continuous)) {
         cJSON_Delete(payload);
-        free(raw);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing continuous flag");
         return ESP_FAIL;
     }
 
     bool enable = cJSON_IsTrue(continuous);
     cJSON_Delete(payload);
-    free(raw);
-
-    sensor_read_guard_t guard;
-    sensor_read_guard_acquire(&guard);
 
-    esp_err_t ret = ezo_sensor_set_continuous_mode(sensor, enable);
-    if (ret != ESP_OK) {
-        sensor_read_guard_release(&guard);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to update mode");
+    sensor_action_job_t *job = calloc(1, sizeof(*job));
+    if (job == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
         return ESP_FAIL;
     }
+    job->address = address;
+    job->flag = enable;
+    return submit_sensor_job(req, "mode", address, sensor_mode_job, job);
+}
 
-    esp_err_t resp = send_sensor_success_response(req, sensor);
-    sensor_read_guard_release(&guard);
-    return resp;
+static void sensor_power_job(void *arg, sensor_job_output_t *out)
+{
+    sensor_action_job_t *job = arg;
+    sensor_read_guard_t guard;
+    ezo_sensor_t *sensor = sensor_job_begin(job->address, &guard, out);
+    if (sensor != NULL) {
+        esp_err_t ret = job->flag ? ezo_sensor_sleep(sensor) : ezo_sensor_wake(sensor);
+        if (ret != ESP_OK) {
+            out->error = "Failed to change power state";
+        } else {
+            sensor_job_set_sensor_result(out, sensor);
+        }
+        sensor_read_guard_release(&guard);
+    }
+    sensor_action_job_free(job);
 }
 
 static esp_err_t api_sensor_power_handler(httpd_req_t *req)
@@ -1729,38 +3432,29 @@ static esp_err_t api_sensor_power_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    char *raw = NULL;
-    cJSON *payload = parse_request_json_body(req, &raw);
+    cJSON *payload = parse_request_json_body(req);
     if (payload == NULL) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
         return ESP_FAIL;
     }
 
     cJSON *sleep_flag = cJSON_GetObjectItem(payload, "sleep");
     if (sleep_flag == NULL || !cJSON_IsBool(sleep_flag)) {
         cJSON_Delete(payload);
-        free(raw);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing sleep flag");
         return ESP_FAIL;
     }
 
     bool sleep = cJSON_IsTrue(sleep_flag);
     cJSON_Delete(payload);
-    free(raw);
-
-    sensor_read_guard_t guard;
-    sensor_read_guard_acquire(&guard);
 
-    esp_err_t ret = sleep ? ezo_sensor_sleep(sensor) : ezo_sensor_wake(sensor);
-    if (ret != ESP_OK) {
-        sensor_read_guard_release(&guard);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to change power state");
+    sensor_action_job_t *job = calloc(1, sizeof(*job));
+    if (job == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
         return ESP_FAIL;
     }
-
-    esp_err_t resp = send_sensor_success_response(req, sensor);
-    sensor_read_guard_release(&guard);
-    return resp;
+    job->address = address;
+    job->flag = sleep;
+    return submit_sensor_job(req, "power", address, sensor_power_job, job);
 }
 
 static esp_err_t api_sensor_status_handler(httpd_req_t *req)
@@ -1778,33 +3472,26 @@ static esp_err_t api_sensor_status_handler(httpd_req_t *req)
     }
 
     sensor_read_guard_t guard;
-    sensor_read_guard_acquire(&guard);
+    sensor_read_guard_acquire(&guard, sensor->config.i2c_address);
 
     esp_err_t refresh = ezo_sensor_refresh_settings(sensor);
     if (refresh != ESP_OK) {
         ESP_LOGW(TAG, "Failed to refresh sensor %02X before status read: %s", address, esp_err_to_name(refresh));
     }
 
-    cJSON *sensor_json = build_sensor_json(sensor, -1, true);
-    if (sensor_json == NULL) {
-        sensor_read_guard_release(&guard);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to serialize sensor");
-        return ESP_FAIL;
-    }
-
-    const char *payload = cJSON_PrintUnformatted(sensor_json);
-    cJSON_Delete(sensor_json);
-    if (payload == NULL) {
-        sensor_read_guard_release(&guard);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to serialize sensor");
-        return ESP_FAIL;
-    }
+    char chunk[HTTP_JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), json_writer_httpd_sink, req);
 
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, payload);
-    free((void*)payload);
+    write_sensor_json(&w, sensor, -1, true, NULL, 0, 0);
+    esp_err_t err = json_writer_finish(&w);
     sensor_read_guard_release(&guard);
-    return ESP_OK;
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Sensor status response aborted: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
 }
 
 static esp_err_t api_sensor_sample_handler(httpd_req_t *req)
@@ -1824,58 +3511,595 @@ static esp_err_t api_sensor_sample_handler(httpd_req_t *req)
     float values[4] = {0};
     uint8_t count = 0;
 
-    sensor_read_guard_t guard;
-    sensor_read_guard_acquire(&guard);
-    esp_err_t ret = ezo_sensor_read_all(sensor, values, &count);
-    sensor_read_guard_release(&guard);
+    esp_err_t ret = sensor_interactive_read(sensor, values, &count);
 
     if (ret != ESP_OK || count == 0) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to read sensor");
         return ESP_FAIL;
     }
 
-    cJSON *sensor_json = build_sensor_json(sensor, -1, true);
-    if (sensor_json == NULL) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to serialize sensor");
+    uint64_t timestamp_ms = esp_timer_get_time() / 1000ULL;
+    return send_sensor_json_response(req, sensor, values, count, timestamp_ms);
+}
+
+#define HISTORY_PAGE_ROWS       16
+#define HISTORY_MAX_ROWS        4000
+#define HISTORY_CHUNK_SIZE      1024
+
+typedef struct {
+    httpd_req_t *req;
+    char buf[HISTORY_CHUNK_SIZE];
+    size_t len;
+    esp_err_t err;
+} history_chunk_writer_t;
+
+static void history_writer_flush(history_chunk_writer_t *w)
+{
+    if (w->err == ESP_OK && w->len > 0) {
+        w->err = httpd_resp_send_chunk(w->req, w->buf, w->len);
+    }
+    w->len = 0;
+}
+
+static void history_writer_printf(history_chunk_writer_t *w, const char *fmt, ...)
+{
+    if (w->err != ESP_OK) {
+        return;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(w->buf + w->len, sizeof(w->buf) - w->len, fmt, args);
+        va_end(args);
+        if (n >= 0 && (size_t)n < sizeof(w->buf) - w->len) {
+            w->len += n;
+            return;
+        }
+        // Did not fit: flush what we have and retry into the empty buffer
+        history_writer_flush(w);
+    }
+    w->err = ESP_ERR_INVALID_SIZE;
+}
+
+static void history_writer_column(history_chunk_writer_t *w, const float *values, uint8_t count)
+{
+    history_writer_printf(w, "[");
+    for (uint8_t ch = 0; ch < count; ch++) {
+        const char *sep = (ch + 1 < count) ? "," : "";
+        if (isnan(values[ch])) {
+            history_writer_printf(w, "null%s", sep);
+        } else {
+            history_writer_printf(w, "%.6g%s", values[ch], sep);
+        }
+    }
+    history_writer_printf(w, "]");
+}
+
+static bool history_query_u32(const char *query, const char *key, uint32_t *out)
+{
+    char value[16];
+    if (query == NULL || httpd_query_key_value(query, key, value, sizeof(value)) != ESP_OK) {
+        return false;
+    }
+    char *end = NULL;
+    unsigned long parsed = strtoul(value, &end, 10);
+    if (end == value || *end != '\0') {
+        return false;
+    }
+    *out = (uint32_t)parsed;
+    return true;
+}
+
+/**
+ * @brief GET /api/sensors/history?from=&to=&resolution= - Recorded sensor history
+ *
+ * from/to are Unix seconds once time is synced, seconds since boot before
+ * that ("clock" in the response says which). resolution is raw, 1m, 10m or
+ * auto (default: finest tier covering the span). Rows are streamed as
+ * [t,[v...]] for raw and [t,[mean...],[min...],[max...]] for rollups, with one
+ * column per entry of "channels".
+ */
+static esp_err_t api_sensors_history_handler(httpd_req_t *req)
+{
+    if (!sensor_history_is_enabled()) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Sensor history not available");
+        return ESP_FAIL;
+    }
+
+    char query[96] = {0};
+    bool have_query = httpd_req_get_url_query_len(req) > 0 &&
+                      httpd_req_get_url_query_len(req) < sizeof(query) &&
+                      httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK;
+
+    uint32_t to = sensor_history_now();
+    uint32_t from = (to > 3600) ? to - 3600 : 0;
+    if (have_query) {
+        history_query_u32(query, "to", &to);
+        if (!history_query_u32(query, "from", &from)) {
+            from = (to > 3600) ? to - 3600 : 0;
+        }
+    }
+    if (from > to) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "from must not be after to");
+        return ESP_FAIL;
+    }
+
+    sensor_history_resolution_t resolution = sensor_history_pick_resolution(to - from);
+    char res_str[8] = {0};
+    if (have_query && httpd_query_key_value(query, "resolution", res_str, sizeof(res_str)) == ESP_OK) {
+        if (strcmp(res_str, "raw") == 0) {
+            resolution = SENSOR_HISTORY_RES_RAW;
+        } else if (strcmp(res_str, "1m") == 0) {
+            resolution = SENSOR_HISTORY_RES_1MIN;
+        } else if (strcmp(res_str, "10m") == 0) {
+            resolution = SENSOR_HISTORY_RES_10MIN;
+        } else if (strcmp(res_str, "auto") != 0) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "resolution must be raw, 1m, 10m or auto");
+            return ESP_FAIL;
+        }
+    }
+    static const char *const k_resolution_names[] = { "raw", "1m", "10m" };
+
+    sensor_history_channel_t channels[SENSOR_HISTORY_MAX_CHANNELS];
+    uint8_t channel_count = sensor_history_get_channels(channels, SENSOR_HISTORY_MAX_CHANNELS);
+
+    history_chunk_writer_t *w = calloc(1, sizeof(history_chunk_writer_t));
+    sensor_history_row_t *rows = malloc(HISTORY_PAGE_ROWS * sizeof(sensor_history_row_t));
+    if (w == NULL || rows == NULL) {
+        free(w);
+        free(rows);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    w->req = req;
+
+    httpd_resp_set_type(req, "application/json");
+    history_writer_printf(w, "{\"clock\":\"%s\",\"resolution\":\"%s\",\"bucket_sec\":%lu,"
+                             "\"from\":%lu,\"to\":%lu,\"channels\":[",
+                          sensor_history_clock_is_unix() ? "unix" : "uptime",
+                          k_resolution_names[resolution],
+                          (unsigned long)sensor_history_bucket_sec(resolution),
+                          (unsigned long)from, (unsigned long)to);
+    for (uint8_t ch = 0; ch < channel_count; ch++) {
+        history_writer_printf(w, "%s{\"type\":\"%s\",\"index\":%u,\"address\":%u}", ch > 0 ? "," : "",
+                              channels[ch].sensor_type, channels[ch].value_index, channels[ch].address);
+    }
+    history_writer_printf(w, "],\"rows\":[");
+
+    // Page through the tier so the history lock is only held for a few rows at a time
+    size_t total_rows = 0;
+    uint32_t cursor = from;
+    bool truncated = false;
+    while (w->err == ESP_OK) {
+        size_t n = sensor_history_read(resolution, cursor, to, rows, HISTORY_PAGE_ROWS);
+        for (size_t r = 0; r < n; r++) {
+            if (total_rows >= HISTORY_MAX_ROWS) {
+                truncated = true;
+                break;
+            }
+            history_writer_printf(w, "%s[%lu,", total_rows > 0 ? "," : "", (unsigned long)rows[r].timestamp);
+            history_writer_column(w, rows[r].mean, channel_count);
+            if (resolution != SENSOR_HISTORY_RES_RAW) {
+                history_writer_printf(w, ",");
+                history_writer_column(w, rows[r].min, channel_count);
+                history_writer_printf(w, ",");
+                history_writer_column(w, rows[r].max, channel_count);
+            }
+            history_writer_printf(w, "]");
+            total_rows++;
+        }
+        if (truncated || n < HISTORY_PAGE_ROWS || rows[n - 1].timestamp >= to) {
+            break;
+        }
+        cursor = rows[n - 1].timestamp + 1;
+    }
+
+    history_writer_printf(w, "],\"count\":%u,\"truncated\":%s}", (unsigned)total_rows,
+                          truncated ? "true" : "false");
+    history_writer_flush(w);
+    esp_err_t ret = w->err;
+    if (ret == ESP_OK) {
+        ret = httpd_resp_send_chunk(req, NULL, 0);
+    }
+
+    free(rows);
+    free(w);
+    return ret;
+}
+
+/**
+ * @brief GET /api/perf/mqtt - MQTT publish latency histograms and outbox counters
+ *
+ * ?reset=1 clears the counters after they are reported.
+ */
+static esp_err_t api_perf_mqtt_handler(httpd_req_t *req)
+{
+    mqtt_perf_stats_t stats;
+    if (mqtt_get_perf_stats(&stats) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Counters busy");
+        return ESP_FAIL;
+    }
+    
+    char query[32];
+    bool reset = false;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        uint32_t value = 0;
+        reset = history_query_u32(query, "reset", &value) && value != 0;
+    }
+    if (reset) {
+        mqtt_reset_perf_stats();
+    }
+    
+    char chunk[HTTP_JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), json_writer_httpd_sink, req);
+    
+    httpd_resp_set_type(req, "application/json");
+    json_writer_object_begin(&w);
+    json_writer_kv_bool(&w, "connected", mqtt_client_is_connected());
+    json_writer_kv_int(&w, "uptime", esp_timer_get_time() / 1000000);
+    json_writer_kv_int(&w, "log_pending", telemetry_log_pending_count());
+    json_writer_kv_bool(&w, "reset", reset);
+    json_writer_key(&w, "mqtt");
+    mqtt_write_perf_json(&w, &stats);
+    json_writer_object_end(&w);
+    
+    esp_err_t err = json_writer_finish(&w);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "MQTT perf response aborted: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * @brief GET /api/perf/sensors - Acquisition cycle latency histograms per board
+ *
+ * ?reset=1 clears the histograms after they are reported.
+ */
+static esp_err_t api_perf_sensors_handler(httpd_req_t *req)
+{
+    char query[32];
+    bool reset = false;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        uint32_t value = 0;
+        reset = history_query_u32(query, "reset", &value) && value != 0;
+    }
+    
+    char chunk[HTTP_JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), json_writer_httpd_sink, req);
+    
+    httpd_resp_set_type(req, "application/json");
+    json_writer_object_begin(&w);
+    json_writer_kv_int(&w, "uptime", esp_timer_get_time() / 1000000);
+    json_writer_kv_int(&w, "window_sec", ACQ_STATS_WINDOW_SEC);
+    json_writer_kv_bool(&w, "reset", reset);
+    json_writer_key(&w, "acquisition");
+    acq_stats_write_json(&w, true);
+    json_writer_object_end(&w);
+    
+    esp_err_t err = json_writer_finish(&w);
+    if (reset) {
+        sensor_manager_reset_acq_stats();
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Sensor perf response aborted: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * @brief GET /api/perf - CPU load per core and per-task CPU share and stack margin
+ */
+static esp_err_t api_perf_handler(httpd_req_t *req)
+{
+    char chunk[HTTP_JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), json_writer_httpd_sink, req);
+    
+    httpd_resp_set_type(req, "application/json");
+    json_writer_object_begin(&w);
+    json_writer_kv_int(&w, "uptime", esp_timer_get_time() / 1000000);
+    json_writer_kv_int(&w, "free_heap", esp_get_free_heap_size());
+    json_writer_kv_int(&w, "min_free_heap", esp_get_minimum_free_heap_size());
+    json_writer_key(&w, "cpu");
+    perf_monitor_write_json(&w, true);
+    json_writer_key(&w, "memory");
+    mem_monitor_write_json(&w, true);
+    json_writer_key(&w, "json_arena");
+    json_arena_write_json(&w);
+    json_writer_key(&w, "i2c");
+    i2c_scanner_write_health_json(&w);
+#ifdef CONFIG_KC_LAN_POLL
+    json_writer_key(&w, "lan_poll");
+    lan_poll_write_json(&w);
+#endif
+    json_writer_object_end(&w);
+    
+    esp_err_t err = json_writer_finish(&w);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Perf response aborted: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * @brief GET /api/perf/boot - Startup timing marks of this boot and the previous ones
+ */
+static esp_err_t api_perf_boot_handler(httpd_req_t *req)
+{
+    char chunk[HTTP_JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), json_writer_httpd_sink, req);
+    
+    httpd_resp_set_type(req, "application/json");
+    boot_profile_write_json(&w, true);
+    
+    esp_err_t err = json_writer_finish(&w);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Boot profile response aborted: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * @brief Run the data-path benchmark with sensor reading parked
+ *
+ * job->value carries the iteration count and job->flag whether to save the
+ * run as the new baseline. A regression fails the job with 409.
+ */
+static void perf_bench_job(void *arg, sensor_job_output_t *out)
+{
+    sensor_action_job_t *job = arg;
+    uint32_t iterations = (uint32_t)job->value;
+    bool save = job->flag;
+    sensor_action_job_free(job);
+    
+    // The filter stage borrows a sensor slot, so the reading task must be idle
+    bool was_paused = sensor_manager_is_reading_paused();
+    sensor_manager_pause_reading();
+    for (int waited = 0; waited < PERF_BENCH_IDLE_WAIT_MS && sensor_manager_is_reading_in_progress(); waited += 50) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    
+    data_bench_report_t report;
+    esp_err_t ret = data_bench_run(iterations, &report);
+    if (!was_paused) {
+        sensor_manager_resume_reading();
+    }
+    if (ret != ESP_OK) {
+        out->status = 409;
+        out->error = "Benchmark already running";
+        return;
+    }
+    
+    if (save) {
+        if (data_bench_save_baseline(&report) != ESP_OK) {
+            out->error = "Failed to save baseline";
+        }
+    } else if (!report.passed) {
+        out->status = 409;
+        out->error = "Performance regression beyond threshold";
+    }
+    
+    char *buf = malloc(SENSOR_JOB_RESULT_SIZE);
+    if (buf == NULL) {
+        return;
+    }
+    json_writer_t w;
+    json_writer_init(&w, buf, SENSOR_JOB_RESULT_SIZE, NULL, NULL);
+    data_bench_write_json(&w, &report);
+    if (json_writer_finish(&w) != ESP_OK) {
+        free(buf);
+        return;
+    }
+    out->result = buf;
+}
+
+/**
+ * @brief POST /api/perf/bench?iterations=&baseline=save|clear - Benchmark the data path (202, runs as a job)
+ *
+ * baseline=save stores this run as the reference, baseline=clear drops the
+ * stored one first. Without either the run is compared to the stored baseline.
+ */
+static esp_err_t api_perf_bench_post_handler(httpd_req_t *req)
+{
+    char query[64];
+    uint32_t iterations = 0;
+    bool save = false;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        history_query_u32(query, "iterations", &iterations);
+        char baseline[8];
+        if (httpd_query_key_value(query, "baseline", baseline, sizeof(baseline)) == ESP_OK) {
+            if (strcmp(baseline, "save") == 0) {
+                save = true;
+            } else if (strcmp(baseline, "clear") == 0) {
+                if (data_bench_clear_baseline() != ESP_OK) {
+                    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to clear baseline");
+                    return ESP_FAIL;
+                }
+            } else {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "baseline must be save or clear");
+                return ESP_FAIL;
+            }
+        }
+    }
+    if (iterations > DATA_BENCH_MAX_ITERATIONS) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Too many iterations");
+        return ESP_FAIL;
+    }
+    
+    sensor_action_job_t *job = calloc(1, sizeof(*job));
+    if (job == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    job->value = (float)iterations;
+    job->flag = save;
+    return submit_sensor_job(req, "bench", 0, perf_bench_job, job);
+}
+
+/**
+ * @brief GET /api/perf/bench - Result of the last data-path benchmark
+ */
+static esp_err_t api_perf_bench_get_handler(httpd_req_t *req)
+{
+    data_bench_report_t report;
+    if (data_bench_get_last(&report) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No benchmark has run yet");
+        return ESP_FAIL;
+    }
+    
+    char chunk[HTTP_JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), json_writer_httpd_sink, req);
+    
+    httpd_resp_set_type(req, "application/json");
+    data_bench_write_json(&w, &report);
+    
+    esp_err_t err = json_writer_finish(&w);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Benchmark response aborted: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+#ifdef CONFIG_KC_EZO_EMULATOR
+/**
+ * @brief GET /api/emulator - Emulated EZO boards, their programming and counters
+ */
+static esp_err_t api_emulator_get_handler(httpd_req_t *req)
+{
+    char chunk[HTTP_JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), json_writer_httpd_sink, req);
+    
+    httpd_resp_set_type(req, "application/json");
+    ezo_emulator_write_json(&w);
+    
+    esp_err_t err = json_writer_finish(&w);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Emulator response aborted: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * @brief POST /api/emulator - Add, reprogram or remove an emulated board
+ *
+ * Body: {"address":32, "type":"pH", "latency_ms":900, "jitter_ms":50,
+ * "fail_permille":0, "busy_permille":0, "values":[7.0], "noise":0.01,
+ * "response":"", "remove":false}. Fields left out keep their current value
+ * (or the kind's defaults for a new board). A rescan or hot-plug pass picks
+ * up the change.
+ */
+static esp_err_t api_emulator_post_handler(httpd_req_t *req)
+{
+    cJSON *root = parse_request_json_body(req);
+    if (root == NULL) {
+        return ESP_FAIL;
+    }
+    
+    const cJSON *address = cJSON_GetObjectItem(root, "address");
+    if (!cJSON_IsNumber(address) || address->valueint < 0x08 || address->valueint > 0x77) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "address must be 0x08..0x77");
         return ESP_FAIL;
     }
-
-    uint64_t timestamp_ms = esp_timer_get_time() / 1000ULL;
-    cJSON_AddNumberToObject(sensor_json, "timestamp_ms", (double)timestamp_ms);
-    cJSON_AddNumberToObject(sensor_json, "value_count", count);
-
-    cJSON *raw_array = cJSON_CreateArray();
-    if (raw_array != NULL) {
-        for (uint8_t i = 0; i < count; i++) {
-            cJSON_AddItemToArray(raw_array, cJSON_CreateNumber(values[i]));
+    uint8_t addr = (uint8_t)address->valueint;
+    
+    esp_err_t ret;
+    if (cJSON_IsTrue(cJSON_GetObjectItem(root, "remove"))) {
+        ret = ezo_emulator_remove(addr);
+    } else {
+        ezo_emulator_config_t config;
+        const cJSON *type = cJSON_GetObjectItem(root, "type");
+        bool exists = ezo_emulator_get(addr, &config) == ESP_OK;
+        if (cJSON_IsString(type)) {
+            uint8_t kind = ezo_sensor_kind_from_type(type->valuestring);
+            if (!exists || kind != config.kind) {
+                ezo_emulator_default_config(kind, addr, &config);
+            }
+        } else if (!exists) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "type is required for a new board");
+            return ESP_FAIL;
+        }
+        
+        const cJSON *item;
+        if (cJSON_IsNumber(item = cJSON_GetObjectItem(root, "latency_ms"))) {
+            config.latency_ms = (uint16_t)item->valueint;
+        }
+        if (cJSON_IsNumber(item = cJSON_GetObjectItem(root, "jitter_ms"))) {
+            config.jitter_ms = (uint16_t)item->valueint;
+        }
+        if (cJSON_IsNumber(item = cJSON_GetObjectItem(root, "fail_permille"))) {
+            config.fail_permille = (uint16_t)item->valueint;
+        }
+        if (cJSON_IsNumber(item = cJSON_GetObjectItem(root, "busy_permille"))) {
+            config.busy_permille = (uint16_t)item->valueint;
+        }
+        if (cJSON_IsNumber(item = cJSON_GetObjectItem(root, "noise"))) {
+            config.noise = (float)item->valuedouble;
+        }
+        if (cJSON_IsString(item = cJSON_GetObjectItem(root, "response"))) {
+            snprintf(config.response, sizeof(config.response), "%s", item->valuestring);
         }
-        cJSON_AddItemToObject(sensor_json, "raw", raw_array);
+        if (cJSON_IsArray(item = cJSON_GetObjectItem(root, "values"))) {
+            for (int v = 0; v < 4 && v < cJSON_GetArraySize(item); v++) {
+                const cJSON *value = cJSON_GetArrayItem(item, v);
+                if (cJSON_IsNumber(value)) {
+                    config.values[v] = (float)value->valuedouble;
+                }
+            }
+        }
+        ret = ezo_emulator_set(&config);
     }
-
-    add_sample_readings_to_json(sensor_json, sensor->config.type, values, count);
-
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        cJSON_Delete(sensor_json);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to allocate response");
+    cJSON_Delete(root);
+    
+    if (ret == ESP_ERR_NOT_FOUND) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No emulated board at this address");
         return ESP_FAIL;
     }
-
-    cJSON_AddStringToObject(root, "status", "success");
-    cJSON_AddItemToObject(root, "sensor", sensor_json);
-
-    const char *payload = cJSON_PrintUnformatted(root);
-    if (payload == NULL) {
-        cJSON_Delete(root);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to encode response");
+    if (ret != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, esp_err_to_name(ret));
         return ESP_FAIL;
     }
+    return api_emulator_get_handler(req);
+}
+#endif
 
+/**
+ * @brief GET /api/trace?limit= - Newest hot-path trace events, oldest first
+ */
+static esp_err_t api_trace_handler(httpd_req_t *req)
+{
+    char query[32];
+    uint32_t limit = 0;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        history_query_u32(query, "limit", &limit);
+    }
+    
+    char chunk[HTTP_JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), json_writer_httpd_sink, req);
+    
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, payload);
-    free((void*)payload);
-    cJSON_Delete(root);
-    return ESP_OK;
+    trace_log_write_json(&w, limit);
+    
+    esp_err_t err = json_writer_finish(&w);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Trace response aborted: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
 }
 
 // URI handlers
@@ -1964,6 +4188,13 @@ static const httpd_uri_t api_sensors_config_uri = {
     .user_ctx = NULL
 };
 
+static const httpd_uri_t api_job_get_uri = {
+    .uri = "/api/jobs/*",
+    .method = HTTP_GET,
+    .handler = api_job_get_handler,
+    .user_ctx = NULL
+};
+
 static const httpd_uri_t api_sensors_pause_uri = {
     .uri = "/api/sensors/pause",
     .method = HTTP_POST,
@@ -2020,6 +4251,78 @@ static const httpd_uri_t api_sensor_sample_uri = {
     .user_ctx = NULL
 };
 
+static const httpd_uri_t api_sensors_history_uri = {
+    .uri = "/api/sensors/history",
+    .method = HTTP_GET,
+    .handler = api_sensors_history_handler,
+    .user_ctx = NULL
+};
+
+static const httpd_uri_t api_perf_uri = {
+    .uri = "/api/perf",
+    .method = HTTP_GET,
+    .handler = api_perf_handler,
+    .user_ctx = NULL
+};
+
+static const httpd_uri_t api_perf_boot_uri = {
+    .uri = "/api/perf/boot",
+    .method = HTTP_GET,
+    .handler = api_perf_boot_handler,
+    .user_ctx = NULL
+};
+
+static const httpd_uri_t api_perf_bench_get_uri = {
+    .uri = "/api/perf/bench",
+    .method = HTTP_GET,
+    .handler = api_perf_bench_get_handler,
+    .user_ctx = NULL
+};
+
+static const httpd_uri_t api_perf_bench_post_uri = {
+    .uri = "/api/perf/bench",
+    .method = HTTP_POST,
+    .handler = api_perf_bench_post_handler,
+    .user_ctx = NULL
+};
+
+#ifdef CONFIG_KC_EZO_EMULATOR
+static const httpd_uri_t api_emulator_get_uri = {
+    .uri = "/api/emulator",
+    .method = HTTP_GET,
+    .handler = api_emulator_get_handler,
+    .user_ctx = NULL
+};
+
+static const httpd_uri_t api_emulator_post_uri = {
+    .uri = "/api/emulator",
+    .method = HTTP_POST,
+    .handler = api_emulator_post_handler,
+    .user_ctx = NULL
+};
+#endif
+
+static const httpd_uri_t api_trace_uri = {
+    .uri = "/api/trace",
+    .method = HTTP_GET,
+    .handler = api_trace_handler,
+    .user_ctx = NULL
+};
+
+static const httpd_uri_t api_perf_mqtt_uri = {
+    .uri = "/api/perf/mqtt",
+    .method = HTTP_GET,
+    .handler = api_perf_mqtt_handler,
+    .user_ctx = NULL
+};
+
+static const httpd_uri_t api_perf_sensors_uri = {
+    .uri = "/api/perf/sensors",
+    .method = HTTP_GET,
+    .handler = api_perf_sensors_handler,
+    .user_ctx = NULL
+};
+
 /**
  * @brief List web files API handler
  */
@@ -2029,7 +4332,7 @@ static esp_err_t api_webfiles_list_handler(httpd_req_t *req)
     if (web_editor_list_files(&json) == ESP_OK) {
         httpd_resp_set_type(req, "application/json");
         httpd_resp_send(req, json, HTTPD_RESP_USE_STRLEN);
-        free(json);
+        cJSON_free(json);
         return ESP_OK;
     }
     httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to list files");
@@ -2046,6 +4349,11 @@ static esp_err_t api_webfiles_get_handler(httpd_req_t *req)
     
     ESP_LOGI(TAG, "GET handler called for file: %s", filename);
     
+    // Dashboard CSS/JS are linked from index.html through this endpoint
+    if (send_cached_asset(req, filename) == ESP_OK) {
+        return ESP_OK;
+    }
+    
     char *content = NULL;
     size_t size = 0;
     esp_err_t ret = web_editor_load_file(filename, &content, &size);
@@ -2068,43 +4376,53 @@ static esp_err_t api_webfiles_put_handler(httpd_req_t *req)
     // Extract filename from URI (e.g., /api/webfiles/index.html)
     const char *filename = req->uri + strlen("/api/webfiles/");
     
-    // Read request body (allocate from PSRAM first to avoid IRAM fragmentation)
-    char *content = heap_caps_malloc(WEB_EDITOR_MAX_FILE_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (content == NULL) {
-        content = malloc(WEB_EDITOR_MAX_FILE_SIZE);
+    if (req->content_len > WEB_EDITOR_MAX_FILE_SIZE) {
+        httpd_resp_send_err(req, HTTPD_413_CONTENT_TOO_LARGE, "File exceeds 200KB limit");
+        return ESP_FAIL;
+    }
+    
+    // Stream the body to a temporary file instead of buffering the whole upload
+    web_editor_upload_t *upload = NULL;
+    esp_err_t ret = web_editor_upload_begin(filename, &upload);
+    if (ret == ESP_ERR_INVALID_ARG || ret == ESP_ERR_NOT_ALLOWED) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid file name or type");
+        return ESP_FAIL;
+    }
+    if (ret != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to save file");
+        return ESP_FAIL;
     }
-    if (content == NULL) {
-        ESP_LOGE(TAG, "webfiles PUT: failed to allocate %d bytes", WEB_EDITOR_MAX_FILE_SIZE);
+    
+    char *chunk = malloc(HTTP_UPLOAD_CHUNK_SIZE);
+    if (chunk == NULL) {
+        web_editor_upload_abort(upload);
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
         return ESP_FAIL;
     }
     
-    int total_len = 0;
-    int received;
-    while (total_len < req->content_len && total_len < WEB_EDITOR_MAX_FILE_SIZE) {
-        size_t bytes_to_read = req->content_len - total_len;
-        if (bytes_to_read > WEB_EDITOR_MAX_FILE_SIZE - total_len) {
-            bytes_to_read = WEB_EDITOR_MAX_FILE_SIZE - total_len;
-        }
-        received = httpd_req_recv(req, content + total_len, bytes_to_read);
+    size_t remaining = req->content_len;
+    while (remaining > 0) {
+        size_t bytes_to_read = remaining < HTTP_UPLOAD_CHUNK_SIZE ? remaining : HTTP_UPLOAD_CHUNK_SIZE;
+        int received = httpd_req_recv(req, chunk, bytes_to_read);
         if (received <= 0) {
-            free(content);
+            free(chunk);
+            web_editor_upload_abort(upload);
             httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to read request");
             return ESP_FAIL;
         }
-        total_len += received;
-    }
-    
-    if (total_len == WEB_EDITOR_MAX_FILE_SIZE && total_len < req->content_len) {
-        free(content);
-        httpd_resp_send_err(req, HTTPD_413_CONTENT_TOO_LARGE, "File exceeds 200KB limit");
-        return ESP_FAIL;
+        ret = web_editor_upload_write(upload, chunk, received);
+        if (ret != ESP_OK) {
+            free(chunk);
+            web_editor_upload_abort(upload);
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to save file");
+            return ESP_FAIL;
+        }
+        remaining -= received;
     }
+    free(chunk);
     
-    // Persist to on-device filesystem
-    esp_err_t ret = web_editor_save_file(filename, content, total_len);
-    free(content);
-    
+    // Replaces the live file only once the whole body is on flash
+    ret = web_editor_upload_commit(upload);
     if (ret == ESP_OK) {
         httpd_resp_set_type(req, "application/json");
         httpd_resp_sendstr(req, "{\"success\":true}");
@@ -2191,65 +4509,44 @@ static esp_err_t api_firmware_upload_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    esp_ota_handle_t ota_handle = 0;
-    esp_err_t err = esp_ota_begin(update_partition, req->content_len, &ota_handle);
+    // The writer task flashes filled buffers while this handler keeps receiving
+    ota_pipeline_t *ota = NULL;
+    esp_err_t err = ota_pipeline_begin(&ota);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "esp_ota_begin failed: %s", esp_err_to_name(err));
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to start OTA");
         return ESP_FAIL;
     }
 
-    uint8_t *ota_buffer = heap_caps_malloc(OTA_UPLOAD_BUFFER_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (ota_buffer == NULL) {
-        ota_buffer = malloc(OTA_UPLOAD_BUFFER_SIZE);
-    }
-    if (ota_buffer == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate OTA buffer");
-        esp_ota_abort(ota_handle);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
-        return ESP_FAIL;
-    }
-
     int remaining = req->content_len;
     while (remaining > 0) {
-        int chunk = remaining > OTA_UPLOAD_BUFFER_SIZE ? OTA_UPLOAD_BUFFER_SIZE : remaining;
-        int received = httpd_req_recv(req, (char *)ota_buffer, chunk);
+        uint8_t *buf = NULL;
+        size_t capacity = 0;
+        err = ota_pipeline_acquire(ota, &buf, &capacity);
+        if (err != ESP_OK) {
+            ota_pipeline_abort(ota);
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Flash write failed");
+            return ESP_FAIL;
+        }
+
+        int chunk = (size_t)remaining > capacity ? (int)capacity : remaining;
+        int received = httpd_req_recv(req, (char *)buf, chunk);
         if (received <= 0) {
             if (received == HTTPD_SOCK_ERR_TIMEOUT) {
                 continue;
             }
             ESP_LOGE(TAG, "OTA upload interrupted (%d)", received);
-            free(ota_buffer);
-            esp_ota_abort(ota_handle);
+            ota_pipeline_abort(ota);
             httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Upload interrupted");
             return ESP_FAIL;
         }
 
-        err = esp_ota_write(ota_handle, ota_buffer, received);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "esp_ota_write failed: %s", esp_err_to_name(err));
-            free(ota_buffer);
-            esp_ota_abort(ota_handle);
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Flash write failed");
-            return ESP_FAIL;
-        }
+        ota_pipeline_produced(ota, received);
         remaining -= received;
     }
 
-    free(ota_buffer);
-
-    err = esp_ota_end(ota_handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "esp_ota_end failed: %s", esp_err_to_name(err));
-        esp_ota_abort(ota_handle);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA finalize failed");
-        return ESP_FAIL;
-    }
-
-    err = esp_ota_set_boot_partition(update_partition);
+    err = ota_pipeline_finish(ota);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set boot partition: %s", esp_err_to_name(err));
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to set boot partition");
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA image rejected");
         return ESP_FAIL;
     }
 
@@ -2274,34 +4571,11 @@ static const httpd_uri_t api_firmware_upload_uri = {
  */
 static esp_err_t ca_cert_handler(httpd_req_t *req)
 {
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open_from_partition("https", "https", NVS_READONLY, &nvs_handle);
-    if (err != ESP_OK) {
-        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "CA certificate not found");
-        return ESP_FAIL;
-    }
-    
+    const char *ca_cert = NULL;
     size_t ca_cert_len = 0;
-    err = nvs_get_str(nvs_handle, "ca_cert", NULL, &ca_cert_len);
-    if (err != ESP_OK || ca_cert_len == 0) {
-        nvs_close(nvs_handle);
-        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "CA certificate not available");
-        return ESP_FAIL;
-    }
-    
-    char *ca_cert = malloc(ca_cert_len);
-    if (ca_cert == NULL) {
-        nvs_close(nvs_handle);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
-        return ESP_FAIL;
-    }
-    
-    err = nvs_get_str(nvs_handle, "ca_cert", ca_cert, &ca_cert_len);
-    nvs_close(nvs_handle);
-    
+    esp_err_t err = cloud_prov_credential_get(CLOUD_PROV_CRED_CA_CERT, &ca_cert, &ca_cert_len);
     if (err != ESP_OK) {
-        free(ca_cert);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to read CA certificate");
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "CA certificate not available");
         return ESP_FAIL;
     }
     
@@ -2309,8 +4583,7 @@ static esp_err_t ca_cert_handler(httpd_req_t *req)
     httpd_resp_set_type(req, "application/x-pem-file");
     httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"kannacloud-ca.crt\"");
     
-    httpd_resp_send(req, ca_cert, ca_cert_len - 1);
-    free(ca_cert);
+    httpd_resp_send(req, ca_cert, ca_cert_len);
     
     return ESP_OK;
 }
@@ -2330,6 +4603,238 @@ static const httpd_uri_t sensor_ws_uri = {
     .is_websocket = true
 };
 
+// ============================================================================
+// Connection budget
+// ============================================================================
+// The server holds HTTP_MAX_OPEN_SOCKETS TLS sessions. Left to httpd's LRU
+// purge, a burst of dashboard requests evicts the WebSocket (it rarely sends
+// anything, so it is always least recently used) and every eviction costs the
+// browser a full ECDHE handshake. Instead, one slot is always kept free for
+// the next connection by closing the oldest API session, WebSocket sessions
+// are never closed by the budget, and API sessions are retired after
+// HTTP_API_KEEPALIVE_MS so they cannot pin their slot. Session tickets make
+// the reconnects that follow an abbreviated handshake.
+//
+// Every function in this section runs in the httpd task, so the session table
+// and counters need no lock.
+
+/**
+ * @brief Check if a session has been upgraded to the sensor WebSocket
+ */
+static bool sensor_ws_is_client(int fd)
+{
+    bool result = false;
+    if (s_ws_clients_mutex != NULL && xSemaphoreTake(s_ws_clients_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+        for (int i = 0; i < SENSOR_WS_MAX_CLIENTS; i++) {
+            if (s_ws_clients[i].active && s_ws_clients[i].fd == fd) {
+                result = true;
+                break;
+            }
+        }
+        xSemaphoreGive(s_ws_clients_mutex);
+    }
+    return result;
+}
+
+static int http_session_count(void)
+{
+    int count = 0;
+    for (int i = 0; i < HTTP_MAX_OPEN_SOCKETS; i++) {
+        if (s_http_sessions[i].fd >= 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Close the oldest session that is not a WebSocket
+ *
+ * @param keep_fd Session that must stay open (the one just accepted), or -1
+ * @return true if a session was closed
+ */
+static bool http_budget_close_oldest(int keep_fd)
+{
+    int oldest = -1;
+    for (int i = 0; i < HTTP_MAX_OPEN_SOCKETS; i++) {
+        http_session_t *session = &s_http_sessions[i];
+        if (session->fd < 0 || session->fd == keep_fd || sensor_ws_is_client(session->fd)) {
+            continue;
+        }
+        if (oldest < 0 || session->opened_us < s_http_sessions[oldest].opened_us) {
+            oldest = i;
+        }
+    }
+    if (oldest < 0) {
+        return false;
+    }
+
+    ESP_LOGD(TAG, "Connection budget: closing fd %d", s_http_sessions[oldest].fd);
+    httpd_sess_trigger_close(s_server, s_http_sessions[oldest].fd);
+    s_http_stats.budget_closes++;
+    return true;
+}
+
+#ifdef CONFIG_ESP_HTTPS_SERVER_CERT_SELECT_HOOK
+/**
+ * @brief Marks the start of a handshake (ClientHello parsed)
+ *
+ * Handshakes run one at a time inside httpd's accept path, so a single start
+ * timestamp is enough. Returning 0 keeps the configured certificate.
+ */
+static int http_handshake_start_cb(mbedtls_ssl_context *ssl)
+{
+    (void)ssl;
+    s_http_handshake_start_us = esp_timer_get_time();
+    s_http_stats.handshakes_started++;
+    return 0;
+}
+#endif
+
+/**
+ * @brief Session opened: called by esp_https_server once the handshake is done
+ */
+static esp_err_t http_session_open_cb(httpd_handle_t hd, int sockfd)
+{
+    (void)hd;
+    int64_t now_us = esp_timer_get_time();
+
+    s_http_stats.handshakes++;
+    if (s_http_handshake_start_us > 0) {
+        uint32_t ms = (uint32_t)((now_us - s_http_handshake_start_us) / 1000);
+        s_http_handshake_start_us = 0;
+        s_http_stats.handshakes_timed++;
+        s_http_stats.handshake_last_ms = ms;
+        s_http_stats.handshake_total_ms += ms;
+        if (ms > s_http_stats.handshake_max_ms) {
+            s_http_stats.handshake_max_ms = ms;
+        }
+    }
+
+    for (int i = 0; i < HTTP_MAX_OPEN_SOCKETS; i++) {
+        if (s_http_sessions[i].fd < 0) {
+            s_http_sessions[i].fd = sockfd;
+            s_http_sessions[i].opened_us = now_us;
+            break;
+        }
+    }
+
+    // Keep a slot free so the next connection (often the WebSocket) never triggers the LRU purge
+    if (http_session_count() >= HTTP_MAX_OPEN_SOCKETS) {
+        http_budget_close_oldest(sockfd);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Session closed: forget it and close the socket (replaces httpd's default close)
+ */
+static void http_session_close_cb(httpd_handle_t hd, int sockfd)
+{
+    (void)hd;
+    for (int i = 0; i < HTTP_MAX_OPEN_SOCKETS; i++) {
+        if (s_http_sessions[i].fd == sockfd) {
+            s_http_sessions[i].fd = -1;
+            break;
+        }
+    }
+    close(sockfd);
+}
+
+static void http_budget_sweep_work_cb(void *arg)
+{
+    (void)arg;
+    atomic_store(&s_http_sweep_queued, false);
+    if (s_server == NULL) {
+        return;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    for (int i = 0; i < HTTP_MAX_OPEN_SOCKETS; i++) {
+        http_session_t *session = &s_http_sessions[i];
+        if (session->fd < 0 || now_us - session->opened_us < (int64_t)HTTP_API_KEEPALIVE_MS * 1000) {
+            continue;
+        }
+        if (!sensor_ws_is_client(session->fd)) {
+            ESP_LOGD(TAG, "Retiring API session fd %d after keep-alive limit", session->fd);
+            httpd_sess_trigger_close(s_server, session->fd);
+            s_http_stats.keepalive_closes++;
+            // Re-arm so a close still in flight is not counted twice
+            session->opened_us = now_us;
+        }
+    }
+}
+
+static void http_budget_timer_cb(void *arg)
+{
+    (void)arg;
+    if (s_server == NULL || atomic_exchange(&s_http_sweep_queued, true)) {
+        return;
+    }
+    if (httpd_queue_work(s_server, http_budget_sweep_work_cb, NULL) != ESP_OK) {
+        atomic_store(&s_http_sweep_queued, false);
+    }
+}
+
+static void http_budget_start(void)
+{
+    for (int i = 0; i < HTTP_MAX_OPEN_SOCKETS; i++) {
+        s_http_sessions[i].fd = -1;
+    }
+    s_http_handshake_start_us = 0;
+
+    if (s_http_budget_timer == NULL) {
+        esp_timer_create_args_t args = {
+            .callback = http_budget_timer_cb,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "http_budget"
+        };
+        if (esp_timer_create(&args, &s_http_budget_timer) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create connection budget timer");
+            return;
+        }
+    }
+    esp_timer_start_periodic(s_http_budget_timer, HTTP_BUDGET_SWEEP_MS * 1000ULL);
+}
+
+static void http_budget_stop(void)
+{
+    if (s_http_budget_timer != NULL) {
+        esp_timer_stop(s_http_budget_timer);
+        esp_timer_delete(s_http_budget_timer);
+        s_http_budget_timer = NULL;
+    }
+}
+
+/**
+ * @brief Write connection and handshake counters as a JSON object
+ */
+static void http_write_connection_stats(json_writer_t *w)
+{
+    json_writer_object_begin(w);
+    json_writer_kv_int(w, "open_sessions", http_session_count());
+    json_writer_kv_int(w, "max_sessions", HTTP_MAX_OPEN_SOCKETS);
+#ifdef CONFIG_ESP_TLS_SERVER_SESSION_TICKETS
+    json_writer_kv_bool(w, "session_tickets", true);
+#else
+    json_writer_kv_bool(w, "session_tickets", false);
+#endif
+    json_writer_kv_int(w, "handshakes", s_http_stats.handshakes);
+#ifdef CONFIG_ESP_HTTPS_SERVER_CERT_SELECT_HOOK
+    // Started but never completed: aborted by the client or failed
+    json_writer_kv_int(w, "handshakes_failed", s_http_stats.handshakes_started - s_http_stats.handshakes_timed);
+    json_writer_kv_int(w, "handshake_last_ms", s_http_stats.handshake_last_ms);
+    json_writer_kv_int(w, "handshake_max_ms", s_http_stats.handshake_max_ms);
+    if (s_http_stats.handshakes_timed > 0) {
+        json_writer_kv_int(w, "handshake_avg_ms", s_http_stats.handshake_total_ms / s_http_stats.handshakes_timed);
+    }
+#endif
+    json_writer_kv_int(w, "budget_closes", s_http_stats.budget_closes);
+    json_writer_kv_int(w, "keepalive_closes", s_http_stats.keepalive_closes);
+    json_writer_object_end(w);
+}
+
 esp_err_t http_server_start(void)
 {
     if (s_server != NULL) {
@@ -2342,31 +4847,19 @@ esp_err_t http_server_start(void)
     
     ESP_LOGI(TAG, "Starting HTTPS server...");
     
-    // Get certificates from cloud provisioning
-    char *certificate = malloc(CLOUD_PROV_MAX_CERT_SIZE);
-    char *private_key = malloc(CLOUD_PROV_MAX_KEY_SIZE);
-    
-    if (certificate == NULL || private_key == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate memory for certificates");
-        free(certificate);
-        free(private_key);
-        return ESP_ERR_NO_MEM;
-    }
-    
-    size_t cert_len, key_len;
-    esp_err_t err = cloud_prov_get_certificate(certificate, &cert_len);
+    // Views into the credential cache; mbedTLS parses its own copy at start
+    const char *certificate = NULL;
+    const char *private_key = NULL;
+    size_t cert_len = 0, key_len = 0;
+    esp_err_t err = cloud_prov_credential_get(CLOUD_PROV_CRED_DEVICE_CERT, &certificate, &cert_len);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to get certificate: %s", esp_err_to_name(err));
-        free(certificate);
-        free(private_key);
         return err;
     }
     
-    err = cloud_prov_get_private_key(private_key, &key_len);
+    err = cloud_prov_credential_get(CLOUD_PROV_CRED_PRIVATE_KEY, &private_key, &key_len);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to get private key: %s", esp_err_to_name(err));
-        free(certificate);
-        free(private_key);
         return err;
     }
     
@@ -2381,17 +4874,21 @@ esp_err_t http_server_start(void)
     
     // Configure HTTPS server
     httpd_ssl_config_t config = HTTPD_SSL_CONFIG_DEFAULT();
-    config.httpd.max_uri_handlers = 30;  // Increased for web file editor + sensor action endpoints
-    config.httpd.stack_size = 8192;  // Reduced stack to save memory
-    config.httpd.max_open_sockets = 3;  // Allow multiple connections now that PSRAM is enabled
-    config.httpd.lru_purge_enable = true;  // Enable automatic cleanup of old connections
-    config.httpd.close_fn = NULL;  // Use default close function
+    config.httpd.max_uri_handlers = 40;  // Increased for web file editor + sensor action + perf endpoints
+    const task_profile_entry_t *httpd_task = task_profile_get(TASK_PROFILE_HTTPD);
+    config.httpd.stack_size = httpd_task->stack;
+    config.httpd.task_priority = httpd_task->priority;
+    config.httpd.core_id = httpd_task->core < 0 ? tskNO_AFFINITY : httpd_task->core;
+    config.httpd.max_open_sockets = HTTP_MAX_OPEN_SOCKETS;
+    config.httpd.lru_purge_enable = true;  // Backstop only; the connection budget keeps a slot free
+    config.httpd.open_fn = http_session_open_cb;   // Chained by esp_https_server after the handshake
+    config.httpd.close_fn = http_session_close_cb;
     config.httpd.recv_wait_timeout = 30;  // Increased timeout for SSL handshake (was 10)
     config.httpd.send_wait_timeout = 30;  // Increased timeout for SSL handshake (was 10)
     config.port_insecure = 0;  // Disable insecure port (HTTPS only)
     config.httpd.uri_match_fn = httpd_uri_match_wildcard;  // Enable wildcard URI matching
     
-    // Set certificates (PEM format from NVS is already null-terminated)
+    // Set certificates (PEM in the credential cache is null-terminated)
     // mbedTLS needs length + 1 to include the null terminator
     config.servercert = (const uint8_t *)certificate;
     config.servercert_len = cert_len + 1;
@@ -2399,46 +4896,76 @@ esp_err_t http_server_start(void)
     config.prvtkey_len = key_len + 1;
     
     // Skip client certificate verification (allows browsers to connect without trusting cert)
-    config.session_tickets = false;  // Disable session resumption for testing
+#ifdef CONFIG_ESP_TLS_SERVER_SESSION_TICKETS
+    // Reconnecting browsers resume with a ticket instead of a full ECDHE handshake
+    config.session_tickets = true;
+#else
+    config.session_tickets = false;
+#endif
+#ifdef CONFIG_ESP_HTTPS_SERVER_CERT_SELECT_HOOK
+    config.cert_select_cb = http_handshake_start_cb;
+#endif
     config.use_secure_element = false;  // Not using hardware secure element
     
+    http_budget_start();
+    
+    // Slow sensor actions run here instead of in the httpd task
+    err = sensor_jobs_init(sensor_job_ws_listener);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start sensor job executor: %s", esp_err_to_name(err));
+        http_budget_stop();
+        return err;
+    }
+    alarm_rules_set_listener(alarm_ws_listener);
+    
     // Start server
     err = httpd_ssl_start(&s_server, &config);
     
-    // Clean up certificate buffers
-    free(certificate);
-    free(private_key);
-    
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to start HTTPS server: %s", esp_err_to_name(err));
+        http_budget_stop();
         return err;
     }
     
-    // Register URI handlers
+    // Register URI handlers; JSON endpoints get a request arena, except the
+    // config endpoint, whose parsed body outlives the request in a sensor job
     httpd_register_uri_handler(s_server, &favicon_uri);
     httpd_register_uri_handler(s_server, &root_uri);
-    httpd_register_uri_handler(s_server, &sensor_ws_uri);
+    http_register_arena_handler(s_server, &sensor_ws_uri);
     httpd_register_uri_handler(s_server, &ca_cert_uri);  // CA certificate download
-    httpd_register_uri_handler(s_server, &api_status_uri);
-    httpd_register_uri_handler(s_server, &api_clear_wifi_uri);
-    httpd_register_uri_handler(s_server, &api_reboot_uri);
-    httpd_register_uri_handler(s_server, &api_test_mqtt_uri);
-    httpd_register_uri_handler(s_server, &api_settings_get_uri);
-    httpd_register_uri_handler(s_server, &api_settings_post_uri);
-    httpd_register_uri_handler(s_server, &api_settings_reset_uri);
-    httpd_register_uri_handler(s_server, &api_sensors_list_uri);
-    httpd_register_uri_handler(s_server, &api_sensors_rescan_uri);
+    http_register_arena_handler(s_server, &api_status_uri);
+    http_register_arena_handler(s_server, &api_clear_wifi_uri);
+    http_register_arena_handler(s_server, &api_reboot_uri);
+    http_register_arena_handler(s_server, &api_test_mqtt_uri);
+    http_register_arena_handler(s_server, &api_settings_get_uri);
+    http_register_arena_handler(s_server, &api_settings_post_uri);
+    http_register_arena_handler(s_server, &api_settings_reset_uri);
+    http_register_arena_handler(s_server, &api_sensors_list_uri);
+    http_register_arena_handler(s_server, &api_sensors_rescan_uri);
     httpd_register_uri_handler(s_server, &api_sensors_config_uri);
-    httpd_register_uri_handler(s_server, &api_sensors_pause_uri);
-    httpd_register_uri_handler(s_server, &api_sensors_resume_uri);
-    httpd_register_uri_handler(s_server, &api_sensor_calibrate_uri);
-    httpd_register_uri_handler(s_server, &api_sensor_comp_uri);
-    httpd_register_uri_handler(s_server, &api_sensor_mode_uri);
-    httpd_register_uri_handler(s_server, &api_sensor_power_uri);
-    httpd_register_uri_handler(s_server, &api_sensor_status_uri);
-    httpd_register_uri_handler(s_server, &api_sensor_sample_uri);
+    http_register_arena_handler(s_server, &api_job_get_uri);
+    http_register_arena_handler(s_server, &api_sensors_pause_uri);
+    http_register_arena_handler(s_server, &api_sensors_resume_uri);
+    http_register_arena_handler(s_server, &api_sensor_calibrate_uri);
+    http_register_arena_handler(s_server, &api_sensor_comp_uri);
+    http_register_arena_handler(s_server, &api_sensor_mode_uri);
+    http_register_arena_handler(s_server, &api_sensor_power_uri);
+    http_register_arena_handler(s_server, &api_sensor_status_uri);
+    http_register_arena_handler(s_server, &api_sensor_sample_uri);
+    http_register_arena_handler(s_server, &api_sensors_history_uri);
+    http_register_arena_handler(s_server, &api_perf_uri);
+    http_register_arena_handler(s_server, &api_perf_boot_uri);
+    http_register_arena_handler(s_server, &api_perf_bench_get_uri);
+    http_register_arena_handler(s_server, &api_perf_bench_post_uri);
+#ifdef CONFIG_KC_EZO_EMULATOR
+    http_register_arena_handler(s_server, &api_emulator_get_uri);
+    http_register_arena_handler(s_server, &api_emulator_post_uri);
+#endif
+    http_register_arena_handler(s_server, &api_trace_uri);
+    http_register_arena_handler(s_server, &api_perf_mqtt_uri);
+    http_register_arena_handler(s_server, &api_perf_sensors_uri);
     // Register specific list endpoint before wildcard catch-alls so /list is handled correctly
-    httpd_register_uri_handler(s_server, &api_webfiles_list_uri);
+    http_register_arena_handler(s_server, &api_webfiles_list_uri);
     httpd_register_uri_handler(s_server, &api_webfiles_reset_uri);
     httpd_register_uri_handler(s_server, &api_webfiles_get_uri);
     httpd_register_uri_handler(s_server, &api_webfiles_put_uri);
@@ -2459,17 +4986,27 @@ esp_err_t http_server_stop(void)
         return ESP_OK;
     }
     
-    sensor_manager_register_cache_listener(NULL, NULL);
+    sensor_manager_unregister_cache_listener(handle_sensor_cache_update);
+    alarm_rules_set_listener(NULL);
+    http_budget_stop();
     focus_stream_stop();
     if (s_focus_timer != NULL) {
         esp_timer_delete(s_focus_timer);
         s_focus_timer = NULL;
     }
+    if (s_status_timer != NULL) {
+        esp_timer_stop(s_status_timer);
+        esp_timer_delete(s_status_timer);
+        s_status_timer = NULL;
+    }
+    s_status_push.valid = false;
     if (s_ws_clients_mutex != NULL) {
         if (xSemaphoreTake(s_ws_clients_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
             for (int i = 0; i < SENSOR_WS_MAX_CLIENTS; i++) {
                 s_ws_clients[i].active = false;
                 s_ws_clients[i].fd = -1;
+                s_ws_clients[i].send_scheduled = false;
+                sensor_ws_client_clear_locked(&s_ws_clients[i]);
             }
             xSemaphoreGive(s_ws_clients_mutex);
         }
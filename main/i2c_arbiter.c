@@ -0,0 +1,490 @@
+/**
+ * @file i2c_arbiter.c
+ * @brief Prioritized I2C bus arbiter implementation
+ */
+
+#include "i2c_arbiter.h"
+#include "task_profile.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "I2C_ARB";
+
+#define I2C_ARBITER_QUEUE_DEPTH 8
+#define I2C_ARBITER_SUBMIT_TIMEOUT_MS 1000
+
+typedef struct {
+    i2c_arbiter_txn_fn_t fn;
+    void *ctx;
+    i2c_arbiter_done_cb_t done_cb;
+    SemaphoreHandle_t done_sem;     // Signalled for synchronous callers
+    esp_err_t *result;              // Written before done_sem is given
+    uint8_t address;
+    i2c_arbiter_priority_t prio;
+} i2c_arbiter_request_t;
+
+// A session is a transaction that parks the arbiter until the owner releases it
+typedef struct {
+    SemaphoreHandle_t granted;
+    SemaphoreHandle_t released;
+} i2c_arbiter_session_t;
+
+typedef struct {
+    QueueHandle_t queues[I2C_ARBITER_PRIO_COUNT];
+    SemaphoreHandle_t pending;
+    TaskHandle_t task;
+    i2c_arbiter_session_t *active_session;
+} i2c_arbiter_bus_t;
+
+// A task holding sessions; at most one task holds each bus
+typedef struct {
+    TaskHandle_t task;
+    uint8_t bus_mask;               // Buses held, released by the outermost end
+    uint32_t depth;
+} i2c_arbiter_owner_t;
+
+static i2c_arbiter_bus_t s_buses[I2C_ARBITER_MAX_BUSES] = {0};
+static uint8_t s_bus_count = 0;     // 0 until the tasks run
+static uint8_t s_device_bus[128] = {0};
+
+static i2c_arbiter_owner_t s_owners[I2C_ARBITER_MAX_BUSES] = {0};
+static portMUX_TYPE s_owner_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t s_epoch[128] = {0};
+
+static uint8_t i2c_arbiter_bus_of(uint8_t address) {
+    uint8_t bus = s_device_bus[address & 0x7F];
+    return bus < s_bus_count ? bus : 0;
+}
+
+static i2c_arbiter_owner_t *i2c_arbiter_find_owner(TaskHandle_t task) {
+    for (int i = 0; i < I2C_ARBITER_MAX_BUSES; i++) {
+        if (s_owners[i].task == task) {
+            return &s_owners[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Buses the calling task can use without a new session
+ *
+ * Each arbiter task implicitly owns its bus while it runs a transaction.
+ */
+static uint8_t i2c_arbiter_caller_mask(void) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint8_t mask = 0;
+    for (uint8_t b = 0; b < s_bus_count; b++) {
+        if (s_buses[b].task == self) {
+            mask |= (uint8_t)(1u << b);
+        }
+    }
+    taskENTER_CRITICAL(&s_owner_lock);
+    const i2c_arbiter_owner_t *owner = i2c_arbiter_find_owner(self);
+    if (owner != NULL) {
+        mask |= owner->bus_mask;
+    }
+    taskEXIT_CRITICAL(&s_owner_lock);
+    return mask;
+}
+
+static bool i2c_arbiter_caller_owns_bus(uint8_t bus) {
+    return (i2c_arbiter_caller_mask() & (1u << bus)) != 0;
+}
+
+static void i2c_arbiter_task(void *arg) {
+    i2c_arbiter_bus_t *bus = (i2c_arbiter_bus_t *)arg;
+    ESP_LOGI(TAG, "I2C arbiter task started (bus %d)", (int)(bus - s_buses));
+
+    while (1) {
+        if (xSemaphoreTake(bus->pending, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        i2c_arbiter_request_t req;
+        bool have_request = false;
+        for (int p = 0; p < I2C_ARBITER_PRIO_COUNT && !have_request; p++) {
+            have_request = (xQueueReceive(bus->queues[p], &req, 0) == pdTRUE);
+        }
+        if (!have_request) {
+            continue;
+        }
+
+        if (req.prio != I2C_ARBITER_PRIO_SCHEDULED) {
+            s_epoch[req.address & 0x7F]++;
+        }
+
+        esp_err_t ret = req.fn(req.ctx);
+
+        if (req.result != NULL) {
+            *req.result = ret;
+        }
+        if (req.done_cb != NULL) {
+            req.done_cb(ret, req.ctx);
+        }
+        if (req.done_sem != NULL) {
+            xSemaphoreGive(req.done_sem);
+        }
+    }
+}
+
+esp_err_t i2c_arbiter_init(uint8_t bus_count) {
+    if (s_bus_count > 0) {
+        return ESP_OK;
+    }
+    if (bus_count == 0) {
+        bus_count = 1;
+    } else if (bus_count > I2C_ARBITER_MAX_BUSES) {
+        bus_count = I2C_ARBITER_MAX_BUSES;
+    }
+
+    for (uint8_t b = 0; b < bus_count; b++) {
+        i2c_arbiter_bus_t *bus = &s_buses[b];
+        for (int p = 0; p < I2C_ARBITER_PRIO_COUNT; p++) {
+            bus->queues[p] = xQueueCreate(I2C_ARBITER_QUEUE_DEPTH, sizeof(i2c_arbiter_request_t));
+            if (bus->queues[p] == NULL) {
+                ESP_LOGE(TAG, "Failed to create request queue %d of bus %u", p, b);
+                return ESP_ERR_NO_MEM;
+            }
+        }
+
+        bus->pending = xSemaphoreCreateCounting(I2C_ARBITER_QUEUE_DEPTH * I2C_ARBITER_PRIO_COUNT, 0);
+        if (bus->pending == NULL) {
+            ESP_LOGE(TAG, "Failed to create request semaphore of bus %u", b);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    for (uint8_t b = 0; b < bus_count; b++) {
+        char name[configMAX_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), b == 0 ? "i2c_arb" : "i2c_arb%u", b);
+        // Shares its core with the sensor reading task (see task_profile.c)
+        BaseType_t ret = task_profile_create(TASK_PROFILE_I2C_ARBITER, i2c_arbiter_task, name, &s_buses[b],
+                                             &s_buses[b].task);
+        if (ret != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create arbiter task for bus %u", b);
+            s_buses[b].task = NULL;
+            if (b == 0) {
+                return ESP_FAIL;
+            }
+            // Devices on the other buses are served through bus 0's task
+            bus_count = b;
+            break;
+        }
+    }
+
+    s_bus_count = bus_count;
+    ESP_LOGI(TAG, "✓ I2C arbiter ready (%u bus%s)", bus_count, bus_count == 1 ? "" : "es");
+    return ESP_OK;
+}
+
+bool i2c_arbiter_is_running(void) {
+    return s_bus_count > 0;
+}
+
+void i2c_arbiter_set_device_bus(uint8_t address, uint8_t bus) {
+    if (bus < I2C_ARBITER_MAX_BUSES) {
+        s_device_bus[address & 0x7F] = bus;
+    }
+}
+
+uint8_t i2c_arbiter_get_device_bus(uint8_t address) {
+    uint8_t bus = s_device_bus[address & 0x7F];
+    return bus < I2C_ARBITER_MAX_BUSES ? bus : 0;
+}
+
+static esp_err_t i2c_arbiter_enqueue(uint8_t bus, const i2c_arbiter_request_t *req) {
+    if (req->prio >= I2C_ARBITER_PRIO_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (xQueueSend(s_buses[bus].queues[req->prio], req, pdMS_TO_TICKS(I2C_ARBITER_SUBMIT_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "Request queue %d of bus %u full", req->prio, bus);
+        return ESP_ERR_TIMEOUT;
+    }
+    xSemaphoreGive(s_buses[bus].pending);
+    return ESP_OK;
+}
+
+esp_err_t i2c_arbiter_run(i2c_arbiter_priority_t prio, uint8_t address,
+                          i2c_arbiter_txn_fn_t fn, void *ctx) {
+    if (fn == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!i2c_arbiter_is_running()) {
+        return fn(ctx);
+    }
+
+    if (address == I2C_ARBITER_ADDR_ANY && s_bus_count > 1) {
+        esp_err_t err = i2c_arbiter_begin(prio, address);
+        if (err == ESP_OK) {
+            err = fn(ctx);
+        }
+        i2c_arbiter_end();
+        return err;
+    }
+
+    uint8_t bus = i2c_arbiter_bus_of(address);
+    if (i2c_arbiter_caller_owns_bus(bus)) {
+        return fn(ctx);
+    }
+
+    esp_err_t result = ESP_FAIL;
+    i2c_arbiter_request_t req = {
+        .fn = fn,
+        .ctx = ctx,
+        .done_cb = NULL,
+        .done_sem = xSemaphoreCreateBinary(),
+        .result = &result,
+        .address = address,
+        .prio = prio,
+    };
+    if (req.done_sem == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = i2c_arbiter_enqueue(bus, &req);
+    if (err == ESP_OK) {
+        // The request references this stack frame, so wait for it unconditionally
+        xSemaphoreTake(req.done_sem, portMAX_DELAY);
+        err = result;
+    }
+
+    vSemaphoreDelete(req.done_sem);
+    return err;
+}
+
+esp_err_t i2c_arbiter_submit(i2c_arbiter_priority_t prio, uint8_t address,
+                             i2c_arbiter_txn_fn_t fn, void *ctx,
+                             i2c_arbiter_done_cb_t done_cb) {
+    if (fn == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!i2c_arbiter_is_running()) {
+        esp_err_t ret = fn(ctx);
+        if (done_cb != NULL) {
+            done_cb(ret, ctx);
+        }
+        return ESP_OK;
+    }
+
+    i2c_arbiter_request_t req = {
+        .fn = fn,
+        .ctx = ctx,
+        .done_cb = done_cb,
+        .done_sem = NULL,
+        .result = NULL,
+        .address = address,
+        .prio = prio,
+    };
+    return i2c_arbiter_enqueue(i2c_arbiter_bus_of(address), &req);
+}
+
+static esp_err_t i2c_arbiter_session_park(void *ctx) {
+    i2c_arbiter_session_t *session = (i2c_arbiter_session_t *)ctx;
+
+    xSemaphoreGive(session->granted);
+    xSemaphoreTake(session->released, portMAX_DELAY);
+
+    vSemaphoreDelete(session->granted);
+    vSemaphoreDelete(session->released);
+    free(session);
+    return ESP_OK;
+}
+
+/**
+ * @brief Park one bus's arbiter on a new session owned by the caller
+ */
+static esp_err_t i2c_arbiter_acquire_bus(uint8_t bus, i2c_arbiter_priority_t prio, uint8_t address) {
+    i2c_arbiter_session_t *session = calloc(1, sizeof(i2c_arbiter_session_t));
+    if (session == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    session->granted = xSemaphoreCreateBinary();
+    session->released = xSemaphoreCreateBinary();
+    if (session->granted == NULL || session->released == NULL) {
+        if (session->granted != NULL) vSemaphoreDelete(session->granted);
+        if (session->released != NULL) vSemaphoreDelete(session->released);
+        free(session);
+        return ESP_ERR_NO_MEM;
+    }
+
+    i2c_arbiter_request_t req = {
+        .fn = i2c_arbiter_session_park,
+        .ctx = session,
+        .done_cb = NULL,
+        .done_sem = NULL,
+        .result = NULL,
+        .address = address,
+        .prio = prio,
+    };
+    esp_err_t err = i2c_arbiter_enqueue(bus, &req);
+    if (err != ESP_OK) {
+        vSemaphoreDelete(session->granted);
+        vSemaphoreDelete(session->released);
+        free(session);
+        return err;
+    }
+
+    // Once queued the arbiter will park on this session, so the grant must be consumed
+    xSemaphoreTake(session->granted, portMAX_DELAY);
+    s_buses[bus].active_session = session;
+    return ESP_OK;
+}
+
+static void i2c_arbiter_release_bus(uint8_t bus) {
+    i2c_arbiter_session_t *session = s_buses[bus].active_session;
+    s_buses[bus].active_session = NULL;
+    if (session != NULL) {
+        xSemaphoreGive(session->released);
+    }
+}
+
+/**
+ * @brief Count a failed nested begin as a session level
+ *
+ * Callers pair every begin with an end, checked or not; without this the
+ * end of a failed begin would close the enclosing session early.
+ */
+static void i2c_arbiter_nest_failed(TaskHandle_t self) {
+    taskENTER_CRITICAL(&s_owner_lock);
+    i2c_arbiter_owner_t *owner = i2c_arbiter_find_owner(self);
+    if (owner != NULL) {
+        owner->depth++;
+    }
+    taskEXIT_CRITICAL(&s_owner_lock);
+}
+
+/**
+ * @brief Open or extend the caller's session so it holds every bus in mask
+ *
+ * Buses are always acquired in ascending order, so two sessions that both
+ * need several buses cannot wait on each other. A caller that already holds
+ * a bus may only add buses above it: waiting for a lower bus while holding
+ * a higher one inverts the order, so such a begin is refused.
+ */
+static esp_err_t i2c_arbiter_begin_mask(uint8_t mask, i2c_arbiter_priority_t prio, uint8_t address) {
+    if (!i2c_arbiter_is_running()) {
+        return ESP_OK;
+    }
+
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint8_t held = i2c_arbiter_caller_mask();
+    uint8_t need = mask & (uint8_t)~held;
+
+    taskENTER_CRITICAL(&s_owner_lock);
+    bool in_session = (i2c_arbiter_find_owner(self) != NULL);
+    taskEXIT_CRITICAL(&s_owner_lock);
+    if (need == 0 && !in_session) {
+        // An arbiter task inside one of its own transactions
+        return ESP_OK;
+    }
+
+    // held and need are disjoint, so held exceeds the lowest needed bus only if it holds a higher one
+    uint8_t lowest_need = need & (uint8_t)(~need + 1u);
+    if (need != 0 && held > lowest_need) {
+        ESP_LOGE(TAG, "Refusing to extend session on buses 0x%02X to lower buses 0x%02X (0x%02X)",
+                 held, need, address);
+        i2c_arbiter_nest_failed(self);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t acquired = 0;
+    esp_err_t err = ESP_OK;
+    for (uint8_t b = 0; b < s_bus_count && err == ESP_OK; b++) {
+        if (!(need & (1u << b))) {
+            continue;
+        }
+        err = i2c_arbiter_acquire_bus(b, prio, address);
+        if (err == ESP_OK) {
+            acquired |= (uint8_t)(1u << b);
+        }
+    }
+
+    if (err == ESP_OK) {
+        taskENTER_CRITICAL(&s_owner_lock);
+        i2c_arbiter_owner_t *owner = i2c_arbiter_find_owner(self);
+        if (owner == NULL) {
+            // Each new owner holds at least one bus nobody else holds, so a slot should be free
+            owner = i2c_arbiter_find_owner(NULL);
+            if (owner != NULL) {
+                owner->task = self;
+                owner->bus_mask = 0;
+                owner->depth = 0;
+            }
+        }
+        if (owner != NULL) {
+            owner->bus_mask |= acquired;
+            owner->depth++;
+        }
+        taskEXIT_CRITICAL(&s_owner_lock);
+        if (owner == NULL) {
+            ESP_LOGE(TAG, "No free session slot for buses 0x%02X", acquired);
+            err = ESP_ERR_NO_MEM;
+        }
+    }
+
+    if (err != ESP_OK) {
+        for (uint8_t r = 0; r < s_bus_count; r++) {
+            if (acquired & (1u << r)) {
+                i2c_arbiter_release_bus(r);
+            }
+        }
+        i2c_arbiter_nest_failed(self);
+    }
+    return err;
+}
+
+esp_err_t i2c_arbiter_begin(i2c_arbiter_priority_t prio, uint8_t address) {
+    if (!i2c_arbiter_is_running()) {
+        return ESP_OK;
+    }
+    uint8_t mask = (address == I2C_ARBITER_ADDR_ANY) ? (uint8_t)((1u << s_bus_count) - 1)
+                                                     : (uint8_t)(1u << i2c_arbiter_bus_of(address));
+    return i2c_arbiter_begin_mask(mask, prio, address);
+}
+
+esp_err_t i2c_arbiter_begin_bus(uint8_t bus, i2c_arbiter_priority_t prio, uint8_t address) {
+    if (!i2c_arbiter_is_running()) {
+        return ESP_OK;
+    }
+    if (bus >= s_bus_count) {
+        bus = 0;
+    }
+    return i2c_arbiter_begin_mask((uint8_t)(1u << bus), prio, address);
+}
+
+void i2c_arbiter_end(void) {
+    if (!i2c_arbiter_is_running()) {
+        return;
+    }
+
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint8_t release = 0;
+    taskENTER_CRITICAL(&s_owner_lock);
+    i2c_arbiter_owner_t *owner = i2c_arbiter_find_owner(self);
+    if (owner != NULL && --owner->depth == 0) {
+        release = owner->bus_mask;
+        owner->task = NULL;
+        owner->bus_mask = 0;
+    }
+    taskEXIT_CRITICAL(&s_owner_lock);
+
+    for (uint8_t b = 0; b < s_bus_count; b++) {
+        if (release & (1u << b)) {
+            i2c_arbiter_release_bus(b);
+        }
+    }
+}
+
+uint32_t i2c_arbiter_get_epoch(uint8_t address) {
+    return s_epoch[address & 0x7F] + s_epoch[I2C_ARBITER_ADDR_ANY];
+}
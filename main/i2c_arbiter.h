@@ -0,0 +1,156 @@
+/**
+ * @file i2c_arbiter.h
+ * @brief Prioritized I2C bus arbiter
+ *
+ * One arbiter task per I2C bus owns that bus and serves transaction
+ * requests in priority order (interactive > scheduled > maintenance).
+ * Work is either submitted as a transaction callback that runs in the
+ * arbiter task, or run by the caller inside a bus session granted by the
+ * arbiter. Background acquisition and manual actions interleave at
+ * transaction granularity instead of pausing each other.
+ *
+ * Requests are routed by device address: the scanner records which bus
+ * each device answered on, so an address is unique across buses. Traffic
+ * on different buses runs in parallel; I2C_ARBITER_ADDR_ANY sessions hold
+ * every bus.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define I2C_ARBITER_ADDR_ANY    0x00    // Transaction is not tied to one device
+#define I2C_ARBITER_MAX_BUSES   2
+
+/**
+ * @brief Request priority (lower value is served first)
+ */
+typedef enum {
+    I2C_ARBITER_PRIO_INTERACTIVE = 0,   // User-initiated actions (HTTP, WebSocket)
+    I2C_ARBITER_PRIO_SCHEDULED,         // Background acquisition
+    I2C_ARBITER_PRIO_MAINTENANCE,       // Settings refresh, housekeeping
+    I2C_ARBITER_PRIO_COUNT
+} i2c_arbiter_priority_t;
+
+/**
+ * @brief Transaction body, executed with exclusive bus access
+ */
+typedef esp_err_t (*i2c_arbiter_txn_fn_t)(void *ctx);
+
+/**
+ * @brief Completion callback for asynchronous transactions (runs in arbiter task)
+ */
+typedef void (*i2c_arbiter_done_cb_t)(esp_err_t result, void *ctx);
+
+/**
+ * @brief Start one arbiter task per bus
+ *
+ * Until this is called, transactions and sessions run inline in the caller
+ * so early boot code (scanning, sensor init) works unchanged.
+ *
+ * @param bus_count Buses to arbitrate (clamped to 1..I2C_ARBITER_MAX_BUSES)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t i2c_arbiter_init(uint8_t bus_count);
+
+/**
+ * @brief Record the bus a device answered on; requests for it go to that bus
+ *
+ * Unmapped addresses belong to bus 0.
+ */
+void i2c_arbiter_set_device_bus(uint8_t address, uint8_t bus);
+
+/**
+ * @brief Bus a device address is routed to
+ */
+uint8_t i2c_arbiter_get_device_bus(uint8_t address);
+
+/**
+ * @brief Check if the arbiter task is running
+ */
+bool i2c_arbiter_is_running(void);
+
+/**
+ * @brief Run a transaction and wait for its result
+ *
+ * @param prio Request priority
+ * @param address Target device address (I2C_ARBITER_ADDR_ANY if several)
+ * @param fn Transaction body
+ * @param ctx Argument passed to fn
+ * @return esp_err_t Result returned by fn, or an error if the request could not be queued
+ *
+ * An I2C_ARBITER_ADDR_ANY transaction runs in the caller inside a session
+ * that holds every bus.
+ */
+esp_err_t i2c_arbiter_run(i2c_arbiter_priority_t prio, uint8_t address,
+                          i2c_arbiter_txn_fn_t fn, void *ctx);
+
+/**
+ * @brief Queue a transaction without waiting
+ *
+ * @param prio Request priority
+ * @param address Target device address (I2C_ARBITER_ADDR_ANY if several)
+ * @param fn Transaction body
+ * @param ctx Argument passed to fn and done_cb (must outlive the transaction)
+ * @param done_cb Optional completion callback
+ * @return esp_err_t ESP_OK if queued, ESP_ERR_TIMEOUT if the queue is full
+ *
+ * I2C_ARBITER_ADDR_ANY transactions are queued on bus 0.
+ */
+esp_err_t i2c_arbiter_submit(i2c_arbiter_priority_t prio, uint8_t address,
+                             i2c_arbiter_txn_fn_t fn, void *ctx,
+                             i2c_arbiter_done_cb_t done_cb);
+
+/**
+ * @brief Acquire the bus for a sequence of operations issued by the caller
+ *
+ * Blocks until the arbiter grants the device's bus, or every bus for
+ * I2C_ARBITER_ADDR_ANY. Sessions nest: a task that already holds a bus may
+ * call begin/run again without deadlocking. A nested session on a higher
+ * bus adds that bus to the session, and all of them are released by the
+ * outermost i2c_arbiter_end(). A nested session needing a bus below one
+ * already held is refused, since buses are acquired in ascending order.
+ * Call i2c_arbiter_end() after every begin, including a failed one. Keep
+ * sessions short; every other user of the bus waits while one is open.
+ *
+ * @param prio Request priority
+ * @param address Target device address (I2C_ARBITER_ADDR_ANY if several)
+ * @return esp_err_t ESP_OK when the bus is held, ESP_ERR_INVALID_STATE if the
+ *         caller holds a higher bus than one it needs
+ */
+esp_err_t i2c_arbiter_begin(i2c_arbiter_priority_t prio, uint8_t address);
+
+/**
+ * @brief Acquire one bus, whatever bus the address is mapped to
+ *
+ * For probing addresses that are not mapped yet (bus scans).
+ */
+esp_err_t i2c_arbiter_begin_bus(uint8_t bus, i2c_arbiter_priority_t prio, uint8_t address);
+
+/**
+ * @brief Release a session obtained with i2c_arbiter_begin() or i2c_arbiter_begin_bus()
+ */
+void i2c_arbiter_end(void);
+
+/**
+ * @brief Per-device activity counter for non-scheduled work
+ *
+ * Incremented whenever an interactive or maintenance request touches a
+ * device (or the whole bus). Background acquisition compares the value
+ * before and after a conversion to detect that another command reached the
+ * board in between and its pending reading is no longer trustworthy.
+ *
+ * @param address Device address
+ * @return Current counter value
+ */
+uint32_t i2c_arbiter_get_epoch(uint8_t address);
+
+#ifdef __cplusplus
+}
+#endif
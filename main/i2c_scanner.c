@@ -4,133 +4,740 @@
  */
 
 #include "i2c_scanner.h"
+#include "i2c_arbiter.h"
+#ifdef CONFIG_KC_EZO_EMULATOR
+#include "ezo_emulator.h"
+#endif
 #include "esp_log.h"
+#include "trace_log.h"
 #include "driver/i2c_master.h"
+#include "driver/gpio.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "soc/soc_caps.h"
+#include <stdio.h>
 #include <string.h>
+#include <stdatomic.h>
 
 static const char *TAG = "I2C_SCAN";
 
-static i2c_master_bus_handle_t bus_handle = NULL;
+#define I2C_TOPOLOGY_NVS_NAMESPACE  "i2c_topo"
+#define I2C_TOPOLOGY_NVS_KEY        "map"       // Bus 0; bus N uses "mapN"
+#define I2C_SWEEP_TASK_STACK        3072
+#define I2C_SWEEP_TASK_PRIORITY     2
+#define I2C_SWEEP_START_DELAY_MS    5000
+#define I2C_RECOVERY_HALF_PERIOD_US 5       // 100 kHz clock-out
+#define I2C_RECOVERY_STRETCH_US     1000    // Longest a slave may hold SCL low per pulse
+#define I2C_RECOVERY_PULSES         9       // Enough to finish any byte a slave is sending
 
-esp_err_t i2c_scanner_init(void)
+// Device map, one bit per 7-bit address. known marks addresses probed
+// since boot (or the last invalidate); present holds the probe result.
+typedef struct {
+    i2c_master_bus_handle_t handle;
+    atomic_uint known[I2C_TOPOLOGY_WORDS];
+    atomic_uint present[I2C_TOPOLOGY_WORDS];
+} i2c_scanner_bus_t;
+
+// Bus health. The run fields are only touched from inside a session on
+// the bus, which the arbiter serializes.
+typedef struct {
+    uint8_t run;                    // Consecutive timeouts
+    uint8_t run_address;            // Address of the first timeout in the run
+    bool run_multi;                 // Run spans more than one device
+    atomic_bool stalled;
+    uint32_t backoff_ms;
+    int64_t retry_after_us;
+    i2c_bus_health_t stats;
+} i2c_scanner_health_t;
+
+typedef struct {
+    int port;
+    int scl;
+    int sda;
+} i2c_scanner_pins_t;
+
+static const i2c_scanner_pins_t s_pins[I2C_BUS_MAX] = {
+    { I2C_NUM_0, I2C_MASTER_SCL_IO, I2C_MASTER_SDA_IO },
+#if SOC_HP_I2C_NUM > 1
+    { I2C_NUM_1, I2C_BUS1_SCL_IO, I2C_BUS1_SDA_IO },
+#else
+    { -1, -1, -1 },
+#endif
+};
+
+static i2c_scanner_bus_t s_buses[I2C_BUS_MAX];
+static i2c_scanner_health_t s_health[I2C_BUS_MAX];
+static uint8_t s_bus_count = 0;
+static TaskHandle_t s_sweep_task = NULL;
+
+static bool i2c_scanner_bus_has(const i2c_scanner_bus_t *bus, uint8_t address)
 {
-    ESP_LOGI(TAG, "Initializing I2C master bus");
-    ESP_LOGI(TAG, "  SDA: GPIO%d, SCL: GPIO%d", I2C_MASTER_SDA_IO, I2C_MASTER_SCL_IO);
-    
+    uint32_t bit = 1u << (address & 31);
+    uint8_t word = (address & 0x7F) >> 5;
+    return (atomic_load(&bus->known[word]) & atomic_load(&bus->present[word]) & bit) != 0;
+}
+
+/**
+ * @brief Bus that owns an address, or -1 if none has answered for it
+ */
+static int i2c_scanner_owner_bus(uint8_t address)
+{
+    for (uint8_t b = 0; b < s_bus_count; b++) {
+        if (i2c_scanner_bus_has(&s_buses[b], address)) {
+            return b;
+        }
+    }
+    return -1;
+}
+
+static bool i2c_scanner_probe(uint8_t bus_index, uint8_t address)
+{
+    i2c_scanner_bus_t *bus = &s_buses[bus_index];
+    esp_err_t ret = i2c_master_probe(bus->handle, address, I2C_MASTER_TIMEOUT_MS);
+#ifdef CONFIG_KC_EZO_EMULATOR
+    // Emulated boards live on the first bus
+    if (bus_index == 0 && ezo_emulator_present(address)) {
+        ret = ESP_OK;
+    }
+#endif
+    uint32_t bit = 1u << (address & 31);
+    uint8_t word = (address & 0x7F) >> 5;
+
+    if (ret == ESP_OK) {
+        int owner = i2c_scanner_owner_bus(address);
+        if (owner >= 0 && owner < bus_index) {
+            ESP_LOGW(TAG, "Address 0x%02X answers on bus %d and bus %u, using bus %d",
+                     address, owner, bus_index, owner);
+        } else {
+            i2c_arbiter_set_device_bus(address, bus_index);
+        }
+        atomic_fetch_or(&bus->present[word], bit);
+    } else {
+        atomic_fetch_and(&bus->present[word], ~bit);
+    }
+    atomic_fetch_or(&bus->known[word], bit);
+    return (ret == ESP_OK);
+}
+
+static void i2c_scanner_log_device(uint8_t addr)
+{
+    ESP_LOGI(TAG, "✓ Device found at address 0x%02X", addr);
+
+    // Print common device names for known addresses
+    switch (addr) {
+        case 0x1E: ESP_LOGI(TAG, "  → Possible: HMC5883L (Magnetometer)"); break;
+        case 0x20:
+        case 0x21:
+        case 0x22:
+        case 0x23:
+        case 0x24:
+        case 0x25:
+        case 0x26:
+        case 0x27: ESP_LOGI(TAG, "  → Possible: PCF8574 (I/O Expander) or LCD"); break;
+        case 0x38: ESP_LOGI(TAG, "  → Possible: FT6236 (Touch Controller)"); break;
+        case 0x39: ESP_LOGI(TAG, "  → Possible: TSL2561/APDS9960 (Light Sensor)"); break;
+        case 0x3C:
+        case 0x3D: ESP_LOGI(TAG, "  → Possible: SSD1306 (OLED Display)"); break;
+        case 0x40: ESP_LOGI(TAG, "  → Possible: PCA9685/SI7021 (PWM/Humidity)"); break;
+        case 0x48:
+        case 0x49:
+        case 0x4A:
+        case 0x4B: ESP_LOGI(TAG, "  → Possible: ADS1115/PCF8591 (ADC)"); break;
+        case 0x50:
+        case 0x51:
+        case 0x52:
+        case 0x53:
+        case 0x54:
+        case 0x55:
+        case 0x56:
+        case 0x57: ESP_LOGI(TAG, "  → Possible: AT24C (EEPROM)"); break;
+        case 0x68:
+        case 0x69: ESP_LOGI(TAG, "  → Possible: MPU6050/DS3231/DS1307 (IMU/RTC)"); break;
+        case 0x76:
+        case 0x77: ESP_LOGI(TAG, "  → Possible: BME280/BMP280 (Temp/Pressure/Humidity)"); break;
+        default: break;
+    }
+}
+
+static void i2c_scanner_topology_key(uint8_t bus, char *key, size_t size)
+{
+    if (bus == 0) {
+        snprintf(key, size, "%s", I2C_TOPOLOGY_NVS_KEY);
+    } else {
+        snprintf(key, size, "%s%u", I2C_TOPOLOGY_NVS_KEY, bus);
+    }
+}
+
+static esp_err_t i2c_scanner_load_topology(uint8_t bus, uint32_t map[I2C_TOPOLOGY_WORDS])
+{
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    i2c_scanner_topology_key(bus, key, sizeof(key));
+
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(I2C_TOPOLOGY_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    size_t size = sizeof(uint32_t) * I2C_TOPOLOGY_WORDS;
+    ret = nvs_get_blob(handle, key, map, &size);
+    nvs_close(handle);
+    if (ret == ESP_OK && size != sizeof(uint32_t) * I2C_TOPOLOGY_WORDS) {
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    return ret;
+}
+
+static esp_err_t i2c_scanner_save_topology(uint8_t bus, const uint32_t map[I2C_TOPOLOGY_WORDS])
+{
+    uint32_t stored[I2C_TOPOLOGY_WORDS];
+    if (i2c_scanner_load_topology(bus, stored) == ESP_OK &&
+        memcmp(stored, map, sizeof(stored)) == 0) {
+        return ESP_OK;  // Unchanged, spare the flash write
+    }
+
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(I2C_TOPOLOGY_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    i2c_scanner_topology_key(bus, key, sizeof(key));
+    ret = nvs_set_blob(handle, key, map, sizeof(uint32_t) * I2C_TOPOLOGY_WORDS);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to store I2C topology of bus %u: %s", bus, esp_err_to_name(ret));
+    } else {
+        ESP_LOGI(TAG, "I2C topology of bus %u stored", bus);
+    }
+    return ret;
+}
+
+static esp_err_t i2c_scanner_new_bus(uint8_t b)
+{
+    const i2c_scanner_pins_t *pins = &s_pins[b];
     i2c_master_bus_config_t i2c_bus_config = {
         .clk_source = I2C_CLK_SRC_DEFAULT,
-        .i2c_port = I2C_NUM_0,
-        .scl_io_num = I2C_MASTER_SCL_IO,
-        .sda_io_num = I2C_MASTER_SDA_IO,
+        .i2c_port = pins->port,
+        .scl_io_num = pins->scl,
+        .sda_io_num = pins->sda,
         .glitch_ignore_cnt = 7,
         .flags.enable_internal_pullup = true,
     };
-    
-    esp_err_t ret = i2c_new_master_bus(&i2c_bus_config, &bus_handle);
+
+    esp_err_t ret = i2c_new_master_bus(&i2c_bus_config, &s_buses[b].handle);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize I2C master bus: %s", esp_err_to_name(ret));
-        return ret;
+        s_buses[b].handle = NULL;
     }
-    
-    ESP_LOGI(TAG, "✓ I2C master bus initialized successfully");
+    return ret;
+}
+
+esp_err_t i2c_scanner_init(void)
+{
+    if (s_bus_count > 0) {
+        return ESP_OK;
+    }
+
+#ifdef CONFIG_KC_EZO_EMULATOR
+    ezo_emulator_init();
+#endif
+
+    for (uint8_t b = 0; b < I2C_BUS_MAX; b++) {
+        const i2c_scanner_pins_t *pins = &s_pins[b];
+        if (pins->port < 0 || pins->scl < 0 || pins->sda < 0) {
+            break;
+        }
+
+        ESP_LOGI(TAG, "Initializing I2C master bus %u", b);
+        ESP_LOGI(TAG, "  SDA: GPIO%d, SCL: GPIO%d", pins->sda, pins->scl);
+
+        esp_err_t ret = i2c_scanner_new_bus(b);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to initialize I2C master bus %u: %s", b, esp_err_to_name(ret));
+            if (b == 0) {
+                return ret;
+            }
+            break;
+        }
+        s_bus_count = b + 1;
+    }
+
+    ESP_LOGI(TAG, "✓ %u I2C master bus(es) initialized successfully", s_bus_count);
     return ESP_OK;
 }
 
+bool i2c_scanner_find_device(uint8_t address, uint8_t *bus)
+{
+    // Answer from the device maps while every bus already probed this address
+    uint32_t bit = 1u << (address & 31);
+    uint8_t word = (address & 0x7F) >> 5;
+    for (uint8_t b = 0; b < s_bus_count; b++) {
+        i2c_scanner_bus_t *state = &s_buses[b];
+        bool found = (atomic_load(&state->known[word]) & bit) ?
+                     (atomic_load(&state->present[word]) & bit) != 0 :
+                     i2c_scanner_probe(b, address);
+        if (found) {
+            if (bus != NULL) {
+                *bus = b;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
 bool i2c_scanner_device_exists(uint8_t address)
 {
-    if (bus_handle == NULL) {
-        return false;
+    return i2c_scanner_find_device(address, NULL);
+}
+
+esp_err_t i2c_scanner_scan(void)
+{
+    if (s_bus_count == 0) {
+        ESP_LOGE(TAG, "I2C bus not initialized. Call i2c_scanner_init() first");
+        return ESP_ERR_INVALID_STATE;
     }
     
-    // Try to probe the device
-    esp_err_t ret = i2c_master_probe(bus_handle, address, I2C_MASTER_TIMEOUT_MS);
-    return (ret == ESP_OK);
+    for (uint8_t b = 0; b < s_bus_count; b++) {
+        ESP_LOGI(TAG, "========================================");
+        ESP_LOGI(TAG, "Scanning I2C bus %u for devices...", b);
+        ESP_LOGI(TAG, "========================================");
+        
+        uint8_t devices_found = 0;
+        
+        // Scan all valid I2C addresses (0x08 to 0x77). Each probe is its own
+        // maintenance transaction so sensor traffic can run in between.
+        for (uint8_t addr = 0x08; addr <= 0x77; addr++) {
+            i2c_arbiter_begin_bus(b, I2C_ARBITER_PRIO_MAINTENANCE, addr);
+            bool found = i2c_scanner_probe(b, addr);
+            i2c_arbiter_end();
+            
+            if (found) {
+                i2c_scanner_log_device(addr);
+                devices_found++;
+            }
+        }
+        
+        uint32_t map[I2C_TOPOLOGY_WORDS];
+        i2c_scanner_get_bus_topology(b, map);
+        i2c_scanner_save_topology(b, map);
+        
+        ESP_LOGI(TAG, "========================================");
+        if (devices_found == 0) {
+            ESP_LOGW(TAG, "No I2C devices found on bus %u!", b);
+            ESP_LOGW(TAG, "Check wiring and pull-up resistors");
+        } else {
+            ESP_LOGI(TAG, "Scan of bus %u complete: %d device(s) found", b, devices_found);
+        }
+        ESP_LOGI(TAG, "========================================");
+    }
+    
+    return ESP_OK;
 }
 
-esp_err_t i2c_scanner_scan(void)
+esp_err_t i2c_scanner_scan_cached(void)
 {
-    if (bus_handle == NULL) {
+    if (s_bus_count == 0) {
         ESP_LOGE(TAG, "I2C bus not initialized. Call i2c_scanner_init() first");
         return ESP_ERR_INVALID_STATE;
     }
     
-    ESP_LOGI(TAG, "========================================");
-    ESP_LOGI(TAG, "Scanning I2C bus for devices...");
-    ESP_LOGI(TAG, "========================================");
+    // Every bus needs a stored map, or a newly enabled bus would never be scanned
+    uint32_t cached[I2C_BUS_MAX][I2C_TOPOLOGY_WORDS];
+    for (uint8_t b = 0; b < s_bus_count; b++) {
+        esp_err_t ret = i2c_scanner_load_topology(b, cached[b]);
+        if (ret != ESP_OK) {
+            ESP_LOGI(TAG, "No cached I2C topology for bus %u (%s)", b, esp_err_to_name(ret));
+            return ESP_ERR_NOT_FOUND;
+        }
+    }
     
     uint8_t devices_found = 0;
+    uint8_t devices_missing = 0;
+    for (uint8_t b = 0; b < s_bus_count; b++) {
+        for (uint8_t addr = 0x08; addr <= 0x77; addr++) {
+            if (!(cached[b][addr >> 5] & (1u << (addr & 31)))) {
+                continue;
+            }
+            if (i2c_scanner_probe(b, addr)) {
+                i2c_scanner_log_device(addr);
+                devices_found++;
+            } else {
+                ESP_LOGW(TAG, "Cached device at 0x%02X on bus %u not responding", addr, b);
+                devices_missing++;
+            }
+        }
+    }
+    
+    ESP_LOGI(TAG, "Cached topology: %d device(s) confirmed, %d missing",
+             devices_found, devices_missing);
+    return ESP_OK;
+}
+
+static void i2c_scanner_sweep_task(void *arg)
+{
+    // Let sensor init and the first acquisition cycle get ahead of the sweep
+    vTaskDelay(pdMS_TO_TICKS(I2C_SWEEP_START_DELAY_MS));
     
-    // Scan all valid I2C addresses (0x08 to 0x77)
-    for (uint8_t addr = 0x08; addr <= 0x77; addr++) {
-        esp_err_t ret = i2c_master_probe(bus_handle, addr, I2C_MASTER_TIMEOUT_MS);
+    uint8_t new_devices = 0;
+    for (uint8_t b = 0; b < s_bus_count; b++) {
+        uint32_t before[I2C_TOPOLOGY_WORDS];
+        i2c_scanner_get_bus_topology(b, before);
         
-        if (ret == ESP_OK) {
-            ESP_LOGI(TAG, "✓ Device found at address 0x%02X", addr);
-            devices_found++;
-            
-            // Print common device names for known addresses
-            switch (addr) {
-                case 0x1E: ESP_LOGI(TAG, "  → Possible: HMC5883L (Magnetometer)"); break;
-                case 0x20:
-                case 0x21:
-                case 0x22:
-                case 0x23:
-                case 0x24:
-                case 0x25:
-                case 0x26:
-                case 0x27: ESP_LOGI(TAG, "  → Possible: PCF8574 (I/O Expander) or LCD"); break;
-                case 0x38: ESP_LOGI(TAG, "  → Possible: FT6236 (Touch Controller)"); break;
-                case 0x39: ESP_LOGI(TAG, "  → Possible: TSL2561/APDS9960 (Light Sensor)"); break;
-                case 0x3C:
-                case 0x3D: ESP_LOGI(TAG, "  → Possible: SSD1306 (OLED Display)"); break;
-                case 0x40: ESP_LOGI(TAG, "  → Possible: PCA9685/SI7021 (PWM/Humidity)"); break;
-                case 0x48:
-                case 0x49:
-                case 0x4A:
-                case 0x4B: ESP_LOGI(TAG, "  → Possible: ADS1115/PCF8591 (ADC)"); break;
-                case 0x50:
-                case 0x51:
-                case 0x52:
-                case 0x53:
-                case 0x54:
-                case 0x55:
-                case 0x56:
-                case 0x57: ESP_LOGI(TAG, "  → Possible: AT24C (EEPROM)"); break;
-                case 0x68:
-                case 0x69: ESP_LOGI(TAG, "  → Possible: MPU6050/DS3231/DS1307 (IMU/RTC)"); break;
-                case 0x76:
-                case 0x77: ESP_LOGI(TAG, "  → Possible: BME280/BMP280 (Temp/Pressure/Humidity)"); break;
-                default: break;
+        // Only probe addresses not confirmed yet; re-probing live sensors mid
+        // conversion would just mark their pending readings stale
+        for (uint8_t addr = 0x08; addr <= 0x77; addr++) {
+            if (before[addr >> 5] & (1u << (addr & 31))) {
+                continue;
+            }
+            if (i2c_scanner_probe_address(b, addr)) {
+                ESP_LOGI(TAG, "Background sweep: new device at 0x%02X on bus %u (rescan sensors to use it)",
+                         addr, b);
+                new_devices++;
             }
         }
+        
+        uint32_t map[I2C_TOPOLOGY_WORDS];
+        i2c_scanner_get_bus_topology(b, map);
+        i2c_scanner_save_topology(b, map);
     }
+    ESP_LOGI(TAG, "Background sweep complete: %d new device(s)", new_devices);
     
-    ESP_LOGI(TAG, "========================================");
-    if (devices_found == 0) {
-        ESP_LOGW(TAG, "No I2C devices found!");
-        ESP_LOGW(TAG, "Check wiring and pull-up resistors");
-    } else {
-        ESP_LOGI(TAG, "Scan complete: %d device(s) found", devices_found);
+    s_sweep_task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t i2c_scanner_start_background_sweep(void)
+{
+    if (s_bus_count == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_sweep_task != NULL) {
+        return ESP_OK;
     }
-    ESP_LOGI(TAG, "========================================");
     
+    BaseType_t ret = xTaskCreate(i2c_scanner_sweep_task, "i2c_sweep", I2C_SWEEP_TASK_STACK, NULL,
+                                 I2C_SWEEP_TASK_PRIORITY, &s_sweep_task);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create background sweep task");
+        s_sweep_task = NULL;
+        return ESP_FAIL;
+    }
     return ESP_OK;
 }
 
+bool i2c_scanner_probe_address(uint8_t bus, uint8_t address)
+{
+    if (bus >= s_bus_count) {
+        return false;
+    }
+    i2c_arbiter_begin_bus(bus, I2C_ARBITER_PRIO_MAINTENANCE, address);
+    bool found = i2c_scanner_probe(bus, address);
+    i2c_arbiter_end();
+    return found;
+}
+
+void i2c_scanner_get_bus_topology(uint8_t bus, uint32_t map[I2C_TOPOLOGY_WORDS])
+{
+    for (int i = 0; i < I2C_TOPOLOGY_WORDS; i++) {
+        map[i] = (bus < s_bus_count) ?
+                 atomic_load(&s_buses[bus].present[i]) & atomic_load(&s_buses[bus].known[i]) : 0;
+    }
+}
+
+void i2c_scanner_get_topology(uint32_t map[I2C_TOPOLOGY_WORDS])
+{
+    memset(map, 0, sizeof(uint32_t) * I2C_TOPOLOGY_WORDS);
+    for (uint8_t b = 0; b < s_bus_count; b++) {
+        uint32_t bus_map[I2C_TOPOLOGY_WORDS];
+        i2c_scanner_get_bus_topology(b, bus_map);
+        for (int i = 0; i < I2C_TOPOLOGY_WORDS; i++) {
+            map[i] |= bus_map[i];
+        }
+    }
+}
+
+uint8_t i2c_scanner_get_bus_count(void)
+{
+    return s_bus_count;
+}
+
+void i2c_scanner_invalidate(void)
+{
+    for (uint8_t b = 0; b < I2C_BUS_MAX; b++) {
+        for (int i = 0; i < I2C_TOPOLOGY_WORDS; i++) {
+            atomic_store(&s_buses[b].known[i], 0);
+            atomic_store(&s_buses[b].present[i], 0);
+        }
+    }
+}
+
 esp_err_t i2c_scanner_deinit(void)
 {
-    if (bus_handle != NULL) {
-        esp_err_t ret = i2c_del_master_bus(bus_handle);
-        if (ret == ESP_OK) {
-            bus_handle = NULL;
-            ESP_LOGI(TAG, "I2C master bus deinitialized");
+    esp_err_t result = ESP_OK;
+    for (int b = s_bus_count - 1; b >= 0; b--) {
+        // A failed recovery leaves no controller to delete
+        esp_err_t ret = (s_buses[b].handle != NULL) ? i2c_del_master_bus(s_buses[b].handle) : ESP_OK;
+        if (ret != ESP_OK) {
+            result = ret;
+            break;
+        }
+        s_buses[b].handle = NULL;
+        s_bus_count = b;
+        ESP_LOGI(TAG, "I2C master bus %d deinitialized", b);
+    }
+    if (s_bus_count == 0) {
+        i2c_scanner_invalidate();
+    }
+    return result;
+}
+
+i2c_master_bus_handle_t i2c_scanner_get_bus_handle(void)
+{
+    return i2c_scanner_get_bus(0);
+}
+
+i2c_master_bus_handle_t i2c_scanner_get_bus(uint8_t bus)
+{
+    return (bus < s_bus_count) ? s_buses[bus].handle : NULL;
+}
+
+void i2c_scanner_note_result(uint8_t address, esp_err_t result)
+{
+    uint8_t bus = i2c_arbiter_get_device_bus(address);
+    if (bus >= s_bus_count) {
+        return;
+    }
+    i2c_scanner_health_t *health = &s_health[bus];
+
+    if (result != ESP_ERR_TIMEOUT) {
+        health->run = 0;
+        return;
+    }
+
+    health->stats.timeouts++;
+    if (health->run == 0) {
+        health->run_address = address;
+        health->run_multi = false;
+    } else if (address != health->run_address) {
+        health->run_multi = true;
+    }
+    if (health->run < UINT8_MAX) {
+        health->run++;
+    }
+
+    // One device timing out may just be that device misbehaving; demand
+    // twice the evidence before blaming the bus
+    uint8_t limit = health->run_multi ? I2C_STALL_TIMEOUTS : 2 * I2C_STALL_TIMEOUTS;
+    if (health->run >= limit && !atomic_load(&health->stalled)) {
+        atomic_store(&health->stalled, true);
+        health->stats.stalls++;
+        health->retry_after_us = 0;
+        ESP_LOGW(TAG, "Bus %u stalled: %u consecutive timeouts (last from 0x%02X)",
+                 bus, health->run, address);
+    }
+}
+
+bool i2c_scanner_bus_stalled(uint8_t bus)
+{
+    return (bus < s_bus_count) && atomic_load(&s_health[bus].stalled);
+}
+
+bool i2c_scanner_recovery_due(uint8_t bus)
+{
+    return i2c_scanner_bus_stalled(bus) && esp_timer_get_time() >= s_health[bus].retry_after_us;
+}
+
+// Double the wait before the next attempt, up to I2C_RECOVERY_BACKOFF_MAX_MS
+static void i2c_scanner_backoff(i2c_scanner_health_t *health)
+{
+    health->backoff_ms = (health->backoff_ms == 0) ? I2C_RECOVERY_BACKOFF_MS : health->backoff_ms * 2;
+    if (health->backoff_ms > I2C_RECOVERY_BACKOFF_MAX_MS) {
+        health->backoff_ms = I2C_RECOVERY_BACKOFF_MAX_MS;
+    }
+    health->retry_after_us = esp_timer_get_time() + (int64_t)health->backoff_ms * 1000;
+}
+
+void i2c_scanner_defer_recovery(uint8_t bus)
+{
+    if (bus >= s_bus_count) {
+        return;
+    }
+    i2c_scanner_backoff(&s_health[bus]);
+    ESP_LOGW(TAG, "Bus %u recovery skipped, retrying in %lu ms", bus, (unsigned long)s_health[bus].backoff_ms);
+}
+
+/**
+ * @brief Drive the bus lines by hand until a slave holding SDA lets go
+ *
+ * A slave reset mid-transfer (or a master reset mid-read) can be left
+ * waiting to clock out the rest of a byte with SDA low. Up to nine clock
+ * pulses finish that byte; the STOP that follows returns it to idle.
+ *
+ * @return true if SDA and SCL are both high afterwards
+ */
+static bool i2c_scanner_clock_out(const i2c_scanner_pins_t *pins)
+{
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << pins->scl) | (1ULL << pins->sda),
+        .mode = GPIO_MODE_INPUT_OUTPUT_OD,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&io_conf);
+    gpio_set_level(pins->sda, 1);
+    gpio_set_level(pins->scl, 1);
+    esp_rom_delay_us(I2C_RECOVERY_HALF_PERIOD_US);
+
+    for (int i = 0; i < I2C_RECOVERY_PULSES && gpio_get_level(pins->sda) == 0; i++) {
+        gpio_set_level(pins->scl, 0);
+        esp_rom_delay_us(I2C_RECOVERY_HALF_PERIOD_US);
+        gpio_set_level(pins->scl, 1);
+        // The slave may stretch the clock
+        for (int waited = 0; gpio_get_level(pins->scl) == 0 && waited < I2C_RECOVERY_STRETCH_US; waited++) {
+            esp_rom_delay_us(1);
         }
+        esp_rom_delay_us(I2C_RECOVERY_HALF_PERIOD_US);
+    }
+
+    // STOP: SDA rises while SCL is high
+    gpio_set_level(pins->scl, 0);
+    esp_rom_delay_us(I2C_RECOVERY_HALF_PERIOD_US);
+    gpio_set_level(pins->sda, 0);
+    esp_rom_delay_us(I2C_RECOVERY_HALF_PERIOD_US);
+    gpio_set_level(pins->scl, 1);
+    esp_rom_delay_us(I2C_RECOVERY_HALF_PERIOD_US);
+    gpio_set_level(pins->sda, 1);
+    esp_rom_delay_us(I2C_RECOVERY_HALF_PERIOD_US);
+
+    bool released = gpio_get_level(pins->sda) == 1 && gpio_get_level(pins->scl) == 1;
+    gpio_reset_pin(pins->scl);
+    gpio_reset_pin(pins->sda);
+    return released;
+}
+
+esp_err_t i2c_scanner_recover_bus(uint8_t bus)
+{
+    if (bus >= s_bus_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    i2c_scanner_bus_t *state = &s_buses[bus];
+    i2c_scanner_health_t *health = &s_health[bus];
+    int64_t start = esp_timer_get_time();
+
+    uint32_t expected[I2C_TOPOLOGY_WORDS];
+    i2c_scanner_get_bus_topology(bus, expected);
+
+    ESP_LOGW(TAG, "Recovering I2C bus %u", bus);
+    esp_err_t ret = i2c_arbiter_begin_bus(bus, I2C_ARBITER_PRIO_INTERACTIVE, I2C_ARBITER_ADDR_ANY);
+    if (ret != ESP_OK) {
+        // Sessions may still be using the bus; deleting it now would free their handles
+        ESP_LOGE(TAG, "Cannot take bus %u for recovery: %s", bus, esp_err_to_name(ret));
+        i2c_scanner_defer_recovery(bus);
         return ret;
     }
+
+    if (state->handle != NULL) {
+        ret = i2c_del_master_bus(state->handle);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Cannot delete bus %u (devices still attached?): %s", bus, esp_err_to_name(ret));
+        } else {
+            state->handle = NULL;
+        }
+    }
+
+    bool released = false;
+    uint8_t answered = 0;
+    uint8_t missing = 0;
+    if (ret == ESP_OK) {
+        released = i2c_scanner_clock_out(&s_pins[bus]);
+        ret = i2c_scanner_new_bus(bus);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to recreate I2C master bus %u: %s", bus, esp_err_to_name(ret));
+        }
+    }
+    if (ret == ESP_OK) {
+        for (uint8_t addr = 0x08; addr <= 0x77; addr++) {
+            if (!(expected[addr >> 5] & (1u << (addr & 31)))) {
+                continue;
+            }
+            if (i2c_scanner_probe(bus, addr)) {
+                answered++;
+            } else {
+                ESP_LOGW(TAG, "Device at 0x%02X on bus %u not responding after recovery", addr, bus);
+                missing++;
+            }
+        }
+        if (!released) {
+            ret = ESP_ERR_TIMEOUT;
+        } else if (answered == 0 && missing > 0) {
+            ret = ESP_ERR_NOT_FOUND;
+        }
+    }
+
+    i2c_arbiter_end();
+
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    health->run = 0;
+    health->stats.last_recovery_ms = elapsed_ms;
+    health->stats.last_recovery_us = esp_timer_get_time();
+    health->stats.devices_missing = missing;
+    if (ret == ESP_OK) {
+        health->stats.recoveries++;
+        health->backoff_ms = 0;
+        atomic_store(&health->stalled, false);
+        ESP_LOGI(TAG, "Bus %u recovered in %lu ms: %u device(s) answering, %u missing",
+                 bus, (unsigned long)elapsed_ms, answered, missing);
+    } else {
+        health->stats.failed_recoveries++;
+        i2c_scanner_backoff(health);
+        ESP_LOGE(TAG, "Bus %u recovery failed (%s, lines %s), retrying in %lu ms",
+                 bus, esp_err_to_name(ret), released ? "released" : "held low",
+                 (unsigned long)health->backoff_ms);
+    }
+    trace_log_emit(TRACE_EV_I2C_RECOVERY, bus, (uint32_t)ret, elapsed_ms);
+    return ret;
+}
+
+esp_err_t i2c_scanner_get_health(uint8_t bus, i2c_bus_health_t *health)
+{
+    if (health == NULL || bus >= s_bus_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *health = s_health[bus].stats;
+    health->stalled = atomic_load(&s_health[bus].stalled);
     return ESP_OK;
 }
 
-i2c_master_bus_handle_t i2c_scanner_get_bus_handle(void)
+void i2c_scanner_write_health_json(json_writer_t *w)
 {
-    return bus_handle;
+    json_writer_array_begin(w);
+    for (uint8_t b = 0; b < s_bus_count; b++) {
+        i2c_bus_health_t health;
+        i2c_scanner_get_health(b, &health);
+        json_writer_object_begin(w);
+        json_writer_kv_int(w, "bus", b);
+        json_writer_kv_bool(w, "stalled", health.stalled);
+        json_writer_kv_int(w, "timeouts", health.timeouts);
+        json_writer_kv_int(w, "stalls", health.stalls);
+        json_writer_kv_int(w, "recoveries", health.recoveries);
+        json_writer_kv_int(w, "failed_recoveries", health.failed_recoveries);
+        if (health.last_recovery_us > 0) {
+            json_writer_kv_int(w, "last_recovery_ms", health.last_recovery_ms);
+            json_writer_kv_int(w, "last_recovery_age_s",
+                               (esp_timer_get_time() - health.last_recovery_us) / 1000000);
+            json_writer_kv_int(w, "missing", health.devices_missing);
+        }
+        json_writer_object_end(w);
+    }
+    json_writer_array_end(w);
 }
@@ -1,12 +1,28 @@
 /**
  * @file i2c_scanner.h
  * @brief I2C bus scanner for detecting connected devices
+ *
+ * Up to I2C_BUS_MAX buses are brought up. Bus 0 is the STEMMA QT connector;
+ * bus 1 is enabled by setting its pins, on targets with a second I2C port.
+ * Each bus keeps its own device map. An address found on one bus is not
+ * used on another: the first bus to answer owns it, and the arbiter routes
+ * the address's transactions to that bus.
+ *
+ * A health monitor watches the transfer results drivers report through
+ * i2c_scanner_note_result(). I2C_STALL_TIMEOUTS timeouts in a row, from more
+ * than one device (or twice as many from one), mark the bus stalled: a board
+ * holding SDA low or a wedged controller. i2c_scanner_recover_bus() then
+ * clocks SCL until SDA is released, sends a STOP, recreates the controller
+ * and re-probes the devices the bus had, without a reboot.
  */
 
 #pragma once
 
+#include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
 #include "driver/i2c_master.h"
+#include "json_writer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,8 +34,36 @@ extern "C" {
 #define I2C_MASTER_FREQ_HZ          100000  /*!< I2C master clock frequency */
 #define I2C_MASTER_TIMEOUT_MS       1000    /*!< I2C timeout */
 
+// Second bus, disabled while its pins are -1
+#define I2C_BUS1_SCL_IO             -1      /*!< GPIO number for bus 1 clock */
+#define I2C_BUS1_SDA_IO             -1      /*!< GPIO number for bus 1 data  */
+
+#define I2C_BUS_MAX                 2       /*!< Buses the scanner can manage */
+
+#define I2C_TOPOLOGY_WORDS          4       /*!< 128-bit device map, one bit per 7-bit address */
+
+#define I2C_STALL_TIMEOUTS          3       /*!< Consecutive timeouts that mark a bus stalled */
+#define I2C_RECOVERY_BACKOFF_MS     1000    /*!< Wait before retrying a failed recovery, doubled each time */
+#define I2C_RECOVERY_BACKOFF_MAX_MS 60000
+
 /**
- * @brief Initialize I2C master bus
+ * @brief Health counters of one bus
+ */
+typedef struct {
+    bool stalled;
+    uint32_t timeouts;              /*!< Timed-out transfers since boot */
+    uint32_t stalls;                /*!< Times the bus was marked stalled */
+    uint32_t recoveries;            /*!< Successful recoveries */
+    uint32_t failed_recoveries;
+    uint32_t last_recovery_ms;      /*!< Duration of the last recovery attempt */
+    int64_t last_recovery_us;       /*!< Uptime when it ended, 0 if none */
+    uint8_t devices_missing;        /*!< Devices that did not answer after the last recovery */
+} i2c_bus_health_t;
+
+/**
+ * @brief Initialize the I2C master buses
+ * 
+ * Bus 0 must come up; a configured bus 1 that fails is logged and left out.
  * 
  * @return esp_err_t ESP_OK on success
  */
@@ -34,6 +78,52 @@ esp_err_t i2c_scanner_init(void);
  */
 esp_err_t i2c_scanner_scan(void);
 
+/**
+ * @brief Probe only the devices recorded in the stored topology
+ * 
+ * Confirms the devices found by the last full scan so sensors can be
+ * started without sweeping the whole address range. Addresses outside the
+ * stored map stay unknown and are probed on demand.
+ * 
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if no topology is stored
+ */
+esp_err_t i2c_scanner_scan_cached(void);
+
+/**
+ * @brief Sweep the remaining addresses in a low-priority background task
+ * 
+ * New devices are logged and added to the stored topology; they are picked
+ * up by the sensor manager on the next rescan.
+ * 
+ * @return esp_err_t ESP_OK if the sweep is running
+ */
+esp_err_t i2c_scanner_start_background_sweep(void);
+
+/**
+ * @brief Get the addresses known to respond, on any bus
+ * 
+ * @param map Output bitmap, bit (addr & 31) of word (addr >> 5)
+ */
+void i2c_scanner_get_topology(uint32_t map[I2C_TOPOLOGY_WORDS]);
+
+/**
+ * @brief Get the addresses known to respond on one bus
+ * 
+ * @param bus Bus index
+ * @param map Output bitmap, cleared for a bus that is not initialized
+ */
+void i2c_scanner_get_bus_topology(uint8_t bus, uint32_t map[I2C_TOPOLOGY_WORDS]);
+
+/**
+ * @brief Number of initialized buses (buses 0..count-1)
+ */
+uint8_t i2c_scanner_get_bus_count(void);
+
+/**
+ * @brief Forget probe results so the next lookups probe the bus again
+ */
+void i2c_scanner_invalidate(void);
+
 /**
  * @brief Deinitialize I2C master bus
  * 
@@ -44,6 +134,8 @@ esp_err_t i2c_scanner_deinit(void);
 /**
  * @brief Check if a device exists at the given I2C address
  * 
+ * Answered from the device map when the address was already probed.
+ * 
  * @param address I2C address to check (7-bit)
  * @return true if device responds
  * @return false if no device at address
@@ -51,12 +143,96 @@ esp_err_t i2c_scanner_deinit(void);
 bool i2c_scanner_device_exists(uint8_t address);
 
 /**
- * @brief Get the I2C bus handle
+ * @brief Find the bus a device answers on
+ * 
+ * @param address I2C address (7-bit)
+ * @param bus Output bus index (may be NULL)
+ * @return true if the device responds on some bus
+ */
+bool i2c_scanner_find_device(uint8_t address, uint8_t *bus);
+
+/**
+ * @brief Probe one address on one bus now and update the device map
+ * 
+ * Runs in its own maintenance session, so acquisition on the bus only
+ * waits for the single probe.
+ * 
+ * @param bus Bus index
+ * @param address I2C address (7-bit)
+ * @return true if the device acknowledged
+ */
+bool i2c_scanner_probe_address(uint8_t bus, uint8_t address);
+
+/**
+ * @brief Report a transfer result to the bus health monitor
+ * 
+ * Called by the drivers from inside their bus session. ESP_ERR_TIMEOUT counts
+ * towards a stall; any other result, a NACK included, shows the bus moving
+ * and resets the count.
+ * 
+ * @param address Device address (7-bit); the bus is the one it is routed to
+ * @param result Result of the i2c_master_* call
+ */
+void i2c_scanner_note_result(uint8_t address, esp_err_t result);
+
+/**
+ * @brief Whether a bus is marked stalled (transfers on it would only time out)
+ */
+bool i2c_scanner_bus_stalled(uint8_t bus);
+
+/**
+ * @brief Whether a stalled bus is due for a recovery attempt (not backing off)
+ */
+bool i2c_scanner_recovery_due(uint8_t bus);
+
+/**
+ * @brief Skip a due recovery attempt and back off as after a failed one
+ *
+ * For callers that could not take the bus for the recovery.
+ */
+void i2c_scanner_defer_recovery(uint8_t bus);
+
+/**
+ * @brief Clock out, reset and recreate a bus, then re-probe its devices
+ * 
+ * Every device handle on the bus must be removed first (the controller
+ * cannot be deleted with devices attached) and added again afterwards to
+ * i2c_scanner_get_bus(bus). Runs in its own interactive session on the bus;
+ * if that session cannot be opened nothing is touched and the attempt is
+ * deferred (i2c_scanner_defer_recovery()).
+ * 
+ * @param bus Bus index
+ * @return esp_err_t ESP_OK if the lines are released and a known device answers,
+ *         the i2c_arbiter_begin_bus() error if the bus could not be taken,
+ *         ESP_ERR_TIMEOUT if SDA or SCL stay low, ESP_ERR_NOT_FOUND if no device answers,
+ *         or the driver error (the bus handle is NULL if it could not be recreated)
+ */
+esp_err_t i2c_scanner_recover_bus(uint8_t bus);
+
+/**
+ * @brief Copy the health counters of a bus
+ */
+esp_err_t i2c_scanner_get_health(uint8_t bus, i2c_bus_health_t *health);
+
+/**
+ * @brief Write the health counters of every bus as a JSON array
+ */
+void i2c_scanner_write_health_json(json_writer_t *w);
+
+/**
+ * @brief Get the I2C bus handle of bus 0
  * 
  * @return i2c_master_bus_handle_t I2C bus handle (NULL if not initialized)
  */
 i2c_master_bus_handle_t i2c_scanner_get_bus_handle(void);
 
+/**
+ * @brief Get the I2C bus handle of a bus
+ * 
+ * @return i2c_master_bus_handle_t I2C bus handle (NULL if not initialized)
+ */
+i2c_master_bus_handle_t i2c_scanner_get_bus(uint8_t bus);
+
 #ifdef __cplusplus
 }
 #endif
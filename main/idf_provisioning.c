@@ -51,7 +51,12 @@ esp_err_t idf_provisioning_start(void) {
     const char *adv_name = idf_provisioning_get_service_name();
     wifi_prov_mgr_config_t prov_cfg = {
         .scheme = wifi_prov_scheme_ble,
+#ifdef CONFIG_KC_BLE_SENSOR_SERVICE
+        // BLE memory stays allocated: the sensor service brings NimBLE back up afterwards
+        .scheme_event_handler = WIFI_PROV_SCHEME_BLE_EVENT_HANDLER_FREE_BT,
+#else
         .scheme_event_handler = WIFI_PROV_SCHEME_BLE_EVENT_HANDLER_FREE_BTDM,
+#endif
         .app_event_handler = WIFI_PROV_EVENT_HANDLER_NONE,
         .wifi_prov_conn_cfg = {
             .wifi_conn_attempts = 3,  // Let prov manager handle WiFi connection (3 attempts)
@@ -0,0 +1,157 @@
+/**
+ * @file json_arena.c
+ * @brief Bump allocator for cJSON documents that live for one request or publish
+ */
+
+#include "json_arena.h"
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "JSON_ARENA";
+
+#define JSON_ARENA_ALIGN 8
+
+struct json_arena {
+    uint8_t *base;
+    size_t used;
+    TaskHandle_t owner;         // Only the owner's allocations land here; NULL while free
+};
+
+static json_arena_t s_arenas[JSON_ARENA_POOL];
+static uint8_t *s_pool = NULL;
+static json_arena_stats_t s_stats;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Arena of the calling task, if any
+ *
+ * Owners are only set and cleared by the owning task itself, so a task
+ * always sees its own entry without taking the lock.
+ */
+static json_arena_t *json_arena_current(void) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < JSON_ARENA_POOL; i++) {
+        if (s_arenas[i].owner == self) {
+            return &s_arenas[i];
+        }
+    }
+    return NULL;
+}
+
+static void *json_arena_malloc(size_t size) {
+    json_arena_t *arena = json_arena_current();
+    if (arena != NULL) {
+        size_t need = (size + JSON_ARENA_ALIGN - 1) & ~(size_t)(JSON_ARENA_ALIGN - 1);
+        if (need <= JSON_ARENA_SIZE - arena->used) {
+            void *ptr = arena->base + arena->used;
+            arena->used += need;
+            return ptr;
+        }
+        s_stats.overflows++;
+    }
+    return malloc(size);
+}
+
+static void json_arena_free(void *ptr) {
+    // Arena memory is reclaimed all at once by json_arena_end()
+    if ((uint8_t *)ptr >= s_pool && (uint8_t *)ptr < s_pool + (size_t)JSON_ARENA_POOL * JSON_ARENA_SIZE) {
+        return;
+    }
+    free(ptr);
+}
+
+esp_err_t json_arena_init(void) {
+    if (s_pool != NULL) {
+        return ESP_OK;
+    }
+
+    // One block for the whole pool, PSRAM when available
+    size_t pool_size = (size_t)JSON_ARENA_POOL * JSON_ARENA_SIZE;
+    s_pool = heap_caps_malloc(pool_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    s_stats.psram = (s_pool != NULL);
+    if (s_pool == NULL) {
+        s_pool = malloc(pool_size);
+    }
+    if (s_pool == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %u byte arena pool, cJSON stays on the heap", (unsigned)pool_size);
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < JSON_ARENA_POOL; i++) {
+        s_arenas[i].base = s_pool + (size_t)i * JSON_ARENA_SIZE;
+    }
+    s_stats.arena_size = JSON_ARENA_SIZE;
+    s_stats.pool_size = JSON_ARENA_POOL;
+
+    // Without realloc cJSON grows print buffers by copying, which the arena absorbs
+    cJSON_Hooks hooks = {
+        .malloc_fn = json_arena_malloc,
+        .free_fn = json_arena_free,
+    };
+    cJSON_InitHooks(&hooks);
+    ESP_LOGI(TAG, "%d x %d byte cJSON arenas in %s", JSON_ARENA_POOL, JSON_ARENA_SIZE,
+             s_stats.psram ? "PSRAM" : "internal RAM");
+    return ESP_OK;
+}
+
+json_arena_t *json_arena_begin(void) {
+    if (s_pool == NULL || json_arena_current() != NULL) {
+        return NULL;
+    }
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    json_arena_t *arena = NULL;
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < JSON_ARENA_POOL; i++) {
+        if (s_arenas[i].owner == NULL) {
+            arena = &s_arenas[i];
+            arena->used = 0;
+            arena->owner = self;
+            break;
+        }
+    }
+    if (arena == NULL) {
+        s_stats.exhausted++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return arena;
+}
+
+void json_arena_end(json_arena_t *arena) {
+    if (arena == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    s_stats.scopes++;
+    s_stats.last_bytes = (uint32_t)arena->used;
+    if (arena->used > s_stats.peak_bytes) {
+        s_stats.peak_bytes = (uint32_t)arena->used;
+    }
+    arena->owner = NULL;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void json_arena_get_stats(json_arena_stats_t *stats) {
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void json_arena_write_json(json_writer_t *w) {
+    json_arena_stats_t stats;
+    json_arena_get_stats(&stats);
+    json_writer_object_begin(w);
+    json_writer_kv_bool(w, "available", s_pool != NULL);
+    json_writer_kv_int(w, "arena_size", stats.arena_size);
+    json_writer_kv_int(w, "pool_size", stats.pool_size);
+    json_writer_kv_bool(w, "psram", stats.psram);
+    json_writer_kv_int(w, "scopes", stats.scopes);
+    json_writer_kv_int(w, "last_bytes", stats.last_bytes);
+    json_writer_kv_int(w, "peak_bytes", stats.peak_bytes);
+    json_writer_kv_int(w, "overflows", stats.overflows);
+    json_writer_kv_int(w, "exhausted", stats.exhausted);
+    json_writer_object_end(w);
+}
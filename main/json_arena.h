@@ -0,0 +1,82 @@
+/**
+ * @file json_arena.h
+ * @brief Bump allocator for cJSON documents that live for one request or publish
+ *
+ * cJSON's hooks are installed once at boot. While a task holds an arena,
+ * its cJSON allocations are carved out of the arena and frees are no-ops;
+ * the whole arena is reclaimed by json_arena_end(). Other tasks, and
+ * allocations that do not fit, use the heap as before. The arenas are one
+ * block allocated at boot (PSRAM when available), so short-lived JSON
+ * trees no longer fragment the heap.
+ *
+ * Nothing cJSON allocated inside a scope may be used after it ends, and
+ * strings printed by cJSON must be released with cJSON_free(), not free().
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef CONFIG_IDF_TARGET_ESP32C6
+#define JSON_ARENA_POOL     2
+#define JSON_ARENA_SIZE     (8 * 1024)
+#else
+#define JSON_ARENA_POOL     3
+#define JSON_ARENA_SIZE     (16 * 1024)
+#endif
+
+typedef struct json_arena json_arena_t;
+
+typedef struct {
+    uint32_t scopes;            // Completed begin/end pairs
+    uint32_t exhausted;         // Scopes that found every arena in use and ran on the heap
+    uint32_t overflows;         // Allocations that did not fit their arena and went to the heap
+    uint32_t last_bytes;        // Bytes the last scope used
+    uint32_t peak_bytes;        // Most bytes one scope used
+    uint32_t arena_size;
+    uint8_t pool_size;
+    bool psram;
+} json_arena_stats_t;
+
+/**
+ * @brief Allocate the arena pool and install the cJSON hooks
+ *
+ * Call before any cJSON use. Without the pool cJSON keeps the heap hooks.
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if the pool could not be allocated
+ */
+esp_err_t json_arena_init(void);
+
+/**
+ * @brief Route the calling task's cJSON allocations to a free arena
+ *
+ * @return The arena, or NULL if the task already holds one (the outer scope
+ *         keeps serving it) or none is free (the heap is used)
+ */
+json_arena_t *json_arena_begin(void);
+
+/**
+ * @brief Record the arena's usage and return it to the pool (NULL is a no-op)
+ */
+void json_arena_end(json_arena_t *arena);
+
+/**
+ * @brief Usage counters since boot, for sizing JSON_ARENA_SIZE and JSON_ARENA_POOL
+ */
+void json_arena_get_stats(json_arena_stats_t *stats);
+
+/**
+ * @brief Write the usage counters as a JSON object
+ */
+void json_arena_write_json(json_writer_t *w);
+
+#ifdef __cplusplus
+}
+#endif
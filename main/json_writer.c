@@ -0,0 +1,269 @@
+/**
+ * @file json_writer.c
+ * @brief Streaming JSON writer without heap allocation
+ */
+
+#include "json_writer.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <inttypes.h>
+
+void json_writer_init(json_writer_t *w, char *buf, size_t size, json_writer_sink_t sink, void *sink_ctx)
+{
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->size = size;
+    w->sink = sink;
+    w->sink_ctx = sink_ctx;
+    if (buf == NULL || size < 2) {
+        w->err = ESP_ERR_INVALID_ARG;
+    }
+}
+
+static void json_writer_flush(json_writer_t *w)
+{
+    if (w->err == ESP_OK && w->len > 0) {
+        w->err = w->sink(w->sink_ctx, w->buf, w->len);
+    }
+    w->len = 0;
+}
+
+static void json_writer_raw(json_writer_t *w, const char *data, size_t len)
+{
+    if (w->err != ESP_OK) {
+        return;
+    }
+
+    // One byte stays reserved for the terminator of sinkless output
+    while (len > 0) {
+        size_t room = w->size - 1 - w->len;
+        if (room == 0) {
+            if (w->sink == NULL) {
+                w->err = ESP_ERR_INVALID_SIZE;
+                return;
+            }
+            json_writer_flush(w);
+            if (w->err != ESP_OK) {
+                return;
+            }
+            continue;
+        }
+        size_t n = len < room ? len : room;
+        memcpy(w->buf + w->len, data, n);
+        w->len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+static void json_writer_value_prefix(json_writer_t *w)
+{
+    if (w->after_key) {
+        w->after_key = false;
+        return;
+    }
+    if (w->has_items[w->depth]) {
+        json_writer_raw(w, ",", 1);
+    }
+    w->has_items[w->depth] = true;
+}
+
+static void json_writer_escaped(json_writer_t *w, const char *value)
+{
+    json_writer_raw(w, "\"", 1);
+
+    const char *run = value;
+    for (const char *p = value; *p != '\0'; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        json_writer_raw(w, run, p - run);
+        char esc[8];
+        switch (c) {
+            case '"':  json_writer_raw(w, "\\\"", 2); break;
+            case '\\': json_writer_raw(w, "\\\\", 2); break;
+            case '\n': json_writer_raw(w, "\\n", 2); break;
+            case '\r': json_writer_raw(w, "\\r", 2); break;
+            case '\t': json_writer_raw(w, "\\t", 2); break;
+            default:
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                json_writer_raw(w, esc, 6);
+                break;
+        }
+        run = p + 1;
+    }
+    json_writer_raw(w, run, strlen(run));
+
+    json_writer_raw(w, "\"", 1);
+}
+
+static void json_writer_open(json_writer_t *w, char c)
+{
+    json_writer_value_prefix(w);
+    json_writer_raw(w, &c, 1);
+    if (w->depth >= JSON_WRITER_MAX_DEPTH) {
+        if (w->err == ESP_OK) {
+            w->err = ESP_ERR_INVALID_STATE;
+        }
+        return;
+    }
+    w->has_items[++w->depth] = false;
+}
+
+static void json_writer_close(json_writer_t *w, char c)
+{
+    if (w->depth == 0) {
+        if (w->err == ESP_OK) {
+            w->err = ESP_ERR_INVALID_STATE;
+        }
+        return;
+    }
+    w->depth--;
+    json_writer_raw(w, &c, 1);
+}
+
+void json_writer_object_begin(json_writer_t *w)
+{
+    json_writer_open(w, '{');
+}
+
+void json_writer_object_end(json_writer_t *w)
+{
+    json_writer_close(w, '}');
+}
+
+void json_writer_array_begin(json_writer_t *w)
+{
+    json_writer_open(w, '[');
+}
+
+void json_writer_array_end(json_writer_t *w)
+{
+    json_writer_close(w, ']');
+}
+
+void json_writer_key(json_writer_t *w, const char *key)
+{
+    json_writer_value_prefix(w);
+    json_writer_escaped(w, key != NULL ? key : "");
+    json_writer_raw(w, ":", 1);
+    w->after_key = true;
+}
+
+void json_writer_string(json_writer_t *w, const char *value)
+{
+    if (value == NULL) {
+        json_writer_null(w);
+        return;
+    }
+    json_writer_value_prefix(w);
+    json_writer_escaped(w, value);
+}
+
+void json_writer_int(json_writer_t *w, int64_t value)
+{
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%" PRId64, value);
+    json_writer_value_prefix(w);
+    json_writer_raw(w, num, n);
+}
+
+void json_writer_bool(json_writer_t *w, bool value)
+{
+    json_writer_value_prefix(w);
+    if (value) {
+        json_writer_raw(w, "true", 4);
+    } else {
+        json_writer_raw(w, "false", 5);
+    }
+}
+
+void json_writer_null(json_writer_t *w)
+{
+    json_writer_value_prefix(w);
+    json_writer_raw(w, "null", 4);
+}
+
+void json_writer_fragment(json_writer_t *w, const char *json)
+{
+    if (json == NULL || json[0] == '\0') {
+        json_writer_null(w);
+        return;
+    }
+    json_writer_value_prefix(w);
+    json_writer_raw(w, json, strlen(json));
+}
+
+static void json_writer_real(json_writer_t *w, double value, int digits)
+{
+    if (isnan(value) || isinf(value)) {
+        json_writer_null(w);
+        return;
+    }
+    // Whole numbers print without an exponent or fraction, as cJSON does
+    if (value == (double)(int64_t)value && fabs(value) < 1e15) {
+        json_writer_int(w, (int64_t)value);
+        return;
+    }
+
+    char num[32];
+    int n = snprintf(num, sizeof(num), "%.*g", digits, value);
+    json_writer_value_prefix(w);
+    json_writer_raw(w, num, n);
+}
+
+void json_writer_number(json_writer_t *w, double value)
+{
+    json_writer_real(w, value, 15);
+}
+
+void json_writer_float(json_writer_t *w, float value)
+{
+    json_writer_real(w, value, 7);
+}
+
+void json_writer_kv_string(json_writer_t *w, const char *key, const char *value)
+{
+    json_writer_key(w, key);
+    json_writer_string(w, value);
+}
+
+void json_writer_kv_int(json_writer_t *w, const char *key, int64_t value)
+{
+    json_writer_key(w, key);
+    json_writer_int(w, value);
+}
+
+void json_writer_kv_bool(json_writer_t *w, const char *key, bool value)
+{
+    json_writer_key(w, key);
+    json_writer_bool(w, value);
+}
+
+void json_writer_kv_number(json_writer_t *w, const char *key, double value)
+{
+    json_writer_key(w, key);
+    json_writer_number(w, value);
+}
+
+void json_writer_kv_float(json_writer_t *w, const char *key, float value)
+{
+    json_writer_key(w, key);
+    json_writer_float(w, value);
+}
+
+esp_err_t json_writer_finish(json_writer_t *w)
+{
+    if (w->err == ESP_OK && w->depth != 0) {
+        w->err = ESP_ERR_INVALID_STATE;
+    }
+    if (w->sink != NULL) {
+        json_writer_flush(w);
+    } else if (w->buf != NULL && w->size > 0) {
+        w->buf[w->len < w->size ? w->len : w->size - 1] = '\0';
+    }
+    return w->err;
+}
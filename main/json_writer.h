@@ -0,0 +1,115 @@
+/**
+ * @file json_writer.h
+ * @brief Streaming JSON writer without heap allocation
+ *
+ * Renders JSON directly into a caller-provided buffer. With a sink the
+ * buffer is only a staging area that is flushed whenever it fills up (e.g.
+ * into httpd_resp_send_chunk), so output size is not bounded by the buffer.
+ * Errors are sticky: once a write fails every later call is a no-op and
+ * json_writer_finish() reports the first error.
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JSON_WRITER_MAX_DEPTH 8
+
+/**
+ * @brief Output sink receiving rendered JSON in pieces
+ */
+typedef esp_err_t (*json_writer_sink_t)(void *ctx, const char *data, size_t len);
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+    json_writer_sink_t sink;
+    void *sink_ctx;
+    esp_err_t err;
+    uint8_t depth;
+    bool has_items[JSON_WRITER_MAX_DEPTH + 1];  // Next value at this depth needs a comma
+    bool after_key;
+} json_writer_t;
+
+/**
+ * @brief Initialize a writer
+ *
+ * @param w Writer
+ * @param buf Output buffer (or staging buffer when sink is set)
+ * @param size Size of buf
+ * @param sink Optional sink; NULL renders the whole document into buf
+ * @param sink_ctx Argument passed to sink
+ */
+void json_writer_init(json_writer_t *w, char *buf, size_t size, json_writer_sink_t sink, void *sink_ctx);
+
+void json_writer_object_begin(json_writer_t *w);
+void json_writer_object_end(json_writer_t *w);
+void json_writer_array_begin(json_writer_t *w);
+void json_writer_array_end(json_writer_t *w);
+
+/**
+ * @brief Write an object key; the next call writes its value
+ */
+void json_writer_key(json_writer_t *w, const char *key);
+
+void json_writer_string(json_writer_t *w, const char *value);
+void json_writer_int(json_writer_t *w, int64_t value);
+void json_writer_bool(json_writer_t *w, bool value);
+void json_writer_null(json_writer_t *w);
+
+/**
+ * @brief Write an already rendered JSON value as is
+ *
+ * For documents produced elsewhere (e.g. a finished job's result); the
+ * caller vouches that json is valid.
+ */
+void json_writer_fragment(json_writer_t *w, const char *json);
+
+/**
+ * @brief Write a double (15 significant digits, NaN/Inf as null)
+ */
+void json_writer_number(json_writer_t *w, double value);
+
+/**
+ * @brief Write a float (7 significant digits, NaN/Inf as null)
+ */
+void json_writer_float(json_writer_t *w, float value);
+
+// Key/value shorthands
+void json_writer_kv_string(json_writer_t *w, const char *key, const char *value);
+void json_writer_kv_int(json_writer_t *w, const char *key, int64_t value);
+void json_writer_kv_bool(json_writer_t *w, const char *key, bool value);
+void json_writer_kv_number(json_writer_t *w, const char *key, double value);
+void json_writer_kv_float(json_writer_t *w, const char *key, float value);
+
+/**
+ * @brief Flush pending output to the sink, or NUL-terminate the buffer
+ *
+ * @param w Writer
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_SIZE if the document
+ *         did not fit a sinkless buffer, or the first sink error
+ */
+esp_err_t json_writer_finish(json_writer_t *w);
+
+/**
+ * @brief Rendered length (sinkless writers)
+ */
+static inline size_t json_writer_length(const json_writer_t *w)
+{
+    return w->len;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,391 @@
+/**
+ * @file lan_poll.c
+ * @brief Signed UDP read endpoint for local controllers
+ */
+
+#include "lan_poll.h"
+#include "api_key_manager.h"
+#include "sensor_manager.h"
+#include "telemetry_codec.h"
+#include "task_profile.h"
+#include "time_sync.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "LAN_POLL";
+
+#ifndef CONFIG_KC_LAN_POLL_OBSERVE_SEC
+#define CONFIG_KC_LAN_POLL_OBSERVE_SEC 120
+#endif
+
+#define LAN_POLL_HEADER_LEN     12      // Magic, version, op, seq, time
+#define LAN_POLL_KEY_SLOTS      8       // Keys whose last sequence number is remembered
+#define LAN_POLL_SELECT_MS      200     // Latency of pushing a new cache to observers
+#define LAN_POLL_MAX_DATAGRAM   (LAN_POLL_HEADER_LEN + 2 + TELEMETRY_PACKED_MAX_SIZE + LAN_POLL_MAC_LEN)
+
+typedef struct {
+    bool active;
+    struct sockaddr_in addr;
+    char key[API_KEY_NAME_MAX_LENGTH];
+    uint32_t seq;               // Of the OBSERVE request, echoed in every notification
+    int64_t expires_us;
+} lan_poll_observer_t;
+
+typedef struct {
+    char key[API_KEY_NAME_MAX_LENGTH];
+    uint32_t last_seq;
+} lan_poll_key_seq_t;
+
+typedef struct {
+    uint32_t requests;          // Authenticated requests answered
+    uint32_t dropped;           // Malformed, unauthenticated or replayed
+    uint32_t notifications;
+    uint32_t send_failures;
+} lan_poll_stats_t;
+
+// Only the endpoint task touches these, apart from s_cache_seq and the stats copy
+static int s_sock = -1;
+static TaskHandle_t s_task = NULL;
+static uint16_t s_port = 0;
+static lan_poll_observer_t s_observers[LAN_POLL_MAX_OBSERVERS];
+static lan_poll_key_seq_t s_key_seqs[LAN_POLL_KEY_SLOTS];
+static uint8_t s_key_seq_next = 0;
+static sensor_cache_t s_cache;
+static uint8_t s_tx[LAN_POLL_MAX_DATAGRAM];
+static uint8_t s_rx[128];
+static atomic_uint s_cache_seq = 0;     // Bumped by the reading task on every new cache
+static lan_poll_stats_t s_stats;
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint32_t lan_poll_unix_time(void) {
+    return time_sync_is_synced() ? (uint32_t)time(NULL) : 0;
+}
+
+/**
+ * @brief Truncated HMAC under a key a local controller may hold
+ */
+static esp_err_t lan_poll_mac(const char *key, const uint8_t *data, size_t len, uint8_t mac[LAN_POLL_MAC_LEN]) {
+    uint8_t full[API_KEY_HMAC_LEN];
+    esp_err_t err = api_key_manager_hmac(key, API_KEY_TYPE_LOCAL_DASHBOARD, data, len, full);
+    if (err == ESP_ERR_NOT_FOUND) {
+        err = api_key_manager_hmac(key, API_KEY_TYPE_CUSTOM, data, len, full);
+    }
+    if (err == ESP_OK) {
+        memcpy(mac, full, LAN_POLL_MAC_LEN);
+    }
+    return err;
+}
+
+static bool lan_poll_mac_equal(const uint8_t *a, const uint8_t *b) {
+    // Constant time: every byte is compared whatever the first mismatch
+    uint8_t diff = 0;
+    for (size_t i = 0; i < LAN_POLL_MAC_LEN; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+/**
+ * @brief Accept a sequence number only if above the last one seen for the key
+ *
+ * The table forgets the least recently added key when full, and everything
+ * at restart. Once the device clock is set, the time check bounds replays in
+ * both cases; before that, a request recorded earlier is accepted again after
+ * a restart.
+ */
+static bool lan_poll_accept_seq(const char *key, uint32_t seq) {
+    for (int i = 0; i < LAN_POLL_KEY_SLOTS; i++) {
+        if (strcmp(s_key_seqs[i].key, key) == 0) {
+            if (seq <= s_key_seqs[i].last_seq) {
+                return false;
+            }
+            s_key_seqs[i].last_seq = seq;
+            return true;
+        }
+    }
+    lan_poll_key_seq_t *slot = &s_key_seqs[s_key_seq_next];
+    s_key_seq_next = (s_key_seq_next + 1) % LAN_POLL_KEY_SLOTS;
+    snprintf(slot->key, sizeof(slot->key), "%s", key);
+    slot->last_seq = seq;
+    return true;
+}
+
+/**
+ * @brief Build and send one signed response
+ */
+static void lan_poll_send(const struct sockaddr_in *to, const char *key, uint8_t op, uint32_t seq,
+                          const uint8_t *payload, size_t payload_len) {
+    uint8_t *p = s_tx;
+    p[0] = 'K';
+    p[1] = 'C';
+    p[2] = LAN_POLL_VERSION;
+    p[3] = op | LAN_POLL_OP_RESPONSE;
+    put_u32(p + 4, seq);
+    put_u32(p + 8, lan_poll_unix_time());
+    p[12] = (uint8_t)(payload_len >> 8);
+    p[13] = (uint8_t)payload_len;
+    size_t len = LAN_POLL_HEADER_LEN + 2;
+    if (payload != NULL && payload != p + len) {
+        memcpy(p + len, payload, payload_len);
+    }
+    len += payload_len;
+    if (lan_poll_mac(key, p, len, p + len) != ESP_OK) {
+        // The key was removed or disabled since the request
+        s_stats.send_failures++;
+        return;
+    }
+    len += LAN_POLL_MAC_LEN;
+
+    if (sendto(s_sock, p, len, 0, (const struct sockaddr *)to, sizeof(*to)) < 0) {
+        s_stats.send_failures++;
+    }
+}
+
+static void lan_poll_send_error(const struct sockaddr_in *to, const char *key, uint32_t seq, lan_poll_error_t code) {
+    uint8_t payload = (uint8_t)code;
+    lan_poll_send(to, key, LAN_POLL_OP_ERROR, seq, &payload, 1);
+}
+
+/**
+ * @brief Send the current cache, packed straight into the transmit buffer
+ */
+static void lan_poll_send_snapshot(const struct sockaddr_in *to, const char *key, uint8_t op, uint32_t seq) {
+    if (sensor_manager_get_cached_data(&s_cache) != ESP_OK) {
+        lan_poll_send_error(to, key, seq, LAN_POLL_ERR_NO_DATA);
+        return;
+    }
+    uint8_t *payload = s_tx + LAN_POLL_HEADER_LEN + 2;
+    size_t payload_len = 0;
+    if (telemetry_pack_snapshot(&s_cache, lan_poll_unix_time(), payload, TELEMETRY_PACKED_MAX_SIZE,
+                                &payload_len) != ESP_OK) {
+        lan_poll_send_error(to, key, seq, LAN_POLL_ERR_NO_DATA);
+        return;
+    }
+    lan_poll_send(to, key, op, seq, payload, payload_len);
+}
+
+static lan_poll_observer_t *lan_poll_find_observer(const struct sockaddr_in *from) {
+    for (int i = 0; i < LAN_POLL_MAX_OBSERVERS; i++) {
+        lan_poll_observer_t *o = &s_observers[i];
+        if (o->active && o->addr.sin_addr.s_addr == from->sin_addr.s_addr && o->addr.sin_port == from->sin_port) {
+            return o;
+        }
+    }
+    return NULL;
+}
+
+static void lan_poll_observe(const struct sockaddr_in *from, const char *key, uint32_t seq) {
+    lan_poll_observer_t *o = lan_poll_find_observer(from);
+    for (int i = 0; o == NULL && i < LAN_POLL_MAX_OBSERVERS; i++) {
+        if (!s_observers[i].active) {
+            o = &s_observers[i];
+        }
+    }
+    if (o == NULL) {
+        lan_poll_send_error(from, key, seq, LAN_POLL_ERR_BUSY);
+        return;
+    }
+    o->active = true;
+    o->addr = *from;
+    snprintf(o->key, sizeof(o->key), "%s", key);
+    o->seq = seq;
+    o->expires_us = esp_timer_get_time() + (int64_t)CONFIG_KC_LAN_POLL_OBSERVE_SEC * 1000000;
+    lan_poll_send_snapshot(from, key, LAN_POLL_OP_OBSERVE, seq);
+}
+
+/**
+ * @brief Authenticate and answer one datagram
+ */
+static void lan_poll_handle(const uint8_t *buf, size_t len, const struct sockaddr_in *from) {
+    if (len < LAN_POLL_HEADER_LEN + 1 + LAN_POLL_MAC_LEN || buf[0] != 'K' || buf[1] != 'C' ||
+        buf[2] != LAN_POLL_VERSION) {
+        s_stats.dropped++;
+        return;
+    }
+    uint8_t name_len = buf[LAN_POLL_HEADER_LEN];
+    size_t signed_len = LAN_POLL_HEADER_LEN + 1 + name_len;
+    if (name_len == 0 || name_len >= API_KEY_NAME_MAX_LENGTH || len != signed_len + LAN_POLL_MAC_LEN) {
+        s_stats.dropped++;
+        return;
+    }
+    char key[API_KEY_NAME_MAX_LENGTH];
+    memcpy(key, buf + LAN_POLL_HEADER_LEN + 1, name_len);
+    key[name_len] = '\0';
+
+    uint8_t mac[LAN_POLL_MAC_LEN];
+    if (lan_poll_mac(key, buf, signed_len, mac) != ESP_OK || !lan_poll_mac_equal(mac, buf + signed_len)) {
+        s_stats.dropped++;
+        return;
+    }
+
+    uint8_t op = buf[3];
+    if (op != LAN_POLL_OP_GET && op != LAN_POLL_OP_OBSERVE && op != LAN_POLL_OP_CANCEL) {
+        s_stats.dropped++;
+        return;
+    }
+    uint32_t seq = get_u32(buf + 4);
+    uint32_t client_time = get_u32(buf + 8);
+    uint32_t now = lan_poll_unix_time();
+    if (now != 0) {
+        // A request without a time would escape the replay bound; only an unset device clock excuses it
+        uint32_t skew = (client_time > now) ? client_time - now : now - client_time;
+        if (client_time == 0 || skew > LAN_POLL_MAX_SKEW_SEC) {
+            s_stats.dropped++;
+            return;
+        }
+    }
+    if (!lan_poll_accept_seq(key, seq)) {
+        s_stats.dropped++;
+        return;
+    }
+
+    s_stats.requests++;
+    switch (op) {
+        case LAN_POLL_OP_GET:
+            lan_poll_send_snapshot(from, key, LAN_POLL_OP_GET, seq);
+            break;
+        case LAN_POLL_OP_OBSERVE:
+            lan_poll_observe(from, key, seq);
+            break;
+        case LAN_POLL_OP_CANCEL: {
+            lan_poll_observer_t *o = lan_poll_find_observer(from);
+            if (o != NULL) {
+                o->active = false;
+            }
+            lan_poll_send(from, key, LAN_POLL_OP_CANCEL, seq, NULL, 0);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Push the new cache to every observer whose lease is still running
+ */
+static void lan_poll_notify(void) {
+    int64_t now_us = esp_timer_get_time();
+    for (int i = 0; i < LAN_POLL_MAX_OBSERVERS; i++) {
+        lan_poll_observer_t *o = &s_observers[i];
+        if (!o->active) {
+            continue;
+        }
+        if (now_us >= o->expires_us) {
+            ESP_LOGD(TAG, "Observer lease of %s ended", o->key);
+            o->active = false;
+            continue;
+        }
+        lan_poll_send_snapshot(&o->addr, o->key, LAN_POLL_OP_OBSERVE, o->seq);
+        s_stats.notifications++;
+    }
+}
+
+static void lan_poll_cache_listener(const sensor_cache_t *cache, void *user_ctx) {
+    (void)cache;
+    (void)user_ctx;
+    atomic_fetch_add(&s_cache_seq, 1);
+}
+
+static void lan_poll_task(void *arg) {
+    (void)arg;
+    unsigned int notified_seq = atomic_load(&s_cache_seq);
+
+    while (1) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(s_sock, &readfds);
+        struct timeval timeout = { .tv_sec = 0, .tv_usec = LAN_POLL_SELECT_MS * 1000 };
+        int ready = select(s_sock + 1, &readfds, NULL, NULL, &timeout);
+
+        if (ready > 0 && FD_ISSET(s_sock, &readfds)) {
+            struct sockaddr_in from;
+            socklen_t from_len = sizeof(from);
+            int len = recvfrom(s_sock, s_rx, sizeof(s_rx), 0, (struct sockaddr *)&from, &from_len);
+            if (len > 0) {
+                lan_poll_handle(s_rx, (size_t)len, &from);
+            }
+        } else if (ready < 0) {
+            ESP_LOGW(TAG, "select failed: errno %d", errno);
+            vTaskDelay(pdMS_TO_TICKS(1000));
+        }
+
+        unsigned int cache_seq = atomic_load(&s_cache_seq);
+        if (cache_seq != notified_seq) {
+            notified_seq = cache_seq;
+            lan_poll_notify();
+        }
+    }
+}
+
+esp_err_t lan_poll_start(uint16_t port) {
+    if (s_task != NULL) {
+        return ESP_OK;
+    }
+
+    s_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s_sock < 0) {
+        ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(s_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(TAG, "Failed to bind UDP port %u: errno %d", port, errno);
+        close(s_sock);
+        s_sock = -1;
+        return ESP_FAIL;
+    }
+
+    esp_err_t err = sensor_manager_register_cache_listener(lan_poll_cache_listener, NULL);
+    if (err != ESP_OK) {
+        close(s_sock);
+        s_sock = -1;
+        return err;
+    }
+    if (task_profile_create(TASK_PROFILE_LAN_POLL, lan_poll_task, NULL, NULL, &s_task) != pdPASS) {
+        sensor_manager_unregister_cache_listener(lan_poll_cache_listener);
+        close(s_sock);
+        s_sock = -1;
+        return ESP_ERR_NO_MEM;
+    }
+    s_port = port;
+    ESP_LOGI(TAG, "LAN poll endpoint on UDP port %u", port);
+    return ESP_OK;
+}
+
+void lan_poll_write_json(json_writer_t *w) {
+    lan_poll_stats_t stats = s_stats;
+    uint8_t observers = 0;
+    for (int i = 0; i < LAN_POLL_MAX_OBSERVERS; i++) {
+        observers += s_observers[i].active ? 1 : 0;
+    }
+
+    json_writer_object_begin(w);
+    json_writer_kv_bool(w, "running", s_task != NULL);
+    json_writer_kv_int(w, "port", s_port);
+    json_writer_kv_int(w, "observers", observers);
+    json_writer_kv_int(w, "requests", stats.requests);
+    json_writer_kv_int(w, "dropped", stats.dropped);
+    json_writer_kv_int(w, "notifications", stats.notifications);
+    json_writer_kv_int(w, "send_failures", stats.send_failures);
+    json_writer_object_end(w);
+}
@@ -0,0 +1,78 @@
+/**
+ * @file lan_poll.h
+ * @brief Signed UDP read endpoint for local controllers
+ *
+ * Local controllers polling every few seconds otherwise pay for a TLS
+ * session and a JSON build on the HTTPS server. This endpoint answers over
+ * UDP with the sensor cache in the packed snapshot encoding
+ * (telemetry_pack_snapshot()), authenticated by an HMAC under a named API key
+ * (local dashboard or custom type).
+ *
+ * Request (all integers big-endian):
+ *   "KC" | version (u8) | op (u8) | seq (u32) | client unix time (u32, 0 if
+ *   unknown; only accepted while the device clock is unset) | key name
+ *   length (u8) | key name | HMAC-SHA256 of everything before it, truncated
+ *   to LAN_POLL_MAC_LEN bytes
+ *
+ * Response:
+ *   "KC" | version | op with LAN_POLL_OP_RESPONSE set | seq of the request |
+ *   device unix time | payload length (u16) | payload | truncated HMAC under
+ *   the same key
+ *
+ * GET returns the snapshot once. OBSERVE returns it and then pushes every
+ * new cache to the sender for CONFIG_KC_LAN_POLL_OBSERVE_SEC; the
+ * controller renews by observing again, CANCEL ends it. Requests with a bad
+ * MAC, an unknown key, a sequence number not above the last one seen for the
+ * key, or (once the device clock is set) a missing time or one more than
+ * LAN_POLL_MAX_SKEW_SEC off are dropped without an answer, so the endpoint
+ * cannot be used to reflect traffic at a spoofed address.
+ *
+ * Advertised over mDNS as _kc-poll._udp.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LAN_POLL_VERSION        1
+#define LAN_POLL_MAC_LEN        16
+#define LAN_POLL_MAX_OBSERVERS  4
+#define LAN_POLL_MAX_SKEW_SEC   60
+
+typedef enum {
+    LAN_POLL_OP_GET = 1,
+    LAN_POLL_OP_OBSERVE = 2,
+    LAN_POLL_OP_CANCEL = 3,
+    LAN_POLL_OP_ERROR = 0x7F,       // Response only; payload is one lan_poll_error_t byte
+} lan_poll_op_t;
+
+#define LAN_POLL_OP_RESPONSE    0x80
+
+typedef enum {
+    LAN_POLL_ERR_NO_DATA = 1,       // No sensor cache yet
+    LAN_POLL_ERR_BUSY = 2,          // Every observer slot is taken
+} lan_poll_error_t;
+
+/**
+ * @brief Bind the socket and start the endpoint task (idempotent)
+ *
+ * @param port UDP port
+ * @return esp_err_t ESP_OK on success, ESP_FAIL if the socket cannot be bound
+ */
+esp_err_t lan_poll_start(uint16_t port);
+
+/**
+ * @brief Write request and notification counters as a JSON object
+ */
+void lan_poll_write_json(json_writer_t *w);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
@@ -14,9 +15,25 @@
 #include "http_server.h"
 #include "api_key_manager.h"
 #include "mdns_service.h"
+#include "lan_poll.h"
+#include "ble_sensor_service.h"
 #include "mqtt_telemetry.h"
+#include "telemetry_publisher.h"
+#include "thread_telemetry.h"
 #include "i2c_scanner.h"
+#include "i2c_arbiter.h"
 #include "sensor_manager.h"
+#include "sensor_history.h"
+#include "alarm_rules.h"
+#include "power_manager.h"
+#include "perf_monitor.h"
+#include "mem_monitor.h"
+#include "startup_orchestrator.h"
+#include "boot_profile.h"
+#include "settings_store.h"
+#include "trace_log.h"
+#include "json_arena.h"
+#include "data_bench.h"
 
 static const char *TAG = "MAIN";
 
@@ -26,12 +43,17 @@ static void reset_button_handler(reset_button_event_t event, uint32_t press_dura
 static void time_sync_handler(bool synced, struct tm *current_time);
 static void cloud_prov_handler(bool success, const char *message);
 static void start_cloud_services(void);
+static esp_err_t start_mqtt_telemetry(void);
+static esp_err_t start_thread_telemetry(void);
+static esp_err_t start_low_power_uplink(void);
 
 /**
  * @brief Main application entry point
  */
 void app_main(void)
 {
+    boot_profile_mark(BOOT_MARK_APP_MAIN);
+    
     ESP_LOGI(TAG, "=================================" );
     ESP_LOGI(TAG, "KC-Device WiFi Provisioning");
     ESP_LOGI(TAG, "=================================" );
@@ -44,12 +66,25 @@ void app_main(void)
     // Log chip information
     chip_info_log();
     
+    // Hot-path trace rings; prints the tail of the last trace after a crash
+    trace_log_init();
+    
+    // Before any cJSON use: request and publish documents come from a fixed arena pool
+    json_arena_init();
+    
     // Initialize security features (NVS encryption with eFuse protection)
     esp_err_t ret = security_init();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Security initialization failed: %s", esp_err_to_name(ret));
         ESP_LOGE(TAG, "Device will continue but credentials may not be secure!");
     }
+    boot_profile_mark(BOOT_MARK_SECURITY);
+    
+    // Runtime settings, loaded once from NVS for every module below
+    ret = settings_store_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize settings store: %s", esp_err_to_name(ret));
+    }
     
     // Initialize reset button (GPIO0 - BOOT button)
     ret = reset_button_init(RESET_BUTTON_GPIO, reset_button_handler);
@@ -63,6 +98,25 @@ void app_main(void)
     // Register state change callback
     provisioning_state_register_callback(state_change_handler);
     
+    // Battery nodes in low-power mode: a timer wake samples, maybe uploads, and sleeps again
+    power_manager_init();
+    if (power_manager_is_duty_wake()) {
+        power_manager_set_uplink(start_low_power_uplink);
+        power_manager_run_wake();
+    }
+    
+    // CPU and stack profile for /api/perf and the health report
+    perf_monitor_init();
+    
+    // Heap fragmentation and per-subsystem allocation counts
+    mem_monitor_init();
+    
+    // Startup timing of this and recent boots (duty wakes above are not recorded)
+    boot_profile_init();
+    
+    // Data-path benchmark baseline for /api/perf/bench
+    data_bench_init();
+    
     bool connected = false;
     bool cloud_started = false;
     char stored_ssid[33] = {0};
@@ -147,125 +201,334 @@ void app_main(void)
             ESP_LOGW(TAG, "WiFi connection lost, attempting to reconnect to %s", stored_reconnect_ssid);
             wifi_manager_connect(stored_reconnect_ssid, stored_reconnect_password);
         }
+        
+        // Low-power mode: after the power-on window, hand over to duty-cycled deep sleep
+        if (power_manager_should_sleep()) {
+            ESP_LOGI(TAG, "Entering low-power duty cycle");
+            power_manager_enter_sleep();
+        }
 
         vTaskDelay(pdMS_TO_TICKS(10000));
     }
 }
 
 /**
- * @brief Start cloud services (consolidated from duplicate code paths)
- * This includes: time sync, cloud provisioning, HTTPS server, I2C/sensors, and MQTT
+ * @brief Start NTP and give it up to 10 s (HTTPS certificate validation needs the time)
+ *
+ * No wait after a warm reset or deep sleep: the RTC-retained clock is restored at once.
  */
-static void start_cloud_services(void)
+static esp_err_t stage_time_sync(void)
 {
-    esp_err_t ret;
-    
-    // Initialize NTP time synchronization
     ESP_LOGI(TAG, "Initializing NTP time synchronization...");
-    ret = time_sync_init(NULL, time_sync_handler); // NULL = UTC timezone
+    esp_err_t ret = time_sync_init(NULL, time_sync_handler); // NULL = UTC timezone
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize time sync: %s", esp_err_to_name(ret));
     }
     
-    // Wait for time sync (required for HTTPS certificate validation)
-    ESP_LOGI(TAG, "Waiting for time synchronization...");
     int sync_wait = 0;
-    while (!time_sync_is_synced() && sync_wait < 10) {
-        vTaskDelay(pdMS_TO_TICKS(1000));
+    while (!time_sync_is_synced() && sync_wait < 100) {
+        vTaskDelay(pdMS_TO_TICKS(100));
         sync_wait++;
     }
-    
-    // Initialize API key manager
-    ESP_LOGI(TAG, "Initializing API key manager...");
-    api_key_manager_init();
-    
-    // Initialize cloud provisioning
-    ESP_LOGI(TAG, "Initializing cloud provisioning...");
+    // Not fatal: provisioning gets its chance either way, as before
+    return ESP_OK;
+}
+
+static esp_err_t stage_api_keys(void)
+{
+    return api_key_manager_init();
+}
+
+static esp_err_t stage_cloud_provisioning(void)
+{
     cloud_prov_init(cloud_prov_handler);
-    
-    // Start automatic provisioning (get certificates)
-    ESP_LOGI(TAG, "Starting cloud provisioning...");
-    ret = cloud_prov_provision_device();
+    esp_err_t ret = cloud_prov_provision_device();
     if (ret == ESP_OK) {
-        // Download MQTT CA certificate for MQTTS
-        ESP_LOGI(TAG, "Downloading MQTT CA certificate...");
-        ret = cloud_prov_download_mqtt_ca_cert();
-        if (ret != ESP_OK) {
-            ESP_LOGW(TAG, "Failed to download MQTT CA certificate: %s", esp_err_to_name(ret));
-        }
-        
+        boot_profile_mark(BOOT_MARK_PROVISIONED);
+    }
+    return ret;
+}
+
+static esp_err_t stage_mqtt_ca(void)
+{
+    esp_err_t ret = cloud_prov_download_mqtt_ca_cert();
+    if (ret != ESP_OK) {
+        // MQTT still starts, without broker verification
+        ESP_LOGW(TAG, "Failed to download MQTT CA certificate: %s", esp_err_to_name(ret));
+    }
+    return ESP_OK;
+}
+
 #ifndef CONFIG_IDF_TARGET_ESP32C6
-        // ESP32-S3: Full local dashboard support
-        // Initialize mDNS for local network discovery
-        ESP_LOGI(TAG, "Initializing mDNS service...");
-        ret = mdns_service_init("kc", "KannaCloud Device");
-        if (ret == ESP_OK) {
-            mdns_service_add_https(443);
+static esp_err_t stage_mdns(void)
+{
+    // Local network discovery; failure only means the device is reachable by IP alone
+    esp_err_t ret = mdns_service_init("kc", "KannaCloud Device");
+    if (ret == ESP_OK) {
+        mdns_service_add_https(443);
+    } else {
+        ESP_LOGW(TAG, "mDNS initialization failed, device accessible by IP only");
+    }
+    return ESP_OK;
+}
+
+static esp_err_t stage_https_server(void)
+{
+    esp_err_t ret = http_server_start();
+    if (ret == ESP_OK) {
+        boot_profile_mark(BOOT_MARK_HTTPS_UP);
+        ESP_LOGI(TAG, "✓ HTTPS dashboard is ready!");
+        ESP_LOGI(TAG, "✓ Access at: https://kc.local");
+    } else {
+        ESP_LOGE(TAG, "Failed to start HTTPS server: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+#endif
+
+/**
+ * @brief Scan the I2C bus, bring up the sensors and start the reading task
+ *
+ * Needs neither the network nor the time, so it runs alongside provisioning.
+ */
+static esp_err_t stage_sensors(void)
+{
+    ESP_LOGI(TAG, "Initializing I2C scanner...");
+    esp_err_t ret = i2c_scanner_init();
+    bool sweep_pending = false;
+    if (ret == ESP_OK) {
+        // Start from the stored topology; the full sweep runs later in the background
+        if (i2c_scanner_scan_cached() == ESP_OK) {
+            sweep_pending = true;
         } else {
-            ESP_LOGW(TAG, "mDNS initialization failed, device accessible by IP only");
+            i2c_scanner_scan();
         }
+        boot_profile_mark(BOOT_MARK_I2C_SCANNED);
         
-        // Start HTTPS server with downloaded certificates
-        ESP_LOGI(TAG, "Starting HTTPS dashboard server...");
-        ret = http_server_start();
+        // Initialize sensor manager for real sensor data
+        ESP_LOGI(TAG, "Initializing sensor manager...");
+        ret = sensor_manager_init();
         if (ret == ESP_OK) {
-            ESP_LOGI(TAG, "✓ HTTPS dashboard is ready!");
-            ESP_LOGI(TAG, "✓ Access at: https://kc.local");
+            ESP_LOGI(TAG, "✓ Sensors initialized: Battery=%s, EZO sensors=%d",
+                     sensor_manager_has_battery_monitor() ? "YES" : "NO",
+                     sensor_manager_get_ezo_count());
+            
+            // Record history of published readings (PSRAM only)
+            sensor_history_init();
+
+            // Local alarms, published as they trip rather than with telemetry
+            alarm_rules_init();
         } else {
-            ESP_LOGE(TAG, "Failed to start HTTPS server: %s", esp_err_to_name(ret));
+            ESP_LOGW(TAG, "Failed to initialize sensors: %s", esp_err_to_name(ret));
         }
+    } else {
+        ESP_LOGW(TAG, "Failed to initialize I2C: %s", esp_err_to_name(ret));
+    }
+    
+    // From here on all bus traffic goes through the arbiter task
+    ret = i2c_arbiter_init(i2c_scanner_get_bus_count());
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to start I2C arbiter, bus access stays inline: %s", esp_err_to_name(ret));
+    }
+    if (sweep_pending) {
+        i2c_scanner_start_background_sweep();
+    }
+    
+    // Start sensor reading task (10 second interval)
+    ESP_LOGI(TAG, "Starting sensor reading task...");
+    ret = sensor_manager_start_reading_task(10);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to start sensor reading task: %s", esp_err_to_name(ret));
+    }
+    boot_profile_mark(BOOT_MARK_SENSORS_READY);
+    // MQTT publishes whatever sensors came up, including none
+    return ESP_OK;
+}
+
+static esp_err_t stage_mqtt(void)
+{
+    if (telemetry_publisher_transport() == TELEMETRY_TRANSPORT_THREAD) {
+        return start_thread_telemetry();
+    }
+    return start_mqtt_telemetry();
+}
+
+#ifdef CONFIG_KC_BLE_SENSOR_SERVICE
+static esp_err_t stage_ble_sensors(void)
+{
+    // Local reads for technicians' phones; the device works the same without them
+    esp_err_t ret = ble_sensor_service_start();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "BLE sensor service not started: %s", esp_err_to_name(ret));
+    }
+    return ESP_OK;
+}
+#endif
+
+#ifdef CONFIG_KC_LAN_POLL
+static esp_err_t stage_lan_poll(void)
+{
+    // Local controllers poll here instead of the HTTPS server
+    esp_err_t ret = lan_poll_start(CONFIG_KC_LAN_POLL_PORT);
+    if (ret == ESP_OK) {
+        mdns_service_add_lan_poll(CONFIG_KC_LAN_POLL_PORT);
+    } else {
+        ESP_LOGW(TAG, "LAN poll endpoint not started: %s", esp_err_to_name(ret));
+    }
+    return ESP_OK;
+}
+#endif
+
+enum {
+    STAGE_TIME_SYNC,
+    STAGE_API_KEYS,
+    STAGE_CLOUD_PROV,
+    STAGE_MQTT_CA,
+#ifndef CONFIG_IDF_TARGET_ESP32C6
+    STAGE_MDNS,
+    STAGE_HTTPS,
+#endif
+    STAGE_SENSORS,
+    STAGE_MQTT,
+#ifdef CONFIG_KC_LAN_POLL
+    STAGE_LAN_POLL,
+#endif
+#ifdef CONFIG_KC_BLE_SENSOR_SERVICE
+    STAGE_BLE_SENSORS,
+#endif
+    STAGE_COUNT
+};
+
+// Wi-Fi is already up when this runs; each stage lists only what it really needs
+static const startup_stage_t s_cloud_stages[STAGE_COUNT] = {
+    [STAGE_TIME_SYNC]  = { "time_sync",  stage_time_sync,          0,                              0 },
+    [STAGE_API_KEYS]   = { "api_keys",   stage_api_keys,           0,                              0 },
+    [STAGE_CLOUD_PROV] = { "cloud_prov", stage_cloud_provisioning, STARTUP_DEP(STAGE_TIME_SYNC),   8192 },
+    [STAGE_MQTT_CA]    = { "mqtt_ca",    stage_mqtt_ca,            STARTUP_DEP(STAGE_CLOUD_PROV),  8192 },
+#ifndef CONFIG_IDF_TARGET_ESP32C6
+    [STAGE_MDNS]       = { "mdns",       stage_mdns,               0,                              0 },
+    [STAGE_HTTPS]      = { "https",      stage_https_server,       STARTUP_DEP(STAGE_CLOUD_PROV) |
+                                                                   STARTUP_DEP(STAGE_API_KEYS),    6144 },
+#endif
+    [STAGE_SENSORS]    = { "sensors",    stage_sensors,            0,                              0 },
+    [STAGE_MQTT]       = { "mqtt",       stage_mqtt,               STARTUP_DEP(STAGE_MQTT_CA) |
+                                                                   STARTUP_DEP(STAGE_SENSORS),     6144 },
+#ifdef CONFIG_KC_LAN_POLL
+#ifndef CONFIG_IDF_TARGET_ESP32C6
+    [STAGE_LAN_POLL]   = { "lan_poll",   stage_lan_poll,           STARTUP_DEP(STAGE_API_KEYS) |
+                                                                   STARTUP_DEP(STAGE_SENSORS) |
+                                                                   STARTUP_DEP(STAGE_MDNS),        0 },
 #else
-        // ESP32-C6: Cloud-only mode (no local dashboard)
-        ESP_LOGI(TAG, "Running in cloud-only mode (ESP32-C6 - no local dashboard)");
+    [STAGE_LAN_POLL]   = { "lan_poll",   stage_lan_poll,           STARTUP_DEP(STAGE_API_KEYS) |
+                                                                   STARTUP_DEP(STAGE_SENSORS),     0 },
 #endif
-        
-        // Initialize and scan I2C bus for sensors
-        ESP_LOGI(TAG, "Initializing I2C scanner...");
-        ret = i2c_scanner_init();
-        if (ret == ESP_OK) {
-            i2c_scanner_scan();
-            
-            // Initialize sensor manager for real sensor data
-            ESP_LOGI(TAG, "Initializing sensor manager...");
-            ret = sensor_manager_init();
-            if (ret == ESP_OK) {
-                ESP_LOGI(TAG, "✓ Sensors initialized: Battery=%s, EZO sensors=%d",
-                         sensor_manager_has_battery_monitor() ? "YES" : "NO",
-                         sensor_manager_get_ezo_count());
-            } else {
-                ESP_LOGW(TAG, "Failed to initialize sensors: %s", esp_err_to_name(ret));
-            }
-        } else {
-            ESP_LOGW(TAG, "Failed to initialize I2C: %s", esp_err_to_name(ret));
-        }
-        
-        // Start sensor reading task (10 second interval)
-        ESP_LOGI(TAG, "Starting sensor reading task...");
-        ret = sensor_manager_start_reading_task(10);
-        if (ret != ESP_OK) {
-            ESP_LOGW(TAG, "Failed to start sensor reading task: %s", esp_err_to_name(ret));
-        }
-        
-        // Initialize and start MQTT client for KannaCloud telemetry
-        ESP_LOGI(TAG, "Initializing MQTT client...");
-        const char *mqtt_broker = "mqtts://mqtt.kannacloud.com:8883";
-        const char *mqtt_username = "sensor01";
-        const char *mqtt_password = "xkKKYQWxiT83Ni3";
-        ret = mqtt_client_init(mqtt_broker, mqtt_username, mqtt_password);
+#endif
+#ifdef CONFIG_KC_BLE_SENSOR_SERVICE
+    [STAGE_BLE_SENSORS] = { "ble_sensors", stage_ble_sensors,      STARTUP_DEP(STAGE_SENSORS),     0 },
+#endif
+};
+
+/**
+ * @brief Start cloud services (consolidated from duplicate code paths)
+ * This includes: time sync, cloud provisioning, HTTPS server, I2C/sensors, and MQTT.
+ * Independent chains run concurrently; see s_cloud_stages for the ordering.
+ */
+static void start_cloud_services(void)
+{
+#ifdef CONFIG_IDF_TARGET_ESP32C6
+    // ESP32-C6: Cloud-only mode (no local dashboard)
+    ESP_LOGI(TAG, "Running in cloud-only mode (ESP32-C6 - no local dashboard)");
+#endif
+    
+    startup_orchestrator_run(s_cloud_stages, STAGE_COUNT);
+    if (startup_orchestrator_stage_result(STAGE_CLOUD_PROV) != ESP_OK) {
+        ESP_LOGW(TAG, "Cloud provisioning failed, dashboard not available");
+    }
+}
+
+/**
+ * @brief Initialize and start the MQTT client for KannaCloud telemetry
+ */
+static esp_err_t start_mqtt_telemetry(void)
+{
+    ESP_LOGI(TAG, "Initializing MQTT client...");
+    const char *mqtt_broker = "mqtts://mqtt.kannacloud.com:8883";
+    const char *mqtt_username = "sensor01";
+    const char *mqtt_password = "xkKKYQWxiT83Ni3";
+    esp_err_t ret = mqtt_client_init(mqtt_broker, mqtt_username, mqtt_password);
+    if (ret == ESP_OK) {
+        ret = mqtt_client_start();
         if (ret == ESP_OK) {
-            ret = mqtt_client_start();
-            if (ret == ESP_OK) {
-                ESP_LOGI(TAG, "✓ MQTT telemetry enabled");
-                // MQTT interval already loaded from NVS in mqtt_client_init()
-            } else {
-                ESP_LOGW(TAG, "Failed to start MQTT client: %s", esp_err_to_name(ret));
-            }
+            ESP_LOGI(TAG, "✓ MQTT telemetry enabled");
+            // MQTT interval already loaded from NVS in mqtt_client_init()
         } else {
-            ESP_LOGW(TAG, "Failed to initialize MQTT client: %s", esp_err_to_name(ret));
+            ESP_LOGW(TAG, "Failed to start MQTT client: %s", esp_err_to_name(ret));
         }
     } else {
-        ESP_LOGW(TAG, "Cloud provisioning failed, dashboard not available");
+        ESP_LOGW(TAG, "Failed to initialize MQTT client: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief Start Thread telemetry, or MQTT for this boot if the Thread stack cannot come up
+ *
+ * A parent that is not found yet is not a failure: the stack keeps trying
+ * and publishing starts on attach.
+ */
+static esp_err_t start_thread_telemetry(void)
+{
+    ESP_LOGI(TAG, "Starting Thread telemetry...");
+    esp_err_t ret = thread_telemetry_start();
+    if (ret == ESP_OK || ret == ESP_ERR_TIMEOUT) {
+        ESP_LOGI(TAG, "✓ Thread telemetry enabled%s", ret == ESP_OK ? "" : " (not attached yet)");
+        return ESP_OK;
+    }
+    ESP_LOGW(TAG, "Thread telemetry failed (%s), using MQTT for this boot", esp_err_to_name(ret));
+    return start_mqtt_telemetry();
+}
+
+/**
+ * @brief Network bring-up for low-power upload wakes
+ *
+ * Only Wi-Fi and MQTT, or only Thread: certificates are already in NVS from the cold
+ * boot, and the dashboard, mDNS and provisioning round trips would dominate the awake time.
+ */
+static esp_err_t start_low_power_uplink(void)
+{
+    char ssid[33] = {0};
+    char password[64] = {0};
+    
+    // Thread needs no Wi-Fi; the RTC clock carries the sample times between cold boots
+    if (telemetry_publisher_transport() == TELEMETRY_TRANSPORT_THREAD) {
+        esp_err_t ret = thread_telemetry_start();
+        return (ret == ESP_ERR_TIMEOUT) ? ESP_OK : ret;
     }
+    
+    esp_err_t ret = wifi_manager_init();
+    if (ret == ESP_OK) {
+        ret = wifi_manager_get_stored_credentials(ssid, password);
+    }
+    if (ret == ESP_OK) {
+        ret = wifi_manager_connect(ssid, password);
+    }
+    memset(password, 0, sizeof(password));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    int wait_ms = 0;
+    while (!wifi_manager_is_connected() && wait_ms < 15000) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+        wait_ms += 100;
+    }
+    if (!wifi_manager_is_connected()) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    // Keeps the RTC clock honest; sample times come from it between uploads
+    time_sync_init(NULL, NULL);
+    return start_mqtt_telemetry();
 }
 
 /**
@@ -146,6 +146,59 @@ esp_err_t max17048_read_version(max17048_t *device, uint16_t *version) {
     return max17048_read_reg(device, MAX17048_REG_VERSION, version);
 }
 
+/**
+ * @brief Configure the ALRT pin sources
+ */
+esp_err_t max17048_configure_alerts(max17048_t *device, uint8_t low_soc_percent, bool soc_change) {
+    if (device == NULL || low_soc_percent < 1 || low_soc_percent > 32) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint16_t config = 0;
+    esp_err_t ret = max17048_read_reg(device, MAX17048_REG_CONFIG, &config);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    config &= ~(MAX17048_CONFIG_ALSC | MAX17048_CONFIG_ALRT | MAX17048_CONFIG_ATHD_MASK);
+    config |= (uint16_t)(32 - low_soc_percent) & MAX17048_CONFIG_ATHD_MASK;
+    if (soc_change) {
+        config |= MAX17048_CONFIG_ALSC;
+    }
+    ret = max17048_write_reg(device, MAX17048_REG_CONFIG, config);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Alerts: SOC below %u%%%s", low_soc_percent, soc_change ? ", every 1%% change" : "");
+    }
+    return ret;
+}
+
+/**
+ * @brief Read the alert flags and release the ALRT pin
+ */
+esp_err_t max17048_clear_alerts(max17048_t *device, uint16_t *status) {
+    if (device == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint16_t flags = 0;
+    esp_err_t ret = max17048_read_reg(device, MAX17048_REG_STATUS, &flags);
+    if (ret == ESP_OK && (flags & MAX17048_STATUS_ALERTS) != 0) {
+        ret = max17048_write_reg(device, MAX17048_REG_STATUS, flags & ~MAX17048_STATUS_ALERTS);
+    }
+
+    uint16_t config = 0;
+    if (ret == ESP_OK) {
+        ret = max17048_read_reg(device, MAX17048_REG_CONFIG, &config);
+    }
+    if (ret == ESP_OK && (config & MAX17048_CONFIG_ALRT) != 0) {
+        ret = max17048_write_reg(device, MAX17048_REG_CONFIG, config & ~MAX17048_CONFIG_ALRT);
+    }
+
+    if (ret == ESP_OK && status != NULL) {
+        *status = flags & MAX17048_STATUS_ALERTS;
+    }
+    return ret;
+}
+
 /**
  * @brief Reset the MAX17048 chip
  */
@@ -23,8 +23,24 @@ extern "C" {
 #define MAX17048_REG_MODE       0x06    // Mode register
 #define MAX17048_REG_VERSION    0x08    // Chip version
 #define MAX17048_REG_CONFIG     0x0C    // Configuration
+#define MAX17048_REG_STATUS     0x1A    // Alert status
 #define MAX17048_REG_COMMAND    0xFE    // Command register
 
+// CONFIG register bits (low byte; the high byte is RCOMP)
+#define MAX17048_CONFIG_ALSC        0x0040  // Alert on every 1% SOC change
+#define MAX17048_CONFIG_ALRT        0x0020  // Alert asserted; cleared to release the ALRT pin
+#define MAX17048_CONFIG_ATHD_MASK   0x001F  // Low-SOC alert at (32 - ATHD)%
+
+// STATUS register bits
+#define MAX17048_STATUS_RI          0x0100  // Reset indicator
+#define MAX17048_STATUS_VH          0x0200  // Cell voltage high
+#define MAX17048_STATUS_VL          0x0400  // Cell voltage low
+#define MAX17048_STATUS_VR          0x0800  // Voltage reset
+#define MAX17048_STATUS_HD          0x1000  // SOC below the ATHD threshold
+#define MAX17048_STATUS_SC          0x2000  // SOC changed by 1%
+#define MAX17048_STATUS_ALERTS      (MAX17048_STATUS_VH | MAX17048_STATUS_VL | MAX17048_STATUS_VR | \
+                                     MAX17048_STATUS_HD | MAX17048_STATUS_SC)
+
 // Commands
 #define MAX17048_CMD_RESET      0x5400  // Power-on reset
 
@@ -80,6 +96,25 @@ esp_err_t max17048_read_soc(max17048_t *device, float *soc);
  */
 esp_err_t max17048_read_version(max17048_t *device, uint16_t *version);
 
+/**
+ * @brief Configure the ALRT pin sources
+ * 
+ * @param device Pointer to MAX17048 handle
+ * @param low_soc_percent Low-SOC alert threshold (1-32%)
+ * @param soc_change Also alert on every 1% change of the state of charge
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a threshold out of range
+ */
+esp_err_t max17048_configure_alerts(max17048_t *device, uint8_t low_soc_percent, bool soc_change);
+
+/**
+ * @brief Read the alert flags and release the ALRT pin
+ * 
+ * @param device Pointer to MAX17048 handle
+ * @param status Alert flags that were set (MAX17048_STATUS_*), may be NULL
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t max17048_clear_alerts(max17048_t *device, uint16_t *status);
+
 /**
  * @brief Reset the MAX17048 chip
  * 
@@ -74,6 +74,19 @@ esp_err_t mdns_service_add_https(uint16_t port)
     return ESP_OK;
 }
 
+esp_err_t mdns_service_add_lan_poll(uint16_t port)
+{
+    // Protocol version, so controllers can tell which framing to speak
+    mdns_txt_item_t txt[] = {
+        { "version", "1" },
+    };
+    esp_err_t err = mdns_service_add(NULL, "_kc-poll", "_udp", port, txt, sizeof(txt) / sizeof(txt[0]));
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to add LAN poll service: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
 void mdns_service_deinit(void)
 {
     ESP_LOGI(TAG, "Stopping mDNS service");
@@ -94,6 +107,11 @@ esp_err_t mdns_service_add_https(uint16_t port)
     return ESP_ERR_NOT_SUPPORTED;
 }
 
+esp_err_t mdns_service_add_lan_poll(uint16_t port)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
 void mdns_service_deinit(void)
 {
     // Nothing to do
@@ -29,6 +29,14 @@ esp_err_t mdns_service_init(const char *hostname, const char *instance_name);
  */
 esp_err_t mdns_service_add_https(uint16_t port);
 
+/**
+ * @brief Advertise the signed UDP read endpoint (lan_poll.h) as _kc-poll._udp
+ * 
+ * @param port UDP port
+ * @return ESP_OK on success
+ */
+esp_err_t mdns_service_add_lan_poll(uint16_t port);
+
 /**
  * @brief Stop mDNS service
  */
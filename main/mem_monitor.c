@@ -0,0 +1,405 @@
+/**
+ * @file mem_monitor.c
+ * @brief Heap usage, fragmentation and per-subsystem allocation telemetry
+ */
+
+#include "mem_monitor.h"
+#include "mqtt_telemetry.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "MEM_MON";
+
+#ifndef CONFIG_KC_MEM_MONITOR_MIN_FREE
+#define CONFIG_KC_MEM_MONITOR_MIN_FREE 24576
+#endif
+#ifndef CONFIG_MBEDTLS_SSL_IN_CONTENT_LEN
+#define CONFIG_MBEDTLS_SSL_IN_CONTENT_LEN 16384
+#endif
+
+#define MEM_MONITOR_TLS_OVERHEAD    512     // Record header, MAC and allocator bookkeeping
+#define MEM_MONITOR_CLEAR_MARGIN    4096    // Hysteresis before a warning clears
+
+static const char *const k_region_names[MEM_REGION_COUNT] = { "internal", "psram" };
+static const uint32_t k_region_caps[MEM_REGION_COUNT] = {
+    MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT,
+    MALLOC_CAP_SPIRAM,
+};
+static const char *const k_subsys_names[MEM_SUBSYS_COUNT] = { "httpd", "mqtt", "sensors", "tls", "other" };
+
+static mem_snapshot_t s_snapshot;           // Guarded by s_mutex
+static mem_snapshot_t s_work;               // Only touched from the esp_timer task
+static uint32_t s_prev_allocs[MEM_SUBSYS_COUNT];
+static uint64_t s_prev_bytes[MEM_SUBSYS_COUNT];
+static SemaphoreHandle_t s_mutex = NULL;
+static esp_timer_handle_t s_timer = NULL;
+static bool s_warning = false;
+
+// Attribution state, written from the heap hooks under s_lock
+typedef struct {
+    TaskHandle_t task;
+    uint8_t subsystem;
+    bool in_tls;                // Inside esp_mbedtls_mem_calloc: count as TLS instead
+    uint32_t allocs;
+} mem_task_t;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static mem_task_t s_tasks[MEM_MONITOR_MAX_TASKS];
+static uint8_t s_task_count = 0;
+static mem_subsys_stats_t s_subsys[MEM_SUBSYS_COUNT];
+static uint32_t s_tls_in_use = 0;
+static uint32_t s_tls_peak = 0;
+
+#ifdef CONFIG_HEAP_USE_HOOKS
+/**
+ * @brief Subsystem of a task, from the names the application and IDF give them
+ */
+static uint8_t IRAM_ATTR mem_monitor_classify(TaskHandle_t task) {
+    const char *name = pcTaskGetName(task);
+    if (name == NULL) {
+        return MEM_SUBSYS_OTHER;
+    }
+    if (strncmp(name, "httpd", 5) == 0) {
+        return MEM_SUBSYS_HTTPD;
+    }
+    if (strncmp(name, "mqtt", 4) == 0) {
+        return MEM_SUBSYS_MQTT;
+    }
+    if (strncmp(name, "sensor", 6) == 0 || strncmp(name, "i2c_arb", 7) == 0) {
+        return MEM_SUBSYS_SENSORS;
+    }
+    return MEM_SUBSYS_OTHER;
+}
+
+/**
+ * @brief Entry of the calling task, created on its first allocation (caller holds s_lock)
+ *
+ * Tasks beyond MEM_MONITOR_MAX_TASKS count as "other" and have no per-task count.
+ */
+static mem_task_t *IRAM_ATTR mem_monitor_task_locked(TaskHandle_t task) {
+    for (uint8_t i = 0; i < s_task_count; i++) {
+        if (s_tasks[i].task == task) {
+            return &s_tasks[i];
+        }
+    }
+    if (s_task_count >= MEM_MONITOR_MAX_TASKS) {
+        return NULL;
+    }
+    mem_task_t *entry = &s_tasks[s_task_count++];
+    entry->task = task;
+    entry->subsystem = mem_monitor_classify(task);
+    entry->in_tls = false;
+    entry->allocs = 0;
+    return entry;
+}
+
+static void IRAM_ATTR mem_monitor_account_locked(uint8_t subsystem, size_t size) {
+    mem_subsys_stats_t *s = &s_subsys[subsystem];
+    s->allocs++;
+    s->bytes += size;
+    if (size > s->largest) {
+        s->largest = (uint32_t)size;
+    }
+}
+
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+    (void)caps;
+    if (ptr == NULL || xPortInIsrContext() || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+        return;
+    }
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL_SAFE(&s_lock);
+    mem_task_t *entry = mem_monitor_task_locked(self);
+    uint8_t subsystem = MEM_SUBSYS_OTHER;
+    if (entry != NULL) {
+        entry->allocs++;
+        subsystem = entry->in_tls ? MEM_SUBSYS_TLS : entry->subsystem;
+    }
+    mem_monitor_account_locked(subsystem, size);
+    portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+void IRAM_ATTR esp_heap_trace_free_hook(void *ptr) {
+    (void)ptr;
+}
+#endif
+
+#ifdef CONFIG_MBEDTLS_CUSTOM_MEM_ALLOC
+/**
+ * @brief mbedTLS allocator: internal RAM, as CONFIG_MBEDTLS_INTERNAL_MEM_ALLOC would use
+ */
+void *esp_mbedtls_mem_calloc(size_t n, size_t size) {
+#ifdef CONFIG_HEAP_USE_HOOKS
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL(&s_lock);
+    mem_task_t *entry = mem_monitor_task_locked(self);
+    if (entry != NULL) {
+        entry->in_tls = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+#endif
+    void *ptr = heap_caps_calloc(n, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    size_t held = (ptr != NULL) ? heap_caps_get_allocated_size(ptr) : 0;
+
+    portENTER_CRITICAL(&s_lock);
+#ifdef CONFIG_HEAP_USE_HOOKS
+    if (entry != NULL) {
+        entry->in_tls = false;
+    }
+#else
+    if (ptr != NULL) {
+        mem_subsys_stats_t *s = &s_subsys[MEM_SUBSYS_TLS];
+        s->allocs++;
+        s->bytes += n * size;
+        if (n * size > s->largest) {
+            s->largest = (uint32_t)(n * size);
+        }
+    }
+#endif
+    s_tls_in_use += held;
+    if (s_tls_in_use > s_tls_peak) {
+        s_tls_peak = s_tls_in_use;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return ptr;
+}
+
+void esp_mbedtls_mem_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    size_t held = heap_caps_get_allocated_size(ptr);
+    heap_caps_free(ptr);
+    portENTER_CRITICAL(&s_lock);
+    s_tls_in_use = (held <= s_tls_in_use) ? s_tls_in_use - held : 0;
+    portEXIT_CRITICAL(&s_lock);
+}
+#endif
+
+int64_t mem_monitor_task_alloc_count(void) {
+#ifdef CONFIG_HEAP_USE_HOOKS
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    int64_t count = -1;
+    portENTER_CRITICAL(&s_lock);
+    mem_task_t *entry = mem_monitor_task_locked(self);
+    if (entry != NULL) {
+        count = entry->allocs;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return count;
+#else
+    return -1;
+#endif
+}
+
+static void mem_monitor_sample_region(mem_region_t region, mem_region_stats_t *out) {
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, k_region_caps[region]);
+    uint32_t total = (uint32_t)heap_caps_get_total_size(k_region_caps[region]);
+    memset(out, 0, sizeof(*out));
+    out->present = total > 0;
+    if (!out->present) {
+        return;
+    }
+    out->total = total;
+    out->free = (uint32_t)info.total_free_bytes;
+    out->min_free = (uint32_t)info.minimum_free_bytes;
+    out->largest_free = (uint32_t)info.largest_free_block;
+    out->alloc_blocks = (uint32_t)info.allocated_blocks;
+    out->free_blocks = (uint32_t)info.free_blocks;
+    out->fragmentation = (out->free > 0) ? (uint8_t)(100 - (uint64_t)out->largest_free * 100 / out->free) : 0;
+}
+
+static void mem_monitor_publish_warning(const mem_snapshot_t *snap) {
+    const mem_region_stats_t *internal = &snap->regions[MEM_REGION_INTERNAL];
+    char buf[256];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_object_begin(&w);
+    json_writer_kv_string(&w, "type", "memory");
+    json_writer_kv_string(&w, "state", snap->warning ? "warning" : "cleared");
+    json_writer_kv_string(&w, "reason", internal->largest_free < snap->tls_block_needed ? "fragmentation" : "low_free");
+    json_writer_kv_int(&w, "free", internal->free);
+    json_writer_kv_int(&w, "min_free", internal->min_free);
+    json_writer_kv_int(&w, "largest_free", internal->largest_free);
+    json_writer_kv_int(&w, "fragmentation", internal->fragmentation);
+    json_writer_kv_int(&w, "tls_block_needed", snap->tls_block_needed);
+    json_writer_kv_int(&w, "uptime_ms", esp_timer_get_time() / 1000);
+    json_writer_object_end(&w);
+    if (json_writer_finish(&w) != ESP_OK) {
+        return;
+    }
+
+    // Queued in the client outbox, so it still goes out if the link is down right now
+    esp_err_t err = mqtt_publish_alert(buf, json_writer_length(&w));
+    if (err != ESP_OK) {
+        ESP_LOGD(TAG, "Memory alert not queued: %s", esp_err_to_name(err));
+    }
+}
+
+static void mem_monitor_sample(void *arg) {
+    (void)arg;
+    mem_snapshot_t *snap = &s_work;
+    memset(snap, 0, sizeof(*snap));
+    for (int r = 0; r < MEM_REGION_COUNT; r++) {
+        mem_monitor_sample_region((mem_region_t)r, &snap->regions[r]);
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    memcpy(snap->subsystems, s_subsys, sizeof(s_subsys));
+    snap->tls_in_use = s_tls_in_use;
+    snap->tls_peak = s_tls_peak;
+    portEXIT_CRITICAL(&s_lock);
+
+    for (int s = 0; s < MEM_SUBSYS_COUNT; s++) {
+        mem_subsys_stats_t *sub = &snap->subsystems[s];
+        sub->window_allocs = sub->allocs - s_prev_allocs[s];
+        sub->window_bytes = (uint32_t)(sub->bytes - s_prev_bytes[s]);
+        s_prev_allocs[s] = sub->allocs;
+        s_prev_bytes[s] = sub->bytes;
+    }
+
+#ifdef CONFIG_HEAP_USE_HOOKS
+    snap->attributed = true;
+#endif
+#ifdef CONFIG_MBEDTLS_CUSTOM_MEM_ALLOC
+    snap->tls_tracked = true;
+#endif
+    snap->tls_block_needed = CONFIG_MBEDTLS_SSL_IN_CONTENT_LEN + MEM_MONITOR_TLS_OVERHEAD;
+    if (snap->subsystems[MEM_SUBSYS_TLS].largest > snap->tls_block_needed) {
+        snap->tls_block_needed = snap->subsystems[MEM_SUBSYS_TLS].largest;
+    }
+
+    const mem_region_stats_t *internal = &snap->regions[MEM_REGION_INTERNAL];
+    uint32_t margin = s_warning ? MEM_MONITOR_CLEAR_MARGIN : 0;
+    bool warning = internal->largest_free < snap->tls_block_needed + margin ||
+                   internal->free < CONFIG_KC_MEM_MONITOR_MIN_FREE + margin;
+    snap->warning = warning;
+    snap->valid = true;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_snapshot = *snap;
+    xSemaphoreGive(s_mutex);
+
+    if (warning != s_warning) {
+        s_warning = warning;
+        if (warning) {
+            ESP_LOGW(TAG, "Internal heap at risk: %lu free, largest block %lu, TLS needs %lu",
+                     (unsigned long)internal->free, (unsigned long)internal->largest_free,
+                     (unsigned long)snap->tls_block_needed);
+        } else {
+            ESP_LOGI(TAG, "Internal heap recovered: largest block %lu", (unsigned long)internal->largest_free);
+        }
+        mem_monitor_publish_warning(snap);
+    }
+}
+
+esp_err_t mem_monitor_init(void) {
+    if (s_timer != NULL) {
+        return ESP_OK;
+    }
+    s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_timer_create_args_t args = {
+        .callback = mem_monitor_sample,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "mem_monitor"
+    };
+    esp_err_t err = esp_timer_create(&args, &s_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    // First window right away, so /api/status has numbers at boot
+    mem_monitor_sample(NULL);
+    return esp_timer_start_periodic(s_timer, MEM_MONITOR_WINDOW_MS * 1000ULL);
+}
+
+esp_err_t mem_monitor_get_snapshot(mem_snapshot_t *snapshot) {
+    if (s_mutex == NULL || snapshot == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool valid = s_snapshot.valid;
+    if (valid) {
+        *snapshot = s_snapshot;
+    }
+    xSemaphoreGive(s_mutex);
+    return valid ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+const char *mem_monitor_region_name(mem_region_t region) {
+    return (region < MEM_REGION_COUNT) ? k_region_names[region] : "unknown";
+}
+
+const char *mem_monitor_subsystem_name(mem_subsystem_t subsystem) {
+    return (subsystem < MEM_SUBSYS_COUNT) ? k_subsys_names[subsystem] : "unknown";
+}
+
+void mem_monitor_write_json(json_writer_t *w, bool detailed) {
+    mem_snapshot_t *snap = malloc(sizeof(mem_snapshot_t));
+    if (snap == NULL) {
+        json_writer_null(w);
+        return;
+    }
+    if (mem_monitor_get_snapshot(snap) != ESP_OK) {
+        free(snap);
+        json_writer_null(w);
+        return;
+    }
+
+    json_writer_object_begin(w);
+    for (int r = 0; r < MEM_REGION_COUNT; r++) {
+        const mem_region_stats_t *region = &snap->regions[r];
+        if (!region->present) {
+            continue;
+        }
+        json_writer_key(w, k_region_names[r]);
+        json_writer_object_begin(w);
+        json_writer_kv_int(w, "total", region->total);
+        json_writer_kv_int(w, "free", region->free);
+        json_writer_kv_int(w, "min_free", region->min_free);
+        json_writer_kv_int(w, "largest_free", region->largest_free);
+        json_writer_kv_int(w, "fragmentation", region->fragmentation);
+        if (detailed) {
+            json_writer_kv_int(w, "alloc_blocks", region->alloc_blocks);
+            json_writer_kv_int(w, "free_blocks", region->free_blocks);
+        }
+        json_writer_object_end(w);
+    }
+    json_writer_kv_bool(w, "warning", snap->warning);
+    json_writer_kv_int(w, "tls_block_needed", snap->tls_block_needed);
+    if (snap->tls_tracked) {
+        json_writer_kv_int(w, "tls_in_use", snap->tls_in_use);
+        json_writer_kv_int(w, "tls_peak", snap->tls_peak);
+    }
+
+    if (detailed && (snap->attributed || snap->tls_tracked)) {
+        json_writer_key(w, "subsystems");
+        json_writer_object_begin(w);
+        for (int s = 0; s < MEM_SUBSYS_COUNT; s++) {
+            const mem_subsys_stats_t *sub = &snap->subsystems[s];
+            json_writer_key(w, k_subsys_names[s]);
+            json_writer_object_begin(w);
+            json_writer_kv_int(w, "allocs", sub->allocs);
+            json_writer_kv_int(w, "bytes", (int64_t)sub->bytes);
+            json_writer_kv_int(w, "window_allocs", sub->window_allocs);
+            json_writer_kv_int(w, "window_bytes", sub->window_bytes);
+            json_writer_kv_int(w, "largest", sub->largest);
+            json_writer_object_end(w);
+        }
+        json_writer_object_end(w);
+    }
+    json_writer_object_end(w);
+    free(snap);
+}
@@ -0,0 +1,115 @@
+/**
+ * @file mem_monitor.h
+ * @brief Heap usage, fragmentation and per-subsystem allocation telemetry
+ *
+ * Every MEM_MONITOR_WINDOW_MS the monitor reads heap_caps_get_info() for
+ * internal RAM and PSRAM: free and minimum-ever free bytes, the largest free
+ * block and block counts. Fragmentation is the share of free memory that is
+ * not in the largest block.
+ *
+ * With CONFIG_KC_MEM_MONITOR_HOOKS the heap allocation hook attributes every
+ * allocation to the subsystem of the calling task (httpd, MQTT, sensors).
+ * mbedTLS allocations go through the monitor when
+ * CONFIG_MBEDTLS_CUSTOM_MEM_ALLOC is set, so TLS bytes in use are exact.
+ *
+ * A TLS handshake needs one contiguous block for its record buffer. When the
+ * largest free internal block falls below that (or internal free memory
+ * below CONFIG_KC_MEM_MONITOR_MIN_FREE), a warning goes out on the MQTT alert
+ * topic while a handshake is still possible, and again when it clears.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEM_MONITOR_WINDOW_MS       10000
+#define MEM_MONITOR_MAX_TASKS       32      // Tasks whose allocations are attributed
+
+typedef enum {
+    MEM_REGION_INTERNAL = 0,
+    MEM_REGION_PSRAM,
+    MEM_REGION_COUNT
+} mem_region_t;
+
+typedef enum {
+    MEM_SUBSYS_HTTPD = 0,
+    MEM_SUBSYS_MQTT,
+    MEM_SUBSYS_SENSORS,
+    MEM_SUBSYS_TLS,
+    MEM_SUBSYS_OTHER,
+    MEM_SUBSYS_COUNT
+} mem_subsystem_t;
+
+typedef struct {
+    bool present;
+    uint32_t total;
+    uint32_t free;
+    uint32_t min_free;          // Lowest free since boot
+    uint32_t largest_free;      // Largest allocatable block
+    uint32_t alloc_blocks;
+    uint32_t free_blocks;
+    uint8_t fragmentation;      // Percent of free bytes outside the largest block
+} mem_region_stats_t;
+
+typedef struct {
+    uint32_t allocs;            // Since boot
+    uint64_t bytes;             // Requested since boot
+    uint32_t window_allocs;     // During the last window
+    uint32_t window_bytes;
+    uint32_t largest;           // Largest single request since boot
+} mem_subsys_stats_t;
+
+typedef struct {
+    bool valid;                 // At least one window has been sampled
+    bool attributed;            // Allocation hooks are installed
+    bool tls_tracked;           // mbedTLS allocations go through the monitor
+    mem_region_stats_t regions[MEM_REGION_COUNT];
+    mem_subsys_stats_t subsystems[MEM_SUBSYS_COUNT];
+    uint32_t tls_in_use;        // Bytes held by mbedTLS now
+    uint32_t tls_peak;
+    uint32_t tls_block_needed;  // Contiguous internal block a new handshake needs
+    bool warning;               // A handshake is at risk
+} mem_snapshot_t;
+
+/**
+ * @brief Start sampling (idempotent)
+ */
+esp_err_t mem_monitor_init(void);
+
+/**
+ * @brief Copy the last sampled window
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE before the first window
+ */
+esp_err_t mem_monitor_get_snapshot(mem_snapshot_t *snapshot);
+
+/**
+ * @brief Allocations made so far by the calling task
+ *
+ * @return Count, or -1 when allocation hooks are not built in
+ */
+int64_t mem_monitor_task_alloc_count(void);
+
+/**
+ * @brief Name of a region or subsystem as used in JSON
+ */
+const char *mem_monitor_region_name(mem_region_t region);
+const char *mem_monitor_subsystem_name(mem_subsystem_t subsystem);
+
+/**
+ * @brief Write the last window as a JSON object
+ *
+ * @param detailed true to add block counts and the per-subsystem attribution
+ */
+void mem_monitor_write_json(json_writer_t *w, bool detailed);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,86 @@
+/**
+ * @file mqtt_deadband.c
+ * @brief Deadband comparison behind the MQTT publish filter
+ *
+ * Kept apart from the MQTT client so the host suite can build it.
+ */
+
+#include "mqtt_telemetry.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * @brief Deadband configured for a channel, or a negative value if none
+ */
+static float mqtt_deadband_threshold(const mqtt_deadband_t *table, uint8_t count,
+                                     const char *sensor_type, uint8_t value_index)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        const mqtt_deadband_t *entry = &table[i];
+        if ((entry->value_index == value_index || entry->value_index == MQTT_DEADBAND_ALL_VALUES) &&
+            strcmp(entry->sensor_type, sensor_type) == 0) {
+            return entry->threshold;
+        }
+    }
+    return -1.0f;
+}
+
+static bool mqtt_deadband_exceeded(const mqtt_deadband_t *table, uint8_t count,
+                                   const char *sensor_type, uint8_t value_index, float previous, float current)
+{
+    float threshold = mqtt_deadband_threshold(table, count, sensor_type, value_index);
+    if (threshold < 0.0f) {
+        return false;
+    }
+    float delta = fabsf(current - previous);
+    return delta > 0.0f && delta >= threshold;
+}
+
+bool mqtt_deadband_changed(const mqtt_deadband_t *table, uint8_t count,
+                           const sensor_cache_t *last, const sensor_cache_t *cache)
+{
+    if (cache->battery_valid != last->battery_valid) {
+        return true;
+    }
+    if (cache->battery_valid &&
+        mqtt_deadband_exceeded(table, count, "battery", 0, last->battery_percentage, cache->battery_percentage)) {
+        return true;
+    }
+
+    uint8_t matched = 0;
+    for (uint8_t i = 0; i < cache->sensor_count && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
+        const cached_sensor_t *sensor = &cache->sensors[i];
+        if (!sensor->valid) {
+            continue;
+        }
+
+        const cached_sensor_t *previous = NULL;
+        for (uint8_t j = 0; j < last->sensor_count && j < SENSOR_MANAGER_MAX_SENSORS; j++) {
+            if (last->sensors[j].valid && last->sensors[j].address == sensor->address &&
+                last->sensors[j].kind == sensor->kind) {
+                previous = &last->sensors[j];
+                break;
+            }
+        }
+        // Sensors appearing or changing shape always publish
+        if (previous == NULL || previous->value_count != sensor->value_count) {
+            return true;
+        }
+        matched++;
+
+        for (uint8_t v = 0; v < sensor->value_count && v < MAX_SENSOR_VALUES; v++) {
+            if (mqtt_deadband_exceeded(table, count, sensor->sensor_type, v, previous->values[v], sensor->values[v])) {
+                return true;
+            }
+        }
+    }
+
+    // Any previously published sensor that dropped out
+    uint8_t previously_valid = 0;
+    for (uint8_t j = 0; j < last->sensor_count && j < SENSOR_MANAGER_MAX_SENSORS; j++) {
+        if (last->sensors[j].valid) {
+            previously_valid++;
+        }
+    }
+    return matched != previously_valid;
+}
@@ -7,21 +7,36 @@
 #include "cloud_provisioning.h"
 #include "wifi_manager.h"
 #include "sensor_manager.h"
+#include "telemetry_codec.h"
+#include "telemetry_log.h"
+#include "telemetry_publisher.h"
+#include "time_sync.h"
 #include "ezo_sensor.h"
+#include "i2c_scanner.h"
+#include "perf_monitor.h"
+#include "mem_monitor.h"
+#include "task_profile.h"
+#include "json_arena.h"
+#include "boot_profile.h"
+#include "trace_log.h"
+#include "settings_store.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_timer.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_random.h"
-#include "nvs_flash.h"
-#include "nvs.h"
+#include "esp_heap_caps.h"
 #include "cJSON.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "mqtt_client.h" // ESP-IDF MQTT client
 #include <string.h>
+#include <stdlib.h>
 #include <sys/time.h>
+#include <time.h>
 #include <math.h>
 
 static const char *TAG = "MQTT_CLIENT";
@@ -29,14 +44,141 @@ static const char *TAG = "MQTT_CLIENT";
 static esp_mqtt_client_handle_t s_mqtt_client = NULL;
 static mqtt_state_t s_mqtt_state = MQTT_STATE_DISCONNECTED;
 static TaskHandle_t s_publish_task_handle = NULL;
+static QueueHandle_t s_snapshot_queue = NULL;   // One-slot mailbox: latest snapshot due for publishing
 static uint32_t s_publish_interval_sec = 10; // Default: 10 seconds between MQTT publishes
 static uint32_t s_mqtt_reconnects = 0;
 static char s_device_id[32] = {0};
-static char s_mqtt_ca_cert[CLOUD_PROV_MAX_CERT_SIZE] = {0}; // Static buffer for CA certificate
+
+#define MQTT_DEFAULT_HEARTBEAT_SEC 300
+#define MQTT_JSON_MAX_SIZE          1024
+
+// Reconnect backoff: doubles per failed or short-lived session, with +/-25% jitter
+#define MQTT_BACKOFF_MIN_MS         2000
+#define MQTT_BACKOFF_MAX_MS         300000
+#define MQTT_STABLE_SESSION_SEC     60      // A session this long resets the backoff
+
+static esp_timer_handle_t s_reconnect_timer = NULL;
+static uint32_t s_backoff_ms = MQTT_BACKOFF_MIN_MS;
+static int64_t s_connected_at_us = 0;
+static bool s_client_running = false;
+
+// Publish pipeline instrumentation, updated by the publish task and the event handler
+#define MQTT_PERF_TRACKED_SENDS     16      // Sends remembered for PUBACK matching
+
+typedef struct {
+    int msg_id;                 // 0 = free slot
+    int64_t sent_us;
+} mqtt_sent_slot_t;
+
+static const uint32_t s_latency_bounds_ms[MQTT_LATENCY_BUCKETS] = MQTT_LATENCY_BUCKET_BOUNDS_MS;
+static SemaphoreHandle_t s_perf_mutex = NULL;
+static mqtt_perf_stats_t s_perf;
+static mqtt_sent_slot_t s_sent[MQTT_PERF_TRACKED_SENDS];
+static uint8_t s_sent_next = 0;
+static int64_t s_disconnected_at_us = 0;
+
+// Publish topics, built once per init; the index + 1 is the MQTT 5 topic alias
+typedef enum {
+    MQTT_TOPIC_DATA = 0,
+    MQTT_TOPIC_DATA_CBOR,
+    MQTT_TOPIC_BATCH,
+    MQTT_TOPIC_BATCH_CBOR,
+    MQTT_TOPIC_TELEMETRY,
+    MQTT_TOPIC_BURST_CBOR,
+    MQTT_TOPIC_ALERT,
+    MQTT_TOPIC_COUNT
+} mqtt_topic_t;
+
+static char s_topics[MQTT_TOPIC_COUNT][80];
+static SemaphoreHandle_t s_publish_mutex = NULL;   // Publish properties apply to the next publish only
+static bool s_protocol_v5 = false;                 // Saved setting, applied by mqtt_client_init
+static bool s_session_v5 = false;                  // Client was created with MQTT 5
+static bool s_aliases_ok = true;                   // Cleared for the session if the broker refuses aliases
+#ifdef CONFIG_MQTT_PROTOCOL_5
+static esp_mqtt5_publish_property_config_t s_publish_props;
+static const esp_mqtt5_publish_property_config_t s_no_props = {0};
+#endif
+
+// Deadband filter state, shared by the sensor reading task (listener) and the publish task
+static SemaphoreHandle_t s_deadband_mutex = NULL;
+static mqtt_deadband_t s_deadbands[MQTT_DEADBAND_MAX_CHANNELS];
+static uint8_t s_deadband_count = 0;
+static uint32_t s_heartbeat_sec = MQTT_DEFAULT_HEARTBEAT_SEC;
+static sensor_cache_t s_last_published;
+static bool s_last_published_valid = false;
+static int64_t s_last_publish_us = 0;
+
+static mqtt_payload_format_t s_payload_format = MQTT_PAYLOAD_JSON;
+static uint8_t s_cbor_buffer[TELEMETRY_CBOR_MAX_SIZE];     // Only used by the publish task
+static char s_json_buffer[MQTT_JSON_MAX_SIZE];              // Only used by the publish task
+
+// Store-and-forward: snapshots taken while offline go to the flash log and are
+// replayed after reconnect. A record is deleted only once its PUBACK arrives.
+#define MQTT_REPLAY_INFLIGHT        8       // Unacknowledged replays at once
+#define MQTT_REPLAY_SPACING_MS      100     // Gap between replayed publishes
+#define MQTT_REPLAY_POLL_MS         250     // Publish task wake-up while replaying
+#define MQTT_REPLAY_ACK_TIMEOUT_MS  30000   // Resend window for a lost PUBACK
+
+typedef struct {
+    int msg_id;                 // 0 = free slot
+    uint32_t pos;               // Record position in the telemetry log
+    int64_t sent_us;
+    bool acked;                 // Set by the event handler, consumed by the publish task
+} mqtt_replay_slot_t;
+
+static SemaphoreHandle_t s_replay_mutex = NULL;
+static mqtt_replay_slot_t s_replay_slots[MQTT_REPLAY_INFLIGHT];
+static uint32_t s_replay_cursor = TELEMETRY_LOG_CURSOR_START;  // Only used by the publish task
+static uint8_t s_replay_record[TELEMETRY_PACKED_MAX_SIZE];      // Only used by the publish task
+static uint8_t s_sample_record[TELEMETRY_PACKED_MAX_SIZE];      // Only used by the cache listener
+static int64_t s_sample_last_us = 0;
+
+// Batching: samples collected by the cache listener, published together by the publish task
+typedef struct {
+    uint64_t timestamp_us;      // Acquisition time (esp_timer), not part of the packed record
+    uint16_t len;
+    uint8_t data[TELEMETRY_PACKED_MAX_SIZE];
+} mqtt_batch_sample_t;
+
+static SemaphoreHandle_t s_batch_mutex = NULL;
+static mqtt_batch_sample_t s_batch[MQTT_BATCH_MAX_SAMPLES];
+static uint8_t s_batch_count = 0;
+static int64_t s_batch_first_us = 0;    // When the oldest sample was added
+static bool s_batch_flush = false;      // mqtt_flush(): publish without waiting for the window
+static uint8_t s_batch_size = 0;
+static uint32_t s_batch_window_sec = 0;
+
+// Burst capture: every sample of a time-bounded fast acquisition run is kept in RAM
+// and uploaded as one CBOR batch when the run ends. Records are packed back to back
+// as a mqtt_burst_header_t followed by the packed snapshot.
+#define MQTT_BURST_BUFFER_SIZE      (16 * 1024)
+
+typedef struct {
+    uint64_t timestamp_us;
+    uint16_t len;
+} mqtt_burst_header_t;
+
+static uint8_t *s_burst_buf = NULL;     // Allocated for the duration of a burst, guarded by s_batch_mutex
+static size_t s_burst_used = 0;
+static uint16_t s_burst_count = 0;
+static int64_t s_burst_end_us = 0;      // 0 = no burst
+static bool s_burst_full = false;
 
 // Forward declarations
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data);
 static void mqtt_publish_task(void *arg);
+static bool mqtt_deadband_should_publish(const sensor_cache_t *cache);
+static void mqtt_deadband_mark_published(const sensor_cache_t *cache);
+static void mqtt_replay_reset(void);
+static void mqtt_replay_on_puback(int msg_id);
+static void mqtt_schedule_reconnect(void);
+static void mqtt_perf_on_connected(void);
+static void mqtt_perf_on_disconnected(void);
+static void mqtt_perf_on_puback(int msg_id);
+static void mqtt_perf_count_dropped(void);
+static esp_err_t mqtt_burst_start(uint32_t duration_sec);
+static esp_err_t mqtt_encode_record_cbor(uint64_t timestamp_us, const uint8_t *record, size_t record_len,
+                                         uint8_t *out, size_t out_size, size_t *out_len);
 
 /**
  * @brief MQTT event handler
@@ -48,7 +190,18 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     switch ((esp_mqtt_event_id_t)event_id) {
         case MQTT_EVENT_CONNECTED:
             ESP_LOGI(TAG, "✓ Connected to MQTT broker");
+            boot_profile_mark(BOOT_MARK_MQTT_CONNECTED);
             s_mqtt_state = MQTT_STATE_CONNECTED;
+            s_connected_at_us = esp_timer_get_time();
+            s_aliases_ok = true;    // esp-mqtt starts every connection with an empty alias table
+            mqtt_perf_on_connected();
+            if (telemetry_log_pending_count() > 0) {
+                ESP_LOGI(TAG, "%lu stored sample(s) to replay", (unsigned long)telemetry_log_pending_count());
+            }
+            // Start replay and flush a batch collected while connecting
+            if (s_publish_task_handle != NULL) {
+                xTaskNotifyGive(s_publish_task_handle);
+            }
             
             // Subscribe to KannaCloud command topic for this device
             char cmd_topic[128];
@@ -64,6 +217,10 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             ESP_LOGW(TAG, "Disconnected from MQTT broker");
             s_mqtt_state = MQTT_STATE_DISCONNECTED;
             s_mqtt_reconnects++;
+            // Unacknowledged replays stay pending in the log and are resent next session
+            mqtt_replay_reset();
+            mqtt_perf_on_disconnected();
+            mqtt_schedule_reconnect();
             break;
             
         case MQTT_EVENT_SUBSCRIBED:
@@ -76,6 +233,9 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             
         case MQTT_EVENT_PUBLISHED:
             ESP_LOGD(TAG, "Published, msg_id=%d", event->msg_id);
+            mqtt_replay_on_puback(event->msg_id);
+            mqtt_perf_on_puback(event->msg_id);
+            boot_profile_mark(BOOT_MARK_FIRST_PUBLISH);
             break;
             
         case MQTT_EVENT_DATA:
@@ -84,6 +244,7 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             
             // Parse command (could be extended to handle different commands)
             if (event->data_len > 0) {
+                json_arena_t *arena = json_arena_begin();
                 cJSON *root = cJSON_ParseWithLength(event->data, event->data_len);
                 if (root) {
                     cJSON *cmd = cJSON_GetObjectItem(root, "command");
@@ -98,10 +259,32 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
                             esp_restart();
                         } else if (strcmp(cmd->valuestring, "ping") == 0) {
                             mqtt_publish_status("pong");
+                        } else if (strcmp(cmd->valuestring, "burst") == 0) {
+                            // {"command":"burst","duration":60}
+                            cJSON *duration = cJSON_GetObjectItem(root, "duration");
+                            uint32_t duration_sec = (duration && cJSON_IsNumber(duration) && duration->valueint > 0) ?
+                                                    (uint32_t)duration->valueint : 0;
+                            mqtt_publish_status(mqtt_burst_start(duration_sec) == ESP_OK ? "burst" : "burst_failed");
+                        } else if (strcmp(cmd->valuestring, "transport") == 0) {
+                            // {"command":"transport","transport":"thread"}; takes effect after a restart
+                            cJSON *name = cJSON_GetObjectItem(root, "transport");
+                            telemetry_transport_t transport;
+                            if (!name || !cJSON_IsString(name) ||
+                                telemetry_transport_from_string(name->valuestring, &transport) != ESP_OK ||
+                                telemetry_publisher_select(transport) != ESP_OK) {
+                                mqtt_publish_status("transport_failed");
+                            } else if (transport != TELEMETRY_TRANSPORT_MQTT) {
+                                ESP_LOGW(TAG, "Switching telemetry to %s, restarting in 3 seconds...",
+                                         telemetry_transport_to_string(transport));
+                                mqtt_publish_status("restarting");
+                                vTaskDelay(pdMS_TO_TICKS(3000));
+                                esp_restart();
+                            }
                         }
                     }
                     cJSON_Delete(root);
                 }
+                json_arena_end(arena);
             }
             break;
             
@@ -120,6 +303,241 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     }
 }
 
+static bool mqtt_perf_lock(void)
+{
+    return s_perf_mutex != NULL && xSemaphoreTake(s_perf_mutex, pdMS_TO_TICKS(20)) == pdTRUE;
+}
+
+// Caller holds s_perf_mutex
+static void mqtt_hist_add(mqtt_latency_hist_t *hist, int64_t elapsed_us)
+{
+    uint32_t ms = (elapsed_us <= 0) ? 0 :
+                  (elapsed_us / 1000 > UINT32_MAX) ? UINT32_MAX : (uint32_t)(elapsed_us / 1000);
+    uint8_t bucket = 0;
+    while (bucket < MQTT_LATENCY_BUCKETS - 1 && ms > s_latency_bounds_ms[bucket]) {
+        bucket++;
+    }
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->sum_ms += ms;
+    if (ms > hist->max_ms) {
+        hist->max_ms = ms;
+    }
+}
+
+static void mqtt_perf_on_connected(void)
+{
+    if (mqtt_perf_lock()) {
+        if (s_disconnected_at_us != 0) {
+            mqtt_hist_add(&s_perf.reconnect, esp_timer_get_time() - s_disconnected_at_us);
+            s_disconnected_at_us = 0;
+        }
+        xSemaphoreGive(s_perf_mutex);
+    }
+}
+
+static void mqtt_perf_on_disconnected(void)
+{
+    if (mqtt_perf_lock()) {
+        if (s_disconnected_at_us == 0) {
+            s_disconnected_at_us = esp_timer_get_time();
+        }
+        // Acks of the old session would measure the outage, not the broker
+        for (int i = 0; i < MQTT_PERF_TRACKED_SENDS; i++) {
+            if (s_sent[i].msg_id != 0) {
+                s_perf.acks_untracked++;
+                s_sent[i].msg_id = 0;
+            }
+        }
+        xSemaphoreGive(s_perf_mutex);
+    }
+}
+
+static void mqtt_perf_on_puback(int msg_id)
+{
+    if (msg_id <= 0 || !mqtt_perf_lock()) {
+        return;
+    }
+    for (int i = 0; i < MQTT_PERF_TRACKED_SENDS; i++) {
+        if (s_sent[i].msg_id == msg_id) {
+            mqtt_hist_add(&s_perf.send_to_ack, esp_timer_get_time() - s_sent[i].sent_us);
+            s_sent[i].msg_id = 0;
+            break;
+        }
+    }
+    xSemaphoreGive(s_perf_mutex);
+}
+
+static void mqtt_perf_count_dropped(void)
+{
+    if (mqtt_perf_lock()) {
+        s_perf.samples_dropped++;
+        xSemaphoreGive(s_perf_mutex);
+    }
+}
+
+/**
+ * @brief Record how long a sample waited between its cache snapshot and the client
+ */
+static void mqtt_perf_record_snapshot(uint64_t snapshot_us, int64_t enqueue_us)
+{
+    if (snapshot_us != 0 && (int64_t)snapshot_us <= enqueue_us && mqtt_perf_lock()) {
+        mqtt_hist_add(&s_perf.snapshot_to_enqueue, enqueue_us - (int64_t)snapshot_us);
+        xSemaphoreGive(s_perf_mutex);
+    }
+}
+
+static void mqtt_build_topics(void)
+{
+    snprintf(s_topics[MQTT_TOPIC_DATA], sizeof(s_topics[0]), "kannacloud/sensor/%s/data", s_device_id);
+    snprintf(s_topics[MQTT_TOPIC_DATA_CBOR], sizeof(s_topics[0]), "kannacloud/sensor/%s/data/cbor", s_device_id);
+    snprintf(s_topics[MQTT_TOPIC_BATCH], sizeof(s_topics[0]), "kannacloud/sensor/%s/data/batch", s_device_id);
+    snprintf(s_topics[MQTT_TOPIC_BATCH_CBOR], sizeof(s_topics[0]), "kannacloud/sensor/%s/data/batch/cbor", s_device_id);
+    snprintf(s_topics[MQTT_TOPIC_TELEMETRY], sizeof(s_topics[0]), "devices/%s/telemetry", s_device_id);
+    snprintf(s_topics[MQTT_TOPIC_BURST_CBOR], sizeof(s_topics[0]), "kannacloud/sensor/%s/data/burst/cbor", s_device_id);
+    snprintf(s_topics[MQTT_TOPIC_ALERT], sizeof(s_topics[0]), "kannacloud/sensor/%s/alert", s_device_id);
+}
+
+/**
+ * @brief Publish with the MQTT 5 properties of a data message
+ *
+ * esp-mqtt sends the full topic only on the first use of an alias per
+ * connection; later publishes carry the two-byte alias alone. The properties
+ * carry the schema version and sample time so the payload can leave them out,
+ * and the expiry lets the broker drop data nobody collected in time.
+ * Caller holds s_publish_mutex.
+ */
+static int mqtt_publish_v5(mqtt_topic_t topic, const char *data, int len, uint32_t sample_time)
+{
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    bool binary = (topic == MQTT_TOPIC_DATA_CBOR || topic == MQTT_TOPIC_BATCH_CBOR || topic == MQTT_TOPIC_BURST_CBOR);
+    char schema[8];
+    char ts[12];
+    snprintf(schema, sizeof(schema), "%u", binary ? TELEMETRY_CBOR_SCHEMA_VERSION : MQTT_JSON_SCHEMA_VERSION);
+    snprintf(ts, sizeof(ts), "%lu", (unsigned long)sample_time);
+    esp_mqtt5_user_property_item_t items[] = {
+        {"schema", schema},
+        {"ts", ts},
+    };
+    
+    memset(&s_publish_props, 0, sizeof(s_publish_props));
+    s_publish_props.payload_format_indicator = !binary;     // UTF-8 payload
+    s_publish_props.message_expiry_interval = MQTT_V5_MESSAGE_EXPIRY_SEC;
+    esp_mqtt5_client_set_user_property(&s_publish_props.user_property, items, sample_time != 0 ? 2 : 1);
+    
+    s_publish_props.topic_alias = s_aliases_ok ? (uint16_t)(topic + 1) : 0;
+    if (esp_mqtt5_client_set_publish_property(s_mqtt_client, &s_publish_props) != ESP_OK &&
+        s_publish_props.topic_alias != 0) {
+        // Alias above the broker's Topic Alias Maximum: send full topics this session
+        ESP_LOGW(TAG, "Broker refused topic alias %u, sending full topics", s_publish_props.topic_alias);
+        s_aliases_ok = false;
+        s_publish_props.topic_alias = 0;
+        esp_mqtt5_client_set_publish_property(s_mqtt_client, &s_publish_props);
+    }
+    
+    int msg_id = esp_mqtt_client_publish(s_mqtt_client, s_topics[topic], data, len, 1, 0);
+    
+    // Properties stick to the client; clear them so other publishes go out bare
+    esp_mqtt5_client_set_publish_property(s_mqtt_client, &s_no_props);
+    esp_mqtt5_client_delete_user_property(s_publish_props.user_property);
+    s_publish_props.user_property = NULL;
+    return msg_id;
+#else
+    return esp_mqtt_client_publish(s_mqtt_client, s_topics[topic], data, len, 1, 0);
+#endif
+}
+
+/**
+ * @brief QoS 1 publish with latency, size and PUBACK tracking
+ *
+ * @param topic Destination topic
+ * @param snapshot_us esp_timer time of the cache snapshot behind the payload (0 if none)
+ * @param sample_time Unix time of the sample for the MQTT 5 "ts" property (0 to omit)
+ * @return MQTT message id, or -1 on failure
+ */
+static int mqtt_publish_tracked(mqtt_topic_t topic, const char *data, int len,
+                                uint64_t snapshot_us, uint32_t sample_time)
+{
+    xSemaphoreTake(s_publish_mutex, portMAX_DELAY);
+    int64_t start_us = esp_timer_get_time();
+    int msg_id = s_session_v5 ? mqtt_publish_v5(topic, data, len, sample_time) :
+                 esp_mqtt_client_publish(s_mqtt_client, s_topics[topic], data, len, 1, 0);
+    int64_t end_us = esp_timer_get_time();
+    xSemaphoreGive(s_publish_mutex);
+    
+    mqtt_perf_record_snapshot(snapshot_us, start_us);
+    if (mqtt_perf_lock()) {
+        if (msg_id < 0) {
+            s_perf.publish_failures++;
+        } else {
+            mqtt_hist_add(&s_perf.enqueue_to_send, end_us - start_us);
+            s_perf.messages_sent++;
+            s_perf.bytes_sent += (len > 0) ? (uint64_t)len : strlen(data);
+            mqtt_sent_slot_t *slot = &s_sent[s_sent_next];
+            if (slot->msg_id != 0) {
+                s_perf.acks_untracked++;
+            }
+            slot->msg_id = msg_id;
+            slot->sent_us = end_us;
+            s_sent_next = (s_sent_next + 1) % MQTT_PERF_TRACKED_SENDS;
+        }
+        xSemaphoreGive(s_perf_mutex);
+    }
+    return msg_id;
+}
+
+/**
+ * @brief Publish outside the data path, serialized with property-carrying publishes
+ */
+static int mqtt_publish_plain(const char *topic, const char *data, int qos, int retain)
+{
+    xSemaphoreTake(s_publish_mutex, portMAX_DELAY);
+    int msg_id = esp_mqtt_client_publish(s_mqtt_client, topic, data, 0, qos, retain);
+    xSemaphoreGive(s_publish_mutex);
+    return msg_id;
+}
+
+static void mqtt_reconnect_timer_cb(void *arg)
+{
+    (void)arg;
+    if (s_client_running && s_mqtt_client != NULL) {
+        ESP_LOGI(TAG, "Reconnecting to MQTT broker");
+        s_mqtt_state = MQTT_STATE_CONNECTING;
+        esp_mqtt_client_reconnect(s_mqtt_client);
+    }
+}
+
+/**
+ * @brief Arm the next reconnect attempt
+ *
+ * Auto-reconnect is disabled in the client so a flapping AP cannot drive a
+ * full TLS handshake every few seconds: each failed or short-lived session
+ * doubles the delay, and only a session that stayed up resets it.
+ */
+static void mqtt_schedule_reconnect(void)
+{
+    if (!s_client_running || s_reconnect_timer == NULL) {
+        return;
+    }
+    
+    int64_t now_us = esp_timer_get_time();
+    if (s_connected_at_us != 0 && now_us - s_connected_at_us >= (int64_t)MQTT_STABLE_SESSION_SEC * 1000000LL) {
+        s_backoff_ms = MQTT_BACKOFF_MIN_MS;
+    }
+    s_connected_at_us = 0;
+    
+    // Jitter spreads reconnects of devices that lost the same AP
+    uint32_t jitter = s_backoff_ms / 4;
+    uint32_t delay_ms = s_backoff_ms - jitter + (esp_random() % (2 * jitter + 1));
+    
+    esp_timer_stop(s_reconnect_timer);
+    if (esp_timer_start_once(s_reconnect_timer, (uint64_t)delay_ms * 1000ULL) == ESP_OK) {
+        ESP_LOGI(TAG, "Next MQTT reconnect in %lu ms", (unsigned long)delay_ms);
+    }
+    
+    s_backoff_ms = (s_backoff_ms >= MQTT_BACKOFF_MAX_MS / 2) ? MQTT_BACKOFF_MAX_MS : s_backoff_ms * 2;
+}
+
 /**
  * @brief Read sensor values using sensor_manager
  * Non-static to allow access from http_server for dashboard display
@@ -162,14 +580,807 @@ float read_light_level(void) {
     return 0.0f;
 }
 
-float read_battery_level(void) {
-    float battery = 0.0f;
-    // Read from MAX17048 battery monitor
-    if (sensor_manager_read_battery_percentage(&battery) == ESP_OK) {
-        return battery;
+float read_battery_level(void) {
+    float battery = 0.0f;
+    // Read from MAX17048 battery monitor
+    if (sensor_manager_read_battery_percentage(&battery) == ESP_OK) {
+        return battery;
+    }
+    // Return 0 if sensor not available (don't send fake data)
+    return 0.0f;
+}
+
+static bool mqtt_deadband_should_publish(const sensor_cache_t *cache)
+{
+    if (s_deadband_count == 0 || s_deadband_mutex == NULL) {
+        return true;
+    }
+    if (xSemaphoreTake(s_deadband_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+        return true;
+    }
+
+    bool publish = !s_last_published_valid;
+    if (!publish && s_heartbeat_sec > 0) {
+        int64_t silent_us = esp_timer_get_time() - s_last_publish_us;
+        publish = (silent_us >= (int64_t)s_heartbeat_sec * 1000000LL);
+    }
+    if (!publish) {
+        publish = mqtt_deadband_changed(s_deadbands, s_deadband_count, &s_last_published, cache);
+    }
+
+    xSemaphoreGive(s_deadband_mutex);
+    return publish;
+}
+
+static void mqtt_deadband_mark_published(const sensor_cache_t *cache)
+{
+    if (s_deadband_mutex == NULL) {
+        return;
+    }
+    if (xSemaphoreTake(s_deadband_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+        s_last_published = *cache;
+        s_last_published_valid = true;
+        s_last_publish_us = esp_timer_get_time();
+        xSemaphoreGive(s_deadband_mutex);
+    }
+}
+
+/**
+ * @brief Acquisition time to attach to a payload (0 while the clock is not synced)
+ */
+static uint32_t mqtt_unix_time(void)
+{
+    return time_sync_is_synced() ? (uint32_t)time(NULL) : 0;
+}
+
+static bool mqtt_batch_enabled(void)
+{
+    return s_batch_size > 1 || s_batch_window_sec > 0;
+}
+
+static uint8_t mqtt_batch_limit(void)
+{
+    return (s_batch_size > 1) ? s_batch_size : MQTT_BATCH_MAX_SAMPLES;
+}
+
+/**
+ * @brief Decide whether a completed sensor cycle is sampled
+ *
+ * The first cycle after the publish interval (times the battery band's
+ * factor) has elapsed is taken (every cycle with interval 0), then the
+ * deadband filter has the final say. Live, batched and stored publishing
+ * all go through this gate, so their series match.
+ */
+static bool mqtt_sample_due(const sensor_cache_t *cache)
+{
+    int64_t now_us = esp_timer_get_time();
+    // Stretched with the sensor intervals as the battery drains
+    int64_t interval_us = (int64_t)s_publish_interval_sec *
+                          power_manager_band_factor(sensor_manager_get_battery_band()) * 1000000LL;
+    if (s_publish_interval_sec > 0 && s_sample_last_us != 0 && now_us - s_sample_last_us < interval_us) {
+        return false;
+    }
+    if (!mqtt_deadband_should_publish(cache)) {
+        return false;
+    }
+    s_sample_last_us = now_us;
+    return true;
+}
+
+/**
+ * @brief Turn a sampled cache update into a packed record (in s_sample_record)
+ *
+ * @return Packed length, or 0 on failure
+ */
+static size_t mqtt_pack_sample(const sensor_cache_t *cache)
+{
+    size_t len = 0;
+    if (telemetry_pack_snapshot(cache, mqtt_unix_time(), s_sample_record, sizeof(s_sample_record), &len) != ESP_OK) {
+        return 0;
+    }
+    mqtt_deadband_mark_published(cache);
+    return len;
+}
+
+/**
+ * @brief Add the sample in s_sample_record to the batch
+ *
+ * @return true when the batch needs the publish task's attention
+ */
+static bool mqtt_batch_add_record(uint64_t timestamp_us, const uint8_t *record, size_t len)
+{
+    if (s_batch_mutex == NULL || xSemaphoreTake(s_batch_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
+    }
+
+    bool wake = false;
+    if (s_batch_count < MQTT_BATCH_MAX_SAMPLES) {
+        mqtt_batch_sample_t *sample = &s_batch[s_batch_count];
+        sample->timestamp_us = timestamp_us;
+        sample->len = (uint16_t)len;
+        memcpy(sample->data, record, len);
+        if (s_batch_count == 0) {
+            s_batch_first_us = esp_timer_get_time();
+        }
+        s_batch_count++;
+        // First sample starts the window, a full batch publishes right away
+        wake = (s_batch_count == 1 && s_batch_window_sec > 0) || s_batch_count == mqtt_batch_limit();
+    } else {
+        ESP_LOGD(TAG, "Batch full, sample dropped");
+        mqtt_perf_count_dropped();
+    }
+
+    xSemaphoreGive(s_batch_mutex);
+    return wake;
+}
+
+/**
+ * @brief Move unsent batch samples to the flash log once the broker is gone
+ */
+static void mqtt_batch_spill_to_log(void)
+{
+    if (s_batch_count == 0 || s_batch_mutex == NULL ||
+        xSemaphoreTake(s_batch_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return;
+    }
+    for (uint8_t i = 0; i < s_batch_count; i++) {
+        telemetry_log_append(s_batch[i].data, s_batch[i].len);
+    }
+    s_batch_count = 0;
+    xSemaphoreGive(s_batch_mutex);
+}
+
+/**
+ * @brief Hand a snapshot to the publish task, replacing one not yet taken
+ */
+static void mqtt_post_snapshot(const sensor_cache_t *cache)
+{
+    xQueueOverwrite(s_snapshot_queue, cache);
+    xTaskNotifyGive(s_publish_task_handle);
+}
+
+/**
+ * @brief Cache listener: the publish pipeline's only source of sensor data
+ *
+ * Runs in the sensor reading task right after each completed cycle. Sampled
+ * snapshots are posted to the publish task (live), added to the batch, or
+ * appended to the flash log while offline; nothing is published here.
+ */
+/**
+ * @brief Start a burst capture (command handler)
+ *
+ * @param duration_sec Burst length, clamped to MQTT_BURST_MAX_SEC
+ */
+static esp_err_t mqtt_burst_start(uint32_t duration_sec)
+{
+    if (duration_sec == 0) {
+        duration_sec = MQTT_BURST_DEFAULT_SEC;
+    }
+    if (duration_sec > MQTT_BURST_MAX_SEC) {
+        duration_sec = MQTT_BURST_MAX_SEC;
+    }
+    if (s_batch_mutex == NULL || xSemaphoreTake(s_batch_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    esp_err_t err = ESP_OK;
+    if (s_burst_buf == NULL) {
+        // PSRAM where available; the buffer only lives for one burst
+        s_burst_buf = heap_caps_malloc(MQTT_BURST_BUFFER_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (s_burst_buf == NULL) {
+            s_burst_buf = malloc(MQTT_BURST_BUFFER_SIZE);
+        }
+        s_burst_used = 0;
+        s_burst_count = 0;
+        s_burst_full = false;
+    }
+    if (s_burst_buf == NULL) {
+        err = ESP_ERR_NO_MEM;
+    } else {
+        // A second command while running extends the current burst
+        s_burst_end_us = esp_timer_get_time() + (int64_t)duration_sec * 1000000LL;
+    }
+    xSemaphoreGive(s_batch_mutex);
+    
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "No memory for a burst capture");
+        return err;
+    }
+    sensor_manager_start_burst(duration_sec);
+    if (s_publish_task_handle != NULL) {
+        xTaskNotifyGive(s_publish_task_handle);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Keep a sample of the running burst (cache listener)
+ *
+ * @return true if a burst is running and the sample belongs to it
+ */
+static bool mqtt_burst_add(const sensor_cache_t *cache)
+{
+    if (s_burst_end_us == 0 || s_batch_mutex == NULL) {
+        return false;
+    }
+    size_t len = mqtt_pack_sample(cache);
+    if (len == 0 || xSemaphoreTake(s_batch_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return true;
+    }
+    
+    bool wake = false;
+    if (s_burst_buf == NULL) {
+        // Finished while this sample was in flight
+    } else if (s_burst_used + sizeof(mqtt_burst_header_t) + len <= MQTT_BURST_BUFFER_SIZE) {
+        mqtt_burst_header_t header = {
+            .timestamp_us = cache->timestamp_us,
+            .len = (uint16_t)len,
+        };
+        memcpy(s_burst_buf + s_burst_used, &header, sizeof(header));
+        memcpy(s_burst_buf + s_burst_used + sizeof(header), s_sample_record, len);
+        s_burst_used += sizeof(header) + len;
+        s_burst_count++;
+    } else {
+        mqtt_perf_count_dropped();
+        wake = !s_burst_full;   // End the run early rather than keep sampling into a full buffer
+        s_burst_full = true;
+    }
+    xSemaphoreGive(s_batch_mutex);
+    
+    if (wake) {
+        xTaskNotifyGive(s_publish_task_handle);
+    }
+    return true;
+}
+
+static bool mqtt_burst_due(void)
+{
+    return s_burst_end_us != 0 && (s_burst_full || esp_timer_get_time() >= s_burst_end_us);
+}
+
+static TickType_t mqtt_burst_wait_ticks(void)
+{
+    if (s_burst_end_us == 0) {
+        return portMAX_DELAY;
+    }
+    int64_t remaining_us = s_burst_end_us - esp_timer_get_time();
+    return (remaining_us > 0) ? pdMS_TO_TICKS(remaining_us / 1000) + 1 : 0;
+}
+
+/**
+ * @brief Encode burst records as a CBOR array of snapshot maps
+ *
+ * @param out Output buffer, or NULL to only measure the encoded size
+ */
+static esp_err_t mqtt_encode_burst_cbor(const uint8_t *records, size_t used, uint16_t count,
+                                        uint8_t *out, size_t out_size, size_t *out_len)
+{
+    size_t total = 0;
+    size_t len = 0;
+    
+    esp_err_t err = telemetry_encode_cbor_array(count, out ? out : s_cbor_buffer,
+                                                out ? out_size : sizeof(s_cbor_buffer), &len);
+    total += len;
+    for (size_t offset = 0; offset < used && err == ESP_OK;) {
+        mqtt_burst_header_t header;
+        memcpy(&header, records + offset, sizeof(header));
+        offset += sizeof(header);
+        err = mqtt_encode_record_cbor(header.timestamp_us, records + offset, header.len,
+                                      out ? out + total : NULL, out ? out_size - total : 0, &len);
+        offset += header.len;
+        total += len;
+    }
+    
+    *out_len = total;
+    return err;
+}
+
+/**
+ * @brief End the burst, upload it as one message and restore the normal schedule
+ *
+ * Samples that cannot be uploaded go to the flash log like any other offline sample.
+ */
+static void mqtt_burst_finish(void)
+{
+    sensor_manager_stop_burst();
+    
+    // Detach the buffer so the listener never waits on the upload
+    xSemaphoreTake(s_batch_mutex, portMAX_DELAY);
+    s_burst_end_us = 0;
+    uint8_t *buf = s_burst_buf;
+    size_t used = s_burst_used;
+    uint16_t count = s_burst_count;
+    s_burst_buf = NULL;
+    s_burst_used = 0;
+    s_burst_count = 0;
+    s_burst_full = false;
+    xSemaphoreGive(s_batch_mutex);
+    
+    int msg_id = -1;
+    size_t len = 0;
+    if (count > 0 && s_mqtt_state == MQTT_STATE_CONNECTED &&
+        mqtt_encode_burst_cbor(buf, used, count, NULL, 0, &len) == ESP_OK) {
+        uint8_t *payload = heap_caps_malloc(len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (payload == NULL) {
+            payload = malloc(len);
+        }
+        if (payload != NULL && mqtt_encode_burst_cbor(buf, used, count, payload, len, &len) == ESP_OK) {
+            msg_id = mqtt_publish_tracked(MQTT_TOPIC_BURST_CBOR, (const char *)payload, (int)len, 0, 0);
+        }
+        free(payload);
+    }
+    
+    if (msg_id >= 0) {
+        ESP_LOGI(TAG, "✓ Burst uploaded (%u samples, %u bytes)", count, (unsigned)len);
+    } else if (count > 0) {
+        ESP_LOGW(TAG, "Burst upload failed, %u samples %s", count,
+                 telemetry_log_is_enabled() ? "stored" : "dropped");
+        for (size_t offset = 0; offset < used && telemetry_log_is_enabled();) {
+            mqtt_burst_header_t header;
+            memcpy(&header, buf + offset, sizeof(header));
+            offset += sizeof(header);
+            telemetry_log_append(buf + offset, header.len);
+            offset += header.len;
+        }
+    }
+    free(buf);
+}
+
+static void mqtt_cache_listener(const sensor_cache_t *cache, void *ctx)
+{
+    (void)ctx;
+    if (s_publish_task_handle == NULL || s_snapshot_queue == NULL) {
+        return;
+    }
+    bool connected = (s_mqtt_state == MQTT_STATE_CONNECTED);
+    bool store = !connected && telemetry_log_is_enabled();
+    if (store) {
+        mqtt_batch_spill_to_log();
+    }
+
+    // Focus mode: the board under test is not sampled on schedule
+    if (sensor_manager_is_reading_paused()) {
+        return;
+    }
+    // A burst keeps every sample, regardless of interval, deadband or link state
+    if (mqtt_burst_add(cache)) {
+        return;
+    }
+    if (!store && !connected && !mqtt_batch_enabled()) {
+        return;
+    }
+    if (!mqtt_sample_due(cache)) {
+        return;
+    }
+
+    if (!store && !mqtt_batch_enabled()) {
+        mqtt_post_snapshot(cache);
+        return;
+    }
+
+    size_t len = mqtt_pack_sample(cache);
+    if (len == 0) {
+        return;
+    }
+    if (store) {
+        if (telemetry_log_append(s_sample_record, len) != ESP_OK) {
+            mqtt_perf_count_dropped();
+        }
+    } else if (mqtt_batch_add_record(cache->timestamp_us, s_sample_record, len) && connected) {
+        xTaskNotifyGive(s_publish_task_handle);
+    }
+}
+
+/**
+ * @brief Publish a snapshot as JSON on the data topic
+ *
+ * @param unix_time Acquisition time added as "timestamp" (0 to omit)
+ * @return MQTT message id, or -1 on failure
+ */
+static int mqtt_publish_json_snapshot(const sensor_cache_t *cache, uint32_t unix_time)
+{
+    json_writer_t w;
+    json_writer_init(&w, s_json_buffer, sizeof(s_json_buffer), NULL, NULL);
+    
+    // MQTT 5 carries the device in the topic and the time in a user property
+    json_writer_object_begin(&w);
+    if (!s_session_v5) {
+        json_writer_kv_string(&w, "device_id", s_device_id);
+    }
+    json_writer_key(&w, "sensors");
+    telemetry_write_sensors_json(&w, cache);
+    telemetry_write_derived_json(&w, cache);
+    if (cache->battery_valid) {
+        json_writer_kv_float(&w, "battery", cache->battery_percentage);
+    }
+    json_writer_kv_int(&w, "rssi", cache->rssi);
+    if (unix_time != 0 && !s_session_v5) {
+        json_writer_kv_int(&w, "timestamp", unix_time);
+    }
+    json_writer_object_end(&w);
+    
+    esp_err_t err = json_writer_finish(&w);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to render telemetry JSON: %s", esp_err_to_name(err));
+        return -1;
+    }
+    
+    int msg_id = mqtt_publish_tracked(MQTT_TOPIC_DATA, s_json_buffer, (int)json_writer_length(&w),
+                                      cache->timestamp_us, unix_time);
+    if (msg_id >= 0) {
+        trace_log_emit(TRACE_EV_MQTT_PUBLISH, 0, (uint32_t)json_writer_length(&w), (uint32_t)msg_id);
+    }
+    return msg_id;
+}
+
+/**
+ * @brief Publish a snapshot as CBOR on the data/cbor topic
+ *
+ * @param unix_time Acquisition time (0 to omit)
+ * @return MQTT message id, or -1 on failure
+ */
+static int mqtt_publish_cbor_snapshot(const sensor_cache_t *cache, uint32_t unix_time)
+{
+    size_t len = 0;
+    esp_err_t err = telemetry_encode_cbor(s_session_v5 ? NULL : s_device_id, cache, unix_time,
+                                          s_cbor_buffer, sizeof(s_cbor_buffer), &len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to encode CBOR telemetry: %s", esp_err_to_name(err));
+        return -1;
+    }
+    
+    int msg_id = mqtt_publish_tracked(MQTT_TOPIC_DATA_CBOR, (const char *)s_cbor_buffer, (int)len,
+                                      cache->timestamp_us, unix_time);
+    if (msg_id >= 0) {
+        trace_log_emit(TRACE_EV_MQTT_PUBLISH, 1, (uint32_t)len, (uint32_t)msg_id);
+    }
+    return msg_id;
+}
+
+static int mqtt_publish_snapshot(const sensor_cache_t *cache, uint32_t unix_time)
+{
+    return (s_payload_format == MQTT_PAYLOAD_CBOR) ?
+           mqtt_publish_cbor_snapshot(cache, unix_time) :
+           mqtt_publish_json_snapshot(cache, unix_time);
+}
+
+static bool mqtt_batch_due(void)
+{
+    if (s_batch_count == 0) {
+        return false;
+    }
+    if (!mqtt_batch_enabled() || s_batch_flush || s_batch_count >= mqtt_batch_limit()) {
+        return true;
+    }
+    return s_batch_window_sec > 0 &&
+           esp_timer_get_time() - s_batch_first_us >= (int64_t)s_batch_window_sec * 1000000LL;
+}
+
+/**
+ * @brief Time until the batch window of the oldest sample expires
+ */
+static TickType_t mqtt_batch_wait_ticks(void)
+{
+    if (s_batch_count == 0 || s_batch_window_sec == 0) {
+        return portMAX_DELAY;
+    }
+    int64_t remaining_us = s_batch_first_us + (int64_t)s_batch_window_sec * 1000000LL - esp_timer_get_time();
+    return (remaining_us > 0) ? pdMS_TO_TICKS(remaining_us / 1000) + 1 : 0;
+}
+
+static esp_err_t mqtt_count_sink(void *ctx, const char *data, size_t len)
+{
+    (void)data;
+    *(size_t *)ctx += len;
+    return ESP_OK;
+}
+
+/**
+ * @brief Render the first count batch samples as one JSON document
+ *
+ * {"device_id":..., "samples":[{"timestamp":..., "uptime_ms":..., "sensors":{...}, "battery":...}, ...], "rssi":...}
+ */
+static void mqtt_write_batch_json(json_writer_t *w, uint8_t count)
+{
+    int8_t rssi = 0;
+    
+    json_writer_object_begin(w);
+    if (!s_session_v5) {
+        json_writer_kv_string(w, "device_id", s_device_id);
+    }
+    json_writer_key(w, "samples");
+    json_writer_array_begin(w);
+    for (uint8_t i = 0; i < count; i++) {
+        sensor_cache_t cache;
+        uint32_t unix_time = 0;
+        if (telemetry_unpack_snapshot(s_batch[i].data, s_batch[i].len, &cache, &unix_time) != ESP_OK) {
+            continue;
+        }
+        rssi = cache.rssi;
+        json_writer_object_begin(w);
+        if (unix_time != 0) {
+            json_writer_kv_int(w, "timestamp", unix_time);
+        }
+        if (s_batch[i].timestamp_us != 0) {
+            // Samples carried over from an earlier boot have no uptime
+            json_writer_kv_int(w, "uptime_ms", (int64_t)(s_batch[i].timestamp_us / 1000ULL));
+        }
+        json_writer_key(w, "sensors");
+        telemetry_write_sensors_json(w, &cache);
+        telemetry_write_derived_json(w, &cache);
+        if (cache.battery_valid) {
+            json_writer_kv_float(w, "battery", cache.battery_percentage);
+        }
+        json_writer_object_end(w);
+    }
+    json_writer_array_end(w);
+    json_writer_kv_int(w, "rssi", rssi);
+    json_writer_object_end(w);
+}
+
+/**
+ * @brief Encode one packed sample as a CBOR snapshot map
+ *
+ * @param out Output buffer, or NULL to only measure the encoded size
+ */
+static esp_err_t mqtt_encode_record_cbor(uint64_t timestamp_us, const uint8_t *record, size_t record_len,
+                                         uint8_t *out, size_t out_size, size_t *out_len)
+{
+    sensor_cache_t cache;
+    uint32_t unix_time = 0;
+    esp_err_t err = telemetry_unpack_snapshot(record, record_len, &cache, &unix_time);
+    if (err != ESP_OK) {
+        *out_len = 0;
+        return err;
+    }
+    cache.timestamp_us = timestamp_us;
+    return telemetry_encode_cbor(s_session_v5 ? NULL : s_device_id, &cache, unix_time,
+                                 out ? out : s_cbor_buffer, out ? out_size : sizeof(s_cbor_buffer), out_len);
+}
+
+/**
+ * @brief Encode the first count batch samples as a CBOR array of snapshot maps
+ *
+ * @param out Output buffer, or NULL to only measure the encoded size
+ */
+static esp_err_t mqtt_encode_batch_cbor(uint8_t count, uint8_t *out, size_t out_size, size_t *out_len)
+{
+    size_t total = 0;
+    size_t len = 0;
+    
+    esp_err_t err = telemetry_encode_cbor_array(count, out ? out : s_cbor_buffer,
+                                                out ? out_size : sizeof(s_cbor_buffer), &len);
+    total += len;
+    for (uint8_t i = 0; i < count && err == ESP_OK; i++) {
+        err = mqtt_encode_record_cbor(s_batch[i].timestamp_us, s_batch[i].data, s_batch[i].len,
+                                      out ? out + total : NULL, out ? out_size - total : 0, &len);
+        total += len;
+    }
+    
+    *out_len = total;
+    return err;
+}
+
+/**
+ * @brief Publish the collected samples as one message
+ *
+ * The payload is measured first and allocated to size, so large batches do
+ * not need a permanently reserved buffer.
+ */
+static void mqtt_publish_batch(void)
+{
+    xSemaphoreTake(s_batch_mutex, portMAX_DELAY);
+    
+    uint8_t count = s_batch_count;
+    bool cbor = (s_payload_format == MQTT_PAYLOAD_CBOR);
+    size_t len = 0;
+    char *payload = NULL;
+    esp_err_t err;
+    
+    if (cbor) {
+        err = mqtt_encode_batch_cbor(count, NULL, 0, &len);
+        if (err == ESP_OK) {
+            payload = malloc(len);
+            err = (payload != NULL) ? mqtt_encode_batch_cbor(count, (uint8_t *)payload, len, &len) : ESP_ERR_NO_MEM;
+        }
+    } else {
+        json_writer_t w;
+        json_writer_init(&w, s_json_buffer, sizeof(s_json_buffer), mqtt_count_sink, &len);
+        mqtt_write_batch_json(&w, count);
+        err = json_writer_finish(&w);
+        if (err == ESP_OK) {
+            payload = malloc(len + 1);
+            if (payload != NULL) {
+                json_writer_init(&w, payload, len + 1, NULL, NULL);
+                mqtt_write_batch_json(&w, count);
+                err = json_writer_finish(&w);
+                len = json_writer_length(&w);
+            } else {
+                err = ESP_ERR_NO_MEM;
+            }
+        }
+    }
+    
+    xSemaphoreGive(s_batch_mutex);
+    
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to encode batch of %u samples: %s", count, esp_err_to_name(err));
+        free(payload);
+        return;
+    }
+    
+    int64_t enqueue_us = esp_timer_get_time();
+    int msg_id = mqtt_publish_tracked(cbor ? MQTT_TOPIC_BATCH_CBOR : MQTT_TOPIC_BATCH, payload, (int)len, 0, 0);
+    free(payload);
+    if (msg_id < 0) {
+        // Keep the samples; they are retried next cycle or spilled to flash if the link is gone
+        ESP_LOGW(TAG, "Batch publish failed, %u samples kept", count);
+        return;
+    }
+    trace_log_emit(TRACE_EV_MQTT_PUBLISH, 2, (uint32_t)len, (uint32_t)msg_id);
+    
+    xSemaphoreTake(s_batch_mutex, portMAX_DELAY);
+    // Samples added while publishing move to the front and start a new window
+    uint8_t sent = (count <= s_batch_count) ? count : s_batch_count;
+    // Batching delay shows up per sample in snapshot_to_enqueue
+    for (uint8_t i = 0; i < sent; i++) {
+        mqtt_perf_record_snapshot(s_batch[i].timestamp_us, enqueue_us);
+    }
+    memmove(&s_batch[0], &s_batch[sent], (s_batch_count - sent) * sizeof(s_batch[0]));
+    s_batch_count -= sent;
+    s_batch_flush = (s_batch_count > 0) && s_batch_flush;
+    s_batch_first_us = esp_timer_get_time();
+    xSemaphoreGive(s_batch_mutex);
+}
+
+/**
+ * @brief Forget in-flight replays; their records stay pending in the log
+ */
+static void mqtt_replay_reset(void)
+{
+    if (s_replay_mutex == NULL) {
+        return;
+    }
+    if (xSemaphoreTake(s_replay_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        memset(s_replay_slots, 0, sizeof(s_replay_slots));
+        s_replay_cursor = TELEMETRY_LOG_CURSOR_START;
+        xSemaphoreGive(s_replay_mutex);
+    }
+}
+
+/**
+ * @brief PUBACK from the event handler: flag the matching replay as delivered
+ *
+ * The flash update itself is left to the publish task so the MQTT task never
+ * waits on a sector erase.
+ */
+static void mqtt_replay_on_puback(int msg_id)
+{
+    if (s_replay_mutex == NULL || msg_id <= 0) {
+        return;
+    }
+    if (xSemaphoreTake(s_replay_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+        for (int i = 0; i < MQTT_REPLAY_INFLIGHT; i++) {
+            if (s_replay_slots[i].msg_id == msg_id) {
+                s_replay_slots[i].acked = true;
+                break;
+            }
+        }
+        xSemaphoreGive(s_replay_mutex);
+    }
+}
+
+/**
+ * @brief Retire acknowledged replays and send the next batch from the log
+ *
+ * @return true while stored samples remain to be delivered
+ */
+static bool mqtt_replay_service(void)
+{
+    if (!telemetry_log_is_enabled() || s_replay_mutex == NULL) {
+        return false;
+    }
+
+    uint32_t acked[MQTT_REPLAY_INFLIGHT];
+    int acked_count = 0;
+    int free_slots = 0;
+    bool expired = false;
+    int64_t now_us = esp_timer_get_time();
+
+    xSemaphoreTake(s_replay_mutex, portMAX_DELAY);
+    for (int i = 0; i < MQTT_REPLAY_INFLIGHT; i++) {
+        mqtt_replay_slot_t *slot = &s_replay_slots[i];
+        if (slot->msg_id != 0 && slot->acked) {
+            acked[acked_count++] = slot->pos;
+            memset(slot, 0, sizeof(*slot));
+        } else if (slot->msg_id != 0 && now_us - slot->sent_us > MQTT_REPLAY_ACK_TIMEOUT_MS * 1000LL) {
+            expired = true;
+        }
+    }
+    if (expired) {
+        // A PUBACK went missing: rewind so pending records are sent again
+        memset(s_replay_slots, 0, sizeof(s_replay_slots));
+        s_replay_cursor = TELEMETRY_LOG_CURSOR_START;
+    }
+    for (int i = 0; i < MQTT_REPLAY_INFLIGHT; i++) {
+        if (s_replay_slots[i].msg_id == 0) {
+            free_slots++;
+        }
+    }
+    xSemaphoreGive(s_replay_mutex);
+
+    for (int i = 0; i < acked_count; i++) {
+        telemetry_log_ack(acked[i]);
+    }
+    if (expired) {
+        ESP_LOGW(TAG, "Replay acknowledgement timed out, resending stored samples");
+    }
+
+    while (free_slots > 0 && s_mqtt_state == MQTT_STATE_CONNECTED) {
+        uint32_t pos = 0;
+        size_t len = 0;
+        if (telemetry_log_next(&s_replay_cursor, &pos, s_replay_record, sizeof(s_replay_record), &len) != ESP_OK) {
+            break;
+        }
+
+        sensor_cache_t cache;
+        uint32_t unix_time = 0;
+        if (telemetry_unpack_snapshot(s_replay_record, len, &cache, &unix_time) != ESP_OK) {
+            ESP_LOGW(TAG, "Dropping unreadable stored sample");
+            telemetry_log_ack(pos);
+            continue;
+        }
+
+        int msg_id = mqtt_publish_snapshot(&cache, unix_time);
+        if (msg_id <= 0) {
+            // Not queued; rewind and retry on the next pass
+            mqtt_replay_reset();
+            break;
+        }
+
+        xSemaphoreTake(s_replay_mutex, portMAX_DELAY);
+        for (int i = 0; i < MQTT_REPLAY_INFLIGHT; i++) {
+            if (s_replay_slots[i].msg_id == 0) {
+                s_replay_slots[i] = (mqtt_replay_slot_t){
+                    .msg_id = msg_id,
+                    .pos = pos,
+                    .sent_us = esp_timer_get_time(),
+                    .acked = false,
+                };
+                break;
+            }
+        }
+        xSemaphoreGive(s_replay_mutex);
+        free_slots--;
+
+        vTaskDelay(pdMS_TO_TICKS(MQTT_REPLAY_SPACING_MS));
+    }
+
+    return telemetry_log_pending_count() > 0;
+}
+
+/**
+ * @brief Publish device health with the pipeline counters
+ */
+static void mqtt_publish_perf_report(void)
+{
+    telemetry_data_t data = {
+        .uptime_sec = (uint32_t)(esp_timer_get_time() / 1000000),
+        .free_heap = esp_get_free_heap_size(),
+        .min_free_heap = esp_get_minimum_free_heap_size(),
+        .largest_free_block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT),
+        .rssi = 0,
+        .cpu_temp = NAN,
+        .wifi_reconnects = 0,
+        .mqtt_reconnects = s_mqtt_reconnects,
+    };
+    wifi_ap_record_t ap_info;
+    if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+        data.rssi = ap_info.rssi;
+    }
+    if (mqtt_get_perf_stats(&data.mqtt_perf) == ESP_OK) {
+        mqtt_publish_telemetry(&data);
     }
-    // Return 0 if sensor not available (don't send fake data)
-    return 0.0f;
 }
 
 /**
@@ -179,100 +1390,76 @@ static void mqtt_publish_task(void *arg)
 {
     ESP_LOGI(TAG, "MQTT publish task started (interval: %lu seconds)", s_publish_interval_sec);
     
+    bool replaying = false;
+    int64_t next_report_us = esp_timer_get_time() + (int64_t)MQTT_PERF_REPORT_SEC * 1000000;
+    
     while (1) {
-        // Wait for next publish cycle FIRST (before checking conditions)
-        // If interval is 0, wait for notification (triggered by sensor reads)
-        if (s_publish_interval_sec == 0) {
-            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-        } else {
-            vTaskDelay(pdMS_TO_TICKS(s_publish_interval_sec * 1000));
-        }
-        
-        // Only publish if connected to MQTT broker
-        if (s_mqtt_state != MQTT_STATE_CONNECTED) {
-            continue;
-        }
-        
-        // Skip publishing if sensor reading is in progress
-        if (sensor_manager_is_reading_in_progress()) {
-            vTaskDelay(pdMS_TO_TICKS(1000));
-            continue;
-        }
-        
-        // Skip publishing if sensor reading is paused (focus mode active)
-        if (sensor_manager_is_reading_paused()) {
-            vTaskDelay(pdMS_TO_TICKS(1000));
-            continue;
+        // Sleep until the cache listener posts a snapshot, the broker connects or
+        // a setting changes. Only a batch window or a replay in progress adds a timeout.
+        TickType_t wait = mqtt_burst_wait_ticks();
+        if (s_mqtt_state == MQTT_STATE_CONNECTED) {
+            if (mqtt_batch_enabled() || s_batch_count > 0) {
+                TickType_t batch_wait = mqtt_batch_wait_ticks();
+                if (wait == portMAX_DELAY || wait > batch_wait) {
+                    wait = batch_wait;
+                }
+            }
+            if (replaying && (wait == portMAX_DELAY || wait > pdMS_TO_TICKS(MQTT_REPLAY_POLL_MS))) {
+                // Stored samples are drained on a short cadence between live publishes
+                wait = pdMS_TO_TICKS(MQTT_REPLAY_POLL_MS);
+            }
+            int64_t report_in_us = next_report_us - esp_timer_get_time();
+            TickType_t report_wait = (report_in_us > 0) ? pdMS_TO_TICKS(report_in_us / 1000) + 1 : 0;
+            if (wait == portMAX_DELAY || wait > report_wait) {
+                wait = report_wait;
+            }
         }
+        ulTaskNotifyTake(pdTRUE, wait);
         
-        // Get cached sensor data from sensor_manager (non-blocking)
         sensor_cache_t cache;
-        if (sensor_manager_get_cached_data(&cache) != ESP_OK) {
-            ESP_LOGW(TAG, "No cached sensor data available yet");
-            vTaskDelay(pdMS_TO_TICKS(1000));
-            continue;
+        bool have_snapshot = (xQueueReceive(s_snapshot_queue, &cache, 0) == pdTRUE);
+        
+        // A burst ends on time even while offline; its samples then go to the flash log
+        if (mqtt_burst_due()) {
+            mqtt_burst_finish();
         }
         
-        // Create JSON from cached data
-        cJSON *root = cJSON_CreateObject();
-        if (root == NULL) {
-            vTaskDelay(pdMS_TO_TICKS(1000));
+        // Only publish if connected to MQTT broker
+        if (s_mqtt_state != MQTT_STATE_CONNECTED) {
+            replaying = false;
             continue;
         }
         
-        cJSON_AddStringToObject(root, "device_id", s_device_id);
+        json_arena_t *arena = json_arena_begin();
         
-        // Add sensors
-        cJSON *sensors = cJSON_CreateObject();
-        for (uint8_t i = 0; i < cache.sensor_count && i < 8; i++) {
-            cached_sensor_t *sensor = &cache.sensors[i];
-            if (!sensor->valid) continue;
-            
-            if (sensor->value_count == 1) {
-                cJSON_AddNumberToObject(sensors, sensor->sensor_type, sensor->values[0]);
-            } else if (sensor->value_count > 1) {
-                cJSON *sensor_obj = cJSON_CreateObject();
-                if (strcmp(sensor->sensor_type, "HUM") == 0) {
-                    if (sensor->value_count >= 1) cJSON_AddNumberToObject(sensor_obj, "humidity", sensor->values[0]);
-                    if (sensor->value_count >= 2) cJSON_AddNumberToObject(sensor_obj, "air_temp", sensor->values[1]);
-                    if (sensor->value_count >= 3) cJSON_AddNumberToObject(sensor_obj, "dew_point", sensor->values[2]);
-                } else if (strcmp(sensor->sensor_type, "EC") == 0) {
-                    if (sensor->value_count >= 1) cJSON_AddNumberToObject(sensor_obj, "conductivity", sensor->values[0]);
-                    if (sensor->value_count >= 2) cJSON_AddNumberToObject(sensor_obj, "tds", sensor->values[1]);
-                    if (sensor->value_count >= 3) cJSON_AddNumberToObject(sensor_obj, "salinity", sensor->values[2]);
-                } else if (strcmp(sensor->sensor_type, "DO") == 0) {
-                    if (sensor->value_count >= 1) cJSON_AddNumberToObject(sensor_obj, "dissolved_oxygen", sensor->values[0]);
-                    if (sensor->value_count >= 2) cJSON_AddNumberToObject(sensor_obj, "saturation", sensor->values[1]);
-                }
-                cJSON_AddItemToObject(sensors, sensor->sensor_type, sensor_obj);
-            }
+        if (have_snapshot && mqtt_publish_snapshot(&cache, mqtt_unix_time()) >= 0) {
+            mqtt_deadband_mark_published(&cache);
         }
-        cJSON_AddItemToObject(root, "sensors", sensors);
         
-        // Add battery
-        if (cache.battery_valid) {
-            cJSON_AddNumberToObject(root, "battery", cache.battery_percentage);
+        // Batching mode: samples are collected by the cache listener
+        if (mqtt_batch_due()) {
+            mqtt_publish_batch();
         }
         
-        // Add RSSI
-        cJSON_AddNumberToObject(root, "rssi", cache.rssi);
-        
-        // Serialize and publish
-        char *json_str = cJSON_PrintUnformatted(root);
-        cJSON_Delete(root);
+        replaying = mqtt_replay_service();
         
-        if (json_str != NULL) {
-            ESP_LOGI(TAG, "Publishing JSON: %s", json_str);
-            
-            char topic[128];
-            snprintf(topic, sizeof(topic), "kannacloud/sensor/%s/data", s_device_id);
-            
-            int msg_id = esp_mqtt_client_publish(s_mqtt_client, topic, json_str, 0, 1, 0);
-            if (msg_id >= 0) {
-                ESP_LOGI(TAG, "✓ MQTT data published successfully");
-            }
-            free(json_str);
+        if (esp_timer_get_time() >= next_report_us) {
+            next_report_us = esp_timer_get_time() + (int64_t)MQTT_PERF_REPORT_SEC * 1000000;
+            mqtt_publish_perf_report();
         }
+        json_arena_end(arena);
+    }
+}
+
+/**
+ * @brief Re-arm the publish task: a leftover batch is flushed when batching is switched off
+ */
+static void mqtt_batch_setting_changed(setting_id_t id, void *ctx)
+{
+    (void)id;
+    (void)ctx;
+    if (s_publish_task_handle != NULL) {
+        xTaskNotifyGive(s_publish_task_handle);
     }
 }
 
@@ -283,27 +1470,53 @@ esp_err_t mqtt_client_init(const char *broker_uri, const char *username, const c
         return ESP_OK;
     }
     
-    // Load saved MQTT interval from NVS
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open("settings", NVS_READONLY, &nvs_handle);
-    if (err == ESP_OK) {
-        uint32_t saved_interval = 10; // Default
-        err = nvs_get_u32(nvs_handle, "mqtt_interval", &saved_interval);
-        if (err == ESP_OK) {
-            s_publish_interval_sec = saved_interval;
-            ESP_LOGI(TAG, "Loaded MQTT interval from NVS: %lu seconds", saved_interval);
-        } else {
-            ESP_LOGW(TAG, "Failed to load MQTT interval from NVS: %s, using default %lu", esp_err_to_name(err), saved_interval);
-            s_publish_interval_sec = saved_interval;
-        }
-        nvs_close(nvs_handle);
-    } else {
-        ESP_LOGW(TAG, "Failed to open NVS for MQTT interval: %s, using default 10", esp_err_to_name(err));
-        s_publish_interval_sec = 10;
+    // Saved settings were loaded by settings_store_init()
+    s_publish_interval_sec = settings_store_get_u32(SETTING_MQTT_INTERVAL);
+    ESP_LOGI(TAG, "MQTT interval: %lu seconds", s_publish_interval_sec);
+    
+    // Load deadband filter settings
+    if (s_deadband_mutex == NULL) {
+        s_deadband_mutex = xSemaphoreCreateMutex();
+    }
+    if (s_replay_mutex == NULL) {
+        s_replay_mutex = xSemaphoreCreateMutex();
+    }
+    if (s_batch_mutex == NULL) {
+        s_batch_mutex = xSemaphoreCreateMutex();
+    }
+    if (s_perf_mutex == NULL) {
+        s_perf_mutex = xSemaphoreCreateMutex();
+    }
+    if (s_publish_mutex == NULL) {
+        s_publish_mutex = xSemaphoreCreateMutex();
+    }
+    
+    // Offline store-and-forward (no-op without a "tlog" partition)
+    telemetry_log_init();
+    size_t size = sizeof(s_deadbands);
+    if (settings_store_get_blob(SETTING_MQTT_DEADBANDS, s_deadbands, &size) == ESP_OK &&
+        size % sizeof(mqtt_deadband_t) == 0) {
+        s_deadband_count = size / sizeof(mqtt_deadband_t);
+    }
+    s_payload_format = (mqtt_payload_format_t)settings_store_get_u32(SETTING_MQTT_FORMAT);
+    s_heartbeat_sec = settings_store_get_u32(SETTING_MQTT_HEARTBEAT);
+    s_batch_size = (uint8_t)settings_store_get_u32(SETTING_MQTT_BATCH_SIZE);
+    s_batch_window_sec = settings_store_get_u32(SETTING_MQTT_BATCH_WINDOW);
+    s_protocol_v5 = settings_store_get_u32(SETTING_MQTT_V5) != 0;
+    settings_store_add_listener(SETTING_MQTT_BATCH_SIZE, mqtt_batch_setting_changed, NULL);
+    settings_store_add_listener(SETTING_MQTT_BATCH_WINDOW, mqtt_batch_setting_changed, NULL);
+    if (mqtt_batch_enabled()) {
+        ESP_LOGI(TAG, "Batched publishing enabled (%u samples, %lu s window)",
+                 mqtt_batch_limit(), s_batch_window_sec);
+    }
+    if (s_deadband_count > 0) {
+        ESP_LOGI(TAG, "Deadband publishing enabled (%u channels, heartbeat %lu s)",
+                 s_deadband_count, s_heartbeat_sec);
     }
     
     // Get device ID from cloud provisioning
     cloud_prov_get_device_id(s_device_id, sizeof(s_device_id));
+    mqtt_build_topics();
     
     ESP_LOGI(TAG, "Initializing MQTT client");
     ESP_LOGI(TAG, "Broker URI: %s", broker_uri);
@@ -323,46 +1536,35 @@ esp_err_t mqtt_client_init(const char *broker_uri, const char *username, const c
         .credentials.authentication.password = password,
         .session.keepalive = 60,
         .session.disable_clean_session = false,
-        .network.reconnect_timeout_ms = 10000,
+        .network.disable_auto_reconnect = true,   // Reconnects are paced by mqtt_schedule_reconnect()
         .network.timeout_ms = 10000,
         .buffer.size = 2048,
         .buffer.out_size = 2048,
+        .task.priority = task_profile_get(TASK_PROFILE_MQTT_CLIENT)->priority,
+        .task.stack_size = task_profile_get(TASK_PROFILE_MQTT_CLIENT)->stack,
     };
     
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    if (s_protocol_v5) {
+        mqtt_cfg.session.protocol_ver = MQTT_PROTOCOL_V_5;
+        ESP_LOGI(TAG, "Using MQTT 5 (topic aliases, %u s message expiry)", MQTT_V5_MESSAGE_EXPIRY_SEC);
+    }
+    s_session_v5 = s_protocol_v5;
+#endif
+    
     // Add TLS configuration for secure connections
     if (is_secure) {
         ESP_LOGI(TAG, "Configuring MQTTS with TLS encryption");
         
-        // Load CA certificate from NVS into static buffer
+        // esp-mqtt keeps this pointer, so it must be the cache view, not a stack copy
+        const char *ca_cert = NULL;
         size_t ca_cert_len = 0;
-        esp_err_t ret = cloud_prov_get_mqtt_ca_cert(s_mqtt_ca_cert, &ca_cert_len);
+        esp_err_t ret = cloud_prov_credential_get(CLOUD_PROV_CRED_MQTT_CA, &ca_cert, &ca_cert_len);
         
         if (ret == ESP_OK && ca_cert_len > 0) {
-            ESP_LOGI(TAG, "Loaded CA certificate for MQTTS (%zu bytes)", ca_cert_len);
-            
-            // Log first and last parts of certificate for verification
-            char preview_start[150];
-            char preview_end[150];
-            size_t preview_len = ca_cert_len < 149 ? ca_cert_len : 149;
-            memcpy(preview_start, s_mqtt_ca_cert, preview_len);
-            preview_start[preview_len] = '\0';
-            
-            if (ca_cert_len > 149) {
-                size_t end_offset = ca_cert_len - 100;
-                memcpy(preview_end, s_mqtt_ca_cert + end_offset, 100);
-                preview_end[100] = '\0';
-            }
-            
-            ESP_LOGI(TAG, "Certificate START: %s", preview_start);
-            if (ca_cert_len > 149) {
-                ESP_LOGI(TAG, "Certificate END: %s", preview_end);
-            }
-            ESP_LOGI(TAG, "Certificate null-terminated: %s", (s_mqtt_ca_cert[ca_cert_len] == '\0') ? "YES" : "NO");
-            
-            // The certificate must be null-terminated for mbedTLS
-            s_mqtt_ca_cert[ca_cert_len] = '\0';
+            ESP_LOGI(TAG, "Using cached CA certificate for MQTTS (%zu bytes)", ca_cert_len);
             
-            mqtt_cfg.broker.verification.certificate = s_mqtt_ca_cert;
+            mqtt_cfg.broker.verification.certificate = ca_cert;
             mqtt_cfg.broker.verification.certificate_len = ca_cert_len + 1; // Include null terminator
             ESP_LOGI(TAG, "✓ TLS encryption enabled with CA certificate verification");
         } else {
@@ -401,37 +1603,41 @@ esp_err_t mqtt_client_start(void)
     ESP_LOGI(TAG, "Starting MQTT client...");
     s_mqtt_state = MQTT_STATE_CONNECTING;
     
+    if (s_reconnect_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = mqtt_reconnect_timer_cb,
+            .name = "mqtt_reconnect",
+        };
+        if (esp_timer_create(&timer_args, &s_reconnect_timer) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create reconnect timer");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    s_backoff_ms = MQTT_BACKOFF_MIN_MS;
+    s_client_running = true;
+    s_disconnected_at_us = esp_timer_get_time();   // First connect counts as a reconnect sample
+    
     esp_err_t ret = esp_mqtt_client_start(s_mqtt_client);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to start MQTT client: %s", esp_err_to_name(ret));
         s_mqtt_state = MQTT_STATE_ERROR;
+        s_client_running = false;
         return ret;
     }
     
+    if (s_snapshot_queue == NULL) {
+        s_snapshot_queue = xQueueCreate(1, sizeof(sensor_cache_t));
+        if (s_snapshot_queue == NULL) {
+            ESP_LOGE(TAG, "Failed to create snapshot queue");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
     // Create MQTT publish task
     if (s_publish_task_handle == NULL) {
-#ifdef CONFIG_FREERTOS_UNICORE
-        // Single core (ESP32-C6): Run on core 0
-        BaseType_t task_ret = xTaskCreate(
-            mqtt_publish_task,
-            "mqtt_publish",
-            4096,
-            NULL,
-            5,
-            &s_publish_task_handle
-        );
-#else
-        // Dual core (ESP32-S3): Pin to core 0 (network core)
-        BaseType_t task_ret = xTaskCreatePinnedToCore(
-            mqtt_publish_task,
-            "mqtt_publish",
-            4096,
-            NULL,
-            5,
-            &s_publish_task_handle,
-            0  // Pin to Core 0 (network core)
-        );
-#endif
+        // Network core on dual-core targets (see task_profile.c)
+        BaseType_t task_ret = task_profile_create(TASK_PROFILE_MQTT_PUBLISH, mqtt_publish_task, NULL, NULL,
+                                                  &s_publish_task_handle);
         
         if (task_ret != pdPASS) {
             ESP_LOGE(TAG, "Failed to create MQTT publish task");
@@ -441,6 +1647,8 @@ esp_err_t mqtt_client_start(void)
         ESP_LOGI(TAG, "✓ MQTT publish task started (publish interval: %lu seconds)", s_publish_interval_sec);
     }
     
+    sensor_manager_register_cache_listener(mqtt_cache_listener, NULL);
+    
     return ESP_OK;
 }
 
@@ -450,6 +1658,14 @@ esp_err_t mqtt_client_stop(void)
         return ESP_OK;
     }
     
+    sensor_manager_unregister_cache_listener(mqtt_cache_listener);
+    sensor_manager_stop_burst();
+    
+    s_client_running = false;
+    if (s_reconnect_timer != NULL) {
+        esp_timer_stop(s_reconnect_timer);
+    }
+    
     // Stop MQTT publish task
     if (s_publish_task_handle != NULL) {
         vTaskDelete(s_publish_task_handle);
@@ -496,6 +1712,110 @@ mqtt_state_t mqtt_get_state(void)
 
 
 
+esp_err_t mqtt_get_perf_stats(mqtt_perf_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!mqtt_perf_lock()) {
+        return ESP_ERR_TIMEOUT;
+    }
+    *stats = s_perf;
+    stats->inflight = 0;
+    for (int i = 0; i < MQTT_PERF_TRACKED_SENDS; i++) {
+        if (s_sent[i].msg_id != 0) {
+            stats->inflight++;
+        }
+    }
+    xSemaphoreGive(s_perf_mutex);
+    
+    stats->outbox_bytes = (s_mqtt_client != NULL) ? esp_mqtt_client_get_outbox_size(s_mqtt_client) : 0;
+    return ESP_OK;
+}
+
+esp_err_t mqtt_add_packed_sample(const uint8_t *record, size_t len)
+{
+    if (record == NULL || len == 0 || len > TELEMETRY_PACKED_MAX_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_batch_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // No esp_timer time: the sample was taken before this boot
+    mqtt_batch_add_record(0, record, len);
+    return ESP_OK;
+}
+
+esp_err_t mqtt_flush(uint32_t timeout_ms)
+{
+    if (s_mqtt_client == NULL || s_publish_task_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    s_batch_flush = true;
+    xTaskNotifyGive(s_publish_task_handle);
+    
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (esp_timer_get_time() < deadline_us) {
+        mqtt_perf_stats_t stats;
+        if (s_mqtt_state == MQTT_STATE_CONNECTED && s_batch_count == 0 &&
+            uxQueueMessagesWaiting(s_snapshot_queue) == 0 &&
+            mqtt_get_perf_stats(&stats) == ESP_OK && stats.inflight == 0) {
+            return ESP_OK;
+        }
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    return ESP_ERR_TIMEOUT;
+}
+
+void mqtt_reset_perf_stats(void)
+{
+    if (mqtt_perf_lock()) {
+        memset(&s_perf, 0, sizeof(s_perf));
+        xSemaphoreGive(s_perf_mutex);
+    }
+}
+
+static void mqtt_write_hist_json(json_writer_t *w, const char *key, const mqtt_latency_hist_t *hist)
+{
+    json_writer_key(w, key);
+    json_writer_object_begin(w);
+    json_writer_kv_int(w, "count", hist->count);
+    json_writer_kv_int(w, "max_ms", hist->max_ms);
+    json_writer_kv_number(w, "mean_ms", hist->count > 0 ? (double)hist->sum_ms / hist->count : 0.0);
+    json_writer_key(w, "buckets");
+    json_writer_array_begin(w);
+    for (int i = 0; i < MQTT_LATENCY_BUCKETS; i++) {
+        json_writer_int(w, hist->buckets[i]);
+    }
+    json_writer_array_end(w);
+    json_writer_object_end(w);
+}
+
+void mqtt_write_perf_json(json_writer_t *w, const mqtt_perf_stats_t *stats)
+{
+    json_writer_object_begin(w);
+    // Upper bucket bounds; the last bucket is open-ended
+    json_writer_key(w, "bounds_ms");
+    json_writer_array_begin(w);
+    for (int i = 0; i < MQTT_LATENCY_BUCKETS - 1; i++) {
+        json_writer_int(w, s_latency_bounds_ms[i]);
+    }
+    json_writer_array_end(w);
+    mqtt_write_hist_json(w, "snapshot_to_enqueue", &stats->snapshot_to_enqueue);
+    mqtt_write_hist_json(w, "enqueue_to_send", &stats->enqueue_to_send);
+    mqtt_write_hist_json(w, "send_to_ack", &stats->send_to_ack);
+    mqtt_write_hist_json(w, "reconnect", &stats->reconnect);
+    json_writer_kv_int(w, "messages_sent", stats->messages_sent);
+    json_writer_kv_int(w, "bytes_sent", (int64_t)stats->bytes_sent);
+    json_writer_kv_int(w, "publish_failures", stats->publish_failures);
+    json_writer_kv_int(w, "samples_dropped", stats->samples_dropped);
+    json_writer_kv_int(w, "acks_untracked", stats->acks_untracked);
+    json_writer_kv_int(w, "inflight", stats->inflight);
+    json_writer_kv_int(w, "outbox_bytes", stats->outbox_bytes);
+    json_writer_object_end(w);
+}
+
 esp_err_t mqtt_publish_telemetry(const telemetry_data_t *data)
 {
     if (s_mqtt_client == NULL || s_mqtt_state != MQTT_STATE_CONNECTED) {
@@ -506,36 +1826,48 @@ esp_err_t mqtt_publish_telemetry(const telemetry_data_t *data)
         return ESP_ERR_INVALID_ARG;
     }
     
-    // Create JSON payload
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
+    // Histograms and the CPU, boot, memory and acquisition summaries make this larger than a sensor payload
+    size_t size = MQTT_JSON_MAX_SIZE * 3;
+    char *json_str = malloc(size);
+    if (json_str == NULL) {
         return ESP_ERR_NO_MEM;
     }
     
-    cJSON_AddNumberToObject(root, "uptime", data->uptime_sec);
-    cJSON_AddNumberToObject(root, "free_heap", data->free_heap);
-    cJSON_AddNumberToObject(root, "rssi", data->rssi);
-    cJSON_AddNumberToObject(root, "cpu_temp", data->cpu_temp);
-    cJSON_AddNumberToObject(root, "wifi_reconnects", data->wifi_reconnects);
-    cJSON_AddNumberToObject(root, "mqtt_reconnects", data->mqtt_reconnects);
-    
-    // Add timestamp
     struct timeval tv;
     gettimeofday(&tv, NULL);
-    cJSON_AddNumberToObject(root, "timestamp", tv.tv_sec);
-    
-    char *json_str = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
     
-    if (json_str == NULL) {
+    json_writer_t w;
+    json_writer_init(&w, json_str, size, NULL, NULL);
+    json_writer_object_begin(&w);
+    json_writer_kv_int(&w, "uptime", data->uptime_sec);
+    json_writer_kv_int(&w, "free_heap", data->free_heap);
+    json_writer_kv_int(&w, "min_free_heap", data->min_free_heap);
+    json_writer_kv_int(&w, "largest_free_block", data->largest_free_block);
+    json_writer_kv_int(&w, "rssi", data->rssi);
+    json_writer_kv_float(&w, "cpu_temp", data->cpu_temp);
+    json_writer_kv_int(&w, "wifi_reconnects", data->wifi_reconnects);
+    json_writer_kv_int(&w, "mqtt_reconnects", data->mqtt_reconnects);
+    json_writer_kv_int(&w, "timestamp", tv.tv_sec);
+    json_writer_key(&w, "mqtt_perf");
+    mqtt_write_perf_json(&w, &data->mqtt_perf);
+    json_writer_key(&w, "cpu");
+    perf_monitor_write_json(&w, false);
+    json_writer_key(&w, "boot");
+    boot_profile_write_json(&w, false);
+    json_writer_key(&w, "memory");
+    mem_monitor_write_json(&w, false);
+    json_writer_key(&w, "acquisition");
+    acq_stats_write_json(&w, false);
+    json_writer_key(&w, "i2c");
+    i2c_scanner_write_health_json(&w);
+    json_writer_object_end(&w);
+    
+    if (json_writer_finish(&w) != ESP_OK) {
+        free(json_str);
         return ESP_ERR_NO_MEM;
     }
     
-    // Publish to telemetry topic
-    char topic[128];
-    snprintf(topic, sizeof(topic), "devices/%s/telemetry", s_device_id);
-    
-    int msg_id = esp_mqtt_client_publish(s_mqtt_client, topic, json_str, 0, 1, 0);
+    int msg_id = mqtt_publish_tracked(MQTT_TOPIC_TELEMETRY, json_str, (int)json_writer_length(&w), 0, 0);
     free(json_str);
     
     if (msg_id < 0) {
@@ -556,122 +1888,73 @@ esp_err_t mqtt_publish_kannacloud_data(const kannacloud_data_t *data)
     if (data == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
-    
-    // Create JSON payload following KannaCloud format
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        return ESP_ERR_NO_MEM;
+    if (strcmp(data->device_id, s_device_id) != 0) {
+        // The broker session, and with it the topic alias, belongs to this device
+        ESP_LOGE(TAG, "KannaCloud data for foreign device %s", data->device_id);
+        return ESP_ERR_INVALID_ARG;
     }
     
-    // Add device_id (required)
-    cJSON_AddStringToObject(root, "device_id", data->device_id);
+    // Render JSON payload following KannaCloud format
+    char json_str[MQTT_JSON_MAX_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, json_str, sizeof(json_str), NULL, NULL);
     
-    // Add sensors object - read all EZO sensors dynamically
-    cJSON *sensors = cJSON_CreateObject();
-    if (sensors == NULL) {
-        cJSON_Delete(root);
-        return ESP_ERR_NO_MEM;
+    json_writer_object_begin(&w);
+    
+    // Add device_id (required; MQTT 5 carries it in the topic)
+    if (!s_session_v5) {
+        json_writer_kv_string(&w, "device_id", data->device_id);
     }
     
-    uint8_t sensor_count = sensor_manager_get_ezo_count();
-    for (uint8_t i = 0; i < sensor_count; i++) {
-        char sensor_type[16];
-        float values[4];
-        uint8_t value_count;
-        
-        if (sensor_manager_read_ezo_sensor(i, sensor_type, values, &value_count) == ESP_OK) {
-            if (value_count == 1) {
-                // Single value sensor
-                cJSON_AddNumberToObject(sensors, sensor_type, values[0]);
-            } else if (value_count > 1) {
-                // Multi-value sensor - create object with named fields
-                cJSON *sensor_obj = cJSON_CreateObject();
-                
-                // Define field names based on sensor type
-                if (strcmp(sensor_type, "HUM") == 0) {
-                    // Get HUM sensor config to determine which parameters are enabled
-                    ezo_sensor_t *sensor = (ezo_sensor_t *)sensor_manager_get_ezo_sensor(i);
-                    if (sensor != NULL && sensor->config.hum.param_count > 0) {
-                        // Use dynamic parameter mapping based on enabled outputs
-                        for (uint8_t j = 0; j < value_count && j < sensor->config.hum.param_count; j++) {
-                            const char *param = sensor->config.hum.param_order[j];
-                            const char *field_name = NULL;
-                            
-                            if (strcmp(param, "HUM") == 0) {
-                                field_name = "humidity";
-                            } else if (strcmp(param, "T") == 0) {
-                                field_name = "air_temp";
-                            } else if (strcmp(param, "DEW") == 0) {
-                                field_name = "dew_point";
-                            }
-                            
-                            if (field_name != NULL) {
-                                cJSON_AddNumberToObject(sensor_obj, field_name, values[j]);
-                            }
-                        }
-                    } else {
-                        // Fallback if config unavailable
-                        if (value_count >= 1) cJSON_AddNumberToObject(sensor_obj, "humidity", values[0]);
-                        if (value_count >= 2) cJSON_AddNumberToObject(sensor_obj, "air_temp", values[1]);
-                        if (value_count >= 3) cJSON_AddNumberToObject(sensor_obj, "dew_point", values[2]);
-                    }
-                } else if (strcmp(sensor_type, "ORP") == 0) {
-                    if (value_count >= 1) cJSON_AddNumberToObject(sensor_obj, "orp", values[0]);
-                } else if (strcmp(sensor_type, "DO") == 0) {
-                    if (value_count >= 1) cJSON_AddNumberToObject(sensor_obj, "dissolved_oxygen", values[0]);
-                    if (value_count >= 2) cJSON_AddNumberToObject(sensor_obj, "saturation", values[1]);
-                } else if (strcmp(sensor_type, "EC") == 0) {
-                    if (value_count >= 1) cJSON_AddNumberToObject(sensor_obj, "conductivity", values[0]);
-                    if (value_count >= 2) cJSON_AddNumberToObject(sensor_obj, "tds", values[1]);
-                    if (value_count >= 3) cJSON_AddNumberToObject(sensor_obj, "salinity", values[2]);
-                    if (value_count >= 4) cJSON_AddNumberToObject(sensor_obj, "specific_gravity", values[3]);
-                } else {
-                    // Unknown multi-value sensor - use generic field names
-                    for (uint8_t j = 0; j < value_count; j++) {
-                        char field_name[16];
-                        snprintf(field_name, sizeof(field_name), "value_%d", j);
-                        cJSON_AddNumberToObject(sensor_obj, field_name, values[j]);
-                    }
-                }
-                
-                cJSON_AddItemToObject(sensors, sensor_type, sensor_obj);
-            }
+    // Add sensors object - read all EZO sensors dynamically
+    json_writer_key(&w, "sensors");
+    json_writer_object_begin(&w);
+    
+    // Values come from the last completed sensor cycle; publishing never touches the bus
+    sensor_cache_t cache;
+    if (sensor_manager_get_cached_data(&cache) != ESP_OK) {
+        cache.sensor_count = 0;
+    }
+    for (uint8_t i = 0; i < cache.sensor_count && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
+        const cached_sensor_t *cached = &cache.sensors[i];
+        if (!cached->valid) {
+            continue;
         }
+        // Names follow the board's channel map (HUM reports only its enabled outputs)
+        const char *names[MAX_SENSOR_VALUES];
+        bool named = telemetry_sensor_names(cached, names);
+        char key[24];
+        telemetry_write_keyed_sensor_json(&w, telemetry_sensor_key(&cache, i, key, sizeof(key)),
+                                          cached->sensor_type, cached->values, cached->value_count,
+                                          named ? names : NULL);
     }
     
-    cJSON_AddItemToObject(root, "sensors", sensors);
+    json_writer_object_end(&w);
+    telemetry_write_derived_json(&w, &cache);
     
     // Add battery level (optional)
     if (!isnan(data->battery)) {
-        cJSON_AddNumberToObject(root, "battery", data->battery);
+        json_writer_kv_float(&w, "battery", data->battery);
     }
     
     // Add RSSI
-    cJSON_AddNumberToObject(root, "rssi", data->rssi);
-    
-    char *json_str = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
+    json_writer_kv_int(&w, "rssi", data->rssi);
+    json_writer_object_end(&w);
     
-    if (json_str == NULL) {
+    if (json_writer_finish(&w) != ESP_OK) {
         return ESP_ERR_NO_MEM;
     }
     
-    // Debug: Log the exact JSON being published
-    ESP_LOGI(TAG, "Publishing JSON: %s", json_str);
-    
     // Publish to KannaCloud topic: kannacloud/sensor/{device_id}/data
-    char topic[128];
-    snprintf(topic, sizeof(topic), "kannacloud/sensor/%s/data", data->device_id);
-    
-    int msg_id = esp_mqtt_client_publish(s_mqtt_client, topic, json_str, 0, 1, 0); // QoS 1
-    free(json_str);
+    int msg_id = mqtt_publish_tracked(MQTT_TOPIC_DATA, json_str, (int)json_writer_length(&w),
+                                      cache.timestamp_us, mqtt_unix_time()); // QoS 1
     
     if (msg_id < 0) {
         ESP_LOGE(TAG, "Failed to publish KannaCloud data");
         return ESP_FAIL;
     }
     
-    ESP_LOGD(TAG, "KannaCloud data published to %s (msg_id: %d)", topic, msg_id);
+    trace_log_emit(TRACE_EV_MQTT_PUBLISH, 0, (uint32_t)json_writer_length(&w), (uint32_t)msg_id);
     return ESP_OK;
 }
 
@@ -709,8 +1992,8 @@ esp_err_t mqtt_publish_status(const char *status)
     char topic[128];
     snprintf(topic, sizeof(topic), "devices/%s/status", s_device_id);
     
-    int msg_id = esp_mqtt_client_publish(s_mqtt_client, topic, json_str, 0, 1, 1); // QoS 1, Retain
-    free(json_str);
+    int msg_id = mqtt_publish_plain(topic, json_str, 1, 1); // QoS 1, Retain
+    cJSON_free(json_str);
     
     if (msg_id < 0) {
         ESP_LOGE(TAG, "Failed to publish status");
@@ -731,7 +2014,7 @@ esp_err_t mqtt_publish_json(const char *topic, const char *json_data, int qos, b
         return ESP_ERR_INVALID_ARG;
     }
     
-    int msg_id = esp_mqtt_client_publish(s_mqtt_client, topic, json_data, 0, qos, retain ? 1 : 0);
+    int msg_id = mqtt_publish_plain(topic, json_data, qos, retain ? 1 : 0);
     if (msg_id < 0) {
         ESP_LOGE(TAG, "Failed to publish to %s", topic);
         return ESP_FAIL;
@@ -741,6 +2024,33 @@ esp_err_t mqtt_publish_json(const char *topic, const char *json_data, int qos, b
     return ESP_OK;
 }
 
+esp_err_t mqtt_publish_alert(const char *json_data, size_t len)
+{
+    if (s_mqtt_client == NULL || s_topics[MQTT_TOPIC_ALERT][0] == '\0') {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (json_data == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // MQTT 5 publish properties stick to the client until the data publish clears them
+    if (s_session_v5 && xSemaphoreTake(s_publish_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+        ESP_LOGW(TAG, "Alert dropped: client busy with a data publish");
+        return ESP_ERR_TIMEOUT;
+    }
+    int msg_id = esp_mqtt_client_enqueue(s_mqtt_client, s_topics[MQTT_TOPIC_ALERT], json_data, (int)len, 1, 0, true);
+    if (s_session_v5) {
+        xSemaphoreGive(s_publish_mutex);
+    }
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Failed to queue alert");
+        return ESP_FAIL;
+    }
+    
+    ESP_LOGI(TAG, "Alert queued (msg_id: %d)", msg_id);
+    return ESP_OK;
+}
+
 esp_err_t mqtt_subscribe(const char *topic, int qos)
 {
     if (s_mqtt_client == NULL || s_mqtt_state != MQTT_STATE_CONNECTED) {
@@ -783,41 +2093,16 @@ esp_err_t mqtt_unsubscribe(const char *topic)
 
 esp_err_t mqtt_set_telemetry_interval(uint32_t interval_sec)
 {
-    uint32_t old_interval = s_publish_interval_sec;
     s_publish_interval_sec = interval_sec;
     
+    // Takes effect at the next completed sensor cycle; the publisher has no timer to re-arm
     if (interval_sec == 0) {
-        ESP_LOGI(TAG, "MQTT periodic publishing disabled (will publish on sensor read only)");
+        ESP_LOGI(TAG, "MQTT publishing on every sensor cycle");
     } else {
         ESP_LOGI(TAG, "MQTT publish interval updated to %lu seconds", interval_sec);
-        
-        // If changing from 0 to non-zero, wake up the task so it starts periodic publishing
-        if (old_interval == 0 && s_publish_task_handle != NULL) {
-            ESP_LOGI(TAG, "Waking up MQTT task to start periodic publishing");
-            xTaskNotifyGive(s_publish_task_handle);
-        }
-    }
-    
-    // Save to NVS
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open("settings", NVS_READWRITE, &nvs_handle);
-    if (err == ESP_OK) {
-        err = nvs_set_u32(nvs_handle, "mqtt_interval", interval_sec);
-        if (err == ESP_OK) {
-            err = nvs_commit(nvs_handle);
-            if (err == ESP_OK) {
-                ESP_LOGI(TAG, "MQTT interval %lu saved to NVS", interval_sec);
-            } else {
-                ESP_LOGE(TAG, "Failed to commit MQTT interval to NVS: %s", esp_err_to_name(err));
-            }
-        } else {
-            ESP_LOGE(TAG, "Failed to set MQTT interval in NVS: %s", esp_err_to_name(err));
-        }
-        nvs_close(nvs_handle);
-    } else {
-        ESP_LOGE(TAG, "Failed to open NVS for MQTT interval: %s", esp_err_to_name(err));
     }
     
+    settings_store_set_u32(SETTING_MQTT_INTERVAL, interval_sec);
     return ESP_OK;
 }
 
@@ -828,15 +2113,143 @@ uint32_t mqtt_get_telemetry_interval(void)
 
 esp_err_t mqtt_trigger_immediate_publish(void)
 {
-    if (s_publish_task_handle == NULL) {
+    if (s_publish_task_handle == NULL || s_snapshot_queue == NULL) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    // Wake up the publish task
-    xTaskNotifyGive(s_publish_task_handle);
+    sensor_cache_t cache;
+    if (sensor_manager_get_cached_data(&cache) != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    mqtt_post_snapshot(&cache);
+    return ESP_OK;
+}
+
+esp_err_t mqtt_set_deadbands(const mqtt_deadband_t *entries, uint8_t count)
+{
+    if (count > MQTT_DEADBAND_MAX_CHANNELS || (count > 0 && entries == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_deadband_mutex == NULL) {
+        s_deadband_mutex = xSemaphoreCreateMutex();
+        if (s_deadband_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    xSemaphoreTake(s_deadband_mutex, portMAX_DELAY);
+    if (count > 0) {
+        memcpy(s_deadbands, entries, count * sizeof(mqtt_deadband_t));
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        s_deadbands[i].sensor_type[sizeof(s_deadbands[i].sensor_type) - 1] = '\0';
+    }
+    s_deadband_count = count;
+    xSemaphoreGive(s_deadband_mutex);
+    
+    if (count == 0) {
+        ESP_LOGI(TAG, "Deadband publishing disabled");
+    } else {
+        ESP_LOGI(TAG, "Deadband publishing enabled (%u channels)", count);
+    }
+    
+    // An empty table erases the saved one
+    xSemaphoreTake(s_deadband_mutex, portMAX_DELAY);
+    settings_store_set_blob(SETTING_MQTT_DEADBANDS, s_deadbands, count * sizeof(mqtt_deadband_t));
+    xSemaphoreGive(s_deadband_mutex);
+    return ESP_OK;
+}
+
+uint8_t mqtt_get_deadbands(mqtt_deadband_t *entries, uint8_t max_entries)
+{
+    if (entries == NULL || s_deadband_mutex == NULL) {
+        return 0;
+    }
+    
+    xSemaphoreTake(s_deadband_mutex, portMAX_DELAY);
+    uint8_t count = s_deadband_count < max_entries ? s_deadband_count : max_entries;
+    memcpy(entries, s_deadbands, count * sizeof(mqtt_deadband_t));
+    xSemaphoreGive(s_deadband_mutex);
+    return count;
+}
+
+esp_err_t mqtt_set_heartbeat_interval(uint32_t interval_sec)
+{
+    s_heartbeat_sec = interval_sec;
+    ESP_LOGI(TAG, "Deadband heartbeat set to %lu seconds", interval_sec);
+    settings_store_set_u32(SETTING_MQTT_HEARTBEAT, interval_sec);
+    return ESP_OK;
+}
+
+uint32_t mqtt_get_heartbeat_interval(void)
+{
+    return s_heartbeat_sec;
+}
+
+esp_err_t mqtt_set_batch_size(uint8_t samples)
+{
+    if (samples > MQTT_BATCH_MAX_SAMPLES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_batch_size = samples;
+    ESP_LOGI(TAG, "MQTT batch size set to %u samples", samples);
+    settings_store_set_u32(SETTING_MQTT_BATCH_SIZE, samples);
+    return ESP_OK;
+}
+
+uint8_t mqtt_get_batch_size(void)
+{
+    return s_batch_size;
+}
+
+esp_err_t mqtt_set_batch_window(uint32_t window_sec)
+{
+    s_batch_window_sec = window_sec;
+    ESP_LOGI(TAG, "MQTT batch window set to %lu seconds", window_sec);
+    settings_store_set_u32(SETTING_MQTT_BATCH_WINDOW, window_sec);
+    return ESP_OK;
+}
+
+uint32_t mqtt_get_batch_window(void)
+{
+    return s_batch_window_sec;
+}
+
+esp_err_t mqtt_set_payload_format(mqtt_payload_format_t format)
+{
+    if (format != MQTT_PAYLOAD_JSON && format != MQTT_PAYLOAD_CBOR) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    s_payload_format = format;
+    ESP_LOGI(TAG, "MQTT payload format set to %s", format == MQTT_PAYLOAD_CBOR ? "cbor" : "json");
+    settings_store_set_u32(SETTING_MQTT_FORMAT, (uint32_t)format);
+    return ESP_OK;
+}
+
+mqtt_payload_format_t mqtt_get_payload_format(void)
+{
+    return s_payload_format;
+}
+
+esp_err_t mqtt_set_protocol_v5(bool enable)
+{
+#ifndef CONFIG_MQTT_PROTOCOL_5
+    if (enable) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+#endif
+    s_protocol_v5 = enable;
+    ESP_LOGI(TAG, "MQTT protocol set to %s (applies on next start)", enable ? "5" : "3.1.1");
+    settings_store_set_u32(SETTING_MQTT_V5, enable ? 1 : 0);
     return ESP_OK;
 }
 
+bool mqtt_get_protocol_v5(void)
+{
+    return s_protocol_v5;
+}
+
 esp_err_t mqtt_get_device_id(char *device_id, size_t size)
 {
     if (device_id == NULL || size == 0) {
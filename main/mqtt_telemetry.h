@@ -7,6 +7,8 @@
 #define MQTT_TELEMETRY_H
 
 #include "esp_err.h"
+#include "json_writer.h"
+#include "sensor_manager.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -24,16 +26,60 @@ typedef enum {
     MQTT_STATE_ERROR
 } mqtt_state_t;
 
+/**
+ * @brief Payload encoding of the data topic
+ */
+typedef enum {
+    MQTT_PAYLOAD_JSON = 0,      // JSON on kannacloud/sensor/<id>/data (default)
+    MQTT_PAYLOAD_CBOR,          // CBOR schema (telemetry_codec.h) on kannacloud/sensor/<id>/data/cbor
+} mqtt_payload_format_t;
+
+/**
+ * @brief Latency histogram with fixed bucket bounds
+ *
+ * Bucket i counts samples up to MQTT_LATENCY_BUCKET_BOUNDS_MS[i]; the last
+ * bucket catches everything above.
+ */
+#define MQTT_LATENCY_BUCKETS            12
+#define MQTT_LATENCY_BUCKET_BOUNDS_MS   {5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, UINT32_MAX}
+typedef struct {
+    uint32_t buckets[MQTT_LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t max_ms;
+    uint64_t sum_ms;
+} mqtt_latency_hist_t;
+
+/**
+ * @brief Publish pipeline counters since boot (or the last reset)
+ */
+#define MQTT_PERF_REPORT_SEC            300     // Period of the telemetry message carrying these
+typedef struct {
+    mqtt_latency_hist_t snapshot_to_enqueue;    // Cache snapshot taken -> handed to the client
+    mqtt_latency_hist_t enqueue_to_send;        // Time inside esp_mqtt_client_publish (writes while connected)
+    mqtt_latency_hist_t send_to_ack;            // Sent -> PUBACK
+    mqtt_latency_hist_t reconnect;              // Broker lost -> connected again
+    uint32_t messages_sent;
+    uint64_t bytes_sent;                        // Payload bytes
+    uint32_t publish_failures;                  // esp_mqtt_client_publish rejected the message
+    uint32_t samples_dropped;                   // Samples lost to a full batch or log
+    uint32_t acks_untracked;                    // Sends evicted from the PUBACK table before their ack
+    uint32_t inflight;                          // Sends waiting for PUBACK
+    int32_t outbox_bytes;                       // esp-mqtt outbox size at the time of the snapshot
+} mqtt_perf_stats_t;
+
 /**
  * @brief Telemetry data structure (legacy)
  */
 typedef struct {
     uint32_t uptime_sec;          // Device uptime in seconds
     uint32_t free_heap;           // Free heap memory in bytes
+    uint32_t min_free_heap;       // Lowest free heap since boot
+    uint32_t largest_free_block;  // Largest allocatable internal block
     int8_t rssi;                  // WiFi signal strength in dBm
     float cpu_temp;               // CPU temperature (if available)
     uint32_t wifi_reconnects;     // Number of WiFi reconnections
     uint32_t mqtt_reconnects;     // Number of MQTT reconnections
+    mqtt_perf_stats_t mqtt_perf;  // Publish latency and outbox counters
 } telemetry_data_t;
 
 /**
@@ -72,6 +118,31 @@ typedef struct {
     int8_t rssi;                 // WiFi signal strength in dBm (optional)
 } kannacloud_data_t;
 
+/**
+ * @brief Deadband for one published channel (one value of one sensor type)
+ *
+ * A change of at least threshold on the channel publishes immediately.
+ * Channels without an entry never trigger a publish on their own.
+ */
+#define MQTT_DEADBAND_MAX_CHANNELS  16
+#define MQTT_DEADBAND_ALL_VALUES    0xFF   // value_index matching every value of the sensor
+typedef struct {
+    char sensor_type[16];   // EZO type string, or "battery"
+    uint8_t value_index;    // Index into the sensor's values, or MQTT_DEADBAND_ALL_VALUES
+    float threshold;        // Minimum absolute change that publishes
+} mqtt_deadband_t;
+
+#define MQTT_BATCH_MAX_SAMPLES      16     // Upper bound of samples per batched publish
+
+// MQTT 5 data messages (mqtt_set_protocol_v5)
+#define MQTT_V5_MESSAGE_EXPIRY_SEC  900    // Broker discards undelivered data messages after this
+#define MQTT_JSON_SCHEMA_VERSION    1      // "schema" user property of JSON data messages
+
+// Burst capture, started by {"command":"burst","duration":<sec>} on kannacloud/sensor/<id>/cmd.
+// The samples are uploaded as one CBOR batch on kannacloud/sensor/<id>/data/burst/cbor.
+#define MQTT_BURST_DEFAULT_SEC      60
+#define MQTT_BURST_MAX_SEC          300
+
 /**
  * @brief Initialize MQTT client
  * 
@@ -163,6 +234,20 @@ esp_err_t mqtt_publish_status(const char *status);
  */
 esp_err_t mqtt_publish_json(const char *topic, const char *json_data, int qos, bool retain);
 
+/**
+ * @brief Queue an alarm document on the alert topic (kannacloud/sensor/<id>/alert)
+ * 
+ * QoS 1 and independent of the telemetry interval. The message goes into the
+ * client outbox without waiting for the network, so it is safe from a cache
+ * listener, and is delivered after a reconnect if the link is down.
+ * 
+ * @param json_data JSON document
+ * @param len Length of json_data
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE before mqtt_client_init(),
+ *         ESP_ERR_TIMEOUT if a data publish held the client, ESP_FAIL if the outbox refused it
+ */
+esp_err_t mqtt_publish_alert(const char *json_data, size_t len);
+
 /**
  * @brief Subscribe to a topic
  * 
@@ -183,7 +268,10 @@ esp_err_t mqtt_unsubscribe(const char *topic);
 /**
  * @brief Set telemetry publishing interval
  * 
- * @param interval_sec Interval in seconds (0 to disable automatic publishing)
+ * Publishes are aligned to completed sensor cycles: the first cycle that
+ * finishes after the interval has elapsed is published.
+ * 
+ * @param interval_sec Interval in seconds (0 to publish every sensor cycle)
  * @return ESP_OK on success, error code otherwise
  */
 esp_err_t mqtt_set_telemetry_interval(uint32_t interval_sec);
@@ -191,20 +279,137 @@ esp_err_t mqtt_set_telemetry_interval(uint32_t interval_sec);
 /**
  * @brief Get current telemetry publishing interval
  * 
- * @return Current interval in seconds (0 means automatic publishing disabled)
+ * @return Current interval in seconds (0 means every sensor cycle)
  */
 uint32_t mqtt_get_telemetry_interval(void);
 
 /**
  * @brief Trigger an immediate MQTT publish
  * 
- * Wakes up the MQTT publish task to send data immediately.
- * Useful when interval is set to 0 (on-read publishing).
+ * Hands the current sensor cache to the publish task, bypassing the
+ * interval and deadband filters. Regular publishes need no trigger: every
+ * completed sensor cycle is delivered to the publisher as it happens.
  * 
- * @return ESP_OK on success, ESP_ERR_INVALID_STATE if task not running
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if task not running,
+ *         ESP_ERR_NOT_FOUND if no sensor data is cached yet
  */
 esp_err_t mqtt_trigger_immediate_publish(void);
 
+/**
+ * @brief Replace the deadband table (change-driven publishing)
+ * 
+ * With at least one entry, each sensor cache update is compared to the last
+ * published snapshot: significant changes publish immediately, everything
+ * else is suppressed until the heartbeat interval expires. An empty table
+ * restores plain interval/on-read publishing. Saved to NVS.
+ * 
+ * @param entries Deadband entries
+ * @param count Number of entries (0 disables the filter)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if count exceeds MQTT_DEADBAND_MAX_CHANNELS
+ */
+esp_err_t mqtt_set_deadbands(const mqtt_deadband_t *entries, uint8_t count);
+
+/**
+ * @brief Get the deadband table
+ * 
+ * @param entries Output array
+ * @param max_entries Capacity of entries
+ * @return Number of entries written
+ */
+uint8_t mqtt_get_deadbands(mqtt_deadband_t *entries, uint8_t max_entries);
+
+/**
+ * @brief Deadband comparison of a snapshot against an earlier one
+ *
+ * Pure function behind the publish filter; the heartbeat is not considered.
+ *
+ * @param table Deadband entries
+ * @param count Number of entries
+ * @param last Last published snapshot
+ * @param cache Candidate snapshot
+ * @return true if any channel moved past its deadband or the set of sensors changed
+ */
+bool mqtt_deadband_changed(const mqtt_deadband_t *table, uint8_t count,
+                           const sensor_cache_t *last, const sensor_cache_t *cache);
+
+/**
+ * @brief Set the maximum silence while the deadband filter suppresses publishes
+ * 
+ * @param interval_sec Heartbeat in seconds (0 = no heartbeat)
+ * @return ESP_OK on success
+ */
+esp_err_t mqtt_set_heartbeat_interval(uint32_t interval_sec);
+
+/**
+ * @brief Get the deadband heartbeat interval in seconds
+ */
+uint32_t mqtt_get_heartbeat_interval(void);
+
+/**
+ * @brief Set how many samples are accumulated into one batched publish (saved to NVS)
+ * 
+ * In batching mode every sensor cache update that passes the publish interval
+ * and deadband filters becomes one sample with its own timestamp; samples are
+ * published together on kannacloud/sensor/<id>/data/batch (or .../batch/cbor)
+ * once the batch holds this many samples or its window expires.
+ * 
+ * @param samples Samples per message (0 or 1 = no size limit besides MQTT_BATCH_MAX_SAMPLES)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG above MQTT_BATCH_MAX_SAMPLES
+ */
+esp_err_t mqtt_set_batch_size(uint8_t samples);
+
+/**
+ * @brief Get the batch size (0 when not limited by count)
+ */
+uint8_t mqtt_get_batch_size(void);
+
+/**
+ * @brief Set the maximum age of the oldest sample in a batch (saved to NVS)
+ * 
+ * Batching is active when the batch size is above 1 or the window is non-zero.
+ * 
+ * @param window_sec Window in seconds (0 = publish on size only)
+ * @return ESP_OK on success
+ */
+esp_err_t mqtt_set_batch_window(uint32_t window_sec);
+
+/**
+ * @brief Get the batch window in seconds
+ */
+uint32_t mqtt_get_batch_window(void);
+
+/**
+ * @brief Select the payload format of sensor data publishes (saved to NVS)
+ * 
+ * @param format Payload format
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an unknown format
+ */
+esp_err_t mqtt_set_payload_format(mqtt_payload_format_t format);
+
+/**
+ * @brief Get the payload format of sensor data publishes
+ */
+mqtt_payload_format_t mqtt_get_payload_format(void);
+
+/**
+ * @brief Select MQTT 5 instead of 3.1.1 (saved to NVS, applied by mqtt_client_init)
+ * 
+ * In MQTT 5 mode data topics are sent as topic aliases after their first use
+ * per connection, the schema version and sample time travel as user
+ * properties ("schema", "ts") instead of payload fields, device_id is left out
+ * of payloads because the topic names the device, and data messages expire at
+ * the broker after MQTT_V5_MESSAGE_EXPIRY_SEC.
+ * 
+ * @param enable true for MQTT 5
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if built without CONFIG_MQTT_PROTOCOL_5
+ */
+esp_err_t mqtt_set_protocol_v5(bool enable);
+
+/**
+ * @brief Check if MQTT 5 is selected
+ */
+bool mqtt_get_protocol_v5(void);
+
 /**
  * @brief Get device ID for MQTT topics
  * 
@@ -225,6 +430,50 @@ esp_err_t mqtt_get_device_id(char *device_id, size_t size);
  */
 esp_err_t mqtt_get_cached_sensor_data(kannacloud_data_t *data);
 
+/**
+ * @brief Copy the publish pipeline counters
+ * 
+ * Also published with the legacy telemetry message every MQTT_PERF_REPORT_SEC.
+ * 
+ * @param stats Output counters
+ * @return ESP_OK on success
+ */
+esp_err_t mqtt_get_perf_stats(mqtt_perf_stats_t *stats);
+
+/**
+ * @brief Queue a packed sample (telemetry_pack_snapshot) for the next batch publish
+ * 
+ * Used for samples taken before this boot, e.g. kept in RTC memory across
+ * deep sleep. They are published on the batch topic regardless of the batch
+ * settings; beyond MQTT_BATCH_MAX_SAMPLES they are dropped and counted.
+ * 
+ * @param record Packed snapshot
+ * @param len Record length
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE before mqtt_client_init()
+ */
+esp_err_t mqtt_add_packed_sample(const uint8_t *record, size_t len);
+
+/**
+ * @brief Publish everything queued and wait for the broker to acknowledge it
+ * 
+ * @param timeout_ms Maximum wait
+ * @return ESP_OK once nothing is queued or unacknowledged, ESP_ERR_TIMEOUT otherwise
+ */
+esp_err_t mqtt_flush(uint32_t timeout_ms);
+
+/**
+ * @brief Clear the publish pipeline counters
+ */
+void mqtt_reset_perf_stats(void);
+
+/**
+ * @brief Render counters as a JSON object value (shared by MQTT and /api/perf/mqtt)
+ * 
+ * @param w Writer positioned where the object value goes
+ * @param stats Counters to render
+ */
+void mqtt_write_perf_json(json_writer_t *w, const mqtt_perf_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,436 @@
+/**
+ * @file ota_pipeline.c
+ * @brief Double-buffered firmware update engine
+ */
+
+#include "ota_pipeline.h"
+#include "gzip_format.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "rom/miniz.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "OTA";
+
+#define OTA_WRITER_STACK        4096
+#define OTA_WRITER_PRIORITY     5
+#define OTA_END_OF_IMAGE        (-1)    // Chunk index telling the writer to stop
+
+typedef struct {
+    int index;                  // Ring slot, or OTA_END_OF_IMAGE
+    size_t len;
+} ota_chunk_t;
+
+typedef enum {
+    OTA_FORMAT_UNKNOWN,         // Nothing seen yet
+    OTA_FORMAT_RAW,
+    OTA_FORMAT_GZIP,
+} ota_format_t;
+
+struct ota_pipeline {
+    const esp_partition_t *partition;
+    esp_ota_handle_t handle;
+
+    uint8_t *ring;                              // OTA_PIPELINE_BUFFERS * OTA_PIPELINE_BUFFER_SIZE
+    QueueHandle_t free_q;                       // int: slots the producer may fill
+    QueueHandle_t full_q;                       // ota_chunk_t: slots waiting for the writer
+    SemaphoreHandle_t done;
+    TaskHandle_t writer;
+
+    int current;                                // Slot being filled, -1 if none
+    size_t fill;
+    volatile esp_err_t error;                   // First writer failure, sticky
+    volatile bool aborted;
+
+    // Writer task state
+    ota_format_t format;
+    tinfl_decompressor *inflator;
+    uint8_t *dict;                              // TINFL_LZ_DICT_SIZE circular output window
+    size_t dict_ofs;
+    bool inflate_done;
+    uint32_t crc;
+    uint8_t trailer[GZIP_TRAILER_SIZE];
+    size_t trailer_len;
+
+    size_t bytes_in;
+    size_t bytes_out;
+    int64_t start_us;
+    int64_t producer_wait_us;                   // Time the network side waited on flash
+};
+
+static void *ota_alloc(size_t size)
+{
+    void *ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return ptr != NULL ? ptr : malloc(size);
+}
+
+static esp_err_t ota_flash(ota_pipeline_t *ota, const uint8_t *data, size_t len)
+{
+    esp_err_t err = esp_ota_write(ota->handle, data, len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_write failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    ota->bytes_out += len;
+    return ESP_OK;
+}
+
+static esp_err_t ota_gzip_start(ota_pipeline_t *ota)
+{
+    ota->inflator = ota_alloc(sizeof(tinfl_decompressor));
+    ota->dict = ota_alloc(TINFL_LZ_DICT_SIZE);
+    if (ota->inflator == NULL || ota->dict == NULL) {
+        ESP_LOGE(TAG, "No memory for the inflate window");
+        return ESP_ERR_NO_MEM;
+    }
+    tinfl_init(ota->inflator);
+    ota->dict_ofs = 0;
+    ota->crc = 0;
+    return ESP_OK;
+}
+
+/**
+ * @brief Inflate one chunk of deflate data straight into the OTA partition
+ *
+ * Output goes to a 32 KB circular window (the deflate back-reference range)
+ * and is flashed as it is produced. Bytes after the end of the stream are the
+ * gzip trailer.
+ */
+static esp_err_t ota_gzip_feed(ota_pipeline_t *ota, const uint8_t *in, size_t in_len)
+{
+    size_t pos = 0;
+    while (!ota->inflate_done) {
+        size_t in_bytes = in_len - pos;
+        size_t out_bytes = TINFL_LZ_DICT_SIZE - ota->dict_ofs;
+        tinfl_status status = tinfl_decompress(ota->inflator, in + pos, &in_bytes,
+                                               ota->dict, ota->dict + ota->dict_ofs, &out_bytes,
+                                               TINFL_FLAG_HAS_MORE_INPUT);
+        pos += in_bytes;
+
+        if (out_bytes > 0) {
+            ota->crc = esp_rom_crc32_le(ota->crc, ota->dict + ota->dict_ofs, out_bytes);
+            esp_err_t err = ota_flash(ota, ota->dict + ota->dict_ofs, out_bytes);
+            if (err != ESP_OK) {
+                return err;
+            }
+            ota->dict_ofs = (ota->dict_ofs + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+        }
+
+        if (status == TINFL_STATUS_DONE) {
+            ota->inflate_done = true;
+        } else if (status < TINFL_STATUS_DONE) {
+            ESP_LOGE(TAG, "Compressed image is corrupt (inflate status %d)", (int)status);
+            return ESP_ERR_INVALID_RESPONSE;
+        } else if (status == TINFL_STATUS_NEEDS_MORE_INPUT && pos >= in_len) {
+            return ESP_OK;
+        }
+    }
+
+    size_t extra = in_len - pos;
+    if (extra > GZIP_TRAILER_SIZE - ota->trailer_len) {
+        extra = GZIP_TRAILER_SIZE - ota->trailer_len;
+    }
+    memcpy(ota->trailer + ota->trailer_len, in + pos, extra);
+    ota->trailer_len += extra;
+    return ESP_OK;
+}
+
+static esp_err_t ota_gzip_verify(ota_pipeline_t *ota)
+{
+    if (!ota->inflate_done || ota->trailer_len < GZIP_TRAILER_SIZE) {
+        ESP_LOGE(TAG, "Compressed image is truncated");
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (!gzip_trailer_matches(ota->trailer, ota->crc, ota->bytes_out)) {
+        ESP_LOGE(TAG, "Compressed image CRC/length mismatch");
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ota_process_chunk(ota_pipeline_t *ota, const uint8_t *data, size_t len)
+{
+    if (ota->format == OTA_FORMAT_UNKNOWN) {
+        if (len >= 2 && data[0] == 0x1f && data[1] == 0x8b) {
+            // The header must fit in the first buffer, which is always a full
+            // OTA_PIPELINE_BUFFER_SIZE unless the whole image is smaller
+            size_t header = gzip_header_len(data, len);
+            if (header == 0) {
+                ESP_LOGE(TAG, "Unsupported gzip header");
+                return ESP_ERR_INVALID_ARG;
+            }
+            esp_err_t err = ota_gzip_start(ota);
+            if (err != ESP_OK) {
+                return err;
+            }
+            ota->format = OTA_FORMAT_GZIP;
+            ESP_LOGI(TAG, "Compressed image, inflating while flashing");
+            data += header;
+            len -= header;
+        } else {
+            ota->format = OTA_FORMAT_RAW;
+        }
+    }
+
+    if (ota->format == OTA_FORMAT_GZIP) {
+        return ota_gzip_feed(ota, data, len);
+    }
+    return ota_flash(ota, data, len);
+}
+
+static void ota_writer_task(void *arg)
+{
+    ota_pipeline_t *ota = arg;
+    ota_chunk_t chunk;
+
+    while (xQueueReceive(ota->full_q, &chunk, portMAX_DELAY) == pdTRUE) {
+        if (chunk.index == OTA_END_OF_IMAGE) {
+            break;
+        }
+        // After a failure keep draining so the producer never blocks on a lost buffer
+        if (ota->error == ESP_OK && !ota->aborted) {
+            esp_err_t err = ota_process_chunk(ota, ota->ring + chunk.index * OTA_PIPELINE_BUFFER_SIZE, chunk.len);
+            if (err != ESP_OK) {
+                ota->error = err;
+            }
+        }
+        xQueueSend(ota->free_q, &chunk.index, portMAX_DELAY);
+    }
+
+    xSemaphoreGive(ota->done);
+    vTaskDelete(NULL);
+}
+
+static void ota_free(ota_pipeline_t *ota)
+{
+    if (ota->free_q != NULL) {
+        vQueueDelete(ota->free_q);
+    }
+    if (ota->full_q != NULL) {
+        vQueueDelete(ota->full_q);
+    }
+    if (ota->done != NULL) {
+        vSemaphoreDelete(ota->done);
+    }
+    free(ota->ring);
+    free(ota->inflator);
+    free(ota->dict);
+    free(ota);
+}
+
+/**
+ * @brief Tell the writer the image is complete and wait for it to exit
+ */
+static void ota_writer_stop(ota_pipeline_t *ota)
+{
+    if (ota->writer == NULL) {
+        return;
+    }
+    // full_q holds every slot plus the marker, so this never blocks
+    ota_chunk_t end = { .index = OTA_END_OF_IMAGE, .len = 0 };
+    xQueueSend(ota->full_q, &end, portMAX_DELAY);
+    xSemaphoreTake(ota->done, portMAX_DELAY);
+    ota->writer = NULL;
+}
+
+esp_err_t ota_pipeline_begin(ota_pipeline_t **out)
+{
+    if (out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = NULL;
+
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "No OTA partition available");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    ota_pipeline_t *ota = calloc(1, sizeof(*ota));
+    if (ota == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ota->partition = partition;
+    ota->current = -1;
+    ota->ring = ota_alloc(OTA_PIPELINE_BUFFERS * OTA_PIPELINE_BUFFER_SIZE);
+    ota->free_q = xQueueCreate(OTA_PIPELINE_BUFFERS, sizeof(int));
+    ota->full_q = xQueueCreate(OTA_PIPELINE_BUFFERS + 1, sizeof(ota_chunk_t));
+    ota->done = xSemaphoreCreateBinary();
+    if (ota->ring == NULL || ota->free_q == NULL || ota->full_q == NULL || ota->done == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate OTA pipeline");
+        ota_free(ota);
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < OTA_PIPELINE_BUFFERS; i++) {
+        xQueueSend(ota->free_q, &i, 0);
+    }
+
+    // Sequential writes erase each sector just before it is programmed, so the
+    // erase cost is spread over the transfer instead of stalling it up front
+    esp_err_t err = esp_ota_begin(partition, OTA_WITH_SEQUENTIAL_WRITES, &ota->handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_begin failed: %s", esp_err_to_name(err));
+        ota_free(ota);
+        return err;
+    }
+
+    if (xTaskCreate(ota_writer_task, "ota_writer", OTA_WRITER_STACK, ota,
+                    OTA_WRITER_PRIORITY, &ota->writer) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start OTA writer task");
+        esp_ota_abort(ota->handle);
+        ota_free(ota);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ota->start_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "OTA started on partition %s", partition->label);
+    *out = ota;
+    return ESP_OK;
+}
+
+/**
+ * @brief Hand the buffer being filled to the writer
+ */
+static void ota_submit_current(ota_pipeline_t *ota)
+{
+    if (ota->current < 0) {
+        return;
+    }
+    if (ota->fill > 0) {
+        ota_chunk_t chunk = { .index = ota->current, .len = ota->fill };
+        xQueueSend(ota->full_q, &chunk, portMAX_DELAY);
+    } else {
+        xQueueSend(ota->free_q, &ota->current, portMAX_DELAY);
+    }
+    ota->current = -1;
+    ota->fill = 0;
+}
+
+esp_err_t ota_pipeline_acquire(ota_pipeline_t *ota, uint8_t **buf, size_t *capacity)
+{
+    if (ota == NULL || buf == NULL || capacity == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (ota->error != ESP_OK) {
+        return ota->error;
+    }
+
+    if (ota->current < 0) {
+        int64_t wait_start = esp_timer_get_time();
+        if (xQueueReceive(ota->free_q, &ota->current, pdMS_TO_TICKS(OTA_PIPELINE_STALL_MS)) != pdTRUE) {
+            ESP_LOGE(TAG, "Flash writer stalled");
+            return ESP_ERR_TIMEOUT;
+        }
+        ota->producer_wait_us += esp_timer_get_time() - wait_start;
+        ota->fill = 0;
+        // A failure may have been recorded while waiting
+        if (ota->error != ESP_OK) {
+            return ota->error;
+        }
+    }
+
+    *buf = ota->ring + ota->current * OTA_PIPELINE_BUFFER_SIZE + ota->fill;
+    *capacity = OTA_PIPELINE_BUFFER_SIZE - ota->fill;
+    return ESP_OK;
+}
+
+esp_err_t ota_pipeline_produced(ota_pipeline_t *ota, size_t len)
+{
+    if (ota == NULL || ota->current < 0 || ota->fill + len > OTA_PIPELINE_BUFFER_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ota->fill += len;
+    ota->bytes_in += len;
+    if (ota->fill == OTA_PIPELINE_BUFFER_SIZE) {
+        ota_submit_current(ota);
+    }
+    return ota->error;
+}
+
+esp_err_t ota_pipeline_write(ota_pipeline_t *ota, const void *data, size_t len)
+{
+    const uint8_t *src = data;
+    while (len > 0) {
+        uint8_t *buf = NULL;
+        size_t capacity = 0;
+        esp_err_t err = ota_pipeline_acquire(ota, &buf, &capacity);
+        if (err != ESP_OK) {
+            return err;
+        }
+        size_t n = len < capacity ? len : capacity;
+        memcpy(buf, src, n);
+        err = ota_pipeline_produced(ota, n);
+        if (err != ESP_OK) {
+            return err;
+        }
+        src += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+void ota_pipeline_abort(ota_pipeline_t *ota)
+{
+    if (ota == NULL) {
+        return;
+    }
+    ota->aborted = true;
+    ota_submit_current(ota);
+    ota_writer_stop(ota);
+    esp_ota_abort(ota->handle);
+    ESP_LOGW(TAG, "OTA aborted after %zu bytes", ota->bytes_in);
+    ota_free(ota);
+}
+
+esp_err_t ota_pipeline_finish(ota_pipeline_t *ota)
+{
+    if (ota == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ota_submit_current(ota);
+    ota_writer_stop(ota);
+
+    esp_err_t err = ota->error;
+    if (err == ESP_OK && ota->format == OTA_FORMAT_GZIP) {
+        err = ota_gzip_verify(ota);
+    }
+    if (err == ESP_OK && ota->bytes_out == 0) {
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    if (err != ESP_OK) {
+        esp_ota_abort(ota->handle);
+        ota_free(ota);
+        return err;
+    }
+
+    // Validates the image header, segments and SHA-256 digest
+    err = esp_ota_end(ota->handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_end failed: %s", esp_err_to_name(err));
+        ota_free(ota);
+        return err;
+    }
+
+    err = esp_ota_set_boot_partition(ota->partition);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set boot partition: %s", esp_err_to_name(err));
+        ota_free(ota);
+        return err;
+    }
+
+    int64_t elapsed_ms = (esp_timer_get_time() - ota->start_us) / 1000;
+    ESP_LOGI(TAG, "OTA complete: %zu bytes received, %zu flashed in %lld ms (network waited %lld ms on flash)",
+             ota->bytes_in, ota->bytes_out, (long long)elapsed_ms, (long long)(ota->producer_wait_us / 1000));
+    ota_free(ota);
+    return ESP_OK;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file ota_pipeline.h
+ * @brief Double-buffered firmware update engine
+ *
+ * The transport (HTTPS upload today, MQTT or HTTPS pull later) fills buffers
+ * from a small ring while a writer task erases and programs flash from the
+ * buffers already filled, so the network keeps receiving during flash writes.
+ * Images starting with the gzip magic are inflated on the fly in the writer
+ * task; anything else is written as a raw application image.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OTA_PIPELINE_BUFFER_SIZE    8192    // Bytes per ring buffer
+#define OTA_PIPELINE_BUFFERS        3       // One being filled, the rest queued or flashing
+#define OTA_PIPELINE_STALL_MS       30000   // Longest the producer waits for a free buffer
+
+typedef struct ota_pipeline ota_pipeline_t;
+
+/**
+ * @brief Open the next OTA partition and start the writer task
+ *
+ * @param out Pipeline handle, released by ota_pipeline_finish() or ota_pipeline_abort()
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t ota_pipeline_begin(ota_pipeline_t **out);
+
+/**
+ * @brief Get free space in the buffer being filled, for receiving in place
+ *
+ * Blocks while every buffer is queued for flashing.
+ *
+ * @param buf Receives a pointer into the current buffer
+ * @param capacity Receives the bytes available at buf
+ * @return esp_err_t ESP_OK, ESP_ERR_TIMEOUT if the writer stalled, or the writer's error
+ */
+esp_err_t ota_pipeline_acquire(ota_pipeline_t *ota, uint8_t **buf, size_t *capacity);
+
+/**
+ * @brief Account for len bytes written at the pointer from ota_pipeline_acquire()
+ *
+ * A buffer is handed to the writer as soon as it is full.
+ */
+esp_err_t ota_pipeline_produced(ota_pipeline_t *ota, size_t len);
+
+/**
+ * @brief Copy data into the pipeline (for transports that deliver their own buffers)
+ */
+esp_err_t ota_pipeline_write(ota_pipeline_t *ota, const void *data, size_t len);
+
+/**
+ * @brief Flush the last buffer, validate the image and make it the boot partition
+ *
+ * The handle is released whether or not this succeeds.
+ *
+ * @return esp_err_t ESP_OK when the image is ready to boot
+ */
+esp_err_t ota_pipeline_finish(ota_pipeline_t *ota);
+
+/**
+ * @brief Stop the writer and discard the partial image
+ */
+void ota_pipeline_abort(ota_pipeline_t *ota);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,256 @@
+/**
+ * @file perf_monitor.c
+ * @brief CPU and task stack profiler built on FreeRTOS run-time stats
+ */
+
+#include "perf_monitor.h"
+#include "task_profile.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "PERF";
+
+// Long-running application tasks whose stack margin goes into the summary
+static const char *const k_watched_tasks[] = {
+    "sensor_read", "mqtt_publish", "mqtt_task", "httpd", "i2c_arb",
+};
+
+#define PERF_WATCHED_COUNT (sizeof(k_watched_tasks) / sizeof(k_watched_tasks[0]))
+
+#if defined(CONFIG_FREERTOS_USE_TRACE_FACILITY) && defined(CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS)
+
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t runtime;
+} perf_prev_t;
+
+// Sampler state, only touched from the esp_timer task
+static TaskStatus_t s_status[PERF_MONITOR_MAX_TASKS];
+static perf_prev_t s_prev[PERF_MONITOR_MAX_TASKS];
+static UBaseType_t s_prev_count = 0;
+static int64_t s_prev_us = 0;
+
+static perf_snapshot_t s_snapshot;          // Guarded by s_mutex
+static perf_snapshot_t s_work;
+static SemaphoreHandle_t s_mutex = NULL;
+static esp_timer_handle_t s_timer = NULL;
+
+static uint32_t prev_runtime(TaskHandle_t handle, bool *found) {
+    for (UBaseType_t i = 0; i < s_prev_count; i++) {
+        if (s_prev[i].handle == handle) {
+            *found = true;
+            return s_prev[i].runtime;
+        }
+    }
+    *found = false;
+    return 0;
+}
+
+static int compare_cpu_desc(const void *a, const void *b) {
+    float ca = ((const perf_task_stats_t *)a)->cpu_percent;
+    float cb = ((const perf_task_stats_t *)b)->cpu_percent;
+    return (ca < cb) - (ca > cb);
+}
+
+static void perf_sample_cb(void *arg) {
+    (void)arg;
+    uint32_t total_runtime = 0;
+    UBaseType_t count = uxTaskGetSystemState(s_status, PERF_MONITOR_MAX_TASKS, &total_runtime);
+    int64_t now_us = esp_timer_get_time();
+    if (count == 0) {
+        // More tasks than PERF_MONITOR_MAX_TASKS; nothing is filled in
+        ESP_LOGW(TAG, "Too many tasks to profile (limit %d)", PERF_MONITOR_MAX_TASKS);
+        return;
+    }
+
+    int64_t window_us = now_us - s_prev_us;
+    bool have_window = s_prev_us > 0 && window_us > 0;
+
+    perf_snapshot_t *snap = &s_work;
+    memset(snap, 0, sizeof(*snap));
+    snap->window_ms = (uint32_t)(window_us / 1000);
+    snap->core_count = portNUM_PROCESSORS < PERF_MONITOR_MAX_CORES ? portNUM_PROCESSORS : PERF_MONITOR_MAX_CORES;
+    for (uint8_t c = 0; c < snap->core_count; c++) {
+        snap->core_load[c] = 100.0f;
+    }
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t *task = &s_status[i];
+        bool found = false;
+        uint32_t previous = prev_runtime(task->xHandle, &found);
+        // Unsigned difference survives the 32-bit microsecond counter wrapping
+        uint32_t delta = found ? task->ulRunTimeCounter - previous : 0;
+        float percent = have_window ? (float)delta * 100.0f / (float)window_us : 0.0f;
+
+        for (uint8_t c = 0; c < snap->core_count; c++) {
+            if (task->xHandle == xTaskGetIdleTaskHandleForCore(c)) {
+                snap->core_load[c] = percent < 100.0f ? 100.0f - percent : 0.0f;
+            }
+        }
+
+        perf_task_stats_t *out = &snap->tasks[snap->task_count++];
+        strncpy(out->name, task->pcTaskName, sizeof(out->name) - 1);
+        out->cpu_percent = percent;
+        out->stack_free = task->usStackHighWaterMark;   // Bytes: IDF stacks are byte-addressed
+        BaseType_t core = xTaskGetCoreID(task->xHandle);
+        out->core = (core == tskNO_AFFINITY) ? -1 : (int8_t)core;
+        out->priority = (uint8_t)task->uxCurrentPriority;
+
+        s_prev[i].handle = task->xHandle;
+        s_prev[i].runtime = task->ulRunTimeCounter;
+    }
+    s_prev_count = count;
+    s_prev_us = now_us;
+
+    if (!have_window) {
+        return;
+    }
+
+    float sum = 0.0f;
+    for (uint8_t c = 0; c < snap->core_count; c++) {
+        sum += snap->core_load[c];
+    }
+    snap->cpu_usage = sum / snap->core_count;
+    qsort(snap->tasks, snap->task_count, sizeof(snap->tasks[0]), compare_cpu_desc);
+    snap->valid = true;
+
+    if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        s_snapshot = *snap;
+        xSemaphoreGive(s_mutex);
+    }
+}
+
+esp_err_t perf_monitor_init(void) {
+    if (s_timer != NULL) {
+        return ESP_OK;
+    }
+    s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_timer_create_args_t args = {
+        .callback = perf_sample_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "perf_monitor"
+    };
+    esp_err_t err = esp_timer_create(&args, &s_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create sampling timer: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    // Baseline now so the first window completes one period from boot
+    perf_sample_cb(NULL);
+    err = esp_timer_start_periodic(s_timer, PERF_MONITOR_WINDOW_MS * 1000ULL);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "CPU profiler sampling every %d ms", PERF_MONITOR_WINDOW_MS);
+    }
+    return err;
+}
+
+esp_err_t perf_monitor_get_snapshot(perf_snapshot_t *snapshot) {
+    if (snapshot == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_mutex == NULL || xSemaphoreTake(s_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *snapshot = s_snapshot;
+    xSemaphoreGive(s_mutex);
+    return snapshot->valid ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+int perf_monitor_cpu_usage(void) {
+    int usage = -1;
+    if (s_mutex != NULL && xSemaphoreTake(s_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+        if (s_snapshot.valid) {
+            usage = (int)(s_snapshot.cpu_usage + 0.5f);
+        }
+        xSemaphoreGive(s_mutex);
+    }
+    return usage;
+}
+
+#else
+
+esp_err_t perf_monitor_init(void) {
+    ESP_LOGW(TAG, "FreeRTOS run-time stats disabled, CPU profiler unavailable");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t perf_monitor_get_snapshot(perf_snapshot_t *snapshot) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+int perf_monitor_cpu_usage(void) {
+    return -1;
+}
+
+#endif
+
+static void write_task_json(json_writer_t *w, const perf_task_stats_t *task) {
+    json_writer_object_begin(w);
+    json_writer_kv_string(w, "name", task->name);
+    json_writer_kv_float(w, "cpu", task->cpu_percent);
+    json_writer_kv_int(w, "stack_free", task->stack_free);
+    json_writer_kv_int(w, "core", task->core);
+    json_writer_kv_int(w, "priority", task->priority);
+    json_writer_object_end(w);
+}
+
+void perf_monitor_write_json(json_writer_t *w, bool detailed) {
+    // Copied out so the writer's sink (possibly a socket) runs without the lock
+    perf_snapshot_t *snap = malloc(sizeof(*snap));
+    if (snap == NULL || perf_monitor_get_snapshot(snap) != ESP_OK) {
+        free(snap);
+        json_writer_object_begin(w);
+        json_writer_kv_bool(w, "available", false);
+        json_writer_kv_string(w, "profile", task_profile_name());
+        json_writer_object_end(w);
+        return;
+    }
+
+    json_writer_object_begin(w);
+    json_writer_kv_bool(w, "available", true);
+    json_writer_kv_string(w, "profile", task_profile_name());
+    json_writer_kv_int(w, "window_ms", snap->window_ms);
+    json_writer_kv_float(w, "cpu_usage", snap->cpu_usage);
+    json_writer_key(w, "core_load");
+    json_writer_array_begin(w);
+    for (uint8_t c = 0; c < snap->core_count; c++) {
+        json_writer_float(w, snap->core_load[c]);
+    }
+    json_writer_array_end(w);
+
+    if (detailed) {
+        json_writer_key(w, "tasks");
+        json_writer_array_begin(w);
+        for (uint8_t i = 0; i < snap->task_count; i++) {
+            write_task_json(w, &snap->tasks[i]);
+        }
+        json_writer_array_end(w);
+        // What the tasks were created with, to compare against the measured core and priority
+        json_writer_key(w, "schedule");
+        task_profile_write_json(w);
+    } else {
+        json_writer_key(w, "stack_free");
+        json_writer_object_begin(w);
+        for (uint8_t i = 0; i < snap->task_count; i++) {
+            for (size_t k = 0; k < PERF_WATCHED_COUNT; k++) {
+                if (strcmp(snap->tasks[i].name, k_watched_tasks[k]) == 0) {
+                    json_writer_kv_int(w, snap->tasks[i].name, snap->tasks[i].stack_free);
+                    break;
+                }
+            }
+        }
+        json_writer_object_end(w);
+    }
+    json_writer_object_end(w);
+    free(snap);
+}
@@ -0,0 +1,75 @@
+/**
+ * @file perf_monitor.h
+ * @brief CPU and task stack profiler built on FreeRTOS run-time stats
+ *
+ * Every PERF_MONITOR_WINDOW_MS the monitor diffs the run-time counters of all
+ * tasks. It derives per-core load from the idle tasks, the share of a core each
+ * task used during the window, and each task's stack high-water mark. Readers
+ * get the last completed window, so a request never waits for a sample.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "json_writer.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PERF_MONITOR_WINDOW_MS   5000
+#define PERF_MONITOR_MAX_TASKS   32
+#define PERF_MONITOR_MAX_CORES   2
+
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN];
+    float cpu_percent;          // Share of one core used during the window
+    uint32_t stack_free;        // Stack high-water mark: fewest bytes ever left free
+    int8_t core;                // Pinned core, or -1 if the task can run on either
+    uint8_t priority;
+} perf_task_stats_t;
+
+typedef struct {
+    bool valid;                 // At least one full window has been measured
+    uint32_t window_ms;
+    uint8_t core_count;
+    float core_load[PERF_MONITOR_MAX_CORES];    // Percent busy per core
+    float cpu_usage;                            // Mean of core_load
+    uint8_t task_count;
+    perf_task_stats_t tasks[PERF_MONITOR_MAX_TASKS];   // Busiest first
+} perf_snapshot_t;
+
+/**
+ * @brief Start sampling run-time stats
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_SUPPORTED if the build has
+ *         no FreeRTOS run-time stats
+ */
+esp_err_t perf_monitor_init(void);
+
+/**
+ * @brief Copy the last completed measurement window
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE before the first window
+ */
+esp_err_t perf_monitor_get_snapshot(perf_snapshot_t *snapshot);
+
+/**
+ * @brief Overall CPU load of the last window in percent, or -1 if unknown
+ */
+int perf_monitor_cpu_usage(void);
+
+/**
+ * @brief Write the profile as a JSON object
+ *
+ * @param detailed true for every task; false for core loads plus the stack
+ *        margins of the application's long-running tasks
+ */
+void perf_monitor_write_json(json_writer_t *w, bool detailed);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,311 @@
+/**
+ * @file power_manager.c
+ * @brief Duty-cycled deep-sleep operation for battery-powered nodes
+ */
+
+#include "power_manager.h"
+#include "sensor_manager.h"
+#include "ezo_sensor.h"
+#include "i2c_arbiter.h"
+#include "i2c_scanner.h"
+#include "telemetry_codec.h"
+#include "telemetry_publisher.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "esp_attr.h"
+#include "settings_store.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "POWER";
+
+#define POWER_RTC_MAGIC             0x50574D31  // "PWM1"
+#define POWER_MAX_PERIOD_SEC        (6 * 3600)
+#define POWER_SAMPLE_TIMEOUT_MS     15000       // First acquisition cycle after wake
+#define POWER_CONNECT_TIMEOUT_MS    20000       // Wi-Fi association plus MQTT session, or Thread attach
+#define POWER_FLUSH_TIMEOUT_MS      10000       // Batch publish and PUBACK
+#define POWER_MIN_VALID_UNIX        1704067200  // 2024-01-01; older clock values are not a real time
+
+/**
+ * @brief Samples kept across deep sleep (RTC memory survives, main RAM does not)
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t wakes;
+    uint16_t count;
+    uint16_t len[POWER_RTC_SAMPLES];
+    uint8_t data[POWER_RTC_SAMPLES][TELEMETRY_PACKED_MAX_SIZE];
+} power_rtc_state_t;
+
+static RTC_DATA_ATTR power_rtc_state_t s_rtc;
+
+static bool s_low_power = false;
+static uint32_t s_interval_sec = POWER_DEFAULT_INTERVAL_SEC;
+static bool s_duty_wake = false;
+static power_uplink_fn_t s_uplink = NULL;
+
+esp_err_t power_manager_init(void) {
+    s_low_power = settings_store_get_u32(SETTING_LOW_POWER) != 0;
+    s_interval_sec = settings_store_get_u32(SETTING_LP_INTERVAL);
+
+    bool timer_wake = (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER);
+    if (!timer_wake || s_rtc.magic != POWER_RTC_MAGIC) {
+        // Power-on or reset: RTC memory holds no batch of ours
+        memset(&s_rtc, 0, sizeof(s_rtc));
+        s_rtc.magic = POWER_RTC_MAGIC;
+    }
+    s_duty_wake = timer_wake && s_low_power;
+
+    if (s_low_power) {
+        ESP_LOGI(TAG, "Low-power mode enabled (%lu s base period, %u samples per upload)%s",
+                 s_interval_sec, POWER_RTC_SAMPLES, s_duty_wake ? ", duty-cycle wake" : "");
+    }
+    return ESP_OK;
+}
+
+bool power_manager_is_duty_wake(void) {
+    return s_duty_wake;
+}
+
+void power_manager_set_uplink(power_uplink_fn_t uplink) {
+    s_uplink = uplink;
+}
+
+power_band_t power_manager_battery_band(float soc_percent, power_band_t current) {
+    if (soc_percent < 0.0f) {
+        return POWER_BAND_NORMAL;
+    }
+    // Lower edge of each band's parent: below s_band_pct[b - 1] the battery is in band b
+    static const float s_band_pct[] = {
+        CONFIG_KC_BATTERY_BAND_REDUCED_PCT, CONFIG_KC_BATTERY_BAND_LOW_PCT, CONFIG_KC_BATTERY_BAND_CRITICAL_PCT,
+    };
+    power_band_t band = POWER_BAND_NORMAL;
+    for (int b = 0; b < 3; b++) {
+        float threshold = s_band_pct[b];
+        if (current > (power_band_t)b) {
+            threshold += POWER_BAND_HYSTERESIS_PCT;
+        }
+        if (soc_percent < threshold) {
+            band = (power_band_t)(b + 1);
+        }
+    }
+    return band;
+}
+
+uint32_t power_manager_band_factor(power_band_t band) {
+    return 1u << band;
+}
+
+bool power_manager_band_sleeps_ezo(power_band_t band) {
+    return (int)band >= CONFIG_KC_BATTERY_EZO_SLEEP_BAND;
+}
+
+const char *power_band_to_string(power_band_t band) {
+    switch (band) {
+        case POWER_BAND_NORMAL:   return "normal";
+        case POWER_BAND_REDUCED:  return "reduced";
+        case POWER_BAND_LOW:      return "low";
+        case POWER_BAND_CRITICAL: return "critical";
+        default:                  return "unknown";
+    }
+}
+
+uint32_t power_manager_sleep_period_sec(float soc_percent) {
+    uint32_t factor = power_manager_band_factor(power_manager_battery_band(soc_percent, POWER_BAND_NORMAL));
+    uint32_t period = s_interval_sec * factor;
+    return period < POWER_MAX_PERIOD_SEC ? period : POWER_MAX_PERIOD_SEC;
+}
+
+static float power_manager_cached_soc(void) {
+    sensor_cache_t cache;
+    if (sensor_manager_get_cached_data(&cache) == ESP_OK && cache.battery_valid) {
+        return cache.battery_percentage;
+    }
+    return -1.0f;
+}
+
+/**
+ * @brief Stop acquisition and send every EZO board to sleep
+ */
+static void power_manager_sleep_sensors(void) {
+    sensor_manager_pause_reading();
+    for (int waited = 0; sensor_manager_is_reading_in_progress() && waited < 50; waited++) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+
+    uint8_t count = sensor_manager_get_ezo_count();
+    for (uint8_t i = 0; i < count; i++) {
+        ezo_sensor_t *sensor = (ezo_sensor_t *)sensor_manager_get_ezo_sensor(i);
+        if (sensor == NULL) {
+            continue;
+        }
+        i2c_arbiter_begin(I2C_ARBITER_PRIO_INTERACTIVE, sensor->config.i2c_address);
+        esp_err_t ret = ezo_sensor_sleep(sensor);
+        i2c_arbiter_end();
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to sleep %s @0x%02X: %s", sensor->config.type,
+                     sensor->config.i2c_address, esp_err_to_name(ret));
+        }
+    }
+}
+
+static void power_manager_deep_sleep(uint32_t period_sec) {
+    ESP_LOGI(TAG, "Deep sleep for %lu s (%u samples held)", period_sec, s_rtc.count);
+    // Shutdown handlers do not run on the way into deep sleep
+    settings_store_flush();
+    esp_wifi_stop();
+    esp_sleep_enable_timer_wakeup((uint64_t)period_sec * 1000000ULL);
+    esp_deep_sleep_start();
+}
+
+void power_manager_enter_sleep(void) {
+    float soc = power_manager_cached_soc();
+    // Samples already queued go out before the radio is switched off
+    telemetry_publisher_get()->flush(POWER_FLUSH_TIMEOUT_MS);
+    power_manager_sleep_sensors();
+    power_manager_deep_sleep(power_manager_sleep_period_sec(soc));
+}
+
+bool power_manager_should_sleep(void) {
+    return s_low_power && sensor_manager_has_battery_monitor() && !sensor_manager_is_burst_active() &&
+           esp_timer_get_time() >= (int64_t)POWER_COLD_BOOT_AWAKE_SEC * 1000000LL;
+}
+
+/**
+ * @brief Bring up the sensors and wait for the first complete acquisition cycle
+ *
+ * The reading task triggers every due board before polling them, so all EZO
+ * conversions of the wake run in parallel.
+ */
+static esp_err_t power_manager_sample(sensor_cache_t *cache) {
+    esp_err_t ret = i2c_scanner_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (i2c_scanner_scan_cached() != ESP_OK) {
+        i2c_scanner_scan();
+    }
+    ret = sensor_manager_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    i2c_arbiter_init(i2c_scanner_get_bus_count());
+    ret = sensor_manager_start_reading_task(sensor_manager_get_reading_interval());
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    for (int waited = 0; waited < POWER_SAMPLE_TIMEOUT_MS; waited += 100) {
+        if (sensor_manager_get_cached_data(cache) == ESP_OK) {
+            return ESP_OK;
+        }
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    return ESP_ERR_TIMEOUT;
+}
+
+/**
+ * @brief Append a reading to the RTC batch, dropping the oldest when full
+ */
+static void power_manager_store(const sensor_cache_t *cache) {
+    time_t now = time(NULL);
+    uint32_t unix_time = (now >= POWER_MIN_VALID_UNIX) ? (uint32_t)now : 0;
+
+    if (s_rtc.count == POWER_RTC_SAMPLES) {
+        memmove(&s_rtc.data[0], &s_rtc.data[1], (POWER_RTC_SAMPLES - 1) * sizeof(s_rtc.data[0]));
+        memmove(&s_rtc.len[0], &s_rtc.len[1], (POWER_RTC_SAMPLES - 1) * sizeof(s_rtc.len[0]));
+        s_rtc.count--;
+    }
+    size_t len = 0;
+    if (telemetry_pack_snapshot(cache, unix_time, s_rtc.data[s_rtc.count], sizeof(s_rtc.data[0]), &len) == ESP_OK) {
+        s_rtc.len[s_rtc.count] = (uint16_t)len;
+        s_rtc.count++;
+    }
+}
+
+/**
+ * @brief Connect and publish the RTC batch
+ */
+static esp_err_t power_manager_upload(void) {
+    if (s_uplink == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret = s_uplink();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    const telemetry_publisher_t *publisher = telemetry_publisher_get();
+    for (int waited = 0; !publisher->is_connected(); waited += 100) {
+        if (waited >= POWER_CONNECT_TIMEOUT_MS) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    for (uint16_t i = 0; i < s_rtc.count; i++) {
+        publisher->add_packed_sample(s_rtc.data[i], s_rtc.len[i]);
+    }
+    return publisher->flush(POWER_FLUSH_TIMEOUT_MS);
+}
+
+void power_manager_run_wake(void) {
+    s_rtc.wakes++;
+    int64_t start_us = esp_timer_get_time();
+
+    sensor_cache_t cache;
+    esp_err_t ret = power_manager_sample(&cache);
+    if (ret == ESP_OK && !sensor_manager_has_battery_monitor()) {
+        // Battery monitor gone: this node is mains powered now, run the normal firmware
+        ESP_LOGW(TAG, "No battery monitor, leaving low-power mode");
+        esp_restart();
+    }
+    float soc = (ret == ESP_OK && cache.battery_valid) ? cache.battery_percentage : -1.0f;
+    if (ret == ESP_OK) {
+        power_manager_store(&cache);
+    } else {
+        ESP_LOGW(TAG, "No reading this wake: %s", esp_err_to_name(ret));
+    }
+    power_manager_sleep_sensors();
+
+    if (s_rtc.count >= POWER_RTC_SAMPLES) {
+        ret = power_manager_upload();
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "✓ Uploaded %u samples", s_rtc.count);
+            s_rtc.count = 0;
+        } else {
+            // Kept for the next upload wake; the oldest samples make room if it fails again
+            ESP_LOGW(TAG, "Upload failed (%s), keeping %u samples", esp_err_to_name(ret), s_rtc.count);
+        }
+    }
+
+    ESP_LOGI(TAG, "Wake %lu done in %lld ms", s_rtc.wakes, (esp_timer_get_time() - start_us) / 1000);
+    power_manager_deep_sleep(power_manager_sleep_period_sec(soc));
+}
+
+esp_err_t power_manager_set_low_power(bool enable) {
+    s_low_power = enable;
+    ESP_LOGI(TAG, "Low-power mode %s", enable ? "enabled" : "disabled");
+    settings_store_set_u32(SETTING_LOW_POWER, enable ? 1 : 0);
+    return ESP_OK;
+}
+
+bool power_manager_get_low_power(void) {
+    return s_low_power;
+}
+
+esp_err_t power_manager_set_interval(uint32_t interval_sec) {
+    if (interval_sec < POWER_MIN_INTERVAL_SEC) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_interval_sec = interval_sec;
+    settings_store_set_u32(SETTING_LP_INTERVAL, interval_sec);
+    return ESP_OK;
+}
+
+uint32_t power_manager_get_interval(void) {
+    return s_interval_sec;
+}
@@ -0,0 +1,160 @@
+/**
+ * @file power_manager.h
+ * @brief Duty-cycled deep-sleep operation for battery-powered nodes
+ *
+ * With low-power mode enabled on a node that has a MAX17048, the device
+ * sleeps between samples instead of running the always-on Wi-Fi loop. Each
+ * timer wake takes one reading of all EZO boards, appends it to a batch kept
+ * in RTC memory and puts the boards back to sleep. The telemetry transport
+ * (Wi-Fi and MQTT, or Thread; see telemetry_publisher.h) is only brought up
+ * when the batch is full, so most wakes never power the radio.
+ * The sleep period stretches as the battery state of charge drops.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define POWER_RTC_SAMPLES           8       // Samples kept across deep sleep before an upload
+#define POWER_DEFAULT_INTERVAL_SEC  300     // Sleep period at a healthy battery
+#define POWER_MIN_INTERVAL_SEC      30
+#define POWER_COLD_BOOT_AWAKE_SEC   120     // Dashboard window after power-on before the first sleep
+#define POWER_BAND_HYSTERESIS_PCT   2       // Recharge needed above a band's threshold to leave it
+
+/**
+ * @brief State-of-charge bands of the battery policy
+ *
+ * Thresholds come from CONFIG_KC_BATTERY_BAND_*_PCT. Each band doubles the
+ * sensor, publish and deep-sleep intervals of the one above it; from
+ * CONFIG_KC_BATTERY_EZO_SLEEP_BAND the EZO boards also sleep between reads.
+ */
+typedef enum {
+    POWER_BAND_NORMAL = 0,
+    POWER_BAND_REDUCED,
+    POWER_BAND_LOW,
+    POWER_BAND_CRITICAL,
+} power_band_t;
+
+/**
+ * @brief Brings up the selected telemetry transport for an upload wake
+ *
+ * Provided by the application, which owns the Wi-Fi credentials and broker
+ * settings. Returns once the client is started; the power manager waits for
+ * the broker session (or Thread attach) itself.
+ */
+typedef esp_err_t (*power_uplink_fn_t)(void);
+
+/**
+ * @brief Load the low-power settings and classify the current boot
+ *
+ * Call once early in app_main, after NVS is initialized.
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t power_manager_init(void);
+
+/**
+ * @brief Check if this boot is a duty-cycle wake from deep sleep
+ *
+ * True only for timer wakes with low-power mode enabled; reset, power-on and
+ * button boots always run the full startup.
+ */
+bool power_manager_is_duty_wake(void);
+
+/**
+ * @brief Register the uplink used by upload wakes
+ */
+void power_manager_set_uplink(power_uplink_fn_t uplink);
+
+/**
+ * @brief Run one duty-cycle wake and go back to deep sleep (does not return)
+ *
+ * Samples the sensors, stores the reading in RTC memory and, when the batch
+ * is full, brings up the telemetry transport just long enough to publish it.
+ */
+void power_manager_run_wake(void);
+
+/**
+ * @brief Check if the running system should enter duty-cycled sleep
+ *
+ * @return true if low-power mode is enabled, a battery monitor is present and
+ *         the cold-boot awake window has passed
+ */
+bool power_manager_should_sleep(void);
+
+/**
+ * @brief Put the EZO boards to sleep and enter deep sleep (does not return)
+ */
+void power_manager_enter_sleep(void);
+
+/**
+ * @brief Band for a state of charge
+ *
+ * Falling SOC changes band at the threshold; rising SOC only leaves a band
+ * POWER_BAND_HYSTERESIS_PCT above it, so readings around a threshold do not
+ * flip the intervals back and forth.
+ *
+ * @param soc_percent State of charge, or a negative value if unknown (POWER_BAND_NORMAL)
+ * @param current Band in effect now
+ * @return New band
+ */
+power_band_t power_manager_battery_band(float soc_percent, power_band_t current);
+
+/**
+ * @brief Interval multiplier of a band (1, 2, 4 or 8)
+ */
+uint32_t power_manager_band_factor(power_band_t band);
+
+/**
+ * @brief Whether EZO boards sleep between reads in a band
+ */
+bool power_manager_band_sleeps_ezo(power_band_t band);
+
+/**
+ * @brief Band name ("normal", "reduced", "low", "critical")
+ */
+const char *power_band_to_string(power_band_t band);
+
+/**
+ * @brief Sleep period for a battery state of charge
+ *
+ * @param soc_percent State of charge, or a negative value if unknown
+ * @return Seconds until the next wake
+ */
+uint32_t power_manager_sleep_period_sec(float soc_percent);
+
+/**
+ * @brief Enable or disable low-power mode (saved to NVS)
+ *
+ * @param enable true to duty-cycle battery nodes
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t power_manager_set_low_power(bool enable);
+
+/**
+ * @brief Check if low-power mode is enabled
+ */
+bool power_manager_get_low_power(void);
+
+/**
+ * @brief Set the base sleep period (saved to NVS)
+ *
+ * @param interval_sec Seconds between wakes at a healthy battery
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG below POWER_MIN_INTERVAL_SEC
+ */
+esp_err_t power_manager_set_interval(uint32_t interval_sec);
+
+/**
+ * @brief Get the base sleep period in seconds
+ */
+uint32_t power_manager_get_interval(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,392 @@
+/**
+ * @file sensor_history.c
+ * @brief On-device sensor time-series history implementation
+ */
+
+#include "sensor_history.h"
+#include "sensor_manager.h"
+#include "time_sync.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+static const char *TAG = "SENSOR_HIST";
+
+#define HISTORY_RAW_CAPACITY    3600    // One hour at the fastest (1 s) reading interval
+#define HISTORY_1MIN_CAPACITY   1440    // 24 hours
+#define HISTORY_10MIN_CAPACITY  1008    // 7 days
+
+typedef struct {
+    uint32_t capacity;
+    uint32_t bucket_sec;        // 0 for the raw tier
+    uint32_t head;              // Next slot to write
+    uint32_t count;
+    uint32_t *timestamps;       // Seconds since boot
+    float *mean;                // Columnar: [channel * capacity + slot]
+    float *min;                 // NULL for the raw tier
+    float *max;
+    // Open rollup bucket
+    bool acc_open;
+    uint32_t acc_start;
+    float acc_min[SENSOR_HISTORY_MAX_CHANNELS];
+    float acc_max[SENSOR_HISTORY_MAX_CHANNELS];
+    float acc_sum[SENSOR_HISTORY_MAX_CHANNELS];
+    uint16_t acc_count[SENSOR_HISTORY_MAX_CHANNELS];
+} history_tier_t;
+
+static history_tier_t s_tiers[SENSOR_HISTORY_RES_COUNT] = {
+    [SENSOR_HISTORY_RES_RAW]   = { .capacity = HISTORY_RAW_CAPACITY,   .bucket_sec = 0 },
+    [SENSOR_HISTORY_RES_1MIN]  = { .capacity = HISTORY_1MIN_CAPACITY,  .bucket_sec = 60 },
+    [SENSOR_HISTORY_RES_10MIN] = { .capacity = HISTORY_10MIN_CAPACITY, .bucket_sec = 600 },
+};
+
+static sensor_history_channel_t s_channels[SENSOR_HISTORY_MAX_CHANNELS];
+static uint8_t s_channel_count = 0;
+static uint64_t s_channel_last_us[SENSOR_HISTORY_MAX_CHANNELS] = {0};  // Acquisition time of last recorded value
+static SemaphoreHandle_t s_history_mutex = NULL;
+static bool s_history_enabled = false;
+
+static uint32_t history_uptime_sec(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000000LL);
+}
+
+// Offset from seconds-since-boot to the reporting clock
+static int64_t history_clock_offset(void) {
+    if (!time_sync_is_synced()) {
+        return 0;
+    }
+    return (int64_t)time(NULL) - (int64_t)history_uptime_sec();
+}
+
+static void *history_alloc(size_t count, size_t size) {
+    return heap_caps_calloc(count, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+static esp_err_t history_tier_alloc(history_tier_t *tier) {
+    size_t cells = (size_t)tier->capacity * SENSOR_HISTORY_MAX_CHANNELS;
+    tier->timestamps = history_alloc(tier->capacity, sizeof(uint32_t));
+    tier->mean = history_alloc(cells, sizeof(float));
+    if (tier->bucket_sec > 0) {
+        tier->min = history_alloc(cells, sizeof(float));
+        tier->max = history_alloc(cells, sizeof(float));
+    }
+
+    if (tier->timestamps == NULL || tier->mean == NULL ||
+        (tier->bucket_sec > 0 && (tier->min == NULL || tier->max == NULL))) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static void history_tier_free(history_tier_t *tier) {
+    heap_caps_free(tier->timestamps);
+    heap_caps_free(tier->mean);
+    heap_caps_free(tier->min);
+    heap_caps_free(tier->max);
+    tier->timestamps = NULL;
+    tier->mean = NULL;
+    tier->min = NULL;
+    tier->max = NULL;
+}
+
+static void history_tier_push(history_tier_t *tier, uint32_t timestamp,
+                              const float *mean, const float *min, const float *max) {
+    uint32_t slot = tier->head;
+    tier->timestamps[slot] = timestamp;
+    for (uint8_t ch = 0; ch < SENSOR_HISTORY_MAX_CHANNELS; ch++) {
+        size_t cell = (size_t)ch * tier->capacity + slot;
+        tier->mean[cell] = mean[ch];
+        if (tier->min != NULL) {
+            tier->min[cell] = min[ch];
+            tier->max[cell] = max[ch];
+        }
+    }
+
+    tier->head = (tier->head + 1) % tier->capacity;
+    if (tier->count < tier->capacity) {
+        tier->count++;
+    }
+}
+
+static void history_tier_acc_reset(history_tier_t *tier, uint32_t bucket_start) {
+    tier->acc_open = true;
+    tier->acc_start = bucket_start;
+    memset(tier->acc_sum, 0, sizeof(tier->acc_sum));
+    memset(tier->acc_count, 0, sizeof(tier->acc_count));
+}
+
+// Fill mean/min/max from the open bucket; channels without samples become NAN
+static void history_tier_acc_values(const history_tier_t *tier, float *mean, float *min, float *max) {
+    for (uint8_t ch = 0; ch < SENSOR_HISTORY_MAX_CHANNELS; ch++) {
+        if (tier->acc_count[ch] > 0) {
+            mean[ch] = tier->acc_sum[ch] / tier->acc_count[ch];
+            min[ch] = tier->acc_min[ch];
+            max[ch] = tier->acc_max[ch];
+        } else {
+            mean[ch] = NAN;
+            min[ch] = NAN;
+            max[ch] = NAN;
+        }
+    }
+}
+
+static void history_tier_add(history_tier_t *tier, uint32_t timestamp, const float *values) {
+    if (tier->bucket_sec == 0) {
+        history_tier_push(tier, timestamp, values, NULL, NULL);
+        return;
+    }
+
+    uint32_t bucket_start = timestamp - (timestamp % tier->bucket_sec);
+    if (tier->acc_open && bucket_start != tier->acc_start) {
+        float mean[SENSOR_HISTORY_MAX_CHANNELS];
+        float min[SENSOR_HISTORY_MAX_CHANNELS];
+        float max[SENSOR_HISTORY_MAX_CHANNELS];
+        history_tier_acc_values(tier, mean, min, max);
+        history_tier_push(tier, tier->acc_start, mean, min, max);
+        tier->acc_open = false;
+    }
+    if (!tier->acc_open) {
+        history_tier_acc_reset(tier, bucket_start);
+    }
+
+    for (uint8_t ch = 0; ch < SENSOR_HISTORY_MAX_CHANNELS; ch++) {
+        float v = values[ch];
+        if (isnan(v)) {
+            continue;
+        }
+        if (tier->acc_count[ch] == 0) {
+            tier->acc_min[ch] = v;
+            tier->acc_max[ch] = v;
+        } else {
+            if (v < tier->acc_min[ch]) tier->acc_min[ch] = v;
+            if (v > tier->acc_max[ch]) tier->acc_max[ch] = v;
+        }
+        tier->acc_sum[ch] += v;
+        tier->acc_count[ch]++;
+    }
+}
+
+static int history_find_channel(const char *sensor_type, uint8_t address, uint8_t value_index) {
+    for (uint8_t ch = 0; ch < s_channel_count; ch++) {
+        if (s_channels[ch].value_index == value_index && s_channels[ch].address == address &&
+            strcmp(s_channels[ch].sensor_type, sensor_type) == 0) {
+            return ch;
+        }
+    }
+
+    if (s_channel_count >= SENSOR_HISTORY_MAX_CHANNELS) {
+        return -1;
+    }
+
+    sensor_history_channel_t *c = &s_channels[s_channel_count];
+    strncpy(c->sensor_type, sensor_type, sizeof(c->sensor_type) - 1);
+    c->sensor_type[sizeof(c->sensor_type) - 1] = '\0';
+    c->value_index = value_index;
+    c->address = address;
+    ESP_LOGI(TAG, "New history channel %u: %s@0x%02X[%u]", s_channel_count, c->sensor_type, address, value_index);
+    return s_channel_count++;
+}
+
+static void history_cache_listener(const sensor_cache_t *cache, void *ctx) {
+    (void)ctx;
+
+    float values[SENSOR_HISTORY_MAX_CHANNELS];
+    for (uint8_t ch = 0; ch < SENSOR_HISTORY_MAX_CHANNELS; ch++) {
+        values[ch] = NAN;
+    }
+
+    xSemaphoreTake(s_history_mutex, portMAX_DELAY);
+
+    bool any = false;
+    for (uint8_t i = 0; i < cache->sensor_count && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
+        const cached_sensor_t *sensor = &cache->sensors[i];
+        if (!sensor->valid) {
+            continue;
+        }
+        for (uint8_t v = 0; v < sensor->value_count && v < MAX_SENSOR_VALUES; v++) {
+            int ch = history_find_channel(sensor->sensor_type, sensor->address, v);
+            // Sensors that were not due this cycle carry old values forward; record each sample once
+            if (ch < 0 || sensor->timestamp_us == s_channel_last_us[ch]) {
+                continue;
+            }
+            s_channel_last_us[ch] = sensor->timestamp_us;
+            values[ch] = sensor->values[v];
+            any = true;
+        }
+    }
+
+    if (cache->battery_valid) {
+        int ch = history_find_channel("battery", 0, 0);
+        if (ch >= 0) {
+            values[ch] = cache->battery_percentage;
+            any = true;
+        }
+    }
+
+    if (any) {
+        uint32_t timestamp = (uint32_t)(cache->timestamp_us / 1000000ULL);
+        for (int t = 0; t < SENSOR_HISTORY_RES_COUNT; t++) {
+            history_tier_add(&s_tiers[t], timestamp, values);
+        }
+    }
+
+    xSemaphoreGive(s_history_mutex);
+}
+
+esp_err_t sensor_history_init(void) {
+    if (s_history_enabled) {
+        return ESP_OK;
+    }
+
+#ifndef CONFIG_SPIRAM
+    ESP_LOGI(TAG, "No PSRAM, sensor history disabled");
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+    s_history_mutex = xSemaphoreCreateMutex();
+    if (s_history_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t total = 0;
+    for (int t = 0; t < SENSOR_HISTORY_RES_COUNT; t++) {
+        history_tier_t *tier = &s_tiers[t];
+        if (history_tier_alloc(tier) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to allocate history tier %d", t);
+            for (int f = 0; f <= t; f++) {
+                history_tier_free(&s_tiers[f]);
+            }
+            vSemaphoreDelete(s_history_mutex);
+            s_history_mutex = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+        size_t columns = (tier->bucket_sec > 0) ? 3 : 1;
+        total += tier->capacity * (sizeof(uint32_t) + columns * SENSOR_HISTORY_MAX_CHANNELS * sizeof(float));
+    }
+
+    esp_err_t ret = sensor_manager_register_cache_listener(history_cache_listener, NULL);
+    if (ret != ESP_OK) {
+        for (int t = 0; t < SENSOR_HISTORY_RES_COUNT; t++) {
+            history_tier_free(&s_tiers[t]);
+        }
+        vSemaphoreDelete(s_history_mutex);
+        s_history_mutex = NULL;
+        return ret;
+    }
+
+    s_history_enabled = true;
+    ESP_LOGI(TAG, "✓ Sensor history ready (%u KB PSRAM)", (unsigned)(total / 1024));
+    return ESP_OK;
+#endif
+}
+
+bool sensor_history_is_enabled(void) {
+    return s_history_enabled;
+}
+
+uint8_t sensor_history_get_channels(sensor_history_channel_t *channels, uint8_t max_channels) {
+    if (!s_history_enabled || channels == NULL) {
+        return 0;
+    }
+
+    xSemaphoreTake(s_history_mutex, portMAX_DELAY);
+    uint8_t count = s_channel_count < max_channels ? s_channel_count : max_channels;
+    memcpy(channels, s_channels, count * sizeof(sensor_history_channel_t));
+    xSemaphoreGive(s_history_mutex);
+    return count;
+}
+
+bool sensor_history_clock_is_unix(void) {
+    return time_sync_is_synced();
+}
+
+uint32_t sensor_history_now(void) {
+    return (uint32_t)(history_uptime_sec() + history_clock_offset());
+}
+
+uint32_t sensor_history_bucket_sec(sensor_history_resolution_t resolution) {
+    if (resolution >= SENSOR_HISTORY_RES_COUNT) {
+        return 0;
+    }
+    return s_tiers[resolution].bucket_sec;
+}
+
+sensor_history_resolution_t sensor_history_pick_resolution(uint32_t span_sec) {
+    if (span_sec <= 3600) {
+        return SENSOR_HISTORY_RES_RAW;
+    }
+    if (span_sec <= 24 * 3600) {
+        return SENSOR_HISTORY_RES_1MIN;
+    }
+    return SENSOR_HISTORY_RES_10MIN;
+}
+
+static void history_fill_row(const history_tier_t *tier, uint32_t slot, int64_t offset,
+                             sensor_history_row_t *row) {
+    row->timestamp = (uint32_t)(tier->timestamps[slot] + offset);
+    for (uint8_t ch = 0; ch < SENSOR_HISTORY_MAX_CHANNELS; ch++) {
+        size_t cell = (size_t)ch * tier->capacity + slot;
+        row->mean[ch] = tier->mean[cell];
+        row->min[ch] = tier->min != NULL ? tier->min[cell] : tier->mean[cell];
+        row->max[ch] = tier->max != NULL ? tier->max[cell] : tier->mean[cell];
+    }
+}
+
+size_t sensor_history_read(sensor_history_resolution_t resolution, uint32_t from, uint32_t to,
+                           sensor_history_row_t *rows, size_t max_rows) {
+    if (!s_history_enabled || resolution >= SENSOR_HISTORY_RES_COUNT || rows == NULL || max_rows == 0) {
+        return 0;
+    }
+
+    // Translate the query window into seconds since boot
+    int64_t offset = history_clock_offset();
+    int64_t from_up = (int64_t)from - offset;
+    int64_t to_up = (int64_t)to - offset;
+    if (to_up < 0 || to_up < from_up) {
+        return 0;
+    }
+    if (from_up < 0) {
+        from_up = 0;
+    }
+
+    xSemaphoreTake(s_history_mutex, portMAX_DELAY);
+
+    const history_tier_t *tier = &s_tiers[resolution];
+    uint32_t oldest = (tier->head + tier->capacity - tier->count) % tier->capacity;
+
+    // Timestamps are monotonic, so binary search for the first row >= from
+    uint32_t lo = 0;
+    uint32_t hi = tier->count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        uint32_t slot = (oldest + mid) % tier->capacity;
+        if ((int64_t)tier->timestamps[slot] < from_up) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    size_t written = 0;
+    for (uint32_t i = lo; i < tier->count && written < max_rows; i++) {
+        uint32_t slot = (oldest + i) % tier->capacity;
+        if ((int64_t)tier->timestamps[slot] > to_up) {
+            break;
+        }
+        history_fill_row(tier, slot, offset, &rows[written++]);
+    }
+
+    if (written < max_rows && tier->acc_open &&
+        (int64_t)tier->acc_start >= from_up && (int64_t)tier->acc_start <= to_up) {
+        sensor_history_row_t *row = &rows[written++];
+        row->timestamp = (uint32_t)(tier->acc_start + offset);
+        history_tier_acc_values(tier, row->mean, row->min, row->max);
+    }
+
+    xSemaphoreGive(s_history_mutex);
+    return written;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file sensor_history.h
+ * @brief On-device sensor time-series history with multi-resolution rollups
+ *
+ * Samples published by the sensor manager are kept in PSRAM ring buffers:
+ * raw samples for the last hour, plus min/max/mean rollups in 1-minute
+ * buckets (24 h) and 10-minute buckets (7 days). Storage is columnar, one
+ * contiguous array per channel, where a channel is one value of one sensor.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SENSOR_HISTORY_MAX_CHANNELS 32
+
+/**
+ * @brief History tier
+ */
+typedef enum {
+    SENSOR_HISTORY_RES_RAW = 0,     // Every published sample, last hour
+    SENSOR_HISTORY_RES_1MIN,        // 1-minute rollups, last 24 hours
+    SENSOR_HISTORY_RES_10MIN,       // 10-minute rollups, last 7 days
+    SENSOR_HISTORY_RES_COUNT
+} sensor_history_resolution_t;
+
+/**
+ * @brief Channel descriptor (one value of one sensor)
+ */
+typedef struct {
+    char sensor_type[16];           // EZO type string, or "battery"
+    uint8_t value_index;            // Index into the sensor's value array
+    uint8_t address;                // I2C address of the board (0 for battery), so same-type boards stay apart
+} sensor_history_channel_t;
+
+/**
+ * @brief One history row; channels without data in the row are NAN
+ *
+ * For the raw tier min, max and mean are all the sample value.
+ */
+typedef struct {
+    uint32_t timestamp;             // Bucket start, in the clock reported by sensor_history_clock_is_unix()
+    float mean[SENSOR_HISTORY_MAX_CHANNELS];
+    float min[SENSOR_HISTORY_MAX_CHANNELS];
+    float max[SENSOR_HISTORY_MAX_CHANNELS];
+} sensor_history_row_t;
+
+/**
+ * @brief Allocate history buffers and subscribe to sensor cache updates
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_SUPPORTED without PSRAM,
+ *         ESP_ERR_NO_MEM if the buffers cannot be allocated
+ */
+esp_err_t sensor_history_init(void);
+
+/**
+ * @brief Check if history recording is active
+ */
+bool sensor_history_is_enabled(void);
+
+/**
+ * @brief Get the channels seen so far (column order of every row)
+ *
+ * @param channels Output array
+ * @param max_channels Capacity of the output array
+ * @return Number of channels written
+ */
+uint8_t sensor_history_get_channels(sensor_history_channel_t *channels, uint8_t max_channels);
+
+/**
+ * @brief Check which clock history timestamps use
+ *
+ * @return true for Unix seconds (time synced), false for seconds since boot
+ */
+bool sensor_history_clock_is_unix(void);
+
+/**
+ * @brief Current time in the history clock
+ */
+uint32_t sensor_history_now(void);
+
+/**
+ * @brief Bucket width of a tier in seconds (0 for the raw tier)
+ */
+uint32_t sensor_history_bucket_sec(sensor_history_resolution_t resolution);
+
+/**
+ * @brief Pick the finest tier that still covers a time span
+ *
+ * @param span_sec Requested span in seconds
+ * @return Tier to query
+ */
+sensor_history_resolution_t sensor_history_pick_resolution(uint32_t span_sec);
+
+/**
+ * @brief Read rows with timestamps in [from, to], oldest first
+ *
+ * Call repeatedly with from set past the last returned timestamp to page
+ * through long ranges. The in-progress rollup bucket is returned as the last
+ * row so charts reach the current time.
+ *
+ * @param resolution Tier to read
+ * @param from First timestamp (inclusive)
+ * @param to Last timestamp (inclusive)
+ * @param rows Output rows
+ * @param max_rows Capacity of rows
+ * @return Number of rows written
+ */
+size_t sensor_history_read(sensor_history_resolution_t resolution, uint32_t from, uint32_t to,
+                           sensor_history_row_t *rows, size_t max_rows);
+
+#ifdef __cplusplus
+}
+#endif
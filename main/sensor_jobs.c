@@ -0,0 +1,209 @@
+/**
+ * @file sensor_jobs.c
+ * @brief Background executor for slow sensor actions requested over HTTP
+ */
+
+#include "sensor_jobs.h"
+#include "task_profile.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "SENSOR_JOBS";
+
+typedef struct {
+    sensor_job_info_t info;     // info.id == 0 marks a free slot
+    sensor_job_fn_t fn;
+    void *arg;
+    char *result;
+} sensor_job_t;
+
+static sensor_job_t s_jobs[SENSOR_JOBS_MAX];
+static SemaphoreHandle_t s_jobs_mutex = NULL;
+static QueueHandle_t s_job_queue = NULL;    // Slot indexes, oldest first
+static sensor_job_listener_t s_listener = NULL;
+static uint32_t s_next_id = 1;
+
+static void sensor_job_notify_locked(const sensor_job_t *job)
+{
+    if (s_listener != NULL) {
+        s_listener(&job->info, job->result);
+    }
+}
+
+static void sensor_jobs_task(void *arg)
+{
+    (void)arg;
+    uint8_t slot;
+    for (;;) {
+        if (xQueueReceive(s_job_queue, &slot, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+        sensor_job_t *job = &s_jobs[slot];
+        job->info.state = SENSOR_JOB_RUNNING;
+        sensor_job_fn_t fn = job->fn;
+        void *job_arg = job->arg;
+        uint32_t id = job->info.id;
+        sensor_job_notify_locked(job);
+        xSemaphoreGive(s_jobs_mutex);
+
+        ESP_LOGI(TAG, "Job %lu (%s) running", (unsigned long)id, job->info.kind);
+        sensor_job_output_t out = { 0 };
+        fn(job_arg, &out);
+        if (out.status == 0) {
+            out.status = (out.error == NULL) ? 200 : 500;
+        }
+
+        // Running slots are never evicted, so the slot still holds this job
+        xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+        job->fn = NULL;
+        job->arg = NULL;
+        job->result = out.result;
+        job->info.status = out.status;
+        job->info.error = out.error;
+        job->info.state = (out.error == NULL) ? SENSOR_JOB_SUCCEEDED : SENSOR_JOB_FAILED;
+        job->info.finished_us = esp_timer_get_time();
+        ESP_LOGI(TAG, "Job %lu (%s) %s in %lld ms%s%s", (unsigned long)id, job->info.kind,
+                 sensor_jobs_state_name(job->info.state),
+                 (long long)((job->info.finished_us - job->info.queued_us) / 1000),
+                 out.error != NULL ? ": " : "", out.error != NULL ? out.error : "");
+        sensor_job_notify_locked(job);
+        xSemaphoreGive(s_jobs_mutex);
+    }
+}
+
+esp_err_t sensor_jobs_init(sensor_job_listener_t listener)
+{
+    if (s_job_queue != NULL) {
+        return ESP_OK;
+    }
+
+    s_jobs_mutex = xSemaphoreCreateMutex();
+    s_job_queue = xQueueCreate(SENSOR_JOBS_MAX, sizeof(uint8_t));
+    if (s_jobs_mutex == NULL || s_job_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create job queue");
+        if (s_jobs_mutex != NULL) {
+            vSemaphoreDelete(s_jobs_mutex);
+            s_jobs_mutex = NULL;
+        }
+        if (s_job_queue != NULL) {
+            vQueueDelete(s_job_queue);
+            s_job_queue = NULL;
+        }
+        return ESP_ERR_NO_MEM;
+    }
+    s_listener = listener;
+
+    // Jobs spend their time waiting on the I2C arbiter, so they share its core
+    BaseType_t ret = task_profile_create(TASK_PROFILE_SENSOR_JOBS, sensor_jobs_task, NULL, NULL, NULL);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create job task");
+        vQueueDelete(s_job_queue);
+        s_job_queue = NULL;
+        vSemaphoreDelete(s_jobs_mutex);
+        s_jobs_mutex = NULL;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Sensor job executor ready");
+    return ESP_OK;
+}
+
+esp_err_t sensor_jobs_submit(const char *kind, uint8_t address, sensor_job_fn_t fn, void *arg, uint32_t *id)
+{
+    if (kind == NULL || fn == NULL || id == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_job_queue == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+
+    // A free slot, otherwise the job that finished longest ago
+    int slot = -1;
+    for (int i = 0; i < SENSOR_JOBS_MAX; i++) {
+        const sensor_job_info_t *info = &s_jobs[i].info;
+        if (info->id == 0) {
+            slot = i;
+            break;
+        }
+        if (info->finished_us != 0 &&
+            (slot < 0 || info->finished_us < s_jobs[slot].info.finished_us)) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        xSemaphoreGive(s_jobs_mutex);
+        ESP_LOGW(TAG, "Job queue full, rejecting %s", kind);
+        return ESP_ERR_NO_MEM;
+    }
+
+    sensor_job_t *job = &s_jobs[slot];
+    free(job->result);
+    memset(job, 0, sizeof(*job));
+    job->info.id = s_next_id++;
+    if (s_next_id == 0) {
+        s_next_id = 1;
+    }
+    strncpy(job->info.kind, kind, sizeof(job->info.kind) - 1);
+    job->info.address = address;
+    job->info.state = SENSOR_JOB_QUEUED;
+    job->info.queued_us = esp_timer_get_time();
+    job->fn = fn;
+    job->arg = arg;
+
+    // The queue holds SENSOR_JOBS_MAX entries and at most that many jobs are unfinished
+    uint8_t index = (uint8_t)slot;
+    xQueueSend(s_job_queue, &index, 0);
+    *id = job->info.id;
+    sensor_job_notify_locked(job);
+    xSemaphoreGive(s_jobs_mutex);
+    return ESP_OK;
+}
+
+esp_err_t sensor_jobs_get(uint32_t id, sensor_job_info_t *info, char **result)
+{
+    if (info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (result != NULL) {
+        *result = NULL;
+    }
+    if (s_jobs_mutex == NULL || id == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+    for (int i = 0; i < SENSOR_JOBS_MAX; i++) {
+        if (s_jobs[i].info.id == id) {
+            *info = s_jobs[i].info;
+            if (result != NULL && s_jobs[i].result != NULL) {
+                *result = strdup(s_jobs[i].result);
+            }
+            ret = ESP_OK;
+            break;
+        }
+    }
+    xSemaphoreGive(s_jobs_mutex);
+    return ret;
+}
+
+const char *sensor_jobs_state_name(sensor_job_state_t state)
+{
+    switch (state) {
+        case SENSOR_JOB_QUEUED:    return "queued";
+        case SENSOR_JOB_RUNNING:   return "running";
+        case SENSOR_JOB_SUCCEEDED: return "succeeded";
+        case SENSOR_JOB_FAILED:    return "failed";
+        default:                   return "unknown";
+    }
+}
@@ -0,0 +1,107 @@
+/**
+ * @file sensor_jobs.h
+ * @brief Background executor for slow sensor actions requested over HTTP
+ *
+ * Multi-command EZO sequences (configuration, mode and power changes,
+ * compensation, bus rescans) take hundreds of milliseconds to seconds. Run in
+ * a request handler, they would stall the single httpd task for every client.
+ * Handlers validate the request, submit a job and answer 202 with its id. One
+ * worker task runs the jobs in order. The table keeps the last
+ * SENSOR_JOBS_MAX jobs with their result so clients can fetch them later;
+ * each state change is also reported to a listener.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SENSOR_JOBS_MAX         8       // Queued, running and finished jobs kept
+#define SENSOR_JOB_KIND_MAX     16
+
+typedef enum {
+    SENSOR_JOB_QUEUED = 0,
+    SENSOR_JOB_RUNNING,
+    SENSOR_JOB_SUCCEEDED,
+    SENSOR_JOB_FAILED,
+} sensor_job_state_t;
+
+/**
+ * @brief What a job function reports back
+ */
+typedef struct {
+    int status;                 // HTTP status the synchronous endpoint would have answered with
+    const char *error;          // Static message, NULL on success
+    char *result;               // malloc'd JSON document handed to the table, or NULL
+} sensor_job_output_t;
+
+/**
+ * @brief Job body, run in the worker task
+ *
+ * The function owns arg and must release it. Leaving out->status at 0 means
+ * 200 when out->error is NULL and 500 otherwise.
+ */
+typedef void (*sensor_job_fn_t)(void *arg, sensor_job_output_t *out);
+
+typedef struct {
+    uint32_t id;
+    char kind[SENSOR_JOB_KIND_MAX];
+    uint8_t address;            // Board the job works on, 0 for bus-wide jobs
+    sensor_job_state_t state;
+    int status;
+    const char *error;
+    int64_t queued_us;
+    int64_t finished_us;        // 0 until the job ends
+} sensor_job_info_t;
+
+/**
+ * @brief Called on every state change, from the submitting or the worker task
+ *
+ * Runs with the job table locked: it must not call back into sensor_jobs.
+ *
+ * @param result Result document of a finished job, or NULL
+ */
+typedef void (*sensor_job_listener_t)(const sensor_job_info_t *info, const char *result);
+
+/**
+ * @brief Create the worker task (idempotent)
+ *
+ * @param listener Notified of state changes (may be NULL)
+ */
+esp_err_t sensor_jobs_init(sensor_job_listener_t listener);
+
+/**
+ * @brief Queue a job
+ *
+ * @param kind Short name reported with the job ("config", "rescan", ...)
+ * @param fn Job body
+ * @param arg Passed to fn, which owns it; stays with the caller when this fails
+ * @param id Output job id
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM when SENSOR_JOBS_MAX jobs
+ *         are still pending, ESP_ERR_INVALID_STATE before sensor_jobs_init()
+ */
+esp_err_t sensor_jobs_submit(const char *kind, uint8_t address, sensor_job_fn_t fn, void *arg, uint32_t *id);
+
+/**
+ * @brief Look up a job
+ *
+ * @param info Output snapshot of the job
+ * @param result Output copy of the result document for the caller to free
+ *        (NULL while there is none); may be NULL
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND for unknown or evicted ids
+ */
+esp_err_t sensor_jobs_get(uint32_t id, sensor_job_info_t *info, char **result);
+
+/**
+ * @brief Name of a job state ("queued", "running", "succeeded", "failed")
+ */
+const char *sensor_jobs_state_name(sensor_job_state_t state);
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,30 +7,107 @@
 #include "i2c_scanner.h"
 #include "max17048.h"
 #include "ezo_sensor.h"
-#include "mqtt_telemetry.h"
+#include "i2c_arbiter.h"
+#include "boot_profile.h"
+#include "trace_log.h"
+#include "settings_store.h"
+#include "signal_filter.h"
+#include "derived_metrics.h"
+#include "task_profile.h"
+#include "acq_stats.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_wifi.h"
-#include "nvs_flash.h"
-#include "nvs.h"
+#include "esp_attr.h"
+#include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include <string.h>
+#include <stdlib.h>
+#include <stdatomic.h>
 
 static const char *TAG = "SENSOR_MGR";
 
+_Static_assert(EZO_MAX_CHANNELS == MAX_SENSOR_VALUES, "cached_sensor_t.channels must match the EZO descriptors");
+_Static_assert(ACQ_STATS_MAX_SENSORS == SENSOR_MANAGER_MAX_SENSORS, "acq_stats slots must match the registry");
+
 // Sensor handles
 static max17048_t s_battery_monitor;
 static bool s_battery_available = false;
 
-#define MAX_EZO_SENSORS 5
-static ezo_sensor_t s_ezo_sensors[MAX_EZO_SENSORS];
+// State of charge, read by the reading task on a fuel-gauge alert or every CONFIG_KC_BATTERY_REFRESH_SEC
+#define SENSOR_BATTERY_ALERT_REFRESH_FACTOR 12  // Safety re-read stretch with the ALRT line wired
+#define SENSOR_EZO_SLEEP_MIN_INTERVAL_SEC   30  // Shorter intervals do not pay for the wake command
+static float s_battery_soc = 0.0f;
+static bool s_battery_soc_valid = false;
+static int64_t s_battery_read_us = 0;
+static bool s_battery_alert_line = false;
+static atomic_bool s_battery_alert = false;    // Set by the ALRT ISR, taken by the reading task
+static volatile power_band_t s_battery_band = POWER_BAND_NORMAL;
+
+static ezo_sensor_t s_ezo_sensors[SENSOR_MANAGER_MAX_SENSORS];
+static uint8_t s_ezo_bus[SENSOR_MANAGER_MAX_SENSORS];
 static uint8_t s_ezo_count = 0;
+static volatile bool s_ezo_offline[SENSOR_MANAGER_MAX_SENSORS];
+static uint8_t s_ezo_failures[SENSOR_MANAGER_MAX_SENSORS];  // Consecutive failed triggers (reading task)
+static atomic_uint s_registry_gen = 0;   // Bumped by deinit; hot-plug results of an older registry are dropped
+
+// Board read by another task (focus stream) and its latest reading, not yet used by a cycle
+static portMUX_TYPE s_external_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t s_external_address = 0;
+static bool s_external_fresh = false;
+static uint8_t s_external_count = 0;
+static float s_external_values[MAX_SENSOR_VALUES];
 
 #define SENSOR_TRIGGER_DELAY_MS 20
 #define SENSOR_WAIT_STEP_MS 50
 #define SENSOR_MIN_WAIT_MS 750
+#define SENSOR_POLL_FIRST_MS 250    // Earliest status poll after a trigger (polled mode)
+#define SENSOR_POLL_GRACE_MS 500    // Extra time past the nominal conversion delay before giving up
+#define SENSOR_SCHEDULE_SLACK_MS 250  // Sensors due within this window join the current cycle
+#define SENSOR_SCHEDULE_MIN_WAIT_MS 200
+#define SENSOR_PARALLEL_INIT 1      // Bring EZO boards up concurrently at boot
+#define SENSOR_INIT_WORKER_STACK 4096
+#define SENSOR_INIT_TIMEOUT_MS 15000
+#define SENSOR_HOTPLUG_INTERVAL_MS 30000
+#define SENSOR_HOTPLUG_OFFLINE_FAILURES 5   // Consecutive failed triggers before a board is taken offline
+#define SENSOR_HOTPLUG_QUEUE_LEN 4
+
+// Per-board conversion tracking for one acquisition cycle
+typedef struct {
+    bool pending;
+    bool fetched;
+    esp_err_t result;
+    int64_t trigger_us;
+    uint32_t deadline_ms;
+    uint32_t epoch;             // Arbiter epoch of the board at trigger time
+    float values[MAX_SENSOR_VALUES];
+    uint8_t value_count;
+    esp_err_t fetch_result;     // Result of a fetch queued on the board's bus
+    ezo_sensor_t *sensor;
+    acq_sensor_sample_t timing; // Bus and wait times for acq_stats
+} sensor_conversion_t;
+
+// One EZO board being brought up by an init worker
+typedef struct {
+    uint8_t address;
+    uint8_t bus;
+    i2c_master_bus_handle_t bus_handle;
+    ezo_sensor_t sensor;
+    esp_err_t result;
+    uint32_t duration_ms;
+    bool started;
+    SemaphoreHandle_t done;
+} ezo_init_job_t;
+
+// A board brought up by the hot-plug pass, handed to the reading task to install
+typedef struct {
+    ezo_sensor_t sensor;
+    uint8_t bus;
+    unsigned int gen;           // s_registry_gen when the pass started
+} sensor_hotplug_board_t;
 
 // EZO sensor type indices
 static int s_rtd_index = -1;  // Temperature
@@ -42,44 +119,284 @@ static int s_hum_index = -1;  // Humidity
 
 // Cached sensor readings (last successful values) - old per-sensor cache
 typedef struct {
-    float values[4];
+    float values[4];            // Conditioned
+    float raw_values[4];
     uint8_t count;
     bool valid;
+    bool temp_compensated;
     uint32_t timestamp_ms;
 } cached_sensor_data_t;
 
-static cached_sensor_data_t s_cached_readings[MAX_EZO_SENSORS] = {0};
+static cached_sensor_data_t s_cached_readings[SENSOR_MANAGER_MAX_SENSORS] = {0};
 #define CACHE_TIMEOUT_MS 300000  // 5 minutes - consider cached data stale after this
 
-// Global sensor cache for API access
-static sensor_cache_t s_sensor_cache = {0};
+// Global sensor cache for API access, double-buffered behind a sequence counter.
+// s_cache_seq is odd while a publish is filling the spare buffer; publish k
+// leaves snapshot k in s_cache_buffers[k & 1]. Readers copy without blocking
+// and retry only if the writer lapped them mid-copy. The mutex serializes
+// publishers, never readers.
+#define SENSOR_CACHE_READ_RETRIES 4
+static sensor_cache_t s_cache_buffers[2] = {0};
+static atomic_uint s_cache_seq = 0;
 static bool s_cache_valid = false;
 static SemaphoreHandle_t s_cache_mutex = NULL;
-static sensor_cache_listener_t s_cache_listener = NULL;
-static void *s_cache_listener_ctx = NULL;
+#define SENSOR_CACHE_MAX_LISTENERS 6
+typedef struct {
+    sensor_cache_listener_t fn;
+    void *ctx;
+} cache_listener_slot_t;
+static cache_listener_slot_t s_cache_listeners[SENSOR_CACHE_MAX_LISTENERS] = {0};
 
 // RTD temperature tracking for compensation
 static float s_last_rtd_temp = 25.0f;  // Default fallback temperature
 static int64_t s_last_rtd_timestamp_us = 0;  // Timestamp of last RTD reading
 #define RTD_TEMP_STALE_THRESHOLD_US (30 * 1000000)  // 30 seconds
 
+// Per-sensor sampling schedule (0 = follow s_reading_interval_sec)
+static uint32_t s_sensor_interval_sec[SENSOR_MANAGER_MAX_SENSORS] = {0};
+static int64_t s_sensor_last_read_us[SENSOR_MANAGER_MAX_SENSORS] = {0};
+
 // Background reading task
 static TaskHandle_t s_reading_task_handle = NULL;
+static TaskHandle_t s_hotplug_task_handle = NULL;
+static QueueHandle_t s_hotplug_queue = NULL;      // sensor_hotplug_board_t *, freed by the reading task
+static uint32_t s_hotplug_rejected[I2C_TOPOLOGY_WORDS];  // Answered but not an EZO board (hot-plug task)
+static SemaphoreHandle_t s_fetch_done = NULL;   // Counts queued fetches that completed
 static uint32_t s_reading_interval_sec = 10;
 static bool s_reading_paused = false;
 static bool s_reading_in_progress = false;
+static volatile uint32_t s_burst_until_ms = 0;  // Burst capture end (ms since boot), 0 = none
+static sensor_acq_mode_t s_acq_mode = SENSOR_ACQ_MODE_POLLED;
 static esp_err_t sensor_manager_refresh_settings_internal(void);
 
 // Forward declaration
 static void sensor_reading_task(void *arg);
 static uint32_t sensor_manager_get_conversion_delay_ms(const ezo_sensor_t *sensor);
 static bool sensor_manager_use_cached_value(uint8_t index, cached_sensor_t *target, uint32_t now_ms);
+static bool sensor_manager_poll_conversions(sensor_conversion_t *conv, uint8_t total_sensors);
+static void sensor_manager_load_schedules(void);
+static void sensor_manager_load_schedule(uint8_t i);
+static const sensor_cache_t *sensor_manager_published_cache(void);
+static void sensor_manager_publish_cache(const sensor_cache_t *cache);
+static uint32_t sensor_manager_effective_interval_sec(uint8_t index);
+static uint32_t sensor_manager_next_wait_ms(void);
+static void sensor_manager_setup_battery_alert(void);
+static void sensor_manager_recover_stalled_buses(void);
+
+/**
+ * @brief Point each kind's sensor index at its first online board
+ *
+ * The single-value readers and RTD compensation use these, so an offline
+ * board hands over to the next board of its kind.
+ */
+static void sensor_manager_map_kinds(void) {
+    int rtd = -1, ph = -1, ec = -1, dox = -1, orp = -1, hum = -1;
+    for (uint8_t i = 0; i < s_ezo_count; i++) {
+        if (s_ezo_offline[i]) {
+            continue;
+        }
+        switch (s_ezo_sensors[i].config.kind) {
+            case EZO_KIND_RTD: if (rtd < 0) rtd = i; break;
+            case EZO_KIND_PH:  if (ph < 0) ph = i; break;
+            case EZO_KIND_EC:  if (ec < 0) ec = i; break;
+            case EZO_KIND_DO:  if (dox < 0) dox = i; break;
+            case EZO_KIND_ORP: if (orp < 0) orp = i; break;
+            case EZO_KIND_HUM: if (hum < 0) hum = i; break;
+            default: break;
+        }
+    }
+    s_rtd_index = rtd;
+    s_ph_index = ph;
+    s_ec_index = ec;
+    s_do_index = dox;
+    s_orp_index = orp;
+    s_hum_index = hum;
+}
+
+/**
+ * @brief Store an initialized EZO board in a registry slot
+ */
+static void sensor_manager_store_ezo(uint8_t slot, const ezo_sensor_t *initialized, uint8_t bus) {
+    ezo_sensor_t *sensor = &s_ezo_sensors[slot];
+    *sensor = *initialized;
+    s_ezo_bus[slot] = bus;
+    s_ezo_offline[slot] = false;
+    s_ezo_failures[slot] = 0;
+    
+    ESP_LOGI(TAG, "✓ EZO sensor initialized: Type=%s, Name=%s, FW=%s, bus %u", 
+             sensor->config.type, sensor->config.name, sensor->config.firmware_version, bus);
+    
+    switch (sensor->config.kind) {
+        case EZO_KIND_RTD: ESP_LOGI(TAG, "  → Temperature sensor (RTD)"); break;
+        case EZO_KIND_PH:  ESP_LOGI(TAG, "  → pH sensor"); break;
+        case EZO_KIND_EC:  ESP_LOGI(TAG, "  → Electrical Conductivity sensor"); break;
+        case EZO_KIND_DO:  ESP_LOGI(TAG, "  → Dissolved Oxygen sensor"); break;
+        case EZO_KIND_ORP: ESP_LOGI(TAG, "  → ORP sensor"); break;
+        case EZO_KIND_HUM: ESP_LOGI(TAG, "  → Humidity sensor"); break;
+        default: break;
+    }
+}
+
+/**
+ * @brief Record an initialized EZO board and map its type to a sensor index
+ */
+static void sensor_manager_register_ezo(const ezo_sensor_t *initialized, uint8_t bus) {
+    sensor_manager_store_ezo(s_ezo_count, initialized, bus);
+    s_ezo_count++;
+    sensor_manager_map_kinds();
+}
+
+/**
+ * @brief Registry slot of the board at an address, -1 if none
+ */
+static int sensor_manager_find_slot(uint8_t address) {
+    for (uint8_t i = 0; i < s_ezo_count; i++) {
+        if (s_ezo_sensors[i].config.i2c_address == address) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Whether an address that answered may be an EZO board
+ *
+ * EZO addresses are configurable, so every device is a candidate except the
+ * fuel gauge and the parts the identify command could harm (an "i" written
+ * to an EEPROM lands in its memory).
+ */
+static bool sensor_manager_is_ezo_candidate(uint8_t address) {
+    if (address == MAX17048_I2C_ADDR) {
+        return false;
+    }
+    if (address >= 0x50 && address <= 0x57) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Boards at these addresses are kept even when they fail to identify
+ */
+static bool sensor_manager_is_default_ezo_address(uint8_t address) {
+    static const uint8_t defaults[] = {0x16, 0x63, 0x64, 0x6F};
+    for (size_t i = 0; i < sizeof(defaults); i++) {
+        if (defaults[i] == address) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void ezo_init_job_run(ezo_init_job_t *job) {
+    int64_t start_us = esp_timer_get_time();
+    job->result = ezo_sensor_init(&job->sensor, job->bus_handle, job->address);
+    job->duration_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+}
+
+static void ezo_init_worker(void *arg) {
+    ezo_init_job_t *job = (ezo_init_job_t *)arg;
+    ezo_init_job_run(job);
+    xSemaphoreGive(job->done);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Initialize all detected EZO boards
+ *
+ * Every device on every bus that may be an EZO board is brought up by its
+ * own short-lived worker task. Board init is dominated by per-command
+ * processing delays, so the boards' waits overlap on the bus instead of
+ * adding up. Boards are registered in bus then address order afterwards, so
+ * sensor indexes are the same as with sequential init. Falls back to
+ * sequential init if workers cannot be created.
+ */
+static void sensor_manager_init_ezo_boards(void) {
+    ezo_init_job_t *jobs = calloc(SENSOR_MANAGER_MAX_SENSORS, sizeof(ezo_init_job_t));
+    if (jobs == NULL) {
+        ESP_LOGE(TAG, "Out of memory for EZO init");
+        return;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    size_t job_count = 0;
+    for (uint8_t bus = 0; bus < i2c_scanner_get_bus_count(); bus++) {
+        uint32_t map[I2C_TOPOLOGY_WORDS];
+        i2c_scanner_get_bus_topology(bus, map);
+        for (uint8_t addr = 0x08; addr <= 0x77; addr++) {
+            if (!(map[addr >> 5] & (1u << (addr & 31))) || !sensor_manager_is_ezo_candidate(addr)) {
+                continue;
+            }
+            // Addresses identify boards everywhere, so the first bus to answer owns one
+            if (i2c_arbiter_get_device_bus(addr) != bus) {
+                ESP_LOGW(TAG, "Skipping 0x%02X on bus %u: address already used on bus %u",
+                         addr, bus, i2c_arbiter_get_device_bus(addr));
+                continue;
+            }
+            if (job_count >= SENSOR_MANAGER_MAX_SENSORS) {
+                ESP_LOGW(TAG, "Sensor registry full, ignoring 0x%02X on bus %u", addr, bus);
+                continue;
+            }
+            ESP_LOGI(TAG, "Candidate EZO sensor at 0x%02X on bus %u", addr, bus);
+
+            ezo_init_job_t *job = &jobs[job_count++];
+            job->address = addr;
+            job->bus = bus;
+            job->bus_handle = i2c_scanner_get_bus(bus);
+            job->result = ESP_FAIL;
+            job->done = xSemaphoreCreateBinary();
+
+#if SENSOR_PARALLEL_INIT
+            if (job->done != NULL &&
+                xTaskCreate(ezo_init_worker, "ezo_init", SENSOR_INIT_WORKER_STACK, job, 5, NULL) == pdPASS) {
+                job->started = true;
+                continue;
+            }
+            ESP_LOGW(TAG, "Parallel init unavailable for 0x%02X, initializing inline", job->address);
+#endif
+            ezo_init_job_run(job);
+        }
+    }
+
+    bool leaked = false;
+    for (size_t i = 0; i < job_count; i++) {
+        ezo_init_job_t *job = &jobs[i];
+        if (job->started && xSemaphoreTake(job->done, pdMS_TO_TICKS(SENSOR_INIT_TIMEOUT_MS)) != pdTRUE) {
+            // The worker still owns the job; keep the buffer alive rather than free it under it
+            ESP_LOGE(TAG, "Timed out initializing EZO sensor at 0x%02X", job->address);
+            boot_profile_ezo_init(job->address, SENSOR_INIT_TIMEOUT_MS, false);
+            leaked = true;
+            continue;
+        }
+        boot_profile_ezo_init(job->address, job->duration_ms, job->result == ESP_OK);
+        if (job->result == ESP_OK && (job->sensor.config.type[0] != '\0' ||
+                                      sensor_manager_is_default_ezo_address(job->address))) {
+            sensor_manager_register_ezo(&job->sensor, job->bus);
+        } else if (job->result == ESP_OK) {
+            // Answered on the bus but not as an EZO board
+            ESP_LOGI(TAG, "Device at 0x%02X is not an EZO board", job->address);
+            ezo_sensor_deinit(&job->sensor);
+        } else {
+            ESP_LOGW(TAG, "Failed to initialize EZO sensor at 0x%02X", job->address);
+        }
+        if (job->done != NULL) {
+            vSemaphoreDelete(job->done);
+        }
+    }
+
+    ESP_LOGI(TAG, "EZO init of %u board(s) took %lld ms", (unsigned)job_count,
+             (long long)((esp_timer_get_time() - start_us) / 1000));
+    if (!leaked) {
+        free(jobs);
+    }
+}
 
 /**
  * @brief Initialize all sensors
  */
 esp_err_t sensor_manager_init(void) {
     ESP_LOGI(TAG, "Initializing sensor manager");
+    acq_stats_init();
     
     i2c_master_bus_handle_t bus_handle = i2c_scanner_get_bus_handle();
     if (bus_handle == NULL) {
@@ -87,8 +404,9 @@ esp_err_t sensor_manager_init(void) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    // Initialize MAX17048 battery monitor at 0x36
-    if (i2c_scanner_device_exists(0x36)) {
+    // Initialize MAX17048 battery monitor at 0x36 (bus 0)
+    uint8_t battery_bus = 0;
+    if (i2c_scanner_find_device(MAX17048_I2C_ADDR, &battery_bus) && battery_bus == 0) {
         ESP_LOGI(TAG, "MAX17048 battery monitor detected at 0x36");
         esp_err_t ret = max17048_init(&s_battery_monitor, bus_handle);
         if (ret == ESP_OK) {
@@ -101,66 +419,22 @@ esp_err_t sensor_manager_init(void) {
                 max17048_read_soc(&s_battery_monitor, &soc) == ESP_OK) {
                 ESP_LOGI(TAG, "  Battery: %.2f V, %.1f%%", voltage, soc);
             }
+            sensor_manager_setup_battery_alert();
         } else {
             ESP_LOGW(TAG, "Failed to initialize MAX17048");
         }
     }
     
-    // Initialize EZO sensors
-    // Scan for EZO sensors at known addresses (excluding 0x36 which is MAX17048)
-    uint8_t ezo_addresses[] = {0x16, 0x63, 0x64, 0x6F};
+    // Initialize EZO sensors on every address found by the scan (see sensor_manager_is_ezo_candidate)
+    sensor_manager_init_ezo_boards();
     
-    for (int i = 0; i < sizeof(ezo_addresses) && s_ezo_count < MAX_EZO_SENSORS; i++) {
-        uint8_t addr = ezo_addresses[i];
-        
-        // Add inter-sensor delay to prevent I2C bus interference
-        // Each sensor takes ~2-3 seconds to initialize, but adding a short gap
-        // between sensors ensures the bus is completely settled
-        if (i > 0) {
-            ESP_LOGI(TAG, "Waiting 500ms before initializing next sensor...");
-            vTaskDelay(pdMS_TO_TICKS(500));
-        }
-        
-        if (i2c_scanner_device_exists(addr)) {
-            ESP_LOGI(TAG, "EZO sensor detected at 0x%02X", addr);
-            
-            esp_err_t ret = ezo_sensor_init(&s_ezo_sensors[s_ezo_count], bus_handle, addr);
-            if (ret == ESP_OK) {
-                ezo_sensor_t *sensor = &s_ezo_sensors[s_ezo_count];
-                
-                ESP_LOGI(TAG, "✓ EZO sensor initialized: Type=%s, Name=%s, FW=%s", 
-                         sensor->config.type, sensor->config.name, sensor->config.firmware_version);
-                
-                // Map sensor type to index
-                if (strcmp(sensor->config.type, EZO_TYPE_RTD) == 0) {
-                    s_rtd_index = s_ezo_count;
-                    ESP_LOGI(TAG, "  → Temperature sensor (RTD)");
-                } else if (strcmp(sensor->config.type, EZO_TYPE_PH) == 0) {
-                    s_ph_index = s_ezo_count;
-                    ESP_LOGI(TAG, "  → pH sensor");
-                } else if (strcmp(sensor->config.type, EZO_TYPE_EC) == 0) {
-                    s_ec_index = s_ezo_count;
-                    ESP_LOGI(TAG, "  → Electrical Conductivity sensor");
-                } else if (strcmp(sensor->config.type, EZO_TYPE_DO) == 0) {
-                    s_do_index = s_ezo_count;
-                    ESP_LOGI(TAG, "  → Dissolved Oxygen sensor");
-                } else if (strcmp(sensor->config.type, EZO_TYPE_ORP) == 0) {
-                    s_orp_index = s_ezo_count;
-                    ESP_LOGI(TAG, "  → ORP sensor");
-                } else if (strcmp(sensor->config.type, EZO_TYPE_HUM) == 0) {
-                    s_hum_index = s_ezo_count;
-                    ESP_LOGI(TAG, "  → Humidity sensor");
-                }
-                
-                s_ezo_count++;
-            } else {
-                ESP_LOGW(TAG, "Failed to initialize EZO sensor at 0x%02X", addr);
-            }
-        }
-    }
-    
-    ESP_LOGI(TAG, "Sensor manager initialized: Battery=%s, EZO sensors=%d",
-             s_battery_available ? "YES" : "NO", s_ezo_count);
+    ESP_LOGI(TAG, "Sensor manager initialized: Battery=%s, EZO sensors=%d, buses=%u",
+             s_battery_available ? "YES" : "NO", s_ezo_count, i2c_scanner_get_bus_count());
+
+    sensor_manager_load_schedules();
+
+    // Also restarts every channel's filter history, as slots may now hold other boards
+    signal_filter_init();
 
     esp_err_t settings_ret = sensor_manager_refresh_settings_internal();
     if (settings_ret != ESP_OK) {
@@ -176,8 +450,16 @@ esp_err_t sensor_manager_init(void) {
 esp_err_t sensor_manager_deinit(void) {
     // Deinitialize MAX17048
     if (s_battery_available) {
+#if CONFIG_KC_BATTERY_ALERT_GPIO >= 0
+        if (s_battery_alert_line) {
+            gpio_isr_handler_remove(CONFIG_KC_BATTERY_ALERT_GPIO);
+            s_battery_alert_line = false;
+        }
+#endif
         max17048_deinit(&s_battery_monitor);
         s_battery_available = false;
+        s_battery_soc_valid = false;
+        s_battery_band = POWER_BAND_NORMAL;
     }
     
     // Deinitialize EZO sensors
@@ -185,6 +467,10 @@ esp_err_t sensor_manager_deinit(void) {
         ezo_sensor_deinit(&s_ezo_sensors[i]);
     }
     s_ezo_count = 0;
+    atomic_fetch_add(&s_registry_gen, 1);
+    memset(s_ezo_bus, 0, sizeof(s_ezo_bus));
+    memset((void *)s_ezo_offline, 0, sizeof(s_ezo_offline));
+    memset(s_ezo_failures, 0, sizeof(s_ezo_failures));
     s_rtd_index = -1;
     s_ph_index = -1;
     s_ec_index = -1;
@@ -194,11 +480,117 @@ esp_err_t sensor_manager_deinit(void) {
     
     // Clear cached readings
     memset(s_cached_readings, 0, sizeof(s_cached_readings));
+    memset(s_sensor_interval_sec, 0, sizeof(s_sensor_interval_sec));
+    memset(s_sensor_last_read_us, 0, sizeof(s_sensor_last_read_us));
     
     ESP_LOGI(TAG, "Sensor manager deinitialized");
     return ESP_OK;
 }
 
+#if CONFIG_KC_BATTERY_ALERT_GPIO >= 0
+static void IRAM_ATTR sensor_manager_battery_isr(void *arg) {
+    (void)arg;
+    atomic_store(&s_battery_alert, true);
+}
+#endif
+
+/**
+ * @brief Let the fuel gauge signal SOC changes on ALRT instead of being read every cycle
+ *
+ * Runs before the reading task starts, so the gauge needs no bus session yet.
+ */
+static void sensor_manager_setup_battery_alert(void) {
+#if CONFIG_KC_BATTERY_ALERT_GPIO >= 0
+    // ALRT is open-drain and active low; the ISR goes in before the gauge is
+    // armed, so an alert raised while arming is not missed
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << CONFIG_KC_BATTERY_ALERT_GPIO),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_NEGEDGE,
+    };
+    esp_err_t ret = gpio_config(&io_conf);
+    if (ret == ESP_OK) {
+        ret = gpio_install_isr_service(0);
+        // ESP_ERR_INVALID_STATE: already installed (reset button)
+        ret = (ret == ESP_ERR_INVALID_STATE) ? ESP_OK : ret;
+    }
+    if (ret == ESP_OK) {
+        ret = gpio_isr_handler_add(CONFIG_KC_BATTERY_ALERT_GPIO, sensor_manager_battery_isr, NULL);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Battery alert GPIO%d unavailable: %s", CONFIG_KC_BATTERY_ALERT_GPIO, esp_err_to_name(ret));
+        return;
+    }
+
+    if (max17048_configure_alerts(&s_battery_monitor, CONFIG_KC_BATTERY_BAND_CRITICAL_PCT, true) != ESP_OK ||
+        max17048_clear_alerts(&s_battery_monitor, NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to configure MAX17048 alerts, reading SOC on a schedule");
+        gpio_isr_handler_remove(CONFIG_KC_BATTERY_ALERT_GPIO);
+        return;
+    }
+    s_battery_alert_line = true;
+
+    // A line still low after the clear produces no edge; take it as an alert now
+    if (gpio_get_level(CONFIG_KC_BATTERY_ALERT_GPIO) == 0) {
+        atomic_store(&s_battery_alert, true);
+    }
+    ESP_LOGI(TAG, "Battery SOC read on ALRT (GPIO%d)", CONFIG_KC_BATTERY_ALERT_GPIO);
+#endif
+}
+
+/**
+ * @brief Re-read the state of charge when the gauge raised an alert or the refresh period ran out
+ *
+ * SOC moves over hours, so the fuel gauge is off the bus on almost every cycle.
+ * A failed read keeps the last value and is retried next cycle.
+ */
+static void sensor_manager_refresh_battery(void) {
+    if (!s_battery_available) {
+        return;
+    }
+    int64_t now_us = esp_timer_get_time();
+    int64_t period_us = (int64_t)CONFIG_KC_BATTERY_REFRESH_SEC * 1000000LL *
+                        (s_battery_alert_line ? SENSOR_BATTERY_ALERT_REFRESH_FACTOR : 1);
+    bool alert = atomic_load(&s_battery_alert);
+    if (!alert && s_battery_soc_valid && now_us - s_battery_read_us < period_us) {
+        return;
+    }
+    if (i2c_scanner_bus_stalled(0)) {
+        return;  // Read again once the bus is recovered
+    }
+
+    // Taken here, so an alert raised from now on is seen by the next cycle
+    alert = atomic_exchange(&s_battery_alert, false) || alert;
+    float soc = 0.0f;
+    i2c_arbiter_begin(I2C_ARBITER_PRIO_SCHEDULED, MAX17048_I2C_ADDR);
+    if (alert) {
+        // Released before the read, so a change after it pulls ALRT low again
+        max17048_clear_alerts(&s_battery_monitor, NULL);
+    }
+    esp_err_t ret = max17048_read_soc(&s_battery_monitor, &soc);
+    i2c_scanner_note_result(MAX17048_I2C_ADDR, ret);
+    i2c_arbiter_end();
+    if (ret != ESP_OK) {
+        if (alert) {
+            atomic_store(&s_battery_alert, true);
+        }
+        return;
+    }
+
+    s_battery_soc = soc;
+    s_battery_soc_valid = true;
+    s_battery_read_us = now_us;
+
+    power_band_t band = power_manager_battery_band(soc, s_battery_band);
+    if (band != s_battery_band) {
+        ESP_LOGI(TAG, "Battery %.1f%%: %s band, intervals x%lu%s", soc, power_band_to_string(band),
+                 power_manager_band_factor(band), power_manager_band_sleeps_ezo(band) ? ", EZO sleep" : "");
+        s_battery_band = band;
+    }
+}
+
 /**
  * @brief Read battery voltage
  */
@@ -208,7 +600,10 @@ esp_err_t sensor_manager_read_battery_voltage(float *voltage) {
         return ESP_ERR_NOT_FOUND;
     }
     
-    return max17048_read_voltage(&s_battery_monitor, voltage);
+    i2c_arbiter_begin(I2C_ARBITER_PRIO_SCHEDULED, MAX17048_I2C_ADDR);
+    esp_err_t ret = max17048_read_voltage(&s_battery_monitor, voltage);
+    i2c_arbiter_end();
+    return ret;
 }
 
 /**
@@ -220,7 +615,21 @@ esp_err_t sensor_manager_read_battery_percentage(float *percentage) {
         return ESP_ERR_NOT_FOUND;
     }
     
-    return max17048_read_soc(&s_battery_monitor, percentage);
+    i2c_arbiter_begin(I2C_ARBITER_PRIO_SCHEDULED, MAX17048_I2C_ADDR);
+    esp_err_t ret = max17048_read_soc(&s_battery_monitor, percentage);
+    i2c_arbiter_end();
+    return ret;
+}
+
+/**
+ * @brief Read a single value from an EZO sensor inside a bus session
+ */
+static esp_err_t sensor_manager_read_single(int index, float *value) {
+    ezo_sensor_t *sensor = &s_ezo_sensors[index];
+    i2c_arbiter_begin(I2C_ARBITER_PRIO_SCHEDULED, sensor->config.i2c_address);
+    esp_err_t ret = ezo_sensor_read(sensor, value);
+    i2c_arbiter_end();
+    return ret;
 }
 
 /**
@@ -232,7 +641,7 @@ esp_err_t sensor_manager_read_temperature(float *temperature) {
         return ESP_ERR_NOT_FOUND;
     }
     
-    return ezo_sensor_read(&s_ezo_sensors[s_rtd_index], temperature);
+    return sensor_manager_read_single(s_rtd_index, temperature);
 }
 
 /**
@@ -244,7 +653,7 @@ esp_err_t sensor_manager_read_ph(float *ph) {
         return ESP_ERR_NOT_FOUND;
     }
     
-    return ezo_sensor_read(&s_ezo_sensors[s_ph_index], ph);
+    return sensor_manager_read_single(s_ph_index, ph);
 }
 
 /**
@@ -256,7 +665,7 @@ esp_err_t sensor_manager_read_ec(float *ec) {
         return ESP_ERR_NOT_FOUND;
     }
     
-    return ezo_sensor_read(&s_ezo_sensors[s_ec_index], ec);
+    return sensor_manager_read_single(s_ec_index, ec);
 }
 
 /**
@@ -268,7 +677,7 @@ esp_err_t sensor_manager_read_do(float *dox) {
         return ESP_ERR_NOT_FOUND;
     }
     
-    return ezo_sensor_read(&s_ezo_sensors[s_do_index], dox);
+    return sensor_manager_read_single(s_do_index, dox);
 }
 
 /**
@@ -280,7 +689,7 @@ esp_err_t sensor_manager_read_orp(float *orp) {
         return ESP_ERR_NOT_FOUND;
     }
     
-    return ezo_sensor_read(&s_ezo_sensors[s_orp_index], orp);
+    return sensor_manager_read_single(s_orp_index, orp);
 }
 
 /**
@@ -292,7 +701,7 @@ esp_err_t sensor_manager_read_humidity(float *humidity) {
         return ESP_ERR_NOT_FOUND;
     }
     
-    return ezo_sensor_read(&s_ezo_sensors[s_hum_index], humidity);
+    return sensor_manager_read_single(s_hum_index, humidity);
 }
 
 /**
@@ -309,6 +718,14 @@ bool sensor_manager_has_battery_monitor(void) {
     return s_battery_available;
 }
 
+power_band_t sensor_manager_get_battery_band(void) {
+    return s_battery_band;
+}
+
+uint8_t sensor_manager_get_ezo_bus(uint8_t index) {
+    return index < s_ezo_count ? s_ezo_bus[index] : 0;
+}
+
 /**
  * @brief Get EZO sensor handle by index
  */
@@ -340,13 +757,16 @@ esp_err_t sensor_manager_read_ezo_sensor(uint8_t index, char *sensor_type, float
     sensor_type[15] = '\0';
     
     // Try to read fresh data from sensor
+    i2c_arbiter_begin(I2C_ARBITER_PRIO_SCHEDULED, sensor->config.i2c_address);
     esp_err_t ret = ezo_sensor_read_all(sensor, values, count);
+    i2c_arbiter_end();
     
     if (ret == ESP_OK) {
         // Success - cache the new readings
         cached_sensor_data_t *cache = &s_cached_readings[index];
         for (uint8_t i = 0; i < *count && i < 4; i++) {
             cache->values[i] = values[i];
+            cache->raw_values[i] = values[i];
         }
         cache->count = *count;
         cache->valid = true;
@@ -379,11 +799,314 @@ esp_err_t sensor_manager_read_ezo_sensor(uint8_t index, char *sensor_type, float
 esp_err_t sensor_manager_rescan(void) {
     ESP_LOGI(TAG, "Rescanning I2C bus for sensors");
     
+    // Hold the whole bus while boards are torn down and re-probed
+    i2c_arbiter_begin(I2C_ARBITER_PRIO_MAINTENANCE, I2C_ARBITER_ADDR_ANY);
+
     // Deinitialize existing sensors
     sensor_manager_deinit();
     
+    // Full sweep so devices added since boot are found (and stored)
+    i2c_scanner_invalidate();
+    i2c_scanner_scan();
+    
     // Reinitialize all sensors
-    return sensor_manager_init();
+    esp_err_t ret = sensor_manager_init();
+    i2c_arbiter_end();
+    return ret;
+}
+
+/**
+ * @brief Probe, bring up and queue one board found by the hot-plug pass
+ *
+ * The board is initialized in a maintenance session of its own, so the
+ * other boards on the bus are only held off for that one init.
+ *
+ * @return true if a board was queued for the reading task
+ */
+static bool sensor_manager_hotplug_try(uint8_t bus, uint8_t address, unsigned int gen) {
+    uint32_t bit = 1u << (address & 31);
+    if (!i2c_scanner_probe_address(bus, address)) {
+        s_hotplug_rejected[address >> 5] &= ~bit;
+        return false;
+    }
+    if (s_hotplug_rejected[address >> 5] & bit) {
+        return false;
+    }
+
+    sensor_hotplug_board_t *board = calloc(1, sizeof(*board));
+    if (board == NULL) {
+        ESP_LOGW(TAG, "Out of memory for hot-plugged board at 0x%02X", address);
+        return false;
+    }
+    board->bus = bus;
+    board->gen = gen;
+
+    i2c_arbiter_begin(I2C_ARBITER_PRIO_MAINTENANCE, address);
+    esp_err_t ret = ezo_sensor_init(&board->sensor, i2c_scanner_get_bus(bus), address);
+    if (ret == ESP_OK) {
+        ezo_sensor_refresh_settings(&board->sensor);
+    }
+    i2c_arbiter_end();
+
+    bool accepted = (ret == ESP_OK) && (board->sensor.config.type[0] != '\0' ||
+                                        sensor_manager_is_default_ezo_address(address));
+    if (!accepted) {
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "Hot-plug: device at 0x%02X on bus %u is not an EZO board", address, bus);
+            ezo_sensor_deinit(&board->sensor);
+            s_hotplug_rejected[address >> 5] |= bit;
+        } else {
+            ESP_LOGW(TAG, "Hot-plug: failed to initialize 0x%02X on bus %u: %s", address, bus, esp_err_to_name(ret));
+        }
+        free(board);
+        return false;
+    }
+
+    if (xQueueSend(s_hotplug_queue, &board, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        ezo_sensor_deinit(&board->sensor);
+        free(board);
+        return false;
+    }
+    ESP_LOGI(TAG, "Hot-plug: %s board at 0x%02X on bus %u queued", board->sensor.config.type, address, bus);
+    xTaskNotifyGive(s_reading_task_handle);
+    return true;
+}
+
+/**
+ * @brief One incremental discovery pass over unclaimed addresses and offline boards
+ *
+ * Devices at registered online addresses are never touched, so their
+ * conversions are not disturbed.
+ */
+static void sensor_manager_hotplug_pass(void) {
+    unsigned int gen = atomic_load(&s_registry_gen);
+    uint8_t free_slots = SENSOR_MANAGER_MAX_SENSORS - s_ezo_count;
+
+    for (uint8_t bus = 0; bus < i2c_scanner_get_bus_count(); bus++) {
+        for (uint8_t addr = 0x08; addr <= 0x77; addr++) {
+            if (s_reading_paused || atomic_load(&s_registry_gen) != gen) {
+                return;
+            }
+            if (!sensor_manager_is_ezo_candidate(addr)) {
+                continue;
+            }
+            int slot = sensor_manager_find_slot(addr);
+            if (slot >= 0 && (!s_ezo_offline[slot] || s_ezo_bus[slot] != bus)) {
+                continue;
+            }
+            // Addresses identify boards everywhere, so one answering on another bus stays there
+            uint8_t owner = 0;
+            if (slot < 0 && i2c_scanner_find_device(addr, &owner) && owner != bus) {
+                continue;
+            }
+            if (slot < 0 && free_slots == 0) {
+                continue;
+            }
+            if (sensor_manager_hotplug_try(bus, addr, gen) && slot < 0) {
+                free_slots--;
+            }
+        }
+    }
+}
+
+static void sensor_hotplug_task(void *arg) {
+    (void)arg;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SENSOR_HOTPLUG_INTERVAL_MS));
+        if (!s_reading_paused) {
+            sensor_manager_hotplug_pass();
+        }
+    }
+}
+
+/**
+ * @brief Take a board offline after repeated failures; reading task only
+ */
+static void sensor_manager_note_trigger(uint8_t index, bool ok) {
+    if (ok) {
+        s_ezo_failures[index] = 0;
+        return;
+    }
+    if (s_ezo_offline[index] || ++s_ezo_failures[index] < SENSOR_HOTPLUG_OFFLINE_FAILURES) {
+        return;
+    }
+    s_ezo_offline[index] = true;
+    sensor_manager_map_kinds();
+    ESP_LOGW(TAG, "%s @0x%02X stopped answering, taken offline after %u failures",
+             s_ezo_sensors[index].config.type, s_ezo_sensors[index].config.i2c_address,
+             (unsigned)s_ezo_failures[index]);
+    if (s_hotplug_task_handle != NULL) {
+        xTaskNotifyGive(s_hotplug_task_handle);
+    }
+}
+
+/**
+ * @brief Install boards queued by the hot-plug pass; reading task only, between cycles
+ *
+ * A returning board takes back its offline slot under its address's bus
+ * session, so no interactive command is using the old handle. A new board
+ * is filled in before the count grows, so readers never see a partial slot.
+ */
+static void sensor_manager_apply_hotplug(void) {
+    sensor_hotplug_board_t *board = NULL;
+    while (s_hotplug_queue != NULL && xQueueReceive(s_hotplug_queue, &board, 0) == pdTRUE) {
+        uint8_t address = board->sensor.config.i2c_address;
+        int slot = sensor_manager_find_slot(address);
+        bool stale = (board->gen != atomic_load(&s_registry_gen)) ||
+                     (slot >= 0 && !s_ezo_offline[slot]) ||
+                     (slot < 0 && s_ezo_count >= SENSOR_MANAGER_MAX_SENSORS);
+        if (stale) {
+            ezo_sensor_deinit(&board->sensor);
+            free(board);
+            continue;
+        }
+
+        if (slot >= 0) {
+            i2c_arbiter_begin(I2C_ARBITER_PRIO_MAINTENANCE, address);
+            ezo_sensor_deinit(&s_ezo_sensors[slot]);
+            sensor_manager_store_ezo((uint8_t)slot, &board->sensor, board->bus);
+            i2c_arbiter_end();
+            ESP_LOGI(TAG, "Hot-plug: 0x%02X back online in slot %d", address, slot);
+        } else {
+            slot = s_ezo_count;
+            sensor_manager_store_ezo((uint8_t)slot, &board->sensor, board->bus);
+            atomic_thread_fence(memory_order_release);
+            s_ezo_count++;
+            ESP_LOGI(TAG, "Hot-plug: 0x%02X added in slot %d", address, slot);
+        }
+        memset(&s_cached_readings[slot], 0, sizeof(s_cached_readings[slot]));
+        s_sensor_last_read_us[slot] = 0;
+        sensor_manager_load_schedule((uint8_t)slot);
+        signal_filter_reset_slot((uint8_t)slot);
+        sensor_manager_map_kinds();
+        free(board);
+    }
+}
+
+/**
+ * @brief Rebuild stalled buses under the devices that use them; reading task only, end of cycle
+ *
+ * The controller can only be deleted with no device attached, so every
+ * handle on the bus is removed first and added to the new bus afterwards,
+ * all inside one interactive session so no command runs on a dangling
+ * handle. Boards keep their identity and settings; a board that does not
+ * come back is taken offline by its next failed triggers.
+ */
+static void sensor_manager_recover_stalled_buses(void) {
+    for (uint8_t bus = 0; bus < i2c_scanner_get_bus_count(); bus++) {
+        if (!i2c_scanner_recovery_due(bus)) {
+            continue;
+        }
+
+        // Boards the hot-plug pass initialized on the old bus
+        sensor_manager_apply_hotplug();
+
+        // Called outside any session, so a refused begin leaves nothing to end
+        esp_err_t begin_ret = i2c_arbiter_begin_bus(bus, I2C_ARBITER_PRIO_INTERACTIVE, I2C_ARBITER_ADDR_ANY);
+        if (begin_ret != ESP_OK) {
+            ESP_LOGW(TAG, "Bus %u recovery postponed, bus not granted: %s", bus, esp_err_to_name(begin_ret));
+            i2c_scanner_defer_recovery(bus);
+            continue;
+        }
+        bool battery_on_bus = s_battery_available && bus == 0;
+        if (battery_on_bus) {
+            max17048_deinit(&s_battery_monitor);
+        }
+        for (uint8_t i = 0; i < s_ezo_count; i++) {
+            if (s_ezo_bus[i] == bus) {
+                ezo_sensor_deinit(&s_ezo_sensors[i]);
+            }
+        }
+
+        i2c_scanner_recover_bus(bus);
+
+        // Attach even after a failed attempt, so the handles are valid until the retry
+        i2c_master_bus_handle_t handle = i2c_scanner_get_bus(bus);
+        if (handle != NULL) {
+            for (uint8_t i = 0; i < s_ezo_count; i++) {
+                if (s_ezo_bus[i] == bus) {
+                    ezo_sensor_attach(&s_ezo_sensors[i], handle);
+                }
+            }
+            if (battery_on_bus) {
+                if (max17048_init(&s_battery_monitor, handle) == ESP_OK) {
+                    atomic_store(&s_battery_alert, true);  // Re-read the gauge next cycle
+                } else {
+                    s_battery_available = false;
+                }
+            }
+        } else if (battery_on_bus) {
+            s_battery_available = false;
+        }
+        i2c_arbiter_end();
+    }
+}
+
+esp_err_t sensor_manager_request_discovery(void) {
+    if (s_hotplug_task_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xTaskNotifyGive(s_hotplug_task_handle);
+    return ESP_OK;
+}
+
+bool sensor_manager_is_ezo_offline(uint8_t address) {
+    int slot = sensor_manager_find_slot(address);
+    return slot >= 0 && s_ezo_offline[slot];
+}
+
+void sensor_manager_set_external_reader(uint8_t address) {
+    taskENTER_CRITICAL(&s_external_lock);
+    s_external_address = address;
+    s_external_fresh = false;
+    taskEXIT_CRITICAL(&s_external_lock);
+    if (address != 0) {
+        ESP_LOGI(TAG, "Board 0x%02X handed to an external reader", address);
+    } else {
+        ESP_LOGI(TAG, "External reader released its board");
+    }
+}
+
+void sensor_manager_submit_external_reading(uint8_t address, const float *values, uint8_t count) {
+    if (address == 0 || values == NULL || count == 0) {
+        return;
+    }
+    if (count > MAX_SENSOR_VALUES) {
+        count = MAX_SENSOR_VALUES;
+    }
+    taskENTER_CRITICAL(&s_external_lock);
+    if (address == s_external_address) {
+        memcpy(s_external_values, values, count * sizeof(float));
+        s_external_count = count;
+        s_external_fresh = true;
+    }
+    taskEXIT_CRITICAL(&s_external_lock);
+}
+
+static uint8_t sensor_manager_external_address(void) {
+    taskENTER_CRITICAL(&s_external_lock);
+    uint8_t address = s_external_address;
+    taskEXIT_CRITICAL(&s_external_lock);
+    return address;
+}
+
+/**
+ * @brief Take the external reader's reading of a board, once
+ *
+ * @return esp_err_t ESP_OK with a reading that arrived since the last call,
+ *         ESP_ERR_NOT_FOUND otherwise
+ */
+static esp_err_t sensor_manager_take_external_reading(uint8_t address, float *values, uint8_t *count) {
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    taskENTER_CRITICAL(&s_external_lock);
+    if (address == s_external_address && s_external_fresh) {
+        memcpy(values, s_external_values, s_external_count * sizeof(float));
+        *count = s_external_count;
+        s_external_fresh = false;
+        ret = ESP_OK;
+    }
+    taskEXIT_CRITICAL(&s_external_lock);
+    return ret;
 }
 
 static esp_err_t sensor_manager_refresh_settings_internal(void) {
@@ -397,7 +1120,10 @@ static esp_err_t sensor_manager_refresh_settings_internal(void) {
 
     for (uint8_t i = 0; i < s_ezo_count; i++) {
         ezo_sensor_t *sensor = &s_ezo_sensors[i];
+        // One short session per board so background reads interleave between them
+        i2c_arbiter_begin(I2C_ARBITER_PRIO_MAINTENANCE, sensor->config.i2c_address);
         esp_err_t ret = ezo_sensor_refresh_settings(sensor);
+        i2c_arbiter_end();
         if (ret != ESP_OK) {
             ESP_LOGW(TAG, "Failed to refresh settings for %s @ 0x%02X: %s",
                      sensor->config.type,
@@ -417,32 +1143,11 @@ static esp_err_t sensor_manager_refresh_settings_internal(void) {
 }
 
 static uint32_t sensor_manager_get_conversion_delay_ms(const ezo_sensor_t *sensor) {
-    if (sensor == NULL || sensor->config.type[0] == '\0') {
-        return 1000;
-    }
-
-    const char *type = sensor->config.type;
-    if (strcmp(type, EZO_TYPE_PH) == 0 || strcmp(type, EZO_TYPE_ORP) == 0) {
-        return 900;
-    }
-    if (strcmp(type, EZO_TYPE_EC) == 0) {
-        return 1000;
-    }
-    if (strcmp(type, EZO_TYPE_DO) == 0) {
-        return 1300;
-    }
-    if (strcmp(type, EZO_TYPE_RTD) == 0) {
-        return 600;
-    }
-    if (strcmp(type, EZO_TYPE_HUM) == 0) {
-        return 600;
-    }
-
-    return 1000;
+    return ezo_sensor_desc(sensor != NULL ? sensor->config.kind : EZO_KIND_UNKNOWN)->conversion_ms;
 }
 
 static bool sensor_manager_use_cached_value(uint8_t index, cached_sensor_t *target, uint32_t now_ms) {
-    if (index >= MAX_EZO_SENSORS || target == NULL) {
+    if (index >= SENSOR_MANAGER_MAX_SENSORS || target == NULL) {
         return false;
     }
 
@@ -464,8 +1169,290 @@ static bool sensor_manager_use_cached_value(uint8_t index, cached_sensor_t *targ
     }
     for (uint8_t i = 0; i < target->value_count; i++) {
         target->values[i] = cache->values[i];
+        target->raw_values[i] = cache->raw_values[i];
     }
     target->valid = true;
+    target->temp_compensated = cache->temp_compensated;
+    target->quality = SENSOR_QUALITY_HELD;
+    target->timestamp_us = (uint64_t)cache->timestamp_ms * 1000ULL;
+    return true;
+}
+
+static void sensor_manager_schedule_key(uint8_t address, char *key, size_t key_size) {
+    snprintf(key, key_size, "sched_%02x", address);
+}
+
+static void sensor_manager_load_schedule(uint8_t i) {
+    char key[16];
+    uint32_t interval = 0;
+    sensor_manager_schedule_key(s_ezo_sensors[i].config.i2c_address, key, sizeof(key));
+    s_sensor_interval_sec[i] = 0;
+    if (settings_store_get_named_u32(key, &interval) == ESP_OK) {
+        s_sensor_interval_sec[i] = interval;
+        ESP_LOGI(TAG, "Loaded schedule for %s @0x%02X: %lu seconds",
+                 s_ezo_sensors[i].config.type, s_ezo_sensors[i].config.i2c_address, interval);
+    }
+}
+
+static void sensor_manager_load_schedules(void) {
+    for (uint8_t i = 0; i < s_ezo_count; i++) {
+        sensor_manager_load_schedule(i);
+    }
+}
+
+static uint32_t sensor_manager_effective_interval_sec(uint8_t index) {
+    uint32_t interval = (index < SENSOR_MANAGER_MAX_SENSORS) ? s_sensor_interval_sec[index] : 0;
+    if (interval == 0) {
+        interval = s_reading_interval_sec;
+    }
+    interval *= power_manager_band_factor(s_battery_band);
+    return interval > 0 ? interval : 1;
+}
+
+static bool sensor_manager_in_burst(int64_t now_us) {
+    uint32_t until_ms = s_burst_until_ms;
+    return until_ms != 0 && (int32_t)(until_ms - (uint32_t)(now_us / 1000)) > 0;
+}
+
+static bool sensor_manager_sensor_is_due(uint8_t index, int64_t now_us) {
+    if (s_sensor_last_read_us[index] == 0 || sensor_manager_in_burst(now_us)) {
+        return true;
+    }
+    int64_t due_us = s_sensor_last_read_us[index] +
+                     (int64_t)sensor_manager_effective_interval_sec(index) * 1000000LL;
+    return now_us >= due_us - (int64_t)SENSOR_SCHEDULE_SLACK_MS * 1000LL;
+}
+
+/**
+ * @brief Time until the next sensor is due, capped at the global interval
+ */
+static uint32_t sensor_manager_next_wait_ms(void) {
+    int64_t now_us = esp_timer_get_time();
+    if (sensor_manager_in_burst(now_us)) {
+        return SENSOR_SCHEDULE_MIN_WAIT_MS;
+    }
+    uint32_t global_sec = (s_reading_interval_sec > 0 ? s_reading_interval_sec : 1) *
+                          power_manager_band_factor(s_battery_band);
+    int64_t earliest_us = now_us + (int64_t)global_sec * 1000000LL;
+
+    for (uint8_t i = 0; i < s_ezo_count; i++) {
+        if (s_ezo_offline[i]) {
+            continue;
+        }
+        int64_t due_us = s_sensor_last_read_us[i] +
+                         (int64_t)sensor_manager_effective_interval_sec(i) * 1000000LL;
+        if (due_us < earliest_us) {
+            earliest_us = due_us;
+        }
+    }
+
+    int64_t wait_ms = (earliest_us - now_us) / 1000;
+    if (wait_ms < SENSOR_SCHEDULE_MIN_WAIT_MS) {
+        wait_ms = SENSOR_SCHEDULE_MIN_WAIT_MS;
+    }
+    return (uint32_t)wait_ms;
+}
+
+/**
+ * @brief RTD compensation stays valid for at least two RTD sampling periods
+ */
+static int64_t sensor_manager_rtd_stale_threshold_us(void) {
+    int64_t threshold = RTD_TEMP_STALE_THRESHOLD_US;
+    if (s_rtd_index >= 0) {
+        int64_t rtd_period_us = (int64_t)sensor_manager_effective_interval_sec(s_rtd_index) * 2000000LL;
+        if (rtd_period_us > threshold) {
+            threshold = rtd_period_us;
+        }
+    }
+    return threshold;
+}
+
+/**
+ * @brief Current published cache snapshot (only stable from the publishing task)
+ */
+static const sensor_cache_t *sensor_manager_published_cache(void) {
+    return &s_cache_buffers[(atomic_load_explicit(&s_cache_seq, memory_order_acquire) >> 1) & 1];
+}
+
+/**
+ * @brief Publish a complete cache snapshot
+ *
+ * Fills the buffer readers are not using and flips it in; the mutex only covers
+ * this copy-and-swap.
+ */
+static void sensor_manager_publish_cache(const sensor_cache_t *cache) {
+    xSemaphoreTake(s_cache_mutex, portMAX_DELAY);
+    unsigned int seq = atomic_load_explicit(&s_cache_seq, memory_order_relaxed);
+    atomic_store_explicit(&s_cache_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&s_cache_buffers[((seq >> 1) + 1) & 1], cache, sizeof(sensor_cache_t));
+    atomic_store_explicit(&s_cache_seq, seq + 2, memory_order_release);
+    xSemaphoreGive(s_cache_mutex);
+}
+
+/**
+ * @brief Poll triggered boards until each reports ready or hits its deadline
+ *
+ * EZO boards answer a read with status 0xFE while a conversion is still running,
+ * so each board can be fetched as soon as it completes instead of waiting for the
+ * slowest board on the bus. Returns false if reading was paused mid-wait.
+ */
+static esp_err_t sensor_manager_check_epoch(const ezo_sensor_t *sensor, const sensor_conversion_t *conv,
+                                           esp_err_t result) {
+    if (result == ESP_OK && i2c_arbiter_get_epoch(sensor->config.i2c_address) != conv->epoch) {
+        // Another command reached the board mid-conversion; the response may be its reply
+        ESP_LOGD(TAG, "Discarding %s @0x%02X reading interleaved with another command",
+                 sensor->config.type, sensor->config.i2c_address);
+        return ESP_ERR_INVALID_STATE;
+    }
+    return result;
+}
+
+/**
+ * @brief Fetch a board's reading, adding the transfer to the conversion's timing
+ */
+static esp_err_t sensor_manager_fetch_timed(sensor_conversion_t *c, float *values, uint8_t *count) {
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = ezo_sensor_fetch_all(c->sensor, values, count);
+    uint32_t held_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+    c->timing.bus_us += held_us;
+    if (ret == ESP_ERR_NOT_FINISHED) {
+        c->timing.retries++;
+    } else if (ret != ESP_OK) {
+        c->timing.errors++;
+    } else {
+        c->timing.fetch_us = held_us;
+        c->timing.wait_us = (uint32_t)(start_us - c->trigger_us);
+    }
+    return ret;
+}
+
+static esp_err_t sensor_manager_fetch_txn(void *ctx) {
+    sensor_conversion_t *c = (sensor_conversion_t *)ctx;
+    return sensor_manager_fetch_timed(c, c->values, &c->value_count);
+}
+
+static void sensor_manager_fetch_done(esp_err_t result, void *ctx) {
+    ((sensor_conversion_t *)ctx)->fetch_result = result;
+    xSemaphoreGive(s_fetch_done);
+}
+
+/**
+ * @brief Fetch a batch of boards into conv[].fetch_result
+ *
+ * With more than one bus the fetches are queued on the boards' buses, so
+ * each bus's arbiter works through its own boards while the other buses do
+ * the same. With a single bus they run inline, one session per board.
+ */
+static void sensor_manager_fetch_batch(sensor_conversion_t *conv, const uint8_t *batch, uint8_t count) {
+    bool queued = (s_fetch_done != NULL && i2c_scanner_get_bus_count() > 1 && i2c_arbiter_is_running());
+    uint8_t submitted = 0;
+
+    for (uint8_t k = 0; k < count; k++) {
+        sensor_conversion_t *c = &conv[batch[k]];
+        uint8_t address = c->sensor->config.i2c_address;
+        if (queued && i2c_arbiter_submit(I2C_ARBITER_PRIO_SCHEDULED, address, sensor_manager_fetch_txn, c,
+                                         sensor_manager_fetch_done) == ESP_OK) {
+            submitted++;
+            continue;
+        }
+        i2c_arbiter_begin(I2C_ARBITER_PRIO_SCHEDULED, address);
+        c->fetch_result = sensor_manager_fetch_txn(c);
+        i2c_arbiter_end();
+    }
+
+    // The queued requests point into conv, so every one must complete before returning
+    for (; submitted > 0; submitted--) {
+        xSemaphoreTake(s_fetch_done, portMAX_DELAY);
+    }
+}
+
+/**
+ * @brief Registry indexes ordered round-robin across buses
+ *
+ * Consecutive triggers then land on different buses, so the per-board
+ * spacing only has to be kept once per round.
+ */
+static void sensor_manager_interleave_buses(uint8_t *order, uint8_t total_sensors) {
+    uint8_t placed = 0;
+    for (uint8_t round = 0; placed < total_sensors; round++) {
+        for (uint8_t bus = 0; bus < I2C_ARBITER_MAX_BUSES; bus++) {
+            uint8_t seen = 0;
+            for (uint8_t i = 0; i < total_sensors; i++) {
+                if (s_ezo_bus[i] == bus && seen++ == round) {
+                    order[placed++] = i;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static bool sensor_manager_poll_conversions(sensor_conversion_t *conv, uint8_t total_sensors) {
+    uint8_t pending_count = 0;
+    for (uint8_t i = 0; i < total_sensors; i++) {
+        if (conv[i].pending) {
+            pending_count++;
+        }
+    }
+
+    while (pending_count > 0) {
+        if (s_reading_paused) {
+            return false;
+        }
+
+        // A bus that stalled mid-cycle would only time out each fetch
+        for (uint8_t i = 0; i < total_sensors; i++) {
+            if (conv[i].pending && i2c_scanner_bus_stalled(s_ezo_bus[i])) {
+                conv[i].pending = false;
+                conv[i].fetched = true;
+                conv[i].result = ESP_ERR_TIMEOUT;
+                pending_count--;
+            }
+        }
+        if (pending_count == 0) {
+            break;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(SENSOR_WAIT_STEP_MS));
+
+        int64_t now_us = esp_timer_get_time();
+        uint8_t batch[SENSOR_MANAGER_MAX_SENSORS];
+        uint8_t batch_count = 0;
+        for (uint8_t i = 0; i < total_sensors; i++) {
+            if (conv[i].pending && (now_us - conv[i].trigger_us) / 1000 >= SENSOR_POLL_FIRST_MS) {
+                batch[batch_count++] = i;
+            }
+        }
+        sensor_manager_fetch_batch(conv, batch, batch_count);
+
+        for (uint8_t k = 0; k < batch_count; k++) {
+            uint8_t i = batch[k];
+            sensor_conversion_t *c = &conv[i];
+            ezo_sensor_t *sensor = c->sensor;
+            uint32_t elapsed_ms = (uint32_t)((now_us - c->trigger_us) / 1000);
+            esp_err_t ret = c->fetch_result;
+            if (ret == ESP_ERR_NOT_FINISHED && elapsed_ms < c->deadline_ms) {
+                continue;
+            }
+            ret = sensor_manager_check_epoch(sensor, c, ret);
+
+            c->pending = false;
+            c->fetched = true;
+            c->result = ret;
+            pending_count--;
+
+            if (ret == ESP_OK) {
+                trace_log_emit(TRACE_EV_EZO_READY, s_ezo_sensors[i].config.i2c_address, elapsed_ms, 0);
+            } else {
+                ESP_LOGW(TAG, "Sensor %s @0x%02X not ready after %lu ms: %s",
+                         s_ezo_sensors[i].config.type, s_ezo_sensors[i].config.i2c_address,
+                         (unsigned long)elapsed_ms, esp_err_to_name(ret));
+            }
+        }
+    }
+
     return true;
 }
 
@@ -491,27 +1478,30 @@ static void sensor_reading_task(void *arg) {
             continue;
         }
         
-        // Wait before next reading (except for first read)
+        // Wait until the next sensor is due (except for first read); a burst start cuts the wait short
         if (!first_read) {
-            vTaskDelay(pdMS_TO_TICKS(s_reading_interval_sec * 1000));
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sensor_manager_next_wait_ms()));
         }
         first_read = false;
         
+        // Registry changes from the hot-plug pass land between cycles
+        sensor_manager_apply_hotplug();
+        
         // Read all sensors
-        if (s_cache_mutex != NULL && xSemaphoreTake(s_cache_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        if (s_cache_mutex != NULL) {
             s_reading_in_progress = true;
+            // Only this task publishes, so the current snapshot is stable while the cycle runs
+            const sensor_cache_t *previous_cache = sensor_manager_published_cache();
 
             sensor_cache_t new_cache;
             memset(&new_cache, 0, sizeof(new_cache));
             new_cache.timestamp_us = esp_timer_get_time();
             
-            // Read battery
-            if (s_battery_available) {
-                float battery_pct;
-                if (sensor_manager_read_battery_percentage(&battery_pct) == ESP_OK) {
-                    new_cache.battery_percentage = battery_pct;
-                    new_cache.battery_valid = true;
-                }
+            // Battery: the gauge is only read on an alert or its refresh period
+            sensor_manager_refresh_battery();
+            if (s_battery_soc_valid) {
+                new_cache.battery_percentage = s_battery_soc;
+                new_cache.battery_valid = true;
             }
             
             // Read RSSI
@@ -521,46 +1511,85 @@ static void sensor_reading_task(void *arg) {
             }
             
             // Read all EZO sensors and keep cache slots aligned to physical indexes
-            const uint8_t cache_capacity = sizeof(s_sensor_cache.sensors) / sizeof(s_sensor_cache.sensors[0]);
+            const uint8_t cache_capacity = sizeof(new_cache.sensors) / sizeof(new_cache.sensors[0]);
             uint8_t total_sensors = s_ezo_count;
             if (total_sensors > cache_capacity) {
                 total_sensors = cache_capacity;
             }
             new_cache.sensor_count = total_sensors;
 
-            bool sensor_triggered[MAX_EZO_SENSORS] = {0};
+            // Decide which sensors are due this tick; the rest keep their previous values
+            bool sensor_due[SENSOR_MANAGER_MAX_SENSORS] = {0};
+            int64_t cycle_us = esp_timer_get_time();
+            for (uint8_t i = 0; i < total_sensors && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
+                // Sensors on a stalled bus keep their previous values until it is recovered
+                sensor_due[i] = !s_ezo_offline[i] && !i2c_scanner_bus_stalled(s_ezo_bus[i]) &&
+                                sensor_manager_sensor_is_due(i, cycle_us);
+            }
+            bool previous_cache_usable = s_cache_valid && previous_cache->sensor_count == total_sensors;
+            // A board the focus stream reads is not triggered; its readings come from the stream
+            const uint8_t external_address = sensor_manager_external_address();
+
+            bool sensor_triggered[SENSOR_MANAGER_MAX_SENSORS] = {0};
+            bool temp_comp_applied[SENSOR_MANAGER_MAX_SENSORS] = {0};
+            sensor_conversion_t conversions[SENSOR_MANAGER_MAX_SENSORS];
+            memset(conversions, 0, sizeof(conversions));
+            const bool polled_mode = (s_acq_mode == SENSOR_ACQ_MODE_POLLED);
             uint8_t triggered_count = 0;
             uint32_t max_wait_ms = 0;
             
             // Check if we have recent RTD temperature for compensation
             int64_t now_us = esp_timer_get_time();
-            bool rtd_temp_valid = (now_us - s_last_rtd_timestamp_us) < RTD_TEMP_STALE_THRESHOLD_US;
+            bool rtd_temp_valid = (now_us - s_last_rtd_timestamp_us) < sensor_manager_rtd_stale_threshold_us();
             float compensation_temp = rtd_temp_valid ? s_last_rtd_temp : 25.0f;
             
             if (!rtd_temp_valid && s_rtd_index >= 0) {
                 ESP_LOGD(TAG, "RTD temperature stale, using fallback 25°C for compensation");
             }
 
-            for (uint8_t i = 0; i < total_sensors; i++) {
+            uint8_t trigger_order[SENSOR_MANAGER_MAX_SENSORS];
+            sensor_manager_interleave_buses(trigger_order, total_sensors);
+
+            for (uint8_t k = 0; k < total_sensors; k++) {
                 if (s_reading_paused) {
-                    ESP_LOGI(TAG, "Sensor reading paused before trigger phase completed (%u/%u)", i, total_sensors);
+                    ESP_LOGI(TAG, "Sensor reading paused before trigger phase completed (%u/%u)", k, total_sensors);
                     break;
                 }
 
+                uint8_t i = trigger_order[k];
+                if (!sensor_due[i]) {
+                    continue;
+                }
+
                 ezo_sensor_t *sensor = &s_ezo_sensors[i];
+                conversions[i].sensor = sensor;
                 esp_err_t trigger_ret;
+                s_sensor_last_read_us[i] = cycle_us;
+                if (sensor->config.i2c_address == external_address) {
+                    continue;
+                }
                 
-                // Use temperature-compensated read for pH, EC, and ORP
-                const char *type = sensor->config.type;
-                bool needs_temp_comp = (strcmp(type, "pH") == 0 || 
-                                       strcmp(type, "EC") == 0 || 
-                                       strcmp(type, "ORP") == 0);
+                // Use temperature-compensated read for the kinds that take one (pH, EC, ORP)
+                bool needs_temp_comp = ezo_sensor_desc(sensor->config.kind)->temp_comp;
                 
+                i2c_arbiter_begin(I2C_ARBITER_PRIO_SCHEDULED, sensor->config.i2c_address);
+                if (sensor->config.sleeping) {
+                    // Put to sleep after its last read by the battery policy
+                    ezo_sensor_wake(sensor);
+                }
+                int64_t trigger_start_us = esp_timer_get_time();
                 if (needs_temp_comp && rtd_temp_valid) {
                     trigger_ret = ezo_sensor_start_read_with_temp(sensor, compensation_temp);
+                    temp_comp_applied[i] = (trigger_ret == ESP_OK);
                 } else {
                     trigger_ret = ezo_sensor_start_read(sensor);
                 }
+                conversions[i].epoch = i2c_arbiter_get_epoch(sensor->config.i2c_address);
+                conversions[i].timing.trigger_us = (uint32_t)(esp_timer_get_time() - trigger_start_us);
+                i2c_arbiter_end();
+                conversions[i].timing.bus_us = conversions[i].timing.trigger_us;
+                conversions[i].timing.errors = (trigger_ret == ESP_OK) ? 0 : 1;
+                sensor_manager_note_trigger(i, trigger_ret == ESP_OK);
                 
                 if (trigger_ret == ESP_OK) {
                     sensor_triggered[i] = true;
@@ -569,6 +1598,9 @@ static void sensor_reading_task(void *arg) {
                     if (sensor_delay > max_wait_ms) {
                         max_wait_ms = sensor_delay;
                     }
+                    conversions[i].pending = true;
+                    conversions[i].trigger_us = esp_timer_get_time();
+                    conversions[i].deadline_ms = sensor_delay + SENSOR_POLL_GRACE_MS;
                 } else {
                     ESP_LOGW(TAG, "Failed to trigger sensor %s @0x%02X: %s",
                              sensor->config.type,
@@ -576,16 +1608,24 @@ static void sensor_reading_task(void *arg) {
                              esp_err_to_name(trigger_ret));
                 }
 
-                vTaskDelay(pdMS_TO_TICKS(SENSOR_TRIGGER_DELAY_MS));
+                // Only the next round returns to a bus that was just triggered
+                if (k + 1 == total_sensors || s_ezo_bus[trigger_order[k + 1]] <= s_ezo_bus[i]) {
+                    vTaskDelay(pdMS_TO_TICKS(SENSOR_TRIGGER_DELAY_MS));
+                }
             }
 
             if (s_reading_paused) {
                 s_reading_in_progress = false;
-                xSemaphoreGive(s_cache_mutex);
                 continue;
             }
 
-            if (triggered_count > 0) {
+            if (triggered_count > 0 && polled_mode) {
+                if (!sensor_manager_poll_conversions(conversions, total_sensors)) {
+                    ESP_LOGI(TAG, "Sensor reading paused while polling conversions");
+                    s_reading_in_progress = false;
+                    continue;
+                }
+            } else if (triggered_count > 0) {
                 if (max_wait_ms < SENSOR_MIN_WAIT_MS) {
                     max_wait_ms = SENSOR_MIN_WAIT_MS;
                 }
@@ -603,13 +1643,13 @@ static void sensor_reading_task(void *arg) {
                 if (s_reading_paused) {
                     ESP_LOGI(TAG, "Sensor reading paused while waiting for conversions");
                     s_reading_in_progress = false;
-                    xSemaphoreGive(s_cache_mutex);
                     continue;
                 }
             }
 
             uint8_t valid_sensors = 0;
             uint8_t sensors_processed = 0;
+            uint32_t cycle_bus_us = 0;
             for (uint8_t i = 0; i < total_sensors; i++) {
                 cached_sensor_t *cached = &new_cache.sensors[i];
                 memset(cached, 0, sizeof(*cached));
@@ -630,25 +1670,81 @@ static void sensor_reading_task(void *arg) {
                     snprintf(cached->sensor_type, sizeof(cached->sensor_type), "UNKNOWN_%02X", sensor->config.i2c_address);
                     ESP_LOGW(TAG, "Sensor at 0x%02X has invalid type, using fallback name", sensor->config.i2c_address);
                 }
+                cached->address = sensor->config.i2c_address;
+                cached->bus = s_ezo_bus[i];
+                cached->kind = sensor->config.kind;
+                memcpy(cached->channels, sensor->config.channels, sizeof(cached->channels));
+
+                if (s_ezo_offline[i]) {
+                    // Keeps its slot so the other boards' indexes stay put
+                    cached->offline = true;
+                    cached->valid = false;
+                    cached->quality = SENSOR_QUALITY_INVALID;
+                    sensors_processed++;
+                    continue;
+                }
+
+                if (!sensor_due[i]) {
+                    // Not scheduled this tick: carry the previous sample and its timestamp forward
+                    const cached_sensor_t *previous = &previous_cache->sensors[i];
+                    if (previous_cache_usable && previous->address == cached->address &&
+                        previous->kind == cached->kind) {
+                        *cached = *previous;
+                        memcpy(cached->channels, sensor->config.channels, sizeof(cached->channels));
+                        if (cached->valid) {
+                            valid_sensors++;
+                        }
+                    } else {
+                        uint32_t now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+                        cached->valid = sensor_manager_use_cached_value(i, cached, now_ms);
+                        if (!cached->valid) {
+                            cached->quality = SENSOR_QUALITY_INVALID;
+                        }
+                    }
+                    sensors_processed++;
+                    continue;
+                }
 
                 esp_err_t read_ret = ESP_FAIL;
-                if (sensor_triggered[i]) {
-                    read_ret = ezo_sensor_fetch_all(sensor, cached->values, &cached->value_count);
+                if (conversions[i].fetched) {
+                    read_ret = conversions[i].result;
+                    if (read_ret == ESP_OK) {
+                        cached->value_count = conversions[i].value_count;
+                        memcpy(cached->values, conversions[i].values, sizeof(cached->values));
+                    }
+                } else if (sensor_triggered[i]) {
+                    i2c_arbiter_begin(I2C_ARBITER_PRIO_SCHEDULED, sensor->config.i2c_address);
+                    read_ret = sensor_manager_fetch_timed(&conversions[i], cached->values, &cached->value_count);
+                    i2c_arbiter_end();
                     if (read_ret == ESP_ERR_NOT_FINISHED) {
                         vTaskDelay(pdMS_TO_TICKS(200));
-                        read_ret = ezo_sensor_fetch_all(sensor, cached->values, &cached->value_count);
+                        i2c_arbiter_begin(I2C_ARBITER_PRIO_SCHEDULED, sensor->config.i2c_address);
+                        read_ret = sensor_manager_fetch_timed(&conversions[i], cached->values, &cached->value_count);
+                        i2c_arbiter_end();
                     }
+                    read_ret = sensor_manager_check_epoch(sensor, &conversions[i], read_ret);
+                } else if (sensor->config.i2c_address == external_address) {
+                    read_ret = sensor_manager_take_external_reading(external_address, cached->values,
+                                                                    &cached->value_count);
                 }
 
                 uint32_t now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
                 if (read_ret == ESP_OK) {
+                    // Keep the board's values as raw_values and publish the conditioned ones
+                    memcpy(cached->raw_values, cached->values, sizeof(cached->raw_values));
+                    cached->quality = signal_filter_apply(i, cached->sensor_type, cached->raw_values,
+                                                          cached->values, cached->value_count);
                     cached->valid = true;
+                    cached->temp_compensated = temp_comp_applied[i];
+                    cached->timestamp_us = esp_timer_get_time();
                     cached_sensor_data_t *slot = &s_cached_readings[i];
                     slot->valid = true;
                     slot->count = cached->value_count;
+                    slot->temp_compensated = cached->temp_compensated;
                     slot->timestamp_ms = now_ms;
                     for (uint8_t v = 0; v < cached->value_count && v < MAX_SENSOR_VALUES; v++) {
                         slot->values[v] = cached->values[v];
+                        slot->raw_values[v] = cached->raw_values[v];
                     }
                     valid_sensors++;
                     
@@ -661,9 +1757,15 @@ static void sensor_reading_task(void *arg) {
                 } else {
                     if (!sensor_manager_use_cached_value(i, cached, now_ms)) {
                         cached->valid = false;
+                        cached->quality = SENSOR_QUALITY_INVALID;
                     }
                 }
 
+                if (sensor->config.i2c_address != external_address) {
+                    conversions[i].timing.ok = (read_ret == ESP_OK);
+                    acq_stats_record_sensor(i, sensor->config.i2c_address, &conversions[i].timing);
+                    cycle_bus_us += conversions[i].timing.bus_us;
+                }
                 sensors_processed++;
 
                 if (s_reading_paused) {
@@ -671,7 +1773,23 @@ static void sensor_reading_task(void *arg) {
                     break;
                 }
 
-                vTaskDelay(pdMS_TO_TICKS(SENSOR_TRIGGER_DELAY_MS));
+                if (!conversions[i].fetched) {
+                    vTaskDelay(pdMS_TO_TICKS(SENSOR_TRIGGER_DELAY_MS));
+                }
+            }
+
+            // Low battery: boards read this cycle sleep until their next trigger
+            if (power_manager_band_sleeps_ezo(s_battery_band) && !sensor_manager_in_burst(esp_timer_get_time())) {
+                for (uint8_t i = 0; i < total_sensors; i++) {
+                    ezo_sensor_t *sensor = &s_ezo_sensors[i];
+                    if (!sensor_triggered[i] || sensor->config.sleeping ||
+                        sensor_manager_effective_interval_sec(i) < SENSOR_EZO_SLEEP_MIN_INTERVAL_SEC) {
+                        continue;
+                    }
+                    i2c_arbiter_begin(I2C_ARBITER_PRIO_SCHEDULED, sensor->config.i2c_address);
+                    ezo_sensor_sleep(sensor);
+                    i2c_arbiter_end();
+                }
             }
 
             // Mark any unused cache slots (including skipped sensors) as invalid to avoid stale data
@@ -679,45 +1797,46 @@ static void sensor_reading_task(void *arg) {
                 cached_sensor_t *cached = &new_cache.sensors[i];
                 memset(cached, 0, sizeof(*cached));
                 cached->valid = false;
+                cached->quality = SENSOR_QUALITY_INVALID;
             }
             
+            derived_metrics_compute(&new_cache);
+
             bool cache_updated = false;
             bool notify_listener = false;
-            sensor_cache_t listener_snapshot;
+            trace_log_emit(TRACE_EV_SENSOR_CYCLE, valid_sensors, total_sensors, sensors_processed);
             if (total_sensors == 0) {
-                ESP_LOGI(TAG, "Sensor cache refreshed (no sensors detected)");
-                memcpy(&s_sensor_cache, &new_cache, sizeof(new_cache));
+                sensor_manager_publish_cache(&new_cache);
                 cache_updated = true;
             } else if (sensors_processed < total_sensors) {
                 ESP_LOGI(TAG, "Sensor cache update interrupted (%u/%u processed, %u valid)",
                          sensors_processed, total_sensors, valid_sensors);
                 // Keep previous cache to avoid wiping data used by MQTT/UI
             } else {
-                memcpy(&s_sensor_cache, &new_cache, sizeof(new_cache));
+                sensor_manager_publish_cache(&new_cache);
                 cache_updated = true;
-                ESP_LOGI(TAG, "✓ Cache updated (%u/%u sensors valid)",
-                         valid_sensors, total_sensors);
             }
 
             if (cache_updated) {
                 s_cache_valid = true;
-                if (s_cache_listener != NULL) {
-                    listener_snapshot = s_sensor_cache;
-                    notify_listener = true;
-                }
-                
-                // Trigger MQTT publish if periodic publishing is disabled (interval=0)
-                if (mqtt_get_telemetry_interval() == 0) {
-                    ESP_LOGI(TAG, "Triggering MQTT publish (on-read mode)");
-                    mqtt_trigger_immediate_publish();
-                }
+                notify_listener = true;
+                acq_stats_record_cycle((uint32_t)(esp_timer_get_time() - new_cache.timestamp_us), cycle_bus_us);
+            }
+
+            if (!s_reading_paused) {
+                sensor_manager_recover_stalled_buses();
             }
 
             s_reading_in_progress = false;
-            xSemaphoreGive(s_cache_mutex);
 
-            if (notify_listener && s_cache_listener != NULL) {
-                s_cache_listener(&listener_snapshot, s_cache_listener_ctx);
+            // new_cache is not touched again this cycle, so listeners read it in place
+            if (notify_listener) {
+                for (int l = 0; l < SENSOR_CACHE_MAX_LISTENERS; l++) {
+                    cache_listener_slot_t slot = s_cache_listeners[l];
+                    if (slot.fn != NULL) {
+                        slot.fn(&new_cache, slot.ctx);
+                    }
+                }
             }
         }
     }
@@ -729,21 +1848,24 @@ esp_err_t sensor_manager_start_reading_task(uint32_t interval_sec) {
         return ESP_OK;
     }
     
-    // Load saved sensor interval from NVS (or use provided default)
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open("settings", NVS_READONLY, &nvs_handle);
-    if (err == ESP_OK) {
-        uint32_t saved_interval = interval_sec;
-        err = nvs_get_u32(nvs_handle, "sensor_interval", &saved_interval);
-        if (err == ESP_OK) {
-            interval_sec = saved_interval;
-            ESP_LOGI(TAG, "Loaded sensor interval from NVS: %lu seconds", saved_interval);
-        }
-        nvs_close(nvs_handle);
+    // Saved sensor interval (or use provided default)
+    if (settings_store_is_set(SETTING_SENSOR_INTERVAL)) {
+        interval_sec = settings_store_get_u32(SETTING_SENSOR_INTERVAL);
+        ESP_LOGI(TAG, "Loaded sensor interval from NVS: %lu seconds", interval_sec);
     }
+    s_acq_mode = (sensor_acq_mode_t)settings_store_get_u32(SETTING_SENSOR_ACQ_MODE);
     
     s_reading_interval_sec = interval_sec;
+    ESP_LOGI(TAG, "EZO acquisition mode: %s",
+             s_acq_mode == SENSOR_ACQ_MODE_POLLED ? "polled" : "fixed-wait");
     
+    if (s_fetch_done == NULL) {
+        s_fetch_done = xSemaphoreCreateCounting(SENSOR_MANAGER_MAX_SENSORS, 0);
+        if (s_fetch_done == NULL) {
+            ESP_LOGW(TAG, "No fetch semaphore, boards on all buses are fetched in turn");
+        }
+    }
+
     // Create mutex for cache access
     if (s_cache_mutex == NULL) {
         s_cache_mutex = xSemaphoreCreateMutex();
@@ -756,40 +1878,34 @@ esp_err_t sensor_manager_start_reading_task(uint32_t interval_sec) {
     // Initialize cache as valid but empty to prevent startup warnings
     s_cache_valid = false;  // Will be set true after first read completes
     
-    // Create reading task
-#ifdef CONFIG_FREERTOS_UNICORE
-    // Single core (ESP32-C6): Run on core 0
-    BaseType_t ret = xTaskCreate(
-        sensor_reading_task,
-        "sensor_read",
-        4096,
-        NULL,
-        5,
-        &s_reading_task_handle
-    );
-#else
-    // Dual core (ESP32-S3): Pin to core 1
-    BaseType_t ret = xTaskCreatePinnedToCore(
-        sensor_reading_task,
-        "sensor_read",
-        4096,
-        NULL,
-        5,
-        &s_reading_task_handle,
-        1  // Core 1
-    );
-#endif
+    // Create reading task (core and priority from the scheduling profile)
+    BaseType_t ret = task_profile_create(TASK_PROFILE_SENSOR_READ, sensor_reading_task, NULL, NULL,
+                                         &s_reading_task_handle);
     
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create reading task");
         return ESP_FAIL;
     }
     
+    if (s_hotplug_queue == NULL) {
+        s_hotplug_queue = xQueueCreate(SENSOR_HOTPLUG_QUEUE_LEN, sizeof(sensor_hotplug_board_t *));
+    }
+    if (s_hotplug_queue == NULL ||
+        task_profile_create(TASK_PROFILE_SENSOR_HOTPLUG, sensor_hotplug_task, NULL, NULL,
+                            &s_hotplug_task_handle) != pdPASS) {
+        s_hotplug_task_handle = NULL;
+        ESP_LOGW(TAG, "Hot-plug detection unavailable, use a rescan to pick up new boards");
+    }
+    
     ESP_LOGI(TAG, "Sensor reading task started");
     return ESP_OK;
 }
 
 esp_err_t sensor_manager_stop_reading_task(void) {
+    if (s_hotplug_task_handle != NULL) {
+        vTaskDelete(s_hotplug_task_handle);
+        s_hotplug_task_handle = NULL;
+    }
     if (s_reading_task_handle != NULL) {
         vTaskDelete(s_reading_task_handle);
         s_reading_task_handle = NULL;
@@ -807,15 +1923,15 @@ esp_err_t sensor_manager_get_cached_data(sensor_cache_t *cache) {
         return ESP_ERR_NOT_FOUND;
     }
     
-    if (s_cache_mutex == NULL) {
-        return ESP_ERR_INVALID_STATE;
-    }
-    
-    // Copy cached data (thread-safe)
-    if (xSemaphoreTake(s_cache_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        memcpy(cache, &s_sensor_cache, sizeof(sensor_cache_t));
-        xSemaphoreGive(s_cache_mutex);
-        return ESP_OK;
+    // Lock-free copy of the last complete snapshot
+    for (int attempt = 0; attempt < SENSOR_CACHE_READ_RETRIES; attempt++) {
+        unsigned int seq = atomic_load_explicit(&s_cache_seq, memory_order_acquire) & ~1u;
+        memcpy(cache, &s_cache_buffers[(seq >> 1) & 1], sizeof(sensor_cache_t));
+        atomic_thread_fence(memory_order_acquire);
+        // This buffer is only rewritten once the next-but-one publish starts (seq + 3)
+        if (atomic_load_explicit(&s_cache_seq, memory_order_relaxed) - seq < 3) {
+            return ESP_OK;
+        }
     }
     
     return ESP_FAIL;
@@ -824,19 +1940,7 @@ esp_err_t sensor_manager_get_cached_data(sensor_cache_t *cache) {
 esp_err_t sensor_manager_set_reading_interval(uint32_t interval_sec) {
     s_reading_interval_sec = interval_sec;
     ESP_LOGI(TAG, "Reading interval updated to %lu seconds", interval_sec);
-    
-    // Save to NVS
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open("settings", NVS_READWRITE, &nvs_handle);
-    if (err == ESP_OK) {
-        err = nvs_set_u32(nvs_handle, "sensor_interval", interval_sec);
-        if (err == ESP_OK) {
-            nvs_commit(nvs_handle);
-            ESP_LOGI(TAG, "Sensor interval saved to NVS");
-        }
-        nvs_close(nvs_handle);
-    }
-    
+    settings_store_set_u32(SETTING_SENSOR_INTERVAL, interval_sec);
     return ESP_OK;
 }
 
@@ -844,6 +1948,56 @@ uint32_t sensor_manager_get_reading_interval(void) {
     return s_reading_interval_sec;
 }
 
+esp_err_t sensor_manager_set_acquisition_mode(sensor_acq_mode_t mode) {
+    if (mode != SENSOR_ACQ_MODE_FIXED_WAIT && mode != SENSOR_ACQ_MODE_POLLED) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_acq_mode = mode;
+    ESP_LOGI(TAG, "Acquisition mode updated to %s",
+             mode == SENSOR_ACQ_MODE_POLLED ? "polled" : "fixed-wait");
+    settings_store_set_u32(SETTING_SENSOR_ACQ_MODE, (uint32_t)mode);
+    return ESP_OK;
+}
+
+sensor_acq_mode_t sensor_manager_get_acquisition_mode(void) {
+    return s_acq_mode;
+}
+
+esp_err_t sensor_manager_set_sensor_interval(uint8_t address, uint32_t interval_sec) {
+    int index = -1;
+    for (uint8_t i = 0; i < s_ezo_count; i++) {
+        if (s_ezo_sensors[i].config.i2c_address == address) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    s_sensor_interval_sec[index] = interval_sec;
+    ESP_LOGI(TAG, "Schedule for %s @0x%02X set to %lu seconds%s",
+             s_ezo_sensors[index].config.type, address, interval_sec,
+             interval_sec == 0 ? " (global)" : "");
+
+    // Back on the global interval: the saved schedule is erased
+    char key[16];
+    sensor_manager_schedule_key(address, key, sizeof(key));
+    settings_store_set_named_u32(key, interval_sec, interval_sec == 0);
+
+    return ESP_OK;
+}
+
+uint32_t sensor_manager_get_sensor_interval(uint8_t address) {
+    for (uint8_t i = 0; i < s_ezo_count; i++) {
+        if (s_ezo_sensors[i].config.i2c_address == address) {
+            return s_sensor_interval_sec[i];
+        }
+    }
+    return 0;
+}
+
 esp_err_t sensor_manager_pause_reading(void) {
     s_reading_paused = true;
     ESP_LOGI(TAG, "Sensor reading paused");
@@ -864,41 +2018,76 @@ bool sensor_manager_is_reading_paused(void) {
     return s_reading_paused;
 }
 
-esp_err_t sensor_manager_refresh_settings(void) {
-    if (s_ezo_count == 0) {
-        return ESP_OK;
+esp_err_t sensor_manager_start_burst(uint32_t duration_sec) {
+    if (duration_sec == 0) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    bool resume_required = false;
-    bool reading_task_running = (s_reading_task_handle != NULL);
+    uint32_t until_ms = (uint32_t)(esp_timer_get_time() / 1000) + duration_sec * 1000;
+    s_burst_until_ms = until_ms != 0 ? until_ms : 1;
+    ESP_LOGI(TAG, "Burst capture for %lu s at the minimum cycle", (unsigned long)duration_sec);
 
-    if (reading_task_running && !sensor_manager_is_reading_paused()) {
-        sensor_manager_pause_reading();
-        resume_required = true;
+    if (s_reading_task_handle != NULL) {
+        xTaskNotifyGive(s_reading_task_handle);
     }
+    return ESP_OK;
+}
 
-    if (reading_task_running) {
-        const TickType_t timeout_ticks = pdMS_TO_TICKS(2000);
-        TickType_t start = xTaskGetTickCount();
-        while (sensor_manager_is_reading_in_progress()) {
-            if ((xTaskGetTickCount() - start) > timeout_ticks) {
-                ESP_LOGW(TAG, "Timeout waiting for sensor reading task to stop before refreshing settings");
-                break;
-            }
-            vTaskDelay(pdMS_TO_TICKS(50));
+void sensor_manager_stop_burst(void) {
+    if (s_burst_until_ms != 0) {
+        s_burst_until_ms = 0;
+        ESP_LOGI(TAG, "Burst capture ended, back to %lu s interval", s_reading_interval_sec);
+    }
+}
+
+bool sensor_manager_is_burst_active(void) {
+    return sensor_manager_in_burst(esp_timer_get_time());
+}
+
+esp_err_t sensor_manager_refresh_settings(void) {
+    // Each board is refreshed in its own maintenance session, so the reading task keeps running
+    return sensor_manager_refresh_settings_internal();
+}
+
+esp_err_t sensor_manager_register_cache_listener(sensor_cache_listener_t listener, void *user_ctx) {
+    if (listener == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int free_slot = -1;
+    for (int l = 0; l < SENSOR_CACHE_MAX_LISTENERS; l++) {
+        if (s_cache_listeners[l].fn == listener) {
+            s_cache_listeners[l].ctx = user_ctx;
+            return ESP_OK;
+        }
+        if (s_cache_listeners[l].fn == NULL && free_slot < 0) {
+            free_slot = l;
         }
     }
 
-    esp_err_t ret = sensor_manager_refresh_settings_internal();
+    if (free_slot < 0) {
+        ESP_LOGW(TAG, "No free cache listener slots");
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_cache_listeners[free_slot].ctx = user_ctx;
+    s_cache_listeners[free_slot].fn = listener;
+    return ESP_OK;
+}
 
-    if (resume_required) {
-        sensor_manager_resume_reading();
+void sensor_manager_unregister_cache_listener(sensor_cache_listener_t listener) {
+    for (int l = 0; l < SENSOR_CACHE_MAX_LISTENERS; l++) {
+        if (s_cache_listeners[l].fn == listener) {
+            s_cache_listeners[l].fn = NULL;
+            s_cache_listeners[l].ctx = NULL;
+        }
     }
+}
 
-    return ret;
+esp_err_t sensor_manager_get_acq_stats(acq_stats_snapshot_t *stats) {
+    return acq_stats_get(stats);
 }
 
-void sensor_manager_register_cache_listener(sensor_cache_listener_t listener, void *user_ctx) {
-    s_cache_listener = listener;
-    s_cache_listener_ctx = user_ctx;
+void sensor_manager_reset_acq_stats(void) {
+    acq_stats_reset();
 }
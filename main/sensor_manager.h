@@ -1,6 +1,16 @@
 /**
  * @file sensor_manager.h
  * @brief Sensor manager for handling MAX17048 and EZO sensors
+ *
+ * EZO boards are discovered at any address that answers on any of the I2C
+ * buses, so several boards of one type can run side by side. Boards are
+ * registered in bus then address order; the registry index is the cache
+ * slot of a board. The single-value readers use the first board of a type.
+ *
+ * While the reading task runs, a low-priority hot-plug pass probes the
+ * unclaimed addresses between cycles. New boards are appended to the
+ * registry and boards that stop answering are marked offline; slots keep
+ * their index, so the other boards report without interruption.
  */
 
 #pragma once
@@ -8,6 +18,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "acq_stats.h"
+#include "power_manager.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -107,6 +119,22 @@ uint8_t sensor_manager_get_ezo_count(void);
  */
 bool sensor_manager_has_battery_monitor(void);
 
+/**
+ * @brief Battery policy band in effect (POWER_BAND_NORMAL without a battery monitor)
+ *
+ * Updated by the reading task whenever it reads the fuel gauge. Sensor and
+ * publish intervals are multiplied by power_manager_band_factor() of it.
+ */
+power_band_t sensor_manager_get_battery_band(void);
+
+/**
+ * @brief Get the I2C bus an EZO sensor is attached to
+ * 
+ * @param index Sensor index (0 to sensor_manager_get_ezo_count()-1)
+ * @return Bus index, 0 for an invalid index
+ */
+uint8_t sensor_manager_get_ezo_bus(uint8_t index);
+
 /**
  * @brief Get EZO sensor handle by index
  * 
@@ -135,29 +163,105 @@ esp_err_t sensor_manager_read_ezo_sensor(uint8_t index, char *sensor_type, float
  */
 esp_err_t sensor_manager_rescan(void);
 
+/**
+ * @brief Run an incremental discovery pass now instead of at the next interval
+ * 
+ * Only unclaimed addresses and offline boards are probed; acquisition of
+ * the registered boards continues.
+ * 
+ * @return esp_err_t ESP_OK if requested, ESP_ERR_INVALID_STATE if the reading task is not running
+ */
+esp_err_t sensor_manager_request_discovery(void);
+
+/**
+ * @brief Whether the board at an address stopped answering and is out of acquisition
+ */
+bool sensor_manager_is_ezo_offline(uint8_t address);
+
+/**
+ * @brief Hand a board's acquisition to another reader (the focus stream)
+ *
+ * The reading task stops triggering and fetching the board, so commands of
+ * the other reader do not invalidate its conversions and a board held in
+ * continuous mode is not sent R. Readings passed to
+ * sensor_manager_submit_external_reading() stand in for its own; the board
+ * keeps reporting to the cache, MQTT, history and alarms.
+ *
+ * @param address Board address, 0 to give acquisition back to the reading task
+ */
+void sensor_manager_set_external_reader(uint8_t address);
+
+/**
+ * @brief Reading of the board handed to an external reader, used by the next cycle
+ *
+ * Ignored unless address is the board set with sensor_manager_set_external_reader().
+ */
+void sensor_manager_submit_external_reading(uint8_t address, const float *values, uint8_t count);
+
 /**
  * @brief Cached sensor data structure
  */
+#define SENSOR_MANAGER_MAX_SENSORS 16  // EZO boards in the registry, across all buses
 #define MAX_SENSOR_VALUES 4
+#define MAX_DERIVED_VALUES 8
+/**
+ * @brief How trustworthy a sensor's published values are (see signal_filter.h)
+ */
+typedef enum {
+    SENSOR_QUALITY_GOOD = 0,     // Fresh sample accepted by the conditioning stage
+    SENSOR_QUALITY_SETTLING,     // Fresh sample, filter window still filling after a reset
+    SENSOR_QUALITY_SPIKE,        // Fresh sample rejected as an outlier; values hold the previous estimate
+    SENSOR_QUALITY_HELD,         // Read failed; values repeat an earlier reading
+    SENSOR_QUALITY_INVALID,
+} sensor_quality_t;
+
 typedef struct {
     char sensor_type[16];
-    float values[MAX_SENSOR_VALUES];
+    float values[MAX_SENSOR_VALUES];     // Conditioned values, what consumers should use
+    float raw_values[MAX_SENSOR_VALUES]; // As read from the board
     uint8_t value_count;
     bool valid;
+    uint8_t quality;             // sensor_quality_t
+    bool temp_compensated;       // Board applied the RTD temperature to this reading
+    uint64_t timestamp_us;       // Time this sensor's values were acquired (esp_timer)
+    uint8_t address;             // I2C address of the board
+    uint8_t bus;                 // I2C bus of the board
+    uint8_t kind;                // ezo_sensor_kind_t of sensor_type
+    uint8_t channels[MAX_SENSOR_VALUES]; // Descriptor channel of each value (see ezo_sensor_desc_t)
+    bool offline;                // Board stopped answering; the slot holds no values
 } cached_sensor_t;
 
 typedef struct {
-    cached_sensor_t sensors[8];  // Support up to 8 EZO sensors
+    cached_sensor_t sensors[SENSOR_MANAGER_MAX_SENSORS];  // Indexed like the registry
     uint8_t sensor_count;
     float battery_percentage;
     bool battery_valid;
     int8_t rssi;
     uint64_t timestamp_us;
+    float derived[MAX_DERIVED_VALUES];   // Computed from the sensors (derived_metric_t order)
+    uint8_t derived_valid;               // Bit n set when derived[n] holds a value
 } sensor_cache_t;
 
 typedef void (*sensor_cache_listener_t)(const sensor_cache_t *cache, void *user_ctx);
 
-void sensor_manager_register_cache_listener(sensor_cache_listener_t listener, void *user_ctx);
+/**
+ * @brief Register a callback invoked after each published cache update
+ *
+ * Listeners run in the sensor reading task and must not block. Registering
+ * the same callback again only updates its context.
+ *
+ * @param listener Callback function
+ * @param user_ctx Argument passed to the callback
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if all slots are taken
+ */
+esp_err_t sensor_manager_register_cache_listener(sensor_cache_listener_t listener, void *user_ctx);
+
+/**
+ * @brief Remove a previously registered cache listener
+ *
+ * @param listener Callback passed to sensor_manager_register_cache_listener()
+ */
+void sensor_manager_unregister_cache_listener(sensor_cache_listener_t listener);
 
 /**
  * @brief Start background sensor reading task
@@ -179,8 +283,9 @@ esp_err_t sensor_manager_stop_reading_task(void);
 /**
  * @brief Get cached sensor data (non-blocking, no I2C operations)
  * 
- * Returns the most recent sensor readings from the background task.
- * This is safe to call from any context including HTTP handlers.
+ * Returns the last complete snapshot published by the background task. The
+ * copy never waits on an acquisition cycle in progress, so this is safe to call
+ * from any context including HTTP handlers.
  * 
  * @param cache Pointer to sensor_cache_t structure to fill
  * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if no data yet
@@ -202,6 +307,48 @@ esp_err_t sensor_manager_set_reading_interval(uint32_t interval_sec);
  */
 uint32_t sensor_manager_get_reading_interval(void);
 
+/**
+ * @brief Set per-sensor sampling interval (persisted to NVS)
+ *
+ * Sensors without an override follow the global reading interval.
+ *
+ * @param address I2C address of the EZO sensor
+ * @param interval_sec Interval in seconds, 0 to follow the global interval
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if no sensor at address
+ */
+esp_err_t sensor_manager_set_sensor_interval(uint8_t address, uint32_t interval_sec);
+
+/**
+ * @brief Get per-sensor sampling interval override
+ *
+ * @param address I2C address of the EZO sensor
+ * @return Interval in seconds, 0 if the sensor follows the global interval
+ */
+uint32_t sensor_manager_get_sensor_interval(uint8_t address);
+
+/**
+ * @brief EZO acquisition strategy used by the background reading task
+ */
+typedef enum {
+    SENSOR_ACQ_MODE_FIXED_WAIT = 0,  // Sleep for the slowest board's worst-case conversion time
+    SENSOR_ACQ_MODE_POLLED = 1,      // Poll each board's status byte and fetch as soon as it is ready
+} sensor_acq_mode_t;
+
+/**
+ * @brief Set EZO acquisition mode (persisted to NVS)
+ *
+ * @param mode SENSOR_ACQ_MODE_FIXED_WAIT or SENSOR_ACQ_MODE_POLLED
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for unknown modes
+ */
+esp_err_t sensor_manager_set_acquisition_mode(sensor_acq_mode_t mode);
+
+/**
+ * @brief Get current EZO acquisition mode
+ *
+ * @return Current acquisition mode
+ */
+sensor_acq_mode_t sensor_manager_get_acquisition_mode(void);
+
 /**
  * @brief Pause sensor reading task
  * 
@@ -232,15 +379,52 @@ bool sensor_manager_is_reading_in_progress(void);
  */
 bool sensor_manager_is_reading_paused(void);
 
+/**
+ * @brief Sample every sensor at the minimum cycle for a bounded time
+ *
+ * Overrides the global and per-sensor intervals without changing them or
+ * their saved values; the schedule returns to normal when the time is up or
+ * sensor_manager_stop_burst() is called.
+ *
+ * @param duration_sec Burst length in seconds
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a zero duration
+ */
+esp_err_t sensor_manager_start_burst(uint32_t duration_sec);
+
+/**
+ * @brief End a burst early
+ */
+void sensor_manager_stop_burst(void);
+
+/**
+ * @brief Check if a burst capture is running
+ */
+bool sensor_manager_is_burst_active(void);
+
 /**
  * @brief Refresh cached sensor settings (calibration status, mode, compensation)
  *
- * Safely pauses the background reading task if necessary while issuing the
- * required I2C commands, then resumes it when finished (unless it was already
- * paused by the caller).
+ * Each board is queried in its own maintenance-priority I2C arbiter session,
+ * so the background reading task keeps running; readings interleaved with a
+ * refresh are discarded and re-acquired on the next cycle.
  */
 esp_err_t sensor_manager_refresh_settings(void);
 
+/**
+ * @brief Acquisition cycle timing of the last one to two ACQ_STATS_WINDOW_SEC windows
+ *
+ * Per board: trigger and fetch bus time, conversion wait, not-ready retries
+ * and I2C errors; per cycle: duration and total bus time.
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE before sensor_manager_init()
+ */
+esp_err_t sensor_manager_get_acq_stats(acq_stats_snapshot_t *stats);
+
+/**
+ * @brief Clear the acquisition cycle timing
+ */
+void sensor_manager_reset_acq_stats(void);
+
 #ifdef __cplusplus
 }
 #endif
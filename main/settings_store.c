@@ -0,0 +1,509 @@
+/**
+ * @file settings_store.c
+ * @brief Typed runtime settings, mirrored in RAM and committed to NVS in batches
+ */
+
+#include "settings_store.h"
+#include "sensor_manager.h"
+#include "mqtt_telemetry.h"
+#include "power_manager.h"
+#include "telemetry_publisher.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdatomic.h>
+#include <string.h>
+
+static const char *TAG = "SETTINGS";
+
+#define NVS_NAMESPACE "settings"
+
+typedef enum {
+    SETTING_TYPE_U8,
+    SETTING_TYPE_U32,
+    SETTING_TYPE_BLOB,
+} setting_type_t;
+
+typedef struct {
+    const char *key;
+    setting_type_t type;
+    uint32_t def;               // Blob settings: index into s_blobs
+    uint32_t min;
+    uint32_t max;
+} setting_desc_t;
+
+static const setting_desc_t k_settings[SETTING_COUNT] = {
+    [SETTING_SENSOR_INTERVAL]   = { "sensor_interval", SETTING_TYPE_U32, 10, 0, UINT32_MAX },
+    [SETTING_SENSOR_ACQ_MODE]   = { "sensor_acq_mode", SETTING_TYPE_U8, SENSOR_ACQ_MODE_POLLED, 0, SENSOR_ACQ_MODE_POLLED },
+    [SETTING_MQTT_INTERVAL]     = { "mqtt_interval", SETTING_TYPE_U32, 10, 0, UINT32_MAX },
+    [SETTING_MQTT_HEARTBEAT]    = { "mqtt_heartbeat", SETTING_TYPE_U32, 300, 0, UINT32_MAX },
+    [SETTING_MQTT_FORMAT]       = { "mqtt_format", SETTING_TYPE_U8, MQTT_PAYLOAD_JSON, 0, MQTT_PAYLOAD_CBOR },
+    [SETTING_MQTT_BATCH_SIZE]   = { "mqtt_batch_n", SETTING_TYPE_U8, 0, 0, MQTT_BATCH_MAX_SAMPLES },
+    [SETTING_MQTT_BATCH_WINDOW] = { "mqtt_batch_t", SETTING_TYPE_U32, 0, 0, UINT32_MAX },
+    [SETTING_MQTT_V5]           = { "mqtt_v5", SETTING_TYPE_U8, 0, 0, 1 },
+    [SETTING_MQTT_DEADBANDS]    = { "mqtt_deadband", SETTING_TYPE_BLOB, 0, 0, 0 },
+    [SETTING_SIGNAL_FILTERS]    = { "sig_filters", SETTING_TYPE_BLOB, 1, 0, 0 },
+    [SETTING_LOW_POWER]         = { "low_power", SETTING_TYPE_U8, 0, 0, 1 },
+    [SETTING_LP_INTERVAL]       = { "lp_interval", SETTING_TYPE_U32, POWER_DEFAULT_INTERVAL_SEC, POWER_MIN_INTERVAL_SEC, UINT32_MAX },
+    [SETTING_ALARM_RULES]       = { "alarm_rules", SETTING_TYPE_BLOB, 2, 0, 0 },
+    [SETTING_TELEMETRY_TRANSPORT] = { "tlm_transport", SETTING_TYPE_U8, TELEMETRY_TRANSPORT_MQTT, 0, TELEMETRY_TRANSPORT_COUNT - 1 },
+};
+
+typedef struct {
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    uint32_t value;
+    bool used;
+    bool present;           // false once erased, until the erase has been committed
+    bool dirty;
+} named_setting_t;
+
+typedef struct {
+    setting_id_t id;
+    settings_listener_t fn;
+    void *ctx;
+} listener_entry_t;
+
+// Numeric settings are read without the mutex; everything else is under it
+static _Atomic uint32_t s_values[SETTING_COUNT];
+static uint32_t s_set_mask = 0;
+static uint32_t s_dirty_mask = 0;
+
+static uint8_t s_blobs[SETTINGS_STORE_MAX_BLOBS][SETTINGS_STORE_BLOB_MAX];
+static size_t s_blob_lens[SETTINGS_STORE_MAX_BLOBS];
+
+static named_setting_t s_named[SETTINGS_STORE_MAX_NAMED];
+static bool s_named_dirty = false;
+
+static listener_entry_t s_listeners[SETTINGS_STORE_MAX_LISTENERS];
+static uint8_t s_listener_count = 0;
+
+static SemaphoreHandle_t s_mutex = NULL;
+static esp_timer_handle_t s_commit_timer = NULL;
+static int64_t s_first_dirty_us = 0;
+
+static bool value_in_range(const setting_desc_t *desc, uint32_t value)
+{
+    uint32_t max = (desc->type == SETTING_TYPE_U8 && desc->max > UINT8_MAX) ? UINT8_MAX : desc->max;
+    return value >= desc->min && value <= max;
+}
+
+static named_setting_t *find_named(const char *key)
+{
+    for (int i = 0; i < SETTINGS_STORE_MAX_NAMED; i++) {
+        if (s_named[i].used && strncmp(s_named[i].key, key, sizeof(s_named[i].key)) == 0) {
+            return &s_named[i];
+        }
+    }
+    return NULL;
+}
+
+static bool is_registered_key(const char *key)
+{
+    for (int i = 0; i < SETTING_COUNT; i++) {
+        if (strcmp(k_settings[i].key, key) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Arm the commit timer after a change; caller holds s_mutex
+ *
+ * Each change pushes the commit back by the quiet time, but not past the
+ * deadline set by the first change that is still unsaved.
+ */
+static void schedule_commit_locked(void)
+{
+    int64_t now_us = esp_timer_get_time();
+    if (s_first_dirty_us == 0) {
+        s_first_dirty_us = now_us;
+    }
+    int64_t due_us = now_us + SETTINGS_STORE_COMMIT_DELAY_MS * 1000LL;
+    int64_t deadline_us = s_first_dirty_us + SETTINGS_STORE_COMMIT_MAX_DELAY_MS * 1000LL;
+    if (due_us > deadline_us) {
+        due_us = deadline_us;
+    }
+    int64_t delay_us = due_us - now_us;
+    if (delay_us < 1000) {
+        delay_us = 1000;
+    }
+    esp_timer_stop(s_commit_timer);
+    esp_timer_start_once(s_commit_timer, (uint64_t)delay_us);
+}
+
+static void notify_listeners(setting_id_t id)
+{
+    // Registration happens at init, so the table is stable while changes run
+    for (uint8_t i = 0; i < s_listener_count; i++) {
+        if (s_listeners[i].id == id) {
+            s_listeners[i].fn(id, s_listeners[i].ctx);
+        }
+    }
+}
+
+static esp_err_t commit_locked(void)
+{
+    if (s_dirty_mask == 0 && !s_named_dirty) {
+        return ESP_OK;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    int written = 0;
+    for (int i = 0; i < SETTING_COUNT && err == ESP_OK; i++) {
+        if (!(s_dirty_mask & (1UL << i))) {
+            continue;
+        }
+        const setting_desc_t *desc = &k_settings[i];
+        uint32_t value = atomic_load_explicit(&s_values[i], memory_order_relaxed);
+        if (desc->type == SETTING_TYPE_U8) {
+            err = nvs_set_u8(nvs_handle, desc->key, (uint8_t)value);
+        } else if (desc->type == SETTING_TYPE_U32) {
+            err = nvs_set_u32(nvs_handle, desc->key, value);
+        } else if (s_blob_lens[desc->def] > 0) {
+            err = nvs_set_blob(nvs_handle, desc->key, s_blobs[desc->def], s_blob_lens[desc->def]);
+        } else {
+            err = nvs_erase_key(nvs_handle, desc->key);
+            if (err == ESP_ERR_NVS_NOT_FOUND) {
+                err = ESP_OK;
+            }
+        }
+        written++;
+    }
+    for (int i = 0; i < SETTINGS_STORE_MAX_NAMED && err == ESP_OK; i++) {
+        named_setting_t *named = &s_named[i];
+        if (!named->used || !named->dirty) {
+            continue;
+        }
+        if (named->present) {
+            err = nvs_set_u32(nvs_handle, named->key, named->value);
+        } else {
+            err = nvs_erase_key(nvs_handle, named->key);
+            if (err == ESP_ERR_NVS_NOT_FOUND) {
+                err = ESP_OK;
+            }
+        }
+        written++;
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (err != ESP_OK) {
+        // Left dirty: the next change or flush retries
+        ESP_LOGE(TAG, "Failed to commit settings: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    s_dirty_mask = 0;
+    s_named_dirty = false;
+    for (int i = 0; i < SETTINGS_STORE_MAX_NAMED; i++) {
+        s_named[i].dirty = false;
+        if (!s_named[i].present) {
+            s_named[i].used = false;
+        }
+    }
+    s_first_dirty_us = 0;
+    ESP_LOGI(TAG, "Committed %d setting(s) to NVS", written);
+    return ESP_OK;
+}
+
+static void commit_timer_cb(void *arg)
+{
+    (void)arg;
+    settings_store_flush();
+}
+
+static void settings_store_shutdown_handler(void)
+{
+    settings_store_flush();
+}
+
+static void load_named_settings(nvs_handle_t nvs_handle)
+{
+    nvs_iterator_t it = NULL;
+    esp_err_t res = nvs_entry_find(NVS_DEFAULT_PART_NAME, NVS_NAMESPACE, NVS_TYPE_U32, &it);
+    int slot = 0;
+    while (res == ESP_OK) {
+        nvs_entry_info_t info;
+        nvs_entry_info(it, &info);
+        if (!is_registered_key(info.key)) {
+            if (slot >= SETTINGS_STORE_MAX_NAMED) {
+                ESP_LOGW(TAG, "No slot for setting '%s'", info.key);
+            } else if (nvs_get_u32(nvs_handle, info.key, &s_named[slot].value) == ESP_OK) {
+                strncpy(s_named[slot].key, info.key, sizeof(s_named[slot].key) - 1);
+                s_named[slot].used = true;
+                s_named[slot].present = true;
+                slot++;
+            }
+        }
+        res = nvs_entry_next(&it);
+    }
+    nvs_release_iterator(it);
+}
+
+esp_err_t settings_store_init(void)
+{
+    if (s_mutex != NULL) {
+        return ESP_OK;
+    }
+
+    for (int i = 0; i < SETTING_COUNT; i++) {
+        atomic_store_explicit(&s_values[i], k_settings[i].def, memory_order_relaxed);
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err == ESP_OK) {
+        int loaded = 0;
+        for (int i = 0; i < SETTING_COUNT; i++) {
+            const setting_desc_t *desc = &k_settings[i];
+            uint32_t value = 0;
+            if (desc->type == SETTING_TYPE_U8) {
+                uint8_t v8 = 0;
+                err = nvs_get_u8(nvs_handle, desc->key, &v8);
+                value = v8;
+            } else if (desc->type == SETTING_TYPE_U32) {
+                err = nvs_get_u32(nvs_handle, desc->key, &value);
+            } else {
+                size_t len = sizeof(s_blobs[desc->def]);
+                err = nvs_get_blob(nvs_handle, desc->key, s_blobs[desc->def], &len);
+                s_blob_lens[desc->def] = (err == ESP_OK) ? len : 0;
+            }
+            if (err != ESP_OK) {
+                continue;
+            }
+            if (desc->type != SETTING_TYPE_BLOB) {
+                if (!value_in_range(desc, value)) {
+                    ESP_LOGW(TAG, "Ignoring out-of-range %s=%lu", desc->key, (unsigned long)value);
+                    continue;
+                }
+                atomic_store_explicit(&s_values[i], value, memory_order_relaxed);
+            }
+            s_set_mask |= 1UL << i;
+            loaded++;
+        }
+        load_named_settings(nvs_handle);
+        nvs_close(nvs_handle);
+        ESP_LOGI(TAG, "Loaded %d of %d settings from NVS", loaded, SETTING_COUNT);
+    } else if (err != ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGW(TAG, "Failed to open NVS, using defaults: %s", esp_err_to_name(err));
+    }
+
+    esp_timer_create_args_t args = {
+        .callback = commit_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "settings_commit"
+    };
+    err = esp_timer_create(&args, &s_commit_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == NULL) {
+        esp_timer_delete(s_commit_timer);
+        s_commit_timer = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    esp_register_shutdown_handler(settings_store_shutdown_handler);
+    return ESP_OK;
+}
+
+uint32_t settings_store_get_u32(setting_id_t id)
+{
+    if (id >= SETTING_COUNT) {
+        return 0;
+    }
+    return atomic_load_explicit(&s_values[id], memory_order_relaxed);
+}
+
+bool settings_store_is_set(setting_id_t id)
+{
+    return id < SETTING_COUNT && (s_set_mask & (1UL << id)) != 0;
+}
+
+esp_err_t settings_store_set_u32(setting_id_t id, uint32_t value)
+{
+    if (id >= SETTING_COUNT || k_settings[id].type == SETTING_TYPE_BLOB ||
+        !value_in_range(&k_settings[id], value)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool changed = atomic_load_explicit(&s_values[id], memory_order_relaxed) != value ||
+                   !(s_set_mask & (1UL << id));
+    if (changed) {
+        atomic_store_explicit(&s_values[id], value, memory_order_relaxed);
+        s_set_mask |= 1UL << id;
+        s_dirty_mask |= 1UL << id;
+        schedule_commit_locked();
+    }
+    xSemaphoreGive(s_mutex);
+
+    if (changed) {
+        notify_listeners(id);
+    }
+    return ESP_OK;
+}
+
+esp_err_t settings_store_get_blob(setting_id_t id, void *buf, size_t *len)
+{
+    if (id >= SETTING_COUNT || k_settings[id].type != SETTING_TYPE_BLOB || len == NULL ||
+        (buf == NULL && *len > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t slot = k_settings[id].def;
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (*len < s_blob_lens[slot]) {
+        ret = ESP_ERR_INVALID_SIZE;
+    } else if (s_blob_lens[slot] > 0) {
+        memcpy(buf, s_blobs[slot], s_blob_lens[slot]);
+    }
+    *len = s_blob_lens[slot];
+    xSemaphoreGive(s_mutex);
+    return ret;
+}
+
+esp_err_t settings_store_set_blob(setting_id_t id, const void *data, size_t len)
+{
+    if (id >= SETTING_COUNT || k_settings[id].type != SETTING_TYPE_BLOB || (data == NULL && len > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len > SETTINGS_STORE_BLOB_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t slot = k_settings[id].def;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool changed = len != s_blob_lens[slot] || (len > 0 && memcmp(s_blobs[slot], data, len) != 0);
+    if (changed) {
+        if (len > 0) {
+            memcpy(s_blobs[slot], data, len);
+        }
+        s_blob_lens[slot] = len;
+        s_set_mask |= 1UL << id;
+        s_dirty_mask |= 1UL << id;
+        schedule_commit_locked();
+    }
+    xSemaphoreGive(s_mutex);
+
+    if (changed) {
+        notify_listeners(id);
+    }
+    return ESP_OK;
+}
+
+esp_err_t settings_store_get_named_u32(const char *key, uint32_t *value)
+{
+    if (key == NULL || value == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    named_setting_t *named = find_named(key);
+    if (named != NULL && named->present) {
+        *value = named->value;
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(s_mutex);
+    return ret;
+}
+
+esp_err_t settings_store_set_named_u32(const char *key, uint32_t value, bool erase)
+{
+    if (key == NULL || strlen(key) >= NVS_KEY_NAME_MAX_SIZE || is_registered_key(key)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    named_setting_t *named = find_named(key);
+    if (named == NULL && !erase) {
+        for (int i = 0; i < SETTINGS_STORE_MAX_NAMED; i++) {
+            if (!s_named[i].used) {
+                named = &s_named[i];
+                memset(named, 0, sizeof(*named));
+                strncpy(named->key, key, sizeof(named->key) - 1);
+                named->used = true;
+                break;
+            }
+        }
+        if (named == NULL) {
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    if (named != NULL && (named->present == erase || (!erase && named->value != value))) {
+        named->present = !erase;
+        named->value = erase ? 0 : value;
+        named->dirty = true;
+        s_named_dirty = true;
+        schedule_commit_locked();
+    }
+    xSemaphoreGive(s_mutex);
+    return ret;
+}
+
+esp_err_t settings_store_add_listener(setting_id_t id, settings_listener_t listener, void *ctx)
+{
+    if (id >= SETTING_COUNT || listener == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (s_listener_count >= SETTINGS_STORE_MAX_LISTENERS) {
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        s_listeners[s_listener_count].id = id;
+        s_listeners[s_listener_count].fn = listener;
+        s_listeners[s_listener_count].ctx = ctx;
+        s_listener_count++;
+    }
+    xSemaphoreGive(s_mutex);
+    return ret;
+}
+
+esp_err_t settings_store_flush(void)
+{
+    if (s_mutex == NULL) {
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    esp_timer_stop(s_commit_timer);
+    esp_err_t err = commit_locked();
+    xSemaphoreGive(s_mutex);
+    return err;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file settings_store.h
+ * @brief Typed runtime settings, mirrored in RAM and committed to NVS in batches
+ *
+ * Every runtime setting is declared once in a registry with its NVS key, type,
+ * default and bounds. settings_store_init() loads the "settings" namespace in a
+ * single NVS pass; from then on reads come from RAM. Numeric reads are single
+ * aligned 32-bit loads and take no lock, so they are safe from any task.
+ *
+ * Writes update RAM and notify listeners immediately, then mark the setting
+ * dirty. Dirty settings are written under one nvs_open/nvs_commit once writes
+ * have been quiet for SETTINGS_STORE_COMMIT_DELAY_MS, and never later than
+ * SETTINGS_STORE_COMMIT_MAX_DELAY_MS after the first unsaved change, so dragging
+ * a dashboard slider costs one flash commit instead of one per step.
+ *
+ * Keys are the ones the modules used before the store existed, so settings
+ * saved by older firmware load unchanged.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SETTINGS_STORE_COMMIT_DELAY_MS      1500    // Quiet time before dirty settings are written
+#define SETTINGS_STORE_COMMIT_MAX_DELAY_MS  10000   // Upper bound while writes keep coming
+#define SETTINGS_STORE_BLOB_MAX             384     // Largest blob setting (16 MQTT deadbands)
+#define SETTINGS_STORE_MAX_BLOBS            3
+#define SETTINGS_STORE_MAX_NAMED            16      // Run-time keyed u32 settings (e.g. per-sensor schedules)
+#define SETTINGS_STORE_MAX_LISTENERS        8
+
+typedef enum {
+    SETTING_SENSOR_INTERVAL,    // "sensor_interval", u32 seconds
+    SETTING_SENSOR_ACQ_MODE,    // "sensor_acq_mode", u8 sensor_acq_mode_t
+    SETTING_MQTT_INTERVAL,      // "mqtt_interval", u32 seconds (0 = every sensor cycle)
+    SETTING_MQTT_HEARTBEAT,     // "mqtt_heartbeat", u32 seconds
+    SETTING_MQTT_FORMAT,        // "mqtt_format", u8 mqtt_payload_format_t
+    SETTING_MQTT_BATCH_SIZE,    // "mqtt_batch_n", u8 samples
+    SETTING_MQTT_BATCH_WINDOW,  // "mqtt_batch_t", u32 seconds
+    SETTING_MQTT_V5,            // "mqtt_v5", u8 bool
+    SETTING_MQTT_DEADBANDS,     // "mqtt_deadband", blob of mqtt_deadband_t
+    SETTING_SIGNAL_FILTERS,     // "sig_filters", blob of signal_filter_entry_t
+    SETTING_LOW_POWER,          // "low_power", u8 bool
+    SETTING_LP_INTERVAL,        // "lp_interval", u32 seconds
+    SETTING_ALARM_RULES,        // "alarm_rules", blob of alarm_rule_t
+    SETTING_TELEMETRY_TRANSPORT,// "tlm_transport", u8 telemetry_transport_t
+    SETTING_COUNT
+} setting_id_t;
+
+/**
+ * @brief Called after a setting changed in RAM, in the context of the writer
+ *
+ * Use settings_store_get_*() for the new value. Listeners must not block.
+ */
+typedef void (*settings_listener_t)(setting_id_t id, void *ctx);
+
+/**
+ * @brief Load every registered setting in one NVS pass
+ *
+ * Settings missing from NVS, or stored out of bounds, keep their defaults.
+ * Requires nvs_flash_init(); safe to call more than once.
+ *
+ * @return esp_err_t ESP_OK on success (also when the namespace does not exist yet)
+ */
+esp_err_t settings_store_init(void);
+
+/**
+ * @brief Current value of a u8 or u32 setting (lock-free)
+ */
+uint32_t settings_store_get_u32(setting_id_t id);
+
+/**
+ * @brief Whether a setting has been loaded from NVS or written since boot
+ *
+ * Lets a caller that has its own fallback tell a saved value from the default.
+ */
+bool settings_store_is_set(setting_id_t id);
+
+/**
+ * @brief Set a u8 or u32 setting
+ *
+ * Writing the current value is a no-op: listeners are not called and nothing
+ * is scheduled for NVS.
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for an out-of-range
+ *         value or a blob setting
+ */
+esp_err_t settings_store_set_u32(setting_id_t id, uint32_t value);
+
+/**
+ * @brief Copy a blob setting
+ *
+ * @param len In: buffer size, out: blob length (0 when unset)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_SIZE if the buffer is too small
+ */
+esp_err_t settings_store_get_blob(setting_id_t id, void *buf, size_t *len);
+
+/**
+ * @brief Replace a blob setting; a zero length erases the key from NVS
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_SIZE above SETTINGS_STORE_BLOB_MAX
+ */
+esp_err_t settings_store_set_blob(setting_id_t id, const void *data, size_t len);
+
+/**
+ * @brief Read a u32 setting whose key is only known at run time
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if the key is not set
+ */
+esp_err_t settings_store_get_named_u32(const char *key, uint32_t *value);
+
+/**
+ * @brief Set or erase a run-time keyed u32 setting
+ *
+ * @param erase true to remove the key (value is ignored)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM when all
+ *         SETTINGS_STORE_MAX_NAMED slots are taken
+ */
+esp_err_t settings_store_set_named_u32(const char *key, uint32_t value, bool erase);
+
+/**
+ * @brief Register a change listener for one setting
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM when the table is full
+ */
+esp_err_t settings_store_add_listener(setting_id_t id, settings_listener_t listener, void *ctx);
+
+/**
+ * @brief Write pending changes to NVS now
+ *
+ * Also runs from a shutdown handler, so a change made just before esp_restart()
+ * is not lost.
+ *
+ * @return esp_err_t ESP_OK on success (or nothing pending), otherwise the NVS error
+ */
+esp_err_t settings_store_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,390 @@
+/**
+ * @file signal_filter.c
+ * @brief Per-channel conditioning of EZO readings before they reach the sensor cache
+ */
+
+#include "signal_filter.h"
+#include "ezo_sensor.h"
+#include "settings_store.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <math.h>
+#include <string.h>
+#include <stdatomic.h>
+
+static const char *TAG = "SIG_FILTER";
+
+#define SIGNAL_FILTER_MAD_SCALE 1.4826f    // MAD to standard deviation for Gaussian noise
+
+typedef struct {
+    const char *sensor_type;
+    signal_filter_config_t config;
+} signal_filter_default_t;
+
+// DO and EC probes are the noisy ones: a median removes their bursts without lag on steps
+static const signal_filter_default_t k_defaults[] = {
+    { EZO_TYPE_RTD, { SIGNAL_FILTER_KALMAN, 5, 0.0f, 0.0025f, 0.01f, 5.0f, 0.5f, 0.0f } },
+    { EZO_TYPE_PH,  { SIGNAL_FILTER_EMA,    5, 0.5f, 0.0f, 0.0f, 5.0f, 0.1f, 0.0f } },
+    { EZO_TYPE_EC,  { SIGNAL_FILTER_MEDIAN, 5, 0.0f, 0.0f, 0.0f, 4.0f, 0.0f, 0.05f } },
+    { EZO_TYPE_DO,  { SIGNAL_FILTER_MEDIAN, 5, 0.0f, 0.0f, 0.0f, 4.0f, 0.2f, 0.05f } },
+    { EZO_TYPE_ORP, { SIGNAL_FILTER_EMA,    5, 0.3f, 0.0f, 0.0f, 5.0f, 10.0f, 0.0f } },
+    { EZO_TYPE_HUM, { SIGNAL_FILTER_EMA,    5, 0.4f, 0.0f, 0.0f, 5.0f, 2.0f, 0.05f } },
+};
+
+static const signal_filter_config_t k_passthrough = { SIGNAL_FILTER_NONE, 5, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+// Channel state, struct-of-arrays; channel = slot * MAX_SENSOR_VALUES + value index
+static float s_history[SIGNAL_FILTER_CHANNELS][SIGNAL_FILTER_WINDOW_MAX];  // Raw ring per channel
+static uint8_t s_history_len[SIGNAL_FILTER_CHANNELS];
+static uint8_t s_history_head[SIGNAL_FILTER_CHANNELS];
+static float s_estimate[SIGNAL_FILTER_CHANNELS];
+static float s_variance[SIGNAL_FILTER_CHANNELS];        // Kalman error covariance
+static uint8_t s_rejects[SIGNAL_FILTER_CHANNELS];       // Consecutive outliers
+
+// Per-slot bookkeeping, only touched by the reading task
+static char s_slot_type[SIGNAL_FILTER_MAX_SENSORS][16];
+static uint32_t s_slot_seq[SIGNAL_FILTER_MAX_SENSORS];
+
+// Bumped by configuration changes and resets; slots that see a new value start over
+static atomic_uint s_config_seq = 1;
+
+static signal_filter_entry_t s_overrides[SIGNAL_FILTER_MAX_TYPES];
+static uint8_t s_override_count = 0;
+static SemaphoreHandle_t s_mutex = NULL;
+
+static void signal_filter_entry_to_config(const signal_filter_entry_t *e, signal_filter_config_t *config) {
+    config->mode = (signal_filter_mode_t)e->mode;
+    config->window = e->window;
+    config->alpha = e->alpha;
+    config->process_noise = e->process_noise;
+    config->measurement_noise = e->measurement_noise;
+    config->spike_k = e->spike_k;
+    config->spike_floor = e->spike_floor;
+    config->spike_rel = e->spike_rel;
+}
+
+static bool signal_filter_config_valid(const signal_filter_config_t *c) {
+    if (c->mode >= SIGNAL_FILTER_MODE_COUNT ||
+        c->window < SIGNAL_FILTER_WINDOW_MIN || c->window > SIGNAL_FILTER_WINDOW_MAX) {
+        return false;
+    }
+    if (!isfinite(c->alpha) || !isfinite(c->process_noise) || !isfinite(c->measurement_noise) ||
+        !isfinite(c->spike_k) || !isfinite(c->spike_floor) || !isfinite(c->spike_rel)) {
+        return false;
+    }
+    if (c->mode == SIGNAL_FILTER_EMA && (c->alpha <= 0.0f || c->alpha > 1.0f)) {
+        return false;
+    }
+    if (c->mode == SIGNAL_FILTER_KALMAN && (c->process_noise < 0.0f || c->measurement_noise <= 0.0f)) {
+        return false;
+    }
+    return c->spike_k >= 0.0f && c->spike_floor >= 0.0f && c->spike_rel >= 0.0f;
+}
+
+static int signal_filter_find_override_locked(const char *sensor_type) {
+    for (uint8_t i = 0; i < s_override_count; i++) {
+        if (strncmp(s_overrides[i].sensor_type, sensor_type, sizeof(s_overrides[i].sensor_type)) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+esp_err_t signal_filter_init(void) {
+    if (s_mutex == NULL) {
+        s_mutex = xSemaphoreCreateMutex();
+        if (s_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    signal_filter_entry_t saved[SIGNAL_FILTER_MAX_TYPES];
+    size_t size = sizeof(saved);
+    uint8_t count = 0;
+    if (settings_store_get_blob(SETTING_SIGNAL_FILTERS, saved, &size) == ESP_OK &&
+        size % sizeof(signal_filter_entry_t) == 0) {
+        count = size / sizeof(signal_filter_entry_t);
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_override_count = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        signal_filter_config_t config;
+        signal_filter_entry_to_config(&saved[i], &config);
+        saved[i].sensor_type[sizeof(saved[i].sensor_type) - 1] = '\0';
+        if (!signal_filter_config_valid(&config)) {
+            ESP_LOGW(TAG, "Ignoring invalid saved filter for %s", saved[i].sensor_type);
+            continue;
+        }
+        s_overrides[s_override_count++] = saved[i];
+    }
+    xSemaphoreGive(s_mutex);
+
+    atomic_fetch_add(&s_config_seq, 1);
+    ESP_LOGI(TAG, "Signal conditioning ready (%u saved overrides)", s_override_count);
+    return ESP_OK;
+}
+
+void signal_filter_get_config(const char *sensor_type, signal_filter_config_t *config) {
+    if (config == NULL) {
+        return;
+    }
+    *config = k_passthrough;
+    if (sensor_type == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof(k_defaults) / sizeof(k_defaults[0]); i++) {
+        if (strcmp(k_defaults[i].sensor_type, sensor_type) == 0) {
+            *config = k_defaults[i].config;
+            break;
+        }
+    }
+    if (s_mutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    int index = signal_filter_find_override_locked(sensor_type);
+    if (index >= 0) {
+        signal_filter_entry_to_config(&s_overrides[index], config);
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+esp_err_t signal_filter_set_config(const char *sensor_type, const signal_filter_config_t *config) {
+    if (sensor_type == NULL || strlen(sensor_type) >= sizeof(s_overrides[0].sensor_type) ||
+        (config != NULL && !signal_filter_config_valid(config))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ESP_OK;
+    signal_filter_entry_t snapshot[SIGNAL_FILTER_MAX_TYPES];
+    uint8_t snapshot_count = 0;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    int index = signal_filter_find_override_locked(sensor_type);
+    if (config == NULL) {
+        if (index >= 0) {
+            s_overrides[index] = s_overrides[--s_override_count];
+        }
+    } else {
+        if (index < 0) {
+            if (s_override_count >= SIGNAL_FILTER_MAX_TYPES) {
+                ret = ESP_ERR_NO_MEM;
+            } else {
+                index = s_override_count++;
+            }
+        }
+        if (ret == ESP_OK) {
+            signal_filter_entry_t *e = &s_overrides[index];
+            memset(e, 0, sizeof(*e));
+            strncpy(e->sensor_type, sensor_type, sizeof(e->sensor_type) - 1);
+            e->mode = (uint8_t)config->mode;
+            e->window = config->window;
+            e->alpha = config->alpha;
+            e->process_noise = config->process_noise;
+            e->measurement_noise = config->measurement_noise;
+            e->spike_k = config->spike_k;
+            e->spike_floor = config->spike_floor;
+            e->spike_rel = config->spike_rel;
+        }
+    }
+    snapshot_count = s_override_count;
+    memcpy(snapshot, s_overrides, snapshot_count * sizeof(signal_filter_entry_t));
+    xSemaphoreGive(s_mutex);
+
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    atomic_fetch_add(&s_config_seq, 1);
+    ESP_LOGI(TAG, "Filter for %s set to %s", sensor_type,
+             config != NULL ? signal_filter_mode_name(config->mode) : "defaults");
+    return settings_store_set_blob(SETTING_SIGNAL_FILTERS, snapshot,
+                                   snapshot_count * sizeof(signal_filter_entry_t));
+}
+
+void signal_filter_reset_all(void) {
+    atomic_fetch_add(&s_config_seq, 1);
+}
+
+void signal_filter_reset_slot(uint8_t slot) {
+    if (slot < SIGNAL_FILTER_MAX_SENSORS) {
+        // The next sample then takes the type-change path and restarts every channel
+        s_slot_type[slot][0] = '\0';
+    }
+}
+
+static void signal_filter_reset_channel(uint8_t ch) {
+    s_history_len[ch] = 0;
+    s_history_head[ch] = 0;
+    s_rejects[ch] = 0;
+}
+
+static float signal_filter_median(float *v, uint8_t n) {
+    // Insertion sort: windows are at most SIGNAL_FILTER_WINDOW_MAX samples
+    for (uint8_t i = 1; i < n; i++) {
+        float x = v[i];
+        int j = i - 1;
+        while (j >= 0 && v[j] > x) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = x;
+    }
+    return (n % 2) ? v[n / 2] : 0.5f * (v[n / 2 - 1] + v[n / 2]);
+}
+
+static float signal_filter_history_median(uint8_t ch, uint8_t window) {
+    float sorted[SIGNAL_FILTER_WINDOW_MAX];
+    uint8_t n = s_history_len[ch] < window ? s_history_len[ch] : window;
+    for (uint8_t i = 0; i < n; i++) {
+        sorted[i] = s_history[ch][(s_history_head[ch] + SIGNAL_FILTER_WINDOW_MAX - 1 - i) % SIGNAL_FILTER_WINDOW_MAX];
+    }
+    return signal_filter_median(sorted, n);
+}
+
+static bool signal_filter_is_spike(uint8_t ch, const signal_filter_config_t *config, float x) {
+    uint8_t n = s_history_len[ch] < config->window ? s_history_len[ch] : config->window;
+    if (config->spike_k <= 0.0f || n < SIGNAL_FILTER_WINDOW_MIN) {
+        return false;
+    }
+
+    float median = signal_filter_history_median(ch, config->window);
+    float deviations[SIGNAL_FILTER_WINDOW_MAX];
+    for (uint8_t i = 0; i < n; i++) {
+        float h = s_history[ch][(s_history_head[ch] + SIGNAL_FILTER_WINDOW_MAX - 1 - i) % SIGNAL_FILTER_WINDOW_MAX];
+        deviations[i] = fabsf(h - median);
+    }
+    float mad = signal_filter_median(deviations, n);
+
+    float threshold = config->spike_k * SIGNAL_FILTER_MAD_SCALE * mad;
+    threshold = fmaxf(threshold, config->spike_floor);
+    threshold = fmaxf(threshold, config->spike_rel * fabsf(median));
+    return fabsf(x - median) > threshold;
+}
+
+/**
+ * @brief Run one accepted sample through the smoothing filter
+ */
+static float signal_filter_update(uint8_t ch, const signal_filter_config_t *config, float x) {
+    bool first = (s_history_len[ch] == 0);
+    s_history[ch][s_history_head[ch]] = x;
+    s_history_head[ch] = (s_history_head[ch] + 1) % SIGNAL_FILTER_WINDOW_MAX;
+    if (s_history_len[ch] < SIGNAL_FILTER_WINDOW_MAX) {
+        s_history_len[ch]++;
+    }
+
+    switch (config->mode) {
+    case SIGNAL_FILTER_MEDIAN:
+        s_estimate[ch] = signal_filter_history_median(ch, config->window);
+        break;
+    case SIGNAL_FILTER_EMA:
+        s_estimate[ch] = first ? x : s_estimate[ch] + config->alpha * (x - s_estimate[ch]);
+        break;
+    case SIGNAL_FILTER_KALMAN:
+        if (first) {
+            s_estimate[ch] = x;
+            s_variance[ch] = config->measurement_noise;
+        } else {
+            float p = s_variance[ch] + config->process_noise;
+            float gain = p / (p + config->measurement_noise);
+            s_estimate[ch] += gain * (x - s_estimate[ch]);
+            s_variance[ch] = (1.0f - gain) * p;
+        }
+        break;
+    default:
+        s_estimate[ch] = x;
+        break;
+    }
+    return s_estimate[ch];
+}
+
+sensor_quality_t signal_filter_apply(uint8_t slot, const char *sensor_type, const float *raw,
+                                     float *filtered, uint8_t count) {
+    if (slot >= SIGNAL_FILTER_MAX_SENSORS || sensor_type == NULL || raw == NULL || filtered == NULL) {
+        return SENSOR_QUALITY_INVALID;
+    }
+    if (count > MAX_SENSOR_VALUES) {
+        count = MAX_SENSOR_VALUES;
+    }
+
+    uint32_t seq = atomic_load(&s_config_seq);
+    if (s_slot_seq[slot] != seq || strncmp(s_slot_type[slot], sensor_type, sizeof(s_slot_type[slot])) != 0) {
+        for (uint8_t v = 0; v < MAX_SENSOR_VALUES; v++) {
+            signal_filter_reset_channel(slot * MAX_SENSOR_VALUES + v);
+        }
+        strncpy(s_slot_type[slot], sensor_type, sizeof(s_slot_type[slot]) - 1);
+        s_slot_type[slot][sizeof(s_slot_type[slot]) - 1] = '\0';
+        s_slot_seq[slot] = seq;
+    }
+
+    signal_filter_config_t config;
+    signal_filter_get_config(sensor_type, &config);
+
+    sensor_quality_t quality = SENSOR_QUALITY_GOOD;
+    for (uint8_t v = 0; v < count; v++) {
+        uint8_t ch = slot * MAX_SENSOR_VALUES + v;
+        float x = raw[v];
+        if (!isfinite(x)) {
+            filtered[v] = x;
+            continue;
+        }
+
+        if (signal_filter_is_spike(ch, &config, x)) {
+            if (++s_rejects[ch] < SIGNAL_FILTER_MAX_REJECTS) {
+                filtered[v] = s_estimate[ch];
+                quality = SENSOR_QUALITY_SPIKE;
+                continue;
+            }
+            // The "outlier" persisted: treat it as a real step and start over at the new level
+            ESP_LOGD(TAG, "%s[%u] stepped to %.3f", sensor_type, v, x);
+            signal_filter_reset_channel(ch);
+        }
+        s_rejects[ch] = 0;
+
+        filtered[v] = signal_filter_update(ch, &config, x);
+        bool windowed = config.mode == SIGNAL_FILTER_MEDIAN || config.spike_k > 0.0f;
+        if (windowed && s_history_len[ch] < config.window && quality == SENSOR_QUALITY_GOOD) {
+            quality = SENSOR_QUALITY_SETTLING;
+        }
+    }
+    return quality;
+}
+
+const char *signal_filter_mode_name(signal_filter_mode_t mode) {
+    switch (mode) {
+    case SIGNAL_FILTER_NONE:   return "none";
+    case SIGNAL_FILTER_MEDIAN: return "median";
+    case SIGNAL_FILTER_EMA:    return "ema";
+    case SIGNAL_FILTER_KALMAN: return "kalman";
+    default:                   return "unknown";
+    }
+}
+
+esp_err_t signal_filter_mode_from_name(const char *name, signal_filter_mode_t *mode) {
+    if (name == NULL || mode == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int m = 0; m < SIGNAL_FILTER_MODE_COUNT; m++) {
+        if (strcmp(name, signal_filter_mode_name((signal_filter_mode_t)m)) == 0) {
+            *mode = (signal_filter_mode_t)m;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+const char *signal_filter_quality_name(sensor_quality_t quality) {
+    switch (quality) {
+    case SENSOR_QUALITY_GOOD:     return "good";
+    case SENSOR_QUALITY_SETTLING: return "settling";
+    case SENSOR_QUALITY_SPIKE:    return "spike";
+    case SENSOR_QUALITY_HELD:     return "held";
+    default:                      return "invalid";
+    }
+}
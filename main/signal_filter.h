@@ -0,0 +1,145 @@
+/**
+ * @file signal_filter.h
+ * @brief Per-channel conditioning of EZO readings before they reach the sensor cache
+ *
+ * Every value of every sensor slot is a channel. A fresh sample first goes
+ * through spike rejection: it is compared with the median of the channel's
+ * recent raw samples, and rejected if it is further away than spike_k robust
+ * standard deviations (1.4826 * MAD) and both configured floors. A rejected
+ * sample leaves the estimate unchanged. After SIGNAL_FILTER_MAX_REJECTS
+ * rejections in a row the new level is accepted as a real step. Accepted
+ * samples then feed the smoothing filter chosen for the sensor type: a
+ * sliding median, an EMA or a scalar Kalman filter.
+ *
+ * Filter state is kept as struct-of-arrays indexed by channel, so a cycle
+ * walks a few contiguous arrays. Filtering runs only in the sensor reading
+ * task; configuration can be changed from any task.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sensor_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIGNAL_FILTER_MAX_SENSORS   SENSOR_MANAGER_MAX_SENSORS  // Slots in sensor_cache_t
+#define SIGNAL_FILTER_CHANNELS      (SIGNAL_FILTER_MAX_SENSORS * MAX_SENSOR_VALUES)
+#define SIGNAL_FILTER_WINDOW_MIN    3
+#define SIGNAL_FILTER_WINDOW_MAX    9
+#define SIGNAL_FILTER_MAX_REJECTS   3       // Consecutive outliers accepted as a step change
+#define SIGNAL_FILTER_MAX_TYPES     8
+
+typedef enum {
+    SIGNAL_FILTER_NONE = 0,     // Spike rejection only
+    SIGNAL_FILTER_MEDIAN,       // Median of the last window samples
+    SIGNAL_FILTER_EMA,          // Exponential moving average
+    SIGNAL_FILTER_KALMAN,       // Scalar Kalman filter with a constant-level model
+    SIGNAL_FILTER_MODE_COUNT
+} signal_filter_mode_t;
+
+/**
+ * @brief Conditioning settings for one sensor type
+ */
+typedef struct {
+    signal_filter_mode_t mode;
+    uint8_t window;             // Raw samples kept for the median and for spike detection
+    float alpha;                // EMA weight of a new sample, (0, 1]
+    float process_noise;        // Kalman q: expected variance of the true value per sample
+    float measurement_noise;    // Kalman r: variance of the probe reading
+    float spike_k;              // Outlier threshold in robust standard deviations, 0 disables rejection
+    float spike_floor;          // Deviations below this (in sensor units) are never outliers
+    float spike_rel;            // Nor are deviations below this fraction of the median
+} signal_filter_config_t;
+
+/**
+ * @brief Persisted form of one override (SETTING_SIGNAL_FILTERS blob entry)
+ */
+typedef struct {
+    char sensor_type[8];
+    uint8_t mode;
+    uint8_t window;
+    uint8_t reserved[2];
+    float alpha;
+    float process_noise;
+    float measurement_noise;
+    float spike_k;
+    float spike_floor;
+    float spike_rel;
+} signal_filter_entry_t;
+
+/**
+ * @brief Load saved per-type overrides from the settings store
+ *
+ * Types without an override use built-in defaults tuned to each EZO probe.
+ */
+esp_err_t signal_filter_init(void);
+
+/**
+ * @brief Condition one fresh sample of a sensor slot
+ *
+ * Channel state is reset when the slot's sensor type changes, for example
+ * after a rescan.
+ *
+ * @param slot Sensor slot (index into sensor_cache_t.sensors)
+ * @param sensor_type EZO type of the board in the slot
+ * @param raw Values as read from the board
+ * @param filtered Output conditioned values (may alias raw)
+ * @param count Number of values
+ * @return Quality of the conditioned values
+ */
+sensor_quality_t signal_filter_apply(uint8_t slot, const char *sensor_type, const float *raw,
+                                     float *filtered, uint8_t count);
+
+/**
+ * @brief Forget the history of every channel
+ */
+void signal_filter_reset_all(void);
+
+/**
+ * @brief Forget the history of one slot, e.g. when another board takes it
+ *
+ * Call from the task that applies the filters.
+ */
+void signal_filter_reset_slot(uint8_t slot);
+
+/**
+ * @brief Get the settings in effect for a sensor type
+ */
+void signal_filter_get_config(const char *sensor_type, signal_filter_config_t *config);
+
+/**
+ * @brief Override the settings for a sensor type (persisted)
+ *
+ * Channel histories restart with the new settings.
+ *
+ * @param config New settings, or NULL to return to the built-in defaults
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for out-of-range
+ *         settings, ESP_ERR_NO_MEM when SIGNAL_FILTER_MAX_TYPES types are overridden
+ */
+esp_err_t signal_filter_set_config(const char *sensor_type, const signal_filter_config_t *config);
+
+/**
+ * @brief Name of a filter mode ("none", "median", "ema", "kalman")
+ */
+const char *signal_filter_mode_name(signal_filter_mode_t mode);
+
+/**
+ * @brief Parse a filter mode name
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND for unknown names
+ */
+esp_err_t signal_filter_mode_from_name(const char *name, signal_filter_mode_t *mode);
+
+/**
+ * @brief Name of a quality flag ("good", "settling", "spike", "held", "invalid")
+ */
+const char *signal_filter_quality_name(sensor_quality_t quality);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,140 @@
+/**
+ * @file startup_orchestrator.c
+ * @brief Dependency-ordered, concurrent bring-up of subsystems
+ */
+
+#include "startup_orchestrator.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include <string.h>
+
+static const char *TAG = "STARTUP";
+
+typedef struct {
+    const startup_stage_t *stage;
+    size_t index;
+} stage_arg_t;
+
+// State of the run in progress; written by each stage's own worker only
+static EventGroupHandle_t s_done_group = NULL;
+static const startup_stage_t *s_stages = NULL;
+static size_t s_stage_count = 0;
+static esp_err_t s_results[STARTUP_MAX_STAGES];
+static uint32_t s_duration_ms[STARTUP_MAX_STAGES];
+static stage_arg_t s_args[STARTUP_MAX_STAGES];
+
+/**
+ * @brief Check that every stage depends only on stages listed before it
+ *
+ * That rules out cycles, and lets a stage with no worker run inline.
+ */
+static bool stages_ordered(const startup_stage_t *stages, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        uint32_t earlier = STARTUP_DEP(i) - 1;
+        if ((stages[i].deps & ~earlier) != 0) {
+            ESP_LOGE(TAG, "Stage '%s' depends on itself or a later stage", stages[i].name);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void stage_execute(const startup_stage_t *stage, size_t index)
+{
+    if (stage->deps != 0) {
+        xEventGroupWaitBits(s_done_group, stage->deps, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+
+    esp_err_t result = ESP_OK;
+    for (size_t d = 0; d < s_stage_count; d++) {
+        if ((stage->deps & STARTUP_DEP(d)) && s_results[d] != ESP_OK) {
+            ESP_LOGW(TAG, "Skipping '%s': '%s' did not complete", stage->name, s_stages[d].name);
+            result = ESP_ERR_INVALID_STATE;
+            break;
+        }
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    if (result == ESP_OK && stage->fn != NULL) {
+        result = stage->fn();
+        if (result != ESP_OK) {
+            ESP_LOGW(TAG, "Stage '%s' failed: %s", stage->name, esp_err_to_name(result));
+        }
+    }
+    s_duration_ms[index] = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    s_results[index] = result;
+
+    // Result is published before the bit, so dependents always see it
+    xEventGroupSetBits(s_done_group, STARTUP_DEP(index));
+}
+
+static void stage_task(void *arg)
+{
+    const stage_arg_t *stage_arg = (const stage_arg_t *)arg;
+    stage_execute(stage_arg->stage, stage_arg->index);
+    vTaskDelete(NULL);
+}
+
+esp_err_t startup_orchestrator_run(const startup_stage_t *stages, size_t count)
+{
+    if (stages == NULL || count == 0 || count > STARTUP_MAX_STAGES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!stages_ordered(stages, count)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_done_group = xEventGroupCreate();
+    if (s_done_group == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_stages = stages;
+    s_stage_count = count;
+    for (size_t i = 0; i < count; i++) {
+        s_results[i] = ESP_ERR_NOT_FINISHED;
+        s_duration_ms[i] = 0;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    UBaseType_t priority = uxTaskPriorityGet(NULL);
+    for (size_t i = 0; i < count; i++) {
+        s_args[i].stage = &stages[i];
+        s_args[i].index = i;
+        uint32_t stack = stages[i].stack_size ? stages[i].stack_size : STARTUP_DEFAULT_STACK_SIZE;
+        if (xTaskCreate(stage_task, stages[i].name, stack, &s_args[i], priority, NULL) != pdPASS) {
+            // No memory for another worker: run it here once its dependencies are done
+            ESP_LOGW(TAG, "No worker for '%s', running inline", stages[i].name);
+            stage_execute(&stages[i], i);
+        }
+    }
+
+    uint32_t all = STARTUP_DEP(count) - 1;
+    xEventGroupWaitBits(s_done_group, all, pdFALSE, pdTRUE, portMAX_DELAY);
+    uint32_t total_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0; i < count; i++) {
+        ESP_LOGI(TAG, "  %-14s %6lu ms  %s", stages[i].name, (unsigned long)s_duration_ms[i],
+                 s_results[i] == ESP_OK ? "ok" : esp_err_to_name(s_results[i]));
+        if (s_results[i] != ESP_OK) {
+            ret = ESP_FAIL;
+        }
+    }
+    ESP_LOGI(TAG, "Startup finished in %lu ms", (unsigned long)total_ms);
+
+    vEventGroupDelete(s_done_group);
+    s_done_group = NULL;
+    return ret;
+}
+
+esp_err_t startup_orchestrator_stage_result(size_t index)
+{
+    if (index >= s_stage_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return s_results[index];
+}
@@ -0,0 +1,59 @@
+/**
+ * @file startup_orchestrator.h
+ * @brief Dependency-ordered, concurrent bring-up of subsystems
+ *
+ * Each stage names the stages it depends on. Every stage gets its own short-lived
+ * task that waits until its dependencies have finished, so independent chains
+ * (sensor bring-up and cloud provisioning, for example) run side by side and the
+ * whole startup takes about as long as its longest chain. A stage whose
+ * dependency failed is skipped, and so is everything that depends on it.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STARTUP_MAX_STAGES          24      // Event group bits available per stage
+#define STARTUP_DEFAULT_STACK_SIZE  4096
+
+// Dependency mask bit for the stage at index i of the table
+#define STARTUP_DEP(i)              (1UL << (i))
+
+typedef esp_err_t (*startup_stage_fn_t)(void);
+
+typedef struct {
+    const char *name;               // Also used as the worker task name
+    startup_stage_fn_t fn;          // NULL marks an empty slot (done, nothing to run)
+    uint32_t deps;                  // STARTUP_DEP() bits of the stages that must succeed first
+    uint32_t stack_size;            // 0 for STARTUP_DEFAULT_STACK_SIZE
+} startup_stage_t;
+
+/**
+ * @brief Run a stage table and wait for every stage to finish or be skipped
+ *
+ * Worker tasks run at the caller's priority. Not reentrant.
+ *
+ * @param stages Stage table; a stage may only depend on stages listed before it
+ * @param count Number of entries (at most STARTUP_MAX_STAGES)
+ * @return esp_err_t ESP_OK if every stage succeeded, ESP_FAIL if any failed or
+ *         was skipped, ESP_ERR_INVALID_ARG if a stage depends on itself or a later one
+ */
+esp_err_t startup_orchestrator_run(const startup_stage_t *stages, size_t count);
+
+/**
+ * @brief Result of a stage from the last run
+ *
+ * @return The stage function's result, ESP_ERR_INVALID_STATE if it was skipped,
+ *         or ESP_ERR_NOT_FINISHED while it has not completed
+ */
+esp_err_t startup_orchestrator_stage_result(size_t index);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,110 @@
+/**
+ * @file task_profile.c
+ * @brief Per-target core, priority and stack of the application's tasks
+ */
+
+#include "task_profile.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "TASK_PROFILE";
+
+#if defined(CONFIG_KC_TASK_PROFILE_ISOLATED)
+
+// Core 1: acquisition, with the arbiter above its clients so grants are never late.
+// Core 0: Wi-Fi, lwIP and TLS; the dashboard yields to publishing.
+#define TASK_PROFILE_NAME "isolated"
+static const task_profile_entry_t s_entries[TASK_PROFILE_COUNT] = {
+    [TASK_PROFILE_I2C_ARBITER]    = { "i2c_arb",        1, 7, 4096 },
+    [TASK_PROFILE_SENSOR_READ]    = { "sensor_read",    1, 6, 6144 },
+    [TASK_PROFILE_SENSOR_JOBS]    = { "sensor_jobs",    1, 4, 4096 },
+    [TASK_PROFILE_SENSOR_HOTPLUG] = { "sensor_hotplug", 1, 1, 4096 },
+    [TASK_PROFILE_MQTT_PUBLISH]   = { "mqtt_publish",   0, 5, 6144 },
+    [TASK_PROFILE_MQTT_CLIENT]    = { "mqtt_task",      0, 5, 6144 },
+    [TASK_PROFILE_HTTPD]          = { "httpd",          0, 4, 8192 },
+    [TASK_PROFILE_LAN_POLL]       = { "lan_poll",       0, 4, 4096 },
+    [TASK_PROFILE_OT_MAIN]        = { "ot_main",        0, 5, 6144 },
+    [TASK_PROFILE_THREAD_TLM]     = { "thread_tlm",     0, 5, 4096 },
+};
+
+#elif defined(CONFIG_KC_TASK_PROFILE_COOPERATIVE)
+
+// One core: strict ordering, each level only runs while the ones above it block
+#define TASK_PROFILE_NAME "cooperative"
+static const task_profile_entry_t s_entries[TASK_PROFILE_COUNT] = {
+    [TASK_PROFILE_I2C_ARBITER]    = { "i2c_arb",        -1, 7, 4096 },
+    [TASK_PROFILE_SENSOR_READ]    = { "sensor_read",    -1, 6, 6144 },
+    [TASK_PROFILE_MQTT_PUBLISH]   = { "mqtt_publish",   -1, 5, 6144 },
+    [TASK_PROFILE_MQTT_CLIENT]    = { "mqtt_task",      -1, 5, 6144 },
+    [TASK_PROFILE_OT_MAIN]        = { "ot_main",        -1, 5, 6144 },
+    [TASK_PROFILE_THREAD_TLM]     = { "thread_tlm",     -1, 5, 4096 },
+    [TASK_PROFILE_SENSOR_JOBS]    = { "sensor_jobs",    -1, 4, 4096 },
+    [TASK_PROFILE_HTTPD]          = { "httpd",          -1, 3, 8192 },
+    [TASK_PROFILE_LAN_POLL]       = { "lan_poll",       -1, 3, 4096 },
+    [TASK_PROFILE_SENSOR_HOTPLUG] = { "sensor_hotplug", -1, 1, 4096 },
+};
+
+#else
+
+// The fixed parameters used before profiles existed
+#define TASK_PROFILE_NAME "legacy"
+static const task_profile_entry_t s_entries[TASK_PROFILE_COUNT] = {
+    [TASK_PROFILE_I2C_ARBITER]    = { "i2c_arb",        1, 6, 4096 },
+    [TASK_PROFILE_SENSOR_READ]    = { "sensor_read",    1, 5, 6144 },
+    [TASK_PROFILE_SENSOR_JOBS]    = { "sensor_jobs",    1, 5, 4096 },
+    [TASK_PROFILE_SENSOR_HOTPLUG] = { "sensor_hotplug", -1, 2, 4096 },
+    [TASK_PROFILE_MQTT_PUBLISH]   = { "mqtt_publish",   0, 5, 6144 },
+    [TASK_PROFILE_MQTT_CLIENT]    = { "mqtt_task",      -1, 5, 6144 },
+    [TASK_PROFILE_HTTPD]          = { "httpd",          -1, 5, 8192 },
+    [TASK_PROFILE_LAN_POLL]       = { "lan_poll",       -1, 5, 4096 },
+    [TASK_PROFILE_OT_MAIN]        = { "ot_main",        -1, 5, 6144 },
+    [TASK_PROFILE_THREAD_TLM]     = { "thread_tlm",     -1, 5, 4096 },
+};
+
+#endif
+
+const char *task_profile_name(void) {
+    return TASK_PROFILE_NAME;
+}
+
+const task_profile_entry_t *task_profile_get(task_profile_task_t task) {
+    return &s_entries[task];
+}
+
+BaseType_t task_profile_create(task_profile_task_t task, TaskFunction_t fn, const char *name,
+                               void *arg, TaskHandle_t *handle) {
+    const task_profile_entry_t *entry = task_profile_get(task);
+#ifdef CONFIG_FREERTOS_UNICORE
+    BaseType_t core = tskNO_AFFINITY;
+#else
+    BaseType_t core = entry->core < 0 ? tskNO_AFFINITY : entry->core;
+#endif
+    BaseType_t ret = xTaskCreatePinnedToCore(fn, name != NULL ? name : entry->name, entry->stack, arg,
+                                             entry->priority, handle, core);
+    if (ret == pdPASS) {
+        ESP_LOGD(TAG, "%s: core %d, priority %u, stack %lu (%s)", name != NULL ? name : entry->name,
+                 (int)entry->core, entry->priority, (unsigned long)entry->stack, TASK_PROFILE_NAME);
+    }
+    return ret;
+}
+
+void task_profile_write_json(json_writer_t *w) {
+    json_writer_object_begin(w);
+    json_writer_kv_string(w, "name", TASK_PROFILE_NAME);
+    json_writer_key(w, "tasks");
+    json_writer_array_begin(w);
+    for (int t = 0; t < TASK_PROFILE_COUNT; t++) {
+        json_writer_object_begin(w);
+        json_writer_kv_string(w, "name", s_entries[t].name);
+#ifdef CONFIG_FREERTOS_UNICORE
+        json_writer_kv_int(w, "core", -1);
+#else
+        json_writer_kv_int(w, "core", s_entries[t].core);
+#endif
+        json_writer_kv_int(w, "priority", s_entries[t].priority);
+        json_writer_kv_int(w, "stack", s_entries[t].stack);
+        json_writer_object_end(w);
+    }
+    json_writer_array_end(w);
+    json_writer_object_end(w);
+}
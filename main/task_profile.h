@@ -0,0 +1,70 @@
+/**
+ * @file task_profile.h
+ * @brief Per-target core, priority and stack of the application's tasks
+ *
+ * The profile is chosen with CONFIG_KC_TASK_PROFILE_* (menuconfig, "KC
+ * device task scheduling"). On the dual-core S3 the default keeps I2C
+ * acquisition on core 1, away from Wi-Fi, lwIP and TLS on core 0. On the
+ * single-core C6 it orders priorities so acquisition preempts publishing,
+ * and publishing preempts the web server.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "json_writer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    TASK_PROFILE_I2C_ARBITER = 0,
+    TASK_PROFILE_SENSOR_READ,
+    TASK_PROFILE_SENSOR_JOBS,
+    TASK_PROFILE_SENSOR_HOTPLUG,
+    TASK_PROFILE_MQTT_PUBLISH,
+    TASK_PROFILE_MQTT_CLIENT,   // esp-mqtt's task; its core comes from CONFIG_MQTT_USE_CORE_*
+    TASK_PROFILE_HTTPD,
+    TASK_PROFILE_LAN_POLL,
+    TASK_PROFILE_OT_MAIN,       // OpenThread mainloop (Thread telemetry)
+    TASK_PROFILE_THREAD_TLM,
+    TASK_PROFILE_COUNT
+} task_profile_task_t;
+
+typedef struct {
+    const char *name;           // Task name as the profiler reports it
+    int8_t core;                // -1: either core
+    uint8_t priority;
+    uint32_t stack;             // Bytes
+} task_profile_entry_t;
+
+/**
+ * @brief Name of the profile built in ("isolated", "cooperative" or "legacy")
+ */
+const char *task_profile_name(void);
+
+/**
+ * @brief Scheduling parameters of one task
+ */
+const task_profile_entry_t *task_profile_get(task_profile_task_t task);
+
+/**
+ * @brief Create a task with its profile's core, priority and stack
+ *
+ * @param name Task name, or NULL for the profile's name
+ * @return pdPASS on success
+ */
+BaseType_t task_profile_create(task_profile_task_t task, TaskFunction_t fn, const char *name,
+                               void *arg, TaskHandle_t *handle);
+
+/**
+ * @brief Write the profile as a JSON object: name plus each task's parameters
+ */
+void task_profile_write_json(json_writer_t *w);
+
+#ifdef __cplusplus
+}
+#endif
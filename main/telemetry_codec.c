@@ -0,0 +1,493 @@
+/**
+ * @file telemetry_codec.c
+ * @brief Sensor telemetry encodings shared by MQTT, HTTP and WebSocket
+ */
+
+#include "telemetry_codec.h"
+#include "derived_metrics.h"
+#include "ezo_sensor.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#define CBOR_MAJOR_UINT     0
+#define CBOR_MAJOR_NEGINT   1
+#define CBOR_MAJOR_TEXT     3
+#define CBOR_MAJOR_ARRAY    4
+#define CBOR_MAJOR_MAP      5
+#define CBOR_FLOAT32        0xFA
+
+enum {
+    TELEMETRY_KEY_VERSION = 0,
+    TELEMETRY_KEY_DEVICE_ID,
+    TELEMETRY_KEY_TIMESTAMP_MS,
+    TELEMETRY_KEY_SENSORS,
+    TELEMETRY_KEY_BATTERY,
+    TELEMETRY_KEY_RSSI,
+    TELEMETRY_KEY_UNIX_TIME,
+    TELEMETRY_KEY_DERIVED,
+};
+
+#define TELEMETRY_PACKED_VERSION    1
+
+const char *telemetry_value_name(const char *sensor_type, uint8_t index)
+{
+    return ezo_sensor_channel_name(ezo_sensor_kind_from_type(sensor_type), index);
+}
+
+bool telemetry_sensor_names(const cached_sensor_t *sensor, const char *names[MAX_SENSOR_VALUES])
+{
+    bool named = (sensor->kind != EZO_KIND_UNKNOWN);
+    for (uint8_t j = 0; j < MAX_SENSOR_VALUES; j++) {
+        names[j] = named ? ezo_sensor_channel_name(sensor->kind, sensor->channels[j]) : NULL;
+    }
+    return named;
+}
+
+void telemetry_sensor_set_kind(cached_sensor_t *sensor)
+{
+    sensor->kind = ezo_sensor_kind_from_type(sensor->sensor_type);
+    uint8_t channel_count = ezo_sensor_desc(sensor->kind)->channel_count;
+    for (uint8_t j = 0; j < MAX_SENSOR_VALUES; j++) {
+        sensor->channels[j] = (j < channel_count) ? j : EZO_CHANNEL_NONE;
+    }
+}
+
+const char *telemetry_sensor_key(const sensor_cache_t *cache, uint8_t index, char *key, size_t size)
+{
+    const char *type = cache->sensors[index].sensor_type;
+    unsigned ordinal = 1;
+    for (uint8_t i = 0; i < index; i++) {
+        if (strcmp(cache->sensors[i].sensor_type, type) == 0) {
+            ordinal++;
+        }
+    }
+    if (ordinal == 1) {
+        return type;
+    }
+    snprintf(key, size, "%s_%u", type, ordinal);
+    return key;
+}
+
+void telemetry_write_sensor_json(json_writer_t *w, const char *sensor_type,
+                                 const float *values, uint8_t count, const char *const *names)
+{
+    telemetry_write_keyed_sensor_json(w, sensor_type, sensor_type, values, count, names);
+}
+
+void telemetry_write_keyed_sensor_json(json_writer_t *w, const char *key, const char *sensor_type,
+                                       const float *values, uint8_t count, const char *const *names)
+{
+    if (count == 0) {
+        return;
+    }
+    if (count > MAX_SENSOR_VALUES) {
+        count = MAX_SENSOR_VALUES;
+    }
+
+    if (count == 1) {
+        json_writer_kv_float(w, key, values[0]);
+        return;
+    }
+
+    json_writer_key(w, key);
+    json_writer_object_begin(w);
+    const char *default_names[MAX_SENSOR_VALUES];
+    if (names == NULL) {
+        ezo_sensor_kind_t kind = ezo_sensor_kind_from_type(sensor_type);
+        for (uint8_t j = 0; j < count; j++) {
+            default_names[j] = ezo_sensor_channel_name(kind, j);
+        }
+        if (kind != EZO_KIND_UNKNOWN) {
+            names = default_names;
+        }
+    }
+    bool named = (names != NULL);
+    for (uint8_t j = 0; j < count; j++) {
+        if (named) {
+            const char *field = names[j];
+            if (field != NULL) {
+                json_writer_kv_float(w, field, values[j]);
+            }
+        } else {
+            // Unknown multi-value sensor - use generic field names
+            char field[16];
+            snprintf(field, sizeof(field), "value_%d", j);
+            json_writer_kv_float(w, field, values[j]);
+        }
+    }
+    json_writer_object_end(w);
+}
+
+void telemetry_write_sensors_json(json_writer_t *w, const sensor_cache_t *cache)
+{
+    json_writer_object_begin(w);
+    for (uint8_t i = 0; cache != NULL && i < cache->sensor_count && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
+        const cached_sensor_t *sensor = &cache->sensors[i];
+        if (sensor->valid) {
+            char key[24];
+            const char *names[MAX_SENSOR_VALUES];
+            bool named = telemetry_sensor_names(sensor, names);
+            telemetry_write_keyed_sensor_json(w, telemetry_sensor_key(cache, i, key, sizeof(key)),
+                                              sensor->sensor_type, sensor->values, sensor->value_count,
+                                              named ? names : NULL);
+        }
+    }
+    json_writer_object_end(w);
+}
+
+void telemetry_write_derived_json(json_writer_t *w, const sensor_cache_t *cache)
+{
+    if (cache == NULL || cache->derived_valid == 0) {
+        return;
+    }
+    json_writer_key(w, "derived");
+    json_writer_object_begin(w);
+    for (uint8_t m = 0; m < DERIVED_METRIC_COUNT; m++) {
+        if (cache->derived_valid & (1u << m)) {
+            json_writer_kv_float(w, derived_metrics_name(m), cache->derived[m]);
+        }
+    }
+    json_writer_object_end(w);
+}
+
+static uint8_t telemetry_derived_count(const sensor_cache_t *cache)
+{
+    uint8_t count = 0;
+    for (uint8_t m = 0; m < DERIVED_METRIC_COUNT; m++) {
+        if (cache->derived_valid & (1u << m)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+typedef struct {
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+} cbor_writer_t;
+
+static void cbor_put(cbor_writer_t *w, const void *data, size_t len)
+{
+    if (w->overflow || w->len + len > w->size) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+}
+
+static void cbor_put_head(cbor_writer_t *w, uint8_t major, uint64_t value)
+{
+    uint8_t head[9];
+    size_t n;
+
+    if (value < 24) {
+        head[0] = (major << 5) | (uint8_t)value;
+        n = 1;
+    } else if (value <= 0xFF) {
+        head[0] = (major << 5) | 24;
+        head[1] = (uint8_t)value;
+        n = 2;
+    } else if (value <= 0xFFFF) {
+        head[0] = (major << 5) | 25;
+        head[1] = (uint8_t)(value >> 8);
+        head[2] = (uint8_t)value;
+        n = 3;
+    } else if (value <= 0xFFFFFFFFULL) {
+        head[0] = (major << 5) | 26;
+        for (int i = 0; i < 4; i++) {
+            head[1 + i] = (uint8_t)(value >> (24 - 8 * i));
+        }
+        n = 5;
+    } else {
+        head[0] = (major << 5) | 27;
+        for (int i = 0; i < 8; i++) {
+            head[1 + i] = (uint8_t)(value >> (56 - 8 * i));
+        }
+        n = 9;
+    }
+    cbor_put(w, head, n);
+}
+
+static void cbor_put_int(cbor_writer_t *w, int64_t value)
+{
+    if (value >= 0) {
+        cbor_put_head(w, CBOR_MAJOR_UINT, (uint64_t)value);
+    } else {
+        cbor_put_head(w, CBOR_MAJOR_NEGINT, (uint64_t)(-1 - value));
+    }
+}
+
+static void cbor_put_text(cbor_writer_t *w, const char *text)
+{
+    size_t len = strlen(text);
+    cbor_put_head(w, CBOR_MAJOR_TEXT, len);
+    cbor_put(w, text, len);
+}
+
+static void cbor_put_float(cbor_writer_t *w, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint8_t out[5] = {
+        CBOR_FLOAT32,
+        (uint8_t)(bits >> 24), (uint8_t)(bits >> 16), (uint8_t)(bits >> 8), (uint8_t)bits,
+    };
+    cbor_put(w, out, sizeof(out));
+}
+
+esp_err_t telemetry_encode_cbor(const char *device_id, const sensor_cache_t *cache, uint32_t unix_time,
+                                uint8_t *buf, size_t buf_size, size_t *out_len)
+{
+    if (cache == NULL || buf == NULL || out_len == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cbor_writer_t w = {
+        .buf = buf,
+        .size = buf_size,
+    };
+
+    uint8_t sensor_count = 0;
+    for (uint8_t i = 0; i < cache->sensor_count && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
+        if (cache->sensors[i].valid) {
+            sensor_count++;
+        }
+    }
+
+    uint8_t derived_count = telemetry_derived_count(cache);
+    cbor_put_head(&w, CBOR_MAJOR_MAP, 4 + (device_id != NULL ? 1 : 0) +
+                                       (cache->battery_valid ? 1 : 0) + (unix_time != 0 ? 1 : 0) +
+                                       (derived_count > 0 ? 1 : 0));
+
+    cbor_put_int(&w, TELEMETRY_KEY_VERSION);
+    cbor_put_int(&w, TELEMETRY_CBOR_SCHEMA_VERSION);
+
+    if (device_id != NULL) {
+        cbor_put_int(&w, TELEMETRY_KEY_DEVICE_ID);
+        cbor_put_text(&w, device_id);
+    }
+
+    cbor_put_int(&w, TELEMETRY_KEY_TIMESTAMP_MS);
+    cbor_put_int(&w, (int64_t)(cache->timestamp_us / 1000ULL));
+
+    cbor_put_int(&w, TELEMETRY_KEY_SENSORS);
+    cbor_put_head(&w, CBOR_MAJOR_ARRAY, sensor_count);
+    for (uint8_t i = 0; i < cache->sensor_count && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
+        const cached_sensor_t *sensor = &cache->sensors[i];
+        if (!sensor->valid) {
+            continue;
+        }
+        uint8_t value_count = sensor->value_count < MAX_SENSOR_VALUES ? sensor->value_count : MAX_SENSOR_VALUES;
+        cbor_put_head(&w, CBOR_MAJOR_ARRAY, 2);
+        cbor_put_text(&w, sensor->sensor_type);
+        cbor_put_head(&w, CBOR_MAJOR_ARRAY, value_count);
+        for (uint8_t v = 0; v < value_count; v++) {
+            cbor_put_float(&w, sensor->values[v]);
+        }
+    }
+
+    if (cache->battery_valid) {
+        cbor_put_int(&w, TELEMETRY_KEY_BATTERY);
+        cbor_put_float(&w, cache->battery_percentage);
+    }
+
+    cbor_put_int(&w, TELEMETRY_KEY_RSSI);
+    cbor_put_int(&w, cache->rssi);
+
+    if (unix_time != 0) {
+        cbor_put_int(&w, TELEMETRY_KEY_UNIX_TIME);
+        cbor_put_int(&w, unix_time);
+    }
+
+    if (derived_count > 0) {
+        cbor_put_int(&w, TELEMETRY_KEY_DERIVED);
+        cbor_put_head(&w, CBOR_MAJOR_MAP, derived_count);
+        for (uint8_t m = 0; m < DERIVED_METRIC_COUNT; m++) {
+            if (cache->derived_valid & (1u << m)) {
+                cbor_put_text(&w, derived_metrics_name(m));
+                cbor_put_float(&w, cache->derived[m]);
+            }
+        }
+    }
+
+    if (w.overflow) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *out_len = w.len;
+    return ESP_OK;
+}
+
+esp_err_t telemetry_encode_cbor_array(size_t count, uint8_t *buf, size_t buf_size, size_t *out_len)
+{
+    if (buf == NULL || out_len == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cbor_writer_t w = {
+        .buf = buf,
+        .size = buf_size,
+    };
+    cbor_put_head(&w, CBOR_MAJOR_ARRAY, count);
+    if (w.overflow) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *out_len = w.len;
+    return ESP_OK;
+}
+
+static void pack_put(cbor_writer_t *w, const void *data, size_t len)
+{
+    // Packed records are host byte order (little-endian on every ESP32 target)
+    cbor_put(w, data, len);
+}
+
+esp_err_t telemetry_pack_snapshot(const sensor_cache_t *cache, uint32_t unix_time,
+                                  uint8_t *buf, size_t buf_size, size_t *out_len)
+{
+    if (cache == NULL || buf == NULL || out_len == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cbor_writer_t w = {
+        .buf = buf,
+        .size = buf_size,
+    };
+
+    uint8_t version = TELEMETRY_PACKED_VERSION;
+    float battery = cache->battery_valid ? cache->battery_percentage : NAN;
+    int8_t rssi = cache->rssi;
+    uint8_t sensor_count = 0;
+    for (uint8_t i = 0; i < cache->sensor_count && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
+        if (cache->sensors[i].valid) {
+            sensor_count++;
+        }
+    }
+
+    pack_put(&w, &version, sizeof(version));
+    pack_put(&w, &unix_time, sizeof(unix_time));
+    pack_put(&w, &battery, sizeof(battery));
+    pack_put(&w, &rssi, sizeof(rssi));
+    pack_put(&w, &sensor_count, sizeof(sensor_count));
+
+    for (uint8_t i = 0; i < cache->sensor_count && i < SENSOR_MANAGER_MAX_SENSORS; i++) {
+        const cached_sensor_t *sensor = &cache->sensors[i];
+        if (!sensor->valid) {
+            continue;
+        }
+        uint8_t type_len = (uint8_t)strnlen(sensor->sensor_type, sizeof(sensor->sensor_type) - 1);
+        uint8_t value_count = sensor->value_count < MAX_SENSOR_VALUES ? sensor->value_count : MAX_SENSOR_VALUES;
+        pack_put(&w, &type_len, sizeof(type_len));
+        pack_put(&w, sensor->sensor_type, type_len);
+        pack_put(&w, &value_count, sizeof(value_count));
+        pack_put(&w, sensor->values, value_count * sizeof(float));
+    }
+
+    // The derived section is optional: a record full of sensors goes without it
+    uint8_t derived_mask = cache->derived_valid & (uint8_t)((1u << DERIVED_METRIC_COUNT) - 1);
+    if (derived_mask != 0 && !w.overflow &&
+        w.len + 1 + telemetry_derived_count(cache) * sizeof(float) <= w.size) {
+        pack_put(&w, &derived_mask, sizeof(derived_mask));
+        for (uint8_t m = 0; m < DERIVED_METRIC_COUNT; m++) {
+            if (derived_mask & (1u << m)) {
+                pack_put(&w, &cache->derived[m], sizeof(float));
+            }
+        }
+    }
+
+    if (w.overflow) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *out_len = w.len;
+    return ESP_OK;
+}
+
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;
+    bool underflow;
+} pack_reader_t;
+
+static void pack_get(pack_reader_t *r, void *out, size_t len)
+{
+    if (r->underflow || r->pos + len > r->len) {
+        r->underflow = true;
+        memset(out, 0, len);
+        return;
+    }
+    memcpy(out, r->buf + r->pos, len);
+    r->pos += len;
+}
+
+esp_err_t telemetry_unpack_snapshot(const uint8_t *buf, size_t len, sensor_cache_t *cache, uint32_t *unix_time)
+{
+    if (buf == NULL || cache == NULL || unix_time == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pack_reader_t r = {
+        .buf = buf,
+        .len = len,
+    };
+    memset(cache, 0, sizeof(*cache));
+
+    uint8_t version = 0;
+    float battery = NAN;
+    uint8_t sensor_count = 0;
+    pack_get(&r, &version, sizeof(version));
+    if (version != TELEMETRY_PACKED_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    pack_get(&r, unix_time, sizeof(*unix_time));
+    pack_get(&r, &battery, sizeof(battery));
+    pack_get(&r, &cache->rssi, sizeof(cache->rssi));
+    pack_get(&r, &sensor_count, sizeof(sensor_count));
+    if (sensor_count > SENSOR_MANAGER_MAX_SENSORS) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    cache->battery_valid = !isnan(battery);
+    cache->battery_percentage = cache->battery_valid ? battery : 0.0f;
+
+    for (uint8_t i = 0; i < sensor_count && !r.underflow; i++) {
+        cached_sensor_t *sensor = &cache->sensors[i];
+        uint8_t type_len = 0;
+        pack_get(&r, &type_len, sizeof(type_len));
+        if (type_len >= sizeof(sensor->sensor_type)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        pack_get(&r, sensor->sensor_type, type_len);
+        sensor->sensor_type[type_len] = '\0';
+        telemetry_sensor_set_kind(sensor);
+        pack_get(&r, &sensor->value_count, sizeof(sensor->value_count));
+        if (sensor->value_count > MAX_SENSOR_VALUES) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        pack_get(&r, sensor->values, sensor->value_count * sizeof(float));
+        memcpy(sensor->raw_values, sensor->values, sizeof(sensor->raw_values));
+        sensor->quality = SENSOR_QUALITY_GOOD;
+        sensor->valid = true;
+    }
+
+    if (!r.underflow && r.pos < r.len) {
+        uint8_t derived_mask = 0;
+        pack_get(&r, &derived_mask, sizeof(derived_mask));
+        for (uint8_t m = 0; m < MAX_DERIVED_VALUES && !r.underflow; m++) {
+            if (derived_mask & (1u << m)) {
+                pack_get(&r, &cache->derived[m], sizeof(float));
+            }
+        }
+        // Metrics this firmware does not know are read past but not reported
+        cache->derived_valid = derived_mask & (uint8_t)((1u << DERIVED_METRIC_COUNT) - 1);
+    }
+
+    if (r.underflow) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    cache->sensor_count = sensor_count;
+    return ESP_OK;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file telemetry_codec.h
+ * @brief Sensor telemetry encodings shared by MQTT, HTTP and WebSocket
+ *
+ * The JSON "sensors" object is rendered with the streaming JSON writer:
+ * single-value sensors map to a number, multi-value sensors to an object
+ * with named fields ("conductivity", "tds", ...).
+ *
+ * The compact binary (CBOR) schema version 1 is a CBOR map with small integer keys that mirrors
+ * sensor_cache_t:
+ *
+ *   0: schema version (uint)
+ *   1: device id (text, omitted on MQTT 5 where the topic names the device)
+ *   2: snapshot time, ms since boot (uint)
+ *   3: sensors, array of [type (text), values (array of float32)]
+ *   4: battery percentage (float32, omitted when invalid)
+ *   5: RSSI in dBm (int)
+ *   6: acquisition time, Unix seconds (uint, omitted when the clock is not synced)
+ *   7: derived metrics, map of name (text) to float32 (omitted when none is valid)
+ *
+ * Only valid sensors are encoded. Keys are never reused; new fields get new
+ * keys and bump the version only when existing ones change meaning.
+ *
+ * A batch of samples is a CBOR array of such maps, one per sample.
+ */
+
+#ifndef TELEMETRY_CODEC_H
+#define TELEMETRY_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sensor_manager.h"
+#include "json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TELEMETRY_CBOR_SCHEMA_VERSION   1
+#define TELEMETRY_CBOR_MAX_SIZE         1024    // Enough for 16 sensors x 4 values
+#define TELEMETRY_PACKED_MAX_SIZE       512     // Packed snapshot, 16 sensors x 4 values
+
+/**
+ * @brief JSON field name of one value of a multi-value sensor
+ *
+ * @param sensor_type EZO type string
+ * @param index Value index
+ * @return Field name, or NULL if the type has no name for this value
+ */
+const char *telemetry_value_name(const char *sensor_type, uint8_t index);
+
+/**
+ * @brief Field names of a cached sensor's values, from its kind and channel map
+ *
+ * @param names Output, one entry per value (NULL for a value without a name)
+ * @return true if the sensor's kind names its values, false for unknown boards
+ */
+bool telemetry_sensor_names(const cached_sensor_t *sensor, const char *names[MAX_SENSOR_VALUES]);
+
+/**
+ * @brief Resolve kind and a default channel map from sensor_type (decoded snapshots)
+ */
+void telemetry_sensor_set_kind(cached_sensor_t *sensor);
+
+/**
+ * @brief Write one sensor as a key of the enclosing "sensors" object
+ *
+ * @param w Writer positioned inside an object
+ * @param sensor_type EZO type string (used as key)
+ * @param values Sensor values
+ * @param count Number of values
+ * @param names Optional per-value field names overriding the defaults (NULL entries are skipped)
+ */
+void telemetry_write_sensor_json(json_writer_t *w, const char *sensor_type,
+                                 const float *values, uint8_t count, const char *const *names);
+
+/**
+ * @brief As telemetry_write_sensor_json(), under a key other than the type
+ */
+void telemetry_write_keyed_sensor_json(json_writer_t *w, const char *key, const char *sensor_type,
+                                       const float *values, uint8_t count, const char *const *names);
+
+/**
+ * @brief JSON key of a sensor in a snapshot
+ *
+ * The first board of a type is keyed by the type ("pH"); later boards of
+ * the same type get an ordinal suffix ("pH_2", "pH_3") in registry order.
+ *
+ * @return key, or the type itself when it is the first of its kind
+ */
+const char *telemetry_sensor_key(const sensor_cache_t *cache, uint8_t index, char *key, size_t size);
+
+/**
+ * @brief Write the "sensors" object value for every valid sensor in a snapshot
+ *
+ * @param w Writer positioned where the object value goes (after a key)
+ * @param cache Snapshot to render
+ */
+void telemetry_write_sensors_json(json_writer_t *w, const sensor_cache_t *cache);
+
+/**
+ * @brief Write a "derived" key with the snapshot's valid derived metrics
+ *
+ * Nothing is written when no metric is valid.
+ *
+ * @param w Writer positioned inside an object
+ * @param cache Snapshot to render
+ */
+void telemetry_write_derived_json(json_writer_t *w, const sensor_cache_t *cache);
+
+/**
+ * @brief Encode a sensor snapshot as CBOR (schema TELEMETRY_CBOR_SCHEMA_VERSION)
+ *
+ * @param device_id Device identifier, or NULL to omit it when the topic names the device
+ * @param cache Snapshot to encode
+ * @param unix_time Acquisition time in Unix seconds, or 0 to omit it
+ * @param buf Output buffer
+ * @param buf_size Size of buf
+ * @param out_len Encoded length
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_SIZE if buf is too small
+ */
+esp_err_t telemetry_encode_cbor(const char *device_id, const sensor_cache_t *cache, uint32_t unix_time,
+                                uint8_t *buf, size_t buf_size, size_t *out_len);
+
+/**
+ * @brief Encode the header of a CBOR array (batch of snapshot maps)
+ *
+ * @param count Number of elements that follow
+ * @param buf Output buffer
+ * @param buf_size Size of buf
+ * @param out_len Encoded length
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_SIZE if buf is too small
+ */
+esp_err_t telemetry_encode_cbor_array(size_t count, uint8_t *buf, size_t buf_size, size_t *out_len);
+
+/**
+ * @brief Pack a snapshot into a compact little-endian record for storage
+ *
+ * Layout: version (u8), unix_time (u32), battery (f32, NaN when invalid),
+ * rssi (i8), sensor count (u8), then per valid sensor: type length (u8),
+ * type bytes, value count (u8), values (f32 each). A trailing derived
+ * section follows when any derived metric is valid: mask (u8), then one f32
+ * per set bit; records without it unpack with no derived metrics.
+ *
+ * @param cache Snapshot to pack
+ * @param unix_time Acquisition time in Unix seconds (0 if unknown)
+ * @param buf Output buffer
+ * @param buf_size Size of buf
+ * @param out_len Packed length
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_SIZE if buf is too small
+ */
+esp_err_t telemetry_pack_snapshot(const sensor_cache_t *cache, uint32_t unix_time,
+                                  uint8_t *buf, size_t buf_size, size_t *out_len);
+
+/**
+ * @brief Restore a snapshot packed with telemetry_pack_snapshot()
+ *
+ * @param buf Packed record
+ * @param len Record length
+ * @param cache Output snapshot (timestamp_us is left at 0)
+ * @param unix_time Acquisition time stored in the record
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_VERSION or ESP_ERR_INVALID_SIZE on a bad record
+ */
+esp_err_t telemetry_unpack_snapshot(const uint8_t *buf, size_t len, sensor_cache_t *cache, uint32_t *unix_time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_CODEC_H
@@ -0,0 +1,369 @@
+/**
+ * @file telemetry_log.c
+ * @brief Persistent store-and-forward log for telemetry on a flash partition
+ */
+
+#include "telemetry_log.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "TLOG";
+
+#define TLOG_SEGMENT_SIZE       4096        // Flash erase sector
+#define TLOG_MAX_SEGMENTS       64
+#define TLOG_SEGMENT_MAGIC      0x31474C54  // "TLG1"
+#define TLOG_RECORD_MAGIC       0x5A17
+#define TLOG_STATE_PENDING      0xFFFFFFFF
+#define TLOG_STATE_ACKED        0x00000000
+#define TLOG_ALIGN(x)           (((x) + 3u) & ~3u)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;               // Increases by one per opened segment
+} tlog_segment_hdr_t;
+
+typedef struct {
+    uint16_t magic;
+    uint16_t len;
+    uint32_t crc;               // CRC32 of the payload
+    uint32_t state;             // Cleared in place once delivered
+} tlog_record_hdr_t;
+
+static const esp_partition_t *s_partition = NULL;
+static SemaphoreHandle_t s_mutex = NULL;
+static uint32_t s_segment_count = 0;
+static uint32_t s_seg_seq[TLOG_MAX_SEGMENTS];       // 0 = erased/free
+static uint32_t s_head = 0;                         // Segment being appended to
+static uint32_t s_head_offset = 0;                  // Next write offset within the head segment
+static uint32_t s_tail = 0;                         // Oldest segment in use
+static uint32_t s_next_seq = 1;
+static uint32_t s_pending = 0;
+
+static uint32_t tlog_segment_base(uint32_t seg) {
+    return seg * TLOG_SEGMENT_SIZE;
+}
+
+static esp_err_t tlog_open_segment(uint32_t seg) {
+    esp_err_t ret = esp_partition_erase_range(s_partition, tlog_segment_base(seg), TLOG_SEGMENT_SIZE);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    tlog_segment_hdr_t hdr = {
+        .magic = TLOG_SEGMENT_MAGIC,
+        .seq = s_next_seq,
+    };
+    ret = esp_partition_write(s_partition, tlog_segment_base(seg), &hdr, sizeof(hdr));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    s_seg_seq[seg] = s_next_seq++;
+    s_head = seg;
+    s_head_offset = sizeof(tlog_segment_hdr_t);
+    return ESP_OK;
+}
+
+/**
+ * @brief Walk the records of a segment
+ *
+ * @param pending_out Pending records found
+ * @return Offset after the last well-formed record (append position)
+ */
+static uint32_t tlog_scan_segment(uint32_t seg, uint32_t *pending_out) {
+    uint32_t offset = sizeof(tlog_segment_hdr_t);
+    uint32_t pending = 0;
+
+    while (offset + sizeof(tlog_record_hdr_t) <= TLOG_SEGMENT_SIZE) {
+        tlog_record_hdr_t hdr;
+        if (esp_partition_read(s_partition, tlog_segment_base(seg) + offset, &hdr, sizeof(hdr)) != ESP_OK) {
+            break;
+        }
+        if (hdr.magic == 0xFFFF) {
+            break;      // Erased space: end of segment
+        }
+        if (hdr.magic != TLOG_RECORD_MAGIC || hdr.len > TELEMETRY_LOG_MAX_RECORD ||
+            offset + sizeof(hdr) + hdr.len > TLOG_SEGMENT_SIZE) {
+            // Torn header from a power cut: nothing after it can be trusted
+            offset = TLOG_SEGMENT_SIZE;
+            break;
+        }
+        if (hdr.state == TLOG_STATE_PENDING) {
+            pending++;
+        }
+        offset += TLOG_ALIGN(sizeof(hdr) + hdr.len);
+    }
+
+    if (pending_out != NULL) {
+        *pending_out = pending;
+    }
+    return offset;
+}
+
+static uint32_t tlog_next_segment(uint32_t seg) {
+    return (seg + 1) % s_segment_count;
+}
+
+// Erase the tail segment and advance to the next one in use
+static void tlog_drop_tail(void) {
+    uint32_t pending = 0;
+    tlog_scan_segment(s_tail, &pending);
+    if (pending > 0) {
+        ESP_LOGW(TAG, "Log full, discarding %lu undelivered record(s)", (unsigned long)pending);
+        s_pending -= (pending <= s_pending) ? pending : s_pending;
+    }
+
+    esp_partition_erase_range(s_partition, tlog_segment_base(s_tail), TLOG_SEGMENT_SIZE);
+    s_seg_seq[s_tail] = 0;
+    s_tail = tlog_next_segment(s_tail);
+}
+
+esp_err_t telemetry_log_init(void) {
+    if (s_partition != NULL) {
+        return ESP_OK;
+    }
+
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                                ESP_PARTITION_SUBTYPE_ANY,
+                                                                TELEMETRY_LOG_PARTITION_LABEL);
+    if (partition == NULL) {
+        ESP_LOGI(TAG, "No '%s' partition, store-and-forward disabled", TELEMETRY_LOG_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_partition = partition;
+    s_segment_count = partition->size / TLOG_SEGMENT_SIZE;
+    if (s_segment_count > TLOG_MAX_SEGMENTS) {
+        s_segment_count = TLOG_MAX_SEGMENTS;
+    }
+    if (s_segment_count < 2) {
+        ESP_LOGE(TAG, "Log partition too small (%lu bytes)", (unsigned long)partition->size);
+        s_partition = NULL;
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Recover segment order from the sequence numbers
+    uint32_t min_seq = UINT32_MAX;
+    uint32_t max_seq = 0;
+    for (uint32_t seg = 0; seg < s_segment_count; seg++) {
+        tlog_segment_hdr_t hdr;
+        s_seg_seq[seg] = 0;
+        if (esp_partition_read(s_partition, tlog_segment_base(seg), &hdr, sizeof(hdr)) == ESP_OK &&
+            hdr.magic == TLOG_SEGMENT_MAGIC && hdr.seq != 0 && hdr.seq != UINT32_MAX) {
+            s_seg_seq[seg] = hdr.seq;
+            if (hdr.seq < min_seq) {
+                min_seq = hdr.seq;
+                s_tail = seg;
+            }
+            if (hdr.seq > max_seq) {
+                max_seq = hdr.seq;
+                s_head = seg;
+            }
+        }
+    }
+
+    esp_err_t ret = ESP_OK;
+    s_pending = 0;
+    if (max_seq == 0) {
+        s_next_seq = 1;
+        ret = tlog_open_segment(0);
+        s_tail = 0;
+    } else {
+        s_next_seq = max_seq + 1;
+        for (uint32_t seg = 0; seg < s_segment_count; seg++) {
+            if (s_seg_seq[seg] != 0) {
+                uint32_t pending = 0;
+                uint32_t end = tlog_scan_segment(seg, &pending);
+                s_pending += pending;
+                if (seg == s_head) {
+                    s_head_offset = end;
+                }
+            }
+        }
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to format log partition: %s", esp_err_to_name(ret));
+        s_partition = NULL;
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "✓ Telemetry log: %lu segments, %lu record(s) pending",
+             (unsigned long)s_segment_count, (unsigned long)s_pending);
+    return ESP_OK;
+}
+
+bool telemetry_log_is_enabled(void) {
+    return s_partition != NULL;
+}
+
+esp_err_t telemetry_log_append(const void *data, size_t len) {
+    if (s_partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (data == NULL || len == 0 || len > TELEMETRY_LOG_MAX_RECORD) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t record[TLOG_ALIGN(sizeof(tlog_record_hdr_t) + TELEMETRY_LOG_MAX_RECORD)];
+    size_t record_len = TLOG_ALIGN(sizeof(tlog_record_hdr_t) + len);
+    memset(record, 0xFF, record_len);
+    tlog_record_hdr_t *hdr = (tlog_record_hdr_t *)record;
+    hdr->magic = TLOG_RECORD_MAGIC;
+    hdr->len = (uint16_t)len;
+    hdr->crc = esp_rom_crc32_le(0, (const uint8_t *)data, len);
+    hdr->state = TLOG_STATE_PENDING;
+    memcpy(record + sizeof(tlog_record_hdr_t), data, len);
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    esp_err_t ret = ESP_OK;
+    if (s_head_offset + record_len > TLOG_SEGMENT_SIZE) {
+        uint32_t next = tlog_next_segment(s_head);
+        if (next == s_tail && s_seg_seq[next] != 0) {
+            tlog_drop_tail();
+        }
+        ret = tlog_open_segment(next);
+    }
+
+    if (ret == ESP_OK) {
+        ret = esp_partition_write(s_partition, tlog_segment_base(s_head) + s_head_offset, record, record_len);
+        // Skip the slot even on failure; a torn record is detected by scan/CRC
+        s_head_offset += record_len;
+        if (ret == ESP_OK) {
+            s_pending++;
+        }
+    }
+
+    xSemaphoreGive(s_mutex);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to append record: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t telemetry_log_next(uint32_t *cursor, uint32_t *pos, void *buf, size_t size, size_t *len) {
+    if (s_partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (cursor == NULL || pos == NULL || buf == NULL || len == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    uint32_t seg;
+    uint32_t offset;
+    if (*cursor == TELEMETRY_LOG_CURSOR_START) {
+        seg = s_tail;
+        offset = sizeof(tlog_segment_hdr_t);
+    } else {
+        seg = *cursor / TLOG_SEGMENT_SIZE;
+        offset = *cursor % TLOG_SEGMENT_SIZE;
+        // The cursor's segment may have been reclaimed or overwritten meanwhile
+        if (seg >= s_segment_count || s_seg_seq[seg] == 0 ||
+            s_seg_seq[seg] < s_seg_seq[s_tail]) {
+            seg = s_tail;
+            offset = sizeof(tlog_segment_hdr_t);
+        }
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    while (s_seg_seq[seg] != 0) {
+        uint32_t end = (seg == s_head) ? s_head_offset : TLOG_SEGMENT_SIZE;
+        bool found = false;
+
+        while (offset + sizeof(tlog_record_hdr_t) <= end) {
+            tlog_record_hdr_t hdr;
+            uint32_t at = tlog_segment_base(seg) + offset;
+            if (esp_partition_read(s_partition, at, &hdr, sizeof(hdr)) != ESP_OK ||
+                hdr.magic != TLOG_RECORD_MAGIC || hdr.len > TELEMETRY_LOG_MAX_RECORD ||
+                offset + sizeof(hdr) + hdr.len > TLOG_SEGMENT_SIZE) {
+                break;
+            }
+            offset += TLOG_ALIGN(sizeof(hdr) + hdr.len);
+
+            if (hdr.state != TLOG_STATE_PENDING || hdr.len > size) {
+                continue;
+            }
+            if (esp_partition_read(s_partition, at + sizeof(hdr), buf, hdr.len) != ESP_OK ||
+                esp_rom_crc32_le(0, (const uint8_t *)buf, hdr.len) != hdr.crc) {
+                ESP_LOGW(TAG, "Skipping corrupt record at 0x%lx", (unsigned long)at);
+                continue;
+            }
+
+            *pos = at;
+            *len = hdr.len;
+            found = true;
+            break;
+        }
+
+        if (found) {
+            *cursor = tlog_segment_base(seg) + offset;
+            ret = ESP_OK;
+            break;
+        }
+        if (seg == s_head) {
+            *cursor = tlog_segment_base(seg) + offset;
+            break;
+        }
+        seg = tlog_next_segment(seg);
+        offset = sizeof(tlog_segment_hdr_t);
+    }
+
+    xSemaphoreGive(s_mutex);
+    return ret;
+}
+
+esp_err_t telemetry_log_ack(uint32_t pos) {
+    if (s_partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    uint32_t seg = pos / TLOG_SEGMENT_SIZE;
+    esp_err_t ret = ESP_ERR_INVALID_ARG;
+    tlog_record_hdr_t hdr;
+    if (seg < s_segment_count && s_seg_seq[seg] != 0 &&
+        esp_partition_read(s_partition, pos, &hdr, sizeof(hdr)) == ESP_OK &&
+        hdr.magic == TLOG_RECORD_MAGIC) {
+        ret = ESP_OK;
+        if (hdr.state == TLOG_STATE_PENDING) {
+            // Programming only clears bits, so the state word can be rewritten in place
+            uint32_t acked = TLOG_STATE_ACKED;
+            ret = esp_partition_write(s_partition, pos + offsetof(tlog_record_hdr_t, state),
+                                      &acked, sizeof(acked));
+            if (ret == ESP_OK && s_pending > 0) {
+                s_pending--;
+            }
+        }
+    }
+
+    // Reclaim fully delivered segments behind the head
+    while (ret == ESP_OK && s_tail != s_head) {
+        uint32_t pending = 0;
+        tlog_scan_segment(s_tail, &pending);
+        if (pending > 0) {
+            break;
+        }
+        esp_partition_erase_range(s_partition, tlog_segment_base(s_tail), TLOG_SEGMENT_SIZE);
+        s_seg_seq[s_tail] = 0;
+        s_tail = tlog_next_segment(s_tail);
+    }
+
+    xSemaphoreGive(s_mutex);
+    return ret;
+}
+
+uint32_t telemetry_log_pending_count(void) {
+    return s_pending;
+}
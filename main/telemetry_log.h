@@ -0,0 +1,79 @@
+/**
+ * @file telemetry_log.h
+ * @brief Persistent store-and-forward log for telemetry on a flash partition
+ *
+ * Records are appended to the "tlog" data partition, which is split into
+ * erase-sector sized segments used as a ring. Each record carries a length,
+ * a CRC32 and a state word; acknowledging a record clears its state word in
+ * place (no erase). A segment is erased only when every record in it has
+ * been acknowledged, or when the ring is full and the oldest segment has to
+ * make room. Segments are written round-robin, so erases spread evenly.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TELEMETRY_LOG_PARTITION_LABEL   "tlog"
+#define TELEMETRY_LOG_MAX_RECORD        512
+#define TELEMETRY_LOG_CURSOR_START      UINT32_MAX  // Iterate from the oldest record
+
+/**
+ * @brief Mount the log partition and recover the write position
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND without a "tlog" partition
+ */
+esp_err_t telemetry_log_init(void);
+
+/**
+ * @brief Check if the log is mounted
+ */
+bool telemetry_log_is_enabled(void);
+
+/**
+ * @brief Append one record
+ *
+ * When the ring is full the oldest segment is discarded, pending or not.
+ *
+ * @param data Record payload
+ * @param len Payload length (at most TELEMETRY_LOG_MAX_RECORD)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_log_append(const void *data, size_t len);
+
+/**
+ * @brief Read the next unacknowledged record after a cursor
+ *
+ * @param cursor In: position to continue from (TELEMETRY_LOG_CURSOR_START for
+ *               the oldest record). Out: position to pass on the next call.
+ * @param pos Position of the returned record, used to acknowledge it
+ * @param buf Output buffer
+ * @param size Size of buf
+ * @param len Payload length
+ * @return esp_err_t ESP_OK if a record was returned, ESP_ERR_NOT_FOUND at the end of the log
+ */
+esp_err_t telemetry_log_next(uint32_t *cursor, uint32_t *pos, void *buf, size_t size, size_t *len);
+
+/**
+ * @brief Mark a record as delivered; fully delivered segments are reclaimed
+ *
+ * @param pos Record position from telemetry_log_next()
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_log_ack(uint32_t pos);
+
+/**
+ * @brief Number of records not yet acknowledged
+ */
+uint32_t telemetry_log_pending_count(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,85 @@
+/**
+ * @file telemetry_publisher.c
+ * @brief Runtime choice of the telemetry transport
+ */
+
+#include "telemetry_publisher.h"
+#include "mqtt_telemetry.h"
+#include "thread_telemetry.h"
+#include "settings_store.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "TLM_PUB";
+
+static const char *const s_transport_names[TELEMETRY_TRANSPORT_COUNT] = {
+    [TELEMETRY_TRANSPORT_MQTT] = "mqtt",
+    [TELEMETRY_TRANSPORT_THREAD] = "thread",
+};
+
+static const telemetry_publisher_t s_publishers[TELEMETRY_TRANSPORT_COUNT] = {
+    [TELEMETRY_TRANSPORT_MQTT] = {
+        .name = "mqtt",
+        .is_connected = mqtt_client_is_connected,
+        .add_packed_sample = mqtt_add_packed_sample,
+        .flush = mqtt_flush,
+    },
+    [TELEMETRY_TRANSPORT_THREAD] = {
+        .name = "thread",
+        .is_connected = thread_telemetry_is_attached,
+        .add_packed_sample = thread_telemetry_add_packed_sample,
+        .flush = thread_telemetry_flush,
+    },
+};
+
+static bool telemetry_transport_built_in(telemetry_transport_t transport) {
+    switch (transport) {
+        case TELEMETRY_TRANSPORT_MQTT:
+            return true;
+        case TELEMETRY_TRANSPORT_THREAD:
+#ifdef CONFIG_KC_THREAD_TELEMETRY
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+telemetry_transport_t telemetry_publisher_transport(void) {
+    telemetry_transport_t transport = (telemetry_transport_t)settings_store_get_u32(SETTING_TELEMETRY_TRANSPORT);
+    return telemetry_transport_built_in(transport) ? transport : TELEMETRY_TRANSPORT_MQTT;
+}
+
+const telemetry_publisher_t *telemetry_publisher_get(void) {
+    return &s_publishers[telemetry_publisher_transport()];
+}
+
+esp_err_t telemetry_publisher_select(telemetry_transport_t transport) {
+    if (!telemetry_transport_built_in(transport)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    esp_err_t err = settings_store_set_u32(SETTING_TELEMETRY_TRANSPORT, transport);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Telemetry transport set to %s (next boot)", s_transport_names[transport]);
+    }
+    return err;
+}
+
+const char *telemetry_transport_to_string(telemetry_transport_t transport) {
+    return (transport < TELEMETRY_TRANSPORT_COUNT) ? s_transport_names[transport] : "unknown";
+}
+
+esp_err_t telemetry_transport_from_string(const char *name, telemetry_transport_t *transport) {
+    if (name == NULL || transport == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < TELEMETRY_TRANSPORT_COUNT; i++) {
+        if (strcmp(name, s_transport_names[i]) == 0) {
+            *transport = (telemetry_transport_t)i;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file telemetry_publisher.h
+ * @brief Runtime choice of the telemetry transport
+ *
+ * Sensor snapshots leave the device over one transport per boot: MQTT over
+ * TLS (Wi-Fi) or, on targets with an 802.15.4 radio and
+ * CONFIG_KC_THREAD_TELEMETRY, CoAP over Thread (thread_telemetry.h). The
+ * choice is the "tlm_transport" setting; it takes effect at the next boot.
+ *
+ * Both transports take the packed snapshot encoding
+ * (telemetry_pack_snapshot()), so code that drains stored samples (the
+ * low-power upload wake) goes through telemetry_publisher_get() and does not
+ * depend on the transport.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    TELEMETRY_TRANSPORT_MQTT = 0,
+    TELEMETRY_TRANSPORT_THREAD = 1,
+    TELEMETRY_TRANSPORT_COUNT
+} telemetry_transport_t;
+
+typedef struct {
+    const char *name;
+    /** @brief Whether samples can be sent now (broker session up, Thread attached) */
+    bool (*is_connected)(void);
+    /** @brief Queue a packed snapshot for the next flush */
+    esp_err_t (*add_packed_sample)(const uint8_t *record, size_t len);
+    /** @brief Send everything queued and wait for it to be acknowledged */
+    esp_err_t (*flush)(uint32_t timeout_ms);
+} telemetry_publisher_t;
+
+/**
+ * @brief Transport selected for this boot
+ *
+ * Falls back to MQTT when the saved choice is not built in.
+ */
+telemetry_transport_t telemetry_publisher_transport(void);
+
+/**
+ * @brief Publisher of the transport selected for this boot
+ */
+const telemetry_publisher_t *telemetry_publisher_get(void);
+
+/**
+ * @brief Save the transport for the next boot
+ *
+ * @param transport Transport
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_SUPPORTED if it is not built in
+ */
+esp_err_t telemetry_publisher_select(telemetry_transport_t transport);
+
+/**
+ * @brief Transport name ("mqtt", "thread")
+ */
+const char *telemetry_transport_to_string(telemetry_transport_t transport);
+
+/**
+ * @brief Parse a transport name
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for an unknown name
+ */
+esp_err_t telemetry_transport_from_string(const char *name, telemetry_transport_t *transport);
+
+#ifdef __cplusplus
+}
+#endif
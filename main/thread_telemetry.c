@@ -0,0 +1,424 @@
+/**
+ * @file thread_telemetry.c
+ * @brief Telemetry over Thread (802.15.4) as a sleepy end device
+ */
+
+#include "thread_telemetry.h"
+#include "esp_log.h"
+
+static const char *TAG = "THREAD_TLM";
+
+#ifdef CONFIG_KC_THREAD_TELEMETRY
+
+#include "sensor_manager.h"
+#include "telemetry_codec.h"
+#include "telemetry_publisher.h"
+#include "cloud_provisioning.h"
+#include "task_profile.h"
+#include "esp_openthread.h"
+#include "esp_openthread_lock.h"
+#include "esp_openthread_netif_glue.h"
+#include "esp_openthread_types.h"
+#include "esp_netif.h"
+#include "esp_event.h"
+#include "esp_vfs_eventfd.h"
+#include "esp_system.h"
+#include "openthread/coap.h"
+#include "openthread/dataset.h"
+#include "openthread/instance.h"
+#include "openthread/ip6.h"
+#include "openthread/link.h"
+#include "openthread/message.h"
+#include "openthread/thread.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define THREAD_TLM_URI_BASE         "kc/t"
+#define THREAD_TLM_URI_TRANSPORT    "kc/transport"
+#define THREAD_TLM_MIN_VALID_UNIX   1704067200  // 2024-01-01; older clock values are not a real time
+#define THREAD_TLM_RESTART_DELAY_MS 500         // Lets the response to /kc/transport go out
+
+#define THREAD_TLM_NOTIFY_CACHE     (1u << 0)
+#define THREAD_TLM_NOTIFY_RESTART   (1u << 1)
+
+static otInstance *s_instance = NULL;
+static esp_netif_t *s_netif = NULL;
+static TaskHandle_t s_ot_task = NULL;
+static TaskHandle_t s_publish_task = NULL;
+static TaskHandle_t s_starter = NULL;
+static bool s_listening = false;
+static otIp6Address s_peer;
+static char s_uri_path[64];
+static uint8_t s_record[TELEMETRY_PACKED_MAX_SIZE];  // Publish task only
+
+static atomic_bool s_attached = false;
+static atomic_uint s_pending = 0;
+static atomic_uint s_sent = 0;
+static atomic_uint s_acked = 0;
+static atomic_uint s_failed = 0;
+static atomic_uint s_dropped = 0;
+
+static void thread_telemetry_state_changed(otChangedFlags flags, void *ctx) {
+    (void)ctx;
+    if ((flags & OT_CHANGED_THREAD_ROLE) == 0) {
+        return;
+    }
+    otDeviceRole role = otThreadGetDeviceRole(s_instance);
+    bool attached = (role == OT_DEVICE_ROLE_CHILD || role == OT_DEVICE_ROLE_ROUTER ||
+                     role == OT_DEVICE_ROLE_LEADER);
+    if (atomic_exchange(&s_attached, attached) != attached) {
+        ESP_LOGI(TAG, "Thread role: %s", otThreadDeviceRoleToString(role));
+    }
+}
+
+static void thread_telemetry_response(void *ctx, otMessage *message, const otMessageInfo *info, otError result) {
+    (void)ctx;
+    (void)info;
+    if (result == OT_ERROR_NONE && message != NULL &&
+        (otCoapMessageGetCode(message) >> 5) == 2) {        // 2.xx
+        atomic_fetch_add(&s_acked, 1);
+    } else {
+        atomic_fetch_add(&s_failed, 1);
+        ESP_LOGD(TAG, "POST failed: %s", otThreadErrorToString(result));
+    }
+    atomic_fetch_sub(&s_pending, 1);
+}
+
+/**
+ * @brief PUT/POST /kc/transport from the collector: save the transport and restart
+ */
+static void thread_telemetry_transport_request(void *ctx, otMessage *message, const otMessageInfo *info) {
+    (void)ctx;
+    otCoapCode code = otCoapMessageGetCode(message);
+    otCoapCode reply = OT_COAP_CODE_BAD_REQUEST;
+    bool restart = false;
+
+    if (!otIp6IsAddressEqual(&info->mPeerAddr, &s_peer)) {
+        reply = OT_COAP_CODE_FORBIDDEN;
+    } else if (code != OT_COAP_CODE_PUT && code != OT_COAP_CODE_POST) {
+        reply = OT_COAP_CODE_METHOD_NOT_ALLOWED;
+    } else {
+        char name[16] = {0};
+        uint16_t len = otMessageRead(message, otMessageGetOffset(message), name, sizeof(name) - 1);
+        name[len] = '\0';
+        telemetry_transport_t transport;
+        if (telemetry_transport_from_string(name, &transport) == ESP_OK) {
+            esp_err_t err = telemetry_publisher_select(transport);
+            reply = (err == ESP_OK) ? OT_COAP_CODE_CHANGED : OT_COAP_CODE_NOT_IMPLEMENTED;
+            restart = (err == ESP_OK && transport != TELEMETRY_TRANSPORT_THREAD);
+        }
+    }
+
+    if (otCoapMessageGetType(message) == OT_COAP_TYPE_CONFIRMABLE) {
+        otMessage *response = otCoapNewMessage(s_instance, NULL);
+        if (response != NULL) {
+            otCoapMessageInitResponse(response, message, OT_COAP_TYPE_ACKNOWLEDGMENT, reply);
+            if (otCoapSendResponse(s_instance, response, info) != OT_ERROR_NONE) {
+                otMessageFree(response);
+            }
+        }
+    }
+    if (restart) {
+        ESP_LOGW(TAG, "Transport changed by the collector, restarting");
+        xTaskNotify(s_publish_task, THREAD_TLM_NOTIFY_RESTART, eSetBits);
+    }
+}
+
+static otCoapResource s_transport_resource = {
+    .mUriPath = THREAD_TLM_URI_TRANSPORT,
+    .mHandler = thread_telemetry_transport_request,
+    .mContext = NULL,
+    .mNext = NULL,
+};
+
+/**
+ * @brief Bring up OpenThread as a sleepy end device (caller holds the OpenThread lock)
+ */
+static esp_err_t thread_telemetry_configure(void) {
+    otLinkModeConfig mode = {
+        .mRxOnWhenIdle = false,
+        .mDeviceType = false,       // Minimal Thread device: never becomes a router
+        .mNetworkData = false,      // Stable network data only
+    };
+    if (otThreadSetLinkMode(s_instance, mode) != OT_ERROR_NONE ||
+        otLinkSetPollPeriod(s_instance, CONFIG_KC_THREAD_TELEMETRY_POLL_MS) != OT_ERROR_NONE) {
+        return ESP_FAIL;
+    }
+    if (otSetStateChangedCallback(s_instance, thread_telemetry_state_changed, NULL) != OT_ERROR_NONE ||
+        otCoapStart(s_instance, OT_DEFAULT_COAP_PORT) != OT_ERROR_NONE) {
+        return ESP_FAIL;
+    }
+    otCoapAddResource(s_instance, &s_transport_resource);
+
+    // The dataset comes from NVS after the first attach, else from the Kconfig network defaults
+    otOperationalDatasetTlvs dataset;
+    bool stored = (otDatasetGetActiveTlvs(s_instance, &dataset) == OT_ERROR_NONE);
+    return esp_openthread_auto_start(stored ? &dataset : NULL);
+}
+
+/**
+ * @brief Owns the OpenThread stack: init, report to thread_telemetry_start(), then run the mainloop
+ */
+static void thread_telemetry_ot_task(void *arg) {
+    (void)arg;
+    esp_openthread_platform_config_t config = {
+        .radio_config = { .radio_mode = RADIO_MODE_NATIVE },
+        .host_config = { .host_connection_mode = HOST_CONNECTION_MODE_NONE },
+        .port_config = { .storage_partition_name = "nvs", .netif_queue_size = 10, .task_queue_size = 10 },
+    };
+
+    esp_err_t err = esp_openthread_init(&config);
+    if (err == ESP_OK) {
+        esp_netif_config_t netif_config = ESP_NETIF_DEFAULT_OPENTHREAD();
+        s_netif = esp_netif_new(&netif_config);
+        err = (s_netif != NULL) ? esp_netif_attach(s_netif, esp_openthread_netif_glue_init(&config)) : ESP_ERR_NO_MEM;
+    }
+    if (err == ESP_OK) {
+        s_instance = esp_openthread_get_instance();
+        esp_openthread_lock_acquire(portMAX_DELAY);
+        err = thread_telemetry_configure();
+        esp_openthread_lock_release();
+    }
+
+    xTaskNotify(s_starter, (uint32_t)err, eSetValueWithOverwrite);
+    if (err != ESP_OK) {
+        s_instance = NULL;
+        s_ot_task = NULL;
+        vTaskDelete(NULL);
+        return;
+    }
+    esp_openthread_launch_mainloop();
+
+    // Only returns if the stack is torn down
+    ESP_LOGW(TAG, "OpenThread mainloop ended");
+    s_ot_task = NULL;
+    vTaskDelete(NULL);
+}
+
+static esp_err_t thread_telemetry_send(const uint8_t *record, size_t len) {
+    if (!atomic_load(&s_attached)) {
+        atomic_fetch_add(&s_dropped, 1);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (atomic_load(&s_pending) >= THREAD_TELEMETRY_MAX_PENDING) {
+        atomic_fetch_add(&s_dropped, 1);
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    otError error = OT_ERROR_NO_BUFS;
+    otMessage *message = otCoapNewMessage(s_instance, NULL);
+    if (message != NULL) {
+        otCoapMessageInit(message, OT_COAP_TYPE_CONFIRMABLE, OT_COAP_CODE_POST);
+        otCoapMessageGenerateToken(message, OT_COAP_DEFAULT_TOKEN_LENGTH);
+        error = otCoapMessageAppendUriPathOptions(message, s_uri_path);
+        if (error == OT_ERROR_NONE) {
+            error = otCoapMessageAppendContentFormatOption(message, OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM);
+        }
+        if (error == OT_ERROR_NONE) {
+            error = otCoapMessageSetPayloadMarker(message);
+        }
+        if (error == OT_ERROR_NONE) {
+            error = otMessageAppend(message, record, (uint16_t)len);
+        }
+        if (error == OT_ERROR_NONE) {
+            otMessageInfo info;
+            memset(&info, 0, sizeof(info));
+            info.mPeerAddr = s_peer;
+            info.mPeerPort = CONFIG_KC_THREAD_TELEMETRY_PORT;
+            // Counted first: the response handler runs in the mainloop, after this lock is released
+            atomic_fetch_add(&s_pending, 1);
+            error = otCoapSendRequest(s_instance, message, &info, thread_telemetry_response, NULL);
+            if (error != OT_ERROR_NONE) {
+                atomic_fetch_sub(&s_pending, 1);
+            }
+        }
+        if (error != OT_ERROR_NONE) {
+            otMessageFree(message);
+        }
+    }
+    esp_openthread_lock_release();
+
+    if (error != OT_ERROR_NONE) {
+        atomic_fetch_add(&s_dropped, 1);
+        ESP_LOGW(TAG, "POST not sent: %s", otThreadErrorToString(error));
+        return ESP_ERR_NO_MEM;
+    }
+    atomic_fetch_add(&s_sent, 1);
+    return ESP_OK;
+}
+
+static void thread_telemetry_cache_listener(const sensor_cache_t *cache, void *user_ctx) {
+    (void)cache;
+    (void)user_ctx;
+    xTaskNotify(s_publish_task, THREAD_TLM_NOTIFY_CACHE, eSetBits);
+}
+
+static void thread_telemetry_publish_task(void *arg) {
+    (void)arg;
+    while (1) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+
+        if (bits & THREAD_TLM_NOTIFY_RESTART) {
+            vTaskDelay(pdMS_TO_TICKS(THREAD_TLM_RESTART_DELAY_MS));
+            esp_restart();
+        }
+        if ((bits & THREAD_TLM_NOTIFY_CACHE) == 0) {
+            continue;
+        }
+
+        sensor_cache_t cache;
+        if (sensor_manager_get_cached_data(&cache) != ESP_OK) {
+            continue;
+        }
+        time_t now = time(NULL);
+        uint32_t unix_time = (now >= THREAD_TLM_MIN_VALID_UNIX) ? (uint32_t)now : 0;
+        size_t len = 0;
+        if (telemetry_pack_snapshot(&cache, unix_time, s_record, sizeof(s_record), &len) == ESP_OK) {
+            thread_telemetry_send(s_record, len);
+        }
+    }
+}
+
+esp_err_t thread_telemetry_start(void) {
+    if (s_instance == NULL) {
+        if (otIp6AddressFromString(CONFIG_KC_THREAD_TELEMETRY_PEER, &s_peer) != OT_ERROR_NONE) {
+            ESP_LOGE(TAG, "Bad collector address: %s", CONFIG_KC_THREAD_TELEMETRY_PEER);
+            return ESP_ERR_INVALID_ARG;
+        }
+        char device_id[32] = {0};
+        if (cloud_prov_get_device_id(device_id, sizeof(device_id)) != ESP_OK) {
+            snprintf(device_id, sizeof(device_id), "unknown");
+        }
+        snprintf(s_uri_path, sizeof(s_uri_path), THREAD_TLM_URI_BASE "/%s", device_id);
+
+        // Already done by Wi-Fi on cold boots, not on Thread upload wakes
+        esp_err_t err = esp_netif_init();
+        if (err == ESP_OK) {
+            err = esp_event_loop_create_default();
+        }
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+            return err;
+        }
+
+        // OpenThread's task queue and radio wake the mainloop through eventfds
+        esp_vfs_eventfd_config_t eventfd_config = { .max_fds = 3 };
+        err = esp_vfs_eventfd_register(&eventfd_config);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+            return err;
+        }
+
+        // Before the stack: the /kc/transport handler signals this task
+        if (s_publish_task == NULL &&
+            task_profile_create(TASK_PROFILE_THREAD_TLM, thread_telemetry_publish_task, NULL, NULL,
+                                &s_publish_task) != pdPASS) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        s_starter = xTaskGetCurrentTaskHandle();
+        xTaskNotifyStateClear(NULL);
+        if (task_profile_create(TASK_PROFILE_OT_MAIN, thread_telemetry_ot_task, NULL, NULL, &s_ot_task) != pdPASS) {
+            return ESP_ERR_NO_MEM;
+        }
+        uint32_t result = ESP_ERR_TIMEOUT;
+        if (xTaskNotifyWait(0, UINT32_MAX, &result, pdMS_TO_TICKS(10000)) != pdTRUE) {
+            ESP_LOGE(TAG, "OpenThread init did not finish");
+            return ESP_ERR_TIMEOUT;
+        }
+        if ((esp_err_t)result != ESP_OK) {
+            ESP_LOGE(TAG, "OpenThread init failed: %s", esp_err_to_name((esp_err_t)result));
+            return (esp_err_t)result;
+        }
+    }
+
+    if (!s_listening) {
+        esp_err_t err = sensor_manager_register_cache_listener(thread_telemetry_cache_listener, NULL);
+        if (err != ESP_OK) {
+            return err;
+        }
+        s_listening = true;
+        ESP_LOGI(TAG, "Publishing to [%s]:%d/%s, poll period %d ms", CONFIG_KC_THREAD_TELEMETRY_PEER,
+                 CONFIG_KC_THREAD_TELEMETRY_PORT, s_uri_path, CONFIG_KC_THREAD_TELEMETRY_POLL_MS);
+    }
+
+    for (int waited = 0; !atomic_load(&s_attached); waited += 100) {
+        if (waited >= THREAD_TELEMETRY_ATTACH_MS) {
+            ESP_LOGW(TAG, "Not attached after %d ms, still trying", THREAD_TELEMETRY_ATTACH_MS);
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    return ESP_OK;
+}
+
+bool thread_telemetry_is_attached(void) {
+    return atomic_load(&s_attached);
+}
+
+esp_err_t thread_telemetry_add_packed_sample(const uint8_t *record, size_t len) {
+    if (record == NULL || len == 0 || len > TELEMETRY_PACKED_MAX_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_instance == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return thread_telemetry_send(record, len);
+}
+
+esp_err_t thread_telemetry_flush(uint32_t timeout_ms) {
+    for (uint32_t waited = 0; atomic_load(&s_pending) > 0; waited += 50) {
+        if (waited >= timeout_ms) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    return ESP_OK;
+}
+
+esp_err_t thread_telemetry_get_stats(thread_telemetry_stats_t *stats) {
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    stats->sent = atomic_load(&s_sent);
+    stats->acked = atomic_load(&s_acked);
+    stats->failed = atomic_load(&s_failed);
+    stats->dropped = atomic_load(&s_dropped);
+    stats->pending = (uint8_t)atomic_load(&s_pending);
+    stats->attached = atomic_load(&s_attached);
+    return ESP_OK;
+}
+
+#else
+// Built without OpenThread: MQTT is the only transport
+
+esp_err_t thread_telemetry_start(void) {
+    ESP_LOGW(TAG, "Thread telemetry not built in (CONFIG_KC_THREAD_TELEMETRY)");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+bool thread_telemetry_is_attached(void) {
+    return false;
+}
+
+esp_err_t thread_telemetry_add_packed_sample(const uint8_t *record, size_t len) {
+    (void)record;
+    (void)len;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t thread_telemetry_flush(uint32_t timeout_ms) {
+    (void)timeout_ms;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t thread_telemetry_get_stats(thread_telemetry_stats_t *stats) {
+    (void)stats;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_KC_THREAD_TELEMETRY
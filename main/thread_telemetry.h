@@ -0,0 +1,91 @@
+/**
+ * @file thread_telemetry.h
+ * @brief Telemetry over Thread (802.15.4) as a sleepy end device
+ *
+ * With CONFIG_KC_THREAD_TELEMETRY and "tlm_transport" set to "thread", the
+ * device joins the Thread network held in the OpenThread dataset (stored in
+ * NVS, or built from the CONFIG_OPENTHREAD_NETWORK_* defaults on first use)
+ * as a sleepy end device: the receiver stays off and the parent is polled
+ * every CONFIG_KC_THREAD_TELEMETRY_POLL_MS. That costs a fraction of keeping
+ * Wi-Fi associated and a TLS session to the broker open.
+ *
+ * Every new sensor cache is packed (telemetry_pack_snapshot()) and sent as
+ * a confirmable CoAP POST to the collector behind the border router:
+ *
+ *   coap://[CONFIG_KC_THREAD_TELEMETRY_PEER]:CONFIG_KC_THREAD_TELEMETRY_PORT/kc/t/<device id>
+ *   Content-Format: application/octet-stream, payload: one packed snapshot
+ *
+ * The collector can switch the device back with a CoAP PUT of "mqtt" (or
+ * "thread") to /kc/transport on the device; the device saves the choice and
+ * restarts. Only requests from the collector's address are accepted; the
+ * Thread network key already authenticates every frame on the mesh.
+ *
+ * Without CONFIG_KC_THREAD_TELEMETRY the functions return
+ * ESP_ERR_NOT_SUPPORTED.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define THREAD_TELEMETRY_MAX_PENDING    8       // Unacknowledged POSTs in flight
+#define THREAD_TELEMETRY_ATTACH_MS      30000   // Wait for the parent in thread_telemetry_start()
+
+typedef struct {
+    uint32_t sent;              // POSTs handed to the stack
+    uint32_t acked;             // 2.xx responses
+    uint32_t failed;            // Error responses and timeouts
+    uint32_t dropped;           // Not sent: detached, too many pending, or no buffers
+    uint8_t pending;
+    bool attached;
+} thread_telemetry_stats_t;
+
+/**
+ * @brief Start OpenThread, attach as a sleepy end device and publish every new cache (idempotent)
+ *
+ * Waits up to THREAD_TELEMETRY_ATTACH_MS for the parent; the stack keeps trying
+ * after a timeout.
+ *
+ * @return esp_err_t ESP_OK once attached, ESP_ERR_TIMEOUT if still detached,
+ *         ESP_ERR_INVALID_ARG for a bad collector address, or the OpenThread init error
+ */
+esp_err_t thread_telemetry_start(void);
+
+/**
+ * @brief Whether the device is attached to a Thread parent
+ */
+bool thread_telemetry_is_attached(void);
+
+/**
+ * @brief Send a packed snapshot taken earlier (e.g. kept across deep sleep)
+ *
+ * @param record Packed snapshot
+ * @param len Record length
+ * @return esp_err_t ESP_OK once handed to the stack, ESP_ERR_INVALID_STATE while detached,
+ *         ESP_ERR_NO_MEM with THREAD_TELEMETRY_MAX_PENDING in flight or no message buffers
+ */
+esp_err_t thread_telemetry_add_packed_sample(const uint8_t *record, size_t len);
+
+/**
+ * @brief Wait until every POST is acknowledged or has failed
+ *
+ * @param timeout_ms Maximum wait
+ * @return esp_err_t ESP_OK when none is pending, ESP_ERR_TIMEOUT otherwise
+ */
+esp_err_t thread_telemetry_flush(uint32_t timeout_ms);
+
+/**
+ * @brief Copy the publish counters
+ */
+esp_err_t thread_telemetry_get_stats(thread_telemetry_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
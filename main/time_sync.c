@@ -4,8 +4,12 @@
  */
 
 #include "time_sync.h"
+#include "boot_profile.h"
 #include "esp_log.h"
 #include "esp_sntp.h"
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "nvs.h"
 #include <string.h>
 #include <sys/time.h>
 
@@ -16,9 +20,164 @@ static const char *TAG = "TIME_SYNC";
 #define NTP_SERVER_SECONDARY "time.nist.gov"
 #define NTP_SERVER_TERTIARY  "time.google.com"
 
+// Retained clock
+#define CLOCK_RTC_MAGIC         0x434C4B31  // "CLK1"
+#define CLOCK_NVS_NAMESPACE     "time_sync"
+#define CLOCK_NVS_KEY           "clock"
+#define CLOCK_NVS_SAVE_SEC      (6 * 3600)  // At most one flash write per this many seconds
+#define CLOCK_DRIFT_MIN_SPAN_SEC 60         // Shorter gaps say nothing useful about drift
+#define CLOCK_DRIFT_MAX_PPM     50000       // RC slow clock across deep sleep is a few percent at worst
+
+typedef struct {
+    int64_t anchor_unix_us;     // Wall time the clock was last known good
+    int32_t drift_ppm;          // RTC error while the main clock was off, positive = RTC fast
+    uint32_t check;
+} clock_record_t;
+
+// Not initialized on reset, so it carries over esp_restart(), panics and deep sleep
+static RTC_NOINIT_ATTR clock_record_t s_rtc_clock;
+static RTC_NOINIT_ATTR uint32_t s_rtc_clock_magic;
+
 // Time sync state
 static bool s_time_synced = false;
+static time_sync_source_t s_time_source = TIME_SOURCE_NONE;
 static time_sync_callback_t s_sync_callback = NULL;
+static int32_t s_drift_ppm = 0;
+static int64_t s_restore_span_sec = 0;      // How long the RTC alone carried the clock
+static int64_t s_nvs_saved_unix = 0;
+
+static uint32_t clock_record_check(const clock_record_t *record)
+{
+    uint32_t check = CLOCK_RTC_MAGIC;
+    check ^= (uint32_t)record->anchor_unix_us;
+    check ^= (uint32_t)(record->anchor_unix_us >> 32) * 31;
+    check ^= (uint32_t)record->drift_ppm * 131;
+    return check;
+}
+
+static int64_t clock_now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static void clock_set_us(int64_t unix_us)
+{
+    struct timeval tv = {
+        .tv_sec = (time_t)(unix_us / 1000000LL),
+        .tv_usec = (suseconds_t)(unix_us % 1000000LL),
+    };
+    settimeofday(&tv, NULL);
+}
+
+static void clock_save(int64_t anchor_unix_us)
+{
+    s_rtc_clock.anchor_unix_us = anchor_unix_us;
+    s_rtc_clock.drift_ppm = s_drift_ppm;
+    s_rtc_clock.check = clock_record_check(&s_rtc_clock);
+    s_rtc_clock_magic = CLOCK_RTC_MAGIC;
+    
+    // NVS only has to bound the clock after a power loss; it need not be fresh
+    int64_t anchor_sec = anchor_unix_us / 1000000LL;
+    if (s_nvs_saved_unix != 0 && anchor_sec - s_nvs_saved_unix < CLOCK_NVS_SAVE_SEC) {
+        return;
+    }
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(CLOCK_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(nvs_handle, CLOCK_NVS_KEY, &s_rtc_clock, sizeof(s_rtc_clock));
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs_handle);
+        }
+        nvs_close(nvs_handle);
+    }
+    if (err == ESP_OK) {
+        s_nvs_saved_unix = anchor_sec;
+    } else {
+        ESP_LOGW(TAG, "Failed to save clock to NVS: %s", esp_err_to_name(err));
+    }
+}
+
+/**
+ * @brief Bring the clock back before SNTP answers
+ *
+ * After a warm reset or deep sleep the system time kept running on the RTC, so
+ * only its drift since the last good time needs correcting. After a power loss
+ * the last saved time is a lower bound: good enough for certificate validity,
+ * not for sample timestamps.
+ */
+static void clock_restore(void)
+{
+    esp_reset_reason_t reason = esp_reset_reason();
+    bool warm = (reason != ESP_RST_POWERON && reason != ESP_RST_BROWNOUT && reason != ESP_RST_UNKNOWN);
+    int64_t now_us = clock_now_us();
+    
+    if (warm && s_rtc_clock_magic == CLOCK_RTC_MAGIC &&
+        s_rtc_clock.check == clock_record_check(&s_rtc_clock) &&
+        now_us >= s_rtc_clock.anchor_unix_us) {
+        s_drift_ppm = s_rtc_clock.drift_ppm;
+        int64_t span_us = now_us - s_rtc_clock.anchor_unix_us;
+        // A fast RTC (positive ppm) has run ahead; pull it back
+        int64_t correction_us = -(span_us / 1000000LL) * s_drift_ppm;
+        clock_set_us(now_us + correction_us);
+        s_restore_span_sec = span_us / 1000000LL;
+        s_time_source = TIME_SOURCE_RTC;
+        s_time_synced = true;
+        boot_profile_mark(BOOT_MARK_TIME_SYNCED);
+        clock_save(now_us + correction_us);
+        ESP_LOGI(TAG, "Clock restored from RTC (%lld s since last good time, %ld ppm, %+lld ms)",
+                 (long long)s_restore_span_sec, (long)s_drift_ppm, (long long)(correction_us / 1000));
+        return;
+    }
+    
+    memset(&s_rtc_clock, 0, sizeof(s_rtc_clock));
+    s_rtc_clock_magic = 0;
+    
+    clock_record_t record;
+    size_t size = sizeof(record);
+    nvs_handle_t nvs_handle;
+    if (nvs_open(CLOCK_NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    esp_err_t err = nvs_get_blob(nvs_handle, CLOCK_NVS_KEY, &record, &size);
+    nvs_close(nvs_handle);
+    if (err != ESP_OK || size != sizeof(record) || record.check != clock_record_check(&record)) {
+        return;
+    }
+    
+    s_drift_ppm = record.drift_ppm;
+    s_nvs_saved_unix = record.anchor_unix_us / 1000000LL;
+    if (now_us < record.anchor_unix_us) {
+        clock_set_us(record.anchor_unix_us);
+        s_time_source = TIME_SOURCE_NVS;
+        ESP_LOGI(TAG, "Clock set to last saved time (power loss, approximate until SNTP)");
+    }
+}
+
+/**
+ * @brief Refine the drift estimate from the first SNTP answer after an RTC restore
+ *
+ * @param error_us SNTP time minus our clock
+ */
+static void clock_update_drift(int64_t error_us)
+{
+    if (s_restore_span_sec < CLOCK_DRIFT_MIN_SPAN_SEC) {
+        return;
+    }
+    // The RTC was slow by error_us over the span, beyond the correction already applied
+    int32_t residual_ppm = (int32_t)(-error_us / s_restore_span_sec);
+    int32_t drift = s_drift_ppm + residual_ppm / 4;
+    if (drift > CLOCK_DRIFT_MAX_PPM) {
+        drift = CLOCK_DRIFT_MAX_PPM;
+    } else if (drift < -CLOCK_DRIFT_MAX_PPM) {
+        drift = -CLOCK_DRIFT_MAX_PPM;
+    }
+    ESP_LOGI(TAG, "RTC drift estimate %ld -> %ld ppm (%+lld ms over %lld s)",
+             (long)s_drift_ppm, (long)drift, (long long)(error_us / 1000), (long long)s_restore_span_sec);
+    s_drift_ppm = drift;
+    s_restore_span_sec = 0;
+}
 
 /**
  * @brief Callback invoked when SNTP sync occurs
@@ -32,8 +191,18 @@ static void time_sync_notification_cb(struct timeval *tv)
     char strftime_buf[64];
     strftime(strftime_buf, sizeof(strftime_buf), "%Y-%m-%d %H:%M:%S", &timeinfo);
     
-    ESP_LOGI(TAG, "✓ Time synchronized: %s", strftime_buf);
+    // In smooth mode the clock is still being slewed, so this is the error we had
+    int64_t sntp_us = (int64_t)tv->tv_sec * 1000000LL + tv->tv_usec;
+    int64_t error_us = sntp_us - clock_now_us();
+    if (s_time_source == TIME_SOURCE_RTC) {
+        clock_update_drift(error_us);
+    }
+    
+    ESP_LOGI(TAG, "✓ Time synchronized: %s (%+lld ms)", strftime_buf, (long long)(error_us / 1000));
     s_time_synced = true;
+    s_time_source = TIME_SOURCE_SNTP;
+    clock_save(sntp_us);
+    boot_profile_mark(BOOT_MARK_TIME_SYNCED);
     
     // Call user callback if registered
     if (s_sync_callback != NULL) {
@@ -58,8 +227,13 @@ esp_err_t time_sync_init(const char *timezone, time_sync_callback_t callback)
     }
     tzset();
     
+    clock_restore();
+    
     // Initialize SNTP
     esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
+    // A restored RTC clock is only off by drift: slew it so timestamps stay monotonic.
+    // Without one, step to the right time at once.
+    sntp_set_sync_mode(s_time_source == TIME_SOURCE_RTC ? SNTP_SYNC_MODE_SMOOTH : SNTP_SYNC_MODE_IMMED);
     
     // Set primary NTP server
     esp_sntp_setservername(0, NTP_SERVER_PRIMARY);
@@ -89,6 +263,11 @@ bool time_sync_is_synced(void)
     return s_time_synced;
 }
 
+time_sync_source_t time_sync_get_source(void)
+{
+    return s_time_source;
+}
+
 esp_err_t time_sync_get_time_string(char *buffer, size_t buffer_size, const char *format)
 {
     if (buffer == NULL || buffer_size == 0) {
@@ -137,5 +316,6 @@ void time_sync_deinit(void)
     ESP_LOGI(TAG, "Stopping SNTP service");
     esp_sntp_stop();
     s_time_synced = false;
+    s_time_source = TIME_SOURCE_NONE;
     s_sync_callback = NULL;
 }
@@ -4,6 +4,11 @@
  * 
  * Provides automatic time synchronization using SNTP (Simple Network Time Protocol).
  * Synchronizes system time with NTP servers after WiFi connection.
+ *
+ * The last good time and a measured RTC drift are kept in RTC memory and NVS.
+ * After a warm reset or deep sleep, time_sync_init() restores a drift-corrected
+ * clock at once and SNTP only slews it; after a power loss the last saved time
+ * is set as a lower bound until SNTP answers.
  */
 
 #ifndef TIME_SYNC_H
@@ -17,6 +22,13 @@
 extern "C" {
 #endif
 
+typedef enum {
+    TIME_SOURCE_NONE,       // Clock not set
+    TIME_SOURCE_NVS,        // Last saved time after a power loss: a lower bound only
+    TIME_SOURCE_RTC,        // Carried over a warm reset or deep sleep, drift-corrected
+    TIME_SOURCE_SNTP,       // Synchronized this boot
+} time_sync_source_t;
+
 /**
  * @brief Time sync status callback
  * 
@@ -28,7 +40,8 @@ typedef void (*time_sync_callback_t)(bool synced, struct tm *current_time);
 /**
  * @brief Initialize NTP time synchronization
  * 
- * Sets up SNTP client with default NTP servers and starts automatic synchronization.
+ * Restores the retained clock, then sets up SNTP client with default NTP servers
+ * and starts automatic synchronization.
  * Should be called after WiFi connection is established.
  * 
  * @param timezone Timezone string (e.g., "EST5EDT,M3.2.0/2,M11.1.0" for US Eastern)
@@ -41,10 +54,15 @@ esp_err_t time_sync_init(const char *timezone, time_sync_callback_t callback);
 /**
  * @brief Check if system time has been synchronized
  * 
- * @return true if time is synced, false otherwise
+ * @return true if time is synced or was restored from RTC, false otherwise
  */
 bool time_sync_is_synced(void);
 
+/**
+ * @brief Where the current system time came from
+ */
+time_sync_source_t time_sync_get_source(void);
+
 /**
  * @brief Get current time as string
  * 
@@ -0,0 +1,341 @@
+/**
+ * @file trace_log.c
+ * @brief Binary in-RAM trace of hot-path events
+ */
+
+#include "trace_log.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <stdio.h>
+
+static const char *TAG = "TRACE";
+
+#define TRACE_MAGIC 0x54524331  // "TRC1"
+
+typedef enum {
+    TRACE_ARG_NONE,
+    TRACE_ARG_U32,
+    TRACE_ARG_I32,
+    TRACE_ARG_HEX,
+    TRACE_ARG_FLOAT,
+    TRACE_ARG_STR8,             // This argument and the next one: 8 packed characters
+} trace_arg_kind_t;
+
+typedef struct {
+    const char *name;
+    const char *arg_names[3];
+    uint8_t kinds[3];
+} trace_event_desc_t;
+
+static const trace_event_desc_t k_events[TRACE_EV_COUNT] = {
+    [TRACE_EV_EZO_CMD]      = { "ezo_cmd", { "addr", "cmd", NULL },
+                                { TRACE_ARG_HEX, TRACE_ARG_STR8, TRACE_ARG_NONE } },
+    [TRACE_EV_EZO_READ]     = { "ezo_read", { "addr", "count", "value" },
+                                { TRACE_ARG_HEX, TRACE_ARG_U32, TRACE_ARG_FLOAT } },
+    [TRACE_EV_EZO_READY]    = { "ezo_ready", { "addr", "wait_ms", NULL },
+                                { TRACE_ARG_HEX, TRACE_ARG_U32, TRACE_ARG_NONE } },
+    [TRACE_EV_SENSOR_CYCLE] = { "sensor_cycle", { "valid", "total", "processed" },
+                                { TRACE_ARG_U32, TRACE_ARG_U32, TRACE_ARG_U32 } },
+    [TRACE_EV_MQTT_PUBLISH] = { "mqtt_publish", { "payload", "bytes", "msg_id" },
+                                { TRACE_ARG_U32, TRACE_ARG_U32, TRACE_ARG_I32 } },
+    [TRACE_EV_I2C_RECOVERY] = { "i2c_recovery", { "bus", "result", "ms" },
+                                { TRACE_ARG_U32, TRACE_ARG_HEX, TRACE_ARG_U32 } },
+};
+
+typedef struct {
+    _Atomic uint32_t seq;       // Global order; 0 while the slot is being written
+    uint32_t ts_us;             // esp_timer_get_time(), low 32 bits
+    uint16_t id;
+    uint8_t core;
+    uint8_t reserved;
+    uint32_t args[3];
+} trace_record_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t capacity;
+    _Atomic uint32_t seq;
+    _Atomic uint32_t head[portNUM_PROCESSORS];
+} trace_header_t;
+
+#if CONFIG_SPIRAM_ALLOW_NOINIT_SEG_EXTERNAL_MEMORY
+// Survives esp_restart() and panics, so the last events before a crash can be read
+static EXT_RAM_NOINIT_ATTR trace_header_t s_header_storage;
+static EXT_RAM_NOINIT_ATTR trace_record_t s_ring_storage[portNUM_PROCESSORS][TRACE_RING_RECORDS];
+#endif
+
+static trace_header_t *s_header = NULL;
+static trace_record_t *s_rings = NULL;      // portNUM_PROCESSORS rings of s_header->capacity
+
+static inline trace_record_t *ring_slot(int core, uint32_t index)
+{
+    return &s_rings[(size_t)core * s_header->capacity + (index % s_header->capacity)];
+}
+
+/**
+ * @brief Copy a record if it is complete and still the one at this index
+ */
+static bool read_record(int core, uint32_t index, trace_record_t *out)
+{
+    trace_record_t *slot = ring_slot(core, index);
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if (seq == 0) {
+        return false;
+    }
+    out->ts_us = slot->ts_us;
+    out->id = slot->id;
+    out->core = slot->core;
+    memcpy(out->args, slot->args, sizeof(out->args));
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq || out->id >= TRACE_EV_COUNT) {
+        return false;
+    }
+    atomic_store_explicit(&out->seq, seq, memory_order_relaxed);
+    return true;
+}
+
+void trace_log_emit(trace_event_t id, uint32_t a0, uint32_t a1, uint32_t a2)
+{
+    if (s_header == NULL || id >= TRACE_EV_COUNT) {
+        return;
+    }
+
+    // The task may migrate after this; the head is atomic, so that only costs locality
+    int core = (int)xPortGetCoreID();
+    uint32_t seq = atomic_fetch_add_explicit(&s_header->seq, 1, memory_order_relaxed) + 1;
+    if (seq == 0) {
+        seq = 1;    // 0 marks a slot in progress
+    }
+    uint32_t index = atomic_fetch_add_explicit(&s_header->head[core], 1, memory_order_relaxed);
+
+    trace_record_t *slot = ring_slot(core, index);
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->ts_us = (uint32_t)esp_timer_get_time();
+    slot->id = (uint16_t)id;
+    slot->core = (uint8_t)core;
+    slot->args[0] = a0;
+    slot->args[1] = a1;
+    slot->args[2] = a2;
+    atomic_store_explicit(&slot->seq, seq, memory_order_release);
+}
+
+static void decode_str8(const trace_record_t *rec, int arg, char text[9])
+{
+    memset(text, 0, 9);
+    memcpy(text, &rec->args[arg], 4);
+    if (arg < 2) {
+        memcpy(text + 4, &rec->args[arg + 1], 4);
+    }
+}
+
+/**
+ * @brief Render one record's arguments as "name=value" pairs
+ */
+static void format_args(const trace_record_t *rec, char *buf, size_t size)
+{
+    const trace_event_desc_t *desc = &k_events[rec->id];
+    size_t len = 0;
+    buf[0] = '\0';
+    for (int i = 0; i < 3 && len < size; i++) {
+        if (desc->kinds[i] == TRACE_ARG_NONE) {
+            continue;
+        }
+        const char *sep = (len > 0) ? " " : "";
+        int n = 0;
+        switch (desc->kinds[i]) {
+            case TRACE_ARG_U32:
+                n = snprintf(buf + len, size - len, "%s%s=%lu", sep, desc->arg_names[i], (unsigned long)rec->args[i]);
+                break;
+            case TRACE_ARG_I32:
+                n = snprintf(buf + len, size - len, "%s%s=%ld", sep, desc->arg_names[i], (long)(int32_t)rec->args[i]);
+                break;
+            case TRACE_ARG_HEX:
+                n = snprintf(buf + len, size - len, "%s%s=0x%02lX", sep, desc->arg_names[i], (unsigned long)rec->args[i]);
+                break;
+            case TRACE_ARG_FLOAT: {
+                float value;
+                memcpy(&value, &rec->args[i], sizeof(value));
+                n = snprintf(buf + len, size - len, "%s%s=%.3f", sep, desc->arg_names[i], value);
+                break;
+            }
+            case TRACE_ARG_STR8: {
+                char text[9];
+                decode_str8(rec, i, text);
+                n = snprintf(buf + len, size - len, "%s%s=%s", sep, desc->arg_names[i], text);
+                i++;
+                break;
+            }
+            default:
+                break;
+        }
+        if (n > 0) {
+            len += (size_t)n;
+        }
+    }
+}
+
+/**
+ * @brief Visit retained records oldest first, merging the per-core rings by sequence
+ *
+ * @param limit Newest records to visit (0 for all)
+ */
+static void for_each_record(size_t limit, void (*fn)(const trace_record_t *rec, void *ctx), void *ctx)
+{
+    uint32_t next[portNUM_PROCESSORS];
+    uint32_t end[portNUM_PROCESSORS];
+    size_t retained = 0;
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        end[c] = atomic_load_explicit(&s_header->head[c], memory_order_acquire);
+        next[c] = (end[c] > s_header->capacity) ? end[c] - s_header->capacity : 0;
+        retained += end[c] - next[c];
+    }
+
+    size_t skip = (limit > 0 && retained > limit) ? retained - limit : 0;
+    trace_record_t pending[portNUM_PROCESSORS];
+    bool have[portNUM_PROCESSORS] = {0};
+    while (true) {
+        int best = -1;
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            // Slots overwritten since the snapshot are skipped, not shown out of order
+            while (!have[c] && next[c] < end[c]) {
+                have[c] = read_record(c, next[c]++, &pending[c]);
+            }
+            if (have[c] && (best < 0 || pending[c].seq < pending[best].seq)) {
+                best = c;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        have[best] = false;
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        fn(&pending[best], ctx);
+    }
+}
+
+static void log_record(const trace_record_t *rec, void *ctx)
+{
+    (void)ctx;
+    char args[96];
+    format_args(rec, args, sizeof(args));
+    ESP_LOGW(TAG, "  #%lu %10lu us core%u %s %s", (unsigned long)rec->seq, (unsigned long)rec->ts_us,
+             rec->core, k_events[rec->id].name, args);
+}
+
+esp_err_t trace_log_init(void)
+{
+    if (s_header != NULL) {
+        return ESP_OK;
+    }
+
+#if CONFIG_SPIRAM_ALLOW_NOINIT_SEG_EXTERNAL_MEMORY
+    s_header = &s_header_storage;
+    s_rings = &s_ring_storage[0][0];
+
+    esp_reset_reason_t reason = esp_reset_reason();
+    bool crashed = (reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT ||
+                    reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT);
+    if (crashed && s_header->magic == TRACE_MAGIC && s_header->capacity == TRACE_RING_RECORDS) {
+        ESP_LOGW(TAG, "Last %d trace events before the %s reset:", TRACE_CRASH_DUMP_RECORDS,
+                 reason == ESP_RST_PANIC ? "panic" : "watchdog");
+        for_each_record(TRACE_CRASH_DUMP_RECORDS, log_record, NULL);
+    }
+    memset(s_rings, 0, sizeof(s_ring_storage));
+    memset(s_header, 0, sizeof(*s_header));
+    s_header->capacity = TRACE_RING_RECORDS;
+#else
+    size_t capacity = TRACE_RING_RECORDS_INTERNAL;
+    trace_header_t *header = heap_caps_calloc(1, sizeof(trace_header_t), MALLOC_CAP_8BIT);
+    trace_record_t *rings = heap_caps_calloc((size_t)portNUM_PROCESSORS * capacity, sizeof(trace_record_t),
+                                             MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (rings == NULL) {
+        rings = heap_caps_calloc((size_t)portNUM_PROCESSORS * capacity, sizeof(trace_record_t), MALLOC_CAP_8BIT);
+    }
+    if (header == NULL || rings == NULL) {
+        heap_caps_free(header);
+        heap_caps_free(rings);
+        return ESP_ERR_NO_MEM;
+    }
+    header->capacity = capacity;
+    s_rings = rings;
+    s_header = header;
+#endif
+    s_header->magic = TRACE_MAGIC;
+    ESP_LOGI(TAG, "Trace rings: %d x %lu records", portNUM_PROCESSORS, (unsigned long)s_header->capacity);
+    return ESP_OK;
+}
+
+typedef struct {
+    json_writer_t *w;
+    uint32_t now_us;
+} trace_json_ctx_t;
+
+static void write_record_json(const trace_record_t *rec, void *arg)
+{
+    trace_json_ctx_t *ctx = (trace_json_ctx_t *)arg;
+    json_writer_t *w = ctx->w;
+    const trace_event_desc_t *desc = &k_events[rec->id];
+
+    json_writer_object_begin(w);
+    json_writer_kv_int(w, "seq", rec->seq);
+    // Age rather than an absolute time: the 32-bit timestamp wraps every 71 minutes
+    json_writer_kv_int(w, "age_us", (uint32_t)(ctx->now_us - rec->ts_us));
+    json_writer_kv_int(w, "core", rec->core);
+    json_writer_kv_string(w, "event", desc->name);
+    for (int i = 0; i < 3; i++) {
+        switch (desc->kinds[i]) {
+            case TRACE_ARG_U32:
+            case TRACE_ARG_HEX:
+                json_writer_kv_int(w, desc->arg_names[i], rec->args[i]);
+                break;
+            case TRACE_ARG_I32:
+                json_writer_kv_int(w, desc->arg_names[i], (int32_t)rec->args[i]);
+                break;
+            case TRACE_ARG_FLOAT: {
+                float value;
+                memcpy(&value, &rec->args[i], sizeof(value));
+                json_writer_kv_float(w, desc->arg_names[i], value);
+                break;
+            }
+            case TRACE_ARG_STR8: {
+                char text[9];
+                decode_str8(rec, i, text);
+                json_writer_kv_string(w, desc->arg_names[i], text);
+                i++;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    json_writer_object_end(w);
+}
+
+void trace_log_write_json(json_writer_t *w, size_t limit)
+{
+    json_writer_object_begin(w);
+    if (s_header == NULL) {
+        json_writer_kv_bool(w, "enabled", false);
+        json_writer_object_end(w);
+        return;
+    }
+    json_writer_kv_bool(w, "enabled", true);
+    json_writer_kv_int(w, "capacity_per_core", s_header->capacity);
+    json_writer_kv_int(w, "total", atomic_load_explicit(&s_header->seq, memory_order_relaxed));
+    json_writer_key(w, "events");
+    json_writer_array_begin(w);
+    trace_json_ctx_t ctx = { .w = w, .now_us = (uint32_t)esp_timer_get_time() };
+    for_each_record(limit, write_record_json, &ctx);
+    json_writer_array_end(w);
+    json_writer_object_end(w);
+}
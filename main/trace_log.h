@@ -0,0 +1,81 @@
+/**
+ * @file trace_log.h
+ * @brief Binary in-RAM trace of hot-path events
+ *
+ * Hot paths (EZO commands, reading cycles, MQTT publishes) record a fixed-size
+ * event (id plus three 32-bit arguments) instead of formatting a log line. A
+ * record costs two atomic increments and a 24-byte store into a per-core ring,
+ * with no lock, no printf and no UART, so tracing can stay on in production.
+ * Records are only turned into text when they are read: by GET /api/trace, or
+ * at the next boot after a crash (the rings live in PSRAM that is not cleared
+ * by a software reset).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "esp_err.h"
+#include "json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRACE_RING_RECORDS          1024    // Per core, in PSRAM
+#define TRACE_RING_RECORDS_INTERNAL 128     // Per core, without PSRAM
+#define TRACE_CRASH_DUMP_RECORDS    32      // Logged after a panic or watchdog reset
+
+typedef enum {
+    TRACE_EV_EZO_CMD,           // addr, command (8 chars)
+    TRACE_EV_EZO_READ,          // addr, value count, first value
+    TRACE_EV_EZO_READY,         // addr, conversion wait in ms
+    TRACE_EV_SENSOR_CYCLE,      // valid sensors, total sensors, sensors processed
+    TRACE_EV_MQTT_PUBLISH,      // payload (0 json, 1 cbor, 2 batch), bytes, msg_id
+    TRACE_EV_I2C_RECOVERY,      // bus, result (esp_err_t), duration in ms
+    TRACE_EV_COUNT
+} trace_event_t;
+
+/**
+ * @brief Set up the rings; logs the tail of the previous boot's trace after a crash
+ */
+esp_err_t trace_log_init(void);
+
+/**
+ * @brief Record an event (any task, any core; not from ISRs)
+ *
+ * Dropped silently before trace_log_init().
+ */
+void trace_log_emit(trace_event_t id, uint32_t a0, uint32_t a1, uint32_t a2);
+
+static inline uint32_t trace_arg_float(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/**
+ * @brief Pack up to 4 characters of s, starting at offset, into an argument
+ */
+static inline uint32_t trace_arg_str4(const char *s, size_t offset)
+{
+    uint32_t packed = 0;
+    size_t len = strlen(s);
+    for (size_t i = 0; i < 4 && offset + i < len; i++) {
+        packed |= (uint32_t)(uint8_t)s[offset + i] << (8 * i);
+    }
+    return packed;
+}
+
+/**
+ * @brief Write the newest records, oldest first, as a JSON object
+ *
+ * @param limit Maximum records (0 for all retained)
+ */
+void trace_log_write_json(json_writer_t *w, size_t limit);
+
+#ifdef __cplusplus
+}
+#endif
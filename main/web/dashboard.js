@@ -13,8 +13,11 @@ const SENSOR_WS_PATH='/ws/sensors';
 let sensorSocket=null;
 let sensorSocketReady=false;
 let sensorSocketReconnectTimer=null;
+let binarySensorState=null;
+let binarySensorSeq=-1;
+let binaryResyncPending=false;
 let focusUsingWebSocket=false;
-function displaySensorValues(sensors){const container=document.getElementById('sensor-values');if(!sensors||Object.keys(sensors).length===0){container.innerHTML='<div class="text-gray-500 dark:text-gray-400">No sensor data available</div>';return;}let html='';const nowLabel=new Date().toLocaleTimeString();for(const type in sensors){const value=sensors[type];const cleanType=(type||'').trim();const typeKey=cleanType.toUpperCase();const cfg=sensorConfig[cleanType]||sensorConfig[typeKey]||{icon:'📊',label:cleanType||typeKey,unit:'',color:'text-gray-500'};latestSensorSnapshots[typeKey]={rawType:cleanType||typeKey,value,config:cfg,timestamp:nowLabel};recordSensorHistory(typeKey,value,nowLabel);if(activeModalType===typeKey){refreshSensorModalContent(typeKey);}if(typeof value==='object'&&!Array.isArray(value)){for(const field in value){const fieldLabel=field.replace('_',' ').replace(/\b\w/g,l=>l.toUpperCase());const fieldValue=typeof value[field]==='number'?value[field].toFixed(2):value[field];html+=`<div class='bg-white dark:bg-gray-700 p-4 rounded-lg border border-gray-200 dark:border-gray-600 cursor-pointer transition hover:border-green-400' onclick='openSensorModal("${typeKey}")'>`;html+=`<div class='flex items-center justify-between mb-2'>`;html+=`<span class='text-2xl'>${cfg.icon}</span>`;html+=`<span class='text-xs text-gray-500 dark:text-gray-400'>${cleanType}</span>`;html+=`</div>`;html+=`<div class='text-sm text-gray-600 dark:text-gray-300 mb-1'>${fieldLabel}</div>`;html+=`<div class='text-2xl font-bold ${cfg.color}'>${fieldValue}</div>`;html+=`</div>`;}}else if(typeof value==='number'){html+=`<div class='bg-white dark:bg-gray-700 p-4 rounded-lg border border-gray-200 dark:border-gray-600 cursor-pointer transition hover:border-green-400' onclick='openSensorModal("${typeKey}")'>`;html+=`<div class='flex items-center justify-between mb-2'>`;html+=`<span class='text-2xl'>${cfg.icon}</span>`;html+=`<span class='text-xs text-gray-500 dark:text-gray-400'>${cleanType}</span>`;html+=`</div>`;html+=`<div class='text-sm text-gray-600 dark:text-gray-300 mb-1'>${cfg.label}</div>`;html+=`<div class='text-2xl font-bold ${cfg.color}'>${value.toFixed(2)} ${cfg.unit}</div>`;html+=`</div>`;}}container.innerHTML=html;}
+function displaySensorValues(sensors){const container=document.getElementById('sensor-values');if(!sensors||Object.keys(sensors).length===0){container.innerHTML='<div class="text-gray-500 dark:text-gray-400">No sensor data available</div>';return;}let html='';const nowLabel=new Date().toLocaleTimeString();for(const type in sensors){const value=sensors[type];const cleanType=(type||'').trim();const typeKey=cleanType.toUpperCase();const baseType=cleanType.replace(/_\d+$/,'');const cfg=sensorConfig[cleanType]||sensorConfig[typeKey]||sensorConfig[baseType]||sensorConfig[baseType.toUpperCase()]||{icon:'📊',label:cleanType||typeKey,unit:'',color:'text-gray-500'};latestSensorSnapshots[typeKey]={rawType:cleanType||typeKey,value,config:cfg,timestamp:nowLabel};recordSensorHistory(typeKey,value,nowLabel);if(activeModalType===typeKey){refreshSensorModalContent(typeKey);}if(typeof value==='object'&&!Array.isArray(value)){for(const field in value){const fieldLabel=field.replace('_',' ').replace(/\b\w/g,l=>l.toUpperCase());const fieldValue=typeof value[field]==='number'?value[field].toFixed(2):value[field];html+=`<div class='bg-white dark:bg-gray-700 p-4 rounded-lg border border-gray-200 dark:border-gray-600 cursor-pointer transition hover:border-green-400' onclick='openSensorModal("${typeKey}")'>`;html+=`<div class='flex items-center justify-between mb-2'>`;html+=`<span class='text-2xl'>${cfg.icon}</span>`;html+=`<span class='text-xs text-gray-500 dark:text-gray-400'>${cleanType}</span>`;html+=`</div>`;html+=`<div class='text-sm text-gray-600 dark:text-gray-300 mb-1'>${fieldLabel}</div>`;html+=`<div class='text-2xl font-bold ${cfg.color}'>${fieldValue}</div>`;html+=`</div>`;}}else if(typeof value==='number'){html+=`<div class='bg-white dark:bg-gray-700 p-4 rounded-lg border border-gray-200 dark:border-gray-600 cursor-pointer transition hover:border-green-400' onclick='openSensorModal("${typeKey}")'>`;html+=`<div class='flex items-center justify-between mb-2'>`;html+=`<span class='text-2xl'>${cfg.icon}</span>`;html+=`<span class='text-xs text-gray-500 dark:text-gray-400'>${cleanType}</span>`;html+=`</div>`;html+=`<div class='text-sm text-gray-600 dark:text-gray-300 mb-1'>${cfg.label}</div>`;html+=`<div class='text-2xl font-bold ${cfg.color}'>${value.toFixed(2)} ${cfg.unit}</div>`;html+=`</div>`;}}container.innerHTML=html;}
 
 function openSensorModal(typeKey){activeModalType=typeKey;const modal=document.getElementById('sensorModal');if(!modal){return;}refreshSensorModalContent(typeKey);const detailList=sensorDetailCache[typeKey]||[];const sensorDetails=detailList.find(sensor=>((sensor.type||'').trim().toUpperCase())===typeKey)||detailList[0];if(sensorDetails){startSensorFocus(sensorDetails).catch(err=>console.warn('Failed to enter focus mode',err));}modal.classList.remove('hidden');}
 
@@ -26,13 +29,22 @@ function recordSensorHistory(typeKey,sample,timestamp){if(!typeKey||sample==null
 
 function formatHistoryValue(sample){if(typeof sample==='number'){return sample.toFixed(2);}if(Array.isArray(sample)){return sample.map(val=>typeof val==='number'?val.toFixed(2):val).join(', ');}if(sample&&typeof sample==='object'){return Object.keys(sample).map(key=>{const val=sample[key];return `${key}: ${typeof val==='number'?val.toFixed(2):val}`;}).join(', ');}return sample??'—';}
 
-function initSensorSocket(){const scheme=window.location.protocol==='https:'?'wss':'ws';try{sensorSocket=new WebSocket(`${scheme}://${window.location.host}${SENSOR_WS_PATH}`);}catch(err){console.warn('Failed to open sensor socket',err);scheduleSensorSocketReconnect();return;}sensorSocket.addEventListener('open',async()=>{sensorSocketReady=true;if(sensorSocketReconnectTimer){clearTimeout(sensorSocketReconnectTimer);sensorSocketReconnectTimer=null;}await stopHttpFocusFallback();sendSensorSocketMessage({action:'request_snapshot'});if(focusModeActive&&focusSensorAddress!=null){focusUsingWebSocket=true;sendFocusCommand('focus_start',focusSensorAddress);}});sensorSocket.addEventListener('message',handleSensorSocketMessage);sensorSocket.addEventListener('close',()=>{sensorSocketReady=false;sensorSocket=null;if(focusModeActive&&focusSensorAddress!=null){focusUsingWebSocket=false;startHttpFocusFallback(focusSensorAddress);}scheduleSensorSocketReconnect();});sensorSocket.addEventListener('error',()=>{sensorSocket?.close();});}
+function initSensorSocket(){const scheme=window.location.protocol==='https:'?'wss':'ws';try{sensorSocket=new WebSocket(`${scheme}://${window.location.host}${SENSOR_WS_PATH}`);}catch(err){console.warn('Failed to open sensor socket',err);scheduleSensorSocketReconnect();return;}sensorSocket.binaryType='arraybuffer';binarySensorState=null;binaryResyncPending=false;sensorSocket.addEventListener('open',async()=>{sensorSocketReady=true;if(sensorSocketReconnectTimer){clearTimeout(sensorSocketReconnectTimer);sensorSocketReconnectTimer=null;}await stopHttpFocusFallback();sendSensorSocketMessage({action:'set_protocol',protocol:'binary'});if(focusModeActive&&focusSensorAddress!=null){focusUsingWebSocket=true;sendFocusCommand('focus_start',focusSensorAddress);}});sensorSocket.addEventListener('message',handleSensorSocketMessage);sensorSocket.addEventListener('close',()=>{sensorSocketReady=false;sensorSocket=null;if(focusModeActive&&focusSensorAddress!=null){focusUsingWebSocket=false;startHttpFocusFallback(focusSensorAddress);}scheduleSensorSocketReconnect();});sensorSocket.addEventListener('error',()=>{sensorSocket?.close();});}
 
 function scheduleSensorSocketReconnect(){if(sensorSocketReconnectTimer){return;}sensorSocketReconnectTimer=setTimeout(()=>{sensorSocketReconnectTimer=null;initSensorSocket();},3000);}
 
 function sendSensorSocketMessage(payload){if(!sensorSocketReady||!sensorSocket)return;try{sensorSocket.send(JSON.stringify(payload));}catch(err){console.warn('Sensor socket send failed',err);}}
 
-function handleSensorSocketMessage(event){let message=null;try{message=JSON.parse(event.data);}catch(err){console.warn('Invalid WS payload',err);return;}if(message?.type==='status_snapshot'&&message.sensors){displaySensorValues(message.sensors);if(typeof message.rssi==='number'){const rssiEl=document.getElementById('wifi-rssi');if(rssiEl)rssiEl.textContent=`${message.rssi} dBm`;}}else if(message?.type==='focus_sample'){ingestFocusedSample(message);}else if(message?.type==='focus_status'){if(message.status==='stopped'){focusUsingWebSocket=false;}}}
+const activeAlarms=new Map();
+function handleAlarmEvent(alarm){const key=`${alarm.rule}:${alarm.address??0}`;if(alarm.state==='tripped'){activeAlarms.set(key,alarm);}else{activeAlarms.delete(key);}renderAlarmBanner();}
+function renderAlarmBanner(){const banner=document.getElementById('alarm-banner');if(!banner)return;banner.replaceChildren();if(activeAlarms.size===0){banner.classList.add('hidden');return;}const fmt=v=>typeof v==='number'?Number(v.toFixed(3)):v;for(const a of activeAlarms.values()){const channel=a.field||`${a.sensor}[${a.index}]`;const board=a.address?` (0x${a.address.toString(16).toUpperCase()})`:'';const limit=a.kind==='rate'?`changing ${fmt(a.value)}/min, limit ${fmt(a.threshold)}/min`:`${fmt(a.value)}, ${a.kind} ${fmt(a.threshold)}`;const row=document.createElement('div');row.textContent=`⚠️ ${a.sensor}${board} ${channel}: ${limit}`;banner.appendChild(row);}banner.classList.remove('hidden');}
+function handleSensorSocketMessage(event){if(event.data instanceof ArrayBuffer){handleBinarySensorFrame(event.data);return;}let message=null;try{message=JSON.parse(event.data);}catch(err){console.warn('Invalid WS payload',err);return;}if(message?.type==='status_snapshot'&&message.sensors){displaySensorValues(message.sensors);if(typeof message.rssi==='number'){const rssiEl=document.getElementById('wifi-rssi');if(rssiEl)rssiEl.textContent=`${message.rssi} dBm`;}}else if(message?.type==='focus_sample'){ingestFocusedSample(message);}else if(message?.type==='job'){settleSensorJob(message.job);}else if(message?.type==='alarm'){handleAlarmEvent(message);}else if(message?.type==='calibration_status'){CalibrationWizard.onCalibrationStatus(message);}else if(message?.type==='focus_status'){if(message.status==='stopped'){focusUsingWebSocket=false;}}else if(message?.type==='device_status'){applyDeviceStatus(message);}else if(message?.type==='protocol'){binarySensorState=null;binaryResyncPending=message.protocol==='binary';}}
+
+function readBinarySensorRecord(view,bytes,pos){const decoder=new TextDecoder();const typeLen=view.getUint8(pos++);const type=decoder.decode(bytes.subarray(pos,pos+typeLen));pos+=typeLen;const count=view.getUint8(pos++);const names=[];const values=[];for(let j=0;j<count;j++){const nameLen=view.getUint8(pos++);names.push(nameLen?decoder.decode(bytes.subarray(pos,pos+nameLen)):null);pos+=nameLen;values.push(view.getFloat32(pos,true));pos+=4;}return{record:{type,names,values},pos};}
+
+function binarySensorReading(record){if(record.values.length===1)return record.values[0];const reading={};record.values.forEach((value,j)=>{if(record.names[j])reading[record.names[j]]=value;});return reading;}
+
+function handleBinarySensorFrame(buffer){const view=new DataView(buffer);const bytes=new Uint8Array(buffer);if(bytes.length<12)return;const kind=view.getUint8(0);const flags=view.getUint8(1);const seq=view.getUint16(2,true);const timestampMs=Number(view.getBigUint64(4,true));let pos=12;try{if(kind===1){const rssi=view.getInt8(pos);pos+=5;const entries=view.getUint8(pos++);if(flags&1){binarySensorState={};const decoder=new TextDecoder();for(let i=0;i<entries;i++){const slot=view.getUint8(pos++);const keyLen=view.getUint8(pos++);const key=decoder.decode(bytes.subarray(pos,pos+keyLen));pos+=keyLen;const parsed=readBinarySensorRecord(view,bytes,pos);pos=parsed.pos;binarySensorState[slot]={...parsed.record,key:key||parsed.record.type};}binaryResyncPending=false;}else{if(!binarySensorState||seq!==((binarySensorSeq+1)&0xffff)){if(!binaryResyncPending){binaryResyncPending=true;binarySensorState=null;sendSensorSocketMessage({action:'request_snapshot'});}return;}for(let i=0;i<entries;i++){const channel=view.getUint8(pos);const value=view.getFloat32(pos+1,true);pos+=5;const record=binarySensorState[channel>>2];if(record&&(channel&3)<record.values.length)record.values[channel&3]=value;}}binarySensorSeq=seq;const sensors={};Object.values(binarySensorState).forEach(record=>{sensors[record.key]=binarySensorReading(record);});displaySensorValues(sensors);const rssiEl=document.getElementById('wifi-rssi');if(rssiEl)rssiEl.textContent=`${rssi} dBm`;}else if(kind===2){const address=view.getUint8(pos++);const parsed=readBinarySensorRecord(view,bytes,pos);const record=parsed.record;const typeKey=(record.type||'').trim().toUpperCase();const previous=(sensorDetailCache[typeKey]||[]).find(item=>item?.address===address)||{};ingestFocusedSample({type:'focus_sample',sensor:{...previous,address,type:record.type,timestamp_ms:timestampMs,value_count:record.values.length,raw:record.values,reading:binarySensorReading(record)}});}}catch(err){console.warn('Invalid binary WS frame',err);}}
 
 function sendFocusCommand(action,address){if(!action)return;const payload={action};if(typeof address==='number')payload.address=address;sendSensorSocketMessage(payload);}
 
@@ -65,7 +77,7 @@ async function loadStatus(){try{const res=await fetch('/api/status');if(!res.ok)
 async function testMQTT(){alert('Testing MQTT connection...');try{await fetch('/api/test-mqtt',{method:'POST'});alert('MQTT test complete');}catch(e){alert('Test failed');}}
 async function rebootDevice(){if(!confirm('Reboot device now?'))return;await fetch('/api/reboot',{method:'POST'});alert('Device rebooting...');setTimeout(()=>location.reload(),10000);}
 async function clearWiFi(){if(!confirm('Clear WiFi and reset device?'))return;await fetch('/api/clear-wifi',{method:'POST'});alert('WiFi cleared. Restarting...');setTimeout(()=>location.reload(),10000);}
-async function uploadFirmware(){const input=document.getElementById('firmwareFile');const status=document.getElementById('firmwareStatus');if(!input){alert('Uploader not available');return;}if(!input.files||input.files.length===0){alert('Select a firmware .bin file first.');return;}const file=input.files[0];if(!file.name.toLowerCase().endsWith('.bin')){if(!confirm('File does not have a .bin extension. Upload anyway?'))return;}if(!confirm(`Upload ${file.name}? The device will reboot when the transfer completes.`))return;status.textContent='Uploading firmware...';try{const res=await fetch('/api/firmware/upload',{method:'POST',headers:{'Content-Type':'application/octet-stream'},body:file});const payload=await res.text();if(!res.ok)throw new Error(payload||'Upload failed');let message='Firmware uploaded. Device rebooting...';try{const data=JSON.parse(payload);if(data.status)message=`Firmware ${data.status}. Device rebooting...`; }catch(e){}status.textContent=message;alert(message);setTimeout(()=>location.reload(),15000);}catch(err){console.error('Firmware upload failed',err);status.textContent=`Upload failed: ${err.message}`;alert(`Firmware upload failed: ${err.message}`);}}
+async function uploadFirmware(){const input=document.getElementById('firmwareFile');const status=document.getElementById('firmwareStatus');if(!input){alert('Uploader not available');return;}if(!input.files||input.files.length===0){alert('Select a firmware .bin file first.');return;}const file=input.files[0];if(!/\.bin(\.gz)?$/.test(file.name.toLowerCase())){if(!confirm('File does not have a .bin or .bin.gz extension. Upload anyway?'))return;}if(!confirm(`Upload ${file.name}? The device will reboot when the transfer completes.`))return;status.textContent='Uploading firmware...';try{const res=await fetch('/api/firmware/upload',{method:'POST',headers:{'Content-Type':'application/octet-stream'},body:file});const payload=await res.text();if(!res.ok)throw new Error(payload||'Upload failed');let message='Firmware uploaded. Device rebooting...';try{const data=JSON.parse(payload);if(data.status)message=`Firmware ${data.status}. Device rebooting...`; }catch(e){}status.textContent=message;alert(message);setTimeout(()=>location.reload(),15000);}catch(err){console.error('Firmware upload failed',err);status.textContent=`Upload failed: ${err.message}`;alert(`Firmware upload failed: ${err.message}`);}}
 async function saveSetting(){const interval=document.getElementById('mqtt-interval').value;await fetch('/api/settings',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify({mqtt_interval:parseInt(interval)})});alert('Settings saved!');}
 async function loadSensors(){try{const res=await fetch('/api/sensors',{signal:AbortSignal.timeout(10000)});if(!res.ok)throw new Error('Failed to load sensors');const d=await res.json();updateSensorDetailCache(Array.isArray(d.sensors)?d.sensors:[]);const list=document.getElementById('sensor-list');if(!list)return;if(!d.count){list.innerHTML='<p class="text-gray-600 dark:text-gray-400">No sensors detected</p>';return;}list.innerHTML=d.sensors.map(renderSensorCard).join('');}catch(e){console.error('Failed to load sensors:',e);const list=document.getElementById('sensor-list');if(list)list.innerHTML=`<p class='text-red-500'>Failed to load sensors: ${e.message}</p>`;}}
 
@@ -92,11 +104,15 @@ function renderPhTempCompSection(sensor){const tempValue=Number.isFinite(sensor.
 function renderModeSection(sensor){const active=!!sensor.continuous_mode;return `<div class='mt-4 border border-gray-200 dark:border-gray-600 rounded-lg p-3'><div class='flex items-center justify-between mb-2'><div><h4 class='text-sm font-semibold text-gray-900 dark:text-white'>Measurement Mode</h4><p class='text-xs text-gray-500 dark:text-gray-300'>Currently ${active?'Continuous stream (C command)':'Single-shot (R command)'}</p></div><div class='flex gap-2'><button class='px-3 py-1.5 text-xs rounded-md ${active?'bg-gray-400 text-white cursor-not-allowed':'bg-green-600 text-white'}' ${active?'disabled':''} onclick='setSensorMode(${sensor.address},true)'>Continuous</button><button class='px-3 py-1.5 text-xs rounded-md ${!active?'bg-gray-400 text-white cursor-not-allowed':'bg-gray-200 dark:bg-gray-700 dark:text-white'}' ${!active?'disabled':''} onclick='setSensorMode(${sensor.address},false)'>Single</button></div></div></div>`;}
 
 function renderSleepSection(sensor){const sleeping=!!sensor.sleeping;return `<div class='mt-4 border border-gray-200 dark:border-gray-600 rounded-lg p-3 bg-yellow-50 dark:bg-yellow-900/40'><div class='flex items-center justify-between'><div><h4 class='text-sm font-semibold text-gray-900 dark:text-white'>Power State</h4><p class='text-xs text-gray-600 dark:text-gray-300'>${sleeping?'Sensor is in Sleep mode':'Sensor is awake'}</p></div><div class='flex gap-2'><button class='px-3 py-1.5 text-xs rounded-md bg-yellow-600 text-white ${sleeping?'cursor-not-allowed opacity-70':''}' ${sleeping?'disabled':''} onclick='setSensorSleep(${sensor.address},true)'>Sleep</button><button class='px-3 py-1.5 text-xs rounded-md bg-green-600 text-white ${sleeping?'':'cursor-not-allowed opacity-70'}' ${sleeping?'':'disabled'} onclick='setSensorSleep(${sensor.address},false)'>Wake</button></div></div></div>`;}
-async function rescanSensors(){alert('Rescanning I2C bus...');await fetch('/api/sensors/rescan',{method:'POST'});await loadSensors();alert('Rescan complete!');}
+const pendingSensorJobs=new Map();const finishedSensorJobs=new Map();
+function settleSensorJob(job){if(!job||job.state==='queued'||job.state==='running')return false;const entry=pendingSensorJobs.get(job.id);if(!entry){finishedSensorJobs.set(job.id,job);if(finishedSensorJobs.size>16)finishedSensorJobs.delete(finishedSensorJobs.keys().next().value);return false;}pendingSensorJobs.delete(job.id);clearTimeout(entry.timer);if(job.state==='succeeded')entry.resolve(job);else entry.reject(new Error(job.error||'Sensor action failed'));return true;}
+function waitForSensorJob(jobId,timeoutMs=60000){return new Promise((resolve,reject)=>{const entry={resolve,reject,timer:null};pendingSensorJobs.set(jobId,entry);const early=finishedSensorJobs.get(jobId);if(early){finishedSensorJobs.delete(jobId);settleSensorJob(early);return;}const deadline=Date.now()+timeoutMs;const poll=async()=>{if(!pendingSensorJobs.has(jobId))return;if(Date.now()>deadline){pendingSensorJobs.delete(jobId);reject(new Error('Timed out waiting for the sensor'));return;}try{const res=await fetch(`/api/jobs/${jobId}`,{signal:AbortSignal.timeout(5000)});if(res.ok&&settleSensorJob(await res.json()))return;}catch(err){console.warn('Job poll failed',err);}if(pendingSensorJobs.has(jobId))entry.timer=setTimeout(poll,sensorSocketReady?3000:1000);};entry.timer=setTimeout(poll,sensorSocketReady?3000:1000);});}
+async function sensorJobRequest(url,payload){const options={method:'POST'};if(payload!==undefined){options.headers={'Content-Type':'application/json'};options.body=JSON.stringify(payload);}const res=await fetch(url,options);if(res.status===202){const accepted=await res.json();return waitForSensorJob(accepted.job_id);}const text=await res.text();if(!res.ok)throw new Error(text||'Request failed');return null;}
+async function rescanSensors(){alert('Rescanning I2C bus...');try{await sensorJobRequest('/api/sensors/rescan');}catch(err){alert('Rescan failed: '+err.message);}await loadSensors();alert('Rescan complete!');}
 async function pauseSensors(){try{await fetch('/api/sensors/pause',{method:'POST'});alert('Sensor readings paused');}catch(e){alert('Failed to pause sensors');}}
 async function resumeSensors(){try{await fetch('/api/sensors/resume',{method:'POST'});alert('Sensor readings resumed');}catch(e){alert('Failed to resume sensors');}}
-async function saveSensorConfig(addr){const cfg={address:addr};const name=document.getElementById(`name-${addr}`)?.value;if(name){const trimmed=name.trim();if(trimmed.length>0){if(trimmed.length>16){alert('Sensor name must be 16 characters or less');return;}if(!/^[A-Za-z0-9_]+$/.test(trimmed)){alert('Sensor name can only contain letters, numbers, and underscores (no spaces or special characters)');return;}cfg.name=trimmed;}}const led=document.getElementById(`led-${addr}`)?.checked;if(led!==undefined)cfg.led=led;const plock=document.getElementById(`plock-${addr}`)?.checked;if(plock!==undefined)cfg.plock=plock;const scale=document.getElementById(`scale-${addr}`)?.value;if(scale)cfg.scale=scale;const extscale=document.getElementById(`extscale-${addr}`)?.checked;if(extscale!==undefined)cfg.extended_scale=extscale;const probe=document.getElementById(`probe-${addr}`)?.value;if(probe)cfg.probe_type=parseFloat(probe);const tds=document.getElementById(`tds-${addr}`)?.value;if(tds)cfg.tds_factor=parseFloat(tds);try{const res=await fetch('/api/sensors/config',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify(cfg)});if(!res.ok){const err=await res.text();alert('Failed to save: '+err);return;}alert('Sensor configuration saved!');await loadSensors();}catch(e){alert('Save failed: '+e.message);}}
-async function sensorActionRequest(url,payload,successMessage){try{const res=await fetch(url,{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify(payload)});const text=await res.text();if(!res.ok)throw new Error(text||'Request failed');if(successMessage)alert(successMessage);await loadSensors();return true;}catch(err){console.error('Sensor action failed:',err);alert(err.message||'Sensor action failed');return false;}}
+async function saveSensorConfig(addr){const cfg={address:addr};const name=document.getElementById(`name-${addr}`)?.value;if(name){const trimmed=name.trim();if(trimmed.length>0){if(trimmed.length>16){alert('Sensor name must be 16 characters or less');return;}if(!/^[A-Za-z0-9_]+$/.test(trimmed)){alert('Sensor name can only contain letters, numbers, and underscores (no spaces or special characters)');return;}cfg.name=trimmed;}}const led=document.getElementById(`led-${addr}`)?.checked;if(led!==undefined)cfg.led=led;const plock=document.getElementById(`plock-${addr}`)?.checked;if(plock!==undefined)cfg.plock=plock;const scale=document.getElementById(`scale-${addr}`)?.value;if(scale)cfg.scale=scale;const extscale=document.getElementById(`extscale-${addr}`)?.checked;if(extscale!==undefined)cfg.extended_scale=extscale;const probe=document.getElementById(`probe-${addr}`)?.value;if(probe)cfg.probe_type=parseFloat(probe);const tds=document.getElementById(`tds-${addr}`)?.value;if(tds)cfg.tds_factor=parseFloat(tds);try{await sensorJobRequest('/api/sensors/config',cfg);alert('Sensor configuration saved!');await loadSensors();}catch(e){alert('Save failed: '+e.message);}}
+async function sensorActionRequest(url,payload,successMessage){try{await sensorJobRequest(url,payload);if(successMessage)alert(successMessage);await loadSensors();return true;}catch(err){console.error('Sensor action failed:',err);alert(err.message||'Sensor action failed');return false;}}
 async function calibratePhSensor(address,point){const addrHex=formatAddress(address);if(point!=='clear'){const input=document.getElementById(`cal-${point}-${address}`)||document.getElementById(`modal-cal-${point}-${address}`);const value=parseFloat(input?.value||'');if(Number.isNaN(value)){alert('Enter a valid calibration value.');return;}if(!confirm(`Calibrate 0x${addrHex.toUpperCase()} (${point.toUpperCase()})?`))return;await sensorActionRequest(`/api/sensors/calibrate/${address}`,{point,value},'Calibration command sent.');}else{if(!confirm(`Clear calibration for sensor 0x${addrHex}?`))return;await sensorActionRequest(`/api/sensors/calibrate/${address}`,{point:'clear'},'Calibration cleared.');}}
 async function calibrateOrpSensor(address){const addrHex=formatAddress(address);const input=document.getElementById(`orp-cal-${address}`)||document.getElementById(`modal-orp-cal-${address}`);const value=parseFloat(input?.value||'');if(Number.isNaN(value)){alert('Enter a valid mV value.');return;}if(!confirm(`Calibrate ORP sensor 0x${addrHex} at ${value.toFixed(0)} mV?`))return;await sensorActionRequest(`/api/sensors/calibrate/${address}`,{value},'ORP calibration command sent.');}
 async function clearOrpCalibration(address){const addrHex=formatAddress(address);if(!confirm(`Clear ORP calibration for sensor 0x${addrHex}?`))return;await sensorActionRequest(`/api/sensors/calibrate/${address}`,{point:'clear'},'ORP calibration cleared.');}
@@ -111,8 +127,12 @@ async function loadSettings(){try{const res=await fetch('/api/settings');if(!res
 async function saveSettings(){try{const mqttInterval=parseInt(document.getElementById('mqtt-interval').value);const sensorInterval=parseInt(document.getElementById('sensor-interval').value);if(isNaN(mqttInterval)||mqttInterval<0){alert('MQTT interval must be >= 0');return;}if(isNaN(sensorInterval)||sensorInterval<1){alert('Sensor interval must be >= 1');return;}const res=await fetch('/api/settings',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify({mqtt_interval:mqttInterval,sensor_interval:sensorInterval})});if(!res.ok)throw new Error('Failed to save settings');alert(mqttInterval===0?'Settings saved! Periodic MQTT publishing disabled (will publish on sensor read).':'Settings saved successfully!');}catch(e){alert('Failed to save settings: '+e.message);}}
 async function resetSettings(){try{if(!confirm('Reset both intervals to 10 seconds (default)?'))return;const res=await fetch('/api/settings/reset',{method:'POST'});if(!res.ok)throw new Error('Failed to reset settings');const data=await res.json();document.getElementById('mqtt-interval').value=data.mqtt_interval;document.getElementById('sensor-interval').value=data.sensor_interval;alert('Settings reset to defaults (10 seconds)!');}catch(e){alert('Failed to reset settings: '+e.message);}}
 let isLoadingStatus=false;
+let lastStatusPushMs=0;
+const STATUS_PUSH_STALE_MS=45000;
+function applyDeviceStatus(d){lastStatusPushMs=Date.now();if(typeof d.uptime==='number'){const upMin=Math.floor(d.uptime/60),upHr=Math.floor(upMin/60);document.getElementById('uptime').textContent=upHr>0?`${upHr}h ${upMin%60}m`:`${upMin}m`;}if(typeof d.current_time==='string'){document.getElementById('current-time').textContent=d.current_time;}if(typeof d.free_heap==='number'){document.getElementById('free-heap').textContent=(d.free_heap/1024).toFixed(1)+' KB';}if(typeof d.rssi==='number'){document.getElementById('wifi-rssi').textContent=d.rssi+' dBm';}if(typeof d.cpu_usage==='number'){document.getElementById('cpu-usage').textContent=d.cpu_usage+'%';}document.getElementById('status-dot').className='bg-green-500 w-3 h-3 rounded-full status-dot';document.getElementById('status-text').textContent='Device Online';}
+function pollStatusIfStale(){if(sensorSocketReady&&Date.now()-lastStatusPushMs<STATUS_PUSH_STALE_MS)return;safeLoadStatus();}
 async function safeLoadStatus(){if(isLoadingStatus||(focusModeActive&&!focusUsingWebSocket))return;isLoadingStatus=true;try{await loadStatus();}catch(e){console.error('Status load failed:',e);}finally{isLoadingStatus=false;}}
-async function initializeDashboard(){loadTheme();await ensureSensorsResumed();await safeLoadStatus();await loadSensors();initSensorSocket();const modal=document.getElementById('sensorModal');if(modal){modal.addEventListener('click',e=>{if(e.target===modal){closeSensorModal();}});}document.addEventListener('keydown',e=>{if(e.key==='Escape')closeSensorModal();});setInterval(safeLoadStatus,10000);}
+async function initializeDashboard(){loadTheme();await ensureSensorsResumed();await safeLoadStatus();await loadSensors();initSensorSocket();const modal=document.getElementById('sensorModal');if(modal){modal.addEventListener('click',e=>{if(e.target===modal){closeSensorModal();}});}document.addEventListener('keydown',e=>{if(e.key==='Escape')closeSensorModal();});setInterval(pollStatusIfStale,10000);}
 async function ensureSensorsResumed(){try{await fetch('/api/sensors/resume',{method:'POST'});}catch(e){console.warn('Resume on init failed:',e);}}
 
 // Code Editor Functions
@@ -138,6 +158,9 @@ const CalibrationWizard = {
   stableCount: 0,
   lastReading: null,
   focusInterval: null,
+  sessionActive: false,
+  sessionDetail: null,
+  commitPending: false,
   
   // Sensor-specific configurations
   configs: {
@@ -238,6 +261,8 @@ const CalibrationWizard = {
     const modal = document.getElementById('calibrationWizard');
     modal.classList.add('hidden');
     
+    this.cancelStabilitySession();
+    
     // Stop focus mode
     if (this.focusInterval) {
       clearInterval(this.focusInterval);
@@ -300,6 +325,64 @@ const CalibrationWizard = {
     } else {
       content.innerHTML = this.renderCalibrationStep(step);
     }
+    
+    if (step.id === 'intro' || step.id === 'complete' || step.isDry) {
+      this.cancelStabilitySession();
+    } else {
+      this.startStabilitySession(step);
+    }
+  },
+  
+  // The device tracks stability itself while the socket is up; the
+  // client-side check below is only the fallback for HTTP polling
+  startStabilitySession(step) {
+    this.sessionDetail = null;
+    this.commitPending = false;
+    if (!sensorSocketReady) {
+      this.sessionActive = false;
+      return;
+    }
+    const payload = {action: 'calibration_start', address: Number(this.sensor.address), point: step.id, auto_commit: false};
+    if (step.value !== undefined) {
+      payload.value = step.value;
+    }
+    sendSensorSocketMessage(payload);
+    this.sessionActive = true;
+  },
+  
+  cancelStabilitySession() {
+    if (this.sessionActive) {
+      sendSensorSocketMessage({action: 'calibration_cancel'});
+    }
+    this.sessionActive = false;
+    this.commitPending = false;
+  },
+  
+  onCalibrationStatus(message) {
+    if (!this.sessionActive || !this.sensor || Number(message.address) !== Number(this.sensor.address)) return;
+    
+    if (message.state === 'committed') {
+      this.sessionActive = false;
+      this.commitPending = false;
+      this.nextStep();
+    } else if (message.state === 'failed') {
+      this.sessionActive = false;
+      if (this.commitPending) {
+        this.commitPending = false;
+        alert(`Calibration failed: ${message.error || 'unknown error'}`);
+      }
+    } else if (message.state === 'stable' || message.state === 'settling') {
+      if (message.error && this.commitPending) {
+        this.commitPending = false;
+        alert(`Calibration failed: ${message.error}`);
+      }
+      this.sessionDetail = message;
+      const wasStable = this.isStable;
+      this.isStable = message.state === 'stable';
+      if (wasStable !== this.isStable || !this.isStable) {
+        this.updateStabilityUI();
+      }
+    }
   },
   
   renderIntroStep() {
@@ -498,7 +581,9 @@ const CalibrationWizard = {
     }
     
     // Check stability
-    this.checkStability(numericValue);
+    if (!this.sessionActive) {
+      this.checkStability(numericValue);
+    }
   },
   
   checkStability(value) {
@@ -553,13 +638,23 @@ const CalibrationWizard = {
             <div class="stability-dot"></div>
             <div class="stability-dot"></div>
           </div>
-          <span>Stabilizing... (${this.stableCount}/3)</span>
+          <span>${this.stabilityProgressText()}</span>
         </div>
       `;
       if (calibrateBtn) calibrateBtn.disabled = true;
     }
   },
   
+  stabilityProgressText() {
+    const detail = this.sessionDetail;
+    if (!this.sessionActive || !detail || !detail.samples) {
+      return `Stabilizing... (${this.stableCount}/3)`;
+    }
+    const spread = Number(detail.stddev || 0).toPrecision(2);
+    const drift = Number(detail.slope_per_min || 0).toPrecision(2);
+    return `Stabilizing... (±${spread}, drift ${drift}/min over ${Math.round((detail.span_ms || 0) / 1000)}s)`;
+  },
+  
   async calibratePoint(pointId) {
     const step = this.steps.find(s => s.id === pointId);
     if (!step) return;
@@ -581,6 +676,13 @@ const CalibrationWizard = {
       payload.value = value;
     }
     
+    if (this.sessionActive && sensorSocketReady) {
+      // The device sends the point and replies with a committed or failed status
+      this.commitPending = true;
+      sendSensorSocketMessage({action: 'calibration_commit', ...payload});
+      return;
+    }
+    
     try {
       const res = await fetch(`/api/sensors/calibrate/${this.sensor.address}`, {
         method: 'POST',
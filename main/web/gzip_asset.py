@@ -0,0 +1,28 @@
+#!/usr/bin/env python3
+"""
+Compress a dashboard asset for embedding in the firmware image
+
+Usage: gzip_asset.py <input> <output.gz>
+
+The gzip header carries no file name or timestamp, so identical sources
+produce identical blobs (and identical ETags on the device).
+"""
+
+import gzip
+import sys
+
+
+def main():
+    if len(sys.argv) != 3:
+        print("Usage: gzip_asset.py <input> <output.gz>")
+        sys.exit(1)
+
+    with open(sys.argv[1], "rb") as f:
+        data = f.read()
+
+    with open(sys.argv[2], "wb") as f:
+        f.write(gzip.compress(data, compresslevel=9, mtime=0))
+
+
+if __name__ == "__main__":
+    main()
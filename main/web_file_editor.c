@@ -11,27 +11,41 @@ static const char *TAG = "WEB_EDITOR";
 #ifndef CONFIG_IDF_TARGET_ESP32C6
 // Full web file editor implementation for ESP32-S3
 
+#include "asset_pack.h"
+#include "gzip_format.h"
 #include "esp_vfs_fat.h"
 #include "esp_partition.h"
 #include "wear_levelling.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "rom/miniz.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "cJSON.h"
 #include <sys/stat.h>
 #include <dirent.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <unistd.h>
+
+#define WEB_EDITOR_NAME_MAX       64
+#define WEB_EDITOR_PATH_MAX       128
+#define WEB_EDITOR_PART_SUFFIX    ".part"   // Upload still being written
+#define WEB_EDITOR_BACKUP_SUFFIX  ".bak"    // Previous copy while an upload is committed
 
 static wl_handle_t s_wl_handle = WL_INVALID_HANDLE;
 
-// External references to embedded web assets
-extern const uint8_t index_html_start[] asm("_binary_index_html_start");
-extern const uint8_t index_html_end[]   asm("_binary_index_html_end");
-extern const uint8_t dashboard_css_start[] asm("_binary_dashboard_css_start");
-extern const uint8_t dashboard_css_end[]   asm("_binary_dashboard_css_end");
-extern const uint8_t dashboard_js_start[]  asm("_binary_dashboard_js_start");
-extern const uint8_t dashboard_js_end[]    asm("_binary_dashboard_js_end");
+// External references to embedded web assets (gzip-compressed at build time)
+extern const uint8_t index_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t index_html_gz_end[]   asm("_binary_index_html_gz_end");
+extern const uint8_t dashboard_css_gz_start[] asm("_binary_dashboard_css_gz_start");
+extern const uint8_t dashboard_css_gz_end[]   asm("_binary_dashboard_css_gz_end");
+extern const uint8_t dashboard_js_gz_start[]  asm("_binary_dashboard_js_gz_start");
+extern const uint8_t dashboard_js_gz_end[]    asm("_binary_dashboard_js_gz_end");
 
 typedef struct {
     const char *name;
@@ -40,16 +54,37 @@ typedef struct {
 } default_asset_t;
 
 static const default_asset_t k_default_assets[] = {
-    { "index.html",    index_html_start,    index_html_end    },
-    { "dashboard.css", dashboard_css_start, dashboard_css_end },
-    { "dashboard.js",  dashboard_js_start,  dashboard_js_end  }
+    { "index.html",    index_html_gz_start,    index_html_gz_end    },
+    { "dashboard.css", dashboard_css_gz_start, dashboard_css_gz_end },
+    { "dashboard.js",  dashboard_js_gz_start,  dashboard_js_gz_end  }
 };
 
+#define WEB_ASSET_COUNT (sizeof(k_default_assets) / sizeof(k_default_assets[0]))
+
+// Dashboard assets resolved between edits, indexed like k_default_assets
+typedef struct {
+    char *content;
+    size_t size;
+    bool gzip;
+    bool packed;                // content points into the mapped asset pack, not PSRAM
+    char etag[WEB_EDITOR_ETAG_SIZE];
+} cached_asset_t;
+
+static cached_asset_t s_asset_cache[WEB_ASSET_COUNT];
+static SemaphoreHandle_t s_cache_mutex = NULL;
+static bool s_pack_enabled = false;     // An "assets" partition exists
+static bool s_pack_dirty = false;       // FATFS changed since the pack was written
+
 static esp_err_t write_default_asset_internal(const default_asset_t *asset, bool allow_format);
+static esp_err_t load_file_caps(const char *filename, char **content, size_t *size, uint32_t caps);
+static void web_editor_cache_invalidate(const char *filename);
 static esp_err_t web_editor_mount_fs(bool format_if_needed);
 static void web_editor_unmount_fs(void);
+static void web_editor_recover_uploads(void);
+static bool has_suffix(const char *name, const char *suffix);
 static esp_err_t web_editor_format_partition(void);
 static esp_err_t web_editor_seed_all_defaults(void);
+static void web_editor_sync_pack(void);
 
 static esp_err_t write_default_asset(const default_asset_t *asset)
 {
@@ -89,11 +124,6 @@ static esp_err_t write_default_asset_internal(const default_asset_t *asset, bool
         return ESP_ERR_INVALID_SIZE;
     }
 
-    if (asset->start[asset_size - 1] == '\0') {
-        ESP_LOGD(TAG, "Trimming trailing null terminator for %s", asset->name);
-        asset_size--;
-    }
-
     char filepath[128];
     snprintf(filepath, sizeof(filepath), "%s/%s", WEB_EDITOR_FS_PATH, asset->name);
 
@@ -120,6 +150,7 @@ static esp_err_t write_default_asset_internal(const default_asset_t *asset, bool
             }
 
             ESP_LOGW(TAG, "Formatting FATFS partition 'www' to recover web assets");
+            web_editor_cache_invalidate(NULL);
             web_editor_unmount_fs();
             esp_err_t fmt = web_editor_format_partition();
             if (fmt != ESP_OK) {
@@ -148,10 +179,102 @@ static esp_err_t write_default_asset_internal(const default_asset_t *asset, bool
         return ESP_FAIL;
     }
 
+    web_editor_cache_invalidate(asset->name);
     ESP_LOGI(TAG, "Seeded default %s (%zu bytes)", asset->name, asset_size);
     return ESP_OK;
 }
 
+/**
+ * @brief Drop cache entries; caller holds s_cache_mutex
+ */
+static void web_editor_cache_clear_locked(const char *filename)
+{
+    for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+        if (filename != NULL && strcmp(filename, k_default_assets[i].name) != 0) {
+            continue;
+        }
+        if (s_asset_cache[i].content != NULL) {
+            ESP_LOGD(TAG, "Invalidated cached %s", k_default_assets[i].name);
+        }
+        if (!s_asset_cache[i].packed) {
+            free(s_asset_cache[i].content);
+        }
+        s_asset_cache[i].content = NULL;
+        s_asset_cache[i].size = 0;
+        s_asset_cache[i].gzip = false;
+        s_asset_cache[i].packed = false;
+        s_asset_cache[i].etag[0] = '\0';
+    }
+}
+
+/**
+ * @brief Drop cached copies so the next request reloads from FATFS
+ *
+ * Also marks the asset pack stale; it is rewritten by web_editor_sync_pack().
+ *
+ * @param filename Asset to drop, or NULL for all of them
+ */
+static void web_editor_cache_invalidate(const char *filename)
+{
+    if (s_cache_mutex == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(s_cache_mutex, portMAX_DELAY);
+    web_editor_cache_clear_locked(filename);
+    s_pack_dirty = true;
+    xSemaphoreGive(s_cache_mutex);
+}
+
+/**
+ * @brief Rewrite the asset pack from FATFS if a file changed since it was built
+ *
+ * Files are read into PSRAM once here, so requests can then be served from
+ * mapped flash without touching FATFS. If the files do not fit the partition,
+ * no pack remains and requests fall back to the PSRAM cache.
+ */
+static void web_editor_sync_pack(void)
+{
+    if (!s_pack_enabled || !s_pack_dirty) {
+        return;
+    }
+    // A file restored while loading below marks the pack dirty again for the next sync
+    s_pack_dirty = false;
+
+    asset_pack_source_t sources[WEB_ASSET_COUNT];
+    char *buffers[WEB_ASSET_COUNT] = { 0 };
+    size_t count = 0;
+    for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+        size_t size = 0;
+        if (load_file_caps(k_default_assets[i].name, &buffers[i], &size,
+                           MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) != ESP_OK) {
+            continue;
+        }
+        sources[count++] = (asset_pack_source_t) {
+            .name = k_default_assets[i].name,
+            .data = buffers[i],
+            .size = size,
+            .encoding = web_editor_is_gzip(buffers[i], size) ? ASSET_PACK_ENCODING_GZIP
+                                                             : ASSET_PACK_ENCODING_IDENTITY,
+        };
+    }
+
+    // Cached entries may point into the mapping that the rewrite drops
+    xSemaphoreTake(s_cache_mutex, portMAX_DELAY);
+    web_editor_cache_clear_locked(NULL);
+    esp_err_t ret = asset_pack_write(sources, count);
+    xSemaphoreGive(s_cache_mutex);
+
+    for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+        free(buffers[i]);
+    }
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Asset pack rebuilt (%zu files)", count);
+    } else {
+        ESP_LOGW(TAG, "Asset pack rebuild failed (%s), serving from FATFS", esp_err_to_name(ret));
+    }
+}
+
 static void ensure_default_asset(const default_asset_t *asset)
 {
     if (asset == NULL) {
@@ -250,20 +373,54 @@ esp_err_t web_editor_init_fs(void)
 {
     ESP_LOGI(TAG, "Initializing FATFS dashboard volume...");
 
+    if (s_cache_mutex == NULL) {
+        s_cache_mutex = xSemaphoreCreateMutex();
+    }
+
     esp_err_t ret = web_editor_mount_fs(true);
     if (ret != ESP_OK) {
         return ret;
     }
 
+    web_editor_recover_uploads();
+
     // Seed dashboard defaults (HTML/CSS/JS) if missing or empty
     for (size_t i = 0; i < (sizeof(k_default_assets) / sizeof(k_default_assets[0])); i++) {
         ensure_default_asset(&k_default_assets[i]);
     }
+
+    // Build the pack when it is missing or was cut short; a seeded default already marked it dirty
+    esp_err_t pack = asset_pack_init();
+    s_pack_enabled = (pack != ESP_ERR_NOT_FOUND);
+    if (pack != ESP_OK) {
+        s_pack_dirty = true;
+    }
+    web_editor_sync_pack();
     
     return ESP_OK;
 }
 
 esp_err_t web_editor_load_file(const char *filename, char **content, size_t *size)
+{
+    esp_err_t ret = load_file_caps(filename, content, size, 0);
+    if (ret != ESP_OK || !web_editor_is_gzip(*content, *size)) {
+        return ret;
+    }
+
+    // Seeded defaults are stored compressed; callers of this API expect the text
+    char *text = NULL;
+    size_t text_size = 0;
+    ret = web_editor_gunzip(*content, *size, &text, &text_size);
+    free(*content);
+    *content = text;
+    *size = text_size;
+    return ret;
+}
+
+/**
+ * @brief Load a file, allocating the buffer with the given heap caps (0 for plain malloc)
+ */
+static esp_err_t load_file_caps(const char *filename, char **content, size_t *size, uint32_t caps)
 {
     if (filename == NULL || content == NULL || size == NULL) {
         return ESP_ERR_INVALID_ARG;
@@ -293,7 +450,7 @@ esp_err_t web_editor_load_file(const char *filename, char **content, size_t *siz
         if (asset != NULL) {
             ESP_LOGI(TAG, "Restoring embedded default for %s", filename);
             if (write_default_asset(asset) == ESP_OK) {
-                return web_editor_load_file(filename, content, size);
+                return load_file_caps(filename, content, size, caps);
             }
             ESP_LOGE(TAG, "Restore failed for %s (errno=%d)", filename, errsv);
         }
@@ -312,7 +469,7 @@ esp_err_t web_editor_load_file(const char *filename, char **content, size_t *siz
             ESP_LOGW(TAG, "%s appears empty, restoring embedded default", filename);
             if (write_default_asset(asset) == ESP_OK) {
                 // Try loading again after restore
-                return web_editor_load_file(filename, content, size);
+                return load_file_caps(filename, content, size, caps);
             }
         }
         ESP_LOGE(TAG, "File %s is empty and no default available", filename);
@@ -325,7 +482,10 @@ esp_err_t web_editor_load_file(const char *filename, char **content, size_t *siz
         return ESP_ERR_INVALID_SIZE;
     }
     
-    *content = malloc(fsize + 1);
+    *content = (caps != 0) ? heap_caps_malloc(fsize + 1, caps) : NULL;
+    if (*content == NULL) {
+        *content = malloc(fsize + 1);
+    }
     if (*content == NULL) {
         fclose(f);
         return ESP_ERR_NO_MEM;
@@ -343,7 +503,7 @@ esp_err_t web_editor_load_file(const char *filename, char **content, size_t *siz
         const default_asset_t *asset = find_default_asset(filename);
         if (asset != NULL && write_default_asset(asset) == ESP_OK) {
             ESP_LOGI(TAG, "Retried load after restoring %s", filename);
-            return web_editor_load_file(filename, content, size);
+            return load_file_caps(filename, content, size, caps);
         }
         return ESP_FAIL;
     }
@@ -355,56 +515,285 @@ esp_err_t web_editor_load_file(const char *filename, char **content, size_t *siz
     return ESP_OK;
 }
 
-esp_err_t web_editor_save_file(const char *filename, const char *content, size_t size)
+esp_err_t web_editor_get_cached_file(const char *filename, const char **content, size_t *size,
+                                     bool *gzip, const char **etag)
 {
-    if (filename == NULL || content == NULL) {
+    if (filename == NULL || content == NULL || size == NULL || gzip == NULL || etag == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
+    if (s_cache_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    esp_err_t fs_status = web_editor_mount_fs(false);
-    if (fs_status != ESP_OK) {
-        ESP_LOGE(TAG, "FATFS volume unavailable when saving %s: %s", filename, esp_err_to_name(fs_status));
-        return fs_status;
+    size_t index = WEB_ASSET_COUNT;
+    for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+        if (strcmp(filename, k_default_assets[i].name) == 0) {
+            index = i;
+            break;
+        }
     }
-    
+    if (index == WEB_ASSET_COUNT) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    web_editor_sync_pack();
+
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(s_cache_mutex, portMAX_DELAY);
+    cached_asset_t *entry = &s_asset_cache[index];
+    asset_pack_file_t packed;
+    if (entry->content == NULL && asset_pack_find(filename, &packed) == ESP_OK) {
+        // Zero-copy: the entry points straight into mapped flash
+        snprintf(entry->etag, sizeof(entry->etag), "\"%08" PRIx32 "-%zx\"", packed.crc32, packed.size);
+        entry->content = (char *)packed.data;
+        entry->size = packed.size;
+        entry->gzip = (packed.encoding == ASSET_PACK_ENCODING_GZIP);
+        entry->packed = true;
+    }
+    if (entry->content == NULL) {
+        char *data = NULL;
+        size_t data_size = 0;
+        ret = load_file_caps(filename, &data, &data_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (ret == ESP_OK) {
+            // Strong validator: content CRC plus length, quoted as HTTP requires
+            uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)data, data_size);
+            snprintf(entry->etag, sizeof(entry->etag), "\"%08" PRIx32 "-%zx\"", crc, data_size);
+            entry->content = data;
+            entry->size = data_size;
+            entry->gzip = web_editor_is_gzip(data, data_size);
+            ESP_LOGI(TAG, "Cached %s (%zu bytes%s, ETag %s)", filename, data_size,
+                     entry->gzip ? ", gzip" : "", entry->etag);
+        }
+    }
+    if (ret == ESP_OK) {
+        *content = entry->content;
+        *size = entry->size;
+        *gzip = entry->gzip;
+        *etag = entry->etag;
+    }
+    xSemaphoreGive(s_cache_mutex);
+    return ret;
+}
+
+/**
+ * @brief Validate a dashboard file name (no paths, editable types only)
+ */
+static esp_err_t web_editor_check_name(const char *filename)
+{
     // Security: prevent directory traversal
     if (strstr(filename, "..") != NULL || strchr(filename, '/') != NULL) {
         ESP_LOGW(TAG, "Invalid filename: %s", filename);
         return ESP_ERR_INVALID_ARG;
     }
-    
+
     // Only allow certain file types
     if (!strstr(filename, ".html") && !strstr(filename, ".js") && !strstr(filename, ".css")) {
         ESP_LOGW(TAG, "File type not allowed: %s", filename);
         return ESP_ERR_NOT_ALLOWED;
     }
-    
-    if (size > WEB_EDITOR_MAX_FILE_SIZE) {
-        ESP_LOGW(TAG, "File too large: %zu bytes", size);
+
+    if (strlen(filename) >= WEB_EDITOR_NAME_MAX) {
+        ESP_LOGW(TAG, "Filename too long: %s", filename);
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+static bool has_suffix(const char *name, const char *suffix)
+{
+    size_t name_len = strlen(name);
+    size_t suffix_len = strlen(suffix);
+    return name_len > suffix_len && strcmp(name + name_len - suffix_len, suffix) == 0;
+}
+
+/**
+ * @brief Finish replacements and drop partial uploads left by a reset mid-write
+ *
+ * A leftover backup whose target is missing means power was lost between the
+ * two renames of a commit, so it is moved back into place.
+ */
+static void web_editor_recover_uploads(void)
+{
+    DIR *dir = opendir(WEB_EDITOR_FS_PATH);
+    if (dir == NULL) {
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type != DT_REG) {
+            continue;
+        }
+        char path[300];
+        snprintf(path, sizeof(path), "%s/%s", WEB_EDITOR_FS_PATH, entry->d_name);
+        if (has_suffix(entry->d_name, WEB_EDITOR_PART_SUFFIX)) {
+            ESP_LOGW(TAG, "Removing interrupted upload %s", entry->d_name);
+            unlink(path);
+        } else if (has_suffix(entry->d_name, WEB_EDITOR_BACKUP_SUFFIX)) {
+            char target[300];
+            snprintf(target, sizeof(target), "%.*s", (int)(strlen(path) - strlen(WEB_EDITOR_BACKUP_SUFFIX)), path);
+            struct stat st;
+            if (stat(target, &st) != 0) {
+                ESP_LOGW(TAG, "Restoring %s from backup", target);
+                rename(path, target);
+            } else {
+                unlink(path);
+            }
+        }
+    }
+    closedir(dir);
+}
+
+struct web_editor_upload {
+    FILE *file;
+    size_t size;
+    char path[WEB_EDITOR_PATH_MAX];
+    char tmp_path[WEB_EDITOR_PATH_MAX];
+    char filename[WEB_EDITOR_NAME_MAX];
+};
+
+esp_err_t web_editor_upload_begin(const char *filename, web_editor_upload_t **upload)
+{
+    if (filename == NULL || upload == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *upload = NULL;
+
+    esp_err_t ret = web_editor_check_name(filename);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    esp_err_t fs_status = web_editor_mount_fs(false);
+    if (fs_status != ESP_OK) {
+        ESP_LOGE(TAG, "FATFS volume unavailable when saving %s: %s", filename, esp_err_to_name(fs_status));
+        return fs_status;
+    }
+
+    web_editor_upload_t *up = calloc(1, sizeof(*up));
+    if (up == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Concurrent uploads of the same name each get their own temporary file
+    static uint32_t s_upload_seq = 0;
+    snprintf(up->filename, sizeof(up->filename), "%s", filename);
+    snprintf(up->path, sizeof(up->path), "%s/%s", WEB_EDITOR_FS_PATH, filename);
+    snprintf(up->tmp_path, sizeof(up->tmp_path), "%s/%s.%" PRIu32 WEB_EDITOR_PART_SUFFIX,
+             WEB_EDITOR_FS_PATH, filename, ++s_upload_seq);
+
+    up->file = fopen(up->tmp_path, "w");
+    if (up->file == NULL) {
+        ESP_LOGE(TAG, "Failed to open file for writing: %s (errno=%d)", up->tmp_path, errno);
+        free(up);
+        return ESP_FAIL;
+    }
+
+    *upload = up;
+    return ESP_OK;
+}
+
+esp_err_t web_editor_upload_write(web_editor_upload_t *upload, const char *data, size_t len)
+{
+    if (upload == NULL || (data == NULL && len > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (upload->size + len > WEB_EDITOR_MAX_FILE_SIZE) {
+        ESP_LOGW(TAG, "File too large: %zu bytes", upload->size + len);
         return ESP_ERR_INVALID_SIZE;
     }
-    
-    char filepath[128];
-    snprintf(filepath, sizeof(filepath), "%s/%s", WEB_EDITOR_FS_PATH, filename);
-    
-    FILE *f = fopen(filepath, "w");
-    if (f == NULL) {
-        ESP_LOGE(TAG, "Failed to open file for writing: %s", filepath);
+
+    size_t written = fwrite(data, 1, len, upload->file);
+    upload->size += written;
+    if (written != len) {
+        ESP_LOGE(TAG, "Write failed: %zu/%zu bytes written", written, len);
         return ESP_FAIL;
     }
-    
-    size_t written = fwrite(content, 1, size, f);
-    fclose(f);
-    
-    if (written != size) {
-        ESP_LOGE(TAG, "Write failed: %zu/%zu bytes written", written, size);
+    return ESP_OK;
+}
+
+void web_editor_upload_abort(web_editor_upload_t *upload)
+{
+    if (upload == NULL) {
+        return;
+    }
+    if (upload->file != NULL) {
+        fclose(upload->file);
+    }
+    unlink(upload->tmp_path);
+    free(upload);
+}
+
+esp_err_t web_editor_upload_commit(web_editor_upload_t *upload)
+{
+    if (upload == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int close_result = fclose(upload->file);
+    upload->file = NULL;
+    if (close_result != 0) {
+        ESP_LOGE(TAG, "Failed to flush %s (errno=%d)", upload->tmp_path, errno);
+        web_editor_upload_abort(upload);
         return ESP_FAIL;
     }
-    
-    ESP_LOGI(TAG, "Saved file: %s (%zu bytes)", filename, size);
+
+    // FATFS cannot rename over an existing file, so the old copy steps aside
+    // first and is only deleted once the new one is in place
+    char backup[WEB_EDITOR_PATH_MAX + sizeof(WEB_EDITOR_BACKUP_SUFFIX)];
+    snprintf(backup, sizeof(backup), "%s" WEB_EDITOR_BACKUP_SUFFIX, upload->path);
+    unlink(backup);
+
+    struct stat st;
+    bool had_target = stat(upload->path, &st) == 0;
+    if (had_target && rename(upload->path, backup) != 0) {
+        ESP_LOGE(TAG, "Failed to move %s aside (errno=%d)", upload->path, errno);
+        web_editor_upload_abort(upload);
+        return ESP_FAIL;
+    }
+    if (rename(upload->tmp_path, upload->path) != 0) {
+        ESP_LOGE(TAG, "Failed to replace %s (errno=%d)", upload->path, errno);
+        if (had_target) {
+            rename(backup, upload->path);
+        }
+        web_editor_cache_invalidate(upload->filename);
+        web_editor_upload_abort(upload);
+        return ESP_FAIL;
+    }
+    if (had_target) {
+        unlink(backup);
+    }
+    web_editor_cache_invalidate(upload->filename);
+
+    ESP_LOGI(TAG, "Saved file: %s (%zu bytes)", upload->filename, upload->size);
+    free(upload);
+    web_editor_sync_pack();
     return ESP_OK;
 }
 
+esp_err_t web_editor_save_file(const char *filename, const char *content, size_t size)
+{
+    if (filename == NULL || content == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (size > WEB_EDITOR_MAX_FILE_SIZE) {
+        ESP_LOGW(TAG, "File too large: %zu bytes", size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    web_editor_upload_t *upload = NULL;
+    esp_err_t ret = web_editor_upload_begin(filename, &upload);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = web_editor_upload_write(upload, content, size);
+    if (ret != ESP_OK) {
+        web_editor_upload_abort(upload);
+        return ret;
+    }
+    return web_editor_upload_commit(upload);
+}
+
 esp_err_t web_editor_list_files(char **json_output)
 {
     if (json_output == NULL) {
@@ -428,7 +817,9 @@ esp_err_t web_editor_list_files(char **json_output)
     
     struct dirent *entry;
     while ((entry = readdir(dir)) != NULL) {
-        if (entry->d_type == DT_REG) {  // Regular file
+        if (entry->d_type == DT_REG &&  // Regular file, not an upload in flight
+            !has_suffix(entry->d_name, WEB_EDITOR_PART_SUFFIX) &&
+            !has_suffix(entry->d_name, WEB_EDITOR_BACKUP_SUFFIX)) {
             cJSON *file_obj = cJSON_CreateObject();
             cJSON_AddStringToObject(file_obj, "name", entry->d_name);
             
@@ -453,6 +844,68 @@ esp_err_t web_editor_list_files(char **json_output)
     return (*json_output != NULL) ? ESP_OK : ESP_ERR_NO_MEM;
 }
 
+bool web_editor_is_gzip(const char *data, size_t size)
+{
+    return data != NULL && size >= 18 && (uint8_t)data[0] == 0x1f && (uint8_t)data[1] == 0x8b;
+}
+
+esp_err_t web_editor_gunzip(const char *in, size_t in_size, char **out, size_t *out_size)
+{
+    if (in == NULL || out == NULL || out_size == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!web_editor_is_gzip(in, in_size)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const uint8_t *src = (const uint8_t *)in;
+    size_t pos = gzip_header_len(src, in_size);
+    if (pos == 0 || pos + GZIP_TRAILER_SIZE > in_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Trailer: CRC32 and length of the uncompressed data
+    const uint8_t *trailer = src + in_size - GZIP_TRAILER_SIZE;
+    uint32_t isize;
+    gzip_read_trailer(trailer, NULL, &isize);
+    if (isize > WEB_EDITOR_MAX_FILE_SIZE) {
+        ESP_LOGW(TAG, "Compressed asset expands to %" PRIu32 " bytes, over the limit", isize);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    char *text = heap_caps_malloc(isize + 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (text == NULL) {
+        text = malloc(isize + 1);
+    }
+    tinfl_decompressor *inflator = malloc(sizeof(tinfl_decompressor));
+    if (text == NULL || inflator == NULL) {
+        free(text);
+        free(inflator);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Whole stream in one call; the ROM inflater needs no window beyond the output buffer
+    tinfl_init(inflator);
+    size_t in_bytes = in_size - pos - GZIP_TRAILER_SIZE;
+    size_t out_bytes = isize;
+    tinfl_status status = tinfl_decompress(inflator, src + pos, &in_bytes,
+                                           (uint8_t *)text, (uint8_t *)text, &out_bytes,
+                                           TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+    free(inflator);
+
+    if (status != TINFL_STATUS_DONE ||
+        !gzip_trailer_matches(trailer, esp_rom_crc32_le(0, (const uint8_t *)text, out_bytes), out_bytes)) {
+        ESP_LOGW(TAG, "Corrupt gzip data (status=%d, %zu/%" PRIu32 " bytes)", (int)status, out_bytes, isize);
+        free(text);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    text[out_bytes] = '\0';
+    *out = text;
+    *out_size = out_bytes;
+    return ESP_OK;
+}
+
 const char* web_editor_get_content_type(const char *filename)
 {
     if (strstr(filename, ".html")) {
@@ -469,6 +922,7 @@ esp_err_t web_editor_reset_fs(void)
 {
     ESP_LOGW(TAG, "Resetting FATFS volume '/www' and restoring default dashboard assets");
 
+    web_editor_cache_invalidate(NULL);
     web_editor_unmount_fs();
 
     esp_err_t err = web_editor_format_partition();
@@ -487,6 +941,7 @@ esp_err_t web_editor_reset_fs(void)
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to reseed default dashboard files: %s", esp_err_to_name(err));
     }
+    web_editor_sync_pack();
     return err;
 }
 
@@ -504,11 +959,46 @@ esp_err_t web_editor_load_file(const char *filename, char **content, size_t *siz
     return ESP_ERR_NOT_SUPPORTED;
 }
 
+esp_err_t web_editor_get_cached_file(const char *filename, const char **content, size_t *size,
+                                     bool *gzip, const char **etag)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+bool web_editor_is_gzip(const char *data, size_t size)
+{
+    return false;
+}
+
+esp_err_t web_editor_gunzip(const char *in, size_t in_size, char **out, size_t *out_size)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
 esp_err_t web_editor_save_file(const char *filename, const char *content, size_t size)
 {
     return ESP_ERR_NOT_SUPPORTED;
 }
 
+esp_err_t web_editor_upload_begin(const char *filename, web_editor_upload_t **upload)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t web_editor_upload_write(web_editor_upload_t *upload, const char *data, size_t len)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t web_editor_upload_commit(web_editor_upload_t *upload)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void web_editor_upload_abort(web_editor_upload_t *upload)
+{
+}
+
 esp_err_t web_editor_list_files(char **json_output)
 {
     return ESP_ERR_NOT_SUPPORTED;
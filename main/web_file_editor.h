@@ -7,6 +7,7 @@
 
 #include "esp_err.h"
 #include <stddef.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -14,6 +15,7 @@ extern "C" {
 
 #define WEB_EDITOR_FS_PATH "/www"
 #define WEB_EDITOR_MAX_FILE_SIZE (200 * 1024)  // 200KB
+#define WEB_EDITOR_ETAG_SIZE 24                 // Quoted "crc32-length" validator
 
 /**
  * @brief Initialize FATFS file system and copy embedded files on first boot
@@ -23,6 +25,9 @@ esp_err_t web_editor_init_fs(void);
 
 /**
  * @brief Load a file from FATFS
+ *
+ * Files stored gzip-compressed (the seeded defaults) are decompressed.
+ *
  * @param filename Name of the file (without path)
  * @param content Output buffer pointer (will be allocated, must be freed by caller)
  * @param size Output size of the loaded content
@@ -30,6 +35,46 @@ esp_err_t web_editor_init_fs(void);
  */
 esp_err_t web_editor_load_file(const char *filename, char **content, size_t *size);
 
+/**
+ * @brief Get a dashboard asset (index.html, dashboard.css, dashboard.js) from the in-memory cache
+ *
+ * The content is returned as stored on FATFS: the seeded defaults are gzip
+ * data, files saved through the editor are plain text. With an "assets"
+ * partition the content points into the memory-mapped asset pack, which is
+ * rebuilt whenever a file changes; otherwise the first call loads the file
+ * into PSRAM. Either way later calls return the same buffer
+ * until web_editor_save_file() or web_editor_reset_fs() replaces the file. The
+ * buffer is owned by the cache, so only use it from the HTTP server task, which
+ * is also where those writes happen.
+ *
+ * @param filename Name of the file (without path)
+ * @param content Output pointer to the cached content
+ * @param size Output size of the content
+ * @param gzip Output true if the content is gzip data
+ * @param etag Output strong ETag (quoted) identifying this content
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if the file is not a cached asset
+ */
+esp_err_t web_editor_get_cached_file(const char *filename, const char **content, size_t *size,
+                                     bool *gzip, const char **etag);
+
+/**
+ * @brief Check for the gzip magic bytes
+ * @param data Buffer to check
+ * @param size Size of the buffer
+ * @return true if data is a gzip stream
+ */
+bool web_editor_is_gzip(const char *data, size_t size);
+
+/**
+ * @brief Decompress a gzip stream (for clients that do not accept gzip)
+ * @param in Gzip data
+ * @param in_size Size of the gzip data
+ * @param out Output buffer pointer (will be allocated and NUL-terminated, must be freed by caller)
+ * @param out_size Output size of the decompressed content
+ * @return ESP_OK on success, ESP_ERR_INVALID_CRC on corrupt data
+ */
+esp_err_t web_editor_gunzip(const char *in, size_t in_size, char **out, size_t *out_size);
+
 /**
  * @brief Save a file to FATFS
  * @param filename Name of the file (without path)
@@ -39,9 +84,45 @@ esp_err_t web_editor_load_file(const char *filename, char **content, size_t *siz
  */
 esp_err_t web_editor_save_file(const char *filename, const char *content, size_t size);
 
+/**
+ * @brief In-progress streamed write of one dashboard file
+ */
+typedef struct web_editor_upload web_editor_upload_t;
+
+/**
+ * @brief Start writing a file in chunks
+ *
+ * Data goes to a temporary file next to the target, which only replaces the
+ * target on web_editor_upload_commit(), so an interrupted upload never leaves
+ * behind a truncated dashboard.
+ *
+ * @param filename Name of the file (without path)
+ * @param upload Output handle, owned by the caller until commit or abort
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG / ESP_ERR_NOT_ALLOWED for bad names
+ */
+esp_err_t web_editor_upload_begin(const char *filename, web_editor_upload_t **upload);
+
+/**
+ * @brief Append a chunk to an upload
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE past WEB_EDITOR_MAX_FILE_SIZE
+ */
+esp_err_t web_editor_upload_write(web_editor_upload_t *upload, const char *data, size_t len);
+
+/**
+ * @brief Finish an upload and move it over the target file
+ *
+ * The handle is released whether or not this succeeds.
+ */
+esp_err_t web_editor_upload_commit(web_editor_upload_t *upload);
+
+/**
+ * @brief Discard an upload and its temporary file
+ */
+void web_editor_upload_abort(web_editor_upload_t *upload);
+
 /**
  * @brief List all files in FATFS
- * @param json_output Output JSON string (must be freed by caller)
+ * @param json_output Output JSON string (release with cJSON_free())
  * @return ESP_OK on success
  */
 esp_err_t web_editor_list_files(char **json_output);
@@ -1,8 +1,13 @@
 #include "wifi_manager.h"
 #include "provisioning_state.h"
+#include "boot_profile.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_attr.h"
+#include "esp_mac.h"
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "freertos/FreeRTOS.h"
@@ -15,13 +20,41 @@ static const char *TAG = "WIFI_MGR";
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT BIT1
 
-// Maximum retry attempts
+// Attempts before a first connection is reported as failed; a link that has
+// worked once keeps retrying with backoff
 #define MAX_RETRY_ATTEMPTS 5
 
+// Jittered exponential backoff between attempts
+#define WIFI_BACKOFF_BASE_MS    500
+#define WIFI_BACKOFF_MAX_MS     60000
+
+// Last AP that gave us an IP, for a directed connect without a full scan
+#define WIFI_AP_CACHE_MAGIC     0x41504331  // "APC1"
+#define WIFI_CACHE_NAMESPACE    "wifi_cache"
+#define WIFI_CACHE_KEY          "ap"
+
+typedef struct {
+    uint32_t magic;
+    char ssid[33];
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t authmode;       // wifi_auth_mode_t
+    uint8_t pmf_required;
+} wifi_ap_cache_t;
+
 static EventGroupHandle_t s_wifi_event_group;
 static int s_retry_num = 0;
 static bool s_is_connected = false;
 static bool s_has_credentials_configured = false;
+static bool s_ever_connected = false;       // Since the current credentials were set
+static bool s_attempt_in_flight = false;
+static bool s_directed_attempt = false;     // Current config targets the cached BSSID/channel
+static esp_timer_handle_t s_retry_timer = NULL;
+
+// RTC copy survives deep sleep; the NVS copy survives power loss
+static RTC_DATA_ATTR wifi_ap_cache_t s_rtc_ap_cache;
+static wifi_ap_cache_t s_ap_cache;
+static wifi_ap_cache_t s_connected_ap;      // Filled on association, cached once we get an IP
 
 // Store credentials temporarily before saving
 static char pending_ssid[33] = {0};
@@ -30,6 +63,134 @@ static char pending_password[64] = {0};
 // Forward declarations
 static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
 
+static void wifi_ap_cache_load(void)
+{
+    if (s_rtc_ap_cache.magic == WIFI_AP_CACHE_MAGIC) {
+        s_ap_cache = s_rtc_ap_cache;
+        return;
+    }
+    
+    nvs_handle_t nvs_handle;
+    if (nvs_open(WIFI_CACHE_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
+        size_t size = sizeof(s_ap_cache);
+        if (nvs_get_blob(nvs_handle, WIFI_CACHE_KEY, &s_ap_cache, &size) != ESP_OK ||
+            size != sizeof(s_ap_cache) || s_ap_cache.magic != WIFI_AP_CACHE_MAGIC) {
+            memset(&s_ap_cache, 0, sizeof(s_ap_cache));
+        }
+        nvs_close(nvs_handle);
+    }
+    s_rtc_ap_cache = s_ap_cache;
+}
+
+static void wifi_ap_cache_store(const wifi_ap_cache_t *ap)
+{
+    s_rtc_ap_cache = *ap;
+    if (memcmp(&s_ap_cache, ap, sizeof(*ap)) == 0) {
+        // Same AP as last time: no flash write
+        return;
+    }
+    s_ap_cache = *ap;
+    
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(WIFI_CACHE_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(nvs_handle, WIFI_CACHE_KEY, ap, sizeof(*ap));
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs_handle);
+        }
+        nvs_close(nvs_handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save AP cache: %s", esp_err_to_name(err));
+        return;
+    }
+    ESP_LOGI(TAG, "Cached AP " MACSTR " on channel %u", MAC2STR(ap->bssid), ap->channel);
+}
+
+static void wifi_ap_cache_clear(void)
+{
+    memset(&s_ap_cache, 0, sizeof(s_ap_cache));
+    memset(&s_rtc_ap_cache, 0, sizeof(s_rtc_ap_cache));
+    nvs_handle_t nvs_handle;
+    if (nvs_open(WIFI_CACHE_NAMESPACE, NVS_READWRITE, &nvs_handle) == ESP_OK) {
+        if (nvs_erase_key(nvs_handle, WIFI_CACHE_KEY) == ESP_OK) {
+            nvs_commit(nvs_handle);
+        }
+        nvs_close(nvs_handle);
+    }
+}
+
+/**
+ * @brief Apply a station config without writing it to flash
+ *
+ * The cached BSSID/channel change from attempt to attempt; only the
+ * credentials belong in the persisted config.
+ */
+static esp_err_t wifi_set_config_ram(wifi_config_t *wifi_config)
+{
+    esp_wifi_set_storage(WIFI_STORAGE_RAM);
+    esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, wifi_config);
+    esp_wifi_set_storage(WIFI_STORAGE_FLASH);
+    return err;
+}
+
+/**
+ * @brief Point the station at the cached AP, or back at a full scan
+ */
+static void wifi_apply_scan_target(wifi_config_t *wifi_config, bool directed)
+{
+    if (directed) {
+        wifi_config->sta.bssid_set = true;
+        memcpy(wifi_config->sta.bssid, s_ap_cache.bssid, sizeof(wifi_config->sta.bssid));
+        wifi_config->sta.channel = s_ap_cache.channel;
+        wifi_config->sta.scan_method = WIFI_FAST_SCAN;
+        wifi_config->sta.threshold.authmode = (wifi_auth_mode_t)s_ap_cache.authmode;
+        wifi_config->sta.pmf_cfg.required = (s_ap_cache.pmf_required != 0);
+    } else {
+        wifi_config->sta.bssid_set = false;
+        wifi_config->sta.channel = 0;
+        wifi_config->sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        wifi_config->sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+        wifi_config->sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+        wifi_config->sta.pmf_cfg.required = false;
+    }
+    s_directed_attempt = directed;
+}
+
+/**
+ * @brief Delay before the given retry: exponential, with "equal jitter"
+ *
+ * Half of the delay is fixed and half random, so nodes that lost the same AP
+ * do not all come back at the same instant.
+ */
+static uint32_t wifi_backoff_ms(int attempt)
+{
+    uint32_t delay_ms = WIFI_BACKOFF_MAX_MS;
+    if (attempt < 16) {
+        uint32_t exp_ms = (uint32_t)WIFI_BACKOFF_BASE_MS << (attempt > 0 ? attempt - 1 : 0);
+        if (exp_ms < delay_ms) {
+            delay_ms = exp_ms;
+        }
+    }
+    return delay_ms / 2 + esp_random() % (delay_ms / 2 + 1);
+}
+
+static void wifi_start_attempt(void)
+{
+    s_attempt_in_flight = true;
+    if (esp_wifi_connect() != ESP_OK) {
+        s_attempt_in_flight = false;
+    }
+}
+
+static void wifi_retry_timer_cb(void *arg)
+{
+    (void)arg;
+    if (!s_is_connected && !s_attempt_in_flight && s_has_credentials_configured) {
+        wifi_start_attempt();
+    }
+}
+
 // WiFi event handler
 static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
 {
@@ -37,22 +198,57 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t e
         ESP_LOGI(TAG, "WiFi station started, attempting to connect...");
         // Only connect if we have credentials configured
         if (s_has_credentials_configured) {
-            esp_wifi_connect();
+            wifi_start_attempt();
         }
         
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        boot_profile_mark(BOOT_MARK_WIFI_ASSOCIATED);
+        wifi_event_sta_connected_t* conn_event = (wifi_event_sta_connected_t*) event_data;
+        memset(&s_connected_ap, 0, sizeof(s_connected_ap));
+        s_connected_ap.magic = WIFI_AP_CACHE_MAGIC;
+        memcpy(s_connected_ap.ssid, conn_event->ssid,
+               conn_event->ssid_len < sizeof(s_connected_ap.ssid) ? conn_event->ssid_len : sizeof(s_connected_ap.ssid) - 1);
+        memcpy(s_connected_ap.bssid, conn_event->bssid, sizeof(s_connected_ap.bssid));
+        s_connected_ap.channel = conn_event->channel;
+        s_connected_ap.authmode = (uint8_t)conn_event->authmode;
+        // WPA3-SAE only works with PMF, so a WPA3-only AP needs it on the fast path too
+        s_connected_ap.pmf_required = (conn_event->authmode == WIFI_AUTH_WPA3_PSK);
+        
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
         wifi_event_sta_disconnected_t* disconn_event = (wifi_event_sta_disconnected_t*) event_data;
         ESP_LOGI(TAG, "WiFi disconnected (reason: %d)", disconn_event->reason);
         
+        bool was_connected = s_is_connected;
+        bool was_active = s_is_connected || s_attempt_in_flight;
         s_is_connected = false;
+        s_attempt_in_flight = false;
         
-        if (s_retry_num < MAX_RETRY_ATTEMPTS) {
-            esp_wifi_connect();
+        if (!s_has_credentials_configured || !was_active) {
+            // Neither connected nor connecting: a stop or disconnect we asked for
+        } else if (s_directed_attempt && !was_connected) {
+            // The cached AP moved or went away: fall back to a full scan straight away
+            ESP_LOGW(TAG, "Directed connect to cached AP failed, falling back to full scan");
+            wifi_config_t wifi_config;
+            if (esp_wifi_get_config(WIFI_IF_STA, &wifi_config) == ESP_OK) {
+                wifi_apply_scan_target(&wifi_config, false);
+                wifi_set_config_ram(&wifi_config);
+            }
+            s_directed_attempt = false;
+            wifi_start_attempt();
+            
+        } else if (s_ever_connected || s_retry_num < MAX_RETRY_ATTEMPTS) {
             s_retry_num++;
-            ESP_LOGI(TAG, "Retry connection attempt %d/%d", s_retry_num, MAX_RETRY_ATTEMPTS);
+            uint32_t delay_ms = wifi_backoff_ms(s_retry_num);
+            ESP_LOGI(TAG, "Retry connection attempt %d in %lu ms", s_retry_num, (unsigned long)delay_ms);
+            esp_timer_stop(s_retry_timer);
+            esp_timer_start_once(s_retry_timer, (uint64_t)delay_ms * 1000ULL);
             
             char msg[64];
-            snprintf(msg, sizeof(msg), "Connecting... (attempt %d/%d)", s_retry_num, MAX_RETRY_ATTEMPTS);
+            if (s_ever_connected) {
+                snprintf(msg, sizeof(msg), "Reconnecting... (attempt %d)", s_retry_num);
+            } else {
+                snprintf(msg, sizeof(msg), "Connecting... (attempt %d/%d)", s_retry_num, MAX_RETRY_ATTEMPTS);
+            }
             provisioning_state_set(PROV_STATE_WIFI_CONNECTING, STATUS_SUCCESS, msg);
             
         } else {
@@ -85,11 +281,18 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t e
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "WiFi connected! IP: " IPSTR, IP2STR(&event->ip_info.ip));
+        boot_profile_mark(BOOT_MARK_GOT_IP);
         
         s_retry_num = 0;
         s_is_connected = true;
+        s_ever_connected = true;
+        s_attempt_in_flight = false;
         xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
         
+        if (s_connected_ap.magic == WIFI_AP_CACHE_MAGIC) {
+            wifi_ap_cache_store(&s_connected_ap);
+        }
+        
         // ESP-IDF automatically saves credentials with WIFI_STORAGE_FLASH
         ESP_LOGI(TAG, "Credentials saved automatically by ESP-IDF (encrypted in NVS)");
         
@@ -135,6 +338,15 @@ esp_err_t wifi_manager_init(void)
     // This works seamlessly with wifi_prov_mgr
     ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_FLASH));
     
+    esp_timer_create_args_t timer_args = {
+        .callback = wifi_retry_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "wifi_retry"
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_retry_timer));
+    wifi_ap_cache_load();
+    
     // Register event handlers
     ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL));
     ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL));
@@ -156,6 +368,16 @@ esp_err_t wifi_manager_connect(const char* ssid, const char* password)
         return ESP_ERR_INVALID_ARG;
     }
     
+    // Already connecting to this network: let the backoff run instead of restarting the radio
+    wifi_config_t current_config;
+    if (s_has_credentials_configured && !s_is_connected &&
+        (s_attempt_in_flight || esp_timer_is_active(s_retry_timer)) &&
+        esp_wifi_get_config(WIFI_IF_STA, &current_config) == ESP_OK &&
+        strncmp((const char*)current_config.sta.ssid, ssid, sizeof(current_config.sta.ssid)) == 0) {
+        ESP_LOGD(TAG, "Connection to %s already in progress", ssid);
+        return ESP_OK;
+    }
+    
     ESP_LOGI(TAG, "Connecting to WiFi SSID: %s", ssid);
     
     // Store credentials temporarily
@@ -171,20 +393,35 @@ esp_err_t wifi_manager_connect(const char* ssid, const char* password)
     wifi_config.sta.pmf_cfg.required = false;
     
     // Stop WiFi if already running
+    s_has_credentials_configured = false;
+    s_is_connected = false;
+    esp_timer_stop(s_retry_timer);
     esp_wifi_stop();
     
-    // Set configuration
+    // Set configuration (persisted with the plain credentials only)
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
     
+    // Same network as last time: go straight to the cached AP on its channel
+    bool directed = (s_ap_cache.magic == WIFI_AP_CACHE_MAGIC &&
+                     strncmp(s_ap_cache.ssid, ssid, sizeof(s_ap_cache.ssid)) == 0);
+    wifi_apply_scan_target(&wifi_config, directed);
+    if (directed) {
+        ESP_LOGI(TAG, "Fast connect to cached AP " MACSTR " on channel %u",
+                 MAC2STR(s_ap_cache.bssid), s_ap_cache.channel);
+    }
+    wifi_set_config_ram(&wifi_config);
+    
+    // Reset retry state
+    s_retry_num = 0;
+    s_ever_connected = false;
+    s_attempt_in_flight = false;
+    
     // Mark that we have credentials configured
     s_has_credentials_configured = true;
     
     // Start WiFi
     ESP_ERROR_CHECK(esp_wifi_start());
     
-    // Reset retry counter
-    s_retry_num = 0;
-    
     // Update state
     provisioning_state_set(PROV_STATE_WIFI_CONNECTING, STATUS_SUCCESS, "Initiating WiFi connection");
     
@@ -225,6 +462,7 @@ esp_err_t wifi_manager_disconnect(void)
 {
     ESP_LOGI(TAG, "Disconnecting from WiFi");
     s_is_connected = false;
+    esp_timer_stop(s_retry_timer);
     return esp_wifi_disconnect();
 }
 
@@ -233,7 +471,10 @@ esp_err_t wifi_manager_clear_credentials(void)
     ESP_LOGI(TAG, "Clearing stored credentials");
     
     // Stop WiFi first
+    s_has_credentials_configured = false;
+    esp_timer_stop(s_retry_timer);
     esp_wifi_stop();
+    wifi_ap_cache_clear();
     
     // Clear ESP-IDF's WiFi credentials by erasing the NVS WiFi namespace
     // This is the proper way to clear credentials stored by WIFI_STORAGE_FLASH
@@ -254,9 +495,6 @@ esp_err_t wifi_manager_clear_credentials(void)
         ret = ESP_OK;
     }
     
-    // Clear the configured flag
-    s_has_credentials_configured = false;
-    
     ESP_LOGI(TAG, "Credentials cleared successfully");
     return ret;
 }
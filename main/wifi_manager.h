@@ -14,6 +14,12 @@ esp_err_t wifi_manager_init(void);
 /**
  * @brief Connect to WiFi network with given credentials
  * 
+ * If the network is the one we last got an IP from, the first attempt goes
+ * straight to the cached BSSID and channel (kept in RTC memory across deep
+ * sleep and in NVS across power loss) and falls back to a full scan if that
+ * fails. Retries back off exponentially with jitter. Calling this again while
+ * a connection to the same SSID is in progress does not restart the radio.
+ * 
  * @param ssid WiFi SSID
  * @param password WiFi password
  * @return ESP_OK on success
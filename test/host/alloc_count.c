@@ -0,0 +1,35 @@
+/**
+ * @file alloc_count.c
+ * @brief Allocation counter, linked in with -Wl,--wrap for malloc, calloc and realloc
+ *
+ * Only calls from the suite's own objects are wrapped, so libc-internal
+ * allocations (stdio buffers) are not counted.
+ */
+
+#include "host_port.h"
+#include <stddef.h>
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static int64_t s_allocs = 0;
+
+void *__wrap_malloc(size_t size) {
+    s_allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+    s_allocs++;
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    s_allocs++;
+    return __real_realloc(ptr, size);
+}
+
+int64_t host_alloc_count(void) {
+    return s_allocs;
+}
@@ -0,0 +1,322 @@
+/**
+ * @file bench_data_path.c
+ * @brief Host run of the data-path benchmark with a regression gate
+ *
+ * Runs the data_bench stages (reading parse, filter, deadband, JSON, CBOR,
+ * pack, unpack) plus ezo_fetch, the driver's receive path through the mock
+ * I2C layer, and compares each with a stored baseline:
+ *
+ *   bench_data_path [--baseline FILE] [--save FILE] [--iterations N] [--threshold PCT]
+ *
+ * Stages are timed in thread CPU time, best of BENCH_ROUNDS short windows,
+ * so preemption by other processes is not counted. Baseline times are
+ * first scaled to this machine: the scale is the median
+ * of the current/baseline ratios of every stage and of a reference workload.
+ * A stage that regressed stands out against the rest of the data path, while
+ * a faster or busier machine moves all ratios together. Allocations per
+ * operation are exact and compared without tolerance. Exits 1 on a
+ * regression.
+ */
+
+#include "data_bench.h"
+#include "ezo_sensor.h"
+#include "mock_i2c.h"
+#include "host_port.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_ITERATIONS        2000
+#define BENCH_THRESHOLD_PCT     50      // Host machines are shared; the device gate is tighter
+#define BENCH_ROUNDS            15      // Best of
+#define BENCH_ALLOC_TOLERANCE   0.01f   // Rounding of the stored allocs/op
+#define BENCH_FETCH_ADDRESS     0x63
+#define BENCH_MAX_STAGES        (DATA_BENCH_STAGE_COUNT + 1)
+
+typedef struct {
+    const char *name;
+    uint32_t ns_per_op;
+    float allocs_per_op;
+} bench_stage_t;
+
+typedef struct {
+    uint32_t ref_ns;            // Reference workload, ns/op
+    uint8_t count;
+    bench_stage_t stages[BENCH_MAX_STAGES];
+} bench_run_t;
+
+static volatile uint32_t s_sink;
+
+// Mock board answering every read with a finished EC reading
+static bool fetch_present(uint8_t address) {
+    return address == BENCH_FETCH_ADDRESS;
+}
+
+static esp_err_t fetch_transmit(uint8_t address, const uint8_t *data, size_t len) {
+    (void)address; (void)data; (void)len;
+    return ESP_OK;
+}
+
+static esp_err_t fetch_receive(uint8_t address, uint8_t *buf, size_t len) {
+    static const char k_reading[] = "1413,707,0.70,1.000";
+    (void)address;
+    memset(buf, 0, len);
+    buf[0] = EZO_RESP_SUCCESS;
+    memcpy(buf + 1, k_reading, (sizeof(k_reading) < len - 1) ? sizeof(k_reading) : len - 1);
+    return ESP_OK;
+}
+
+static const mock_i2c_target_t k_fetch_target = {
+    .present = fetch_present,
+    .transmit = fetch_transmit,
+    .receive = fetch_receive,
+};
+
+/**
+ * @brief Fixed mix of formatting and copying, the yardstick for machine speed
+ */
+static void bench_reference(uint32_t n) {
+    char buf[32];
+    char copy[32];
+    for (uint32_t k = 0; k < n; k++) {
+        int len = snprintf(buf, sizeof(buf), "%.3f,%lu", (double)k * 0.001, (unsigned long)k);
+        memcpy(copy, buf, sizeof(copy));
+        s_sink += (uint32_t)len + (uint8_t)copy[k & 15];
+    }
+}
+
+static void bench_fetch(ezo_sensor_t *sensor, uint32_t n) {
+    float values[4];
+    uint8_t count = 0;
+    for (uint32_t k = 0; k < n; k++) {
+        ezo_sensor_fetch_all(sensor, values, &count);
+        s_sink += count;
+    }
+}
+
+static uint32_t bench_best_ns(void (*fn)(uint32_t), uint32_t n) {
+    int64_t best = INT64_MAX;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        int64_t start = esp_timer_get_time();
+        fn(n);
+        int64_t elapsed = esp_timer_get_time() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return (uint32_t)((best * 1000) / n);
+}
+
+static ezo_sensor_t s_fetch_sensor;
+
+static void bench_fetch_stage(uint32_t n) {
+    bench_fetch(&s_fetch_sensor, n);
+}
+
+static int bench_measure(uint32_t iterations, bench_run_t *run) {
+    memset(run, 0, sizeof(*run));
+    run->ref_ns = bench_best_ns(bench_reference, iterations);
+
+    if (data_bench_init() != ESP_OK) {
+        return -1;
+    }
+    for (int s = 0; s < DATA_BENCH_STAGE_COUNT; s++) {
+        run->stages[s].name = data_bench_stage_name((data_bench_stage_t)s);
+        run->stages[s].ns_per_op = UINT32_MAX;
+    }
+    run->count = DATA_BENCH_STAGE_COUNT;
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        data_bench_report_t report;
+        if (data_bench_run(iterations, &report) != ESP_OK) {
+            fprintf(stderr, "data_bench_run failed\n");
+            return -1;
+        }
+        for (int s = 0; s < DATA_BENCH_STAGE_COUNT; s++) {
+            if (!report.stages[s].ran) {
+                fprintf(stderr, "stage %s did not run\n", run->stages[s].name);
+                return -1;
+            }
+            if (report.stages[s].ns_per_op < run->stages[s].ns_per_op) {
+                run->stages[s].ns_per_op = report.stages[s].ns_per_op;
+            }
+            run->stages[s].allocs_per_op = report.stages[s].allocs_per_op;
+        }
+    }
+
+    mock_i2c_attach(&k_fetch_target);
+    memset(&s_fetch_sensor, 0, sizeof(s_fetch_sensor));
+    s_fetch_sensor.config.i2c_address = BENCH_FETCH_ADDRESS;
+    s_fetch_sensor.config.kind = EZO_KIND_EC;
+    i2c_device_config_t dev_cfg = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = BENCH_FETCH_ADDRESS,
+        .scl_speed_hz = 100000,
+    };
+    if (i2c_master_bus_add_device(mock_i2c_bus(), &dev_cfg, &s_fetch_sensor.dev_handle) != ESP_OK) {
+        return -1;
+    }
+    bench_stage_t *fetch = &run->stages[run->count++];
+    fetch->name = "ezo_fetch";
+    int64_t allocs_before = host_alloc_count();
+    bench_fetch(&s_fetch_sensor, iterations);
+    fetch->allocs_per_op = (float)(host_alloc_count() - allocs_before) / (float)iterations;
+    fetch->ns_per_op = bench_best_ns(bench_fetch_stage, iterations);
+    i2c_master_bus_rm_device(s_fetch_sensor.dev_handle);
+    mock_i2c_attach(NULL);
+
+    // Again at the end, so a burst of load during the run does not pass for machine speed
+    uint32_t ref_after = bench_best_ns(bench_reference, iterations);
+    if (ref_after < run->ref_ns) {
+        run->ref_ns = ref_after;
+    }
+    return 0;
+}
+
+static int bench_load(const char *path, bench_run_t *run) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    memset(run, 0, sizeof(*run));
+    static char names[BENCH_MAX_STAGES][24];
+    char line[128];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char name[24];
+        unsigned long ns;
+        float allocs;
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "reference %lu", &ns) == 1) {
+            run->ref_ns = (uint32_t)ns;
+        } else if (sscanf(line, "%23s %lu %f", name, &ns, &allocs) == 3 && run->count < BENCH_MAX_STAGES) {
+            strcpy(names[run->count], name);
+            run->stages[run->count] = (bench_stage_t){ names[run->count], (uint32_t)ns, allocs };
+            run->count++;
+        }
+    }
+    fclose(f);
+    return run->ref_ns > 0 ? 0 : -1;
+}
+
+static int bench_save(const char *path, const bench_run_t *run) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        return -1;
+    }
+    fprintf(f, "# Data-path benchmark baseline: stage ns/op allocs/op (bench_data_path --save)\n");
+    fprintf(f, "reference %lu\n", (unsigned long)run->ref_ns);
+    for (int i = 0; i < run->count; i++) {
+        fprintf(f, "%s %lu %.2f\n", run->stages[i].name, (unsigned long)run->stages[i].ns_per_op,
+                run->stages[i].allocs_per_op);
+    }
+    fclose(f);
+    return 0;
+}
+
+static int bench_cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Median ratio of current to baseline times, reference workload included
+ */
+static double bench_scale(const bench_run_t *run, const bench_run_t *baseline) {
+    double ratios[BENCH_MAX_STAGES + 1];
+    int n = 0;
+    ratios[n++] = (double)run->ref_ns / (double)baseline->ref_ns;
+    for (int i = 0; i < run->count; i++) {
+        for (int j = 0; j < baseline->count; j++) {
+            if (strcmp(run->stages[i].name, baseline->stages[j].name) == 0 && baseline->stages[j].ns_per_op > 0) {
+                ratios[n++] = (double)run->stages[i].ns_per_op / (double)baseline->stages[j].ns_per_op;
+            }
+        }
+    }
+    qsort(ratios, n, sizeof(ratios[0]), bench_cmp_double);
+    return (n % 2) ? ratios[n / 2] : (ratios[n / 2 - 1] + ratios[n / 2]) / 2.0;
+}
+
+static const bench_stage_t *bench_find(const bench_run_t *run, const char *name) {
+    for (int i = 0; i < run->count; i++) {
+        if (strcmp(run->stages[i].name, name) == 0) {
+            return &run->stages[i];
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    const char *baseline_path = NULL;
+    const char *save_path = NULL;
+    uint32_t iterations = BENCH_ITERATIONS;
+    int threshold_pct = BENCH_THRESHOLD_PCT;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--baseline") == 0) {
+            baseline_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--save") == 0) {
+            save_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--iterations") == 0) {
+            iterations = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--threshold") == 0) {
+            threshold_pct = atoi(argv[i + 1]);
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (iterations == 0 || iterations > DATA_BENCH_MAX_ITERATIONS) {
+        iterations = BENCH_ITERATIONS;
+    }
+
+    host_clock_use_cpu_time(true);
+    bench_run_t run;
+    if (bench_measure(iterations, &run) != 0) {
+        return 1;
+    }
+
+    bench_run_t baseline;
+    bool have_baseline = baseline_path != NULL && bench_load(baseline_path, &baseline) == 0;
+    if (baseline_path != NULL && !have_baseline) {
+        fprintf(stderr, "cannot read baseline %s\n", baseline_path);
+        return 1;
+    }
+
+    // Baseline times in this machine's terms
+    double scale = have_baseline ? bench_scale(&run, &baseline) : 1.0;
+    printf("reference      %8lu ns/op  (baseline scale %.2f)\n", (unsigned long)run.ref_ns, scale);
+
+    int regressions = 0;
+    for (int i = 0; i < run.count; i++) {
+        const bench_stage_t *stage = &run.stages[i];
+        const bench_stage_t *base = have_baseline ? bench_find(&baseline, stage->name) : NULL;
+        bool slower = false;
+        bool more_allocs = false;
+        if (base != NULL) {
+            slower = stage->ns_per_op > base->ns_per_op * scale * (100 + threshold_pct) / 100.0;
+            more_allocs = stage->allocs_per_op > base->allocs_per_op + BENCH_ALLOC_TOLERANCE;
+            regressions += (slower || more_allocs) ? 1 : 0;
+        }
+        printf("%-14s %8lu ns/op %6.2f allocs/op", stage->name, (unsigned long)stage->ns_per_op,
+               stage->allocs_per_op);
+        if (base != NULL) {
+            printf("  (baseline %lu)", (unsigned long)(base->ns_per_op * scale));
+        }
+        printf("%s%s\n", slower ? "  SLOWER" : "", more_allocs ? "  MORE ALLOCS" : "");
+    }
+
+    if (save_path != NULL) {
+        if (bench_save(save_path, &run) != 0) {
+            fprintf(stderr, "cannot write %s\n", save_path);
+            return 1;
+        }
+        printf("baseline written to %s\n", save_path);
+    }
+    if (regressions > 0) {
+        printf("%d stage(s) regressed beyond %d%% of the baseline\n", regressions, threshold_pct);
+        return 1;
+    }
+    return 0;
+}
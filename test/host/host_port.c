@@ -0,0 +1,188 @@
+/**
+ * @file host_port.c
+ * @brief ESP-IDF and FreeRTOS services the firmware sources need on the host
+ */
+
+#include "host_port.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_rom_sys.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct host_semaphore {
+    int taken;
+};
+
+static int64_t s_sim_us = 0;
+static int64_t s_mono_start_us = -1;
+static clockid_t s_clock = CLOCK_MONOTONIC;
+static uint32_t s_random_state = 0x2545F491u;
+
+static int64_t host_mono_us(void) {
+    struct timespec ts;
+    clock_gettime(s_clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int64_t host_sim_time_us(void) {
+    return s_sim_us;
+}
+
+void host_sim_advance_us(int64_t us) {
+    if (us > 0) {
+        s_sim_us += us;
+    }
+}
+
+void host_clock_use_cpu_time(bool enable) {
+    s_clock = enable ? CLOCK_THREAD_CPUTIME_ID : CLOCK_MONOTONIC;
+    s_mono_start_us = -1;
+}
+
+void host_random_seed(uint32_t seed) {
+    s_random_state = seed != 0 ? seed : 1;
+}
+
+int64_t esp_timer_get_time(void) {
+    int64_t now = host_mono_us();
+    if (s_mono_start_us < 0) {
+        s_mono_start_us = now;
+    }
+    return (now - s_mono_start_us) + s_sim_us + 1;
+}
+
+uint32_t esp_random(void) {
+    // xorshift32: reproducible runs for a given seed
+    uint32_t x = s_random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s_random_state = x;
+    return x;
+}
+
+void esp_rom_delay_us(uint32_t us) {
+    host_sim_advance_us(us);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    host_sim_advance_us((int64_t)ticks * (1000000 / configTICK_RATE_HZ));
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(esp_timer_get_time() / (1000000 / configTICK_RATE_HZ));
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return calloc(1, sizeof(struct host_semaphore));
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    (void)ticks;
+    if (sem == NULL || sem->taken) {
+        // Single thread: a second take would block forever on the target
+        return pdFALSE;
+    }
+    sem->taken = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    if (sem == NULL || !sem->taken) {
+        return pdFALSE;
+    }
+    sem->taken = 0;
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    free(sem);
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    (void)name;
+    (void)open_mode;
+    (void)out_handle;
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    (void)handle;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    (void)handle; (void)key; (void)out_value; (void)length;
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    (void)handle; (void)key; (void)value; (void)length;
+    return ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+    (void)handle; (void)key;
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    (void)handle;
+    return ESP_ERR_INVALID_STATE;
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                    return "ESP_OK";
+        case ESP_FAIL:                  return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:       return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:     return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:      return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:         return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:     return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:           return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE:  return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_VERSION:   return "ESP_ERR_INVALID_VERSION";
+        case ESP_ERR_NOT_FINISHED:      return "ESP_ERR_NOT_FINISHED";
+        case ESP_ERR_NVS_NOT_FOUND:     return "ESP_ERR_NVS_NOT_FOUND";
+        default:                        return "UNKNOWN ERROR";
+    }
+}
+
+static int host_log_rank(char level) {
+    switch (level) {
+        case 'E': return 1;
+        case 'W': return 2;
+        case 'I': return 3;
+        case 'D': return 4;
+        default:  return 5;
+    }
+}
+
+void host_log(char level, const char *tag, const char *fmt, ...) {
+    static int s_max_rank = 0;
+    if (s_max_rank == 0) {
+        const char *env = getenv("HOST_LOG_LEVEL");
+        s_max_rank = host_log_rank(env != NULL && env[0] != '\0' ? env[0] : 'E');
+    }
+    if (host_log_rank(level) > s_max_rank) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "%c (%s) ", level, tag);
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
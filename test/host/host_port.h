@@ -0,0 +1,51 @@
+/**
+ * @file host_port.h
+ * @brief Controls of the host port layer (clock, random numbers, allocations)
+ *
+ * The suite runs the firmware sources in one thread. esp_timer_get_time() is
+ * the monotonic clock plus a simulated offset: vTaskDelay() and
+ * esp_rom_delay_us() advance the offset instead of sleeping, so a test can
+ * run minutes of bus traffic in milliseconds, and the benchmarks (which never
+ * delay) still measure real time.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Simulated time spent in delays so far, in microseconds
+ */
+int64_t host_sim_time_us(void);
+
+/**
+ * @brief Advance the simulated clock
+ */
+void host_sim_advance_us(int64_t us);
+
+/**
+ * @brief Base esp_timer_get_time() on the thread's CPU time instead of the monotonic clock
+ *
+ * For benchmarks: time the process spends preempted is not counted, so
+ * results hold on a loaded machine. Call before the first esp_timer_get_time().
+ */
+void host_clock_use_cpu_time(bool enable);
+
+/**
+ * @brief Restart esp_random() from a fixed seed
+ */
+void host_random_seed(uint32_t seed);
+
+/**
+ * @brief malloc/calloc/realloc calls made by the linked firmware sources so far
+ */
+int64_t host_alloc_count(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,63 @@
+/**
+ * @file host_stubs.c
+ * @brief Stand-ins for the firmware modules the suite does not build
+ *
+ * Each keeps the behaviour the tested sources rely on: no trace ring, an
+ * arbiter that always grants the bus, an empty settings store and a reading
+ * task that is parked.
+ */
+
+#include "host_port.h"
+#include "trace_log.h"
+#include "i2c_arbiter.h"
+#include "i2c_scanner.h"
+#include "settings_store.h"
+#include "sensor_manager.h"
+#include "mem_monitor.h"
+
+void trace_log_emit(trace_event_t id, uint32_t a0, uint32_t a1, uint32_t a2) {
+    (void)id; (void)a0; (void)a1; (void)a2;
+}
+
+esp_err_t i2c_arbiter_begin(i2c_arbiter_priority_t prio, uint8_t address) {
+    (void)prio; (void)address;
+    return ESP_OK;
+}
+
+void i2c_arbiter_end(void) {
+}
+
+void i2c_scanner_note_result(uint8_t address, esp_err_t result) {
+    (void)address; (void)result;
+}
+
+esp_err_t settings_store_get_blob(setting_id_t id, void *buf, size_t *len) {
+    (void)id; (void)buf; (void)len;
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t settings_store_set_blob(setting_id_t id, const void *data, size_t len) {
+    (void)id; (void)data; (void)len;
+    return ESP_OK;
+}
+
+bool sensor_manager_is_reading_paused(void) {
+    return true;
+}
+
+bool sensor_manager_is_reading_in_progress(void) {
+    return false;
+}
+
+uint8_t sensor_manager_get_ezo_count(void) {
+    return 0;
+}
+
+void *sensor_manager_get_ezo_sensor(uint8_t index) {
+    (void)index;
+    return NULL;
+}
+
+int64_t mem_monitor_task_alloc_count(void) {
+    return host_alloc_count();
+}
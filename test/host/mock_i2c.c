@@ -0,0 +1,114 @@
+/**
+ * @file mock_i2c.c
+ * @brief Mock I2C master behind the IDF driver API
+ */
+
+#include "mock_i2c.h"
+#include <stdlib.h>
+
+struct i2c_master_bus_t {
+    int unused;
+};
+
+struct i2c_master_dev_t {
+    uint8_t address;
+};
+
+static struct i2c_master_bus_t s_bus;
+static const mock_i2c_target_t *s_target = NULL;
+static mock_i2c_stats_t s_stats;
+
+void mock_i2c_attach(const mock_i2c_target_t *target) {
+    s_target = target;
+}
+
+i2c_master_bus_handle_t mock_i2c_bus(void) {
+    return &s_bus;
+}
+
+void mock_i2c_get_stats(mock_i2c_stats_t *stats, bool reset) {
+    uint8_t devices = s_stats.devices;
+    if (stats != NULL) {
+        *stats = s_stats;
+    }
+    if (reset) {
+        s_stats = (mock_i2c_stats_t){ .devices = devices };
+    }
+}
+
+static bool mock_i2c_acks(uint8_t address) {
+    bool present = s_target != NULL && s_target->present(address);
+    if (!present) {
+        s_stats.nacks++;
+    }
+    return present;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle, const i2c_device_config_t *dev_config,
+                                    i2c_master_dev_handle_t *ret_handle) {
+    if (bus_handle != &s_bus || dev_config == NULL || ret_handle == NULL ||
+        dev_config->dev_addr_length != I2C_ADDR_BIT_LEN_7 || dev_config->device_address > 0x7F) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    i2c_master_dev_handle_t dev = malloc(sizeof(*dev));
+    if (dev == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    dev->address = (uint8_t)dev_config->device_address;
+    s_stats.devices++;
+    *ret_handle = dev;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t handle) {
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    free(handle);
+    s_stats.devices--;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer, size_t write_size,
+                              int xfer_timeout_ms) {
+    (void)xfer_timeout_ms;
+    if (i2c_dev == NULL || write_buffer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_stats.transmits++;
+    if (!mock_i2c_acks(i2c_dev->address)) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    return s_target->transmit(i2c_dev->address, write_buffer, write_size);
+}
+
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t i2c_dev, uint8_t *read_buffer, size_t read_size,
+                             int xfer_timeout_ms) {
+    (void)xfer_timeout_ms;
+    if (i2c_dev == NULL || read_buffer == NULL || read_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_stats.receives++;
+    if (!mock_i2c_acks(i2c_dev->address)) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    return s_target->receive(i2c_dev->address, read_buffer, read_size);
+}
+
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer,
+                                      size_t write_size, uint8_t *read_buffer, size_t read_size,
+                                      int xfer_timeout_ms) {
+    esp_err_t ret = i2c_master_transmit(i2c_dev, write_buffer, write_size, xfer_timeout_ms);
+    if (ret == ESP_OK) {
+        ret = i2c_master_receive(i2c_dev, read_buffer, read_size, xfer_timeout_ms);
+    }
+    return ret;
+}
+
+esp_err_t i2c_master_probe(i2c_master_bus_handle_t bus_handle, uint16_t address, int xfer_timeout_ms) {
+    (void)xfer_timeout_ms;
+    if (bus_handle != &s_bus) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return mock_i2c_acks((uint8_t)address) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
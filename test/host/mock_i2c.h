@@ -0,0 +1,52 @@
+/**
+ * @file mock_i2c.h
+ * @brief Mock I2C master behind the IDF driver API (driver/i2c_master.h stub)
+ *
+ * Device handles carry their 7-bit address; transmit and receive go to the
+ * attached target, which stands in for every board on the bus. Addresses
+ * the target does not claim NACK, as on the wire.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/i2c_master.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    bool (*present)(uint8_t address);
+    esp_err_t (*transmit)(uint8_t address, const uint8_t *data, size_t len);
+    esp_err_t (*receive)(uint8_t address, uint8_t *buf, size_t len);
+} mock_i2c_target_t;
+
+typedef struct {
+    uint32_t transmits;
+    uint32_t receives;
+    uint32_t nacks;
+    uint8_t devices;                // Handles currently added
+} mock_i2c_stats_t;
+
+/**
+ * @brief Route transfers to a target, NULL to detach (every address NACKs)
+ */
+void mock_i2c_attach(const mock_i2c_target_t *target);
+
+/**
+ * @brief Bus handle to pass to the drivers
+ */
+i2c_master_bus_handle_t mock_i2c_bus(void);
+
+/**
+ * @brief Copy and optionally clear the transfer counters
+ */
+void mock_i2c_get_stats(mock_i2c_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
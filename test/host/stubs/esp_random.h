@@ -0,0 +1,10 @@
+/**
+ * @file esp_random.h
+ * @brief Host stand-in: deterministic generator, reseeded by host_random_seed()
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+uint32_t esp_random(void);
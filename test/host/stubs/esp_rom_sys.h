@@ -0,0 +1,10 @@
+/**
+ * @file esp_rom_sys.h
+ * @brief Host stand-in: busy-waits advance the simulated clock instead
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+void esp_rom_delay_us(uint32_t us);
@@ -0,0 +1,10 @@
+/**
+ * @file esp_timer.h
+ * @brief Host stand-in: monotonic time plus the simulated time of delays (host_port.c)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,20 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in: one thread, 1 kHz ticks, delays advance the simulated clock
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define configTICK_RATE_HZ  1000
+#define portMAX_DELAY       ((TickType_t)0xFFFFFFFFu)
+#define portTICK_PERIOD_MS  (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              pdTRUE
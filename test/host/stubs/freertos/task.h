@@ -0,0 +1,13 @@
+/**
+ * @file task.h
+ * @brief Host stand-in for the FreeRTOS task API used by the tested sources
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
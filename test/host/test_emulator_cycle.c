@@ -0,0 +1,235 @@
+/**
+ * @file test_emulator_cycle.c
+ * @brief Acquisition cycles against the EZO emulator behind the mock I2C bus
+ *
+ * The driver runs unmodified: its i2c_master_transmit/receive calls reach the
+ * mock bus, which hands them to ezo_emulator.c. Conversion waits and wire time
+ * advance the simulated clock, so a cycle over six boards takes milliseconds
+ * of real time. Checks that the cycle ends no earlier than the slowest
+ * board's conversion and no later than one poll step plus the wire time
+ * after it, that readings land near the programmed values, and that an
+ * injected bus fault costs only the failing board.
+ */
+
+#include "ezo_emulator.h"
+#include "ezo_sensor.h"
+#include "mock_i2c.h"
+#include "host_port.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// Schedule of sensor_reading_task (sensor_manager.c)
+#define CYCLE_POLL_FIRST_MS     250
+#define CYCLE_WAIT_STEP_MS      50
+#define CYCLE_POLL_GRACE_MS     500
+
+#define CYCLE_BASE_ADDR         0x20
+#define CYCLE_BYTE_US           90      // EZO_EMULATOR_BYTE_US
+#define CYCLE_ROUNDS            5
+
+static const uint8_t k_kinds[] = {
+    EZO_KIND_RTD, EZO_KIND_PH, EZO_KIND_EC, EZO_KIND_DO, EZO_KIND_ORP, EZO_KIND_HUM,
+};
+#define CYCLE_BOARDS (sizeof(k_kinds) / sizeof(k_kinds[0]))
+
+static const mock_i2c_target_t k_emulator_target = {
+    .present = ezo_emulator_present,
+    .transmit = ezo_emulator_transmit,
+    .receive = ezo_emulator_receive,
+};
+
+typedef struct {
+    int64_t cycle_us;
+    uint32_t transfers;
+    uint8_t done;
+    uint8_t failed;
+    esp_err_t last_error[CYCLE_BOARDS];
+    float values[CYCLE_BOARDS][4];
+    uint8_t counts[CYCLE_BOARDS];
+} cycle_result_t;
+
+static ezo_sensor_t s_sensors[CYCLE_BOARDS];
+
+static int setup_fleet(void) {
+    mock_i2c_attach(&k_emulator_target);
+    if (ezo_emulator_init() != ESP_OK) {
+        printf("FAIL setup: emulator init\n");
+        return 1;
+    }
+    for (size_t i = 0; i < CYCLE_BOARDS; i++) {
+        ezo_emulator_config_t config;
+        ezo_emulator_default_config(k_kinds[i], (uint8_t)(CYCLE_BASE_ADDR + i), &config);
+        config.noise = 0.0f;
+        if (ezo_emulator_set(&config) != ESP_OK) {
+            printf("FAIL setup: board 0x%02X\n", config.address);
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < CYCLE_BOARDS; i++) {
+        esp_err_t ret = ezo_sensor_init(&s_sensors[i], mock_i2c_bus(), (uint8_t)(CYCLE_BASE_ADDR + i));
+        if (ret != ESP_OK || s_sensors[i].config.kind != k_kinds[i]) {
+            printf("FAIL setup: init 0x%02X returned %s, kind %u\n", CYCLE_BASE_ADDR + (unsigned)i,
+                   esp_err_to_name(ret), s_sensors[i].config.kind);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief One cycle the way sensor_reading_task runs it: trigger all, wait, poll the rest each step
+ */
+static void run_cycle(cycle_result_t *result) {
+    memset(result, 0, sizeof(*result));
+    mock_i2c_get_stats(NULL, true);
+
+    uint32_t max_conversion_ms = 0;
+    bool pending[CYCLE_BOARDS];
+    int64_t start_us = esp_timer_get_time();
+    for (size_t i = 0; i < CYCLE_BOARDS; i++) {
+        uint32_t conversion_ms = ezo_sensor_desc(s_sensors[i].config.kind)->conversion_ms;
+        if (conversion_ms > max_conversion_ms) {
+            max_conversion_ms = conversion_ms;
+        }
+        result->last_error[i] = ezo_sensor_start_read(&s_sensors[i]);
+        pending[i] = (result->last_error[i] == ESP_OK);
+        if (!pending[i]) {
+            result->failed++;
+        }
+    }
+
+    int64_t deadline_us = start_us + (int64_t)(max_conversion_ms + CYCLE_POLL_GRACE_MS) * 1000;
+    vTaskDelay(pdMS_TO_TICKS(CYCLE_POLL_FIRST_MS));
+    int64_t end_us = start_us;
+    while (result->done + result->failed < CYCLE_BOARDS && esp_timer_get_time() < deadline_us) {
+        for (size_t i = 0; i < CYCLE_BOARDS; i++) {
+            if (!pending[i]) {
+                continue;
+            }
+            esp_err_t ret = ezo_sensor_fetch_all(&s_sensors[i], result->values[i], &result->counts[i]);
+            result->last_error[i] = ret;
+            if (ret == ESP_ERR_NOT_FINISHED) {
+                continue;
+            }
+            pending[i] = false;
+            end_us = esp_timer_get_time();
+            if (ret == ESP_OK) {
+                result->done++;
+            } else {
+                result->failed++;
+            }
+        }
+        if (result->done + result->failed < CYCLE_BOARDS) {
+            vTaskDelay(pdMS_TO_TICKS(CYCLE_WAIT_STEP_MS));
+        }
+    }
+
+    mock_i2c_stats_t stats;
+    mock_i2c_get_stats(&stats, false);
+    result->transfers = stats.transmits + stats.receives;
+    result->cycle_us = end_us - start_us;
+}
+
+static uint32_t slowest_conversion_ms(void) {
+    uint32_t slowest = 0;
+    for (size_t i = 0; i < CYCLE_BOARDS; i++) {
+        uint32_t ms = ezo_sensor_desc(k_kinds[i])->conversion_ms;
+        slowest = ms > slowest ? ms : slowest;
+    }
+    return slowest;
+}
+
+static int test_cycle_time(void) {
+    int failures = 0;
+    int64_t floor_us = (int64_t)slowest_conversion_ms() * 1000;
+    for (int round = 0; round < CYCLE_ROUNDS; round++) {
+        cycle_result_t r;
+        run_cycle(&r);
+        // Every transfer may carry a full response; real time between steps is noise on top
+        int64_t wire_us = (int64_t)r.transfers * (EZO_LARGEST_STRING + 1) * CYCLE_BYTE_US;
+        int64_t ceiling_us = floor_us + CYCLE_WAIT_STEP_MS * 1000 + wire_us + 5000;
+        printf("cycle %d: %u boards in %lld us, %u transfers (limit %lld..%lld us)\n", round,
+               r.done, (long long)r.cycle_us, r.transfers, (long long)floor_us, (long long)ceiling_us);
+        if (r.done != CYCLE_BOARDS) {
+            printf("FAIL cycle_time: %u of %u boards read\n", r.done, (unsigned)CYCLE_BOARDS);
+            failures++;
+        }
+        if (r.cycle_us < floor_us || r.cycle_us > ceiling_us) {
+            printf("FAIL cycle_time: %lld us outside %lld..%lld\n", (long long)r.cycle_us,
+                   (long long)floor_us, (long long)ceiling_us);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static int test_values(void) {
+    int failures = 0;
+    cycle_result_t r;
+    run_cycle(&r);
+    for (size_t i = 0; i < CYCLE_BOARDS; i++) {
+        ezo_emulator_config_t config;
+        ezo_emulator_get((uint8_t)(CYCLE_BASE_ADDR + i), &config);
+        for (uint8_t c = 0; c < r.counts[i]; c++) {
+            float tolerance = fmaxf(fabsf(config.values[c]) * 0.001f, 0.001f);
+            if (fabsf(r.values[i][c] - config.values[c]) > tolerance) {
+                printf("FAIL values: board 0x%02X value %u is %.3f, programmed %.3f\n",
+                       config.address, c, (double)r.values[i][c], (double)config.values[c]);
+                failures++;
+            }
+        }
+        if (r.counts[i] == 0) {
+            printf("FAIL values: board 0x%02X returned no values\n", config.address);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static int test_failing_board(void) {
+    int failures = 0;
+    const size_t victim = 2;
+    ezo_emulator_config_t config;
+    ezo_emulator_get((uint8_t)(CYCLE_BASE_ADDR + victim), &config);
+    config.fail_permille = 1000;
+    ezo_emulator_set(&config);
+
+    cycle_result_t r;
+    run_cycle(&r);
+    if (r.last_error[victim] != ESP_ERR_TIMEOUT) {
+        printf("FAIL failing_board: victim returned %s\n", esp_err_to_name(r.last_error[victim]));
+        failures++;
+    }
+    if (r.done != CYCLE_BOARDS - 1 || r.failed != 1) {
+        printf("FAIL failing_board: %u read, %u failed\n", r.done, r.failed);
+        failures++;
+    }
+    // A dead board must not hold the cycle past the healthy boards' conversions
+    if (r.cycle_us > (int64_t)(slowest_conversion_ms() + CYCLE_WAIT_STEP_MS) * 1000 + 50000) {
+        printf("FAIL failing_board: cycle took %lld us\n", (long long)r.cycle_us);
+        failures++;
+    }
+
+    config.fail_permille = 0;
+    ezo_emulator_set(&config);
+    return failures;
+}
+
+int main(void) {
+    host_random_seed(1);
+    if (setup_fleet() != 0) {
+        return 1;
+    }
+
+    int failures = 0;
+    failures += test_cycle_time();
+    failures += test_values();
+    failures += test_failing_board();
+
+    printf("emulator cycle: %d failure%s\n", failures, failures == 1 ? "" : "s");
+    return failures == 0 ? 0 : 1;
+}
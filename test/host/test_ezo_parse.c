@@ -0,0 +1,147 @@
+/**
+ * @file test_ezo_parse.c
+ * @brief Captured EZO responses through ezo_parse_reading()
+ *
+ * Each case is a response as read off the bus (or a damaged variant of one),
+ * the length handed to the parser, and the expected return code, value count,
+ * values and validity mask. ezo_parse_number() is static, so single-field
+ * cases stand in for its tests.
+ */
+
+#include "ezo_sensor.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PARSE_LEN_STRLEN    ((size_t)-1)    // Use strlen(response) + 1
+#define PARSE_REL_TOLERANCE 1e-6f
+
+typedef struct {
+    const char *name;
+    const char *response;
+    size_t len;
+    esp_err_t expect_ret;
+    uint8_t expect_count;
+    float expect_values[4];
+    uint8_t expect_mask;
+} parse_case_t;
+
+static const parse_case_t k_cases[] = {
+    // Captured from the boards
+    { "ph",               "7.012",                    PARSE_LEN_STRLEN, ESP_OK, 1, { 7.012f }, 0x1 },
+    { "ec_all_outputs",   "1413,707,0.70,1.000",      PARSE_LEN_STRLEN, ESP_OK, 4, { 1413.0f, 707.0f, 0.70f, 1.000f }, 0xF },
+    { "orp_negative",     "-212.4",                   PARSE_LEN_STRLEN, ESP_OK, 1, { -212.4f }, 0x1 },
+    { "rtd_negative",     "-12.500",                  PARSE_LEN_STRLEN, ESP_OK, 1, { -12.5f }, 0x1 },
+    { "hum_dew_label",    "45.21,23.10,Dew,11.42",    PARSE_LEN_STRLEN, ESP_OK, 3, { 45.21f, 23.10f, 11.42f }, 0x7 },
+    { "do_crlf",          "8.27\r\n",                 PARSE_LEN_STRLEN, ESP_OK, 1, { 8.27f }, 0x1 },
+    { "padded_fields",    " 1413 , 707 ",             PARSE_LEN_STRLEN, ESP_OK, 2, { 1413.0f, 707.0f }, 0x3 },
+
+    // Signs
+    { "plus_sign",        "+3",                       PARSE_LEN_STRLEN, ESP_OK, 1, { 3.0f }, 0x1 },
+    { "minus_zero",       "-0.000",                   PARSE_LEN_STRLEN, ESP_OK, 1, { -0.0f }, 0x1 },
+    { "bare_sign",        "-",                        PARSE_LEN_STRLEN, ESP_OK, 0, { 0 }, 0x0 },
+    { "double_sign",      "--5",                      PARSE_LEN_STRLEN, ESP_OK, 0, { 0 }, 0x0 },
+    { "leading_dot",      ".5",                       PARSE_LEN_STRLEN, ESP_OK, 1, { 0.5f }, 0x1 },
+    { "trailing_dot",     "5.",                       PARSE_LEN_STRLEN, ESP_OK, 1, { 5.0f }, 0x1 },
+
+    // Truncated reads
+    { "cut_mid_field",    "1413,707,0.70,1.000",      7,  ESP_OK, 2, { 1413.0f, 70.0f }, 0x3 },
+    { "cut_after_comma",  "1413,707,0.70,1.000",      5,  ESP_OK, 1, { 1413.0f }, 0x1 },
+    { "cut_to_nothing",   "7.012",                    0,  ESP_OK, 0, { 0 }, 0x0 },
+    { "empty",            "",                         PARSE_LEN_STRLEN, ESP_OK, 0, { 0 }, 0x0 },
+    { "only_commas",      ",,,",                      PARSE_LEN_STRLEN, ESP_OK, 0, { 0 }, 0x0 },
+    { "nul_in_buffer",    "7.00\0" "99",              8,  ESP_OK, 1, { 7.0f }, 0x1 },
+
+    // Trailing garbage keeps the value but clears its bit
+    { "garbage_suffix",   "12.5abc,3.0",              PARSE_LEN_STRLEN, ESP_OK, 2, { 12.5f, 3.0f }, 0x2 },
+    { "second_dot",       "1.2.3",                    PARSE_LEN_STRLEN, ESP_OK, 1, { 1.2f }, 0x0 },
+    { "inner_space",      "12 5",                     PARSE_LEN_STRLEN, ESP_OK, 1, { 12.0f }, 0x0 },
+
+    // Status markers
+    { "ok_only",          "*OK",                      PARSE_LEN_STRLEN, ESP_OK, 0, { 0 }, 0x0 },
+    { "ok_before_value",  "*OK,7.012",                PARSE_LEN_STRLEN, ESP_OK, 1, { 7.012f }, 0x1 },
+    { "warming_up",       "*WA",                      PARSE_LEN_STRLEN, ESP_OK, 0, { 0 }, 0x0 },
+    { "error",            "*ER",                      PARSE_LEN_STRLEN, ESP_ERR_INVALID_RESPONSE, 0, { 0 }, 0x0 },
+    { "over_voltage",     "*OV",                      PARSE_LEN_STRLEN, ESP_ERR_INVALID_RESPONSE, 0, { 0 }, 0x0 },
+    { "under_voltage",    "*UV\r",                    PARSE_LEN_STRLEN, ESP_ERR_INVALID_RESPONSE, 0, { 0 }, 0x0 },
+    { "error_after_value","7.012,*ER",                PARSE_LEN_STRLEN, ESP_ERR_INVALID_RESPONSE, 1, { 7.012f }, 0x0 },
+
+    // Overlong mantissas: digits past uint64 range scale, extra decimals drop
+    { "long_fraction",    "1.123456789012345",        PARSE_LEN_STRLEN, ESP_OK, 1, { 1.123456789f }, 0x1 },
+    { "long_integer",     "123456789012345678901234", PARSE_LEN_STRLEN, ESP_OK, 1, { 1.23456789e23f }, 0x1 },
+    { "long_both",        "12345678901234567890.55",  PARSE_LEN_STRLEN, ESP_OK, 1, { 1.2345679e19f }, 0x1 },
+
+    // At most four values
+    { "five_fields",      "1,2,3,4,5",                PARSE_LEN_STRLEN, ESP_OK, 4, { 1.0f, 2.0f, 3.0f, 4.0f }, 0xF },
+};
+
+static bool value_matches(float expected, float actual) {
+    float tolerance = fabsf(expected) * PARSE_REL_TOLERANCE;
+    if (tolerance < PARSE_REL_TOLERANCE) {
+        tolerance = PARSE_REL_TOLERANCE;
+    }
+    return fabsf(expected - actual) <= tolerance;
+}
+
+static int run_case(const parse_case_t *tc) {
+    size_t len = (tc->len == PARSE_LEN_STRLEN) ? strlen(tc->response) + 1 : tc->len;
+    float values[4] = { NAN, NAN, NAN, NAN };
+    uint8_t count = 0xFF;
+    uint8_t mask = 0xFF;
+
+    esp_err_t ret = ezo_parse_reading(tc->response, len, values, &count, &mask);
+    int failures = 0;
+    if (ret != tc->expect_ret) {
+        printf("FAIL %s: returned %s, expected %s\n", tc->name,
+               esp_err_to_name(ret), esp_err_to_name(tc->expect_ret));
+        failures++;
+    }
+    if (count != tc->expect_count) {
+        printf("FAIL %s: %u values, expected %u\n", tc->name, count, tc->expect_count);
+        failures++;
+    }
+    for (uint8_t i = 0; i < tc->expect_count && i < count; i++) {
+        if (!value_matches(tc->expect_values[i], values[i])) {
+            printf("FAIL %s: value %u is %.9g, expected %.9g\n", tc->name, i,
+                   (double)values[i], (double)tc->expect_values[i]);
+            failures++;
+        }
+    }
+    if (ret == ESP_OK && mask != tc->expect_mask) {
+        printf("FAIL %s: mask 0x%X, expected 0x%X\n", tc->name, mask, tc->expect_mask);
+        failures++;
+    }
+    return failures;
+}
+
+static int run_edge_cases(void) {
+    int failures = 0;
+    float values[4];
+    uint8_t count = 0;
+
+    // The mask is optional
+    if (ezo_parse_reading("1413,707", 16, values, &count, NULL) != ESP_OK || count != 2) {
+        printf("FAIL no_mask: count %u\n", count);
+        failures++;
+    }
+    if (ezo_parse_reading(NULL, 16, values, &count, NULL) != ESP_ERR_INVALID_ARG ||
+        ezo_parse_reading("7.0", 16, NULL, &count, NULL) != ESP_ERR_INVALID_ARG ||
+        ezo_parse_reading("7.0", 16, values, NULL, NULL) != ESP_ERR_INVALID_ARG) {
+        printf("FAIL null_args: expected ESP_ERR_INVALID_ARG\n");
+        failures++;
+    }
+
+    return failures;
+}
+
+int main(void) {
+    int failures = 0;
+    size_t total = sizeof(k_cases) / sizeof(k_cases[0]);
+    for (size_t i = 0; i < total; i++) {
+        failures += run_case(&k_cases[i]);
+    }
+    failures += run_edge_cases();
+
+    printf("%zu parse cases, %d failure%s\n", total, failures, failures == 1 ? "" : "s");
+    return failures == 0 ? 0 : 1;
+}
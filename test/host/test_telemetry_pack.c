@@ -0,0 +1,226 @@
+/**
+ * @file test_telemetry_pack.c
+ * @brief Packed snapshot records through telemetry_pack/unpack_snapshot()
+ *
+ * Packed records are kept across deep sleep, queued for MQTT batches and sent
+ * over Thread and BLE, so a record written by one side must read back the
+ * same on the other. Checks a round trip over a mixed fleet (two boards of
+ * one type, a four-value EC, an invalid slot, no battery, derived metrics)
+ * and that damaged records are rejected rather than half-restored.
+ */
+
+#include "telemetry_codec.h"
+#include "sensor_manager.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PACK_UNIX_TIME          1760400000u
+#define PACK_OFFSET_VERSION     0
+#define PACK_OFFSET_COUNT       10      // version, unix_time, battery, rssi
+
+typedef struct {
+    const char *type;
+    uint8_t count;
+    float values[MAX_SENSOR_VALUES];
+    bool valid;
+} pack_fixture_t;
+
+static const pack_fixture_t k_fleet[] = {
+    { "RTD", 1, { 21.375f }, true },
+    { "pH",  1, { 7.012f }, true },
+    { "EC",  4, { 1413.0f, 707.0f, 0.70f, 1.000f }, true },
+    { "pH",  1, { 6.480f }, true },
+    { "DO",  1, { 8.27f }, false },     // Not packed
+    { "HUM", 3, { 45.21f, 23.10f, 11.42f }, true },
+};
+#define PACK_FLEET (sizeof(k_fleet) / sizeof(k_fleet[0]))
+
+static void build_cache(sensor_cache_t *cache, bool battery, uint8_t derived_valid) {
+    memset(cache, 0, sizeof(*cache));
+    for (size_t i = 0; i < PACK_FLEET; i++) {
+        cached_sensor_t *sensor = &cache->sensors[i];
+        strncpy(sensor->sensor_type, k_fleet[i].type, sizeof(sensor->sensor_type) - 1);
+        sensor->value_count = k_fleet[i].count;
+        memcpy(sensor->values, k_fleet[i].values, sizeof(sensor->values));
+        sensor->valid = k_fleet[i].valid;
+    }
+    cache->sensor_count = PACK_FLEET;
+    cache->battery_valid = battery;
+    cache->battery_percentage = battery ? 87.5f : 0.0f;
+    cache->rssi = -67;
+    for (uint8_t m = 0; m < MAX_DERIVED_VALUES; m++) {
+        cache->derived[m] = (derived_valid & (1u << m)) ? 10.0f + m : 0.0f;
+    }
+    cache->derived_valid = derived_valid;
+}
+
+static int pack(const char *name, const sensor_cache_t *cache, uint8_t *buf, size_t *len) {
+    esp_err_t ret = telemetry_pack_snapshot(cache, PACK_UNIX_TIME, buf, TELEMETRY_PACKED_MAX_SIZE, len);
+    if (ret != ESP_OK) {
+        printf("FAIL %s: pack returned %s\n", name, esp_err_to_name(ret));
+        return 1;
+    }
+    return 0;
+}
+
+static int compare(const char *name, const sensor_cache_t *in, const sensor_cache_t *out) {
+    int failures = 0;
+    uint8_t expect = 0;
+    for (uint8_t i = 0; i < in->sensor_count; i++) {
+        const cached_sensor_t *want = &in->sensors[i];
+        if (!want->valid) {
+            continue;
+        }
+        const cached_sensor_t *got = &out->sensors[expect];
+        char want_key[24];
+        char got_key[24];
+        const char *wk = telemetry_sensor_key(in, i, want_key, sizeof(want_key));
+        const char *gk = telemetry_sensor_key(out, expect, got_key, sizeof(got_key));
+        if (!got->valid || strcmp(got->sensor_type, want->sensor_type) != 0 || strcmp(wk, gk) != 0) {
+            printf("FAIL %s: sensor %u is %s (%s), expected %s (%s)\n", name, expect,
+                   got->sensor_type, gk, want->sensor_type, wk);
+            failures++;
+        }
+        if (got->value_count != want->value_count) {
+            printf("FAIL %s: %s has %u values, expected %u\n", name, wk, got->value_count, want->value_count);
+            failures++;
+        }
+        for (uint8_t v = 0; v < want->value_count && v < got->value_count; v++) {
+            // Packed as raw f32, so the bits come back unchanged
+            if (memcmp(&got->values[v], &want->values[v], sizeof(float)) != 0) {
+                printf("FAIL %s: %s value %u is %.9g, expected %.9g\n", name, wk, v,
+                       (double)got->values[v], (double)want->values[v]);
+                failures++;
+            }
+        }
+        expect++;
+    }
+    if (out->sensor_count != expect) {
+        printf("FAIL %s: %u sensors, expected %u\n", name, out->sensor_count, expect);
+        failures++;
+    }
+    if (out->battery_valid != in->battery_valid ||
+        (in->battery_valid && out->battery_percentage != in->battery_percentage)) {
+        printf("FAIL %s: battery %d/%.2f, expected %d/%.2f\n", name, out->battery_valid,
+               (double)out->battery_percentage, in->battery_valid, (double)in->battery_percentage);
+        failures++;
+    }
+    if (out->rssi != in->rssi) {
+        printf("FAIL %s: rssi %d, expected %d\n", name, out->rssi, in->rssi);
+        failures++;
+    }
+    if (out->derived_valid != in->derived_valid) {
+        printf("FAIL %s: derived mask 0x%02X, expected 0x%02X\n", name, out->derived_valid, in->derived_valid);
+        failures++;
+    }
+    for (uint8_t m = 0; m < MAX_DERIVED_VALUES; m++) {
+        if ((in->derived_valid & (1u << m)) && out->derived[m] != in->derived[m]) {
+            printf("FAIL %s: derived %u is %.3f, expected %.3f\n", name, m,
+                   (double)out->derived[m], (double)in->derived[m]);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static int test_round_trip(const char *name, bool battery, uint8_t derived_valid) {
+    sensor_cache_t in;
+    sensor_cache_t out;
+    uint8_t buf[TELEMETRY_PACKED_MAX_SIZE];
+    size_t len = 0;
+    build_cache(&in, battery, derived_valid);
+    if (pack(name, &in, buf, &len) != 0) {
+        return 1;
+    }
+
+    uint32_t unix_time = 0;
+    esp_err_t ret = telemetry_unpack_snapshot(buf, len, &out, &unix_time);
+    if (ret != ESP_OK) {
+        printf("FAIL %s: unpack returned %s\n", name, esp_err_to_name(ret));
+        return 1;
+    }
+    int failures = compare(name, &in, &out);
+    if (unix_time != PACK_UNIX_TIME) {
+        printf("FAIL %s: unix time %u, expected %u\n", name, (unsigned)unix_time, PACK_UNIX_TIME);
+        failures++;
+    }
+    return failures;
+}
+
+static int test_truncated(void) {
+    int failures = 0;
+    sensor_cache_t in;
+    sensor_cache_t out;
+    uint8_t buf[TELEMETRY_PACKED_MAX_SIZE];
+    size_t len = 0;
+    uint32_t unix_time = 0;
+
+    // Without a derived section every shorter prefix ends inside a field
+    build_cache(&in, true, 0);
+    if (pack("truncated", &in, buf, &len) != 0) {
+        return 1;
+    }
+    for (size_t cut = 0; cut < len; cut++) {
+        esp_err_t ret = telemetry_unpack_snapshot(buf, cut, &out, &unix_time);
+        esp_err_t expect = (cut == 0) ? ESP_ERR_INVALID_VERSION : ESP_ERR_INVALID_SIZE;
+        if (ret != expect) {
+            printf("FAIL truncated: %zu of %zu bytes returned %s\n", cut, len, esp_err_to_name(ret));
+            failures++;
+        }
+    }
+
+    // A cut inside the derived section is damage, not a record without one
+    build_cache(&in, true, 0x05);
+    if (pack("truncated_derived", &in, buf, &len) != 0) {
+        return failures + 1;
+    }
+    esp_err_t ret = telemetry_unpack_snapshot(buf, len - 1, &out, &unix_time);
+    if (ret != ESP_ERR_INVALID_SIZE) {
+        printf("FAIL truncated_derived: returned %s\n", esp_err_to_name(ret));
+        failures++;
+    }
+    return failures;
+}
+
+static int test_bad_header(void) {
+    int failures = 0;
+    sensor_cache_t in;
+    sensor_cache_t out;
+    uint8_t buf[TELEMETRY_PACKED_MAX_SIZE];
+    size_t len = 0;
+    uint32_t unix_time = 0;
+    build_cache(&in, true, 0);
+    if (pack("bad_header", &in, buf, &len) != 0) {
+        return 1;
+    }
+
+    uint8_t version = buf[PACK_OFFSET_VERSION];
+    buf[PACK_OFFSET_VERSION] = (uint8_t)(version + 1);
+    esp_err_t ret = telemetry_unpack_snapshot(buf, len, &out, &unix_time);
+    if (ret != ESP_ERR_INVALID_VERSION) {
+        printf("FAIL wrong_version: returned %s\n", esp_err_to_name(ret));
+        failures++;
+    }
+    buf[PACK_OFFSET_VERSION] = version;
+
+    buf[PACK_OFFSET_COUNT] = SENSOR_MANAGER_MAX_SENSORS + 1;
+    ret = telemetry_unpack_snapshot(buf, len, &out, &unix_time);
+    if (ret != ESP_ERR_INVALID_SIZE) {
+        printf("FAIL sensor_count: %u sensors returned %s\n", buf[PACK_OFFSET_COUNT], esp_err_to_name(ret));
+        failures++;
+    }
+    return failures;
+}
+
+int main(void) {
+    int failures = 0;
+    failures += test_round_trip("round_trip", true, 0);
+    failures += test_round_trip("nan_battery", false, 0);
+    failures += test_round_trip("derived", true, 0x07);
+    failures += test_truncated();
+    failures += test_bad_header();
+
+    printf("telemetry pack: %d failure%s\n", failures, failures == 1 ? "" : "s");
+    return failures == 0 ? 0 : 1;
+}